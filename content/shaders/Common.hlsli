@@ -26,6 +26,7 @@ cbuffer ObjectCBuffer : register(b1)
     float CustomAlphaDiscard;
     uint OriginalInstanceCount;
     uint RenderingObjectFlags;
+    uint IndirectInstanceOffset; // of the object's instances in "IndirectInstanceData" (shared by all indirectly rendered objects)
 };
 
 struct QUAD_VS_IN
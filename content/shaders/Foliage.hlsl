@@ -38,7 +38,8 @@ struct VS_INPUT
     float2 TextureCoordinates : TEXCOORD0;
     float3 Normal : NORMAL;
     
-    row_major float4x4 World : WORLD;
+    float3 InstancePosition : INSTANCE_POSITION;
+    float2 InstanceScaleRotation : INSTANCE_SCALE_ROTATION; // see GPUFoliageInstanceData
 };
 
 struct VS_OUTPUT
@@ -73,22 +74,21 @@ VS_OUTPUT VSMain(VS_INPUT IN)
 {
     VS_OUTPUT OUT = (VS_OUTPUT) 0;
     
-    float4x4 scaleMat;
-    float scaleX = sqrt(IN.World[0][0] * IN.World[0][0] + IN.World[0][1] * IN.World[0][1] + IN.World[0][2] * IN.World[0][2]);
-    float scaleY = sqrt(IN.World[1][0] * IN.World[1][0] + IN.World[1][1] * IN.World[1][1] + IN.World[1][2] * IN.World[1][2]);
-    float scaleZ = sqrt(IN.World[2][0] * IN.World[2][0] + IN.World[2][1] * IN.World[2][1] + IN.World[2][2] * IN.World[2][2]);
+    float scale = IN.InstanceScaleRotation.x;
+    float rotation = IN.InstanceScaleRotation.y;
     
-    scaleMat[0][0] = scaleX;
+    float4x4 scaleMat;
+    scaleMat[0][0] = scale;
     scaleMat[0][1] = 0.0f;
     scaleMat[0][2] = 0.0f;
     scaleMat[0][3] = 0.0f;
     scaleMat[1][0] = 0.0f;
-    scaleMat[1][1] = scaleY;
+    scaleMat[1][1] = scale;
     scaleMat[1][2] = 0.0f;
     scaleMat[1][3] = 0.0f;
     scaleMat[2][0] = 0.0f;
     scaleMat[2][1] = 0.0f;
-    scaleMat[2][2] = scaleZ;
+    scaleMat[2][2] = scale;
     scaleMat[2][3] = 0.0f;
     scaleMat[3][0] = 0.0f;
     scaleMat[3][1] = 0.0f;
@@ -108,29 +108,32 @@ VS_OUTPUT VSMain(VS_INPUT IN)
     translateMat[2][1] = 0.0f;
     translateMat[2][2] = 1.0f;
     translateMat[2][3] = 0.0f;
-    translateMat[3][0] = IN.World[3][0];
-    translateMat[3][1] = IN.World[3][1];
-    translateMat[3][2] = IN.World[3][2];
-    translateMat[3][3] = IN.World[3][3];
+    translateMat[3][0] = IN.InstancePosition.x;
+    translateMat[3][1] = IN.InstancePosition.y;
+    translateMat[3][2] = IN.InstancePosition.z;
+    translateMat[3][3] = 1.0f;
     
+    // instance rotation around Y
     float4x4 rotationMat;
-    rotationMat[0][0] = IN.World[0][0] / scaleX;
-    rotationMat[0][1] = IN.World[0][1] / scaleX;
-    rotationMat[0][2] = IN.World[0][2] / scaleX;
+    rotationMat[0][0] = cos(rotation);
+    rotationMat[0][1] = 0.0f;
+    rotationMat[0][2] = -sin(rotation);
     rotationMat[0][3] = 0.0f;
-    rotationMat[1][0] = IN.World[1][0] / scaleY;
-    rotationMat[1][1] = IN.World[1][1] / scaleY;
-    rotationMat[1][2] = IN.World[1][2] / scaleY;
+    rotationMat[1][0] = 0.0f;
+    rotationMat[1][1] = 1.0f;
+    rotationMat[1][2] = 0.0f;
     rotationMat[1][3] = 0.0f;
-    rotationMat[2][0] = IN.World[2][0] / scaleZ;
-    rotationMat[2][1] = IN.World[2][1] / scaleZ;
-    rotationMat[2][2] = IN.World[2][2] / scaleZ;
+    rotationMat[2][0] = sin(rotation);
+    rotationMat[2][1] = 0.0f;
+    rotationMat[2][2] = cos(rotation);
     rotationMat[2][3] = 0.0f;
     rotationMat[3][0] = 0.0f;
     rotationMat[3][1] = 0.0f;
     rotationMat[3][2] = 0.0f;
     rotationMat[3][3] = 1.0f;
     
+    float4x4 World = mul(mul(scaleMat, rotationMat), translateMat);
+    
     float4 localPos = IN.Position;
     float vertexHeight = 0.5f;
     
@@ -158,11 +161,13 @@ VS_OUTPUT VSMain(VS_INPUT IN)
     localPos = mul(localPos, scaleMat);
     if (RotateToCamera > 0.0f)
         localPos = mul(localPos, newRotationMat);
+    else
+        localPos = mul(localPos, rotationMat);
     localPos = mul(localPos, translateMat);
     OUT.Position = localPos;
     {
         
-        //OUT.Position = mul(localPos, IN.World);
+        //OUT.Position = mul(localPos, World);
         //OUT.Position = mul(OUT.Position, rotationMat);
         if (IN.Position.y > vertexHeight)
         {
@@ -175,11 +180,11 @@ VS_OUTPUT VSMain(VS_INPUT IN)
 
     OUT.Position = mul(OUT.Position, Projection);
     IN.Normal = float3(0.0, 1.0, 0.0);
-    OUT.Normal = normalize(mul(float4(IN.Normal, 0), IN.World).xyz);
+    OUT.Normal = normalize(mul(float4(IN.Normal, 0), World).xyz);
     OUT.TextureCoordinates = IN.TextureCoordinates;
-    OUT.ShadowCoord0 = mul(IN.Position, mul(IN.World, ShadowMatrices[0])).xyz;
-    OUT.ShadowCoord1 = mul(IN.Position, mul(IN.World, ShadowMatrices[1])).xyz;
-    OUT.ShadowCoord2 = mul(IN.Position, mul(IN.World, ShadowMatrices[2])).xyz;
+    OUT.ShadowCoord0 = mul(IN.Position, mul(World, ShadowMatrices[0])).xyz;
+    OUT.ShadowCoord1 = mul(IN.Position, mul(World, ShadowMatrices[1])).xyz;
+    OUT.ShadowCoord2 = mul(IN.Position, mul(World, ShadowMatrices[2])).xyz;
     
     return OUT;
 }
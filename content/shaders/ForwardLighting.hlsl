@@ -143,7 +143,7 @@ VS_OUTPUT VSMain_instancing(VS_INPUT_INSTANCING IN)
     VS_OUTPUT OUT = (VS_OUTPUT) 0;
 
     float4x4 World = (RenderingObjectFlags & RENDERING_OBJECT_FLAG_GPU_INDIRECT_DRAW) ?
-        transpose(IndirectInstanceData[(int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.World;
+        transpose(IndirectInstanceData[(int)IndirectInstanceOffset + (int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.World;
 
     OUT.WorldPos = mul(IN.Position, World).xyz;
     OUT.Position = mul(float4(OUT.WorldPos, 1.0f), ViewProjection);
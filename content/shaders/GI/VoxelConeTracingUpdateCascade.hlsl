@@ -0,0 +1,37 @@
+#define MAX_DIRTY_REGIONS 8 // ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS
+
+// Incremental update of a voxel cascade before its voxelization (see ER_VoxelClipmap):
+// voxels of the previous frame are scrolled with the cascade, newly exposed and dirty voxels are cleared (they are voxelized again).
+Texture3D<float4> inputTexture : register(t0); // mip 0 of the cascade from the previous frame
+RWTexture3D<float4> outputTexture : register(u0);
+
+cbuffer UpdateCascadeCB : register(b0)
+{
+    int4 ScrollOffset; // xyz - in texels, w - texture dimension
+    int4 DirtyRegionsMin[MAX_DIRTY_REGIONS];
+    int4 DirtyRegionsMax[MAX_DIRTY_REGIONS];
+    uint DirtyRegionsCount;
+    float3 pad0;
+};
+
+[numthreads(8, 8, 8)]
+void CSMain(int3 DTid : SV_DispatchThreadID)
+{
+    const int dimension = ScrollOffset.w;
+    if (any(DTid >= dimension))
+        return;
+
+    float4 result = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    
+    const int3 sourceVoxel = DTid + ScrollOffset.xyz;
+    if (all(sourceVoxel >= 0) && all(sourceVoxel < dimension))
+        result = inputTexture.Load(int4(sourceVoxel, 0));
+
+    for (uint i = 0; i < DirtyRegionsCount; i++)
+    {
+        if (all(DTid >= DirtyRegionsMin[i].xyz) && all(DTid < DirtyRegionsMax[i].xyz))
+            result = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    outputTexture[DTid] = result;
+}
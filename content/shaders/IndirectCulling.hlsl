@@ -1,21 +1,20 @@
 #include "IndirectCulling.hlsli"
 
-cbuffer MeshConstants : register(b0)
-{
-	uint4 IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[MAX_LOD_COUNT * MAX_MESH_COUNT];
-	uint OriginalInstancesCount;
-};
-
-cbuffer CameraConstants : register(b1)
+// one dispatch for the instances of all indirectly rendered objects (see ER_GPUCullingTable)
+cbuffer CullingConstants : register(b0)
 {
 	float4 FrustumPlanes[6];
-	float4 LODCameraSqrDistances;
+	float4 LODParams; // x - projection scale, y - LOD hysteresis
 	float4 CameraPos;
+	uint4 Counts; // x - instances count, y - draws count
 };
 
-StructuredBuffer<Instance> instanceData : register(t0);
-RWStructuredBuffer<Instance> newInstanceData : register(u0); // OriginalInstancesCount * MAX_LOD_COUNT
-RWBuffer<uint> argsBuffer : register(u1); // MAX_LOD_COUNT * MAX_MESH_COUNT * 5
+StructuredBuffer<Instance> instanceData : register(t0); // instances of all objects
+StructuredBuffer<CullingObject> objects : register(t1);
+Buffer<uint> instanceObjects : register(t2); // object index of every instance
+RWStructuredBuffer<Instance> newInstanceData : register(u0); // InstancesCount * MAX_LOD_COUNT per object
+RWBuffer<uint> argsBuffer : register(u1); // MAX_LOD_COUNT * MAX_MESH_COUNT * 5 per object
+RWBuffer<uint> instancesLODs : register(u2); // of every instance, LOD + 1 from the last frame (0 - not rendered)
 
 bool PerformFrustumCull(float4 aabbMin, float4 aabbMax)
 {
@@ -59,50 +58,76 @@ bool PerformFrustumCull(float4 aabbMin, float4 aabbMax)
 	return culled;
 }
 
-int CalculateLodIndex(float4x4 worldMat)
+// projected size of the bounding sphere relative to the screen height (same as ER_RenderingObject::ComputeScreenSize())
+float CalculateScreenSize(float4 aabbMin, float4 aabbMax)
 {
-	float3 pos = float3(worldMat[0][3], worldMat[1][3], worldMat[2][3]);
+	float3 center = (aabbMin.xyz + aabbMax.xyz) * 0.5;
+	float3 extent = aabbMax.xyz - center;
+	float radiusSqr = dot(extent, extent);
+	float3 toCamera = CameraPos.xyz - center;
+	float distanceSqr = dot(toCamera, toCamera);
+
+	if (distanceSqr <= radiusSqr)
+		return 1e30;
+	return sqrt(radiusSqr) * LODParams.x / sqrt(distanceSqr - radiusSqr);
+}
 
-	float distanceToCameraSqr =
-		(CameraPos.x - pos.x) * (CameraPos.x - pos.x) +
-		(CameraPos.y - pos.y) * (CameraPos.y - pos.y) +
-		(CameraPos.z - pos.z) * (CameraPos.z - pos.z);
+float GetLODScreenSize(CullingObject object, int lod)
+{
+	return object.LODScreenSizes[lod];
+}
 
-	if (distanceToCameraSqr <= LODCameraSqrDistances.x)
-		return 0;
-	else if (LODCameraSqrDistances.x < distanceToCameraSqr && distanceToCameraSqr <= LODCameraSqrDistances.y)
-		return 1;
-	else if (LODCameraSqrDistances.y < distanceToCameraSqr && distanceToCameraSqr <= LODCameraSqrDistances.z)
-		return 2;
+// same as ER_RenderingObject::SelectLOD()
+int CalculateLodIndex(CullingObject object, float screenSize, int previousLod)
+{
+	int lodCount = (int)object.LODCount;
+	screenSize *= object.LODBias;
 
+	if (previousLod >= -1 && previousLod < lodCount)
+	{
+		int previous = (previousLod == -1) ? lodCount : previousLod;
+		float lowerSize = (previous < lodCount) ? GetLODScreenSize(object, previous) * (1.0 - LODParams.y) : 0.0;
+		float upperSize = (previous > 0) ? GetLODScreenSize(object, previous - 1) * (1.0 + LODParams.y) : 1e30;
+		if (screenSize >= lowerSize && screenSize < upperSize)
+			return previousLod;
+	}
+
+	[loop]
+	for (int lod = 0; lod < lodCount; lod++)
+	{
+		if (screenSize >= GetLODScreenSize(object, lod))
+			return lod;
+	}
 	return -1;
 }
 
 [numthreads(64, 1, 1)]
 void CSMain(int3 DTid : SV_DispatchThreadID)
 {
-	int index = DTid.x;
-	if (index >= OriginalInstancesCount)
+	uint index = DTid.x;
+	if (index >= Counts.x)
 		return;
 
+	CullingObject object = objects[instanceObjects[index]];
 	Instance data = instanceData[index];
 
 	bool isCulled = PerformFrustumCull(data.AABBmin, data.AABBmax);
 	if (!isCulled)
 	{
-		int lod = CalculateLodIndex(data.WorldMat);
+		int lod = CalculateLodIndex(object, CalculateScreenSize(data.AABBmin, data.AABBmax), (int)instancesLODs[index] - 1);
+		instancesLODs[index] = (uint)(lod + 1);
 		if (lod == -1)
 			return;
 
 		// we just need to copy the counters for all meshes in that lod
-		for (int mesh = 0; mesh < MAX_MESH_COUNT; mesh++)
+		for (uint mesh = 0; mesh < object.MeshCount; mesh++)
 		{
-			uint offset = MAX_MESH_COUNT * lod + mesh;
+			uint offset = object.ArgsOffset + (MAX_MESH_COUNT * lod + mesh) * 5;
 
 			uint outIndex;
-			InterlockedAdd(argsBuffer[offset * 5 + 1], 1, outIndex);
+			InterlockedAdd(argsBuffer[offset + 1], 1, outIndex);
 			if (mesh == 0)
-				newInstanceData[OriginalInstancesCount * lod + outIndex] = data;
+				newInstanceData[object.CulledInstancesOffset + object.InstancesCount * lod + outIndex] = data;
 		}
 	}
 }
\ No newline at end of file
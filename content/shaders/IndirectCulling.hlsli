@@ -7,4 +7,18 @@ struct Instance
 	float4x4 WorldMat;
 	float4 AABBmin;
 	float4 AABBmax;
+};
+
+// indirectly rendered object in the batched culling pass (should match ER_GPUCullingObject)
+struct CullingObject
+{
+	uint FirstInstance; // in the instance table
+	uint InstancesCount;
+	uint CulledInstancesOffset; // in the culled instances buffer ("InstancesCount" slots per LOD)
+	uint ArgsOffset; // in the args buffer, MAX_LOD_COUNT * MAX_MESH_COUNT * 5 per object
+	uint LODCount;
+	uint MeshCount;
+	float LODBias;
+	uint Padding;
+	float4 LODScreenSizes; // see ER_RenderingObject::SelectLOD()
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 // Supports:
 // - Shadow Mapping
 // - Instancing
+// - Incremental updates (only the voxels inside of the dirty regions of the cascade are written)
 //
 // TODO:
 // - store normals in voxels
@@ -12,6 +13,8 @@
 // Written by Gen Afanasev for 'EveryRay Rendering Engine', 2017-2022
 // ================================================================================================
 
+#define MAX_DIRTY_REGIONS 8 // ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS
+
 cbuffer VoxelizationCB : register(b0)
 {
     float4x4 World;
@@ -22,6 +25,10 @@ cbuffer VoxelizationCB : register(b0)
     float4 VoxelCameraPos;
     float VoxelTextureDimension;
     float WorldVoxelScale;
+    uint DirtyRegionsCount; // 0 - whole cascade
+    float pad0;
+    int4 DirtyRegionsMin[MAX_DIRTY_REGIONS]; // in texels
+    int4 DirtyRegionsMax[MAX_DIRTY_REGIONS];
 };
 
 RWTexture3D<float4> OutputTexture : register(u0);
@@ -161,12 +168,27 @@ float GetShadow(float3 ShadowCoord, float depthDistance)
     return CalculateShadow(ShadowCoord);
 }
 
+bool IsInDirtyRegion(int3 voxelPos)
+{
+    if (DirtyRegionsCount == 0)
+        return true;
+
+    for (uint i = 0; i < DirtyRegionsCount; i++)
+    {
+        if (all(voxelPos >= DirtyRegionsMin[i].xyz) && all(voxelPos < DirtyRegionsMax[i].xyz))
+            return true;
+    }
+    return false;
+}
+
 void PSMain(PS_IN input)
 {
     float3 voxelPos = input.VoxelPos.rgb;
     voxelPos.y = -voxelPos.y;
     
     int3 finalVoxelPos = int3((float)VoxelTextureDimension * float3(0.5f * voxelPos + float3(0.5f, 0.5f, 0.5f)));
+    if (!IsInDirtyRegion(finalVoxelPos))
+        return; // voxels from the previous frames are still valid there
     float4 colorRes = AlbedoTexture.Sample(LinearSampler, input.UV);
     
     //voxelPos.y = -voxelPos.y;
@@ -0,0 +1,109 @@
+#include "stdafx.h"
+
+#include "ER_Allocators.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	static size_t AlignUp(size_t aValue, size_t aAlignment)
+	{
+		return (aValue + aAlignment - 1) & ~(aAlignment - 1);
+	}
+
+	ER_LinearAllocator::ER_LinearAllocator(size_t aCapacity)
+		: mCapacity(AlignUp(aCapacity, ER_ALLOCATOR_DEFAULT_ALIGNMENT))
+	{
+		if (mCapacity > 0)
+			mBuffer = static_cast<char*>(_aligned_malloc(mCapacity, ER_ALLOCATOR_DEFAULT_ALIGNMENT));
+	}
+
+	ER_LinearAllocator::~ER_LinearAllocator()
+	{
+		Reset();
+		_aligned_free(mBuffer);
+		mBuffer = nullptr;
+	}
+
+	void* ER_LinearAllocator::Allocate(size_t aSize, size_t aAlignment)
+	{
+		assert(aSize > 0);
+		assert(aAlignment > 0 && (aAlignment & (aAlignment - 1)) == 0);
+
+		// reserve the worst case for the alignment, so that we only need one atomic operation
+		const size_t reservedSize = AlignUp(aSize, ER_ALLOCATOR_DEFAULT_ALIGNMENT) + (aAlignment > ER_ALLOCATOR_DEFAULT_ALIGNMENT ? aAlignment : 0);
+		const size_t offset = mOffset.fetch_add(reservedSize, std::memory_order_relaxed);
+		mAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (offset + reservedSize <= mCapacity)
+			return reinterpret_cast<void*>(AlignUp(reinterpret_cast<size_t>(mBuffer + offset), aAlignment));
+
+		// arena is full: it will be grown in Reset(), until then use the heap
+		void* memory = _aligned_malloc(aSize, std::max(aAlignment, static_cast<size_t>(ER_ALLOCATOR_DEFAULT_ALIGNMENT)));
+		assert(memory);
+		const std::lock_guard<std::mutex> lock(mOverflowMutex);
+		mOverflowAllocations.push_back(memory);
+		mHeapAllocationsCount++;
+		return memory;
+	}
+
+	void ER_LinearAllocator::Reset()
+	{
+		const size_t usedBytes = mOffset.load(std::memory_order_relaxed);
+		mPeakBytes = std::max(mPeakBytes, static_cast<UINT64>(usedBytes));
+
+		for (void* memory : mOverflowAllocations)
+			_aligned_free(memory);
+		mOverflowAllocations.clear();
+
+		if (usedBytes > mCapacity)
+		{
+			const size_t oldCapacity = mCapacity;
+			mCapacity = AlignUp(usedBytes + usedBytes / 2, ER_ALLOCATOR_DEFAULT_ALIGNMENT);
+			_aligned_free(mBuffer);
+			mBuffer = static_cast<char*>(_aligned_malloc(mCapacity, ER_ALLOCATOR_DEFAULT_ALIGNMENT));
+			mHeapAllocationsCount++;
+
+			std::string message = "[ER Logger][ER_LinearAllocator] Arena was full, growing it from " + std::to_string(oldCapacity) + " to " + std::to_string(mCapacity) + " bytes\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+
+		mOffset.store(0, std::memory_order_relaxed);
+		mAllocationsCount.store(0, std::memory_order_relaxed);
+	}
+
+	ER_AllocatorStats ER_LinearAllocator::GetStats() const
+	{
+		ER_AllocatorStats stats;
+		stats.AllocationsCount = mAllocationsCount.load(std::memory_order_relaxed);
+		stats.UsedBytes = mOffset.load(std::memory_order_relaxed);
+		stats.PeakBytes = std::max(mPeakBytes, stats.UsedBytes);
+		stats.CapacityBytes = mCapacity;
+		stats.HeapAllocationsCount = mHeapAllocationsCount;
+		return stats;
+	}
+
+	ER_FrameAllocator::ER_FrameAllocator(size_t aCapacityPerFrame)
+	{
+		for (int i = 0; i < ER_FRAME_ALLOCATOR_FRAMES_COUNT; i++)
+			mArenas[i].reset(new ER_LinearAllocator(aCapacityPerFrame));
+	}
+
+	void ER_FrameAllocator::BeginFrame()
+	{
+		mCurrentArena = (mCurrentArena + 1) % ER_FRAME_ALLOCATOR_FRAMES_COUNT;
+		mArenas[mCurrentArena]->Reset();
+	}
+
+	ER_AllocatorStats ER_FrameAllocator::GetStats() const
+	{
+		ER_AllocatorStats stats = mArenas[mCurrentArena]->GetStats();
+		stats.HeapAllocationsCount = 0;
+		for (int i = 0; i < ER_FRAME_ALLOCATOR_FRAMES_COUNT; i++)
+		{
+			ER_AllocatorStats arenaStats = mArenas[i]->GetStats();
+			stats.HeapAllocationsCount += arenaStats.HeapAllocationsCount;
+			stats.PeakBytes = std::max(stats.PeakBytes, arenaStats.PeakBytes);
+		}
+		return stats;
+	}
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <type_traits>
+#include <algorithm>
+
+#define ER_FRAME_ALLOCATOR_FRAMES_COUNT 2 // same as the number of back buffers: data of the previous frame is still valid during the current one
+#define ER_FRAME_ALLOCATOR_DEFAULT_CAPACITY (4 * 1024 * 1024)
+#define ER_ALLOCATOR_DEFAULT_ALIGNMENT 16 // enough for DirectXMath types
+
+namespace EveryRay_Core
+{
+	struct ER_AllocatorStats
+	{
+		UINT64 AllocationsCount = 0; // linear: since the last reset, pool: objects that are currently alive
+		UINT64 UsedBytes = 0;
+		UINT64 PeakBytes = 0;
+		UINT64 CapacityBytes = 0;
+		UINT64 HeapAllocationsCount = 0; // total number of times the allocator had to go to the heap (overflows, growth); should not change in steady-state frames
+	};
+
+	// Lock-free bump allocator: allocations are just an atomic add, there is no free - everything is released at once in Reset().
+	// Memory is not constructed/destructed, so only use it for trivially destructible types.
+	// If the arena is full, allocations fall back to the heap until the next Reset(), which grows the arena to fit the peak.
+	class ER_LinearAllocator
+	{
+	public:
+		ER_LinearAllocator(size_t aCapacity);
+		~ER_LinearAllocator();
+
+		void* Allocate(size_t aSize, size_t aAlignment = ER_ALLOCATOR_DEFAULT_ALIGNMENT); // thread-safe
+
+		template<typename T>
+		T* AllocateArray(size_t aCount)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "ER_LinearAllocator does not call destructors");
+			return aCount > 0 ? static_cast<T*>(Allocate(sizeof(T) * aCount, alignof(T) > ER_ALLOCATOR_DEFAULT_ALIGNMENT ? alignof(T) : ER_ALLOCATOR_DEFAULT_ALIGNMENT)) : nullptr;
+		}
+
+		void Reset(); // not thread-safe: nobody should allocate or use the memory at this point
+		ER_AllocatorStats GetStats() const;
+	private:
+		ER_LinearAllocator(const ER_LinearAllocator&) = delete;
+		ER_LinearAllocator& operator=(const ER_LinearAllocator&) = delete;
+
+		char* mBuffer = nullptr;
+		size_t mCapacity = 0;
+		std::atomic<size_t> mOffset{ 0 }; // can go past the capacity (then it is the size we should have had)
+		std::atomic<UINT64> mAllocationsCount{ 0 };
+		UINT64 mPeakBytes = 0;
+		UINT64 mHeapAllocationsCount = 0;
+
+		std::vector<void*> mOverflowAllocations;
+		std::mutex mOverflowMutex;
+	};
+
+	// Per-frame scratch memory (owned by ER_Core): ER_FRAME_ALLOCATOR_FRAMES_COUNT linear arenas used in turn.
+	// Memory allocated during a frame stays valid until BeginFrame() is called ER_FRAME_ALLOCATOR_FRAMES_COUNT times.
+	class ER_FrameAllocator
+	{
+	public:
+		ER_FrameAllocator(size_t aCapacityPerFrame = ER_FRAME_ALLOCATOR_DEFAULT_CAPACITY);
+		~ER_FrameAllocator() {}
+
+		void BeginFrame(); // main thread only, when no jobs are running
+
+		void* Allocate(size_t aSize, size_t aAlignment = ER_ALLOCATOR_DEFAULT_ALIGNMENT) { return mArenas[mCurrentArena]->Allocate(aSize, aAlignment); }
+		template<typename T>
+		T* AllocateArray(size_t aCount) { return mArenas[mCurrentArena]->AllocateArray<T>(aCount); }
+
+		ER_AllocatorStats GetStats() const; // of the current frame (heap allocations are summed over all arenas)
+	private:
+		ER_FrameAllocator(const ER_FrameAllocator&) = delete;
+		ER_FrameAllocator& operator=(const ER_FrameAllocator&) = delete;
+
+		std::unique_ptr<ER_LinearAllocator> mArenas[ER_FRAME_ALLOCATOR_FRAMES_COUNT];
+		UINT mCurrentArena = 0;
+	};
+
+	// Fixed-size slots of T, allocated in chunks of "ChunkSize" and reused through a free list.
+	// Thread-safe (objects can be freed from a different thread than the one that allocated them).
+	template<typename T, UINT ChunkSize = 64>
+	class ER_PoolAllocator
+	{
+	public:
+		ER_PoolAllocator() {}
+		~ER_PoolAllocator()
+		{
+			assert(("ER_PoolAllocator: some objects were not deleted", mAliveCount == 0));
+			for (Slot* chunk : mChunks)
+				delete[] chunk;
+		}
+
+		template<typename... Args>
+		T* New(Args&&... aArgs)
+		{
+			void* memory = nullptr;
+			{
+				const std::lock_guard<std::mutex> lock(mMutex);
+				if (!mFreeList)
+					AddChunk();
+				memory = mFreeList;
+				mFreeList = mFreeList->Next;
+				mAliveCount++;
+				mPeakAliveCount = std::max(mPeakAliveCount, mAliveCount);
+			}
+			return new (memory) T(std::forward<Args>(aArgs)...);
+		}
+
+		void Delete(T* aObject)
+		{
+			if (!aObject)
+				return;
+			aObject->~T();
+
+			const std::lock_guard<std::mutex> lock(mMutex);
+			Slot* slot = reinterpret_cast<Slot*>(aObject);
+			slot->Next = mFreeList;
+			mFreeList = slot;
+			mAliveCount--;
+		}
+
+		ER_AllocatorStats GetStats()
+		{
+			const std::lock_guard<std::mutex> lock(mMutex);
+			ER_AllocatorStats stats;
+			stats.AllocationsCount = mAliveCount;
+			stats.UsedBytes = mAliveCount * sizeof(Slot);
+			stats.PeakBytes = mPeakAliveCount * sizeof(Slot);
+			stats.CapacityBytes = mChunks.size() * ChunkSize * sizeof(Slot);
+			stats.HeapAllocationsCount = mChunks.size();
+			return stats;
+		}
+	private:
+		ER_PoolAllocator(const ER_PoolAllocator&) = delete;
+		ER_PoolAllocator& operator=(const ER_PoolAllocator&) = delete;
+
+		union Slot
+		{
+			Slot* Next;
+			alignas(T) char Storage[sizeof(T)];
+		};
+
+		void AddChunk()
+		{
+			Slot* chunk = new Slot[ChunkSize];
+			for (UINT i = 0; i < ChunkSize - 1; i++)
+				chunk[i].Next = &chunk[i + 1];
+			chunk[ChunkSize - 1].Next = mFreeList;
+			mFreeList = chunk;
+			mChunks.push_back(chunk);
+		}
+
+		std::vector<Slot*> mChunks;
+		Slot* mFreeList = nullptr;
+		UINT64 mAliveCount = 0;
+		UINT64 mPeakAliveCount = 0;
+		std::mutex mMutex;
+	};
+}
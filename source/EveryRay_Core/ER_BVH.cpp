@@ -0,0 +1,446 @@
+#include "stdafx.h"
+
+#include "ER_BVH.h"
+#include "ER_Ray.h"
+
+#define ER_BVH_TRAVERSAL_COST 1.0f // SAH cost of visiting a node (relative to testing one item)
+#define ER_BVH_STACK_SIZE (2 * ER_BVH_MAX_DEPTH)
+
+namespace EveryRay_Core
+{
+	static ER_AABB GetEmptyAABB()
+	{
+		return ER_AABB(XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+	}
+
+	static void GrowAABB(ER_AABB& aabb, const ER_AABB& other)
+	{
+		aabb.first = XMFLOAT3(std::min(aabb.first.x, other.first.x), std::min(aabb.first.y, other.first.y), std::min(aabb.first.z, other.first.z));
+		aabb.second = XMFLOAT3(std::max(aabb.second.x, other.second.x), std::max(aabb.second.y, other.second.y), std::max(aabb.second.z, other.second.z));
+	}
+
+	static void GrowAABB(ER_AABB& aabb, const XMFLOAT3& point)
+	{
+		aabb.first = XMFLOAT3(std::min(aabb.first.x, point.x), std::min(aabb.first.y, point.y), std::min(aabb.first.z, point.z));
+		aabb.second = XMFLOAT3(std::max(aabb.second.x, point.x), std::max(aabb.second.y, point.y), std::max(aabb.second.z, point.z));
+	}
+
+	static float GetSurfaceArea(const ER_AABB& aabb)
+	{
+		const float x = aabb.second.x - aabb.first.x;
+		const float y = aabb.second.y - aabb.first.y;
+		const float z = aabb.second.z - aabb.first.z;
+		if (x < 0.0f || y < 0.0f || z < 0.0f) // empty
+			return 0.0f;
+		return 2.0f * (x * y + y * z + z * x);
+	}
+
+	static float GetAxis(const XMFLOAT3& v, int axis)
+	{
+		return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+	}
+
+	static bool AreAABBsOverlapping(const ER_AABB& a, const ER_AABB& b)
+	{
+		return
+			(a.first.x <= b.second.x && a.second.x >= b.first.x) &&
+			(a.first.y <= b.second.y && a.second.y >= b.first.y) &&
+			(a.first.z <= b.second.z && a.second.z >= b.first.z);
+	}
+
+	static bool IsAABBInSphere(const ER_AABB& aabb, const XMFLOAT3& center, float radiusSq)
+	{
+		// squared distance from the center to the closest point of the box
+		float distanceSq = 0.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float c = GetAxis(center, axis);
+			const float d = std::max(GetAxis(aabb.first, axis) - c, 0.0f) + std::max(c - GetAxis(aabb.second, axis), 0.0f);
+			distanceSq += d * d;
+		}
+		return distanceSq <= radiusSq;
+	}
+
+	// slab test, returns the entry distance (clamped to 0) if the box is hit within "maxDistance"
+	static bool IntersectRayAABB(const ER_AABB& aabb, const XMFLOAT3& origin, const XMFLOAT3& invDirection, float maxDistance, float& outDistance)
+	{
+		const float tx1 = (aabb.first.x - origin.x) * invDirection.x, tx2 = (aabb.second.x - origin.x) * invDirection.x;
+		const float ty1 = (aabb.first.y - origin.y) * invDirection.y, ty2 = (aabb.second.y - origin.y) * invDirection.y;
+		const float tz1 = (aabb.first.z - origin.z) * invDirection.z, tz2 = (aabb.second.z - origin.z) * invDirection.z;
+
+		const float tMin = std::max(std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2)), 0.0f);
+		const float tMax = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2));
+		if (tMax < tMin || tMin > maxDistance)
+			return false;
+
+		outDistance = tMin;
+		return true;
+	}
+
+	// 0 - culled, 1 - intersecting (some planes remain in "planesMask"), 2 - fully inside of all planes
+	static int ClassifyAABB(const ER_AABB& aabb, const XMFLOAT4* planes, UINT planesCount, UINT& planesMask)
+	{
+		const XMFLOAT3 center = XMFLOAT3((aabb.first.x + aabb.second.x) * 0.5f, (aabb.first.y + aabb.second.y) * 0.5f, (aabb.first.z + aabb.second.z) * 0.5f);
+		const XMFLOAT3 extent = XMFLOAT3((aabb.second.x - aabb.first.x) * 0.5f, (aabb.second.y - aabb.first.y) * 0.5f, (aabb.second.z - aabb.first.z) * 0.5f);
+		for (UINT planeID = 0; planeID < planesCount; planeID++)
+		{
+			if (!(planesMask & (1u << planeID)))
+				continue;
+
+			const XMFLOAT4& plane = planes[planeID];
+			const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			const float radius = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+			if (distance - radius > 0.0f)
+				return 0;
+			if (distance + radius <= 0.0f) // children are inside of this plane too, no need to test them against it
+				planesMask &= ~(1u << planeID);
+		}
+		return planesMask ? 1 : 2;
+	}
+
+	void ER_BVH::Clear()
+	{
+		mNodes.clear();
+		mItemsOrder.clear();
+		mItemsBounds.clear();
+		mCost = 0.0f;
+		mBuildCost = 0.0f;
+		mDepth = 0;
+	}
+
+	void ER_BVH::Build(const ER_AABB* aItemsBounds, UINT aItemsCount)
+	{
+		Clear();
+		if (aItemsCount == 0)
+			return;
+		assert(aItemsBounds);
+
+		mItemsOrder.resize(aItemsCount);
+		mCentroids.resize(aItemsCount);
+		for (UINT i = 0; i < aItemsCount; i++)
+		{
+			mItemsOrder[i] = i;
+			mCentroids[i] = XMFLOAT3(
+				(aItemsBounds[i].first.x + aItemsBounds[i].second.x) * 0.5f,
+				(aItemsBounds[i].first.y + aItemsBounds[i].second.y) * 0.5f,
+				(aItemsBounds[i].first.z + aItemsBounds[i].second.z) * 0.5f);
+		}
+
+		mNodes.reserve(2 * aItemsCount - 1);
+		mNodes.emplace_back();
+		mNodes[0].LeftOrFirstItem = 0;
+		mNodes[0].ItemsCount = aItemsCount;
+		Split(0, aItemsBounds, 1);
+
+		// items' bounds are stored in the leaves order, so that leaves read them sequentially
+		mItemsBounds.resize(aItemsCount);
+		for (UINT i = 0; i < aItemsCount; i++)
+			mItemsBounds[i] = aItemsBounds[mItemsOrder[i]];
+
+		mCost = mBuildCost = ComputeCost();
+	}
+
+	void ER_BVH::Split(UINT aNodeIndex, const ER_AABB* aItemsBounds, UINT aDepth)
+	{
+		mDepth = std::max(mDepth, aDepth);
+
+		const UINT first = mNodes[aNodeIndex].LeftOrFirstItem;
+		const UINT count = mNodes[aNodeIndex].ItemsCount;
+
+		ER_AABB bounds = GetEmptyAABB();
+		ER_AABB centroidsBounds = GetEmptyAABB();
+		for (UINT i = first; i < first + count; i++)
+		{
+			GrowAABB(bounds, aItemsBounds[mItemsOrder[i]]);
+			GrowAABB(centroidsBounds, mCentroids[mItemsOrder[i]]);
+		}
+		mNodes[aNodeIndex].Bounds = bounds;
+
+		if (count <= ER_BVH_MAX_LEAF_ITEMS || aDepth >= ER_BVH_MAX_DEPTH)
+			return;
+
+		// binned SAH: find the cheapest of the (ER_BVH_SAH_BINS_COUNT - 1) split planes on every axis
+		struct Bin
+		{
+			ER_AABB Bounds;
+			UINT Count;
+		};
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		int bestSplit = 0; // number of bins on the left
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float minCentroid = GetAxis(centroidsBounds.first, axis);
+			const float extent = GetAxis(centroidsBounds.second, axis) - minCentroid;
+			if (extent <= 1e-6f)
+				continue;
+			const float scale = ER_BVH_SAH_BINS_COUNT / extent;
+
+			Bin bins[ER_BVH_SAH_BINS_COUNT];
+			for (int bin = 0; bin < ER_BVH_SAH_BINS_COUNT; bin++)
+			{
+				bins[bin].Bounds = GetEmptyAABB();
+				bins[bin].Count = 0;
+			}
+			for (UINT i = first; i < first + count; i++)
+			{
+				const int bin = std::min(ER_BVH_SAH_BINS_COUNT - 1, static_cast<int>((GetAxis(mCentroids[mItemsOrder[i]], axis) - minCentroid) * scale));
+				GrowAABB(bins[bin].Bounds, aItemsBounds[mItemsOrder[i]]);
+				bins[bin].Count++;
+			}
+
+			float rightCosts[ER_BVH_SAH_BINS_COUNT]; // [i] - cost of the bins [i, ER_BVH_SAH_BINS_COUNT)
+			ER_AABB rightBounds = GetEmptyAABB();
+			UINT rightCount = 0;
+			for (int bin = ER_BVH_SAH_BINS_COUNT - 1; bin > 0; bin--)
+			{
+				GrowAABB(rightBounds, bins[bin].Bounds);
+				rightCount += bins[bin].Count;
+				rightCosts[bin] = GetSurfaceArea(rightBounds) * rightCount;
+			}
+
+			ER_AABB leftBounds = GetEmptyAABB();
+			UINT leftCount = 0;
+			for (int bin = 0; bin < ER_BVH_SAH_BINS_COUNT - 1; bin++)
+			{
+				GrowAABB(leftBounds, bins[bin].Bounds);
+				leftCount += bins[bin].Count;
+				if (leftCount == 0 || leftCount == count)
+					continue;
+
+				const float cost = GetSurfaceArea(leftBounds) * leftCount + rightCosts[bin + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = bin + 1;
+				}
+			}
+		}
+
+		UINT leftCount = count / 2;
+		if (bestAxis >= 0)
+		{
+			const float nodeArea = GetSurfaceArea(bounds);
+			const float splitCost = ER_BVH_TRAVERSAL_COST + (nodeArea > 0.0f ? bestCost / nodeArea : 0.0f);
+			if (splitCost >= static_cast<float>(count) && count <= ER_BVH_MAX_SAH_LEAF_ITEMS)
+				return;
+
+			const float minCentroid = GetAxis(centroidsBounds.first, bestAxis);
+			const float scale = ER_BVH_SAH_BINS_COUNT / (GetAxis(centroidsBounds.second, bestAxis) - minCentroid);
+			auto middle = std::partition(mItemsOrder.begin() + first, mItemsOrder.begin() + first + count, [&](UINT item)
+			{
+				const int bin = std::min(ER_BVH_SAH_BINS_COUNT - 1, static_cast<int>((GetAxis(mCentroids[item], bestAxis) - minCentroid) * scale));
+				return bin < bestSplit;
+			});
+			leftCount = static_cast<UINT>(middle - (mItemsOrder.begin() + first));
+			if (leftCount == 0 || leftCount == count)
+				leftCount = count / 2;
+		}
+		else if (count <= ER_BVH_MAX_SAH_LEAF_ITEMS) // all centroids are in the same spot: SAH can not separate them
+			return;
+
+		const UINT leftIndex = static_cast<UINT>(mNodes.size());
+		mNodes.emplace_back();
+		mNodes.emplace_back();
+		mNodes[leftIndex].LeftOrFirstItem = first;
+		mNodes[leftIndex].ItemsCount = leftCount;
+		mNodes[leftIndex + 1].LeftOrFirstItem = first + leftCount;
+		mNodes[leftIndex + 1].ItemsCount = count - leftCount;
+		mNodes[aNodeIndex].LeftOrFirstItem = leftIndex;
+		mNodes[aNodeIndex].ItemsCount = 0;
+
+		Split(leftIndex, aItemsBounds, aDepth + 1);
+		Split(leftIndex + 1, aItemsBounds, aDepth + 1);
+	}
+
+	void ER_BVH::Refit(const ER_AABB* aItemsBounds)
+	{
+		if (mNodes.empty())
+			return;
+		assert(aItemsBounds);
+
+		for (UINT i = 0; i < static_cast<UINT>(mItemsOrder.size()); i++)
+			mItemsBounds[i] = aItemsBounds[mItemsOrder[i]];
+
+		// children are always after their parents, so the reverse order is bottom-up
+		for (int nodeIndex = static_cast<int>(mNodes.size()) - 1; nodeIndex >= 0; nodeIndex--)
+		{
+			ER_BVHNode& node = mNodes[nodeIndex];
+			if (node.IsLeaf())
+			{
+				node.Bounds = GetEmptyAABB();
+				for (UINT i = node.LeftOrFirstItem; i < node.LeftOrFirstItem + node.ItemsCount; i++)
+					GrowAABB(node.Bounds, mItemsBounds[i]);
+			}
+			else
+			{
+				node.Bounds = mNodes[node.LeftOrFirstItem].Bounds;
+				GrowAABB(node.Bounds, mNodes[node.LeftOrFirstItem + 1].Bounds);
+			}
+		}
+
+		mCost = ComputeCost();
+	}
+
+	float ER_BVH::ComputeCost() const
+	{
+		if (mNodes.empty())
+			return 0.0f;
+
+		const float rootArea = GetSurfaceArea(mNodes[0].Bounds);
+		if (rootArea <= 0.0f)
+			return 0.0f;
+
+		float cost = 0.0f;
+		for (const ER_BVHNode& node : mNodes)
+			cost += GetSurfaceArea(node.Bounds) * (node.IsLeaf() ? static_cast<float>(node.ItemsCount) : ER_BVH_TRAVERSAL_COST);
+		return cost / rootArea;
+	}
+
+	void ER_BVH::QueryFrustum(const XMFLOAT4* aPlanes, UINT aPlanesCount, std::vector<UINT>& aOutItems) const
+	{
+		assert(aPlanesCount <= 32);
+		if (mNodes.empty())
+			return;
+
+		struct StackEntry
+		{
+			UINT Node;
+			UINT PlanesMask; // planes that the node still has to be tested against
+		};
+		StackEntry stack[ER_BVH_STACK_SIZE];
+		UINT stackSize = 0;
+		stack[stackSize++] = { 0, (aPlanesCount == 32) ? 0xFFFFFFFF : ((1u << aPlanesCount) - 1) };
+
+		while (stackSize > 0)
+		{
+			StackEntry entry = stack[--stackSize];
+			const ER_BVHNode& node = mNodes[entry.Node];
+			if (entry.PlanesMask && ClassifyAABB(node.Bounds, aPlanes, aPlanesCount, entry.PlanesMask) == 0)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				for (UINT i = node.LeftOrFirstItem; i < node.LeftOrFirstItem + node.ItemsCount; i++)
+				{
+					UINT planesMask = entry.PlanesMask;
+					if (!planesMask || ClassifyAABB(mItemsBounds[i], aPlanes, aPlanesCount, planesMask) != 0)
+						aOutItems.push_back(mItemsOrder[i]);
+				}
+			}
+			else
+			{
+				assert(stackSize + 2 <= ER_BVH_STACK_SIZE);
+				stack[stackSize++] = { node.LeftOrFirstItem + 1, entry.PlanesMask };
+				stack[stackSize++] = { node.LeftOrFirstItem, entry.PlanesMask };
+			}
+		}
+	}
+
+	void ER_BVH::QueryAABB(const ER_AABB& aAABB, std::vector<UINT>& aOutItems) const
+	{
+		if (mNodes.empty())
+			return;
+
+		UINT stack[ER_BVH_STACK_SIZE];
+		UINT stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const ER_BVHNode& node = mNodes[stack[--stackSize]];
+			if (!AreAABBsOverlapping(node.Bounds, aAABB))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				for (UINT i = node.LeftOrFirstItem; i < node.LeftOrFirstItem + node.ItemsCount; i++)
+				{
+					if (AreAABBsOverlapping(mItemsBounds[i], aAABB))
+						aOutItems.push_back(mItemsOrder[i]);
+				}
+			}
+			else
+			{
+				assert(stackSize + 2 <= ER_BVH_STACK_SIZE);
+				stack[stackSize++] = node.LeftOrFirstItem + 1;
+				stack[stackSize++] = node.LeftOrFirstItem;
+			}
+		}
+	}
+
+	void ER_BVH::QuerySphere(const XMFLOAT3& aCenter, float aRadius, std::vector<UINT>& aOutItems) const
+	{
+		if (mNodes.empty())
+			return;
+
+		const float radiusSq = aRadius * aRadius;
+		UINT stack[ER_BVH_STACK_SIZE];
+		UINT stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const ER_BVHNode& node = mNodes[stack[--stackSize]];
+			if (!IsAABBInSphere(node.Bounds, aCenter, radiusSq))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				for (UINT i = node.LeftOrFirstItem; i < node.LeftOrFirstItem + node.ItemsCount; i++)
+				{
+					if (IsAABBInSphere(mItemsBounds[i], aCenter, radiusSq))
+						aOutItems.push_back(mItemsOrder[i]);
+				}
+			}
+			else
+			{
+				assert(stackSize + 2 <= ER_BVH_STACK_SIZE);
+				stack[stackSize++] = node.LeftOrFirstItem + 1;
+				stack[stackSize++] = node.LeftOrFirstItem;
+			}
+		}
+	}
+
+	void ER_BVH::QueryRay(const ER_Ray& aRay, float aMaxDistance, std::vector<ER_BVHRayHit>& aOutHits) const
+	{
+		if (mNodes.empty())
+			return;
+
+		const XMFLOAT3& origin = aRay.Position();
+		const XMFLOAT3& direction = aRay.Direction();
+		// division by 0 gives infinities, which the slab test handles
+		const XMFLOAT3 invDirection = XMFLOAT3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+		const size_t firstHit = aOutHits.size();
+		UINT stack[ER_BVH_STACK_SIZE];
+		UINT stackSize = 0;
+		stack[stackSize++] = 0;
+
+		float distance = 0.0f;
+		while (stackSize > 0)
+		{
+			const ER_BVHNode& node = mNodes[stack[--stackSize]];
+			if (!IntersectRayAABB(node.Bounds, origin, invDirection, aMaxDistance, distance))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				for (UINT i = node.LeftOrFirstItem; i < node.LeftOrFirstItem + node.ItemsCount; i++)
+				{
+					if (IntersectRayAABB(mItemsBounds[i], origin, invDirection, aMaxDistance, distance))
+						aOutHits.push_back({ mItemsOrder[i], distance });
+				}
+			}
+			else
+			{
+				assert(stackSize + 2 <= ER_BVH_STACK_SIZE);
+				stack[stackSize++] = node.LeftOrFirstItem + 1;
+				stack[stackSize++] = node.LeftOrFirstItem;
+			}
+		}
+
+		std::sort(aOutHits.begin() + firstHit, aOutHits.end(), [](const ER_BVHRayHit& a, const ER_BVHRayHit& b) { return a.Distance < b.Distance; });
+	}
+}
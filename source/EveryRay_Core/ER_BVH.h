@@ -0,0 +1,72 @@
+#pragma once
+#include "Common.h"
+
+#define ER_BVH_MAX_LEAF_ITEMS 4 // nodes with this many items (or less) are never split
+#define ER_BVH_MAX_SAH_LEAF_ITEMS 16 // nodes with this many items (or less) become leaves if SAH says that splitting is not worth it
+#define ER_BVH_SAH_BINS_COUNT 12
+#define ER_BVH_MAX_DEPTH 48 // deeper nodes are always leaves (also limits the traversal stack)
+#define ER_BVH_REBUILD_COST_RATIO 1.5f // refitted tree should be rebuilt when its SAH cost grows by this factor
+
+namespace EveryRay_Core
+{
+	class ER_Ray;
+
+	struct ER_BVHNode
+	{
+		ER_AABB Bounds;
+		UINT LeftOrFirstItem = 0; // inner node: index of the left child (the right one is next to it), leaf: first index in the items order
+		UINT ItemsCount = 0; // 0 for inner nodes
+
+		bool IsLeaf() const { return ItemsCount > 0; }
+	};
+
+	struct ER_BVHRayHit
+	{
+		UINT Item;
+		float Distance; // along the ray to the item's AABB (0 if the ray starts inside)
+	};
+
+	// Bounding volume hierarchy over a set of AABBs ("items" are indices in the array that was passed to Build()).
+	// - built top-down with binned SAH (surface area heuristic)
+	// - when items move, Refit() updates the bounds of the nodes bottom-up in O(n) without changing the topology;
+	//   the quality of a refitted tree slowly degrades, so NeedsRebuild() tells when it is better to build it again
+	// Queries can be executed in parallel with each other, but not with Build()/Refit().
+	class ER_BVH
+	{
+	public:
+		ER_BVH() {}
+		~ER_BVH() {}
+
+		void Build(const ER_AABB* aItemsBounds, UINT aItemsCount);
+		void Refit(const ER_AABB* aItemsBounds); // same items (count and order) as in the last Build()
+		bool NeedsRebuild() const { return mCost > mBuildCost * ER_BVH_REBUILD_COST_RATIO; }
+		void Clear();
+
+		// Queries append the indices of the items to the output (in traversal order)
+		void QueryFrustum(const XMFLOAT4* aPlanes, UINT aPlanesCount, std::vector<UINT>& aOutItems) const; // outward facing planes (see ER_Frustum), up to 32
+		void QueryAABB(const ER_AABB& aAABB, std::vector<UINT>& aOutItems) const;
+		void QuerySphere(const XMFLOAT3& aCenter, float aRadius, std::vector<UINT>& aOutItems) const;
+		void QueryRay(const ER_Ray& aRay, float aMaxDistance, std::vector<ER_BVHRayHit>& aOutHits) const; // hits are sorted by distance
+
+		UINT GetItemsCount() const { return static_cast<UINT>(mItemsOrder.size()); }
+		UINT GetNodesCount() const { return static_cast<UINT>(mNodes.size()); }
+		UINT GetDepth() const { return mDepth; }
+		float GetCost() const { return mCost; }
+		float GetBuildCost() const { return mBuildCost; }
+	private:
+		ER_BVH(const ER_BVH&) = delete;
+		ER_BVH& operator=(const ER_BVH&) = delete;
+
+		void Split(UINT aNodeIndex, const ER_AABB* aItemsBounds, UINT aDepth);
+		float ComputeCost() const;
+
+		std::vector<ER_BVHNode> mNodes; // root is the first one, children are always stored after their parents
+		std::vector<UINT> mItemsOrder; // leaves reference ranges of it
+		std::vector<ER_AABB> mItemsBounds; // copy of the items' bounds in "mItemsOrder"
+		std::vector<XMFLOAT3> mCentroids; // of the items (only used in Build())
+
+		float mCost = 0.0f; // SAH cost of the current tree (relative to the root's surface area)
+		float mBuildCost = 0.0f; // ...right after the last Build()
+		UINT mDepth = 0;
+	};
+}
@@ -8,8 +8,8 @@
 #include "ER_MaterialsCallbacks.h"
 #include "ER_Illumination.h"
 
-static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: BasicColorMaterial";
-static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: BasicColorMaterial w/ Instancing";
+static const ER_RHI_PSOHandle psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: BasicColorMaterial";
+static const ER_RHI_PSOHandle psoNameInstanced = "ER_RHI_GPUPipelineStateObject: BasicColorMaterial w/ Instancing";
 
 namespace EveryRay_Core
 {
@@ -56,7 +56,7 @@ namespace EveryRay_Core
 		rhi->SetRootSignature(rs);
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		const std::string& psoName = psoNameNonInstanced; //TODO add instancing support
+		const ER_RHI_PSOHandle& psoName = psoNameNonInstanced; //TODO add instancing support
 		if (!rhi->IsPSOReady(psoName))
 		{
 			rhi->InitializePSO(psoName);
@@ -1,11 +1,39 @@
 #include "ER_CPUProfiler.h"
 #include "ER_Utility.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
 
 namespace EveryRay_Core {
-	
-	ER_CPUProfiler::ER_CPUProfiler()
+
+	// Zones are shared by all profilers (names are registered once per call site by ER_CPU_PROFILE_SCOPE)
+	struct ER_CPUProfilerZonesRegistry
 	{
+		std::deque<std::string> Names; // deque: references stay valid when new zones are added
+		std::unordered_map<std::string, UINT> Indices;
+		std::mutex Mutex;
+	};
 
+	static ER_CPUProfilerZonesRegistry& GetZonesRegistry()
+	{
+		static ER_CPUProfilerZonesRegistry registry;
+		return registry;
+	}
+
+	struct ER_CPUProfilerThreadCache
+	{
+		UINT64 ProfilerId = 0;
+		ER_CPUProfilerThread* Thread = nullptr;
+	};
+	static thread_local ER_CPUProfilerThreadCache threadCache;
+	static std::atomic<UINT64> profilersCounter{ 0 };
+
+	ER_CPUProfiler::ER_CPUProfiler()
+		: mStartTime(std::chrono::high_resolution_clock::now()),
+		mProfilerId(++profilersCounter)
+	{
+		mFrames.resize(ER_CPU_PROFILER_FRAMES_COUNT);
+		SetThreadName("Main thread"); // created on the main thread by ER_Core
 	}
 
 	ER_CPUProfiler::~ER_CPUProfiler()
@@ -21,6 +49,8 @@ namespace EveryRay_Core {
 			mEventsCPUTime.emplace(aEventName, startTimer);
 		else
 			it->second = startTimer;
+
+		BeginZone(RegisterZone(aEventName));
 	}
 
 	void ER_CPUProfiler::EndCPUTime(const std::string& aEventName)
@@ -31,10 +61,291 @@ namespace EveryRay_Core {
 			return;
 		else
 		{
+			EndZone(RegisterZone(aEventName));
+
 			std::chrono::duration<double> finalTime = endTimer - it->second;
 			std::string message = "[ER Logger][ER_CPUProfiler] CPU time of <" + aEventName + "> is " + std::to_string(finalTime.count()) + "s\n";
 			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
 		}
 	}
 
-}
\ No newline at end of file
+	UINT ER_CPUProfiler::RegisterZone(const std::string& aName)
+	{
+		ER_CPUProfilerZonesRegistry& registry = GetZonesRegistry();
+		const std::lock_guard<std::mutex> lock(registry.Mutex);
+
+		auto it = registry.Indices.find(aName);
+		if (it != registry.Indices.end())
+			return it->second;
+
+		UINT index = static_cast<UINT>(registry.Names.size());
+		registry.Names.push_back(aName);
+		registry.Indices.emplace(aName, index);
+		return index;
+	}
+
+	const std::string& ER_CPUProfiler::GetZoneName(UINT aZone)
+	{
+		ER_CPUProfilerZonesRegistry& registry = GetZonesRegistry();
+		const std::lock_guard<std::mutex> lock(registry.Mutex);
+		assert(aZone < registry.Names.size());
+		return registry.Names[aZone];
+	}
+
+	UINT ER_CPUProfiler::GetZonesCount()
+	{
+		ER_CPUProfilerZonesRegistry& registry = GetZonesRegistry();
+		const std::lock_guard<std::mutex> lock(registry.Mutex);
+		return static_cast<UINT>(registry.Names.size());
+	}
+
+	INT64 ER_CPUProfiler::GetTime() const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - mStartTime).count();
+	}
+
+	ER_CPUProfilerThread* ER_CPUProfiler::GetThread()
+	{
+		if (threadCache.ProfilerId == mProfilerId)
+			return threadCache.Thread;
+
+		// first event of this thread
+		const std::lock_guard<std::mutex> lock(mThreadsMutex);
+		mThreads.emplace_back(new ER_CPUProfilerThread());
+		ER_CPUProfilerThread* thread = mThreads.back().get();
+		thread->Index = static_cast<UINT>(mThreads.size() - 1);
+		thread->Name = "Thread " + std::to_string(thread->Index);
+
+		threadCache.ProfilerId = mProfilerId;
+		threadCache.Thread = thread;
+		return thread;
+	}
+
+	void ER_CPUProfiler::SetThreadName(const std::string& aName)
+	{
+		ER_CPUProfilerThread* thread = GetThread();
+		const std::lock_guard<std::mutex> lock(mThreadsMutex);
+		thread->Name = aName;
+	}
+
+	void ER_CPUProfiler::BeginZone(UINT aZone)
+	{
+		if (!IsEnabled())
+			return;
+
+		// only the owning thread touches its open zones
+		GetThread()->OpenZones.emplace_back(aZone, GetTime());
+	}
+
+	void ER_CPUProfiler::EndZone(UINT aZone)
+	{
+		ER_CPUProfilerThread* thread = GetThread();
+		if (thread->OpenZones.empty())
+			return; // profiler was enabled in the middle of the zone
+
+		const INT64 endTime = GetTime();
+
+		// zones are normally closed in LIFO order, but BeginCPUTime()/EndCPUTime() pairs do not have to be
+		auto it = std::find_if(thread->OpenZones.rbegin(), thread->OpenZones.rend(), [aZone](const std::pair<UINT, INT64>& zone) { return zone.first == aZone; });
+		if (it == thread->OpenZones.rend())
+			return;
+
+		ER_CPUProfilerEvent event;
+		event.Zone = aZone;
+		event.Thread = thread->Index;
+		event.Depth = static_cast<UINT>(std::distance(it, thread->OpenZones.rend()) - 1);
+		event.Start = it->second;
+		event.End = endTime;
+		thread->OpenZones.erase(std::next(it).base());
+		// remaining open calls of the same zone started earlier and end later (open zones are only a few levels deep)
+		event.IsNestedInSameZone = std::any_of(thread->OpenZones.begin(), thread->OpenZones.end(), [aZone](const std::pair<UINT, INT64>& zone) { return zone.first == aZone; });
+
+		const std::lock_guard<std::mutex> lock(thread->Mutex);
+		thread->Events.push_back(event);
+	}
+
+	void ER_CPUProfiler::BeginFrame()
+	{
+		const INT64 time = GetTime();
+		const std::lock_guard<std::mutex> framesLock(mFramesMutex);
+
+		if (mIsFrameStarted)
+		{
+			ER_CPUProfilerFrame& frame = mFrames[mCurrentFrame];
+			frame.Start = mCurrentFrameStart;
+			frame.End = time;
+			frame.Events.clear();
+			{
+				const std::lock_guard<std::mutex> threadsLock(mThreadsMutex);
+				for (auto& thread : mThreads)
+				{
+					const std::lock_guard<std::mutex> lock(thread->Mutex);
+					frame.Events.insert(frame.Events.end(), thread->Events.begin(), thread->Events.end());
+					thread->Events.clear();
+				}
+			}
+
+			// per-frame time of every zone (all calls summed, nested calls of the same zone are not counted twice)
+			const UINT zonesCount = GetZonesCount();
+			if (mZonesFrameTimes.size() < zonesCount)
+				mZonesFrameTimes.resize(zonesCount, std::vector<float>(ER_CPU_PROFILER_FRAMES_COUNT, -1.0f));
+			for (auto& zoneTimes : mZonesFrameTimes)
+				zoneTimes[mCurrentFrame] = -1.0f;
+			for (auto& event : frame.Events)
+			{
+				if (event.IsNestedInSameZone)
+					continue;
+
+				float& zoneTime = mZonesFrameTimes[event.Zone][mCurrentFrame];
+				zoneTime = std::max(zoneTime, 0.0f) + static_cast<float>(event.End - event.Start) / 1000.0f;
+			}
+
+			mCurrentFrame = (mCurrentFrame + 1) % ER_CPU_PROFILER_FRAMES_COUNT;
+			mFramesCount = std::min(mFramesCount + 1, static_cast<UINT>(ER_CPU_PROFILER_FRAMES_COUNT));
+		}
+
+		mCurrentFrameStart = time;
+		mIsFrameStarted = true;
+	}
+
+	bool ER_CPUProfiler::GetZoneStats(UINT aZone, ER_CPUProfilerZoneStats& aOutStats)
+	{
+		const std::lock_guard<std::mutex> lock(mFramesMutex);
+		if (aZone >= mZonesFrameTimes.size() || mFramesCount == 0)
+			return false;
+
+		std::vector<float> times;
+		times.reserve(mFramesCount);
+		for (UINT i = 0; i < mFramesCount; i++)
+		{
+			float time = mZonesFrameTimes[aZone][(mCurrentFrame + ER_CPU_PROFILER_FRAMES_COUNT - mFramesCount + i) % ER_CPU_PROFILER_FRAMES_COUNT];
+			if (time >= 0.0f)
+				times.push_back(time);
+		}
+		if (times.empty())
+			return false;
+
+		aOutStats = ER_CPUProfilerZoneStats();
+		aOutStats.LastMs = times.back();
+		aOutStats.FramesCount = static_cast<UINT>(times.size());
+
+		std::sort(times.begin(), times.end());
+		aOutStats.MinMs = times.front();
+		aOutStats.MaxMs = times.back();
+		float sum = 0.0f;
+		for (float time : times)
+			sum += time;
+		aOutStats.AvgMs = sum / times.size();
+		aOutStats.PercentileMs = times[std::min(static_cast<size_t>(ER_CPU_PROFILER_PERCENTILE * times.size()), times.size() - 1)];
+		return true;
+	}
+
+	void ER_CPUProfiler::GetFrameTimes(std::vector<float>& aOutFrameTimesMs)
+	{
+		const std::lock_guard<std::mutex> lock(mFramesMutex);
+		aOutFrameTimesMs.resize(mFramesCount);
+		for (UINT i = 0; i < mFramesCount; i++)
+		{
+			const ER_CPUProfilerFrame& frame = mFrames[(mCurrentFrame + ER_CPU_PROFILER_FRAMES_COUNT - mFramesCount + i) % ER_CPU_PROFILER_FRAMES_COUNT];
+			aOutFrameTimesMs[i] = static_cast<float>(frame.End - frame.Start) / 1000.0f;
+		}
+	}
+
+	static std::string EscapeJsonString(const std::string& aString)
+	{
+		std::string result;
+		result.reserve(aString.size());
+		for (char c : aString)
+		{
+			if (c == '"' || c == '\\')
+				result.push_back('\\');
+			if (static_cast<unsigned char>(c) < 0x20)
+				continue;
+			result.push_back(c);
+		}
+		return result;
+	}
+
+	// Chrome trace event format: "X" (complete) events for zones, "M" (metadata) events for thread names
+	bool ER_CPUProfiler::ExportChromeTrace(const std::string& aPath)
+	{
+		std::stringstream trace;
+		trace << "{\"traceEvents\":[\n";
+		bool isFirst = true;
+		auto separator = [&isFirst]() { const char* s = isFirst ? "" : ",\n"; isFirst = false; return s; };
+
+		{
+			const std::lock_guard<std::mutex> lock(mThreadsMutex);
+			for (auto& thread : mThreads)
+				trace << separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->Index <<
+					",\"args\":{\"name\":\"" << EscapeJsonString(thread->Name) << "\"}}";
+		}
+
+		{
+			const std::lock_guard<std::mutex> lock(mFramesMutex);
+			for (UINT i = 0; i < mFramesCount; i++)
+			{
+				const ER_CPUProfilerFrame& frame = mFrames[(mCurrentFrame + ER_CPU_PROFILER_FRAMES_COUNT - mFramesCount + i) % ER_CPU_PROFILER_FRAMES_COUNT];
+				trace << separator() << "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << frame.Start << ",\"dur\":" << frame.End - frame.Start << "}";
+				for (auto& event : frame.Events)
+					trace << separator() << "{\"name\":\"" << EscapeJsonString(GetZoneName(event.Zone)) << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.Thread <<
+						",\"ts\":" << event.Start << ",\"dur\":" << event.End - event.Start << "}";
+			}
+		}
+		trace << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		const std::string data = trace.str();
+		return ER_Utility::SaveBinaryFile(aPath, data.data(), data.size());
+	}
+
+	void ER_CPUProfiler::ShowImGui()
+	{
+		bool isEnabled = IsEnabled();
+		if (ImGui::Checkbox("Record CPU zones", &isEnabled))
+			SetEnabled(isEnabled);
+
+		std::vector<float> frameTimes;
+		GetFrameTimes(frameTimes);
+		if (!frameTimes.empty())
+		{
+			float maxFrameTime = *std::max_element(frameTimes.begin(), frameTimes.end());
+			ImGui::PlotLines("Frame (ms)", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, nullptr, 0.0f, maxFrameTime, ImVec2(0, 60));
+		}
+
+		static char tracePath[MAX_PATH] = "cpu_trace.json";
+		ImGui::InputText("Trace file", tracePath, MAX_PATH);
+		if (ImGui::Button("Export Chrome trace"))
+		{
+			const std::string path = ER_Utility::GetFilePath(std::string(tracePath));
+			std::string message = ExportChromeTrace(path) ?
+				"[ER Logger][ER_CPUProfiler] Exported CPU trace to: " + path + '\n' : "[ER Logger][ER_CPUProfiler] Could not export CPU trace to: " + path + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+
+		ImGui::Columns(6, "ER_CPUProfilerZones");
+		ImGui::Text("Zone"); ImGui::NextColumn();
+		ImGui::Text("Last"); ImGui::NextColumn();
+		ImGui::Text("Min"); ImGui::NextColumn();
+		ImGui::Text("Avg"); ImGui::NextColumn();
+		ImGui::Text("Max"); ImGui::NextColumn();
+		ImGui::Text("P%d", static_cast<int>(ER_CPU_PROFILER_PERCENTILE * 100)); ImGui::NextColumn();
+		ImGui::Separator();
+
+		const UINT zonesCount = GetZonesCount();
+		for (UINT zone = 0; zone < zonesCount; zone++)
+		{
+			ER_CPUProfilerZoneStats stats;
+			if (!GetZoneStats(zone, stats))
+				continue;
+
+			ImGui::Text("%s", GetZoneName(zone).c_str()); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.LastMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.MinMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.AvgMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.MaxMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.PercentileMs); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+	}
+
+}
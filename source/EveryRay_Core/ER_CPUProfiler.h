@@ -1,11 +1,59 @@
 #pragma once
 #include "Common.h"
+#include <atomic>
 #include <chrono>
 
+#define ER_CPU_PROFILER_FRAMES_COUNT 256 // size of the frames ring buffer (statistics and trace export)
+#define ER_CPU_PROFILER_PERCENTILE 0.95f
+
+#define ER_CPU_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ER_CPU_PROFILE_CONCAT(a, b) ER_CPU_PROFILE_CONCAT_IMPL(a, b)
+
+// Scoped zone: name is registered only once per call site, so the zone itself is just two timer reads and a push into a thread-local buffer.
+// Usage: ER_CPU_PROFILE_SCOPE(core.CPUProfiler(), "Shadow mapper update");
+#define ER_CPU_PROFILE_SCOPE(profiler, name) \
+	static const UINT ER_CPU_PROFILE_CONCAT(erProfileZone, __LINE__) = EveryRay_Core::ER_CPUProfiler::RegisterZone(name); \
+	EveryRay_Core::ER_CPUProfilerScope ER_CPU_PROFILE_CONCAT(erProfileScope, __LINE__)(profiler, ER_CPU_PROFILE_CONCAT(erProfileZone, __LINE__))
+
 namespace EveryRay_Core
 {
 	typedef std::chrono::high_resolution_clock::time_point TimePoint;
 
+	struct ER_CPUProfilerEvent
+	{
+		UINT Zone;
+		UINT Thread;
+		UINT Depth; // nesting level on its thread
+		bool IsNestedInSameZone; // another call of the same zone was open around it on its thread (so its time is already counted)
+		INT64 Start; // in microseconds since the profiler was created
+		INT64 End;
+	};
+
+	struct ER_CPUProfilerZoneStats
+	{
+		float LastMs = 0.0f;
+		float MinMs = 0.0f;
+		float AvgMs = 0.0f;
+		float MaxMs = 0.0f;
+		float PercentileMs = 0.0f; // ER_CPU_PROFILER_PERCENTILE
+		UINT FramesCount = 0; // frames (in the ring buffer) in which the zone was executed
+	};
+
+	struct ER_CPUProfilerThread
+	{
+		std::string Name;
+		UINT Index = 0;
+		std::vector<std::pair<UINT, INT64>> OpenZones; // zone and its start time
+		std::vector<ER_CPUProfilerEvent> Events; // finished events of the current frame
+		std::mutex Mutex; // only contended when the frame is collected
+	};
+
+	// Hierarchical, thread-aware CPU profiler.
+	// - zones are nested scopes (ER_CPU_PROFILE_SCOPE) that can be recorded from any thread (i.e., ER_JobSystem workers) into per-thread buffers
+	// - at the beginning of every frame events of all threads are collected into a ring buffer of the last ER_CPU_PROFILER_FRAMES_COUNT frames
+	// - rolling min/avg/max/percentile statistics per zone (time of the zone per frame, summed over all its calls) are computed from that buffer
+	// - frames of the ring buffer can be exported to the Chrome trace JSON format (chrome://tracing, https://ui.perfetto.dev)
+	// Old BeginCPUTime()/EndCPUTime() are still here for one-time events (i.e., loading) that we want to see in the log.
 	class ER_CPUProfiler
 	{
 	public:
@@ -15,7 +63,65 @@ namespace EveryRay_Core
 		void BeginCPUTime(const std::string& aEventName, bool toLog = true);
 		void EndCPUTime(const std::string& aEventName);
 
+		// Closes the previous frame (collects all threads' events) and starts a new one. Call once per frame from the main thread.
+		void BeginFrame();
+
+		void BeginZone(UINT aZone);
+		void EndZone(UINT aZone);
+		static UINT RegisterZone(const std::string& aName); // returns the same index for the same name
+		static const std::string& GetZoneName(UINT aZone);
+		static UINT GetZonesCount();
+
+		void SetThreadName(const std::string& aName); // for the calling thread
+
+		bool GetZoneStats(UINT aZone, ER_CPUProfilerZoneStats& aOutStats);
+		void GetFrameTimes(std::vector<float>& aOutFrameTimesMs); // oldest to newest
+		bool ExportChromeTrace(const std::string& aPath);
+
+		void ShowImGui();
+
+		bool IsEnabled() const { return mIsEnabled.load(std::memory_order_relaxed); }
+		void SetEnabled(bool value) { mIsEnabled.store(value, std::memory_order_relaxed); }
+	private:
+		struct ER_CPUProfilerFrame
+		{
+			INT64 Start = 0;
+			INT64 End = 0;
+			std::vector<ER_CPUProfilerEvent> Events;
+		};
+
+		INT64 GetTime() const;
+		ER_CPUProfilerThread* GetThread();
+
+		std::map<std::string, TimePoint> mEventsCPUTime; // BeginCPUTime()/EndCPUTime() events
+
+		TimePoint mStartTime;
+		UINT64 mProfilerId = 0; // to detect a stale thread-local cache if a profiler is recreated
+
+		std::vector<std::unique_ptr<ER_CPUProfilerThread>> mThreads;
+		std::mutex mThreadsMutex;
+
+		std::vector<ER_CPUProfilerFrame> mFrames; // ring buffer
+		std::vector<std::vector<float>> mZonesFrameTimes; // [zone][frame in ring buffer], negative if the zone was not executed in that frame
+		UINT mCurrentFrame = 0;
+		UINT mFramesCount = 0;
+		INT64 mCurrentFrameStart = 0;
+		bool mIsFrameStarted = false;
+		std::atomic<bool> mIsEnabled{ true }; // read by all threads that record zones
+
+		std::mutex mFramesMutex;
+	};
+
+	class ER_CPUProfilerScope
+	{
+	public:
+		ER_CPUProfilerScope(ER_CPUProfiler* aProfiler, UINT aZone) : mProfiler(aProfiler), mZone(aZone) { if (mProfiler) mProfiler->BeginZone(mZone); }
+		~ER_CPUProfilerScope() { if (mProfiler) mProfiler->EndZone(mZone); }
 	private:
-		std::map<std::string, TimePoint> mEventsCPUTime;
+		ER_CPUProfilerScope(const ER_CPUProfilerScope&) = delete;
+		ER_CPUProfilerScope& operator=(const ER_CPUProfilerScope&) = delete;
+
+		ER_CPUProfiler* mProfiler;
+		UINT mZone;
 	};
-}
\ No newline at end of file
+}
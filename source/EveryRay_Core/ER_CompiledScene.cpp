@@ -0,0 +1,576 @@
+#include "stdafx.h"
+#include <fstream>
+
+#include "ER_CompiledScene.h"
+#include "ER_CoreException.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	// Builds the string table: every unique string is stored once (texture paths, shader entries, etc. repeat a lot in our levels)
+	class ER_CompiledSceneStringTable
+	{
+	public:
+		UINT32 Add(const std::string& aString)
+		{
+			auto it = mOffsets.find(aString);
+			if (it != mOffsets.end())
+				return it->second;
+
+			UINT32 offset = static_cast<UINT32>(mData.size());
+			mData.insert(mData.end(), aString.begin(), aString.end());
+			mData.push_back('\0');
+			mOffsets.emplace(aString, offset);
+			return offset;
+		}
+
+		// returns ER_COMPILED_SCENE_INVALID_STRING if the field is not in the json
+		UINT32 AddOptional(const Json::Value& aValue, const char* aField)
+		{
+			return aValue.isMember(aField) ? Add(aValue[aField].asString()) : ER_COMPILED_SCENE_INVALID_STRING;
+		}
+
+		const std::vector<char>& GetData() const { return mData; }
+	private:
+		std::unordered_map<std::string, UINT32> mOffsets;
+		std::vector<char> mData;
+	};
+
+	static XMFLOAT3 ReadJsonVec3(const Json::Value& aValue)
+	{
+		float vec3[3] = { 0.0f, 0.0f, 0.0f };
+		for (Json::Value::ArrayIndex i = 0; i != aValue.size() && i < 3; i++)
+			vec3[i] = aValue[i].asFloat();
+
+		return XMFLOAT3(vec3[0], vec3[1], vec3[2]);
+	}
+
+	// json matrices are stored transposed, we store them ready to be used with XMLoadFloat4x4()
+	static XMFLOAT4X4 ReadJsonMatrix(const Json::Value& aValue)
+	{
+		float matrix[16] = {};
+		for (Json::Value::ArrayIndex i = 0; i != aValue.size() && i < 16; i++)
+			matrix[i] = aValue[i].asFloat();
+
+		XMFLOAT4X4 result(matrix);
+		XMStoreFloat4x4(&result, XMMatrixTranspose(XMLoadFloat4x4(&result)));
+		return result;
+	}
+
+	static UINT32 AlignSectionOffset(size_t aOffset)
+	{
+		return ER_BitmaskAlign(static_cast<unsigned int>(aOffset), ER_COMPILED_SCENE_SECTION_ALIGNMENT);
+	}
+
+	ER_CompiledScene::ER_CompiledScene()
+	{
+	}
+
+	ER_CompiledScene::~ER_CompiledScene()
+	{
+		Unload();
+	}
+
+	void ER_CompiledScene::Unload()
+	{
+		mMappedFile.Close();
+		mCompiledData.clear();
+		mCompiledData.shrink_to_fit();
+		mData = nullptr;
+		mDataSize = 0;
+	}
+
+	static void ReadSceneFile(const std::string& aScenePath, std::string& outJson)
+	{
+		std::ifstream file(aScenePath.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.good())
+		{
+			std::string message = "ER_CompiledScene: Failed to open scene file: " + aScenePath;
+			throw ER_CoreException(message.c_str());
+		}
+
+		outJson.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		if (!outJson.empty())
+			file.read(&outJson[0], outJson.size());
+	}
+
+	bool ER_CompiledScene::Load(const std::string& aScenePath)
+	{
+		// we still read the json file to check if the binary is stale, but reading (and hashing) it is cheap compared to parsing it
+		std::string json;
+		ReadSceneFile(aScenePath, json);
+
+		UINT64 sourceHash = ER_Utility::HashData(json.data(), json.size());
+		UINT64 sourceSize = static_cast<UINT64>(json.size());
+
+		const std::string compiledPath = GetCompiledPath(aScenePath);
+		if (LoadFromFile(compiledPath, sourceHash, sourceSize))
+		{
+			std::string message = "[ER Logger][ER_CompiledScene] Loaded compiled scene: " + compiledPath + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+			return false;
+		}
+
+		Json::Reader reader;
+		Json::Value root;
+		if (!reader.parse(json.data(), json.data() + json.size(), root))
+			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
+
+		Compile(root, sourceHash, sourceSize);
+		SaveCompiledScene(compiledPath);
+		return true;
+	}
+
+	void ER_CompiledScene::Recompile(const std::string& aScenePath, const Json::Value& aRoot)
+	{
+		std::string json;
+		ReadSceneFile(aScenePath, json);
+
+		Compile(aRoot, ER_Utility::HashData(json.data(), json.size()), static_cast<UINT64>(json.size()));
+		SaveCompiledScene(GetCompiledPath(aScenePath));
+	}
+
+	void ER_CompiledScene::SaveCompiledScene(const std::string& aCompiledPath)
+	{
+		if (!SaveToFile(aCompiledPath))
+		{
+			std::string message = "[ER Logger][ER_CompiledScene] Failed to save compiled scene: " + aCompiledPath + ". Json will be parsed again on the next load. \n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+		else
+		{
+			std::string message = "[ER Logger][ER_CompiledScene] Compiled scene from json (binary was missing or stale): " + aCompiledPath + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+	}
+
+	bool ER_CompiledScene::LoadFromFile(const std::string& aPath, UINT64 aSourceHash, UINT64 aSourceSize)
+	{
+		Unload();
+
+		if (!mMappedFile.Open(aPath) || mMappedFile.GetSize() < sizeof(ER_CompiledSceneHeader))
+		{
+			Unload();
+			return false;
+		}
+		mData = mMappedFile.GetData();
+		mDataSize = mMappedFile.GetSize();
+
+		const ER_CompiledSceneHeader& header = GetHeader();
+		bool isValid = header.Magic == ER_COMPILED_SCENE_MAGIC && header.Version == ER_COMPILED_SCENE_VERSION &&
+			header.SourceHash == aSourceHash && header.SourceSize == aSourceSize && header.FileSize == mDataSize;
+
+		const UINT64 elementSizes[ER_COMPILED_SCENE_SECTION_COUNT] =
+		{
+			sizeof(ER_CompiledSceneObject), sizeof(ER_CompiledSceneMaterial), sizeof(ER_CompiledSceneMeshTextures),
+			sizeof(UINT32), sizeof(XMFLOAT4X4), sizeof(ER_CompiledSceneFoliageZone), sizeof(char)
+		};
+		for (int i = 0; i < ER_COMPILED_SCENE_SECTION_COUNT && isValid; i++)
+			isValid = static_cast<UINT64>(header.Sections[i].Offset) + header.Sections[i].Count * elementSizes[i] <= mDataSize;
+
+		// strings are read with plain "const char*", so the table must be terminated
+		const ER_CompiledSceneSection& strings = header.Sections[ER_COMPILED_SCENE_SECTION_STRINGS];
+		if (isValid && strings.Count > 0)
+			isValid = mData[strings.Offset + strings.Count - 1] == '\0';
+
+		if (!isValid)
+			Unload();
+
+		return isValid;
+	}
+
+	void ER_CompiledScene::Compile(const Json::Value& aRoot, UINT64 aSourceHash, UINT64 aSourceSize)
+	{
+		Unload();
+
+		ER_CompiledSceneHeader header;
+		ZeroMemory(&header, sizeof(header));
+		header.Magic = ER_COMPILED_SCENE_MAGIC;
+		header.Version = ER_COMPILED_SCENE_VERSION;
+		header.SourceHash = aSourceHash;
+		header.SourceSize = aSourceSize;
+
+		ER_CompiledSceneStringTable strings;
+		std::vector<ER_CompiledSceneObject> objects;
+		std::vector<ER_CompiledSceneMaterial> materials;
+		std::vector<ER_CompiledSceneMeshTextures> meshTextures;
+		std::vector<UINT32> lodPaths;
+		std::vector<XMFLOAT4X4> instances;
+		std::vector<ER_CompiledSceneFoliageZone> foliageZones;
+
+		// scene settings
+		{
+			ER_CompiledSceneSettings& settings = header.Settings;
+			auto setPresent = [&settings](ER_COMPILED_SCENE_SETTING aSetting) { settings.PresentMask |= (1u << aSetting); };
+
+			if (aRoot.isMember("camera_position")) {
+				settings.CameraPosition = ReadJsonVec3(aRoot["camera_position"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_CAMERA_POSITION);
+			}
+			if (aRoot.isMember("camera_direction")) {
+				settings.CameraDirection = ReadJsonVec3(aRoot["camera_direction"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_CAMERA_DIRECTION);
+			}
+			if (aRoot.isMember("sun_direction")) {
+				settings.SunDirection = ReadJsonVec3(aRoot["sun_direction"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_SUN_DIRECTION);
+			}
+			if (aRoot.isMember("sun_color")) {
+				settings.SunColor = ReadJsonVec3(aRoot["sun_color"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_SUN_COLOR);
+			}
+
+			for (int i = 0; i < 4; i++)
+				settings.TerrainSplatLayers[i] = ER_COMPILED_SCENE_INVALID_STRING;
+			if (aRoot.isMember("terrain_num_tiles")) {
+				setPresent(ER_COMPILED_SCENE_SETTING_TERRAIN);
+				settings.TerrainTilesCount = aRoot["terrain_num_tiles"].asInt();
+				if (aRoot.isMember("terrain_tile_scale")) {
+					settings.TerrainTileScale = aRoot["terrain_tile_scale"].asFloat();
+					setPresent(ER_COMPILED_SCENE_SETTING_TERRAIN_TILE_SCALE);
+				}
+				if (aRoot.isMember("terrain_tile_resolution")) {
+					settings.TerrainTileResolution = aRoot["terrain_tile_resolution"].asInt();
+					setPresent(ER_COMPILED_SCENE_SETTING_TERRAIN_TILE_RESOLUTION);
+				}
+				for (int i = 0; i < 4; i++)
+					settings.TerrainSplatLayers[i] = strings.AddOptional(aRoot, ("terrain_texture_splat_layer" + std::to_string(i)).c_str());
+			}
+
+			if (aRoot.isMember("light_probes_volume_bounds_min")) {
+				settings.LightProbesVolumeMinBounds = ReadJsonVec3(aRoot["light_probes_volume_bounds_min"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_MIN_BOUNDS);
+			}
+			if (aRoot.isMember("light_probes_volume_bounds_max")) {
+				settings.LightProbesVolumeMaxBounds = ReadJsonVec3(aRoot["light_probes_volume_bounds_max"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_MAX_BOUNDS);
+			}
+			if (aRoot.isMember("light_probes_diffuse_distance")) {
+				settings.LightProbesDiffuseDistance = aRoot["light_probes_diffuse_distance"].asFloat();
+				setPresent(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_DIFFUSE_DISTANCE);
+			}
+			if (aRoot.isMember("light_probes_specular_distance")) {
+				settings.LightProbesSpecularDistance = aRoot["light_probes_specular_distance"].asFloat();
+				setPresent(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_SPECULAR_DISTANCE);
+			}
+			if (aRoot.isMember("light_probe_global_cam_position")) {
+				settings.GlobalLightProbeCameraPos = ReadJsonVec3(aRoot["light_probe_global_cam_position"]);
+				setPresent(ER_COMPILED_SCENE_SETTING_GLOBAL_LIGHT_PROBE_CAMERA_POSITION);
+			}
+
+			if (aRoot.isMember("foliage_zones"))
+				setPresent(ER_COMPILED_SCENE_SETTING_FOLIAGE);
+
+			if (aRoot.isMember("use_volumetric_fog")) {
+				settings.UseVolumetricFog = aRoot["use_volumetric_fog"].asBool() ? 1 : 0;
+				setPresent(ER_COMPILED_SCENE_SETTING_VOLUMETRIC_FOG);
+			}
+		}
+
+		// rendering objects
+		const Json::Value& jsonObjects = aRoot["rendering_objects"];
+		objects.resize(jsonObjects.size());
+		for (Json::Value::ArrayIndex i = 0; i != jsonObjects.size(); i++)
+		{
+			const Json::Value& jsonObject = jsonObjects[i];
+			ER_CompiledSceneObject& object = objects[i];
+			ZeroMemory(&object, sizeof(object));
+
+			object.Name = strings.Add(jsonObject["name"].asString());
+			object.ModelPath = strings.Add(jsonObject["model_path"].asString());
+
+			auto readBool = [&](ER_COMPILED_SCENE_OBJECT_BOOL aIndex, const char* aField) {
+				if (jsonObject.isMember(aField)) {
+					object.BoolsPresentMask |= (1u << aIndex);
+					if (jsonObject[aField].asBool())
+						object.BoolsValueMask |= (1u << aIndex);
+				}
+			};
+			auto readFloat = [&](ER_COMPILED_SCENE_OBJECT_FLOAT aIndex, const char* aField) {
+				if (jsonObject.isMember(aField)) {
+					object.FloatsPresentMask |= (1u << aIndex);
+					object.Floats[aIndex] = jsonObject[aField].asFloat();
+				}
+			};
+			auto readFloatPair = [&](ER_COMPILED_SCENE_OBJECT_FLOAT aMinIndex, const char* aMinField, ER_COMPILED_SCENE_OBJECT_FLOAT aMaxIndex, const char* aMaxField) {
+				// min/max are only used together
+				if (jsonObject.isMember(aMinField) && jsonObject.isMember(aMaxField)) {
+					readFloat(aMinIndex, aMinField);
+					readFloat(aMaxIndex, aMaxField);
+				}
+			};
+			auto readInt = [&](ER_COMPILED_SCENE_OBJECT_INT aIndex, const char* aField) {
+				if (jsonObject.isMember(aField)) {
+					object.IntsPresentMask |= (1u << aIndex);
+					object.Ints[aIndex] = jsonObject[aField].asInt();
+				}
+			};
+			auto readVec3 = [&](ER_COMPILED_SCENE_OBJECT_VEC3 aIndex, const char* aField) {
+				if (jsonObject.isMember(aField)) {
+					object.Vec3sPresentMask |= (1u << aIndex);
+					object.Vec3s[aIndex] = ReadJsonVec3(jsonObject[aField]);
+				}
+			};
+
+			// flags
+			object.BoolsPresentMask |= (1u << ER_COMPILED_SCENE_OBJECT_BOOL_INSTANCED);
+			if (jsonObject["instanced"].asBool())
+				object.BoolsValueMask |= (1u << ER_COMPILED_SCENE_OBJECT_BOOL_INSTANCED);
+			const bool isInstanced = jsonObject["instanced"].asBool();
+
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_FOLIAGE_MASK, "foliageMask");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_INDIRECT_GLOBAL_LIGHTPROBE, "use_indirect_global_lightprobe");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_IN_GLOBAL_LIGHTPROBE_RENDERING, "use_in_global_lightprobe_rendering");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_PARALLAX_OCCLUSION_MAPPING, "use_parallax_occlusion_mapping");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_FORWARD_SHADING, "use_forward_shading");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_REFLECTION, "use_reflection");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_SSS, "use_sss");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ALPHA_DISCARD, "use_custom_alpha_discard");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_TRANSPARENCY, "use_transparency");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_GPU_INDIRECT_RENDERING, "use_gpu_indirect_rendering");
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_SKIP_INDIRECT_SPECULAR, "skip_indirect_specular");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_INDEX_OF_REFRACTION, "index_of_refraction");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ROUGHNESS, "custom_roughness");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_METALNESS, "custom_metalness");
+
+			//fur
+			readInt(ER_COMPILED_SCENE_OBJECT_INT_FUR_LAYERS_COUNT, "fur_layers_count");
+			readVec3(ER_COMPILED_SCENE_OBJECT_VEC3_FUR_COLOR, "fur_color");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_COLOR_INTERPOLATION, "fur_color_interpolation");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_LENGTH, "fur_length");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF, "fur_cutoff");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF_END, "fur_cutoff_end");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_WIND_FREQUENCY, "fur_wind_frequency");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_GRAVITY_STRENGTH, "fur_gravity_strength");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_UV_SCALE, "fur_uv_scale");
+
+			//terrain (procedural fields are only used with "terrain_placement")
+			readBool(ER_COMPILED_SCENE_OBJECT_BOOL_TERRAIN_PLACEMENT, "terrain_placement");
+			if (object.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_TERRAIN_PLACEMENT))
+			{
+				readInt(ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_SPLAT_CHANNEL, "terrain_splat_channel");
+				readFloatPair(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MIN, "terrain_procedural_instance_scale_min", ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MAX, "terrain_procedural_instance_scale_max");
+				readFloatPair(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MIN, "terrain_procedural_instance_pitch_min", ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MAX, "terrain_procedural_instance_pitch_max");
+				readFloatPair(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MIN, "terrain_procedural_instance_roll_min", ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MAX, "terrain_procedural_instance_roll_max");
+				readFloatPair(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MIN, "terrain_procedural_instance_yaw_min", ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MAX, "terrain_procedural_instance_yaw_max");
+				if (isInstanced)
+					readInt(ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_INSTANCE_COUNT, "terrain_procedural_instance_count");
+				readVec3(ER_COMPILED_SCENE_OBJECT_VEC3_TERRAIN_ZONE_CENTER_POS, "terrain_procedural_zone_center_pos");
+				if (isInstanced)
+					readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ZONE_RADIUS, "terrain_procedural_zone_radius");
+			}
+
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_MIN_SCALE, "min_scale");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_MAX_SCALE, "max_scale");
+			readFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_LOD_BIAS, "lod_bias");
+
+			// materials
+			object.FirstMaterial = static_cast<UINT32>(materials.size());
+			if (jsonObject.isMember("new_materials"))
+			{
+				const Json::Value& jsonMaterials = jsonObject["new_materials"];
+				for (Json::Value::ArrayIndex matIndex = 0; matIndex != jsonMaterials.size(); matIndex++)
+				{
+					ER_CompiledSceneMaterial material;
+					material.Name = strings.Add(jsonMaterials[matIndex]["name"].asString());
+					material.VertexEntry = strings.AddOptional(jsonMaterials[matIndex], "vertexEntry");
+					material.GeometryEntry = strings.AddOptional(jsonMaterials[matIndex], "geometryEntry");
+					material.HullEntry = strings.AddOptional(jsonMaterials[matIndex], "hullEntry");
+					material.DomainEntry = strings.AddOptional(jsonMaterials[matIndex], "domainEntry");
+					material.PixelEntry = strings.AddOptional(jsonMaterials[matIndex], "pixelEntry");
+					materials.push_back(material);
+				}
+			}
+			object.MaterialsCount = static_cast<UINT32>(materials.size()) - object.FirstMaterial;
+
+			// extra materials data
+			object.SnowAlbedo = strings.AddOptional(jsonObject, "snow_albedo");
+			object.SnowNormal = strings.AddOptional(jsonObject, "snow_normal");
+			object.SnowRoughness = strings.AddOptional(jsonObject, "snow_roughness");
+			object.FurHeight = strings.AddOptional(jsonObject, "fur_height");
+			readVec3(ER_COMPILED_SCENE_OBJECT_VEC3_FRESNEL_OUTLINE_COLOR, "fresnel_outline_color");
+
+			// custom textures (per mesh)
+			object.FirstMeshTextures = static_cast<UINT32>(meshTextures.size());
+			if (jsonObject.isMember("textures"))
+			{
+				const Json::Value& jsonTextures = jsonObject["textures"];
+				for (Json::Value::ArrayIndex meshIndex = 0; meshIndex != jsonTextures.size(); meshIndex++)
+				{
+					ER_CompiledSceneMeshTextures textures;
+					textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_ALBEDO] = strings.AddOptional(jsonTextures[meshIndex], "albedo");
+					textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_NORMAL] = strings.AddOptional(jsonTextures[meshIndex], "normal");
+					textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_ROUGHNESS] = strings.AddOptional(jsonTextures[meshIndex], "roughness");
+					textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_METALNESS] = strings.AddOptional(jsonTextures[meshIndex], "metalness");
+					textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_HEIGHT] = strings.AddOptional(jsonTextures[meshIndex], "height");
+					textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_REFLECTION_MASK] = strings.AddOptional(jsonTextures[meshIndex], "reflection_mask");
+					meshTextures.push_back(textures);
+				}
+			}
+			object.MeshTexturesCount = static_cast<UINT32>(meshTextures.size()) - object.FirstMeshTextures;
+
+			// world transform
+			if (jsonObject.isMember("transform") && jsonObject["transform"].size() == 16)
+				object.Transform = ReadJsonMatrix(jsonObject["transform"]);
+			else
+				XMStoreFloat4x4(&object.Transform, XMMatrixIdentity());
+
+			// lods (0 is the main model)
+			object.FirstLODPath = static_cast<UINT32>(lodPaths.size());
+			if (jsonObject.isMember("model_lods"))
+			{
+				const Json::Value& jsonLODs = jsonObject["model_lods"];
+				object.LODsCount = jsonLODs.size();
+				for (Json::Value::ArrayIndex lod = 1; lod < jsonLODs.size(); lod++)
+					lodPaths.push_back(strings.Add(jsonLODs[lod]["path"].asString()));
+			}
+
+			// instances (same transforms are used for all lods)
+			object.FirstInstance = static_cast<UINT32>(instances.size());
+			if (isInstanced && jsonObject.isMember("instances_transforms"))
+			{
+				object.BoolsPresentMask |= (1u << ER_COMPILED_SCENE_OBJECT_BOOL_HAS_INSTANCES_TRANSFORMS);
+				object.BoolsValueMask |= (1u << ER_COMPILED_SCENE_OBJECT_BOOL_HAS_INSTANCES_TRANSFORMS);
+
+				const Json::Value& jsonInstances = jsonObject["instances_transforms"];
+				object.InstancesCount = jsonInstances.size();
+				instances.reserve(instances.size() + object.InstancesCount);
+				for (Json::Value::ArrayIndex instance = 0; instance != jsonInstances.size(); instance++)
+					instances.push_back(ReadJsonMatrix(jsonInstances[instance]["transform"]));
+			}
+		}
+
+		// foliage zones
+		if (aRoot.isMember("foliage_zones"))
+		{
+			const Json::Value& jsonZones = aRoot["foliage_zones"];
+			foliageZones.resize(jsonZones.size());
+			for (Json::Value::ArrayIndex i = 0; i != jsonZones.size(); i++)
+			{
+				ER_CompiledSceneFoliageZone& zone = foliageZones[i];
+				ZeroMemory(&zone, sizeof(zone));
+
+				zone.Position = ReadJsonVec3(jsonZones[i]["position"]);
+				zone.PatchCount = jsonZones[i]["patch_count"].asInt();
+				zone.TexturePath = strings.Add(jsonZones[i]["texture_path"].asString());
+				zone.AverageScale = jsonZones[i]["average_scale"].asFloat();
+				zone.DistributionRadius = jsonZones[i]["distribution_radius"].asFloat();
+				zone.Type = jsonZones[i]["type"].asInt();
+				if (jsonZones[i].isMember("placed_on_terrain"))
+					zone.PlacedOnTerrain = jsonZones[i]["placed_on_terrain"].asBool() ? 1 : 0;
+				if (jsonZones[i].isMember("placed_splat_channel"))
+					zone.PlacedSplatChannel = jsonZones[i]["placed_splat_channel"].asInt();
+				else
+					zone.PlacedSplatChannel = -1;
+				if (jsonZones[i].isMember("placed_height_delta"))
+					zone.PlacedHeightDelta = jsonZones[i]["placed_height_delta"].asFloat();
+			}
+		}
+
+		// layout: header, then every section aligned to ER_COMPILED_SCENE_SECTION_ALIGNMENT
+		UINT32 offset = AlignSectionOffset(sizeof(ER_CompiledSceneHeader));
+		auto placeSection = [&](ER_COMPILED_SCENE_SECTION aSection, size_t aCount, size_t aElementSize) {
+			header.Sections[aSection].Offset = offset;
+			header.Sections[aSection].Count = static_cast<UINT32>(aCount);
+			offset = AlignSectionOffset(offset + aCount * aElementSize);
+		};
+		placeSection(ER_COMPILED_SCENE_SECTION_OBJECTS, objects.size(), sizeof(ER_CompiledSceneObject));
+		placeSection(ER_COMPILED_SCENE_SECTION_MATERIALS, materials.size(), sizeof(ER_CompiledSceneMaterial));
+		placeSection(ER_COMPILED_SCENE_SECTION_MESH_TEXTURES, meshTextures.size(), sizeof(ER_CompiledSceneMeshTextures));
+		placeSection(ER_COMPILED_SCENE_SECTION_LOD_PATHS, lodPaths.size(), sizeof(UINT32));
+		placeSection(ER_COMPILED_SCENE_SECTION_INSTANCES, instances.size(), sizeof(XMFLOAT4X4));
+		placeSection(ER_COMPILED_SCENE_SECTION_FOLIAGE_ZONES, foliageZones.size(), sizeof(ER_CompiledSceneFoliageZone));
+		placeSection(ER_COMPILED_SCENE_SECTION_STRINGS, strings.GetData().size(), sizeof(char));
+		header.FileSize = offset;
+
+		mCompiledData.resize(offset, 0);
+		auto copySection = [&](ER_COMPILED_SCENE_SECTION aSection, const void* aSrc, size_t aSize) {
+			if (aSize > 0)
+				memcpy(mCompiledData.data() + header.Sections[aSection].Offset, aSrc, aSize);
+		};
+		memcpy(mCompiledData.data(), &header, sizeof(header));
+		copySection(ER_COMPILED_SCENE_SECTION_OBJECTS, objects.data(), objects.size() * sizeof(ER_CompiledSceneObject));
+		copySection(ER_COMPILED_SCENE_SECTION_MATERIALS, materials.data(), materials.size() * sizeof(ER_CompiledSceneMaterial));
+		copySection(ER_COMPILED_SCENE_SECTION_MESH_TEXTURES, meshTextures.data(), meshTextures.size() * sizeof(ER_CompiledSceneMeshTextures));
+		copySection(ER_COMPILED_SCENE_SECTION_LOD_PATHS, lodPaths.data(), lodPaths.size() * sizeof(UINT32));
+		copySection(ER_COMPILED_SCENE_SECTION_INSTANCES, instances.data(), instances.size() * sizeof(XMFLOAT4X4));
+		copySection(ER_COMPILED_SCENE_SECTION_FOLIAGE_ZONES, foliageZones.data(), foliageZones.size() * sizeof(ER_CompiledSceneFoliageZone));
+		copySection(ER_COMPILED_SCENE_SECTION_STRINGS, strings.GetData().data(), strings.GetData().size());
+
+		mData = mCompiledData.data();
+		mDataSize = offset;
+	}
+
+	bool ER_CompiledScene::SaveToFile(const std::string& aPath) const
+	{
+		if (!IsValid())
+			return false;
+
+		return ER_Utility::SaveBinaryFile(aPath, mData, static_cast<size_t>(mDataSize));
+	}
+
+	UINT64 ER_CompiledScene::GetContentHash() const
+	{
+		assert(IsValid());
+		return ER_Utility::HashData(mData + sizeof(ER_CompiledSceneHeader), static_cast<size_t>(mDataSize - sizeof(ER_CompiledSceneHeader)));
+	}
+
+	const char* ER_CompiledScene::GetString(UINT32 aOffset) const
+	{
+		if (!HasString(aOffset))
+			return "";
+
+		assert(aOffset < GetHeader().Sections[ER_COMPILED_SCENE_SECTION_STRINGS].Count);
+		return mData + GetHeader().Sections[ER_COMPILED_SCENE_SECTION_STRINGS].Offset + aOffset;
+	}
+
+	std::string ER_CompiledScene::GetCompiledPath(const std::string& aScenePath)
+	{
+		std::string::size_type extensionPos = aScenePath.rfind('.');
+		std::string::size_type slashPos = aScenePath.find_last_of("\\/");
+		if (extensionPos == std::string::npos || (slashPos != std::string::npos && extensionPos < slashPos))
+			return aScenePath + ER_COMPILED_SCENE_EXTENSION;
+		else
+			return aScenePath.substr(0, extensionPos) + ER_COMPILED_SCENE_EXTENSION;
+	}
+
+	bool ER_CompiledScene::CompileSceneFile(const std::string& aScenePath)
+	{
+		ER_CompiledScene compiledScene;
+		try
+		{
+			compiledScene.Load(aScenePath);
+		}
+		catch (ER_CoreException& ex)
+		{
+			std::string message = "[ER Logger][ER_CompiledScene] Failed to compile scene: " + aScenePath + ". Error: " + ex.what() + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+			return false;
+		}
+		return compiledScene.IsValid();
+	}
+
+	bool ER_CompiledScene::CompileScenesFromConfig(const std::string& aConfigPath)
+	{
+		Json::Reader reader;
+		std::ifstream globalConfig(aConfigPath.c_str(), std::ifstream::binary);
+
+		Json::Value root;
+		if (!reader.parse(globalConfig, root))
+		{
+			std::string message = "[ER Logger][ER_CompiledScene] Failed to parse scenes config: " + aConfigPath + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+			return false;
+		}
+
+		bool result = true;
+		for (Json::Value::ArrayIndex i = 0; i != root["scenes"].size(); i++)
+		{
+			// same path as the one ER_Sandbox loads the scene from
+			const std::string scenePath = ER_Utility::GetFilePath(root["scenes"][i]["scene_path"].asString()) + root["scenes"][i]["scene_name"].asString() + ".json";
+			result &= CompileSceneFile(scenePath);
+		}
+		return result;
+	}
+}
@@ -0,0 +1,288 @@
+#pragma once
+#include "Common.h"
+#include "ER_MappedFile.h"
+
+#include "..\JsonCpp\include\json\json.h"
+
+#define ER_COMPILED_SCENE_MAGIC 0x43535245 // "ERSC"
+#define ER_COMPILED_SCENE_VERSION 2
+#define ER_COMPILED_SCENE_EXTENSION ".erscene"
+#define ER_COMPILED_SCENE_INVALID_STRING 0xFFFFFFFF
+#define ER_COMPILED_SCENE_SECTION_ALIGNMENT 16
+
+namespace EveryRay_Core
+{
+	// All the structs below are stored in the file "as is" (POD, little endian, no pointers), so the file can be memory-mapped and used without any parsing.
+	// Strings are stored as byte offsets into the string table (null-terminated), ER_COMPILED_SCENE_INVALID_STRING means "not set in the json".
+	// Optional json fields are stored together with a "present" bitmask, so that the loader can keep the same "isMember()" logic as the json path.
+	// WARNING: if you change any of these structs, increase ER_COMPILED_SCENE_VERSION (old binaries will be recompiled from json).
+
+	enum ER_COMPILED_SCENE_SECTION
+	{
+		ER_COMPILED_SCENE_SECTION_OBJECTS = 0,
+		ER_COMPILED_SCENE_SECTION_MATERIALS,
+		ER_COMPILED_SCENE_SECTION_MESH_TEXTURES,
+		ER_COMPILED_SCENE_SECTION_LOD_PATHS,
+		ER_COMPILED_SCENE_SECTION_INSTANCES,
+		ER_COMPILED_SCENE_SECTION_FOLIAGE_ZONES,
+		ER_COMPILED_SCENE_SECTION_STRINGS,
+
+		ER_COMPILED_SCENE_SECTION_COUNT
+	};
+
+	enum ER_COMPILED_SCENE_SETTING
+	{
+		ER_COMPILED_SCENE_SETTING_CAMERA_POSITION = 0,
+		ER_COMPILED_SCENE_SETTING_CAMERA_DIRECTION,
+		ER_COMPILED_SCENE_SETTING_SUN_DIRECTION,
+		ER_COMPILED_SCENE_SETTING_SUN_COLOR,
+		ER_COMPILED_SCENE_SETTING_TERRAIN,
+		ER_COMPILED_SCENE_SETTING_TERRAIN_TILE_SCALE,
+		ER_COMPILED_SCENE_SETTING_TERRAIN_TILE_RESOLUTION,
+		ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_MIN_BOUNDS,
+		ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_MAX_BOUNDS,
+		ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_DIFFUSE_DISTANCE,
+		ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_SPECULAR_DISTANCE,
+		ER_COMPILED_SCENE_SETTING_GLOBAL_LIGHT_PROBE_CAMERA_POSITION,
+		ER_COMPILED_SCENE_SETTING_FOLIAGE,
+		ER_COMPILED_SCENE_SETTING_VOLUMETRIC_FOG
+	};
+
+	enum ER_COMPILED_SCENE_OBJECT_BOOL
+	{
+		ER_COMPILED_SCENE_OBJECT_BOOL_INSTANCED = 0,
+		ER_COMPILED_SCENE_OBJECT_BOOL_FOLIAGE_MASK,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_INDIRECT_GLOBAL_LIGHTPROBE,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_IN_GLOBAL_LIGHTPROBE_RENDERING,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_PARALLAX_OCCLUSION_MAPPING,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_FORWARD_SHADING,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_REFLECTION,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_SSS,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_TRANSPARENCY,
+		ER_COMPILED_SCENE_OBJECT_BOOL_USE_GPU_INDIRECT_RENDERING,
+		ER_COMPILED_SCENE_OBJECT_BOOL_SKIP_INDIRECT_SPECULAR,
+		ER_COMPILED_SCENE_OBJECT_BOOL_TERRAIN_PLACEMENT,
+		ER_COMPILED_SCENE_OBJECT_BOOL_HAS_INSTANCES_TRANSFORMS,
+
+		ER_COMPILED_SCENE_OBJECT_BOOL_COUNT
+	};
+
+	enum ER_COMPILED_SCENE_OBJECT_FLOAT
+	{
+		ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ALPHA_DISCARD = 0,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_INDEX_OF_REFRACTION,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ROUGHNESS,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_METALNESS,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_COLOR_INTERPOLATION,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_LENGTH,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF_END,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_WIND_FREQUENCY,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_GRAVITY_STRENGTH,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_UV_SCALE,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MIN,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MAX,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MIN,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MAX,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MIN,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MAX,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MIN,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MAX,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ZONE_RADIUS,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_MIN_SCALE,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_MAX_SCALE,
+		ER_COMPILED_SCENE_OBJECT_FLOAT_LOD_BIAS,
+
+		ER_COMPILED_SCENE_OBJECT_FLOAT_COUNT
+	};
+
+	enum ER_COMPILED_SCENE_OBJECT_INT
+	{
+		ER_COMPILED_SCENE_OBJECT_INT_FUR_LAYERS_COUNT = 0,
+		ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_SPLAT_CHANNEL,
+		ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_INSTANCE_COUNT,
+
+		ER_COMPILED_SCENE_OBJECT_INT_COUNT
+	};
+
+	enum ER_COMPILED_SCENE_OBJECT_VEC3
+	{
+		ER_COMPILED_SCENE_OBJECT_VEC3_FUR_COLOR = 0,
+		ER_COMPILED_SCENE_OBJECT_VEC3_TERRAIN_ZONE_CENTER_POS,
+		ER_COMPILED_SCENE_OBJECT_VEC3_FRESNEL_OUTLINE_COLOR,
+
+		ER_COMPILED_SCENE_OBJECT_VEC3_COUNT
+	};
+
+	enum ER_COMPILED_SCENE_MESH_TEXTURE
+	{
+		ER_COMPILED_SCENE_MESH_TEXTURE_ALBEDO = 0,
+		ER_COMPILED_SCENE_MESH_TEXTURE_NORMAL,
+		ER_COMPILED_SCENE_MESH_TEXTURE_ROUGHNESS,
+		ER_COMPILED_SCENE_MESH_TEXTURE_METALNESS,
+		ER_COMPILED_SCENE_MESH_TEXTURE_HEIGHT,
+		ER_COMPILED_SCENE_MESH_TEXTURE_REFLECTION_MASK,
+
+		ER_COMPILED_SCENE_MESH_TEXTURE_COUNT
+	};
+
+	struct ER_CompiledSceneSection
+	{
+		UINT32 Offset; // in bytes, from the beginning of the file
+		UINT32 Count; // in elements (in bytes for the string table)
+	};
+
+	struct ER_CompiledSceneSettings
+	{
+		UINT32 PresentMask; // bits of ER_COMPILED_SCENE_SETTING
+		XMFLOAT3 CameraPosition;
+		XMFLOAT3 CameraDirection;
+		XMFLOAT3 SunDirection;
+		XMFLOAT3 SunColor;
+		INT32 TerrainTilesCount;
+		float TerrainTileScale;
+		INT32 TerrainTileResolution;
+		UINT32 TerrainSplatLayers[4];
+		XMFLOAT3 LightProbesVolumeMinBounds;
+		XMFLOAT3 LightProbesVolumeMaxBounds;
+		float LightProbesDiffuseDistance;
+		float LightProbesSpecularDistance;
+		XMFLOAT3 GlobalLightProbeCameraPos;
+		UINT32 UseVolumetricFog;
+	};
+
+	struct ER_CompiledSceneHeader
+	{
+		UINT32 Magic;
+		UINT32 Version;
+		UINT64 SourceHash; // hash of the json file this binary was compiled from
+		UINT64 SourceSize;
+		UINT64 FileSize;
+		ER_CompiledSceneSection Sections[ER_COMPILED_SCENE_SECTION_COUNT];
+		ER_CompiledSceneSettings Settings;
+	};
+
+	struct ER_CompiledSceneObject
+	{
+		XMFLOAT4X4 Transform; // ready to be loaded (already transposed), identity if not set
+		UINT32 Name;
+		UINT32 ModelPath;
+
+		UINT32 BoolsPresentMask;
+		UINT32 BoolsValueMask;
+		UINT32 FloatsPresentMask;
+		UINT32 IntsPresentMask;
+		UINT32 Vec3sPresentMask;
+		float Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_COUNT];
+		INT32 Ints[ER_COMPILED_SCENE_OBJECT_INT_COUNT];
+		XMFLOAT3 Vec3s[ER_COMPILED_SCENE_OBJECT_VEC3_COUNT];
+
+		UINT32 SnowAlbedo;
+		UINT32 SnowNormal;
+		UINT32 SnowRoughness;
+		UINT32 FurHeight;
+
+		UINT32 FirstMaterial;
+		UINT32 MaterialsCount;
+		UINT32 FirstMeshTextures;
+		UINT32 MeshTexturesCount; // size of "textures" array in json
+		UINT32 FirstLODPath;
+		UINT32 LODsCount; // size of "model_lods" array in json (0 - no lods), paths are stored for LOD 1+
+		UINT32 FirstInstance;
+		UINT32 InstancesCount; // size of "instances_transforms" array in json
+
+		bool HasBool(ER_COMPILED_SCENE_OBJECT_BOOL aIndex) const { return (BoolsPresentMask & (1u << aIndex)) != 0; }
+		bool GetBool(ER_COMPILED_SCENE_OBJECT_BOOL aIndex) const { return (BoolsValueMask & (1u << aIndex)) != 0; }
+		bool HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT aIndex) const { return (FloatsPresentMask & (1u << aIndex)) != 0; }
+		bool HasInt(ER_COMPILED_SCENE_OBJECT_INT aIndex) const { return (IntsPresentMask & (1u << aIndex)) != 0; }
+		bool HasVec3(ER_COMPILED_SCENE_OBJECT_VEC3 aIndex) const { return (Vec3sPresentMask & (1u << aIndex)) != 0; }
+	};
+
+	struct ER_CompiledSceneMaterial
+	{
+		UINT32 Name;
+		UINT32 VertexEntry;
+		UINT32 GeometryEntry;
+		UINT32 HullEntry;
+		UINT32 DomainEntry;
+		UINT32 PixelEntry;
+	};
+
+	struct ER_CompiledSceneMeshTextures
+	{
+		UINT32 Textures[ER_COMPILED_SCENE_MESH_TEXTURE_COUNT];
+	};
+
+	struct ER_CompiledSceneFoliageZone
+	{
+		XMFLOAT3 Position;
+		INT32 PatchCount;
+		UINT32 TexturePath;
+		float AverageScale;
+		float DistributionRadius;
+		INT32 Type;
+		UINT32 PlacedOnTerrain;
+		INT32 PlacedSplatChannel; // -1 if not set
+		float PlacedHeightDelta;
+	};
+
+	// Binary version of the level json ("scene compiler" output).
+	// It is compiled automatically when the scene is loaded from json (see ER_Scene) and saved next to it with ER_COMPILED_SCENE_EXTENSION.
+	// On the next load the binary is memory-mapped instead of parsing the json, unless it is stale (json hash/size or version do not match).
+	// Levels can also be compiled offline with CompileScenesFromConfig() (i.e., "-compile_scenes" command line).
+	class ER_CompiledScene
+	{
+	public:
+		ER_CompiledScene();
+		~ER_CompiledScene();
+
+		// Loads the binary next to the scene json, or compiles (and saves) it from json if it is missing/stale. Returns true if the json was parsed.
+		bool Load(const std::string& aScenePath);
+		// Compiles the already parsed json (i.e., after the editor saved it) and saves the binary.
+		void Recompile(const std::string& aScenePath, const Json::Value& aRoot);
+		// Maps the binary file and validates it against the source json. Returns false if it does not exist or is stale.
+		bool LoadFromFile(const std::string& aPath, UINT64 aSourceHash, UINT64 aSourceSize);
+		// Builds the binary in memory from the parsed json.
+		void Compile(const Json::Value& aRoot, UINT64 aSourceHash, UINT64 aSourceSize);
+		bool SaveToFile(const std::string& aPath) const;
+		bool IsValid() const { return mData != nullptr; }
+		// Hash of the sections (objects, instances, etc.) without the header, so that editing the settings (i.e., camera) does not change it. Used by the baked data of the level.
+		UINT64 GetContentHash() const;
+
+		const ER_CompiledSceneHeader& GetHeader() const { return *reinterpret_cast<const ER_CompiledSceneHeader*>(mData); }
+		const ER_CompiledSceneSettings& GetSettings() const { return GetHeader().Settings; }
+		bool HasSetting(ER_COMPILED_SCENE_SETTING aSetting) const { return (GetSettings().PresentMask & (1u << aSetting)) != 0; }
+
+		UINT GetObjectsCount() const { return GetHeader().Sections[ER_COMPILED_SCENE_SECTION_OBJECTS].Count; }
+		const ER_CompiledSceneObject& GetSceneObject(UINT aIndex) const { return GetSectionElement<ER_CompiledSceneObject>(ER_COMPILED_SCENE_SECTION_OBJECTS, aIndex); }
+		const ER_CompiledSceneMaterial& GetMaterial(UINT aIndex) const { return GetSectionElement<ER_CompiledSceneMaterial>(ER_COMPILED_SCENE_SECTION_MATERIALS, aIndex); }
+		const ER_CompiledSceneMeshTextures& GetMeshTextures(UINT aIndex) const { return GetSectionElement<ER_CompiledSceneMeshTextures>(ER_COMPILED_SCENE_SECTION_MESH_TEXTURES, aIndex); }
+		const char* GetLODPath(UINT aIndex) const { return GetString(GetSectionElement<UINT32>(ER_COMPILED_SCENE_SECTION_LOD_PATHS, aIndex)); }
+		const XMFLOAT4X4* GetInstances(UINT aFirstInstance) const { return &GetSectionElement<XMFLOAT4X4>(ER_COMPILED_SCENE_SECTION_INSTANCES, aFirstInstance); }
+		UINT GetFoliageZonesCount() const { return GetHeader().Sections[ER_COMPILED_SCENE_SECTION_FOLIAGE_ZONES].Count; }
+		const ER_CompiledSceneFoliageZone& GetFoliageZone(UINT aIndex) const { return GetSectionElement<ER_CompiledSceneFoliageZone>(ER_COMPILED_SCENE_SECTION_FOLIAGE_ZONES, aIndex); }
+
+		bool HasString(UINT32 aOffset) const { return aOffset != ER_COMPILED_SCENE_INVALID_STRING; }
+		const char* GetString(UINT32 aOffset) const;
+
+		static std::string GetCompiledPath(const std::string& aScenePath);
+		// Offline path: compiles every scene listed in the global scenes config (i.e., "content\\levels\\global_scenes_config.json")
+		static bool CompileScenesFromConfig(const std::string& aConfigPath);
+		static bool CompileSceneFile(const std::string& aScenePath);
+	private:
+		template <typename T>
+		const T& GetSectionElement(ER_COMPILED_SCENE_SECTION aSection, UINT aIndex) const
+		{
+			assert(aIndex < GetHeader().Sections[aSection].Count);
+			return reinterpret_cast<const T*>(mData + GetHeader().Sections[aSection].Offset)[aIndex];
+		}
+		void Unload();
+		void SaveCompiledScene(const std::string& aCompiledPath);
+
+		std::vector<char> mCompiledData; // used when the scene was compiled in memory (not mapped)
+		const char* mData = nullptr;
+		UINT64 mDataSize = 0;
+
+		ER_MappedFile mMappedFile;
+	};
+}
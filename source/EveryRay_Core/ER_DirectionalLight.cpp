@@ -124,8 +124,7 @@ namespace EveryRay_Core
 		if (mProxyModel)
 			mProxyModel->ApplyTransform(transformMatrix);
 
-		for (auto listener : RotationUpdateEvent->GetListeners())
-			listener();
+		RotationUpdateEvent->Invoke();
 	}
 
 	void ER_DirectionalLight::DrawProxyModel(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, const ER_CoreTime & time, ER_RHI_GPURootSignature* rs)
@@ -8,6 +8,8 @@
 #include "ER_RenderingObject.h"
 #include "ER_Utility.h"
 #include "ER_Scene.h"
+#include "ER_Camera.h"
+#include "ER_Ray.h"
 
 namespace EveryRay_Core
 {
@@ -52,9 +54,12 @@ namespace EveryRay_Core
 			ImGui::TextColored(ImVec4(0.12f, 0.78f, 0.44f, 1), "Scene objects");
 			if (ImGui::CollapsingHeader("Global LOD Properties"))
 			{
-				ImGui::SliderFloat("LOD #0 distance", &ER_Utility::DistancesLOD[0], 0.0f, 100.0f);
-				ImGui::SliderFloat("LOD #1 distance", &ER_Utility::DistancesLOD[1], ER_Utility::DistancesLOD[0], 250.0f);
-				ImGui::SliderFloat("LOD #2 distance", &ER_Utility::DistancesLOD[2], ER_Utility::DistancesLOD[1], 1000.0f);
+				// thresholds are projected sizes of the objects (fraction of the screen height), the smallest one is where objects stop being rendered
+				ImGui::SliderFloat("LOD #0 screen size", &ER_Utility::ScreenSizesLOD[0], ER_Utility::ScreenSizesLOD[1], 1.0f);
+				ImGui::SliderFloat("LOD #1 screen size", &ER_Utility::ScreenSizesLOD[1], ER_Utility::ScreenSizesLOD[2], ER_Utility::ScreenSizesLOD[0]);
+				ImGui::SliderFloat("LOD #2 screen size", &ER_Utility::ScreenSizesLOD[2], 0.0f, ER_Utility::ScreenSizesLOD[1], "%.4f");
+				ImGui::SliderFloat("LOD bias", &ER_Utility::LODBias, 0.1f, 4.0f);
+				ImGui::SliderFloat("LOD hysteresis", &ER_Utility::LODHysteresis, 0.0f, 0.5f);
 				//add more if needed
 			}
 			if (ImGui::Button("Save transforms")) {
@@ -64,9 +69,10 @@ namespace EveryRay_Core
 			int objectIndex = 0;
 			int objectsSize = 0;
 			for (auto& object : mScene->objects) {
-				if (object.second->IsAvailableInEditor())
+				if (object.second->IsAvailableInEditor() && objectIndex < MAX_OBJECTS_COUNT)
 				{
 					editorObjectsNames[objectIndex] = object.first.c_str();
+					editorObjects[objectIndex] = object.second;
 					objectIndex++;
 				}
 			}
@@ -76,27 +82,59 @@ namespace EveryRay_Core
 			if (ImGui::Button("Deselect")) {
 				selectedObjectIndex = -1;
 			}
+			ImGui::Text("Left click in the scene to pick an object");
 			ImGui::ListBox("##empty", &selectedObjectIndex, editorObjectsNames, objectsSize);
 
-			for (size_t i = 0; i < objectsSize; i++)
-			{
-				if (i == selectedObjectIndex)
-				{
-					auto renderingObject = mScene->FindRenderingObjectByName(editorObjectsNames[selectedObjectIndex]);
-					if (renderingObject)
-						renderingObject->SetSelected(true);
-				}
-				else
-				{
-					auto renderingObject = mScene->FindRenderingObjectByName(editorObjectsNames[i]);
-					if (renderingObject)
-						renderingObject->SetSelected(false);
-				}
-			}
+			int pickedObjectIndex = PickObject(objectsSize);
+			if (pickedObjectIndex >= 0)
+				selectedObjectIndex = pickedObjectIndex;
+
+			for (int i = 0; i < objectsSize; i++)
+				editorObjects[i]->SetSelected(i == selectedObjectIndex);
 
 			ImGui::End();
 		}
 
 	}
 
+	int ER_Editor::PickObject(int objectsCount)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		if (!ImGui::IsMouseClicked(0) || io.WantCaptureMouse || ImGuizmo::IsOver() || io.DisplaySize.x <= 0.0f || io.DisplaySize.y <= 0.0f)
+			return -1;
+
+		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+		if (!camera)
+			return -1;
+
+		// unproject the cursor to the near and far planes
+		const float x = 2.0f * io.MousePos.x / io.DisplaySize.x - 1.0f;
+		const float y = 1.0f - 2.0f * io.MousePos.y / io.DisplaySize.y;
+		XMMATRIX invViewProjection = XMMatrixInverse(nullptr, camera->ViewProjectionMatrix());
+		XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(x, y, 0.0f, 1.0f), invViewProjection);
+		XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(x, y, 1.0f, 1.0f), invViewProjection);
+		ER_Ray ray(nearPoint, XMVector3Normalize(farPoint - nearPoint));
+
+		mPickingHits.clear();
+		mScene->GetBVH().QueryRay(ray, XMVectorGetX(XMVector3Length(farPoint - nearPoint)), mPickingHits);
+
+		// closest hit of an editable object (objects that contain the camera are skipped, otherwise big ones would always win)
+		for (const ER_BVHRayHit& hit : mPickingHits)
+		{
+			if (hit.Distance <= 0.0f)
+				continue;
+
+			const ER_SceneBVHItem& item = mScene->GetBVHItem(hit.Item);
+			for (int i = 0; i < objectsCount; i++)
+			{
+				if (editorObjects[i] != item.Object)
+					continue;
+
+				if (item.InstanceIndex >= 0)
+					item.Object->SetSelectedInstance(item.InstanceIndex);
+				return i;
+			}
+		}
+		return -1;
+	}
 }
\ No newline at end of file
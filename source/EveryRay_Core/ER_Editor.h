@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ER_CoreComponent.h"
+#include "ER_BVH.h"
 #define MAX_OBJECTS_COUNT 1000
 #define MAX_LOD 3
 
@@ -31,7 +32,11 @@ namespace EveryRay_Core
 		ER_Editor(const ER_Editor& rhs);
 		ER_Editor& operator=(const ER_Editor& rhs);
 
+		int PickObject(int objectsCount); // casts a ray from the mouse cursor through the scene BVH, returns the index in "editorObjects" (or -1)
+
 		const char* editorObjectsNames[MAX_OBJECTS_COUNT];
+		ER_RenderingObject* editorObjects[MAX_OBJECTS_COUNT];
+		std::vector<ER_BVHRayHit> mPickingHits;
 
 		bool mUseCustomSkyboxColor = true;
 		float bottomColorSky[4] = {217.0f / 255.0f, 217.0f / 255.0f, 218.0f / 255.0f, 1.0f};
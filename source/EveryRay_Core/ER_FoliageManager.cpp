@@ -14,6 +14,7 @@
 #include "ER_Camera.h"
 #include "ER_RenderableAABB.h"
 #include "ER_Terrain.h"
+#include "ER_Frustum.h"
 
 #define FOLIAGE_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define FOLIAGE_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 1
@@ -60,14 +61,14 @@ namespace EveryRay_Core
 			zoneIndex++;
 		}
 
-		for (auto listener : FoliageSystemInitializedEvent->GetListeners())
-			listener();
+		FoliageSystemInitializedEvent->Invoke();
 	}
 
 	void ER_FoliageManager::Update(const ER_CoreTime& gameTime, float gustDistance, float strength, float frequency)
 	{
 		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
 
+		mLastFrameUploadedBytes = 0;
 		if (mEnabled)
 		{
 			for (auto& foliage : mFoliageCollection)
@@ -78,6 +79,7 @@ namespace EveryRay_Core
 				foliage->SetWindParams(gustDistance, strength, frequency);
 				foliage->Update(gameTime);
 				foliage->PerformCPUFrustumCulling((ER_Utility::IsMainCameraCPUFrustumCulling && mEnableCulling) ? camera : nullptr);
+				mLastFrameUploadedBytes += foliage->UpdateBuffersGPU(); // changed patches (and the buffer versions that have not received them yet)
 			}
 		}
 		UpdateImGui();
@@ -134,6 +136,12 @@ namespace EveryRay_Core
 
 		ImGui::Text(showNoteInEditorText.c_str());
 
+		UINT64 instanceBuffersSize = 0;
+		for (auto& foliage : mFoliageCollection)
+			instanceBuffersSize += foliage->GetInstanceBufferSize();
+		ImGui::Text("Instance buffers: %.1f KB (%u bytes per patch), uploaded (last frame): %.1f KB", instanceBuffersSize / 1024.0f,
+			static_cast<UINT>(sizeof(GPUFoliageInstanceData)), mLastFrameUploadedBytes / 1024.0f);
+
 		for (int i = 0; i < mFoliageCollection.size(); i++)
 			mFoliageZonesNamesUI[i] = mFoliageCollection[i]->GetName().c_str();
 
@@ -173,10 +181,8 @@ namespace EveryRay_Core
 				{ "POSITION", 0, ER_FORMAT_R32G32B32A32_FLOAT, 0, 0, true, 0 },
 				{ "TEXCOORD", 0, ER_FORMAT_R32G32_FLOAT, 0, 0xffffffff, true, 0 },
 				{ "NORMAL", 0, ER_FORMAT_R32G32B32_FLOAT, 0, 0xffffffff, true, 0 },
-				{ "WORLD", 0, ER_FORMAT_R32G32B32A32_FLOAT, 1, 0,  false, 1 },
-				{ "WORLD", 1, ER_FORMAT_R32G32B32A32_FLOAT, 1, 16, false, 1 },
-				{ "WORLD", 2, ER_FORMAT_R32G32B32A32_FLOAT, 1, 32, false, 1 },
-				{ "WORLD", 3, ER_FORMAT_R32G32B32A32_FLOAT, 1, 48, false, 1 }
+				{ "INSTANCE_POSITION", 0, ER_FORMAT_R32G32B32_FLOAT, 1, 0, false, 1 },
+				{ "INSTANCE_SCALE_ROTATION", 0, ER_FORMAT_R16G16_FLOAT, 1, 12, false, 1 } // see GPUFoliageInstanceData
 			};
 			mInputLayout = rhi->CreateInputLayout(inputElementDescriptions, ARRAYSIZE(inputElementDescriptions));
 
@@ -216,9 +222,7 @@ namespace EveryRay_Core
 		DeleteObject(mInstanceBuffer);
 		DeleteObject(mIndexBuffer);
 		DeleteObject(mAlbedoTexture);
-		DeleteObjects(mPatchesBufferCPU);
 		DeleteObjects(mCurrentPositions);
-		DeleteObjects(mPatchesBufferGPU);
 		DeleteObject(mDebugGizmoAABB);
 		DeleteObject(mInputLayout);
 		DeleteObject(mVS);
@@ -243,6 +247,7 @@ namespace EveryRay_Core
 			quadSingleModel->GetMesh(0).CreateVertexBuffer_PositionUvNormal(mVertexBuffer);
 			quadSingleModel->GetMesh(0).CreateIndexBuffer(mIndexBuffer);
 			mVerticesCount = static_cast<int>(quadSingleModel->GetMesh(0).Indices().size());
+			mBillboardAABB = quadSingleModel->GenerateAABB();
 		}
 		else if (bType == FoliageBillboardType::TWO_QUADS_CROSSING) {
 			mIsRotating = false;
@@ -250,6 +255,7 @@ namespace EveryRay_Core
 			quadDoubleModel->GetMesh(0).CreateVertexBuffer_PositionUvNormal(mVertexBuffer);
 			quadDoubleModel->GetMesh(0).CreateIndexBuffer(mIndexBuffer);
 			mVerticesCount = static_cast<int>(quadDoubleModel->GetMesh(0).Indices().size());
+			mBillboardAABB = quadDoubleModel->GenerateAABB();
 		}
 		else if (bType == FoliageBillboardType::THREE_QUADS_CROSSING) {
 			mIsRotating = false;
@@ -257,6 +263,7 @@ namespace EveryRay_Core
 			quadTripleModel->GetMesh(0).CreateVertexBuffer_PositionUvNormal(mVertexBuffer);
 			quadTripleModel->GetMesh(0).CreateIndexBuffer(mIndexBuffer);
 			mVerticesCount = static_cast<int>(quadTripleModel->GetMesh(0).Indices().size());
+			mBillboardAABB = quadTripleModel->GenerateAABB();
 		}
 		else if (bType == FoliageBillboardType::MULTIPLE_QUADS_CROSSING) {
 			mIsRotating = false;
@@ -264,6 +271,7 @@ namespace EveryRay_Core
 			quadMultipleModel->GetMesh(0).CreateVertexBuffer_PositionUvNormal(mVertexBuffer);
 			quadMultipleModel->GetMesh(0).CreateIndexBuffer(mIndexBuffer);
 			mVerticesCount = static_cast<int>(quadMultipleModel->GetMesh(0).Indices().size());
+			mBillboardAABB = quadMultipleModel->GenerateAABB();
 		}
 	}
 	void ER_Foliage::Initialize()
@@ -273,11 +281,7 @@ namespace EveryRay_Core
 		mFoliageConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Foliage CB");
 		InitializeBuffersCPU();
 		InitializeBuffersGPU(mPatchesCount);
-
-		float radius = mDistributionRadius * 0.5f + mAABBExtentXZ;
-		XMFLOAT3 minP = XMFLOAT3(mDistributionCenter.x - radius, mDistributionCenter.y - mAABBExtentY, mDistributionCenter.z - radius);
-		XMFLOAT3 maxP = XMFLOAT3(mDistributionCenter.x + radius, mDistributionCenter.y + mAABBExtentY, mDistributionCenter.z + radius);
-		mAABB = ER_AABB(minP, maxP);
+		UpdateAABB();
 
 		mDebugGizmoAABB = new ER_RenderableAABB(mCore, XMFLOAT4(0.0, 0.0, 1.0, 1.0));
 		mDebugGizmoAABB->InitializeGeometry({ mAABB.first, mAABB.second });
@@ -304,13 +308,11 @@ namespace EveryRay_Core
 						assert(aTerrain);
 						aTerrain->ReadbackPlacedPositions(mOutputPositionsOnTerrainBuffer, mInputPositionsOnTerrainBuffer, mCurrentPositions, mPatchesCount);
 						UpdateBuffersCPU();
-						UpdateBuffersGPU();
 						UpdateAABB();
 					}
 				);
 #else
 				UpdateBuffersCPU();
-				UpdateBuffersGPU();
 				UpdateAABB();
 #endif
 
@@ -319,6 +321,7 @@ namespace EveryRay_Core
 
 		mTransformationMatrix = XMMatrixTranslation(mDistributionCenter.x, mDistributionCenter.y, mDistributionCenter.z);
 		ER_MatrixHelper::GetFloatArray(mTransformationMatrix, mCurrentObjectTransformMatrix);
+		ImGuizmo::DecomposeMatrixToComponents(mCurrentObjectTransformMatrix, mMatrixTranslation, mMatrixRotation, mMatrixScale);
 	}
 
 	void ER_Foliage::InitializeBuffersGPU(int count)
@@ -329,40 +332,68 @@ namespace EveryRay_Core
 
 		// instance buffer
 		int instanceCount = count;
-		mPatchesBufferGPU = new GPUFoliageInstanceData[instanceCount];
-
+		mPatchesBufferGPU.resize(instanceCount);
 		for (int i = 0; i < instanceCount; i++)
 		{
-			float randomScale = ER_Utility::RandomFloat(mScale - 1.0f, mScale + 1.0f);
-			mPatchesBufferCPU[i].scale = randomScale;
-			mPatchesBufferGPU[i].worldMatrix = XMMatrixScaling(randomScale, randomScale, randomScale) * XMMatrixTranslation(mPatchesBufferCPU[i].xPos, mPatchesBufferCPU[i].yPos, mPatchesBufferCPU[i].zPos);
-			//mPatchesBufferGPU[i].color = XMFLOAT3(mPatchesBufferCPU[i].r, mPatchesBufferCPU[i].g, mPatchesBufferCPU[i].b);
-			mCurrentPositions[i] = XMFLOAT4(mPatchesBufferCPU[i].xPos, mPatchesBufferCPU[i].yPos, mPatchesBufferCPU[i].zPos, 1.0f);
+			mPatchesScales[i] = ER_Utility::RandomFloat(mScale - 1.0f, mScale + 1.0f);
+			PackPatch(i);
 		}
 
+		// all versions of the buffer are created with this data, so nothing is dirty
+		mPatchesDirtyBlocks.assign((instanceCount + FOLIAGE_PATCHES_PER_DIRTY_BLOCK - 1) / FOLIAGE_PATCHES_PER_DIRTY_BLOCK, 0);
+		mPatchesDirtyVersionsMask = 0;
+
 		mInstanceBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: Foliage instance buffer");
-		mInstanceBuffer->CreateGPUBufferResource(mCore.GetRHI(), mPatchesBufferGPU, instanceCount, sizeof(GPUFoliageInstanceData), true, ER_BIND_VERTEX_BUFFER);
+		mInstanceBuffer->CreateGPUBufferResource(mCore.GetRHI(), mPatchesBufferGPU.data(), instanceCount, sizeof(GPUFoliageInstanceData), true, ER_BIND_VERTEX_BUFFER);
 	}
 
 	void ER_Foliage::InitializeBuffersCPU()
 	{
-		// randomly generate positions and color
-		mPatchesBufferCPU = new CPUFoliageData[mPatchesCount];
+		// randomly generate positions
+		mPatchesPositionsX.resize(mPatchesCount);
+		mPatchesPositionsY.resize(mPatchesCount);
+		mPatchesPositionsZ.resize(mPatchesCount);
+		mPatchesScales.resize(mPatchesCount, mScale);
+		mPatchesRotations.resize(mPatchesCount, 0.0f);
 		mCurrentPositions = new XMFLOAT4[mPatchesCount];
 
 		for (int i = 0; i < mPatchesCount; i++)
 		{
-			mPatchesBufferCPU[i].xPos = mDistributionCenter.x + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius /2;
-			mPatchesBufferCPU[i].yPos = mDistributionCenter.y;
-			mPatchesBufferCPU[i].zPos = mDistributionCenter.z + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius /2;
-			mCurrentPositions[i] = XMFLOAT4(mPatchesBufferCPU[i].xPos, mPatchesBufferCPU[i].yPos, mPatchesBufferCPU[i].zPos, 1.0f);
-
-			mPatchesBufferCPU[i].r = ((float)rand() / (float)(RAND_MAX)) * 1.0f + 1.0f;
-			mPatchesBufferCPU[i].g = ((float)rand() / (float)(RAND_MAX)) * 1.0f + 0.5f;
-			mPatchesBufferCPU[i].b = 0.0f;
+			mPatchesPositionsX[i] = mDistributionCenter.x + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius /2;
+			mPatchesPositionsY[i] = mDistributionCenter.y;
+			mPatchesPositionsZ[i] = mDistributionCenter.z + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius /2;
+			mCurrentPositions[i] = XMFLOAT4(mPatchesPositionsX[i], mPatchesPositionsY[i], mPatchesPositionsZ[i], 1.0f);
 		}
 	}
 
+	void ER_Foliage::PackPatch(int i)
+	{
+		mPatchesBufferGPU[i].Position = XMFLOAT3(mPatchesPositionsX[i], mPatchesPositionsY[i], mPatchesPositionsZ[i]);
+		mPatchesBufferGPU[i].ScaleRotation = PackedVector::XMHALF2(mPatchesScales[i], mPatchesRotations[i]);
+	}
+
+	void ER_Foliage::MarkPatchesDirty(int start, int end)
+	{
+		assert(start >= 0 && start < end && end <= mPatchesCount);
+
+		const UINT versionsCount = mCore.GetRHI()->GetDynamicBufferVersionsCount();
+		assert(versionsCount <= 8); // one bit per version in "mPatchesDirtyBlocks"
+		const UINT8 allVersionsMask = static_cast<UINT8>((1u << versionsCount) - 1);
+
+		for (int block = start / FOLIAGE_PATCHES_PER_DIRTY_BLOCK; block <= (end - 1) / FOLIAGE_PATCHES_PER_DIRTY_BLOCK; block++)
+			mPatchesDirtyBlocks[block] |= allVersionsMask;
+		mPatchesDirtyVersionsMask |= allVersionsMask;
+	}
+
+	void ER_Foliage::SetPatchPosition(int i, float x, float y, float z)
+	{
+		mPatchesPositionsX[i] = x;
+		mPatchesPositionsY[i] = y;
+		mPatchesPositionsZ[i] = z;
+		PackPatch(i);
+		MarkPatchesDirty(i, i + 1);
+	}
+
 	void ER_Foliage::PrepareRendering(const ER_CoreTime& gameTime, const ER_ShadowMapper* worldShadowMapper, ER_RHI_GPURootSignature* rs)
 	{
 		auto rhi = mCore.GetRHI();
@@ -398,7 +429,7 @@ namespace EveryRay_Core
 		rhi->SetConstantBuffers(ER_PIXEL,    { mFoliageConstantBuffer.Buffer() }, 0, rs, FOLIAGE_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 		rhi->SetSamplers(ER_PIXEL, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP, ER_RHI_SAMPLER_STATE::ER_SHADOW_SS });
 
-		std::vector<ER_RHI_GPUResource*> resources(1 + NUM_SHADOW_CASCADES);
+		ER_RHI_GPUResource* resources[1 + NUM_SHADOW_CASCADES] = {};
 		resources[0] = mAlbedoTexture;
 		if (worldShadowMapper)
 		{
@@ -423,7 +454,7 @@ namespace EveryRay_Core
 		rhi->SetIndexBuffer(mIndexBuffer);
 
 		bool isVoxelizationRenderPass = renderPass == FOLIAGE_VOXELIZATION;
-		std::string& psoName = isVoxelizationRenderPass ? mFoliageVoxelizationPassPSOName : mFoliageGBufferPassPSOName;
+		const ER_RHI_PSOHandle& psoName = isVoxelizationRenderPass ? mFoliageVoxelizationPassPSOName : mFoliageGBufferPassPSOName;
 
 		if (!rhi->IsPSOReady(psoName))
 		{
@@ -472,17 +503,21 @@ namespace EveryRay_Core
 
 		if (editable)
 		{
-			mDistributionCenter = XMFLOAT3(mMatrixTranslation[0], mMatrixTranslation[1], mMatrixTranslation[2]);
-			for (int i = 0; i < mPatchesCount; i++)
+			// redistribute the patches only when the gizmo has moved them (otherwise nothing needs to be uploaded)
+			XMFLOAT3 newCenter = XMFLOAT3(mMatrixTranslation[0], mMatrixTranslation[1], mMatrixTranslation[2]);
+			if (newCenter.x != mDistributionCenter.x || newCenter.y != mDistributionCenter.y || newCenter.z != mDistributionCenter.z)
 			{
-				mCurrentPositions[i] = XMFLOAT4(
-					mDistributionCenter.x + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius / 2,
-					mDistributionCenter.y,
-					mDistributionCenter.z + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius / 2, 1.0f);
+				mDistributionCenter = newCenter;
+				for (int i = 0; i < mPatchesCount; i++)
+				{
+					mCurrentPositions[i] = XMFLOAT4(
+						mDistributionCenter.x + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius / 2,
+						mDistributionCenter.y,
+						mDistributionCenter.z + ((float)rand() / (float)(RAND_MAX)) * mDistributionRadius - mDistributionRadius / 2, 1.0f);
+				}
+				UpdateBuffersCPU();
+				UpdateAABB();
 			}
-			UpdateBuffersCPU();
-			UpdateBuffersGPU();
-			UpdateAABB();
 		}
 
 		XMFLOAT3 toCam = { mDistributionCenter.x - mCamera.Position().x, mDistributionCenter.y - mCamera.Position().y, mDistributionCenter.z - mCamera.Position().z };
@@ -553,13 +588,11 @@ namespace EveryRay_Core
 								assert(aTerrain);
 								aTerrain->ReadbackPlacedPositions(mOutputPositionsOnTerrainBuffer, mInputPositionsOnTerrainBuffer, mCurrentPositions, mPatchesCount); 
 								UpdateBuffersCPU();
-								UpdateBuffersGPU();
 								UpdateAABB();
 							}
 						);
 #else
 						UpdateBuffersCPU();
-						UpdateBuffersGPU();
 						UpdateAABB();
 #endif
 						
@@ -585,37 +618,80 @@ namespace EveryRay_Core
 		}
 	}
 
-	// updating world matrices of visible patches
-	void ER_Foliage::UpdateBuffersGPU() 
+	// uploads the blocks of patches that are dirty for the current version of the instance buffer (other versions get them when they become current)
+	UINT64 ER_Foliage::UpdateBuffersGPU()
 	{
 		ER_RHI* rhi = mCore.GetRHI();
 
-		XMMATRIX translationMatrix;
-		for (int i = 0; i < mPatchesCount; i++)
+		const UINT8 versionMask = static_cast<UINT8>(1u << rhi->GetDynamicBufferCurrentVersion());
+		if (!mInstanceBuffer || !(mPatchesDirtyVersionsMask & versionMask))
+			return 0;
+		mPatchesDirtyVersionsMask &= ~versionMask;
+
+		// merge consecutive dirty blocks into ranges
+		const UINT blocksCount = static_cast<UINT>(mPatchesDirtyBlocks.size());
+		const UINT patchSize = static_cast<UINT>(sizeof(GPUFoliageInstanceData));
+		ER_RHI_BufferRange* ranges = mCore.FrameAllocator()->AllocateArray<ER_RHI_BufferRange>(blocksCount);
+		UINT rangesCount = 0;
+		for (UINT block = 0; block < blocksCount; block++)
 		{
-			translationMatrix = XMMatrixTranslation(mPatchesBufferCPU[i].xPos, mPatchesBufferCPU[i].yPos, mPatchesBufferCPU[i].zPos);
-			mPatchesBufferGPU[i].worldMatrix = XMMatrixScaling(mPatchesBufferCPU[i].scale, mPatchesBufferCPU[i].scale, mPatchesBufferCPU[i].scale) * translationMatrix;
+			if (!(mPatchesDirtyBlocks[block] & versionMask))
+				continue;
+			mPatchesDirtyBlocks[block] &= ~versionMask;
+
+			const UINT start = block * FOLIAGE_PATCHES_PER_DIRTY_BLOCK;
+			const UINT end = std::min(start + FOLIAGE_PATCHES_PER_DIRTY_BLOCK, static_cast<UINT>(mPatchesCount));
+			if (rangesCount > 0 && ranges[rangesCount - 1].Offset + ranges[rangesCount - 1].Size == start * patchSize)
+				ranges[rangesCount - 1].Size += (end - start) * patchSize;
+			else
+			{
+				ranges[rangesCount].Offset = start * patchSize;
+				ranges[rangesCount].Size = (end - start) * patchSize;
+				rangesCount++;
+			}
 		}
 
-		rhi->UpdateBuffer(mInstanceBuffer, (void*)mPatchesBufferGPU, (sizeof(GPUFoliageInstanceData) * mPatchesCount), mIsPlacedOnTerrain /* otherwise we won't have placed foliage in some frames */);
+		if (rangesCount == 0)
+			return 0;
+		return rhi->UpdateBufferRanges(mInstanceBuffer, mPatchesBufferGPU.data(), static_cast<int>(GetInstanceBufferSize()), ER_RHI_ArrayView<ER_RHI_BufferRange>(ranges, rangesCount));
 	}
 
+	// copies the positions that have changed (i.e., after on-terrain placement or redistribution) and marks their patches as dirty
 	void ER_Foliage::UpdateBuffersCPU()
 	{
 		for (int i = 0; i < mPatchesCount; i++)
 		{
-			mPatchesBufferCPU[i].xPos = mCurrentPositions[i].x;
-			mPatchesBufferCPU[i].yPos = mCurrentPositions[i].y;
-			mPatchesBufferCPU[i].zPos = mCurrentPositions[i].z;
+			const XMFLOAT4& position = mCurrentPositions[i];
+			if (position.x != mPatchesPositionsX[i] || position.y != mPatchesPositionsY[i] || position.z != mPatchesPositionsZ[i])
+				SetPatchPosition(i, position.x, position.y, position.z);
 		}
 	}
 
 	void ER_Foliage::UpdateAABB()
 	{
-		//update AABB based on the first patch Y position (not accurate, but fast)
-		float radius = mDistributionRadius * 0.5f + mAABBExtentXZ;
-		XMFLOAT3 minP = XMFLOAT3(mDistributionCenter.x - radius, mPatchesBufferCPU[0].yPos - mAABBExtentY, mDistributionCenter.z - radius);
-		XMFLOAT3 maxP = XMFLOAT3(mDistributionCenter.x + radius, mPatchesBufferCPU[0].yPos + mAABBExtentY, mDistributionCenter.z + radius);
+		if (mPatchesCount == 0)
+		{
+			mAABB = ER_AABB(mDistributionCenter, mDistributionCenter);
+			return;
+		}
+
+		// billboards can be rotated around Y (i.e., to the camera), so in XZ we use the radius of the billboard's bounds around the Y axis
+		const float extentX = std::max(fabsf(mBillboardAABB.first.x), fabsf(mBillboardAABB.second.x));
+		const float extentZ = std::max(fabsf(mBillboardAABB.first.z), fabsf(mBillboardAABB.second.z));
+		const float radiusXZ = sqrt(extentX * extentX + extentZ * extentZ);
+
+		XMFLOAT3 minP = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 maxP = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (int i = 0; i < mPatchesCount; i++)
+		{
+			const float scale = mPatchesScales[i];
+			minP.x = std::min(minP.x, mPatchesPositionsX[i] - radiusXZ * scale);
+			maxP.x = std::max(maxP.x, mPatchesPositionsX[i] + radiusXZ * scale);
+			minP.y = std::min(minP.y, mPatchesPositionsY[i] + mBillboardAABB.first.y * scale);
+			maxP.y = std::max(maxP.y, mPatchesPositionsY[i] + mBillboardAABB.second.y * scale);
+			minP.z = std::min(minP.z, mPatchesPositionsZ[i] - radiusXZ * scale);
+			maxP.z = std::max(maxP.z, mPatchesPositionsZ[i] + radiusXZ * scale);
+		}
 		mAABB = ER_AABB(minP, maxP);
 	}
 
@@ -627,44 +703,16 @@ namespace EveryRay_Core
 			return mIsCulled;
 		}
 
-		auto frustum = camera->GetFrustum();
-		bool culled = false;
-		// start a loop through all frustum planes
-		for (int planeID = 0; planeID < 6; ++planeID)
-		{
-			XMVECTOR planeNormal = XMVectorSet(frustum.Planes()[planeID].x, frustum.Planes()[planeID].y, frustum.Planes()[planeID].z, 0.0f);
-			float planeConstant = frustum.Planes()[planeID].w;
-
-			XMFLOAT3 axisVert;
-
-			// x-axis
-			if (frustum.Planes()[planeID].x > 0.0f)
-				axisVert.x = mAABB.first.x;
-			else
-				axisVert.x = mAABB.second.x;
-
-			// y-axis
-			if (frustum.Planes()[planeID].y > 0.0f)
-				axisVert.y = mAABB.first.y;
-			else
-				axisVert.y = mAABB.second.y;
+		// wind moves the top vertices of the billboards in the vertex shader (by up to half of its strength)
+		const float windOffset = 0.5f * fabsf(mWindStrength);
+		ER_AABB bounds = mAABB;
+		bounds.first.x -= windOffset;
+		bounds.first.z -= windOffset;
+		bounds.second.x += windOffset;
+		bounds.second.z += windOffset;
 
-			// z-axis
-			if (frustum.Planes()[planeID].z > 0.0f)
-				axisVert.z = mAABB.first.z;
-			else
-				axisVert.z = mAABB.second.z;
-
-
-			if (XMVectorGetX(XMVector3Dot(planeNormal, XMLoadFloat3(&axisVert))) + planeConstant > 0.0f)
-			{
-				culled = true;
-				// Skip remaining planes to check and move on 
-				break;
-			}
-		}
-		mIsCulled = culled;
-		return culled;
+		mIsCulled = ER_Frustum::IsAABBCulled(camera->GetFrustum().Planes(), 6, bounds);
+		return mIsCulled;
 	}
 
 	void ER_Foliage::CalculateDynamicLOD(float distanceToCam)
@@ -5,6 +5,7 @@
 #include "RHI/ER_RHI.h"
 
 #define MAX_FOLIAGE_ZONES 4096
+#define FOLIAGE_PATCHES_PER_DIRTY_BLOCK 256 // granularity of the instance buffer updates
 
 namespace EveryRay_Core
 {
@@ -62,16 +63,11 @@ namespace EveryRay_Core
 		XMFLOAT3 normals;
 	};
 
-	struct ER_ALIGN_GPU_BUFFER GPUFoliageInstanceData //for GPU instance buffer
+	// Packed patch transform (16 bytes instead of a full world matrix), the matrix is built in the vertex shader
+	struct GPUFoliageInstanceData //for GPU instance buffer
 	{
-		XMMATRIX worldMatrix = XMMatrixIdentity();
-	};
-
-	struct CPUFoliageData //for CPU buffer
-	{
-		float xPos, yPos, zPos;
-		float r, g, b;
-		float scale;
+		XMFLOAT3 Position;
+		PackedVector::XMHALF2 ScaleRotation; // uniform scale, rotation around Y (radians)
 	};
 
 	class ER_Foliage
@@ -104,19 +100,16 @@ namespace EveryRay_Core
 		}
 
 		int GetPatchesCount() { return mPatchesCount; }
-		void SetPatchPosition(int i, float x, float y, float z) {
-			mPatchesBufferCPU[i].xPos = x;
-			mPatchesBufferCPU[i].yPos = y;
-			mPatchesBufferCPU[i].zPos = z;
-		}
-		float GetPatchPositionX(int i) { return mPatchesBufferCPU[i].xPos; }
-		float GetPatchPositionY(int i) { return mPatchesBufferCPU[i].yPos; }
-		float GetPatchPositionZ(int i) { return mPatchesBufferCPU[i].zPos; }
+		void SetPatchPosition(int i, float x, float y, float z); // the patch is uploaded in the next UpdateBuffersGPU()
+		float GetPatchPositionX(int i) { return mPatchesPositionsX[i]; }
+		float GetPatchPositionY(int i) { return mPatchesPositionsY[i]; }
+		float GetPatchPositionZ(int i) { return mPatchesPositionsZ[i]; }
 		const XMFLOAT3& GetDistributionCenter() { return mDistributionCenter; }
 
-		void UpdateBuffersGPU();
-		void UpdateBuffersCPU();
-		void UpdateAABB();
+		UINT64 UpdateBuffersGPU(); // uploads the patches that changed to the current version of the instance buffer, returns the uploaded bytes
+		void UpdateBuffersCPU(); // takes the positions from "mCurrentPositions" (i.e., after on-terrain placement)
+		void UpdateAABB(); // exact bounds of all patches
+		UINT64 GetInstanceBufferSize() const { return static_cast<UINT64>(mPatchesCount) * sizeof(GPUFoliageInstanceData); }
 
 		void SetVoxelizationParams(float* worldVoxelScale, const float* voxelTexDimension, XMFLOAT4* voxelCameraPos)
 		{
@@ -137,6 +130,8 @@ namespace EveryRay_Core
 		void InitializeBuffersCPU();
 		void LoadBillboardModel(FoliageBillboardType bType);
 		void CalculateDynamicLOD(float distanceToCam);
+		void PackPatch(int i);
+		void MarkPatchesDirty(int start, int end);
 
 		ER_Core& mCore;
 		ER_Camera& mCamera;
@@ -146,13 +141,13 @@ namespace EveryRay_Core
 		ER_RHI_GPUShader* mVS = nullptr;
 		ER_RHI_GPUShader* mGS = nullptr;
 		ER_RHI_GPUShader* mPS = nullptr;
-		std::string mFoliageMainPassPSOName = "ER_RHI_GPUPipelineStateObject: Foliage - Main Pass";
+		ER_RHI_PSOHandle mFoliageMainPassPSOName = "ER_RHI_GPUPipelineStateObject: Foliage - Main Pass";
 
 		ER_RHI_GPUShader* mPS_GBuffer = nullptr;
-		std::string mFoliageGBufferPassPSOName = "ER_RHI_GPUPipelineStateObject: Foliage - Gbuffer Pass";
+		ER_RHI_PSOHandle mFoliageGBufferPassPSOName = "ER_RHI_GPUPipelineStateObject: Foliage - Gbuffer Pass";
 
 		ER_RHI_GPUShader* mPS_Voxelization = nullptr;
-		std::string mFoliageVoxelizationPassPSOName = "ER_RHI_GPUPipelineStateObject: Foliage - Voxelization Pass";
+		ER_RHI_PSOHandle mFoliageVoxelizationPassPSOName = "ER_RHI_GPUPipelineStateObject: Foliage - Voxelization Pass";
 
 		ER_RHI_GPUConstantBuffer<FoliageCBufferData::FoliageCB> mFoliageConstantBuffer;
 
@@ -162,9 +157,16 @@ namespace EveryRay_Core
 		ER_RHI_GPUTexture* mAlbedoTexture = nullptr;
 		ER_RHI_GPUTexture* mVoxelizationTexture = nullptr;
 
-		GPUFoliageInstanceData* mPatchesBufferGPU = nullptr;
-		CPUFoliageData* mPatchesBufferCPU = nullptr;
-		XMFLOAT4* mCurrentPositions = nullptr;
+		// patches are stored as structure-of-arrays and packed to "mPatchesBufferGPU" only when they change
+		std::vector<float> mPatchesPositionsX;
+		std::vector<float> mPatchesPositionsY;
+		std::vector<float> mPatchesPositionsZ;
+		std::vector<float> mPatchesScales;
+		std::vector<float> mPatchesRotations; // around Y, in radians
+		std::vector<GPUFoliageInstanceData> mPatchesBufferGPU;
+		std::vector<UINT8> mPatchesDirtyBlocks; // per FOLIAGE_PATCHES_PER_DIRTY_BLOCK patches: bitmask of instance buffer versions to upload
+		UINT8 mPatchesDirtyVersionsMask = 0; // union of all blocks' masks
+		XMFLOAT4* mCurrentPositions = nullptr; // input/output of the on-terrain placement
 
 		ER_RHI_GPUBuffer* mInputPositionsOnTerrainBuffer = nullptr; //input positions for on-terrain placement pass
 		ER_RHI_GPUBuffer* mOutputPositionsOnTerrainBuffer = nullptr; //output positions for on-terrain placement pass
@@ -177,8 +179,7 @@ namespace EveryRay_Core
 
 		ER_RenderableAABB* mDebugGizmoAABB = nullptr;
 		ER_AABB mAABB;
-		const float mAABBExtentY = 25.0f;
-		const float mAABBExtentXZ = 1.0f;
+		ER_AABB mBillboardAABB; // of the billboard model (local space)
 
 		std::string mName;
 		std::string mTextureName;
@@ -201,7 +202,7 @@ namespace EveryRay_Core
 		int mVerticesCount = 0;
 		bool mIsRotating = false;
 
-		float mWindStrength;
+		float mWindStrength = 0.0f;
 		float mWindFrequency;
 		float mWindGustDistance;
 
@@ -252,6 +253,8 @@ namespace EveryRay_Core
 
 		int mEditorSelectedFoliageZoneIndex = 0;
 
+		UINT64 mLastFrameUploadedBytes = 0;
+
 		float mMaxDistanceToCamera = 300.0f; // more than this => culled completely
 		float mDeltaDistanceToCamera = 30.0f; // from which distance we start dynamic culling (patches)
 
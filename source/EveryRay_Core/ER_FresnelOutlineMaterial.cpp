@@ -12,8 +12,8 @@
 
 namespace EveryRay_Core
 {
-	static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: FresnelOutlineMaterial";
-	static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: FresnelOutlineMaterial w/ Instancing";
+	static const ER_RHI_PSOHandle psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: FresnelOutlineMaterial";
+	static const ER_RHI_PSOHandle psoNameInstanced = "ER_RHI_GPUPipelineStateObject: FresnelOutlineMaterial w/ Instancing";
 
 	ER_FresnelOutlineMaterial::ER_FresnelOutlineMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced)
 		: ER_Material(game, entries, shaderFlags)
@@ -76,7 +76,7 @@ namespace EveryRay_Core
 		rhi->SetRootSignature(rs);
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		const std::string& psoName = aObj->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
+		const ER_RHI_PSOHandle& psoName = aObj->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
 		if (!rhi->IsPSOReady(psoName))
 		{
 			rhi->InitializePSO(psoName);
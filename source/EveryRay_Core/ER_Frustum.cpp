@@ -167,4 +167,120 @@ namespace EveryRay_Core
 
 		return (ray.PositionVector() + (ray.DirectionVector() * value));
 	}
+
+	UINT ER_Frustum::CullAABBs(const ER_AABBsSoA& bounds, UINT* outVisibleIndices, UINT8* outCulledFlags) const
+	{
+		return CullAABBs(mPlanes, 6, bounds, outVisibleIndices, outCulledFlags);
+	}
+
+	UINT ER_Frustum::CullAABBs(const XMFLOAT4* planes, UINT planesCount, const ER_AABBsSoA& bounds, UINT* outVisibleIndices, UINT8* outCulledFlags)
+	{
+		assert(outVisibleIndices || bounds.Count == 0);
+		assert(planes && planesCount <= ER_FRUSTUM_MAX_CULLING_PLANES);
+
+		// splat planes once (normals, their absolute values and constants)
+		XMVECTOR planeX[ER_FRUSTUM_MAX_CULLING_PLANES], planeY[ER_FRUSTUM_MAX_CULLING_PLANES], planeZ[ER_FRUSTUM_MAX_CULLING_PLANES],
+			planeAbsX[ER_FRUSTUM_MAX_CULLING_PLANES], planeAbsY[ER_FRUSTUM_MAX_CULLING_PLANES], planeAbsZ[ER_FRUSTUM_MAX_CULLING_PLANES], planeW[ER_FRUSTUM_MAX_CULLING_PLANES];
+		for (UINT planeID = 0; planeID < planesCount; planeID++)
+		{
+			planeX[planeID] = XMVectorReplicate(planes[planeID].x);
+			planeY[planeID] = XMVectorReplicate(planes[planeID].y);
+			planeZ[planeID] = XMVectorReplicate(planes[planeID].z);
+			planeW[planeID] = XMVectorReplicate(planes[planeID].w);
+			planeAbsX[planeID] = XMVectorAbs(planeX[planeID]);
+			planeAbsY[planeID] = XMVectorAbs(planeY[planeID]);
+			planeAbsZ[planeID] = XMVectorAbs(planeZ[planeID]);
+		}
+
+		const XMVECTOR zero = XMVectorZero();
+		const XMVECTOR allTrue = XMVectorTrueInt();
+		UINT visibleCount = 0;
+		for (UINT i = 0; i < bounds.Count; i += 4)
+		{
+			XMVECTOR centerX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.CentersX[i]));
+			XMVECTOR centerY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.CentersY[i]));
+			XMVECTOR centerZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.CentersZ[i]));
+			XMVECTOR extentX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.ExtentsX[i]));
+			XMVECTOR extentY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.ExtentsY[i]));
+			XMVECTOR extentZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&bounds.ExtentsZ[i]));
+
+			// box is culled if it is fully in front of any (outward facing) plane: dot(n, c) + w - dot(|n|, e) > 0
+			// (same as testing the "negative" vertex of the box like we did before)
+			XMVECTOR culled = XMVectorFalseInt();
+			for (UINT planeID = 0; planeID < planesCount; planeID++)
+			{
+				XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX[planeID], planeW[planeID]);
+				distance = XMVectorMultiplyAdd(centerY, planeY[planeID], distance);
+				distance = XMVectorMultiplyAdd(centerZ, planeZ[planeID], distance);
+
+				XMVECTOR radius = XMVectorMultiply(extentX, planeAbsX[planeID]);
+				radius = XMVectorMultiplyAdd(extentY, planeAbsY[planeID], radius);
+				radius = XMVectorMultiplyAdd(extentZ, planeAbsZ[planeID], radius);
+
+				culled = XMVectorOrInt(culled, XMVectorGreater(XMVectorSubtract(distance, radius), zero));
+				if (XMVector4EqualInt(culled, allTrue))
+					break; // all 4 boxes are already culled, skip remaining planes
+			}
+
+#if defined(_XM_SSE_INTRINSICS_)
+			int culledMask = _mm_movemask_ps(culled);
+#else
+			XMUINT4 culledLanes;
+			XMStoreUInt4(&culledLanes, culled);
+			int culledMask = (culledLanes.x ? 1 : 0) | (culledLanes.y ? 2 : 0) | (culledLanes.z ? 4 : 0) | (culledLanes.w ? 8 : 0);
+#endif
+
+			UINT lanesCount = std::min(4u, bounds.Count - i);
+			for (UINT lane = 0; lane < lanesCount; lane++)
+			{
+				bool isCulled = (culledMask >> lane) & 1;
+				if (outCulledFlags)
+					outCulledFlags[i + lane] = isCulled ? 1 : 0;
+				outVisibleIndices[visibleCount] = i + lane;
+				visibleCount += isCulled ? 0 : 1; // branchless compaction
+			}
+		}
+
+		return visibleCount;
+	}
+
+	bool ER_Frustum::IsAABBCulled(const XMFLOAT4* planes, UINT planesCount, const ER_AABB& aabb)
+	{
+		const XMFLOAT3 center = XMFLOAT3((aabb.first.x + aabb.second.x) * 0.5f, (aabb.first.y + aabb.second.y) * 0.5f, (aabb.first.z + aabb.second.z) * 0.5f);
+		const XMFLOAT3 extent = XMFLOAT3((aabb.second.x - aabb.first.x) * 0.5f, (aabb.second.y - aabb.first.y) * 0.5f, (aabb.second.z - aabb.first.z) * 0.5f);
+		for (UINT planeID = 0; planeID < planesCount; planeID++)
+		{
+			const XMFLOAT4& plane = planes[planeID];
+			const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			const float radius = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+			if (distance - radius > 0.0f)
+				return true;
+		}
+		return false;
+	}
+
+	void ER_AABBsSoA::Resize(UINT count)
+	{
+		Count = count;
+
+		// padding with empty boxes, so that the last group of 4 can always be loaded
+		UINT paddedCount = ER_BitmaskAlign(count, 4);
+		CentersX.resize(paddedCount, 0.0f);
+		CentersY.resize(paddedCount, 0.0f);
+		CentersZ.resize(paddedCount, 0.0f);
+		ExtentsX.resize(paddedCount, 0.0f);
+		ExtentsY.resize(paddedCount, 0.0f);
+		ExtentsZ.resize(paddedCount, 0.0f);
+	}
+
+	void ER_AABBsSoA::Set(UINT index, const ER_AABB& aabb)
+	{
+		assert(index < Count);
+		CentersX[index] = (aabb.first.x + aabb.second.x) * 0.5f;
+		CentersY[index] = (aabb.first.y + aabb.second.y) * 0.5f;
+		CentersZ[index] = (aabb.first.z + aabb.second.z) * 0.5f;
+		ExtentsX[index] = (aabb.second.x - aabb.first.x) * 0.5f;
+		ExtentsY[index] = (aabb.second.y - aabb.first.y) * 0.5f;
+		ExtentsZ[index] = (aabb.second.z - aabb.first.z) * 0.5f;
+	}
 }
\ No newline at end of file
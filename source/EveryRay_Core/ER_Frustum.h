@@ -3,6 +3,8 @@
 #include "Common.h"
 #include "ER_Ray.h"
 
+#define ER_FRUSTUM_MAX_CULLING_PLANES 16 // for culling against custom convex volumes (i.e., frustums extruded towards a light)
+
 namespace EveryRay_Core
 {
 	enum FrustumPlane
@@ -15,6 +17,22 @@ namespace EveryRay_Core
 		FrustumPlaneBottom
 	};
 
+	// Structure-of-arrays storage of AABBs (centers and half extents in separate arrays) for SIMD culling.
+	// Arrays are padded to a multiple of 4, so that they can be processed in groups of 4 boxes.
+	struct ER_AABBsSoA
+	{
+		std::vector<float> CentersX;
+		std::vector<float> CentersY;
+		std::vector<float> CentersZ;
+		std::vector<float> ExtentsX;
+		std::vector<float> ExtentsY;
+		std::vector<float> ExtentsZ;
+		UINT Count = 0;
+
+		void Resize(UINT count);
+		void Set(UINT index, const ER_AABB& aabb);
+	};
+
 	class ER_Frustum
 	{
 	public:
@@ -42,6 +60,14 @@ namespace EveryRay_Core
 		void SetMatrix(CXMMATRIX matrix);
 		void SetMatrix(const XMFLOAT4X4& matrix);
 
+		// Tests 4 boxes at a time against all 6 planes. Writes the indices of visible boxes (compacted) to "outVisibleIndices"
+		// (must fit "bounds.Count" elements) and returns their count. Optionally writes per-box culling flags (1 - culled).
+		UINT CullAABBs(const ER_AABBsSoA& bounds, UINT* outVisibleIndices, UINT8* outCulledFlags = nullptr) const;
+
+		// Same tests against any set of outward facing planes (up to ER_FRUSTUM_MAX_CULLING_PLANES)
+		static UINT CullAABBs(const XMFLOAT4* planes, UINT planesCount, const ER_AABBsSoA& bounds, UINT* outVisibleIndices, UINT8* outCulledFlags = nullptr);
+		static bool IsAABBCulled(const XMFLOAT4* planes, UINT planesCount, const ER_AABB& aabb);
+
 	private:
 		ER_Frustum();
 
@@ -12,8 +12,8 @@
 
 namespace EveryRay_Core
 {
-	static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: FurShellMaterial";
-	static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: FurShellMaterial w/ Instancing";
+	static const ER_RHI_PSOHandle psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: FurShellMaterial";
+	static const ER_RHI_PSOHandle psoNameInstanced = "ER_RHI_GPUPipelineStateObject: FurShellMaterial w/ Instancing";
 
 	ER_FurShellMaterial::ER_FurShellMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced, int currentIndex)
 		: ER_Material(game, entries, shaderFlags), mCurrentIndex(currentIndex)
@@ -72,7 +72,7 @@ namespace EveryRay_Core
 		rhi->SetRootSignature(rs);
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		const std::string& psoName =  aObj->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
+		const ER_RHI_PSOHandle& psoName =  aObj->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
 		if (!rhi->IsPSOReady(psoName))
 		{
 			rhi->InitializePSO(psoName);
@@ -105,12 +105,12 @@ namespace EveryRay_Core
 		rhi->SetConstantBuffers(ER_VERTEX, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, FUR_SHELL_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 		rhi->SetConstantBuffers(ER_PIXEL, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, FUR_SHELL_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 
-		std::vector<ER_RHI_GPUResource*> resources;
-		resources.push_back(aObj->GetTextureData(meshIndex).AlbedoMap);
-		resources.push_back(aObj->GetFurHeightTexture());
-		resources.push_back(aObj->GetFurMaskTexture(meshIndex));
+		ER_RHI_GPUResource* resources[3 + NUM_SHADOW_CASCADES];
+		resources[0] = aObj->GetTextureData(meshIndex).AlbedoMap;
+		resources[1] = aObj->GetFurHeightTexture();
+		resources[2] = aObj->GetFurMaskTexture(meshIndex);
 		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
-			resources.push_back(neededSystems.mShadowMapper->GetShadowTexture(i));
+			resources[3 + i] = neededSystems.mShadowMapper->GetShadowTexture(i);
 		rhi->SetShaderResources(ER_PIXEL, resources, 0, rs, FUR_SHELL_MAT_ROOT_DESCRIPTOR_TABLE_SRV_INDEX);
 
 		rhi->SetSamplers(ER_PIXEL, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP, ER_RHI_SAMPLER_STATE::ER_SHADOW_SS });
@@ -10,8 +10,8 @@
 
 namespace EveryRay_Core {
 
-	static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: GBufferMaterial";
-	static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: GBufferMaterial w/ Instancing";
+	static const ER_RHI_PSOHandle psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: GBufferMaterial";
+	static const ER_RHI_PSOHandle psoNameInstanced = "ER_RHI_GPUPipelineStateObject: GBufferMaterial w/ Instancing";
 
 	ER_GBuffer::ER_GBuffer(ER_Core& game, ER_Camera& camera, int width, int height):
 		ER_CoreComponent(game), mWidth(width), mHeight(height)
@@ -94,26 +94,84 @@ namespace EveryRay_Core {
 	void ER_GBuffer::Draw(const ER_Scene* scene)
 	{
 		auto rhi = GetCore()->GetRHI();
+		ER_Camera* camera = (ER_Camera*)(GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		assert(camera);
 
 		rhi->SetRootSignature(mRootSignature);
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		ER_MaterialSystems materialSystems;
+		// gather the draws (every mesh of every visible LOD) with their sort keys
+		mDrawItems.clear();
+		mRenderQueue.Clear();
+		const XMVECTOR cameraPosition = XMLoadFloat3(&camera->Position());
 		for (auto renderingObjectInfo = scene->objects.begin(); renderingObjectInfo != scene->objects.end(); renderingObjectInfo++)
 		{
 			ER_RenderingObject* renderingObject = renderingObjectInfo->second;
-			if (renderingObject->IsCulled())
+			if (!renderingObject->IsRendered() || renderingObject->IsCulled() || renderingObject->GetCurrentLODIndex() == -1)
 				continue;
 
-			const std::string& psoName = renderingObject->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
 			auto materialInfo = renderingObject->GetMaterials().find(ER_MaterialHelper::gbufferMaterialName);
-			if (materialInfo != renderingObject->GetMaterials().end())
+			if (materialInfo == renderingObject->GetMaterials().end())
+				continue;
+			ER_GBufferMaterial* material = static_cast<ER_GBufferMaterial*>(materialInfo->second);
+
+			const ER_AABB& aabb = renderingObject->GetGlobalAABB();
+			const XMVECTOR center = (XMLoadFloat3(&aabb.first) + XMLoadFloat3(&aabb.second)) * 0.5f;
+			const UINT depthBucket = ER_RenderQueue::GetDepthBucket(XMVectorGetX(XMVector3Length(center - cameraPosition)), camera->FarPlaneDistance());
+			const UINT psoKey = renderingObject->IsInstanced() ? 1 : 0;
+
+			// instanced objects draw all LODs (some instances might end up in one LOD, others in other LODs)
+			const int firstLOD = renderingObject->IsInstanced() ? 0 : renderingObject->GetCurrentLODIndex();
+			const int lastLOD = renderingObject->IsInstanced() ? renderingObject->GetLODCount() - 1 : firstLOD;
+			const UINT firstItem = static_cast<UINT>(mDrawItems.size());
+			for (int lod = firstLOD; lod <= lastLOD; lod++)
+			{
+				if (!renderingObject->IsLODDrawable(lod))
+					continue;
+
+				for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(lod); meshIndex++)
+				{
+					ER_RHI_GPUResource* textures[GBUFFER_MAT_MESH_TEXTURES_COUNT];
+					ER_GBufferMaterial::GetMeshTextures(renderingObject, meshIndex, textures);
+					UINT64 texturesHash = 0;
+					for (int i = 0; i < GBUFFER_MAT_MESH_TEXTURES_COUNT; i++)
+						texturesHash = texturesHash * 31 + reinterpret_cast<UINT64>(textures[i]);
+
+					const UINT64 key = ER_RenderQueue::MakeKey(psoKey,
+						ER_RenderQueue::HashToBits(texturesHash, ER_RENDER_QUEUE_KEY_MATERIAL_BITS),
+						ER_RenderQueue::HashToBits(reinterpret_cast<UINT64>(renderingObject->GetVertexBuffer(lod, meshIndex)), ER_RENDER_QUEUE_KEY_MESH_BITS),
+						depthBucket);
+					mRenderQueue.Add(key, static_cast<UINT>(mDrawItems.size()));
+					mDrawItems.push_back({ renderingObject, material, meshIndex, lod });
+				}
+			}
+
+			// view-projection is the same for all draws of the object, so it is uploaded once (not per mesh)
+			if (mDrawItems.size() > firstItem)
+				material->UpdateConstantBuffer();
+		}
+		mRenderQueue.Sort();
+
+		// submit in the sorted order, only setting the state that differs from the previous draw
+		mRenderQueueStats = ER_RenderQueueStats();
+		const ER_RHI_PSOHandle* currentPSO = nullptr;
+		ER_RenderingObject* currentObject = nullptr;
+		int currentLOD = -1;
+		ER_RHI_GPUResource* currentTextures[GBUFFER_MAT_MESH_TEXTURES_COUNT] = {};
+		ER_RHI_GPUBuffer* currentVertexBuffer = nullptr;
+
+		const ER_RenderQueueItem* queueItems = mRenderQueue.GetItems();
+		for (UINT i = 0; i < mRenderQueue.GetItemsCount(); i++)
+		{
+			const DrawItem& item = mDrawItems[queueItems[i].Index];
+
+			const ER_RHI_PSOHandle& psoName = item.Object->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
+			if (&psoName != currentPSO)
 			{
-				ER_GBufferMaterial* material = static_cast<ER_GBufferMaterial*>(materialInfo->second);
 				if (!rhi->IsPSOReady(psoName))
 				{
 					rhi->InitializePSO(psoName);
-					material->PrepareShaders();
+					item.Material->PrepareShaders();
 					rhi->SetRasterizerState(ER_NO_CULLING);
 					rhi->SetBlendState(ER_NO_BLEND);
 					rhi->SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE::ER_DEPTH_ONLY_WRITE_COMPARISON_LESS_EQUAL);
@@ -123,13 +181,46 @@ namespace EveryRay_Core {
 					rhi->FinalizePSO(psoName);
 				}
 				rhi->SetPSO(psoName);
-				for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
-				{
-					material->PrepareForRendering(materialSystems, renderingObject, meshIndex, mRootSignature);
-					renderingObject->Draw(ER_MaterialHelper::gbufferMaterialName, true, meshIndex);
-				}
+				currentPSO = &psoName;
+				mRenderQueueStats.PSOChangesCount++;
+
+				// PSO changes are rare (sorted by them first), so do not rely on the bindings surviving them
+				currentObject = nullptr;
+				currentLOD = -1;
+				std::fill(std::begin(currentTextures), std::end(currentTextures), nullptr);
+				currentVertexBuffer = nullptr;
+			}
+
+			if (item.Object != currentObject || item.LOD != currentLOD)
+			{
+				if (item.Object != currentObject)
+					item.Material->PrepareObjectForRendering(item.Object, mRootSignature);
+				item.Object->UpdateObjectConstantBuffers(item.LOD);
+				currentObject = item.Object;
+				currentLOD = item.LOD;
+				mRenderQueueStats.ConstantBufferChangesCount++;
 			}
+
+			ER_RHI_GPUResource* textures[GBUFFER_MAT_MESH_TEXTURES_COUNT];
+			ER_GBufferMaterial::GetMeshTextures(item.Object, item.MeshIndex, textures);
+			if (!std::equal(std::begin(textures), std::end(textures), std::begin(currentTextures)))
+			{
+				item.Material->PrepareMeshForRendering(item.Object, item.MeshIndex, mRootSignature);
+				std::copy(std::begin(textures), std::end(textures), std::begin(currentTextures));
+				mRenderQueueStats.TextureChangesCount++;
+			}
+
+			ER_RHI_GPUBuffer* vertexBuffer = item.Object->GetVertexBuffer(item.LOD, item.MeshIndex);
+			const bool setBuffers = vertexBuffer != currentVertexBuffer;
+			if (setBuffers)
+			{
+				currentVertexBuffer = vertexBuffer;
+				mRenderQueueStats.VertexBufferChangesCount++;
+			}
+
+			item.Object->DrawMesh(item.Material, item.MeshIndex, item.LOD, setBuffers);
+			mRenderQueueStats.DrawsCount++;
 		}
 		rhi->UnsetPSO();
 	}
-}
+}
\ No newline at end of file
@@ -3,11 +3,14 @@
 #include "Common.h"
 #include "ER_CoreComponent.h"
 #include "RHI/ER_RHI.h"
+#include "ER_RenderQueue.h"
 
 namespace EveryRay_Core
 {
 	class ER_Scene;
 	class ER_Camera;
+	class ER_RenderingObject;
+	class ER_GBufferMaterial;
 
 	class ER_GBuffer: public ER_CoreComponent
 	{
@@ -29,7 +32,16 @@ namespace EveryRay_Core
 		ER_RHI_GPUTexture* GetExtra2Buffer() { return mExtra2Buffer; } // [1 channel: "RenderingObjectFlags" bitmasks]
 		ER_RHI_GPUTexture* GetDepth() { return mDepthBuffer; }
 
+		const ER_RenderQueueStats& GetRenderQueueStats() const { return mRenderQueueStats; } // of the last Draw()
 	private:
+		struct DrawItem
+		{
+			ER_RenderingObject* Object;
+			ER_GBufferMaterial* Material;
+			int MeshIndex;
+			int LOD;
+		};
+
 		ER_RHI_GPURootSignature* mRootSignature = nullptr;
 
 		ER_RHI_GPUTexture* mDepthBuffer = nullptr;
@@ -39,6 +51,10 @@ namespace EveryRay_Core
 		ER_RHI_GPUTexture* mExtraBuffer = nullptr;
 		ER_RHI_GPUTexture* mExtra2Buffer = nullptr;
 
+		ER_RenderQueue mRenderQueue;
+		std::vector<DrawItem> mDrawItems; // referenced by the render queue's items
+		ER_RenderQueueStats mRenderQueueStats;
+
 		int mWidth;
 		int mHeight;
 	};
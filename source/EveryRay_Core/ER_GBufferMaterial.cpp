@@ -58,16 +58,27 @@ namespace EveryRay_Core
 	}
 
 	void ER_GBufferMaterial::PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs)
+	{
+		UpdateConstantBuffer();
+		PrepareObjectForRendering(aObj, rs);
+		PrepareMeshForRendering(aObj, meshIndex, rs);
+	}
+
+	void ER_GBufferMaterial::UpdateConstantBuffer()
 	{
 		auto rhi = ER_Material::GetCore()->GetRHI();
 		ER_Camera* camera = (ER_Camera*)(ER_Material::GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
-
-		assert(aObj);
 		assert(camera);
 
 		mConstantBuffer.Data.ViewProjection = XMMatrixTranspose(camera->ViewMatrix() * camera->ProjectionMatrix());
 		mConstantBuffer.ApplyChanges(rhi);
-		
+	}
+
+	void ER_GBufferMaterial::PrepareObjectForRendering(ER_RenderingObject* aObj, ER_RHI_GPURootSignature* rs)
+	{
+		auto rhi = ER_Material::GetCore()->GetRHI();
+		assert(aObj);
+
 		if (!rhi->IsRootConstantSupported())
 		{
 			rhi->SetConstantBuffers(ER_VERTEX, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer(), aObj->GetObjectsFakeRootConstantBuffer().Buffer() },
@@ -77,19 +88,31 @@ namespace EveryRay_Core
 			rhi->SetConstantBuffers(ER_VERTEX, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 
 		rhi->SetConstantBuffers(ER_PIXEL, { mConstantBuffer.Buffer() , aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
-
-		std::vector<ER_RHI_GPUResource*> resources;
-		resources.push_back(aObj->GetTextureData(meshIndex).AlbedoMap);	
-		resources.push_back(aObj->GetTextureData(meshIndex).NormalMap);
-		resources.push_back(aObj->GetTextureData(meshIndex).RoughnessMap);
-		resources.push_back(aObj->GetTextureData(meshIndex).MetallicMap);
-		resources.push_back(aObj->GetTextureData(meshIndex).HeightMap);	
-		resources.push_back(aObj->GetTextureData(meshIndex).ExtraMaskMap);
-		rhi->SetShaderResources(ER_PIXEL, resources, 0, rs, GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_PIXEL_SRV_INDEX);
 		rhi->SetSamplers(ER_PIXEL, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP }, 0, rs);
 
 		if (aObj->IsGPUIndirectlyRendered())
-			rhi->SetShaderResources(ER_VERTEX, { aObj->GetIndirectNewInstanceBuffer() }, static_cast<int>(resources.size()), rs, GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_VERTEX_SRV_INDEX);
+			rhi->SetShaderResources(ER_VERTEX, { aObj->GetIndirectNewInstanceBuffer() }, GBUFFER_MAT_MESH_TEXTURES_COUNT, rs, GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_VERTEX_SRV_INDEX);
+	}
+
+	void ER_GBufferMaterial::PrepareMeshForRendering(ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs)
+	{
+		auto rhi = ER_Material::GetCore()->GetRHI();
+		assert(aObj);
+
+		ER_RHI_GPUResource* resources[GBUFFER_MAT_MESH_TEXTURES_COUNT];
+		GetMeshTextures(aObj, meshIndex, resources);
+		rhi->SetShaderResources(ER_PIXEL, resources, 0, rs, GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_PIXEL_SRV_INDEX);
+	}
+
+	void ER_GBufferMaterial::GetMeshTextures(ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPUResource* aOutTextures[GBUFFER_MAT_MESH_TEXTURES_COUNT])
+	{
+		const TextureData& textures = aObj->GetTextureData(meshIndex);
+		aOutTextures[0] = textures.AlbedoMap;
+		aOutTextures[1] = textures.NormalMap;
+		aOutTextures[2] = textures.RoughnessMap;
+		aOutTextures[3] = textures.MetallicMap;
+		aOutTextures[4] = textures.HeightMap;
+		aOutTextures[5] = textures.ExtraMaskMap;
 	}
 
 	void ER_GBufferMaterial::PrepareResourcesForStandardMaterial(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs)
@@ -6,6 +6,8 @@
 #define GBUFFER_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
 #define GBUFFER_MAT_ROOT_CONSTANT_INDEX 3
 
+#define GBUFFER_MAT_MESH_TEXTURES_COUNT 6
+
 namespace EveryRay_Core
 {
 	class ER_Mesh;
@@ -24,6 +26,11 @@ namespace EveryRay_Core
 		~ER_GBufferMaterial();
 
 		void PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs);
+		// PrepareForRendering() split for sorted submission (see ER_GBuffer::Draw()): constant buffer upload (once per frame), per-object bindings, per-mesh textures
+		void UpdateConstantBuffer();
+		void PrepareObjectForRendering(ER_RenderingObject* aObj, ER_RHI_GPURootSignature* rs);
+		void PrepareMeshForRendering(ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs);
+		static void GetMeshTextures(ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPUResource* aOutTextures[GBUFFER_MAT_MESH_TEXTURES_COUNT]);
 		virtual void PrepareResourcesForStandardMaterial(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs) override;
 		virtual void SetRootConstantForMaterial(UINT a32BitConstant) override; // We use root constant for LOD index in this material
 		virtual void CreateVertexBuffer(const ER_Mesh& mesh, ER_RHI_GPUBuffer* vertexBuffer) override;
@@ -29,13 +29,14 @@ namespace EveryRay_Core
 
 	ER_GPUCuller::~ER_GPUCuller()
 	{
+		ReleaseBuffers();
+
 		DeleteObject(mIndirectCullingCS);
 		DeleteObject(mIndirectCullingRS);
 		DeleteObject(mIndirectCullingClearCS);
 		DeleteObject(mIndirectCullingClearRS);
 
-		mMeshConstantBuffer.Release();
-		mCameraConstantBuffer.Release();
+		mConstantBuffer.Release();
 	}
 
 	void ER_GPUCuller::Initialize()
@@ -51,9 +52,9 @@ namespace EveryRay_Core
 		mIndirectCullingRS = rhi->CreateRootSignature(3, 0);
 		if (mIndirectCullingRS)
 		{
-			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 2 });
-			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 1 });
-			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 2 });
+			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 3 });
+			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 3 });
+			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 1 });
 			mIndirectCullingRS->Finalize(rhi, "ER_RHI_GPURootSignature: Indirect Culling Main");
 		}
 
@@ -66,61 +67,217 @@ namespace EveryRay_Core
 		}
 
 		//cbuffers
-		mMeshConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler Mesh CB");
-		mCameraConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler Camera CB");
+		mConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler CB");
 	}
 
-	void ER_GPUCuller::ClearCounters(ER_Scene* aScene)
+	void ER_GPUCuller::ReleaseBuffers()
 	{
-		assert(aScene);
+		DeleteObject(mInstancesBuffer);
+		DeleteObject(mObjectsBuffer);
+		DeleteObject(mInstanceObjectsBuffer);
+		DeleteObject(mInstancesLODsBuffer);
+		DeleteObject(mCulledInstancesBuffer);
+		DeleteObject(mArgsBuffer);
+	}
+
+	// Rebuilds the tables if the set of indirectly rendered objects (that are ready) or their instance counts changed, which normally only happens while the scene is loading
+	void ER_GPUCuller::UpdateTable(ER_Scene* aScene)
+	{
+		mTempObjects.clear();
+		for (ER_SceneObject& obPair : aScene->objects)
+		{
+			ER_RenderingObject* aObj = obPair.second;
+			if (aObj->IsGPUIndirectlyRendered() && aObj->IsIndirectInstanceDataReady())
+				mTempObjects.push_back(aObj);
+		}
+		if (mTempObjects == mTableObjects)
+		{
+			bool isLayoutChanged = false;
+			for (UINT i = 0; i < mTable.GetObjectsCount() && !isLayoutChanged; i++)
+				isLayoutChanged = mTable.GetObjectDesc(i).InstancesCount != mTableObjects[i]->GetOriginalInstanceCount();
+			if (!isLayoutChanged)
+				return;
+		}
+		mTableObjects.swap(mTempObjects);
+
 		auto rhi = mCore.GetRHI();
+		if (mArgsBuffer)
+			rhi->WaitForGpuOnGraphicsFence(); // old buffers might still be used by the frames in flight
 
-		rhi->SetRootSignature(mIndirectCullingClearRS, true);
-		if (!rhi->IsPSOReady(mPSOClearName, true))
+		for (ER_RenderingObject* aObj : mTempObjects) // objects that were in the old tables
+			aObj->SetIndirectBuffers(nullptr, 0, nullptr, 0);
+		ReleaseBuffers();
+
+		mTable.Clear();
+		std::vector<ER_GPUCullingInstance> instances;
+		std::vector<UINT> indexCounts;
+		for (ER_RenderingObject* aObj : mTableObjects)
 		{
-			rhi->InitializePSO(mPSOClearName, true);
-			rhi->SetShader(mIndirectCullingClearCS);
-			rhi->SetRootSignatureToPSO(mPSOClearName, mIndirectCullingClearRS, true);
-			rhi->FinalizePSO(mPSOClearName, true);
+			instances.resize(aObj->GetOriginalInstanceCount());
+			aObj->GetIndirectInstanceData(instances.data(), 0, aObj->GetOriginalInstanceCount());
+			aObj->TakeIndirectDirtyInstanceRanges(mTempInstanceRanges); // the table has all instances already
+
+			// we dont support different meshes per LOD yet, so LODs are expected to have the meshes of LOD #0
+			const int lodCount = std::min(aObj->GetLODCount(), MAX_LOD);
+			const int meshCount = std::min(aObj->GetMeshCount(), MAX_MESH_COUNT);
+			indexCounts.assign(lodCount * meshCount, 0);
+			for (int lodI = 0; lodI < lodCount; lodI++)
+			{
+				for (int meshI = 0; meshI < std::min(meshCount, aObj->GetMeshCount(lodI)); meshI++)
+					indexCounts[meshCount * lodI + meshI] = aObj->GetIndexCount(lodI, meshI);
+			}
+			mTable.AddObject(instances.data(), static_cast<UINT>(instances.size()), lodCount, meshCount, indexCounts.data());
 		}
-		rhi->SetPSO(mPSOClearName, true);
+		UpdateObjectsLODs();
 
-		for (ER_SceneObject& obPair : aScene->objects)
+		if (mTable.GetInstancesCount() == 0)
+			return;
+
+		// (RHI takes non-const initial data, but does not modify it)
+		mInstancesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler Instances Buffer");
+		mInstancesBuffer->CreateGPUBufferResource(rhi, const_cast<ER_GPUCullingInstance*>(mTable.GetInstances().data()), mTable.GetInstancesCount(), sizeof(ER_GPUCullingInstance), true,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+
+		mObjectsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler Objects Buffer");
+		mObjectsBuffer->CreateGPUBufferResource(rhi, const_cast<ER_GPUCullingObject*>(mTable.GetObjects().data()), mTable.GetObjectsCount(), sizeof(ER_GPUCullingObject), true,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+
+		mInstanceObjectsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler Instance Objects Buffer");
+		mInstanceObjectsBuffer->CreateGPUBufferResource(rhi, const_cast<UINT*>(mTable.GetInstanceObjects().data()), mTable.GetInstancesCount(), sizeof(UINT), false,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_NONE, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
+
+		std::vector<UINT> instancesLODs(mTable.GetInstancesCount(), 0); // no LOD yet
+		mInstancesLODsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler Instances LOD Buffer");
+		mInstancesLODsBuffer->CreateGPUBufferResource(rhi, instancesLODs.data(), mTable.GetInstancesCount(), sizeof(UINT), false,
+			ER_BIND_UNORDERED_ACCESS, 0, ER_RESOURCE_MISC_NONE, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
+
+		mCulledInstancesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler Culled Instances Buffer");
+		mCulledInstancesBuffer->CreateGPUBufferResource(rhi, nullptr, mTable.GetCulledInstancesCount(), sizeof(ER_GPUCullingInstance), false,
+			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED, ER_FORMAT_UNKNOWN);
+
+		std::vector<UINT> args;
+		mTable.BuildInitialArgs(args);
+		mArgsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler Indirect Args Buffer");
+		mArgsBuffer->CreateGPUBufferResource(rhi, args.data(), mTable.GetArgsCount(), sizeof(UINT), false,
+			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_DRAWINDIRECT_ARGS, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
+
+		for (UINT i = 0; i < mTable.GetObjectsCount(); i++)
+			mTableObjects[i]->SetIndirectBuffers(mCulledInstancesBuffer, mTable.GetObjectDesc(i).CulledInstancesOffset, mArgsBuffer, mTable.GetArgsByteOffset(i));
+
+		std::string message = "[ER Logger][ER_GPUCuller] Built culling tables: " + std::to_string(mTable.GetObjectsCount()) + " objects, " +
+			std::to_string(mTable.GetInstancesCount()) + " instances\n";
+		ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+	}
+
+	// LOD parameters can be changed at any time (i.e., in the editor), so they are checked every frame but only uploaded when they changed
+	void ER_GPUCuller::UpdateObjectsLODs()
+	{
+		bool isChanged = false;
+		float lodScreenSizes[MAX_LOD];
+		for (UINT i = 0; i < mTable.GetObjectsCount(); i++)
 		{
-			ER_RenderingObject* aObj = obPair.second;
+			const ER_RenderingObject* aObj = mTableObjects[i];
+			for (int lodI = 0; lodI < MAX_LOD; lodI++)
+				lodScreenSizes[lodI] = aObj->GetLODScreenSize(lodI);
+			isChanged |= mTable.SetObjectLODs(i, aObj->GetLODBias() * ER_Utility::LODBias, lodScreenSizes);
+		}
 
-			if (!aObj->IsGPUIndirectlyRendered())
-				continue;
+		if (isChanged && mObjectsBuffer)
+		{
+			const std::vector<ER_GPUCullingObject>& objects = mTable.GetObjects();
+			mCore.GetRHI()->UpdateBuffer(mObjectsBuffer, const_cast<ER_GPUCullingObject*>(objects.data()), static_cast<int>(objects.size() * sizeof(ER_GPUCullingObject)), true);
+		}
+	}
 
-			if (!aObj->GetIndirectArgsBuffer() || !aObj->GetIndirectNewInstanceBuffer())
+	// Instances can be moved at any time (i.e., with the editor's gizmo or by on-terrain placement): objects mark the blocks of instances that they changed,
+	// only those are copied to the table and the ones that really changed are uploaded to the current version of the instances buffer (other versions get them when they become current)
+	void ER_GPUCuller::UpdateObjectsInstances()
+	{
+		auto rhi = mCore.GetRHI();
+
+		const UINT versionsCount = rhi->GetDynamicBufferVersionsCount();
+		assert(versionsCount <= ER_GPU_CULLING_MAX_BUFFER_VERSIONS);
+		const UINT8 allVersionsMask = static_cast<UINT8>((1u << versionsCount) - 1);
+
+		for (UINT i = 0; i < mTable.GetObjectsCount(); i++)
+		{
+			ER_RenderingObject* aObj = mTableObjects[i];
+			if (!aObj->TakeIndirectDirtyInstanceRanges(mTempInstanceRanges))
 				continue;
 
-			rhi->ClearUAV(aObj->GetIndirectNewInstanceBuffer(), 0);
+			const UINT instancesCount = mTable.GetObjectDesc(i).InstancesCount;
+			for (const std::pair<UINT, UINT>& range : mTempInstanceRanges)
+			{
+				if (range.first >= instancesCount)
+					break;
+				const UINT count = std::min(range.second, instancesCount - range.first);
+				mTempInstances.resize(count);
+				aObj->GetIndirectInstanceData(mTempInstances.data(), range.first, count);
+				mTable.SetObjectInstances(i, range.first, mTempInstances.data(), count, allVersionsMask);
+			}
+		}
+
+		mTable.TakeDirtyInstanceRanges(rhi->GetDynamicBufferCurrentVersion(), mTempInstanceRanges);
+		if (mTempInstanceRanges.empty() || !mInstancesBuffer)
+			return;
+
+		mTempBufferRanges.resize(mTempInstanceRanges.size());
+		for (size_t i = 0; i < mTempInstanceRanges.size(); i++)
+		{
+			mTempBufferRanges[i].Offset = mTempInstanceRanges[i].first * sizeof(ER_GPUCullingInstance);
+			mTempBufferRanges[i].Size = mTempInstanceRanges[i].second * sizeof(ER_GPUCullingInstance);
+		}
 
-			rhi->SetUnorderedAccessResources(ER_COMPUTE,
-				{
-					aObj->GetIndirectArgsBuffer()
-				}, 0, mIndirectCullingRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		const std::vector<ER_GPUCullingInstance>& instances = mTable.GetInstances();
+		rhi->UpdateBufferRanges(mInstancesBuffer, const_cast<ER_GPUCullingInstance*>(instances.data()), static_cast<int>(instances.size() * sizeof(ER_GPUCullingInstance)),
+			ER_RHI_ArrayView<ER_RHI_BufferRange>(mTempBufferRanges));
+	}
 
-			UpdateMeshesConstantBuffer(aObj);
-			rhi->SetConstantBuffers(ER_COMPUTE, { mMeshConstantBuffer.Buffer() }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+	void ER_GPUCuller::ClearCounters()
+	{
+		auto rhi = mCore.GetRHI();
 
-			rhi->Dispatch(1u, 1u, 1u);
+		rhi->SetRootSignature(mIndirectCullingClearRS, true);
+		if (!rhi->IsPSOReady(mPSOClearName, true))
+		{
+			rhi->InitializePSO(mPSOClearName, true);
+			rhi->SetShader(mIndirectCullingClearCS);
+			rhi->SetRootSignatureToPSO(mPSOClearName, mIndirectCullingClearRS, true);
+			rhi->FinalizePSO(mPSOClearName, true);
 		}
+		rhi->SetPSO(mPSOClearName, true);
+
+		rhi->SetUnorderedAccessResources(ER_COMPUTE, { mArgsBuffer }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		rhi->SetConstantBuffers(ER_COMPUTE, { mConstantBuffer.Buffer() }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+		rhi->Dispatch(ER_DivideByMultiple(mTable.GetDrawsCount(), 64u), 1u, 1u);
+		mDispatchesCount++;
+
 		rhi->UnsetPSO();
 		rhi->UnbindResourcesFromShader(ER_COMPUTE);
 	}
 
-
 	void ER_GPUCuller::PerformCull(ER_Scene* aScene)
 	{
 		assert(aScene);
 
-		ClearCounters(aScene);
-
-		mIndirectCullsCounterPerFrame = 0;
+		mDispatchesCount = 0;
 		auto rhi = mCore.GetRHI();
 
+		UpdateTable(aScene);
+		if (mTable.GetInstancesCount() == 0)
+			return;
+		UpdateObjectsLODs();
+		UpdateObjectsInstances();
+
+		for (int i = 0; i < 6; ++i)
+			mConstantBuffer.Data.FrustumPlanes[i] = mCamera.GetFrustum().Planes()[i];
+		mConstantBuffer.Data.LODParams = XMFLOAT4(mCamera.ProjectionMatrix4X4()._22, ER_Utility::LODHysteresis, 0.0f, 0.0f);
+		mConstantBuffer.Data.CameraPos = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, 1.0f);
+		mConstantBuffer.Data.Counts = XMUINT4(mTable.GetInstancesCount(), mTable.GetDrawsCount(), 0, 0);
+		mConstantBuffer.ApplyChanges(rhi);
+
+		ClearCounters();
+
 		rhi->SetRootSignature(mIndirectCullingRS, true);
 		if (!rhi->IsPSOReady(mPSOName, true))
 		{
@@ -131,68 +288,15 @@ namespace EveryRay_Core
 		}
 		rhi->SetPSO(mPSOName, true);
 
-		for (int i = 0; i < 6; ++i)
-			mCameraConstantBuffer.Data.FrustumPlanes[i] = mCamera.GetFrustum().Planes()[i];
-		mCameraConstantBuffer.Data.LodCameraDistances = XMFLOAT4(
-			ER_Utility::DistancesLOD[0] * ER_Utility::DistancesLOD[0], 
-			ER_Utility::DistancesLOD[1] * ER_Utility::DistancesLOD[1],
-			ER_Utility::DistancesLOD[2] * ER_Utility::DistancesLOD[2], 0.0f);
-		mCameraConstantBuffer.Data.CameraPos = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, 1.0f);
-		mCameraConstantBuffer.ApplyChanges(rhi);
-
-		for (ER_SceneObject& obPair : aScene->objects)
-		{
-			ER_RenderingObject* aObj = obPair.second;
-
-			if (!aObj->IsGPUIndirectlyRendered())
-				continue;
-
-			if (!aObj->GetIndirectArgsBuffer() || !aObj->GetIndirectNewInstanceBuffer() || !aObj->GetIndirectOriginalInstanceBuffer())
-				continue;
-
-			rhi->SetShaderResources(ER_COMPUTE, { aObj->GetIndirectOriginalInstanceBuffer() }, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
-			
-			rhi->SetUnorderedAccessResources(ER_COMPUTE,
-				{ 
-					aObj->GetIndirectNewInstanceBuffer(),
-					aObj->GetIndirectArgsBuffer()
-				}, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		rhi->SetShaderResources(ER_COMPUTE, { mInstancesBuffer, mObjectsBuffer, mInstanceObjectsBuffer }, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+		rhi->SetUnorderedAccessResources(ER_COMPUTE, { mCulledInstancesBuffer, mArgsBuffer, mInstancesLODsBuffer }, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		rhi->SetConstantBuffers(ER_COMPUTE, { mConstantBuffer.Buffer() }, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
 
-			UpdateMeshesConstantBuffer(aObj);
-			rhi->SetConstantBuffers(ER_COMPUTE, { mMeshConstantBuffer.Buffer(), mCameraConstantBuffer.Buffer() },
-				0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+		assert(("ER_GPUCuller: too many instances for one dispatch", ER_DivideByMultiple(mTable.GetInstancesCount(), 64u) <= 65535u));
+		rhi->Dispatch(ER_DivideByMultiple(mTable.GetInstancesCount(), 64u), 1u, 1u);
+		mDispatchesCount++;
 
-			rhi->Dispatch(ER_DivideByMultiple(static_cast<UINT>(aObj->GetInstanceCount()), 64u), 1u, 1u);
-			mIndirectCullsCounterPerFrame++;
-		}
 		rhi->UnsetPSO();
 		rhi->UnbindResourcesFromShader(ER_COMPUTE);
 	}
-
-	void ER_GPUCuller::UpdateMeshesConstantBuffer(const ER_RenderingObject* aObj)
-	{
-		auto rhi = mCore.GetRHI();
-		const int totalObjLodCount = aObj->GetLODCount();
-
-		int offset, indexCount, lastAvailableLod = 0;
-		for (int lodI = 0; lodI < MAX_LOD; lodI++)
-		{
-			for (int meshI = 0; meshI < MAX_MESH_COUNT; meshI++)
-			{
-				offset = MAX_MESH_COUNT * lodI + meshI;
-				if (lodI < totalObjLodCount)
-					indexCount = (meshI < aObj->GetMeshCount(/*TODO ideally from lodI but we dont support meshes per LOD yet*/)) ? aObj->GetIndexCount(lodI, meshI) : INT_MAX;
-				else
-					indexCount = INT_MAX;
-					// Uncomment this if you want to fallback into previous LOD (you have to adjust ER_RenderingObject::Draw())
-					// indexCount = (meshI < aObj->GetMeshCount(/*TODO ideally from lastAvailableLod but we dont support meshes per LOD yet*/)) ? aObj->GetIndexCount(lastAvailableLod, meshI) : INT_MAX;
-				
-				mMeshConstantBuffer.Data.IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[offset] = XMINT4(indexCount, 0, 0, 0);
-			}
-			if (lodI < totalObjLodCount)
-				lastAvailableLod = lodI;
-		}
-		mMeshConstantBuffer.Data.OriginalInstancesCount = aObj->GetInstanceCount();
-		mMeshConstantBuffer.ApplyChanges(rhi);
-	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Common.h"
 #include "ER_CoreComponent.h"
 #include "RHI/ER_RHI.h"
+#include "ER_GPUCullingTable.h"
 
 namespace EveryRay_Core
 {
@@ -11,20 +12,19 @@ namespace EveryRay_Core
 
 	namespace IndirectCullingCBufferData
 	{
-		struct ER_ALIGN_GPU_BUFFER MeshConstants
-		{
-			XMINT4 IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[MAX_LOD * MAX_MESH_COUNT];
-			UINT OriginalInstancesCount;
-		};
-
-		struct ER_ALIGN_GPU_BUFFER CameraConstants
+		struct ER_ALIGN_GPU_BUFFER CullingConstants
 		{
 			XMFLOAT4 FrustumPlanes[6];
-			XMFLOAT4 LodCameraDistances;
+			XMFLOAT4 LODParams; // x - projection scale ([1][1] of the projection matrix), y - LOD hysteresis
 			XMFLOAT4 CameraPos;
+			XMUINT4 Counts; // x - instances count, y - draws count
 		};
 	}
 
+	// GPU culling (and LOD selection) of the instances of all indirectly rendered objects:
+	// objects are packed into shared tables (see ER_GPUCullingTable), so every frame there is one dispatch to clear the counters and one to cull,
+	// no matter how many objects there are. Tables are rebuilt when the set of indirectly rendered objects changes (i.e., when they are loaded),
+	// instances that moved after that (i.e., with the editor's gizmo or on-terrain placement) are uploaded in dirty blocks.
 	class ER_GPUCuller : public ER_CoreComponent
 	{
 	public:
@@ -33,22 +33,41 @@ namespace EveryRay_Core
 
 		void Initialize();
 		void PerformCull(ER_Scene* aScene);
-		void ClearCounters(ER_Scene* aScene);
 
+		const ER_GPUCullingTable& GetTable() const { return mTable; }
+		UINT GetDispatchesCount() const { return mDispatchesCount; } // in the last PerformCull()
 	private:
-		void UpdateMeshesConstantBuffer(const ER_RenderingObject* aObj);
+		void UpdateTable(ER_Scene* aScene);
+		void UpdateObjectsLODs();
+		void UpdateObjectsInstances();
+		void ClearCounters();
+		void ReleaseBuffers();
+
 		ER_Core& mCore;
 		ER_Camera& mCamera;
 
 		ER_RHI_GPUShader* mIndirectCullingCS = nullptr;
 		ER_RHI_GPUShader* mIndirectCullingClearCS = nullptr;
-		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::MeshConstants> mMeshConstantBuffer;
-		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::CameraConstants> mCameraConstantBuffer;
+		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::CullingConstants> mConstantBuffer;
 		ER_RHI_GPURootSignature* mIndirectCullingRS = nullptr;
 		ER_RHI_GPURootSignature* mIndirectCullingClearRS = nullptr;
-		const std::string mPSOName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass";
-		const std::string mPSOClearName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass Clear";
-		
-		int mIndirectCullsCounterPerFrame = 0;
+		const ER_RHI_PSOHandle mPSOName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass";
+		const ER_RHI_PSOHandle mPSOClearName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass Clear";
+
+		ER_GPUCullingTable mTable;
+		std::vector<ER_RenderingObject*> mTableObjects; // in the order of the table's objects
+		std::vector<ER_RenderingObject*> mTempObjects;
+		std::vector<ER_GPUCullingInstance> mTempInstances;
+		std::vector<std::pair<UINT, UINT>> mTempInstanceRanges;
+		std::vector<ER_RHI_BufferRange> mTempBufferRanges;
+
+		ER_RHI_GPUBuffer* mInstancesBuffer = nullptr; // original instances of all objects (dynamic: instances can be moved)
+		ER_RHI_GPUBuffer* mObjectsBuffer = nullptr; // object descriptors (dynamic: LOD parameters can change)
+		ER_RHI_GPUBuffer* mInstanceObjectsBuffer = nullptr; // object index of every instance
+		ER_RHI_GPUBuffer* mInstancesLODsBuffer = nullptr; // LOD + 1 of every instance in the last frame (0 - not rendered), for hysteresis in CS
+		ER_RHI_GPUBuffer* mCulledInstancesBuffer = nullptr; // culled instances of all LODs of all objects (read by the passes that draw the objects)
+		ER_RHI_GPUBuffer* mArgsBuffer = nullptr; // draw indexed instanced indirect args of all objects
+
+		UINT mDispatchesCount = 0;
 	};
 }
\ No newline at end of file
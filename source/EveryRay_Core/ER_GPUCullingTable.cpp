@@ -0,0 +1,127 @@
+#include "stdafx.h"
+
+#include "ER_GPUCullingTable.h"
+
+namespace EveryRay_Core
+{
+	void ER_GPUCullingTable::Clear()
+	{
+		mObjects.clear();
+		mInstances.clear();
+		mInstanceObjects.clear();
+		mIndexCounts.clear();
+		mDirtyInstanceBlocks.clear();
+		mDirtyVersionsMask = 0;
+		mCulledInstancesCount = 0;
+	}
+
+	UINT ER_GPUCullingTable::AddObject(const ER_GPUCullingInstance* aInstances, UINT aInstancesCount, UINT aLODCount, UINT aMeshCount, const UINT* aIndexCounts)
+	{
+		assert(aInstances || aInstancesCount == 0);
+		assert(aMeshCount <= MAX_MESH_COUNT);
+
+		const UINT objectIndex = GetObjectsCount();
+
+		ER_GPUCullingObject object = {};
+		object.FirstInstance = GetInstancesCount();
+		object.InstancesCount = aInstancesCount;
+		object.CulledInstancesOffset = mCulledInstancesCount;
+		object.ArgsOffset = GetArgsCount();
+		object.LODCount = std::min(aLODCount, static_cast<UINT>(MAX_LOD));
+		object.MeshCount = aMeshCount;
+		object.LODBias = 1.0f;
+		mObjects.push_back(object);
+
+		mInstances.insert(mInstances.end(), aInstances, aInstances + aInstancesCount);
+		mInstanceObjects.insert(mInstanceObjects.end(), aInstancesCount, objectIndex);
+		mCulledInstancesCount += aInstancesCount * MAX_LOD;
+		mDirtyInstanceBlocks.resize(ER_DivideByMultiple(GetInstancesCount(), static_cast<UINT>(ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK)), 0); // new instances are in the initial data of the buffer
+
+		mIndexCounts.resize(mIndexCounts.size() + ER_GPU_CULLING_DRAWS_PER_OBJECT, 0);
+		UINT* indexCounts = &mIndexCounts[objectIndex * ER_GPU_CULLING_DRAWS_PER_OBJECT];
+		for (UINT lod = 0; lod < object.LODCount; lod++)
+		{
+			for (UINT mesh = 0; mesh < aMeshCount; mesh++)
+				indexCounts[MAX_MESH_COUNT * lod + mesh] = aIndexCounts[aMeshCount * lod + mesh];
+		}
+
+		return objectIndex;
+	}
+
+	bool ER_GPUCullingTable::SetObjectLODs(UINT aObject, float aLODBias, const float* aLODScreenSizes)
+	{
+		static_assert(MAX_LOD <= 4, "LOD thresholds are passed to the shader in one float4");
+		assert(aObject < GetObjectsCount());
+
+		float lodScreenSizes[4] = {};
+		for (int lod = 0; lod < MAX_LOD; lod++)
+			lodScreenSizes[lod] = aLODScreenSizes[lod];
+
+		ER_GPUCullingObject& object = mObjects[aObject];
+		const XMFLOAT4 screenSizes(lodScreenSizes[0], lodScreenSizes[1], lodScreenSizes[2], lodScreenSizes[3]);
+		if (object.LODBias == aLODBias && memcmp(&object.LODScreenSizes, &screenSizes, sizeof(XMFLOAT4)) == 0)
+			return false;
+
+		object.LODBias = aLODBias;
+		object.LODScreenSizes = screenSizes;
+		return true;
+	}
+
+	bool ER_GPUCullingTable::SetObjectInstances(UINT aObject, UINT aFirstInstance, const ER_GPUCullingInstance* aInstances, UINT aInstancesCount, UINT8 aVersionsMask)
+	{
+		assert(aObject < GetObjectsCount());
+
+		const ER_GPUCullingObject& object = mObjects[aObject];
+		assert(aFirstInstance + aInstancesCount <= object.InstancesCount);
+		assert(aInstances || aInstancesCount == 0);
+
+		bool isChanged = false;
+		for (UINT i = 0; i < aInstancesCount; i++)
+		{
+			const UINT tableInstance = object.FirstInstance + aFirstInstance + i;
+			ER_GPUCullingInstance& instance = mInstances[tableInstance];
+			if (memcmp(&instance, &aInstances[i], sizeof(ER_GPUCullingInstance)) == 0)
+				continue;
+
+			instance = aInstances[i];
+			mDirtyInstanceBlocks[tableInstance / ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK] |= aVersionsMask;
+			isChanged = true;
+		}
+
+		if (isChanged)
+			mDirtyVersionsMask |= aVersionsMask;
+		return isChanged;
+	}
+
+	void ER_GPUCullingTable::TakeDirtyInstanceRanges(UINT aVersion, std::vector<std::pair<UINT, UINT>>& aOutRanges)
+	{
+		assert(aVersion < ER_GPU_CULLING_MAX_BUFFER_VERSIONS);
+
+		aOutRanges.clear();
+		const UINT8 versionMask = static_cast<UINT8>(1u << aVersion);
+		if (!(mDirtyVersionsMask & versionMask))
+			return;
+		mDirtyVersionsMask &= ~versionMask;
+
+		for (UINT block = 0; block < static_cast<UINT>(mDirtyInstanceBlocks.size()); block++)
+		{
+			if (!(mDirtyInstanceBlocks[block] & versionMask))
+				continue;
+			mDirtyInstanceBlocks[block] &= ~versionMask;
+
+			const UINT start = block * ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK;
+			const UINT end = std::min(start + ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK, GetInstancesCount());
+			if (!aOutRanges.empty() && aOutRanges.back().first + aOutRanges.back().second == start)
+				aOutRanges.back().second += end - start;
+			else
+				aOutRanges.push_back(std::make_pair(start, end - start));
+		}
+	}
+
+	void ER_GPUCullingTable::BuildInitialArgs(std::vector<UINT>& aOutArgs) const
+	{
+		aOutArgs.assign(GetArgsCount(), 0);
+		for (UINT draw = 0; draw < GetDrawsCount(); draw++)
+			aOutArgs[draw * ER_GPU_CULLING_DRAW_ARGS_COUNT] = mIndexCounts[draw]; // IndexCountPerInstance (other args are 0)
+	}
+}
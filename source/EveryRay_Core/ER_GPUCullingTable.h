@@ -0,0 +1,78 @@
+#pragma once
+#include "Common.h"
+
+#define ER_GPU_CULLING_DRAW_ARGS_COUNT 5 // of DrawIndexedInstanced()
+#define ER_GPU_CULLING_DRAWS_PER_OBJECT (MAX_LOD * MAX_MESH_COUNT) // draw args of an object are addressed with (MAX_MESH_COUNT * lod + mesh)
+#define ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK 64 // granularity of the instance uploads after the table is built
+#define ER_GPU_CULLING_MAX_BUFFER_VERSIONS 8 // one bit per version of the GPU buffer in the dirty blocks
+
+namespace EveryRay_Core
+{
+	// Layouts of the GPU buffers of the batched culling pass (should match IndirectCulling.hlsli)
+	struct ER_GPUCullingInstance
+	{
+		XMFLOAT4X4 World;
+		XMFLOAT4 AABBMin;
+		XMFLOAT4 AABBMax;
+	};
+
+	struct ER_GPUCullingObject
+	{
+		UINT FirstInstance; // in the instance table
+		UINT InstancesCount;
+		UINT CulledInstancesOffset; // in the culled instances buffer ("InstancesCount" slots per LOD)
+		UINT ArgsOffset; // in the args buffer (in UINTs)
+		UINT LODCount;
+		UINT MeshCount;
+		float LODBias; // of the object multiplied by the global one
+		UINT Padding;
+		XMFLOAT4 LODScreenSizes; // see ER_RenderingObject::SelectLOD()
+	};
+	static_assert(sizeof(ER_GPUCullingObject) % 16 == 0, "ER_GPUCullingObject is read as a structured buffer");
+
+	// CPU side of ER_GPUCuller's batched culling (no RHI): all indirectly rendered objects are packed into
+	// - one instance table (original instances of all objects one after another) and a lookup of the object of every instance,
+	// - one object descriptor table (ranges in the other buffers, LOD parameters),
+	// - one draw args buffer (ER_GPU_CULLING_DRAWS_PER_OBJECT draws per object) and one culled instances buffer,
+	// so that the culling and the clear of the counters are one dispatch each, no matter how many objects there are.
+	class ER_GPUCullingTable
+	{
+	public:
+		ER_GPUCullingTable() {}
+		~ER_GPUCullingTable() {}
+
+		void Clear();
+		// "aIndexCounts" are per LOD, per mesh ("aLODCount * aMeshCount", LOD-major, 0 for missing meshes), LODs above MAX_LOD are ignored; returns the index of the object
+		UINT AddObject(const ER_GPUCullingInstance* aInstances, UINT aInstancesCount, UINT aLODCount, UINT aMeshCount, const UINT* aIndexCounts);
+		// "aLODScreenSizes" has MAX_LOD values; returns true if the descriptor changed (and has to be uploaded again)
+		bool SetObjectLODs(UINT aObject, float aLODBias, const float* aLODScreenSizes);
+		// "aInstances" are "aInstancesCount" instances of the object from "aFirstInstance" (in the object); blocks that changed are marked dirty in all versions of "aVersionsMask"; returns true if anything changed
+		bool SetObjectInstances(UINT aObject, UINT aFirstInstance, const ER_GPUCullingInstance* aInstances, UINT aInstancesCount, UINT8 aVersionsMask);
+		// ranges of the dirty blocks of the version (first instance, instances count; consecutive blocks are merged), the blocks are not dirty in this version anymore
+		void TakeDirtyInstanceRanges(UINT aVersion, std::vector<std::pair<UINT, UINT>>& aOutRanges);
+
+		// args with the index counts and no instances (instance counts are cleared and counted on GPU every frame)
+		void BuildInitialArgs(std::vector<UINT>& aOutArgs) const;
+
+		UINT GetObjectsCount() const { return static_cast<UINT>(mObjects.size()); }
+		UINT GetInstancesCount() const { return static_cast<UINT>(mInstances.size()); }
+		UINT GetDrawsCount() const { return GetObjectsCount() * ER_GPU_CULLING_DRAWS_PER_OBJECT; }
+		UINT GetArgsCount() const { return GetDrawsCount() * ER_GPU_CULLING_DRAW_ARGS_COUNT; }
+		UINT GetCulledInstancesCount() const { return mCulledInstancesCount; }
+
+		const ER_GPUCullingObject& GetObjectDesc(UINT aObject) const { return mObjects[aObject]; }
+		UINT GetArgsByteOffset(UINT aObject) const { return mObjects[aObject].ArgsOffset * sizeof(UINT); }
+
+		const std::vector<ER_GPUCullingObject>& GetObjects() const { return mObjects; }
+		const std::vector<ER_GPUCullingInstance>& GetInstances() const { return mInstances; }
+		const std::vector<UINT>& GetInstanceObjects() const { return mInstanceObjects; }
+	private:
+		std::vector<ER_GPUCullingObject> mObjects;
+		std::vector<ER_GPUCullingInstance> mInstances;
+		std::vector<UINT> mInstanceObjects; // object index of every instance
+		std::vector<UINT> mIndexCounts; // ER_GPU_CULLING_DRAWS_PER_OBJECT per object
+		std::vector<UINT8> mDirtyInstanceBlocks; // bit per version of the GPU buffer that has not received the block yet
+		UINT8 mDirtyVersionsMask = 0; // versions with at least one dirty block
+		UINT mCulledInstancesCount = 0;
+	};
+}
@@ -1,62 +1,240 @@
 // Simple "generic" event system in EveryRay Rendering Engine
 // works with named/anonymous listeners
+//
+// Listeners live in slots that are referenced by handles (index + generation), so removed handles never call a wrong listener.
+// Dispatch iterates the slots in place (no copies of the listeners, no allocations):
+// - listeners added during a dispatch are stored aside and only called from the next dispatch
+// - listeners removed during a dispatch are not called anymore, but are only destroyed after the dispatch (they can remove themselves)
+// Named listeners are found with a linear search, so for hot paths look them up once with FindListener() and use the handle.
 
 #pragma once
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <functional>
+#include <utility>
+#include <cassert>
 #include "ER_CoreException.h"
 
+#define ER_GENERIC_EVENT_RESERVED_LISTENERS 4 // most events have a few listeners, so slots are only allocated once
+
+struct ER_EventListenerHandle
+{
+	unsigned int Index = 0xFFFFFFFF;
+	unsigned int Generation = 0;
+
+	bool IsValid() const { return Index != 0xFFFFFFFF; }
+};
+
 template<typename T>
 class ER_GenericEvent
 {
 public:
-	void AddListener(const std::string& pName, T pEventHandlerMethod)
+	ER_GenericEvent() { mSlots.reserve(ER_GENERIC_EVENT_RESERVED_LISTENERS); }
+	~ER_GenericEvent() { assert(mDispatchDepth == 0); }
+
+	// does nothing if a listener with the same name already exists (returns its handle)
+	ER_EventListenerHandle AddListener(const std::string& pName, T pEventHandlerMethod)
 	{
-		if (mNamedListeners.find(pName) == mNamedListeners.end())
-			mNamedListeners[pName] = pEventHandlerMethod;
+		ER_EventListenerHandle handle = FindListener(pName);
+		if (handle.IsValid())
+			return handle;
+		return AddSlot(pName, std::move(pEventHandlerMethod));
 	}
-	void AddListener(T pEventHandlerMethod)
+	ER_EventListenerHandle AddListener(T pEventHandlerMethod)
 	{
-		mAnonymousListeners.push_back(pEventHandlerMethod);
+		return AddSlot(std::string(), std::move(pEventHandlerMethod));
 	}
 	void RemoveListener(const std::string& pName)
 	{
-		if (mNamedListeners.find(pName) != mNamedListeners.end())
-			mNamedListeners.erase(pName);
+		RemoveListener(FindListener(pName));
+	}
+	void RemoveListener(ER_EventListenerHandle pHandle)
+	{
+		Slot* slot = GetSlot(pHandle);
+		if (!slot)
+			return;
+
+		slot->IsAlive = false;
+		if (mDispatchDepth > 0)
+			mHasRemovedSlots = true; // the listener can be executing right now
+		else
+			ReleaseSlot(pHandle.Index);
 	}
 	void RemoveAllListeners()
 	{
-		mNamedListeners.clear();
-		mAnonymousListeners.clear();
+		for (unsigned int i = 0; i < static_cast<unsigned int>(mSlots.size()); i++)
+			RemoveListener(ER_EventListenerHandle{ i, mSlots[i].Generation });
+		for (Slot& slot : mPendingSlots)
+			slot.IsAlive = false;
 	}
 
-	std::vector<T> GetListeners()
+	ER_EventListenerHandle FindListener(const std::string& pName) const
 	{
-		std::vector<T> allListeners;
-		for (auto listener : mNamedListeners)
+		if (pName.empty())
+			return ER_EventListenerHandle();
+
+		for (unsigned int i = 0; i < static_cast<unsigned int>(mSlots.size()); i++)
 		{
-			allListeners.push_back(listener.second);
+			if (mSlots[i].IsAlive && mSlots[i].Name == pName)
+				return ER_EventListenerHandle{ i, mSlots[i].Generation };
 		}
-		allListeners.insert(allListeners.end(), mAnonymousListeners.begin(), mAnonymousListeners.end());
-		return allListeners;
+		for (unsigned int i = 0; i < static_cast<unsigned int>(mPendingSlots.size()); i++)
+		{
+			if (mPendingSlots[i].IsAlive && mPendingSlots[i].Name == pName)
+				return ER_EventListenerHandle{ static_cast<unsigned int>(mSlots.size()) + i, mPendingSlots[i].Generation };
+		}
+		return ER_EventListenerHandle();
 	}
+	bool HasListener(ER_EventListenerHandle pHandle) const { return GetSlot(pHandle) != nullptr; }
 
-	T GetListener(const std::string& pName)
+	// throws if there is no such listener
+	const T& GetListener(const std::string& pName) const
 	{
-		auto it = mNamedListeners.find(pName);
-		if (it != mNamedListeners.end())
-			return it->second;
-		else
+		const Slot* slot = GetSlot(FindListener(pName));
+		if (!slot)
 		{
 			std::string msg = "Listener was not found: " + pName;
 			throw EveryRay_Core::ER_CoreException(msg.c_str());
 		}
+		return slot->Callback;
+	}
+
+	// calls all listeners (in the order they were added)
+	template<typename... Args>
+	void Invoke(Args&&... pArgs)
+	{
+		BeginDispatch();
+		const size_t slotsCount = mSlots.size(); // listeners added from the callbacks go to "mPendingSlots"
+		for (size_t i = 0; i < slotsCount; i++)
+		{
+			if (mSlots[i].IsAlive && mSlots[i].Callback)
+				mSlots[i].Callback(pArgs...);
+		}
+		EndDispatch();
+	}
+
+	// calls one listener, returns false if it does not exist anymore
+	template<typename... Args>
+	bool Invoke(ER_EventListenerHandle pHandle, Args&&... pArgs)
+	{
+		if (pHandle.Index >= mSlots.size()) // pending listeners are not called until they are added
+			return false;
+		Slot& slot = mSlots[pHandle.Index];
+		if (!slot.IsAlive || slot.Generation != pHandle.Generation || !slot.Callback)
+			return false;
+
+		BeginDispatch();
+		slot.Callback(std::forward<Args>(pArgs)...);
+		EndDispatch();
+		return true;
 	}
-	
+
+	size_t GetListenersCount() const { return mSlots.size() - mFreeSlots.size() + mPendingSlots.size(); }
 
 private:
-	std::unordered_map<std::string, T> mNamedListeners;
-	std::vector<T> mAnonymousListeners;
-};
\ No newline at end of file
+	struct Slot
+	{
+		T Callback;
+		std::string Name; // empty for anonymous listeners
+		unsigned int Generation = 0;
+		bool IsAlive = false;
+		bool IsFree = false; // in "mFreeSlots"
+	};
+
+	ER_EventListenerHandle AddSlot(const std::string& pName, T&& pCallback)
+	{
+		if (mDispatchDepth > 0)
+		{
+			// "mSlots" can not grow while a callback stored in it is executing, and free slots are only reused outside of dispatches
+			Slot slot;
+			slot.Callback = std::move(pCallback);
+			slot.Name = pName;
+			slot.Generation = mNextGeneration++;
+			slot.IsAlive = true;
+			mPendingSlots.push_back(std::move(slot));
+			return ER_EventListenerHandle{ static_cast<unsigned int>(mSlots.size() + mPendingSlots.size() - 1), mPendingSlots.back().Generation };
+		}
+
+		unsigned int index;
+		if (!mFreeSlots.empty())
+		{
+			index = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else
+		{
+			index = static_cast<unsigned int>(mSlots.size());
+			mSlots.emplace_back();
+		}
+
+		Slot& slot = mSlots[index];
+		slot.Callback = std::move(pCallback);
+		slot.Name = pName;
+		slot.Generation = mNextGeneration++;
+		slot.IsAlive = true;
+		slot.IsFree = false;
+		return ER_EventListenerHandle{ index, slot.Generation };
+	}
+
+	const Slot* GetSlot(ER_EventListenerHandle pHandle) const
+	{
+		if (!pHandle.IsValid())
+			return nullptr;
+
+		const Slot* slot = nullptr;
+		if (pHandle.Index < mSlots.size())
+			slot = &mSlots[pHandle.Index];
+		else if (pHandle.Index - mSlots.size() < mPendingSlots.size())
+			slot = &mPendingSlots[pHandle.Index - mSlots.size()];
+		return (slot && slot->IsAlive && slot->Generation == pHandle.Generation) ? slot : nullptr;
+	}
+	Slot* GetSlot(ER_EventListenerHandle pHandle)
+	{
+		return const_cast<Slot*>(static_cast<const ER_GenericEvent*>(this)->GetSlot(pHandle));
+	}
+
+	void ReleaseSlot(unsigned int pIndex)
+	{
+		Slot& slot = mSlots[pIndex];
+		slot.Callback = nullptr;
+		slot.Name.clear();
+		slot.IsAlive = false;
+		slot.IsFree = true;
+		mFreeSlots.push_back(pIndex);
+	}
+
+	void BeginDispatch() { mDispatchDepth++; }
+	void EndDispatch()
+	{
+		assert(mDispatchDepth > 0);
+		if (--mDispatchDepth > 0)
+			return;
+
+		if (mHasRemovedSlots)
+		{
+			for (unsigned int i = 0; i < static_cast<unsigned int>(mSlots.size()); i++)
+			{
+				if (!mSlots[i].IsAlive && !mSlots[i].IsFree)
+					ReleaseSlot(i);
+			}
+			mHasRemovedSlots = false;
+		}
+
+		// pending slots keep the indices from their handles, so they are appended in order (free slots are not reused here)
+		for (Slot& slot : mPendingSlots)
+		{
+			const bool isAlive = slot.IsAlive;
+			mSlots.push_back(std::move(slot));
+			if (!isAlive)
+				ReleaseSlot(static_cast<unsigned int>(mSlots.size() - 1));
+		}
+		mPendingSlots.clear();
+	}
+
+	std::vector<Slot> mSlots;
+	std::vector<Slot> mPendingSlots; // added during a dispatch
+	std::vector<unsigned int> mFreeSlots;
+	unsigned int mNextGeneration = 1;
+	unsigned int mDispatchDepth = 0;
+	bool mHasRemovedSlots = false;
+};
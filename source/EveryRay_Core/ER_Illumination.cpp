@@ -29,7 +29,7 @@
 
 static float clearColorBlack[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-static const std::string voxelizationPSONames[NUM_VOXEL_GI_CASCADES] =
+static const ER_RHI_PSOHandle voxelizationPSONames[NUM_VOXEL_GI_CASCADES] =
 {
 	"ER_RHI_GPUPipelineStateObject: VoxelizationMaterial Pass (cascade 0)",
 	"ER_RHI_GPUPipelineStateObject: VoxelizationMaterial Pass (cascade 1)",
@@ -39,6 +39,10 @@ static const std::string voxelizationPSONames[NUM_VOXEL_GI_CASCADES] =
 #define VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
 #define VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
 
+#define VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
+#define VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
+#define VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
+
 #define VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 1
 
@@ -89,6 +93,7 @@ namespace EveryRay_Core {
 	ER_Illumination::~ER_Illumination()
 	{
 		DeleteObject(mVCTMainCS);
+		DeleteObject(mVCTUpdateCascadeCS);
 		DeleteObject(mUpsampleBlurCS);
 		DeleteObject(mCompositeIlluminationCS);
 		DeleteObject(mVCTVoxelizationDebugVS);
@@ -106,6 +111,7 @@ namespace EveryRay_Core {
 		for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 		{
 			DeleteObject(mVCTVoxelCascades3DRTs[i]);
+			DeleteObject(mVCTVoxelCascadesPrevious3DRTs[i]);
 			DeleteObject(mDebugVoxelZonesGizmos[i]);
 		}
 		DeleteObject(mVCTVoxelizationDebugRT);
@@ -115,6 +121,7 @@ namespace EveryRay_Core {
 		DeleteObject(mFinalIlluminationRT);
 		DeleteObject(mDepthBuffer);
 		DeleteObject(mVCTRS);
+		DeleteObject(mVCTUpdateCascadeRS);
 		DeleteObject(mUpsampleAndBlurRS);
 		DeleteObject(mCompositeIlluminationRS);
 		DeleteObject(mDeferredLightingRS);
@@ -127,6 +134,7 @@ namespace EveryRay_Core {
 		{
 			mVoxelizationDebugConstantBuffer.Release();
 			mVoxelConeTracingMainConstantBuffer.Release();
+			mVoxelCascadeUpdateConstantBuffer.Release();
 		}
 
 		mUpsampleBlurConstantBuffer.Release();
@@ -155,6 +163,9 @@ namespace EveryRay_Core {
 				mVCTVoxelizationDebugPS = rhi->CreateGPUShader();
 				mVCTVoxelizationDebugPS->CompileShader(rhi, "content\\shaders\\GI\\VoxelConeTracingVoxelizationDebug.hlsl", "PSMain", ER_PIXEL);
 
+				mVCTUpdateCascadeCS = rhi->CreateGPUShader();
+				mVCTUpdateCascadeCS->CompileShader(rhi, "content\\shaders\\GI\\VoxelConeTracingUpdateCascade.hlsl", "CSMain", ER_COMPUTE);
+
 				mVCTMainCS = rhi->CreateGPUShader();
 				mVCTMainCS->CompileShader(rhi, "content\\shaders\\GI\\VoxelConeTracingMain.hlsl", "CSMain", ER_COMPUTE);
 			}
@@ -213,6 +224,7 @@ namespace EveryRay_Core {
 			{
 				mVoxelizationDebugConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Voxelization Debug CB");
 				mVoxelConeTracingMainConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Voxel Cone Tracing Main CB");
+				mVoxelCascadeUpdateConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Voxel Cascade Update CB");
 			}
 			mCompositeTotalIlluminationConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Composite Total Illumination CB");
 			mUpsampleBlurConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Upsample+Blur CB");
@@ -230,6 +242,9 @@ namespace EveryRay_Core {
 					mVCTVoxelCascades3DRTs[i] = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Voxel Cone Tracing 3D Cascade #" + std::to_wstring(i));
 					mVCTVoxelCascades3DRTs[i]->CreateGPUTextureResource(rhi, voxelCascadesSizes[i], voxelCascadesSizes[i], 1u,
 						ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE | ER_BIND_RENDER_TARGET | ER_BIND_UNORDERED_ACCESS, 6, voxelCascadesSizes[i]);
+					mVCTVoxelCascadesPrevious3DRTs[i] = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Voxel Cone Tracing 3D Cascade (previous frame) #" + std::to_wstring(i));
+					mVCTVoxelCascadesPrevious3DRTs[i]->CreateGPUTextureResource(rhi, voxelCascadesSizes[i], voxelCascadesSizes[i], 1u,
+						ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE, 1, voxelCascadesSizes[i]);
 
 					mVoxelCameraPositions[i] = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, 1.0f);
 
@@ -287,6 +302,15 @@ namespace EveryRay_Core {
 					mVoxelizationDebugRS->Finalize(rhi, "ER_RHI_GPURootSignature: Voxelization Debug Pass", true);
 				}
 
+				mVCTUpdateCascadeRS = rhi->CreateRootSignature(3, 0);
+				if (mVCTUpdateCascadeRS)
+				{
+					mVCTUpdateCascadeRS->InitDescriptorTable(rhi, VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 1 }, ER_RHI_SHADER_VISIBILITY_ALL);
+					mVCTUpdateCascadeRS->InitDescriptorTable(rhi, VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 1 }, ER_RHI_SHADER_VISIBILITY_ALL);
+					mVCTUpdateCascadeRS->InitDescriptorTable(rhi, VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 1 }, ER_RHI_SHADER_VISIBILITY_ALL);
+					mVCTUpdateCascadeRS->Finalize(rhi, "ER_RHI_GPURootSignature: Voxel Cone Tracing Update Cascade Pass");
+				}
+
 				mVCTRS = rhi->CreateRootSignature(3, 1);
 				if (mVCTRS)
 				{
@@ -421,26 +445,52 @@ namespace EveryRay_Core {
 
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		//voxelization
+		//voxelization (incremental: only the dirty regions of the cascades are voxelized again, see ER_VoxelClipmap)
 		{
-			rhi->SetRootSignature(mVoxelizationRS);
+			// voxels do not depend on the camera, so instanced objects are voxelized with all their instances (not the ones culled for the camera)
+			mVoxelizationInstancedObjects.clear();
+			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+			{
+				if (!mVoxelClipmaps[cascade].IsDirty())
+					continue;
+				for (auto& obj : mVoxelizationObjects[cascade])
+				{
+					if (obj.second->IsInVoxelization() && obj.second->IsInstanced())
+						mVoxelizationInstancedObjects.push_back(obj.second);
+				}
+			}
+			std::sort(mVoxelizationInstancedObjects.begin(), mVoxelizationInstancedObjects.end());
+			mVoxelizationInstancedObjects.erase(std::unique(mVoxelizationInstancedObjects.begin(), mVoxelizationInstancedObjects.end()), mVoxelizationInstancedObjects.end());
+			for (ER_RenderingObject* object : mVoxelizationInstancedObjects)
+				object->UploadAllInstances();
+
 			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
 			{
+				ER_VoxelClipmap& clipmap = mVoxelClipmaps[cascade];
+				mVoxelClipmapsStats[cascade] = clipmap.GetStats();
+				if (!clipmap.IsDirty())
+					continue;
+
+				if (clipmap.IsAllDirty())
+					rhi->ClearUAV(mVCTVoxelCascades3DRTs[cascade], clearColorBlack);
+				else
+					UpdateVoxelCascade(cascade);
+
+				rhi->SetRootSignature(mVoxelizationRS);
+
 				ER_RHI_Viewport vctViewport = { 0.0f, 0.0f, voxelCascadesSizes[cascade], voxelCascadesSizes[cascade] };
 				rhi->SetViewport(vctViewport);
 
 				ER_RHI_Rect vctRect = { 0.0f, 0.0f, voxelCascadesSizes[cascade], voxelCascadesSizes[cascade] };
 				rhi->SetRect(vctRect);
 
-				rhi->ClearUAV(mVCTVoxelCascades3DRTs[cascade], clearColorBlack);
-
 				if (rhi->GetAPI() == ER_GRAPHICS_API::DX11)
 					rhi->SetRenderTargets({}, nullptr, mVCTVoxelCascades3DRTs[cascade]);
 				else
 					rhi->SetUnorderedAccessResources(ER_PIXEL, { mVCTVoxelCascades3DRTs[cascade] }, 0, mVoxelizationRS, VOXELIZATION_MAT_ROOT_DESCRIPTOR_TABLE_UAV_INDEX);
 
 				std::string materialName = ER_MaterialHelper::voxelizationMaterialName + "_" + std::to_string(cascade);
-				const std::string& psoName = voxelizationPSONames[cascade];
+				const ER_RHI_PSOHandle& psoName = voxelizationPSONames[cascade];
 
 				for (auto& obj : mVoxelizationObjects[cascade])
 				{
@@ -452,7 +502,9 @@ namespace EveryRay_Core {
 					if (materialInfo != renderingObject->GetMaterials().end())
 					{
 						ER_Material* material = materialInfo->second;
-						for (int meshIndex = 0; meshIndex < obj.second->GetMeshCount(); meshIndex++)
+						// coarsest LOD (like shadow casters): voxels are coarser than the LODs and must not change with the camera's LODs
+						const int voxelizationLOD = renderingObject->GetLODCount() - 1;
+						for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(voxelizationLOD); meshIndex++)
 						{
 							if (!rhi->IsPSOReady(psoName))
 							{
@@ -466,8 +518,12 @@ namespace EveryRay_Core {
 							}
 							rhi->SetPSO(psoName);
 							static_cast<ER_VoxelizationMaterial*>(material)->PrepareForRendering(materialSystems, renderingObject, meshIndex,
-								mWorldVoxelScales[cascade], voxelCascadesSizes[cascade], mVoxelCameraPositions[cascade], mVoxelizationRS);
-							renderingObject->Draw(materialName, true, meshIndex);
+								mWorldVoxelScales[cascade], voxelCascadesSizes[cascade], mVoxelCameraPositions[cascade], mVoxelizationRS, &clipmap);
+							// objects outside of the camera's frustum are voxelized, too
+							if (renderingObject->IsInstanced())
+								renderingObject->DrawLOD(materialName, true, meshIndex, voxelizationLOD, true, RENDERING_OBJECT_ALL_INSTANCES);
+							else
+								renderingObject->DrawLOD(materialName, true, meshIndex, voxelizationLOD, true);
 							rhi->UnsetPSO();
 						}
 					}
@@ -487,6 +543,9 @@ namespace EveryRay_Core {
 				rhi->SetViewport(currentViewport);
 				rhi->SetRect(currentRect);
 				rhi->SetRasterizerState(ER_RHI_RASTERIZER_STATE::ER_BACK_CULLING);
+
+				clipmap.ClearDirty();
+				mIsVoxelCascadeMipsDirty[cascade] = true;
 			}
 		}
 		
@@ -547,7 +606,11 @@ namespace EveryRay_Core {
 
 			for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 			{
-				rhi->GenerateMips(mVCTVoxelCascades3DRTs[i]);
+				if (mIsVoxelCascadeMipsDirty[i])
+				{
+					rhi->GenerateMips(mVCTVoxelCascades3DRTs[i]);
+					mIsVoxelCascadeMipsDirty[i] = false;
+				}
 				mVoxelConeTracingMainConstantBuffer.Data.VoxelCameraPositions[i] = mVoxelCameraPositions[i];
 				mVoxelConeTracingMainConstantBuffer.Data.WorldVoxelScales[i] = XMFLOAT4(mWorldVoxelScales[i], 0.0, 0.0, 0.0);
 			}
@@ -574,7 +637,7 @@ namespace EveryRay_Core {
 			}
 			rhi->SetPSO(mVCTMainPSOName, true);
 			rhi->SetSamplers(ER_COMPUTE, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP });
-			std::vector<ER_RHI_GPUResource*> resources(4 + NUM_VOXEL_GI_CASCADES);
+			ER_RHI_GPUResource* resources[4 + NUM_VOXEL_GI_CASCADES] = {};
 			resources[0] = gbuffer->GetAlbedo();
 			resources[1] = gbuffer->GetNormals();
 			resources[2] = gbuffer->GetPositions();
@@ -700,19 +763,8 @@ namespace EveryRay_Core {
 			}
 		}
 
-		for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
-		{
-			mWorldVoxelCascadesAABBs[cascade] = mLocalVoxelCascadesAABBs[cascade];
-			mWorldVoxelCascadesAABBs[cascade].first.x += mVoxelCameraPositions[cascade].x;
-			mWorldVoxelCascadesAABBs[cascade].first.y += mVoxelCameraPositions[cascade].y;
-			mWorldVoxelCascadesAABBs[cascade].first.z += mVoxelCameraPositions[cascade].z;
-			mWorldVoxelCascadesAABBs[cascade].second.x += mVoxelCameraPositions[cascade].x;
-			mWorldVoxelCascadesAABBs[cascade].second.y += mVoxelCameraPositions[cascade].y;
-			mWorldVoxelCascadesAABBs[cascade].second.z += mVoxelCameraPositions[cascade].z;
-		}
-
-		CPUCullObjectsAgainstVoxelCascades(scene);
 		UpdateVoxelCameraPosition();
+		CPUCullObjectsAgainstVoxelCascades(scene);
 		UpdateImGui();
 	}
 
@@ -739,6 +791,14 @@ namespace EveryRay_Core {
 					std::string name = "VCT Voxel Scale Cascade " + std::to_string(cascade);
 					ImGui::SliderFloat(name.c_str(), &mWorldVoxelScales[cascade], 0.1f, 10.0f);
 				}
+				ImGui::Checkbox("VCT Incremental Voxelization", &mIsVCTIncrementalVoxelization);
+				for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+				{
+					const ER_VoxelClipmapStats& stats = mVoxelClipmapsStats[cascade];
+					const float totalVoxels = voxelCascadesSizes[cascade] * voxelCascadesSizes[cascade] * voxelCascadesSizes[cascade];
+					ImGui::Text("Cascade %d voxelized (last frame): %s%u regions, %.1f%% of voxels", cascade, stats.IsAllDirty ? "all, " : "",
+						stats.DirtyRegionsCount, 100.0f * std::min(static_cast<float>(stats.DirtyVoxelsCount) / totalVoxels, 1.0f));
+				}
 				ImGui::Separator();
 				ImGui::Checkbox("DEBUG - Ambient Occlusion", &mShowVCTAmbientOcclusionOnly);
 				ImGui::Checkbox("DEBUG - Voxel Texture", &mShowVCTVoxelizationOnly);
@@ -751,6 +811,27 @@ namespace EveryRay_Core {
 				ImGui::Checkbox("DEBUG - Hide culled probes", &mProbesManager->mDebugDiscardCulledProbes);
 				ImGui::Checkbox("DEBUG - Diffuse probes", &mDrawDiffuseProbes);
 				ImGui::Checkbox("DEBUG - Specular probes", &mDrawSpecularProbes);
+
+				// moving a probe only re-assigns it to the cells around its old and new positions (its lighting stays the same until the probes are recomputed)
+				if (mProbesManager->AreProbesReady())
+				{
+					ImGui::Separator();
+					ImGui::Combo("Edited probe type", &mEditedProbeType, "Diffuse\0Specular\0");
+					const ER_ProbeType probeType = (mEditedProbeType == 0) ? DIFFUSE_PROBE : SPECULAR_PROBE;
+					const int probesCount = mProbesManager->GetProbesCount(probeType);
+					if (probesCount > 0)
+					{
+						ImGui::SliderInt("Edited probe index", &mEditedProbeIndex, 0, probesCount - 1);
+						mEditedProbeIndex = std::min(std::max(mEditedProbeIndex, 0), probesCount - 1);
+
+						const ER_LightProbe& probe = (probeType == DIFFUSE_PROBE) ? mProbesManager->GetDiffuseLightProbe(mEditedProbeIndex) : mProbesManager->GetSpecularLightProbe(mEditedProbeIndex);
+						XMFLOAT3 position = probe.GetPosition();
+						if (ImGui::DragFloat3("Edited probe position", &position.x, 0.1f))
+							mProbesManager->UpdateProbePosition(*mCore, probeType, mEditedProbeIndex, position);
+						ImGui::Text("Edited probe cell: %d, camera cell: %d", mProbesManager->GetCellIndex(probe.GetPosition(), probeType),
+							mProbesManager->GetCellIndex(mCamera.Position(), probeType));
+					}
+				}
 			}
 		}
 		ImGui::End();
@@ -771,26 +852,70 @@ namespace EveryRay_Core {
 		if (mCurrentGIQuality == GIQuality::GI_LOW)
 			return;
 
+		const XMFLOAT3 sunDirection = mDirectionalLight.Direction();
+		const bool isSunDirectionChanged = memcmp(&sunDirection, &mVoxelizationSunDirection, sizeof(XMFLOAT3)) != 0;
+		mVoxelizationSunDirection = sunDirection;
+
+		mIsVCTVoxelCameraPositionsUpdated = false;
 		for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 		{
-			float halfCascadeBox = 0.5f * (voxelCascadesSizes[i] / mWorldVoxelScales[i] * 0.5f);
-			XMFLOAT3 voxelGridBoundsMax = XMFLOAT3{ mVoxelCameraPositions[i].x + halfCascadeBox, mVoxelCameraPositions[i].y + halfCascadeBox, mVoxelCameraPositions[i].z + halfCascadeBox };
-			XMFLOAT3 voxelGridBoundsMin = XMFLOAT3{ mVoxelCameraPositions[i].x - halfCascadeBox, mVoxelCameraPositions[i].y - halfCascadeBox, mVoxelCameraPositions[i].z - halfCascadeBox };
-			
-			if (mCamera.Position().x < voxelGridBoundsMin.x || mCamera.Position().y < voxelGridBoundsMin.y || mCamera.Position().z < voxelGridBoundsMin.z ||
-				mCamera.Position().x > voxelGridBoundsMax.x || mCamera.Position().y > voxelGridBoundsMax.y || mCamera.Position().z > voxelGridBoundsMax.z)
+			ER_VoxelClipmap& clipmap = mVoxelClipmaps[i];
+			if (!clipmap.IsInitialized() || clipmap.GetVoxelsPerUnit() != mWorldVoxelScales[i])
+				clipmap.Initialize(static_cast<UINT>(voxelCascadesSizes[i]), mWorldVoxelScales[i]);
+			else if (isSunDirectionChanged || !mIsVCTIncrementalVoxelization)
+				clipmap.MarkAllDirty();
+
+			// cascades follow the camera on the grid of their voxels, so the content of the previous frames can be scrolled
+			clipmap.Scroll(mCamera.Position());
+			const XMFLOAT3 center = clipmap.GetCenter();
+			if (center.x != mVoxelCameraPositions[i].x || center.y != mVoxelCameraPositions[i].y || center.z != mVoxelCameraPositions[i].z)
 			{
-				mVoxelCameraPositions[i] = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, 1.0f);
+				mVoxelCameraPositions[i] = XMFLOAT4(center.x, center.y, center.z, 1.0f);
 				mIsVCTVoxelCameraPositionsUpdated = true;
-
-				if (mDebugVoxelZonesGizmos[i])
-					mDebugVoxelZonesGizmos[i]->Update(mWorldVoxelCascadesAABBs[i]);
 			}
-			else
-				mIsVCTVoxelCameraPositionsUpdated = false;
+
+			mWorldVoxelCascadesAABBs[i] = clipmap.GetBounds();
+			if (mDebugVoxelZonesGizmos[i])
+				mDebugVoxelZonesGizmos[i]->Update(mWorldVoxelCascadesAABBs[i]);
 		}
 	}
 
+	void ER_Illumination::UpdateVoxelCascade(int cascade)
+	{
+		ER_RHI* rhi = GetCore()->GetRHI();
+		const ER_VoxelClipmap& clipmap = mVoxelClipmaps[cascade];
+
+		const XMINT3 scrollOffset = clipmap.GetTexelScrollOffset();
+		const std::vector<ER_VoxelRegion>& regions = clipmap.GetDirtyRegions();
+		assert(regions.size() <= ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS);
+		mVoxelCascadeUpdateConstantBuffer.Data.ScrollOffset = XMINT4(scrollOffset.x, scrollOffset.y, scrollOffset.z, static_cast<int>(clipmap.GetResolution()));
+		for (size_t i = 0; i < regions.size(); i++)
+			clipmap.GetTexelRegion(regions[i], mVoxelCascadeUpdateConstantBuffer.Data.DirtyRegionsMin[i], mVoxelCascadeUpdateConstantBuffer.Data.DirtyRegionsMax[i]);
+		mVoxelCascadeUpdateConstantBuffer.Data.DirtyRegionsCount = static_cast<UINT>(regions.size());
+		mVoxelCascadeUpdateConstantBuffer.Data.pad0 = XMFLOAT3(0, 0, 0);
+		mVoxelCascadeUpdateConstantBuffer.ApplyChanges(rhi);
+
+		// the cascade can not be read and written in the same pass
+		rhi->CopyGPUTextureSubresourceRegion(mVCTVoxelCascadesPrevious3DRTs[cascade], 0, 0, 0, 0, mVCTVoxelCascades3DRTs[cascade], 0);
+
+		rhi->SetRootSignature(mVCTUpdateCascadeRS, true);
+		if (!rhi->IsPSOReady(mVCTUpdateCascadePSOName, true))
+		{
+			rhi->InitializePSO(mVCTUpdateCascadePSOName, true);
+			rhi->SetShader(mVCTUpdateCascadeCS);
+			rhi->SetRootSignatureToPSO(mVCTUpdateCascadePSOName, mVCTUpdateCascadeRS, true);
+			rhi->FinalizePSO(mVCTUpdateCascadePSOName, true);
+		}
+		rhi->SetPSO(mVCTUpdateCascadePSOName, true);
+		rhi->SetShaderResources(ER_COMPUTE, { mVCTVoxelCascadesPrevious3DRTs[cascade] }, 0, mVCTUpdateCascadeRS, VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+		rhi->SetUnorderedAccessResources(ER_COMPUTE, { mVCTVoxelCascades3DRTs[cascade] }, 0, mVCTUpdateCascadeRS, VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		rhi->SetConstantBuffers(ER_COMPUTE, { mVoxelCascadeUpdateConstantBuffer.Buffer() }, 0, mVCTUpdateCascadeRS, VCT_UPDATE_CASCADE_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+		const UINT groupsCount = ER_DivideByMultiple(clipmap.GetResolution(), 8u);
+		rhi->Dispatch(groupsCount, groupsCount, groupsCount);
+		rhi->UnsetPSO();
+		rhi->UnbindResourcesFromShader(ER_COMPUTE);
+	}
+
 	void ER_Illumination::DrawDeferredLighting(ER_GBuffer* gbuffer, ER_RHI_GPUTexture* aRenderTarget)
 	{
 		static const float clearColorBlack[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -846,7 +971,7 @@ namespace EveryRay_Core {
 				else
 					rhi->SetConstantBuffers(ER_COMPUTE, { mDeferredLightingConstantBuffer.Buffer() }, 0, mDeferredLightingRS, DEFERRED_LIGHTING_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
 
-				std::vector<ER_RHI_GPUResource*> resources(18);
+				ER_RHI_GPUResource* resources[18] = {};
 				resources[0] = gbuffer->GetAlbedo();
 				resources[1] = gbuffer->GetNormals();
 				resources[2] = gbuffer->GetPositions();
@@ -906,7 +1031,7 @@ namespace EveryRay_Core {
 	{
 		auto rhi = mCore->GetRHI();
 
-		std::string psoName;
+		ER_RHI_PSOHandle psoName;
 		if (!aObj->IsTransparent())
 			psoName = aObj->IsInstanced() ? mForwardLightingInstancingPSOName : mForwardLightingPSOName;
 		else
@@ -985,7 +1110,7 @@ namespace EveryRay_Core {
 				rhi->SetConstantBuffers(ER_PIXEL,  { mForwardLightingConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, mForwardLightingRS, FORWARD_LIGHTING_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 			}
 
-			std::vector<ER_RHI_GPUResource*> resources(18);
+			ER_RHI_GPUResource* resources[18] = {};
 			if (mProbesManager->AreGlobalProbesReady())
 			{
 				resources[0] = aObj->GetTextureData(meshIndex).AlbedoMap;
@@ -1009,7 +1134,7 @@ namespace EveryRay_Core {
 			}
 
 			if (aObj->IsGPUIndirectlyRendered())
-				rhi->SetShaderResources(ER_VERTEX, { aObj->GetIndirectNewInstanceBuffer() }, static_cast<int>(resources.size()), mForwardLightingRS, FORWARD_LIGHTING_PASS_ROOT_DESCRIPTOR_TABLE_VERTEX_SRV_INDEX);
+				rhi->SetShaderResources(ER_VERTEX, { aObj->GetIndirectNewInstanceBuffer() }, static_cast<int>(_countof(resources)), mForwardLightingRS, FORWARD_LIGHTING_PASS_ROOT_DESCRIPTOR_TABLE_VERTEX_SRV_INDEX);
 
 			// we unset PSO after all objects are rendered
 		}
@@ -1025,38 +1150,51 @@ namespace EveryRay_Core {
 		if (mCurrentGIQuality == GIQuality::GI_LOW)
 			return;
 
-		//TODO add instancing support
+		// objects that have moved (or appeared/disappeared) since the last frame make their old and new bounds (and shadows) dirty,
+		// static objects stay in the voxels of the previous frames
+		mVoxelObjectsTracker.BeginFrame();
+		for (auto& objectInfo : scene->objects)
+		{
+			ER_RenderingObject* object = objectInfo.second;
+			if (!object->IsInVoxelization())
+				continue;
+
+			mVoxelObjectItemsBounds.clear();
+			if (object->IsInstanced())
+			{
+				for (UINT i = 0; i < object->GetOriginalInstanceCount(); i++)
+					mVoxelObjectItemsBounds.push_back(object->GetInstanceAABB(i));
+			}
+			else
+				mVoxelObjectItemsBounds.push_back(object->GetGlobalAABB());
+			mVoxelObjectsTracker.UpdateObject(object, mVoxelObjectItemsBounds.data(), static_cast<UINT>(mVoxelObjectItemsBounds.size()));
+		}
+		mVoxelObjectsTracker.EndFrame();
+
 		//TODO fix repetition checks when the object AABB is bigger than the lower cascade (i.e. sponza)
-		//TODO add optimization for culling objects by checking its volume size in second+ cascades
-		//TODO add indirect drawing support (GPU cull)
 		//TODO add multithreading per cascade
 		for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
 		{
-			for (auto& objectInfo : scene->objects)
+			ER_VoxelClipmap& clipmap = mVoxelClipmaps[cascade];
+			for (const ER_AABB& bounds : mVoxelObjectsTracker.GetDirtyBounds())
+				clipmap.MarkShadowDirty(bounds, mVoxelizationSunDirection);
+
+			mVoxelizationObjects[cascade].clear();
+			if (!clipmap.IsDirty())
+				continue;
+
+			// scene BVH gives us the objects (or instanced objects with at least one instance) that overlap the dirty regions of the cascade
+			const int regionsCount = clipmap.IsAllDirty() ? 1 : static_cast<int>(clipmap.GetDirtyRegions().size());
+			for (int region = 0; region < regionsCount; region++)
 			{
-				if (!objectInfo.second->IsInVoxelization())
-					continue;
+				mVoxelCascadeQueryObjects.clear();
+				scene->QueryObjects(clipmap.IsAllDirty() ? mWorldVoxelCascadesAABBs[cascade] : clipmap.GetRegionBounds(clipmap.GetDirtyRegions()[region]), mVoxelCascadeQueryObjects);
 
-				auto aabbObj = objectInfo.second->GetLocalAABB();
-				XMFLOAT3 position;
-				ER_MatrixHelper::GetTranslation(objectInfo.second->GetTransformationMatrix(), position);
-				aabbObj.first.x += position.x;
-				aabbObj.first.y += position.y;
-				aabbObj.first.z += position.z;
-				aabbObj.second.x += position.x;
-				aabbObj.second.y += position.y;
-				aabbObj.second.z += position.z;
-
-				bool isColliding =
-					(aabbObj.first.x <= mWorldVoxelCascadesAABBs[cascade].second.x && aabbObj.second.x >= mWorldVoxelCascadesAABBs[cascade].first.x) &&
-					(aabbObj.first.y <= mWorldVoxelCascadesAABBs[cascade].second.y && aabbObj.second.y >= mWorldVoxelCascadesAABBs[cascade].first.y) &&
-					(aabbObj.first.z <= mWorldVoxelCascadesAABBs[cascade].second.z && aabbObj.second.z >= mWorldVoxelCascadesAABBs[cascade].first.z);
-
-				auto it = mVoxelizationObjects[cascade].find(objectInfo.first);
-				if (isColliding && (it == mVoxelizationObjects[cascade].end()))
-					mVoxelizationObjects[cascade].insert(objectInfo);
-				else if (!isColliding && (it != mVoxelizationObjects[cascade].end()))
-					mVoxelizationObjects[cascade].erase(it);
+				for (ER_RenderingObject* object : mVoxelCascadeQueryObjects)
+				{
+					if (object->IsInVoxelization())
+						mVoxelizationObjects[cascade].emplace(object->GetName(), object);
+				}
 			}
 		}
 	}
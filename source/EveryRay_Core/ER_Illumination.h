@@ -2,6 +2,7 @@
 #include "Common.h"
 #include "ER_CoreComponent.h"
 #include "ER_LightProbesManager.h"
+#include "ER_VoxelClipmap.h"
 
 #include "RHI/ER_RHI.h"
 
@@ -54,6 +55,14 @@ namespace EveryRay_Core
 			float GIPower;
 			XMFLOAT3 pad0;
 		};
+		struct ER_ALIGN_GPU_BUFFER VoxelCascadeUpdateCB
+		{
+			XMINT4 ScrollOffset; // xyz - in texels, w - texture dimension
+			XMINT4 DirtyRegionsMin[ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS];
+			XMINT4 DirtyRegionsMax[ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS];
+			UINT DirtyRegionsCount;
+			XMFLOAT3 pad0;
+		};
 		struct ER_ALIGN_GPU_BUFFER CompositeTotalIlluminationCB
 		{
 			XMFLOAT4 DebugVoxelAO_Disable;
@@ -145,6 +154,7 @@ namespace EveryRay_Core
 
 		void UpdateImGui();
 		void UpdateVoxelCameraPosition();
+		void UpdateVoxelCascade(int cascade); // scrolls the voxels and clears the dirty regions before the voxelization
 
 		void CPUCullObjectsAgainstVoxelCascades(const ER_Scene* scene);
 
@@ -159,9 +169,14 @@ namespace EveryRay_Core
 
 		using RenderingObjectInfo = std::map<std::string, ER_RenderingObject*>;
 		RenderingObjectInfo mVoxelizationObjects[NUM_VOXEL_GI_CASCADES];
+		std::vector<ER_RenderingObject*> mVoxelCascadeQueryObjects; // temp results of the scene BVH query (sorted)
+		ER_VoxelObjectsTracker mVoxelObjectsTracker;
+		std::vector<ER_AABB> mVoxelObjectItemsBounds; // temp
+		std::vector<ER_RenderingObject*> mVoxelizationInstancedObjects; // temp, instanced objects to voxelize in this frame (unique)
 
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::VoxelizationDebugCB> mVoxelizationDebugConstantBuffer;
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::VoxelConeTracingMainCB> mVoxelConeTracingMainConstantBuffer;
+		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::VoxelCascadeUpdateCB> mVoxelCascadeUpdateConstantBuffer;
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::UpsampleBlurCB> mUpsampleBlurConstantBuffer;
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::CompositeTotalIlluminationCB> mCompositeTotalIlluminationConstantBuffer;
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::DeferredLightingCB> mDeferredLightingConstantBuffer;
@@ -169,6 +184,7 @@ namespace EveryRay_Core
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::LightProbesCB> mLightProbesConstantBuffer;
 
 		ER_RHI_GPUTexture* mVCTVoxelCascades3DRTs[NUM_VOXEL_GI_CASCADES] = { nullptr, nullptr };
+		ER_RHI_GPUTexture* mVCTVoxelCascadesPrevious3DRTs[NUM_VOXEL_GI_CASCADES] = { nullptr, nullptr }; // mip 0 of the previous frame (for scrolling)
 		ER_RHI_GPUTexture* mVCTVoxelizationDebugRT = nullptr;
 		ER_RHI_GPUTexture* mVCTMainRT = nullptr;
 		ER_RHI_GPUTexture* mVCTUpsampleAndBlurRT = nullptr;
@@ -182,41 +198,45 @@ namespace EveryRay_Core
 		ER_RHI_GPUShader* mVCTVoxelizationDebugVS = nullptr;
 		ER_RHI_GPUShader* mVCTVoxelizationDebugGS = nullptr;
 		ER_RHI_GPUShader* mVCTVoxelizationDebugPS = nullptr;
-		std::string mVoxelizationDebugPSOName = "ER_RHI_GPUPipelineStateObject: VCT GI - Voxelization Pass Debug";
+		ER_RHI_PSOHandle mVoxelizationDebugPSOName = "ER_RHI_GPUPipelineStateObject: VCT GI - Voxelization Pass Debug";
 		ER_RHI_GPURootSignature* mVoxelizationRS = nullptr;
 		ER_RHI_GPURootSignature* mVoxelizationDebugRS = nullptr;
 
+		ER_RHI_GPUShader* mVCTUpdateCascadeCS = nullptr;
+		ER_RHI_PSOHandle mVCTUpdateCascadePSOName = "ER_RHI_GPUPipelineStateObject: VCT GI - Update Cascade Pass";
+		ER_RHI_GPURootSignature* mVCTUpdateCascadeRS = nullptr;
+
 		ER_RHI_GPUShader* mVCTMainCS = nullptr;
-		std::string mVCTMainPSOName = "ER_RHI_GPUPipelineStateObject: VCT GI - Main Pass";
+		ER_RHI_PSOHandle mVCTMainPSOName = "ER_RHI_GPUPipelineStateObject: VCT GI - Main Pass";
 		ER_RHI_GPURootSignature* mVCTRS = nullptr;
 
 		ER_RHI_GPUShader* mUpsampleBlurCS = nullptr;
-		std::string mUpsampleBlurPSOName = "ER_RHI_GPUPipelineStateObject: Upsample and Blur Pass";
+		ER_RHI_PSOHandle mUpsampleBlurPSOName = "ER_RHI_GPUPipelineStateObject: Upsample and Blur Pass";
 		ER_RHI_GPURootSignature* mUpsampleAndBlurRS = nullptr;
 
 		ER_RHI_GPUShader* mCompositeIlluminationCS = nullptr;
-		std::string mCompositeIlluminationPSOName = "ER_RHI_GPUPipelineStateObject: Composite Illumination Pass";
+		ER_RHI_PSOHandle mCompositeIlluminationPSOName = "ER_RHI_GPUPipelineStateObject: Composite Illumination Pass";
 		ER_RHI_GPURootSignature* mCompositeIlluminationRS = nullptr;
 
 		ER_RHI_GPUShader* mDeferredLightingCS = nullptr;
-		std::string mDeferredLightingPSOName = "ER_RHI_GPUPipelineStateObject: Deferred Lighting Pass";
+		ER_RHI_PSOHandle mDeferredLightingPSOName = "ER_RHI_GPUPipelineStateObject: Deferred Lighting Pass";
 		ER_RHI_GPURootSignature* mDeferredLightingRS = nullptr;
 
 		ER_RHI_GPUShader* mForwardLightingVS = nullptr;
 		ER_RHI_GPUShader* mForwardLightingVS_Instancing = nullptr;
 		ER_RHI_GPUShader* mForwardLightingPS = nullptr;
 		ER_RHI_GPUShader* mForwardLightingPS_Transparent = nullptr;
-		std::string mForwardLightingPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Pass";
-		std::string mForwardLightingInstancingPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting (Instancing) Pass";
-		std::string mForwardLightingTransparentPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Pass (Transparent)";
-		std::string mForwardLightingTransparentInstancingPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting (Instancing) Pass (Transparent)";
+		ER_RHI_PSOHandle mForwardLightingPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Pass";
+		ER_RHI_PSOHandle mForwardLightingInstancingPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting (Instancing) Pass";
+		ER_RHI_PSOHandle mForwardLightingTransparentPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Pass (Transparent)";
+		ER_RHI_PSOHandle mForwardLightingTransparentInstancingPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting (Instancing) Pass (Transparent)";
 		ER_RHI_GPURootSignature* mForwardLightingRS = nullptr;
 
 		ER_RHI_GPUShader* mForwardLightingDiffuseProbesPS = nullptr;
-		std::string mForwardLightingDiffuseProbesPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Diffuse Probes Pass";
+		ER_RHI_PSOHandle mForwardLightingDiffuseProbesPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Diffuse Probes Pass";
 
 		ER_RHI_GPUShader* mForwardLightingSpecularProbesPS = nullptr;
-		std::string mForwardLightingSpecularProbesPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Specular Probes Pass";
+		ER_RHI_PSOHandle mForwardLightingSpecularProbesPSOName = "ER_RHI_GPUPipelineStateObject: Forward Lighting Specular Probes Pass";
 
 		ER_RHI_InputLayout* mForwardLightingRenderingObjectInputLayout = nullptr;
 		ER_RHI_InputLayout* mForwardLightingRenderingObjectInputLayout_Instancing = nullptr;
@@ -226,7 +246,11 @@ namespace EveryRay_Core
 		//VCT GI
 		XMFLOAT4 mVoxelCameraPositions[NUM_VOXEL_GI_CASCADES];
 		ER_AABB mLocalVoxelCascadesAABBs[NUM_VOXEL_GI_CASCADES]; // constant, must not change after initialization
-		ER_AABB mWorldVoxelCascadesAABBs[NUM_VOXEL_GI_CASCADES]; // dynamic, changes with camera movement (not in every frame probably in order to save perf)
+		ER_AABB mWorldVoxelCascadesAABBs[NUM_VOXEL_GI_CASCADES]; // dynamic, follows the camera in steps of ER_VOXEL_CLIPMAP_SCROLL_STEP voxels
+		ER_VoxelClipmap mVoxelClipmaps[NUM_VOXEL_GI_CASCADES]; // what has to be voxelized again
+		ER_VoxelClipmapStats mVoxelClipmapsStats[NUM_VOXEL_GI_CASCADES]; // of the last voxelization
+		XMFLOAT3 mVoxelizationSunDirection = XMFLOAT3(0.0f, 0.0f, 0.0f); // shadows are in the voxels, so the cascades are invalid when it changes
+		bool mIsVoxelCascadeMipsDirty[NUM_VOXEL_GI_CASCADES] = { true, true };
 		ER_RenderableAABB* mDebugVoxelZonesGizmos[NUM_VOXEL_GI_CASCADES] = { nullptr, nullptr };
 		float mWorldVoxelScales[NUM_VOXEL_GI_CASCADES] = { 2.0f, 0.5f };
 
@@ -243,11 +267,14 @@ namespace EveryRay_Core
 		bool mShowVCTAmbientOcclusionOnly = false;
 		bool mDrawVCTVoxelZonesGizmos = false;
 		bool mIsVCTEnabled = false;
+		bool mIsVCTIncrementalVoxelization = true; // otherwise all cascades are voxelized from scratch every frame
 
 		//light probes
 		bool mDrawDiffuseProbes = false;
 		bool mDrawSpecularProbes = false;
 		bool mDebugSkipIndirectProbeLighting = false;
+		int mEditedProbeType = 0; // ER_ProbeType
+		int mEditedProbeIndex = 0;
 
 		//SSS
 		bool mIsSSS = true; //global on/off flag
@@ -0,0 +1,259 @@
+#include "ER_JobSystem.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	// index of the queue that belongs to the current thread (-1 for non-worker threads)
+	static thread_local int sCurrentWorkerIndex = -1;
+	static thread_local const ER_JobSystem* sCurrentWorkerJobSystem = nullptr;
+
+	ER_JobSystem::ER_JobSystem(UINT aWorkersCount)
+	{
+		UINT workersCount = aWorkersCount;
+		if (workersCount == 0)
+		{
+			UINT hardwareThreads = std::thread::hardware_concurrency();
+			workersCount = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+		}
+
+		mQueues.reserve(workersCount + 1);
+		for (UINT i = 0; i < workersCount + 1; i++)
+			mQueues.emplace_back(new WorkerQueue());
+
+		mWorkers.reserve(workersCount);
+		for (UINT i = 0; i < workersCount; i++)
+			mWorkers.emplace_back(&ER_JobSystem::WorkerLoop, this, i);
+
+		std::string message = "[ER Logger][ER_JobSystem] Started " + std::to_string(workersCount) + " worker threads\n";
+		ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+	}
+
+	ER_JobSystem::~ER_JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+			mIsRunning.store(false);
+		}
+		mWakeCondition.notify_all();
+
+		for (auto& worker : mWorkers)
+			worker.join();
+		mWorkers.clear();
+		mQueues.clear();
+	}
+
+	void ER_JobSystem::Schedule(const ER_JobFunction& aFunction, ER_JobCounter* aCounter, const ER_JobCounter* aDependency)
+	{
+		assert(aFunction);
+
+		if (aCounter)
+			aCounter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+		ER_Job job;
+		job.Function = aFunction;
+		job.Counter = aCounter;
+		job.Dependency = aDependency;
+
+		if (!IsEnabled() || mWorkers.empty())
+		{
+			if (aDependency)
+				Wait(*aDependency);
+			ExecuteJob(job);
+			return;
+		}
+
+		ParkOrPushJob(GetCurrentQueueIndex(), std::move(job));
+	}
+
+	void ER_JobSystem::ParallelFor(UINT aCount, UINT aBatchSize, const ER_JobRangeFunction& aFunction, ER_JobCounter* aCounter, const ER_JobCounter* aDependency)
+	{
+		if (aCount == 0)
+			return;
+
+		assert(aBatchSize > 0);
+		UINT batchesCount = ER_DivideByMultiple(aCount, aBatchSize);
+
+		// not worth the scheduling: execute in place
+		if (batchesCount == 1 || !IsEnabled() || mWorkers.empty())
+		{
+			if (aDependency)
+				Wait(*aDependency);
+			aFunction(0, aCount);
+			return;
+		}
+
+		if (!aCounter)
+		{
+			// we block until all batches are finished, so the caller's function can be used directly (no copies, no allocations)
+			ER_JobCounter localCounter;
+			const ER_JobRangeFunction* function = &aFunction;
+			for (UINT batch = 0; batch < batchesCount; batch++)
+			{
+				UINT start = batch * aBatchSize;
+				UINT end = std::min(start + aBatchSize, aCount);
+				Schedule([function, start, end]() { (*function)(start, end); }, &localCounter, aDependency);
+			}
+			Wait(localCounter);
+			return;
+		}
+
+		// one copy of the function is shared by all batches (the caller's one might be gone if we do not block)
+		ParallelForData* data = mParallelForPool.New();
+		data->Function = aFunction;
+		data->BatchesLeft.store(batchesCount, std::memory_order_relaxed);
+		for (UINT batch = 0; batch < batchesCount; batch++)
+		{
+			UINT start = batch * aBatchSize;
+			UINT end = std::min(start + aBatchSize, aCount);
+			Schedule([this, data, start, end]()
+			{
+				data->Function(start, end);
+				if (data->BatchesLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					mParallelForPool.Delete(data);
+			}, aCounter, aDependency);
+		}
+	}
+
+	void ER_JobSystem::Wait(const ER_JobCounter& aCounter)
+	{
+		UINT queueIndex = GetCurrentQueueIndex();
+		while (!aCounter.IsDone())
+		{
+			if (!TryExecuteJob(queueIndex))
+				std::this_thread::yield();
+		}
+	}
+
+	void ER_JobSystem::WorkerLoop(UINT aWorkerIndex)
+	{
+		sCurrentWorkerIndex = static_cast<int>(aWorkerIndex);
+		sCurrentWorkerJobSystem = this;
+
+		while (mIsRunning.load())
+		{
+			if (TryExecuteJob(aWorkerIndex))
+				continue;
+
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mWakeCondition.wait(lock, [this] { return mPendingJobsCount.load() > 0 || !mIsRunning.load(); });
+		}
+
+		sCurrentWorkerIndex = -1;
+		sCurrentWorkerJobSystem = nullptr;
+	}
+
+	bool ER_JobSystem::TryExecuteJob(UINT aQueueIndex)
+	{
+		ER_Job job;
+		if (!PopJob(aQueueIndex, job) && !StealJob(aQueueIndex, job))
+			return false;
+
+		// dependency counter was reused after the job had been released: park the job again and let the thread pick something else
+		if (job.Dependency && !job.Dependency->IsDone())
+		{
+			ParkOrPushJob(aQueueIndex, std::move(job));
+			return true;
+		}
+
+		ExecuteJob(job);
+		return true;
+	}
+
+	bool ER_JobSystem::PopJob(UINT aQueueIndex, ER_Job& outJob)
+	{
+		WorkerQueue& queue = *mQueues[aQueueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Jobs.empty())
+			return false;
+
+		outJob = std::move(queue.Jobs.back());
+		queue.Jobs.pop_back();
+		mPendingJobsCount.fetch_sub(1);
+		return true;
+	}
+
+	bool ER_JobSystem::StealJob(UINT aQueueIndex, ER_Job& outJob)
+	{
+		UINT queuesCount = static_cast<UINT>(mQueues.size());
+		for (UINT i = 1; i < queuesCount; i++)
+		{
+			WorkerQueue& victim = *mQueues[(aQueueIndex + i) % queuesCount];
+			std::lock_guard<std::mutex> lock(victim.Mutex);
+			if (victim.Jobs.empty())
+				continue;
+
+			// stealing from the opposite end of the owner (oldest, usually the biggest jobs)
+			outJob = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			mPendingJobsCount.fetch_sub(1);
+			mStolenJobsCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	void ER_JobSystem::PushJob(UINT aQueueIndex, ER_Job&& aJob)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mQueues[aQueueIndex]->Mutex);
+			mQueues[aQueueIndex]->Jobs.push_back(std::move(aJob));
+		}
+		mPendingJobsCount.fetch_add(1);
+
+		// taking the lock guarantees that a worker is either before its predicate check or already waiting (no lost wake-ups)
+		{
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+		}
+		mWakeCondition.notify_one();
+	}
+
+	void ER_JobSystem::ParkOrPushJob(UINT aQueueIndex, ER_Job&& aJob)
+	{
+		if (aJob.Dependency)
+		{
+			// checked under the lock: ReleaseParkedJobs() takes it after the counter has reached 0, so the job can not be missed
+			std::lock_guard<std::mutex> lock(mParkedJobsMutex);
+			if (!aJob.Dependency->IsDone())
+			{
+				mParkedJobs[aJob.Dependency].push_back(std::move(aJob));
+				return;
+			}
+		}
+		PushJob(aQueueIndex, std::move(aJob));
+	}
+
+	void ER_JobSystem::ReleaseParkedJobs(const ER_JobCounter* aCounter)
+	{
+		std::vector<ER_Job> jobs;
+		{
+			std::lock_guard<std::mutex> lock(mParkedJobsMutex);
+			auto it = mParkedJobs.find(aCounter);
+			if (it == mParkedJobs.end())
+				return;
+			jobs = std::move(it->second);
+			mParkedJobs.erase(it);
+		}
+
+		UINT queueIndex = GetCurrentQueueIndex();
+		for (auto& job : jobs)
+			PushJob(queueIndex, std::move(job));
+	}
+
+	void ER_JobSystem::ExecuteJob(ER_Job& aJob)
+	{
+		aJob.Function();
+		mExecutedJobsCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (aJob.Counter && aJob.Counter->mValue.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			ReleaseParkedJobs(aJob.Counter);
+	}
+
+	UINT ER_JobSystem::GetCurrentQueueIndex()
+	{
+		// non-worker threads (i.e., main thread, scene loading threads) share the last queue
+		if (sCurrentWorkerJobSystem == this && sCurrentWorkerIndex >= 0)
+			return static_cast<UINT>(sCurrentWorkerIndex);
+		else
+			return static_cast<UINT>(mQueues.size() - 1);
+	}
+}
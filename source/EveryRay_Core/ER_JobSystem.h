@@ -0,0 +1,104 @@
+#pragma once
+#include "Common.h"
+#include "ER_Allocators.h"
+#include <atomic>
+#include <deque>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+
+namespace EveryRay_Core
+{
+	// Counter of unfinished jobs. It is the "handle" of a job (or a group of jobs) that you can wait on or use as a dependency.
+	// Must outlive all the jobs that were scheduled with it.
+	class ER_JobCounter
+	{
+	public:
+		ER_JobCounter() {}
+		ER_JobCounter(const ER_JobCounter&) = delete;
+		ER_JobCounter& operator=(const ER_JobCounter&) = delete;
+
+		bool IsDone() const { return mValue.load(std::memory_order_acquire) == 0; }
+		int GetValue() const { return mValue.load(std::memory_order_acquire); }
+	private:
+		friend class ER_JobSystem;
+		std::atomic<int> mValue{ 0 };
+	};
+
+	typedef std::function<void()> ER_JobFunction;
+	typedef std::function<void(UINT aStart, UINT aEnd)> ER_JobRangeFunction;
+
+	struct ER_Job
+	{
+		ER_JobFunction Function;
+		ER_JobCounter* Counter = nullptr; // decremented when the job is finished
+		const ER_JobCounter* Dependency = nullptr; // job will not start until this counter is done (it is parked until then, see ER_JobSystem::ParkOrPushJob())
+	};
+
+	// Fixed pool of worker threads with a job queue per worker. Workers pop from the back of their own queue
+	// and steal from the front of other workers' queues when they run out of jobs.
+	// The calling (main) thread is not a worker, but it helps executing jobs while it is waiting in Wait().
+	// WARNING: jobs must not call the RHI or ImGui (both are only used from the main thread).
+	class ER_JobSystem
+	{
+	public:
+		ER_JobSystem(UINT aWorkersCount = 0); // 0 - use hardware concurrency (minus the main thread)
+		~ER_JobSystem();
+
+		void Schedule(const ER_JobFunction& aFunction, ER_JobCounter* aCounter = nullptr, const ER_JobCounter* aDependency = nullptr);
+
+		// Splits [0, aCount) into batches of "aBatchSize" and runs them in parallel. If no counter is passed, it blocks until all batches are finished.
+		void ParallelFor(UINT aCount, UINT aBatchSize, const ER_JobRangeFunction& aFunction, ER_JobCounter* aCounter = nullptr, const ER_JobCounter* aDependency = nullptr);
+
+		// Executes other jobs while the counter is not done (so it is safe to wait from inside a job).
+		void Wait(const ER_JobCounter& aCounter);
+
+		UINT GetWorkersCount() const { return static_cast<UINT>(mWorkers.size()); }
+		bool IsEnabled() const { return mIsEnabled.load(std::memory_order_relaxed); }
+		void SetEnabled(bool value) { mIsEnabled.store(value, std::memory_order_relaxed); } // disabled system executes everything on the calling thread (useful for debugging)
+
+		UINT64 GetExecutedJobsCount() const { return mExecutedJobsCount.load(std::memory_order_relaxed); }
+		UINT64 GetStolenJobsCount() const { return mStolenJobsCount.load(std::memory_order_relaxed); }
+		ER_AllocatorStats GetParallelForPoolStats() { return mParallelForPool.GetStats(); }
+	private:
+		struct WorkerQueue
+		{
+			std::deque<ER_Job> Jobs;
+			std::mutex Mutex;
+		};
+
+		// function of a non-blocking ParallelFor() shared by its batches (the last finished batch returns it to the pool)
+		struct ParallelForData
+		{
+			ER_JobRangeFunction Function;
+			std::atomic<UINT> BatchesLeft{ 0 };
+		};
+
+		void WorkerLoop(UINT aWorkerIndex);
+		bool TryExecuteJob(UINT aQueueIndex);
+		bool PopJob(UINT aQueueIndex, ER_Job& outJob);
+		bool StealJob(UINT aQueueIndex, ER_Job& outJob);
+		void PushJob(UINT aQueueIndex, ER_Job&& aJob);
+		void ParkOrPushJob(UINT aQueueIndex, ER_Job&& aJob);
+		void ReleaseParkedJobs(const ER_JobCounter* aCounter);
+		void ExecuteJob(ER_Job& aJob);
+		UINT GetCurrentQueueIndex();
+
+		std::vector<std::thread> mWorkers;
+		std::vector<std::unique_ptr<WorkerQueue>> mQueues; // one per worker + one for external threads (last)
+
+		std::mutex mWakeMutex;
+		std::condition_variable mWakeCondition;
+		std::atomic<int> mPendingJobsCount{ 0 };
+		std::atomic<bool> mIsRunning{ true };
+		std::atomic<UINT64> mExecutedJobsCount{ 0 };
+		std::atomic<UINT64> mStolenJobsCount{ 0 };
+		std::atomic<bool> mIsEnabled{ true };
+
+		// jobs waiting for their dependency (they are not in the queues, so idle workers can sleep); released when the counter reaches 0
+		std::mutex mParkedJobsMutex;
+		std::unordered_map<const ER_JobCounter*, std::vector<ER_Job>> mParkedJobs;
+
+		ER_PoolAllocator<ParallelForData> mParallelForPool;
+	};
+}
@@ -18,6 +18,9 @@
 #include "ER_QuadRenderer.h"
 #include "ER_RenderToLightProbeMaterial.h"
 #include "ER_MaterialsCallbacks.h"
+#include "ER_Scene.h"
+#include "ER_SphericalHarmonics.h"
+#include "ER_RenderingObject.h"
 
 #define DIFFUSE_PROBE 0
 #define SPECULAR_PROBE 1
@@ -115,6 +118,7 @@ namespace EveryRay_Core
 
 		ER_RHI* rhi = game.GetRHI();
 
+		static_assert(SPHERICAL_HARMONICS_COEF_COUNT == ER_SH_COEF_COUNT, "Light probes' SH are projected with ER_SphericalHarmonics");
 		float rgbCoefficients[3][9] = { 
 			0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
 			0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
@@ -161,15 +165,15 @@ namespace EveryRay_Core
 		rhi->SetViewport(oldViewport);
 
 		if (mProbeType == DIFFUSE_PROBE && mIndex != -1)
-			StoreSphericalHarmonicsFromCubemap(game, aTextureConvoluted);
-
-		SaveProbeOnDisk(game, levelPath, aTextureConvoluted);
+			StoreSphericalHarmonicsFromCubemap(game, aTextureConvoluted); // saved by the manager in the level's ER_LightProbesArchive
+		else
+			SaveProbeOnDisk(game, levelPath, aTextureConvoluted);
 
 		mIsProbeLoadedFromDisk = true;
 
 		{
-			std::wstring probeName = GetConstructedProbeName(levelPath, mProbeType == DIFFUSE_PROBE && mIndex != -1);
-			std::wstring msg = L"[ER Logger][ER_LightProbe] Finished computing and saving the probe: " + probeName + L'\n';
+			std::wstring probeName = GetConstructedProbeName(levelPath);
+			std::wstring msg = L"[ER Logger][ER_LightProbe] Finished computing the probe: " + probeName + L'\n';
 			ER_OUTPUT_LOG(msg.c_str());
 		}
 	}
@@ -192,6 +196,10 @@ namespace EveryRay_Core
 
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+		// objects are culled per face with the scene BVH (if we have it), otherwise all of them are drawn
+		ER_Scene* scene = game.GetLevel() ? game.GetLevel()->mScene : nullptr;
+		std::vector<ER_RenderingObject*> faceObjects;
+
 		//draw world to probe
 		for (int cubeMapFaceIndex = 0; cubeMapFaceIndex < CUBEMAP_FACES_COUNT; cubeMapFaceIndex++)
 		{
@@ -217,23 +225,35 @@ namespace EveryRay_Core
 				// Probe P is next to object A, but object A is far from main camera => A does not have lod 0, probe P can not render A.
 				const int lod = 0;
 
-				//TODO change to culled objects per face (not a priority since we compute probes once)
-				for (auto& object : objectsToRender)
+				faceObjects.clear();
+				if (scene && scene->GetBVH().GetItemsCount() > 0)
+				{
+					// cubemap cameras do not update their frustums, so we build it from the current matrices
+					ER_Frustum faceFrustum(mCubemapCameras[cubeMapFaceIndex]->ViewProjectionMatrix());
+					scene->QueryObjects(faceFrustum.Planes(), 6, faceObjects);
+				}
+				else
 				{
-					if (isGlobal && !object.second->IsUsedForGlobalLightProbeRendering())
+					for (auto& object : objectsToRender)
+						faceObjects.push_back(object.second);
+				}
+
+				for (ER_RenderingObject* object : faceObjects)
+				{
+					if (isGlobal && !object->IsUsedForGlobalLightProbeRendering())
 						continue;
 
-					if (!object.second->IsInLightProbe())
+					if (!object->IsInLightProbe())
 						continue;
 				
-					auto materialInfo = object.second->GetMaterials().find(materialListenerName + "_" + std::to_string(cubeMapFaceIndex));
-					if (materialInfo != object.second->GetMaterials().end())
+					auto materialInfo = object->GetMaterials().find(materialListenerName + "_" + std::to_string(cubeMapFaceIndex));
+					if (materialInfo != object->GetMaterials().end())
 					{
-						for (int meshIndex = 0; meshIndex < object.second->GetMeshCount(); meshIndex++)
+						for (int meshIndex = 0; meshIndex < object->GetMeshCount(); meshIndex++)
 						{
 							materialInfo->second->PrepareShaders();
-							static_cast<ER_RenderToLightProbeMaterial*>(materialInfo->second)->PrepareForRendering(matSystems, object.second, meshIndex, mCubemapCameras[cubeMapFaceIndex], nullptr);
-							object.second->DrawLOD(materialInfo->first, false, meshIndex, lod, true);
+							static_cast<ER_RenderToLightProbeMaterial*>(materialInfo->second)->PrepareForRendering(matSystems, object, meshIndex, mCubemapCameras[cubeMapFaceIndex], nullptr);
+							object->DrawLOD(materialInfo->first, false, meshIndex, lod, true);
 						}
 					}
 				}
@@ -302,155 +322,101 @@ namespace EveryRay_Core
 		rhi->UnbindResourcesFromShader(ER_PIXEL);
 	}
 
+	// local diffuse probes are not saved here (their SH are packed into ER_LightProbesArchive by the manager), the rest is saved as cubemaps
 	void ER_LightProbe::SaveProbeOnDisk(ER_Core& game, const std::wstring& levelPath, ER_RHI_GPUTexture* aTextureConvoluted)
 	{
 		if (game.GetRHI()->GetAPI() != ER_GRAPHICS_API::DX11)
 			throw ER_CoreException("Saving light probes is only available on DX11 at the moment.");
 
-		bool saveAsSphericalHarmonics = mProbeType == DIFFUSE_PROBE && mIndex != -1;
-		std::wstring probeName = GetConstructedProbeName(levelPath, saveAsSphericalHarmonics);
+		assert(!(mProbeType == DIFFUSE_PROBE && mIndex != -1));
+		game.GetRHI()->SaveGPUTextureToFile(aTextureConvoluted, GetConstructedProbeName(levelPath));
 
-		if (saveAsSphericalHarmonics)
-		{
-			std::wofstream shFile(probeName.c_str());
-			if (shFile.is_open())
-			{
-				std::string tempString = "";
-				shFile << L"r ";
-				for (int i = 0; i < SPHERICAL_HARMONICS_COEF_COUNT; i++)
-				{
-					tempString = std::to_string(mSphericalHarmonicsRGB[i].x);
-					if (i == SPHERICAL_HARMONICS_COEF_COUNT - 1)
-						tempString += "\n";
-					else
-						tempString += " ";
-					shFile << ER_Utility::ToWideString(tempString);
-				}
-
-				shFile << L"g ";
-				for (int i = 0; i < SPHERICAL_HARMONICS_COEF_COUNT; i++)
-				{
-					tempString = std::to_string(mSphericalHarmonicsRGB[i].y);
-					if (i == SPHERICAL_HARMONICS_COEF_COUNT - 1)
-						tempString += "\n";
-					else
-						tempString += " ";
-					shFile << ER_Utility::ToWideString(tempString);
-				}
+		//loading the same probe from disk, since aTextureConvoluted is a temp texture and otherwise we need a GPU resource copy to mCubemapTexture (better than this, but I am just too lazy...)
+		if (!LoadProbeFromDisk(game, levelPath))
+			throw ER_CoreException("Could not load probe that was already generated :(");
+	}
 
-				shFile << L"b ";
-				for (int i = 0; i < SPHERICAL_HARMONICS_COEF_COUNT; i++)
-				{
-					tempString = std::to_string(mSphericalHarmonicsRGB[i].z);
-					if (i == SPHERICAL_HARMONICS_COEF_COUNT - 1)
-						tempString += "\n";
-					else
-						tempString += " ";
-					shFile << ER_Utility::ToWideString(tempString);
-				}
-				shFile.close();
-			}
-			else
-			{
-				std::string str(probeName.begin(), probeName.end());
-				std::string msg = "Failed to create a probe SH file: " + str;
-				throw ER_CoreException(msg.c_str());
-			}
+	bool ER_LightProbe::LoadProbeFromDisk(ER_Core& game, const std::wstring& levelPath)
+	{
+		assert(!(mProbeType == DIFFUSE_PROBE && mIndex != -1));
+		assert(mCubemapTexture);
 
+		std::wstring probeName = GetConstructedProbeName(levelPath);
+		mCubemapTexture->CreateGPUTextureResource(game.GetRHI(), probeName, true, false, true, &mIsProbeLoadedFromDisk);
+		if (!mIsProbeLoadedFromDisk)
+		{
+			std::wstring message = L"[ER Logger][ER_LightProbe] Could not load probe's texture file: " + probeName + L". This probe will be recomputed and saved to disk. \n";
+			ER_OUTPUT_LOG(message.c_str());
 		}
 		else
 		{
-			game.GetRHI()->SaveGPUTextureToFile(aTextureConvoluted, probeName);
-
-			//loading the same probe from disk, since aTextureConvoluted is a temp texture and otherwise we need a GPU resource copy to mCubemapTexture (better than this, but I am just too lazy...)
-			if (!LoadProbeFromDisk(game, levelPath))
-				throw ER_CoreException("Could not load probe that was already generated :(");
+			std::wstring message = L"[ER Logger][ER_LightProbe] Successfully loaded probe's cubemap texture: " + probeName + L"\n";
+			ER_OUTPUT_LOG(message.c_str());
 		}
+		return mIsProbeLoadedFromDisk;
 	}
 
-	// Method for loading probe from disk in 2 ways: spherical harmonics coefficients and light probe cubemap texture
-	bool ER_LightProbe::LoadProbeFromDisk(ER_Core& game, const std::wstring& levelPath)
+	bool ER_LightProbe::LoadProbeFromMemory(ER_Core& game, const void* aData, UINT64 aSize)
 	{
-		ER_RHI* rhi = game.GetRHI();
-
-		bool loadAsSphericalHarmonics = mProbeType == DIFFUSE_PROBE && mIndex != -1;
-		std::wstring probeName = GetConstructedProbeName(levelPath, loadAsSphericalHarmonics);
-
-		if (loadAsSphericalHarmonics)
-		{
-			FILE* shFile = _wfopen(probeName.c_str(), L"r");
-			if (shFile)
-			{
-				float coefficients[3][SPHERICAL_HARMONICS_COEF_COUNT] =
-				{
-					{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
-					{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
-					{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }
-				};
-				int channel = 0;
-				char line[256];
-				char channelSymbol;
-				while (fgets(line, sizeof(line), shFile))
-				{
-					if (channel == 3)
-						break;
+		assert(!(mProbeType == DIFFUSE_PROBE && mIndex != -1));
+		assert(mCubemapTexture);
 
-					if (line[0] == 'r' || line[0] == 'g' || line[0] == 'b')
-					{
-						sscanf(line, "%c %f %f %f %f %f %f %f %f %f", &channelSymbol,
-							&coefficients[channel][0], &coefficients[channel][1], &coefficients[channel][2],
-							&coefficients[channel][3], &coefficients[channel][4], &coefficients[channel][5],
-							&coefficients[channel][6], &coefficients[channel][7], &coefficients[channel][8]
-						);
-					}
-					else
-					{
-						std::wstring message = L"[ER Logger][ER_LightProbe] Corrupt probe's spherical harmonics file: " + probeName + L". Loading empty coefficients... \n";
-						ER_OUTPUT_LOG(message.c_str());
-						for (int i = 0; i < SPHERICAL_HARMONICS_COEF_COUNT; i++)
-							mSphericalHarmonicsRGB[i] = XMFLOAT3(0, 0, 0);
-
-						break;
-					}
-					channel++;
-				}
+		mCubemapTexture->CreateGPUTextureResourceFromMemory(game.GetRHI(), aData, static_cast<size_t>(aSize), &mIsProbeLoadedFromDisk);
+		return mIsProbeLoadedFromDisk;
+	}
 
-				for (int i = 0; i < SPHERICAL_HARMONICS_COEF_COUNT; i++)
-					mSphericalHarmonicsRGB[i] = XMFLOAT3(coefficients[0][i], coefficients[1][i], coefficients[2][i]);
+	// "r/g/b c0 ... c8" lines (one per channel), as they were saved by the old per-probe baking
+	bool ER_LightProbe::LoadLegacySphericalHarmonics(const std::wstring& levelPath)
+	{
+		assert(mProbeType == DIFFUSE_PROBE && mIndex != -1);
 
-				std::wstring message = L"[ER Logger][ER_LightProbe] Successfully loaded probe's spherical harmonics file: " + probeName + L"\n";
-				ER_OUTPUT_LOG(message.c_str());
+		std::wstring probeName = GetLegacySphericalHarmonicsName(levelPath);
+		FILE* shFile = _wfopen(probeName.c_str(), L"r");
+		if (!shFile)
+		{
+			mIsProbeLoadedFromDisk = false;
+			return false;
+		}
 
-				mIsProbeLoadedFromDisk = true;
-				fclose(shFile);
-			}
-			else
-			{
-				DWORD error = GetLastError();
-				std::wstring message = L"[ER Logger][ER_LightProbe] Could not load probe's spherical harmonics file: " + probeName + L". This probe will be recomputed and saved to disk. \n";
-				ER_OUTPUT_LOG(message.c_str());
-				mIsProbeLoadedFromDisk = false;
-			}
+		float coefficients[3][SPHERICAL_HARMONICS_COEF_COUNT] = {};
+		int channel = 0;
+		char line[256];
+		char channelSymbol;
+		while (channel < 3 && fgets(line, sizeof(line), shFile))
+		{
+			if ((line[0] != 'r' && line[0] != 'g' && line[0] != 'b') ||
+				sscanf(line, "%c %f %f %f %f %f %f %f %f %f", &channelSymbol,
+					&coefficients[channel][0], &coefficients[channel][1], &coefficients[channel][2],
+					&coefficients[channel][3], &coefficients[channel][4], &coefficients[channel][5],
+					&coefficients[channel][6], &coefficients[channel][7], &coefficients[channel][8]) != SPHERICAL_HARMONICS_COEF_COUNT + 1)
+				break;
+			channel++;
 		}
-		else
+		fclose(shFile);
+
+		if (channel < 3)
 		{
-			assert(mCubemapTexture);
-			mCubemapTexture->CreateGPUTextureResource(rhi, probeName, true, false, true, &mIsProbeLoadedFromDisk);
-			if (!mIsProbeLoadedFromDisk)
-			{
-				std::wstring message = L"[ER Logger][ER_LightProbe] Could not load probe's texture file: " + probeName + L". This probe will be recomputed and saved to disk. \n";
-				ER_OUTPUT_LOG(message.c_str());
-			}
-			else
-			{
-				std::wstring message = L"[ER Logger][ER_LightProbe] Successfully loaded specular probe's cubemap texture: " + probeName + L"\n";
-				ER_OUTPUT_LOG(message.c_str());
-			}
+			std::wstring message = L"[ER Logger][ER_LightProbe] Corrupt probe's spherical harmonics file: " + probeName + L". This probe will be recomputed. \n";
+			ER_OUTPUT_LOG(message.c_str());
+			mIsProbeLoadedFromDisk = false;
+			return false;
 		}
-		return mIsProbeLoadedFromDisk;
+
+		mSphericalHarmonicsRGB.resize(SPHERICAL_HARMONICS_COEF_COUNT);
+		for (int i = 0; i < SPHERICAL_HARMONICS_COEF_COUNT; i++)
+			mSphericalHarmonicsRGB[i] = XMFLOAT3(coefficients[0][i], coefficients[1][i], coefficients[2][i]);
+		mIsProbeLoadedFromDisk = true;
+		return true;
 	}
 
-	std::wstring ER_LightProbe::GetConstructedProbeName(const std::wstring& levelPath, bool inSphericalHarmonics)
+	void ER_LightProbe::SetSphericalHarmonics(const XMFLOAT3* aCoefficients)
+	{
+		assert(mProbeType == DIFFUSE_PROBE && mIndex != -1);
+		mSphericalHarmonicsRGB.assign(aCoefficients, aCoefficients + SPHERICAL_HARMONICS_COEF_COUNT);
+		mIsProbeLoadedFromDisk = true;
+	}
+
+	std::wstring ER_LightProbe::GetConstructedProbeName(const std::wstring& levelPath)
 	{
 		std::wstring fileName = levelPath;
 		if (mProbeType == DIFFUSE_PROBE)
@@ -463,16 +429,20 @@ namespace EveryRay_Core
 			fileName += L"_"
 				+ std::to_wstring(static_cast<int>(mPosition.x)) + L"_"
 				+ std::to_wstring(static_cast<int>(mPosition.y)) + L"_"
-				+ std::to_wstring(static_cast<int>(mPosition.z));
-
-			if (!inSphericalHarmonics)
-				fileName += L".dds";
-			else
-				fileName += L"_sh.txt";
+				+ std::to_wstring(static_cast<int>(mPosition.z))
+				+ L".dds";
 		}
 		else
 			fileName += L"_global.dds";
 
 		return fileName;
 	}
+
+	std::wstring ER_LightProbe::GetLegacySphericalHarmonicsName(const std::wstring& levelPath)
+	{
+		assert(mProbeType == DIFFUSE_PROBE && mIndex != -1);
+
+		std::wstring fileName = GetConstructedProbeName(levelPath);
+		return fileName.substr(0, fileName.size() - 4) + L"_sh.txt"; // instead of ".dds"
+	}
 }
\ No newline at end of file
@@ -32,8 +32,15 @@ namespace EveryRay_Core
 			const std::wstring& levelPath, const LightProbeRenderingObjectsInfo& objectsToRender, ER_QuadRenderer* quadRenderer, ER_Skybox* skybox = nullptr);
 		void UpdateProbe(const ER_CoreTime& gameTime);
 
+		// cubemap probes only (global probes, specular probes right after they were computed); local diffuse probes are loaded with SetSphericalHarmonics()
 		bool LoadProbeFromDisk(ER_Core& game, const std::wstring& levelPath);
+		// cubemap probes only: DDS data from ER_LightProbesArchive
+		bool LoadProbeFromMemory(ER_Core& game, const void* aData, UINT64 aSize);
+		// local diffuse probes only: SH file of the levels that were baked before ER_LightProbesArchive (they are moved into the archive by the manager)
+		bool LoadLegacySphericalHarmonics(const std::wstring& levelPath);
+		std::wstring GetLegacySphericalHarmonicsName(const std::wstring& levelPath);
 		bool IsLoadedFromDisk() { return mIsProbeLoadedFromDisk; }
+		std::wstring GetConstructedProbeName(const std::wstring& levelPath);
 		
 		ER_RHI_GPUTexture* GetCubemapTexture() const { return mCubemapTexture; }
 
@@ -41,9 +48,10 @@ namespace EveryRay_Core
 		void SetShaderInfoForConvolution(ER_RHI_GPUShader* ps)	{ mConvolutionPS = ps; }
 
 		const std::vector<XMFLOAT3>& GetSphericalHarmonics() { return mSphericalHarmonicsRGB; }
+		void SetSphericalHarmonics(const XMFLOAT3* aCoefficients); // SPHERICAL_HARMONICS_COEF_COUNT coefficients from ER_LightProbesArchive
 
 		void SetPosition(const XMFLOAT3& pos);
-		const XMFLOAT3& GetPosition() { return mPosition; }
+		const XMFLOAT3& GetPosition() const { return mPosition; }
 		void SetIndex(int index) { mIndex = index; }
 		int GetIndex() { return mIndex; }
 
@@ -54,7 +62,6 @@ namespace EveryRay_Core
 		void SaveProbeOnDisk(ER_Core& game, const std::wstring& levelPath, ER_RHI_GPUTexture* aTextureConvoluted);
 		void DrawGeometryToProbe(ER_Core& game, ER_RHI_GPUTexture* aTextureNonConvoluted, ER_RHI_GPUTexture** aDepthBuffers, const LightProbeRenderingObjectsInfo& objectsToRender, ER_Skybox* skybox);
 		void ConvoluteProbe(ER_Core& game, ER_QuadRenderer* quadRenderer, ER_RHI_GPUTexture* aTextureNonConvoluted, ER_RHI_GPUTexture* aTextureConvoluted);
-		std::wstring GetConstructedProbeName(const std::wstring& levelPath, bool inSphericalHarmonics = false);
 
 		int mProbeType;
 
@@ -0,0 +1,127 @@
+#include "stdafx.h"
+
+#include "ER_LightProbesArchive.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	static UINT64 AppendToArchive(std::vector<char>& aData, const void* aSource, UINT64 aSize)
+	{
+		const UINT64 offset = (static_cast<UINT64>(aData.size()) + ER_LIGHT_PROBES_ARCHIVE_ALIGNMENT - 1) & ~static_cast<UINT64>(ER_LIGHT_PROBES_ARCHIVE_ALIGNMENT - 1);
+		aData.resize(static_cast<size_t>(offset + aSize), 0);
+		if (aSize > 0)
+			memcpy(aData.data() + offset, aSource, static_cast<size_t>(aSize));
+		return offset;
+	}
+
+	static bool ReadCubemapFile(const std::wstring& aPath, std::vector<char>& aOutData)
+	{
+		std::ifstream file(aPath.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.good())
+			return false;
+
+		aOutData.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		if (!aOutData.empty())
+			file.read(aOutData.data(), aOutData.size());
+		return file.good() && !aOutData.empty();
+	}
+
+	bool ER_LightProbesArchive::Load(const std::string& aPath, UINT64 aContentHash, const ER_LightProbesArchiveGrid& aDiffuseGrid, const ER_LightProbesArchiveGrid& aSpecularGrid, UINT aSHCoefficientsCount)
+	{
+		if (!mFile.Open(aPath))
+			return false;
+
+		if (!Validate(aContentHash, aDiffuseGrid, aSpecularGrid, aSHCoefficientsCount))
+		{
+			mFile.Close();
+			return false;
+		}
+		return true;
+	}
+
+	bool ER_LightProbesArchive::Validate(UINT64 aContentHash, const ER_LightProbesArchiveGrid& aDiffuseGrid, const ER_LightProbesArchiveGrid& aSpecularGrid, UINT aSHCoefficientsCount) const
+	{
+		const UINT64 size = mFile.GetSize();
+		if (size < sizeof(ER_LightProbesArchiveHeader))
+			return false;
+
+		const ER_LightProbesArchiveHeader& header = GetHeader();
+		if (header.Magic != ER_LIGHT_PROBES_ARCHIVE_MAGIC || header.Version != ER_LIGHT_PROBES_ARCHIVE_VERSION || header.FileSize != size ||
+			header.ContentHash != aContentHash || header.SphericalHarmonicsCoefficientsCount != aSHCoefficientsCount ||
+			!AreGridsEqual(header.DiffuseGrid, aDiffuseGrid) || !AreGridsEqual(header.SpecularGrid, aSpecularGrid))
+			return false;
+
+		const UINT64 shSize = static_cast<UINT64>(header.DiffuseGrid.ProbesCount) * header.SphericalHarmonicsCoefficientsCount * sizeof(XMFLOAT3);
+		const UINT64 cubemapsSize = static_cast<UINT64>(header.SpecularGrid.ProbesCount) * sizeof(ER_LightProbesArchiveCubemap);
+		if (header.SphericalHarmonicsOffset + shSize > size || header.CubemapsOffset + cubemapsSize > size)
+			return false;
+
+		const ER_LightProbesArchiveCubemap* cubemaps = reinterpret_cast<const ER_LightProbesArchiveCubemap*>(mFile.GetData() + header.CubemapsOffset);
+		for (UINT i = 0; i < header.SpecularGrid.ProbesCount; i++)
+		{
+			if (cubemaps[i].Size == 0 || cubemaps[i].Offset + cubemaps[i].Size > size)
+				return false;
+		}
+		return true;
+	}
+
+	bool ER_LightProbesArchive::Save(const std::string& aPath, UINT64 aContentHash, const ER_LightProbesArchiveGrid& aDiffuseGrid, const ER_LightProbesArchiveGrid& aSpecularGrid,
+		const XMFLOAT3* aSphericalHarmonics, UINT aSHCoefficientsCount, const std::vector<std::wstring>& aCubemapPaths)
+	{
+		assert(aSphericalHarmonics || aDiffuseGrid.ProbesCount == 0);
+		assert(aCubemapPaths.size() == aSpecularGrid.ProbesCount);
+
+		std::vector<char> data(sizeof(ER_LightProbesArchiveHeader), 0);
+
+		ER_LightProbesArchiveHeader header;
+		ZeroMemory(&header, sizeof(header));
+		header.Magic = ER_LIGHT_PROBES_ARCHIVE_MAGIC;
+		header.Version = ER_LIGHT_PROBES_ARCHIVE_VERSION;
+		header.ContentHash = aContentHash;
+		header.DiffuseGrid = aDiffuseGrid;
+		header.SpecularGrid = aSpecularGrid;
+		header.SphericalHarmonicsCoefficientsCount = aSHCoefficientsCount;
+		header.SphericalHarmonicsOffset = AppendToArchive(data, aSphericalHarmonics, static_cast<UINT64>(aDiffuseGrid.ProbesCount) * aSHCoefficientsCount * sizeof(XMFLOAT3));
+
+		// directory goes first, so that it is close to the header (cubemaps are only touched when they are created)
+		std::vector<ER_LightProbesArchiveCubemap> cubemaps(aCubemapPaths.size());
+		header.CubemapsOffset = AppendToArchive(data, cubemaps.data(), cubemaps.size() * sizeof(ER_LightProbesArchiveCubemap));
+
+		std::vector<char> cubemapData;
+		for (size_t i = 0; i < aCubemapPaths.size(); i++)
+		{
+			if (!ReadCubemapFile(aCubemapPaths[i], cubemapData))
+			{
+				std::wstring message = L"[ER Logger][ER_LightProbesArchive] Could not read specular probe's cubemap: " + aCubemapPaths[i] + L". Archive was not saved. \n";
+				ER_OUTPUT_LOG(message.c_str());
+				return false;
+			}
+			cubemaps[i].Size = static_cast<UINT64>(cubemapData.size());
+			cubemaps[i].Offset = AppendToArchive(data, cubemapData.data(), cubemaps[i].Size);
+		}
+		if (!cubemaps.empty())
+			memcpy(data.data() + header.CubemapsOffset, cubemaps.data(), cubemaps.size() * sizeof(ER_LightProbesArchiveCubemap));
+
+		header.FileSize = static_cast<UINT64>(data.size());
+		memcpy(data.data(), &header, sizeof(header));
+
+		return ER_Utility::SaveBinaryFile(aPath, data.data(), data.size());
+	}
+
+	const XMFLOAT3* ER_LightProbesArchive::GetSphericalHarmonics(UINT aProbe) const
+	{
+		const ER_LightProbesArchiveHeader& header = GetHeader();
+		assert(aProbe < header.DiffuseGrid.ProbesCount);
+		return reinterpret_cast<const XMFLOAT3*>(mFile.GetData() + header.SphericalHarmonicsOffset) + aProbe * header.SphericalHarmonicsCoefficientsCount;
+	}
+
+	const char* ER_LightProbesArchive::GetCubemapData(UINT aProbe, UINT64& aOutSize) const
+	{
+		const ER_LightProbesArchiveHeader& header = GetHeader();
+		assert(aProbe < header.SpecularGrid.ProbesCount);
+		const ER_LightProbesArchiveCubemap& cubemap = reinterpret_cast<const ER_LightProbesArchiveCubemap*>(mFile.GetData() + header.CubemapsOffset)[aProbe];
+		aOutSize = cubemap.Size;
+		return mFile.GetData() + cubemap.Offset;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "Common.h"
+#include "ER_MappedFile.h"
+
+#define ER_LIGHT_PROBES_ARCHIVE_MAGIC 0x504C5245 // "ERLP"
+#define ER_LIGHT_PROBES_ARCHIVE_VERSION 1
+#define ER_LIGHT_PROBES_ARCHIVE_FILE_NAME "light_probes.erprobes"
+#define ER_LIGHT_PROBES_ARCHIVE_ALIGNMENT 16
+
+namespace EveryRay_Core
+{
+	// All the structs below are stored in the file "as is" (POD, no pointers), offsets are in bytes from the beginning of the file.
+	// WARNING: if you change any of these structs or the way the probes are computed, increase ER_LIGHT_PROBES_ARCHIVE_VERSION.
+
+	struct ER_LightProbesArchiveGrid
+	{
+		XMFLOAT3 MinBounds;
+		float Distance; // between the probes
+		UINT32 CountX;
+		UINT32 CountY;
+		UINT32 CountZ;
+		UINT32 ProbesCount; // 0 if the level does not have local probes of this type
+	};
+
+	struct ER_LightProbesArchiveCubemap
+	{
+		UINT64 Offset; // of the DDS file data (all faces & mips)
+		UINT64 Size;
+	};
+
+	struct ER_LightProbesArchiveHeader
+	{
+		UINT32 Magic;
+		UINT32 Version;
+		UINT64 ContentHash; // of the scene content and the probes settings the probes were computed with
+		UINT64 FileSize;
+		ER_LightProbesArchiveGrid DiffuseGrid;
+		ER_LightProbesArchiveGrid SpecularGrid;
+		UINT32 SphericalHarmonicsCoefficientsCount; // per diffuse probe
+		UINT32 Padding;
+		UINT64 SphericalHarmonicsOffset; // XMFLOAT3 coefficients of all diffuse probes one after another (same layout as the SH GPU buffer)
+		UINT64 CubemapsOffset; // ER_LightProbesArchiveCubemap per specular probe
+	};
+
+	// Local light probes of a level baked into one file (instead of a text file with SH per diffuse probe and a DDS file per specular probe):
+	// grids of both probe types, packed SH coefficients of the diffuse probes and a directory of the specular probes' cubemaps stored in the same file.
+	// It is saved to the level folder and memory-mapped on the next loads, so SH go to GPU and cubemaps are created from memory without any parsing.
+	// Archive is stale when the content hash (scene content, probes settings), the grids or ER_LIGHT_PROBES_ARCHIVE_VERSION do not match (probes are computed again).
+	class ER_LightProbesArchive
+	{
+	public:
+		ER_LightProbesArchive() {}
+		~ER_LightProbesArchive() {}
+
+		// Maps the archive and validates it. Returns false if it is missing or stale.
+		bool Load(const std::string& aPath, UINT64 aContentHash, const ER_LightProbesArchiveGrid& aDiffuseGrid, const ER_LightProbesArchiveGrid& aSpecularGrid, UINT aSHCoefficientsCount);
+		// Unmaps the archive (pointers from the getters are not valid anymore).
+		void Close() { mFile.Close(); }
+		bool IsLoaded() const { return mFile.IsOpen(); }
+
+		// "aSphericalHarmonics" has "aSHCoefficientsCount" coefficients per diffuse probe; cubemaps are read from the DDS files of the specular probes (in the order of the probes)
+		static bool Save(const std::string& aPath, UINT64 aContentHash, const ER_LightProbesArchiveGrid& aDiffuseGrid, const ER_LightProbesArchiveGrid& aSpecularGrid,
+			const XMFLOAT3* aSphericalHarmonics, UINT aSHCoefficientsCount, const std::vector<std::wstring>& aCubemapPaths);
+
+		const ER_LightProbesArchiveHeader& GetHeader() const { return *reinterpret_cast<const ER_LightProbesArchiveHeader*>(mFile.GetData()); }
+		// coefficients of the diffuse probe (the following probes' coefficients come right after it)
+		const XMFLOAT3* GetSphericalHarmonics(UINT aProbe) const;
+		const char* GetCubemapData(UINT aProbe, UINT64& aOutSize) const;
+
+		static bool AreGridsEqual(const ER_LightProbesArchiveGrid& aA, const ER_LightProbesArchiveGrid& aB) { return memcmp(&aA, &aB, sizeof(ER_LightProbesArchiveGrid)) == 0; }
+	private:
+		bool Validate(UINT64 aContentHash, const ER_LightProbesArchiveGrid& aDiffuseGrid, const ER_LightProbesArchiveGrid& aSpecularGrid, UINT aSHCoefficientsCount) const;
+
+		ER_MappedFile mFile;
+	};
+}
@@ -24,6 +24,10 @@ namespace EveryRay_Core
 		if (!scene)
 			throw ER_CoreException("No scene to load light probes for!");
 
+		mSceneContentHash = scene->GetContentHash();
+		mSceneSunDirection = scene->GetSunDir();
+		mSceneSunColor = scene->GetSunColor();
+
 		ER_RHI* rhi = game.GetRHI();
 
 		mTempDiffuseCubemapFacesRT = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Temp Diffuse Cubemap RT");
@@ -167,9 +171,6 @@ namespace EveryRay_Core
 		assert(mDiffuseProbesCellsCountTotal);
 
 		float probeCellPositionOffset = static_cast<float>(mDistanceBetweenDiffuseProbes) / 2.0f;
-		mDiffuseProbesCellBounds = {
-			XMFLOAT3(-probeCellPositionOffset, -probeCellPositionOffset, -probeCellPositionOffset),
-			XMFLOAT3(probeCellPositionOffset, probeCellPositionOffset, probeCellPositionOffset) };
 		{
 			for (int cellsY = 0; cellsY < mDiffuseProbesCellsCountY; cellsY++)
 			{
@@ -185,6 +186,9 @@ namespace EveryRay_Core
 						int index = cellsY * (mDiffuseProbesCellsCountX * mDiffuseProbesCellsCountZ) + cellsX * mDiffuseProbesCellsCountZ + cellsZ;
 						mDiffuseProbesCells[index].index = index;
 						mDiffuseProbesCells[index].position = pos;
+						mDiffuseProbesCells[index].bounds = {
+							XMFLOAT3(pos.x - probeCellPositionOffset, pos.y - probeCellPositionOffset, pos.z - probeCellPositionOffset),
+							XMFLOAT3(pos.x + probeCellPositionOffset, pos.y + probeCellPositionOffset, pos.z + probeCellPositionOffset) };
 					}
 				}
 			}
@@ -207,34 +211,25 @@ namespace EveryRay_Core
 					int index = probesY * (mDiffuseProbesCountX * mDiffuseProbesCountZ) + probesX * mDiffuseProbesCountZ + probesZ;
 					mDiffuseProbes[index].SetPosition(pos);
 					mDiffuseProbes[index].SetShaderInfoForConvolution(mConvolutionPS);
-					AddProbeToCells(mDiffuseProbes[index], DIFFUSE_PROBE, minBounds, maxBounds);
 				}
 			}
 		}
+		AssignProbesToCells(DIFFUSE_PROBE);
 
 		// all probes positions GPU buffer
 		XMFLOAT3* diffuseProbesPositionsCPUBuffer = new XMFLOAT3[mDiffuseProbesCountTotal];
 		for (int probeIndex = 0; probeIndex < mDiffuseProbesCountTotal; probeIndex++)
 			diffuseProbesPositionsCPUBuffer[probeIndex] = mDiffuseProbes[probeIndex].GetPosition();
 		mDiffuseProbesPositionsGPUBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: diffuse probes positions buffer");
-		mDiffuseProbesPositionsGPUBuffer->CreateGPUBufferResource(rhi, diffuseProbesPositionsCPUBuffer, mDiffuseProbesCountTotal, sizeof(XMFLOAT3), false, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+		mDiffuseProbesPositionsGPUBuffer->CreateGPUBufferResource(rhi, diffuseProbesPositionsCPUBuffer, mDiffuseProbesCountTotal, sizeof(XMFLOAT3), true, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
 		DeleteObjects(diffuseProbesPositionsCPUBuffer);
 
 		// probe cell's indices GPU buffer, tex. array indices GPU/CPU buffers
-		int* diffuseProbeCellsIndicesCPUBuffer = new int[mDiffuseProbesCellsCountTotal * PROBE_COUNT_PER_CELL];
-		for (int probeIndex = 0; probeIndex < mDiffuseProbesCellsCountTotal; probeIndex++)
-		{
-			for (int indices = 0; indices < PROBE_COUNT_PER_CELL; indices++)
-			{
-				if (indices >= mDiffuseProbesCells[probeIndex].lightProbeIndices.size())
-					diffuseProbeCellsIndicesCPUBuffer[probeIndex * PROBE_COUNT_PER_CELL + indices] = -1;
-				else
-					diffuseProbeCellsIndicesCPUBuffer[probeIndex * PROBE_COUNT_PER_CELL + indices] = mDiffuseProbesCells[probeIndex].lightProbeIndices[indices];
-			}
-		}
+		mDiffuseProbesCellsIndicesCPUBuffer.resize(mDiffuseProbesCellsCountTotal * PROBE_COUNT_PER_CELL);
+		for (int cellIndex = 0; cellIndex < mDiffuseProbesCellsCountTotal; cellIndex++)
+			UpdateProbesCellsIndicesCPUBuffer(DIFFUSE_PROBE, cellIndex);
 		mDiffuseProbesCellsIndicesGPUBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: diffuse probes cells indices buffer");
-		mDiffuseProbesCellsIndicesGPUBuffer->CreateGPUBufferResource(rhi, diffuseProbeCellsIndicesCPUBuffer, mDiffuseProbesCellsCountTotal * PROBE_COUNT_PER_CELL, sizeof(int), false, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
-		DeleteObjects(diffuseProbeCellsIndicesCPUBuffer);
+		mDiffuseProbesCellsIndicesGPUBuffer->CreateGPUBufferResource(rhi, mDiffuseProbesCellsIndicesCPUBuffer.data(), mDiffuseProbesCellsCountTotal * PROBE_COUNT_PER_CELL, sizeof(int), true, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
 		
 		std::string name = "Debug diffuse lightprobes ";
 		scene->objects.emplace_back(name, new ER_RenderingObject(name, scene->objects.size(), core, camera,
@@ -288,9 +283,6 @@ namespace EveryRay_Core
 		assert(mSpecularProbesCellsCountTotal);
 
 		float probeCellPositionOffset = static_cast<float>(mDistanceBetweenSpecularProbes) / 2.0f;
-		mSpecularProbesCellBounds = {
-			XMFLOAT3(-probeCellPositionOffset, -probeCellPositionOffset, -probeCellPositionOffset),
-			XMFLOAT3(probeCellPositionOffset, probeCellPositionOffset, probeCellPositionOffset) };
 		
 		for (int cellsY = 0; cellsY < mSpecularProbesCellsCountY; cellsY++)
 		{
@@ -306,6 +298,9 @@ namespace EveryRay_Core
 					int index = cellsY * (mSpecularProbesCellsCountX * mSpecularProbesCellsCountZ) + cellsX * mSpecularProbesCellsCountZ + cellsZ;
 					mSpecularProbesCells[index].index = index;
 					mSpecularProbesCells[index].position = pos;
+					mSpecularProbesCells[index].bounds = {
+						XMFLOAT3(pos.x - probeCellPositionOffset, pos.y - probeCellPositionOffset, pos.z - probeCellPositionOffset),
+						XMFLOAT3(pos.x + probeCellPositionOffset, pos.y + probeCellPositionOffset, pos.z + probeCellPositionOffset) };
 				}
 			}
 		}
@@ -328,36 +323,28 @@ namespace EveryRay_Core
 					//mSpecularProbes[index]->SetIndex(index);
 					mSpecularProbes[index].SetPosition(pos);
 					mSpecularProbes[index].SetShaderInfoForConvolution(mConvolutionPS);
-					AddProbeToCells(mSpecularProbes[index], SPECULAR_PROBE, minBounds, maxBounds);
 				}
 			}
 		}
+		AssignProbesToCells(SPECULAR_PROBE);
 
 		// all probes positions GPU buffer
 		XMFLOAT3* specularProbesPositionsCPUBuffer = new XMFLOAT3[mSpecularProbesCountTotal];
 		for (int probeIndex = 0; probeIndex < mSpecularProbesCountTotal; probeIndex++)
 			specularProbesPositionsCPUBuffer[probeIndex] = mSpecularProbes[probeIndex].GetPosition();
 		mSpecularProbesPositionsGPUBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: specular probes positions buffer");
-		mSpecularProbesPositionsGPUBuffer->CreateGPUBufferResource(rhi, specularProbesPositionsCPUBuffer, mSpecularProbesCountTotal, sizeof(XMFLOAT3), false, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+		mSpecularProbesPositionsGPUBuffer->CreateGPUBufferResource(rhi, specularProbesPositionsCPUBuffer, mSpecularProbesCountTotal, sizeof(XMFLOAT3), true, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
 		DeleteObjects(specularProbesPositionsCPUBuffer);
 
 		// probe cell's indices GPU buffer, tex. array indices GPU/CPU buffers
-		int* specularProbeCellsIndicesCPUBuffer = new int[mSpecularProbesCellsCountTotal * PROBE_COUNT_PER_CELL];
-		for (int probeIndex = 0; probeIndex < mSpecularProbesCellsCountTotal; probeIndex++)
-		{
-			for (int indices = 0; indices < PROBE_COUNT_PER_CELL; indices++)
-			{
-				if (indices >= mSpecularProbesCells[probeIndex].lightProbeIndices.size())
-					specularProbeCellsIndicesCPUBuffer[probeIndex * PROBE_COUNT_PER_CELL + indices] = -1;
-				else
-					specularProbeCellsIndicesCPUBuffer[probeIndex * PROBE_COUNT_PER_CELL + indices] = mSpecularProbesCells[probeIndex].lightProbeIndices[indices];
-			}
-		}
+		mSpecularProbesCellsIndicesCPUBuffer.resize(mSpecularProbesCellsCountTotal * PROBE_COUNT_PER_CELL);
+		for (int cellIndex = 0; cellIndex < mSpecularProbesCellsCountTotal; cellIndex++)
+			UpdateProbesCellsIndicesCPUBuffer(SPECULAR_PROBE, cellIndex);
 		mSpecularProbesCellsIndicesGPUBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: specular probes cells indices buffer");
-		mSpecularProbesCellsIndicesGPUBuffer->CreateGPUBufferResource(rhi, specularProbeCellsIndicesCPUBuffer,	mSpecularProbesCellsCountTotal * PROBE_COUNT_PER_CELL, sizeof(int), false, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
-		DeleteObjects(specularProbeCellsIndicesCPUBuffer);
+		mSpecularProbesCellsIndicesGPUBuffer->CreateGPUBufferResource(rhi, mSpecularProbesCellsIndicesCPUBuffer.data(), mSpecularProbesCellsCountTotal * PROBE_COUNT_PER_CELL, sizeof(int), true, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
 
 		mSpecularProbesTexArrayIndicesCPUBuffer = new int[mSpecularProbesCountTotal];
+		std::fill(mSpecularProbesTexArrayIndicesCPUBuffer, mSpecularProbesTexArrayIndicesCPUBuffer + mSpecularProbesCountTotal, -1); // no probes in the array yet
 		mSpecularProbesTexArrayIndicesGPUBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: specular probes texture array indices buffer");
 		mSpecularProbesTexArrayIndicesGPUBuffer->CreateGPUBufferResource(rhi, mSpecularProbesTexArrayIndicesCPUBuffer, mSpecularProbesCountTotal, sizeof(int), true, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
 
@@ -383,97 +370,145 @@ namespace EveryRay_Core
 
 		mSpecularCubemapArrayRT = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Specular Cubemap Array RT");
 		mSpecularCubemapArrayRT->CreateGPUTextureResource(rhi, SPECULAR_PROBE_SIZE, SPECULAR_PROBE_SIZE, 1, ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE, SPECULAR_PROBE_MIP_COUNT, -1, CUBEMAP_FACES_COUNT, true, mMaxSpecularProbesInVolumeCount);
+		mSpecularProbesResidency.Initialize(mMaxSpecularProbesInVolumeCount, mSpecularProbesCountTotal);
+		mSpecularProbesVolumeValid = false;
 	}
 
-	void ER_LightProbesManager::AddProbeToCells(ER_LightProbe& aProbe, ER_ProbeType aType, const XMFLOAT3& minBounds, const XMFLOAT3& maxBounds)
+	void ER_LightProbesManager::AssignProbesToCells(ER_ProbeType aType)
 	{
-		int index = aProbe.GetIndex();
-		if (aType == DIFFUSE_PROBE)
-		{
-			// brute force O(cells * probes)
-			for (auto& cell : mDiffuseProbesCells)
-			{
-				if (IsProbeInCell(aProbe, cell, mDiffuseProbesCellBounds))
-					cell.lightProbeIndices.push_back(index);
+		const std::vector<ER_LightProbe>& probes = (aType == DIFFUSE_PROBE) ? mDiffuseProbes : mSpecularProbes;
+		std::vector<ER_LightProbeCell>& cells = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCells : mSpecularProbesCells;
+		ER_SpatialHash& probesHash = (aType == DIFFUSE_PROBE) ? mDiffuseProbesHash : mSpecularProbesHash;
+		ER_SpatialHash& cellsHash = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCellsHash : mSpecularProbesCellsHash;
+		const float distanceBetweenProbes = (aType == DIFFUSE_PROBE) ? mDistanceBetweenDiffuseProbes : mDistanceBetweenSpecularProbes;
+
+		// spatial hashes with buckets of the probes' spacing, so that every cell query only visits a few buckets: O(cells + probes) instead of O(cells * probes)
+		std::vector<ER_AABB> bounds(probes.size());
+		for (size_t i = 0; i < probes.size(); i++)
+			bounds[i] = ER_AABB(probes[i].GetPosition(), probes[i].GetPosition());
+		probesHash.Build(bounds.data(), static_cast<UINT>(bounds.size()), distanceBetweenProbes);
+
+		bounds.resize(cells.size());
+		for (size_t i = 0; i < cells.size(); i++)
+			bounds[i] = cells[i].bounds;
+		cellsHash.Build(bounds.data(), static_cast<UINT>(bounds.size()), distanceBetweenProbes);
+
+		for (auto& cell : cells)
+			AddProbesToCell(cell, aType);
+	}
 
-				if (cell.lightProbeIndices.size() > PROBE_COUNT_PER_CELL)
-					throw ER_CoreException("Too many diffuse probes per cell!");
-			}
+	void ER_LightProbesManager::QueryProbesInCell(const ER_LightProbeCell& aCell, ER_ProbeType aType)
+	{
+		const ER_SpatialHash& probesHash = (aType == DIFFUSE_PROBE) ? mDiffuseProbesHash : mSpecularProbesHash;
+
+		const float epsilon = 0.00001f;
+		const ER_AABB bounds = {
+			XMFLOAT3(aCell.bounds.first.x - epsilon, aCell.bounds.first.y - epsilon, aCell.bounds.first.z - epsilon),
+			XMFLOAT3(aCell.bounds.second.x + epsilon, aCell.bounds.second.y + epsilon, aCell.bounds.second.z + epsilon) };
+		probesHash.QueryAABB(bounds, mProbesQueryResult);
+	}
+
+	void ER_LightProbesManager::AddProbesToCell(ER_LightProbeCell& aCell, ER_ProbeType aType)
+	{
+		QueryProbesInCell(aCell, aType);
+		if (mProbesQueryResult.size() > PROBE_COUNT_PER_CELL)
+			throw ER_CoreException((aType == DIFFUSE_PROBE) ? "Too many diffuse probes per cell!" : "Too many specular probes per cell!");
+
+		aCell.lightProbeIndices.assign(mProbesQueryResult.begin(), mProbesQueryResult.end());
+	}
+
+	void ER_LightProbesManager::UpdateProbesCellsIndicesCPUBuffer(ER_ProbeType aType, int aCellIndex)
+	{
+		const ER_LightProbeCell& cell = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCells[aCellIndex] : mSpecularProbesCells[aCellIndex];
+		int* cellIndices = (aType == DIFFUSE_PROBE) ? &mDiffuseProbesCellsIndicesCPUBuffer[aCellIndex * PROBE_COUNT_PER_CELL] : &mSpecularProbesCellsIndicesCPUBuffer[aCellIndex * PROBE_COUNT_PER_CELL];
+
+		for (int indices = 0; indices < PROBE_COUNT_PER_CELL; indices++)
+			cellIndices[indices] = (indices < cell.lightProbeIndices.size()) ? cell.lightProbeIndices[indices] : -1;
+	}
+
+	bool ER_LightProbesManager::UpdateProbePosition(ER_Core& game, ER_ProbeType aType, int aIndex, const XMFLOAT3& aPosition)
+	{
+		std::vector<ER_LightProbe>& probes = (aType == DIFFUSE_PROBE) ? mDiffuseProbes : mSpecularProbes;
+		std::vector<ER_LightProbeCell>& cells = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCells : mSpecularProbesCells;
+		ER_SpatialHash& probesHash = (aType == DIFFUSE_PROBE) ? mDiffuseProbesHash : mSpecularProbesHash;
+		const ER_SpatialHash& cellsHash = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCellsHash : mSpecularProbesCellsHash;
+		std::vector<int>& cellsIndicesCPUBuffer = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCellsIndicesCPUBuffer : mSpecularProbesCellsIndicesCPUBuffer;
+		ER_RHI_GPUBuffer* cellsIndicesGPUBuffer = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCellsIndicesGPUBuffer : mSpecularProbesCellsIndicesGPUBuffer;
+		ER_RHI_GPUBuffer* positionsGPUBuffer = (aType == DIFFUSE_PROBE) ? mDiffuseProbesPositionsGPUBuffer : mSpecularProbesPositionsGPUBuffer;
+		ER_RenderingObject* probeRenderingObject = (aType == DIFFUSE_PROBE) ? mDiffuseProbeRenderingObject : mSpecularProbeRenderingObject;
+
+		assert(aIndex >= 0 && aIndex < static_cast<int>(probes.size()));
+		if (cells.empty())
+			return false;
+
+		const float epsilon = 0.00001f;
+		const XMFLOAT3 oldPosition = probes[aIndex].GetPosition();
+		probesHash.Update(aIndex, ER_AABB(aPosition, aPosition));
+
+		// only the cells around the old and the new positions can gain or lose the probe
+		std::vector<UINT> affectedCells;
+		for (const XMFLOAT3& pos : { oldPosition, aPosition })
+		{
+			cellsHash.QueryAABB({ XMFLOAT3(pos.x - epsilon, pos.y - epsilon, pos.z - epsilon), XMFLOAT3(pos.x + epsilon, pos.y + epsilon, pos.z + epsilon) }, mProbesQueryResult);
+			affectedCells.insert(affectedCells.end(), mProbesQueryResult.begin(), mProbesQueryResult.end());
 		}
-		else
+		std::sort(affectedCells.begin(), affectedCells.end());
+		affectedCells.erase(std::unique(affectedCells.begin(), affectedCells.end()), affectedCells.end());
+
+		for (UINT cellIndex : affectedCells)
 		{
-			// brute force O(cells * probes)
-			for (auto& cell : mSpecularProbesCells)
+			QueryProbesInCell(cells[cellIndex], aType);
+			if (mProbesQueryResult.size() > PROBE_COUNT_PER_CELL)
 			{
-				if (IsProbeInCell(aProbe, cell, mSpecularProbesCellBounds))
-					cell.lightProbeIndices.push_back(index);
+				probesHash.Update(aIndex, ER_AABB(oldPosition, oldPosition));
 
-				if (cell.lightProbeIndices.size() > PROBE_COUNT_PER_CELL)
-					throw ER_CoreException("Too many specular probes per cell!");
+				std::string message = "[ER Logger][ER_LightProbesManager] Could not move probe #" + std::to_string(aIndex) + ": too many probes in cell #" + std::to_string(cellIndex) + "\n";
+				ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+				return false;
 			}
 		}
-	}
 
-	// Fast uniform-grid searching approach (WARNING: can not do multiple indices per pos. (i.e., when pos. is on the edge of several cells))
-	int ER_LightProbesManager::GetCellIndex(const XMFLOAT3& pos, ER_ProbeType aType)
-	{
-		int finalIndex = -1;
+		probes[aIndex].SetPosition(aPosition);
+		if (aType == SPECULAR_PROBE)
+			mSpecularProbesVolumeValid = false; // re-cull the volume on the next update
 
-		if (aType == DIFFUSE_PROBE)
+		for (UINT cellIndex : affectedCells)
 		{
-			int xIndex = floor((pos.x - mSceneProbesMinBounds.x) / static_cast<float>(mDistanceBetweenDiffuseProbes));
-			int yIndex = floor((pos.y - mSceneProbesMinBounds.y) / static_cast<float>(mDistanceBetweenDiffuseProbes));
-			int zIndex = floor((pos.z - mSceneProbesMinBounds.z) / static_cast<float>(mDistanceBetweenDiffuseProbes));
-
-			if (xIndex < 0 || xIndex > mDiffuseProbesCellsCountX)
-				return -1;
-			if (yIndex < 0 || yIndex > mDiffuseProbesCellsCountY)
-				return -1;
-			if (zIndex < 0 || zIndex > mDiffuseProbesCellsCountZ)
-				return -1;
-
-			//little hacky way to prevent from out-of-bounds
-			if (xIndex == mDiffuseProbesCellsCountX)
-				xIndex = mDiffuseProbesCellsCountX - 1;
-			if (yIndex == mDiffuseProbesCellsCountY)
-				yIndex = mDiffuseProbesCellsCountY - 1;
-			if (zIndex == mDiffuseProbesCellsCountZ)
-				zIndex = mDiffuseProbesCellsCountZ - 1;
-
-			finalIndex = yIndex * (mDiffuseProbesCellsCountX * mDiffuseProbesCellsCountZ) + xIndex * mDiffuseProbesCellsCountZ + zIndex;
-
-			if (finalIndex >= mDiffuseProbesCellsCountTotal)
-				return -1;
+			AddProbesToCell(cells[cellIndex], aType);
+			UpdateProbesCellsIndicesCPUBuffer(aType, static_cast<int>(cellIndex));
 		}
-		else
-		{
-			int xIndex = floor((pos.x - mSceneProbesMinBounds.x) / static_cast<float>(mDistanceBetweenSpecularProbes));
-			int yIndex = floor((pos.y - mSceneProbesMinBounds.y) / static_cast<float>(mDistanceBetweenSpecularProbes));
-			int zIndex = floor((pos.z - mSceneProbesMinBounds.z) / static_cast<float>(mDistanceBetweenSpecularProbes));
-
-			if (xIndex < 0 || xIndex > mSpecularProbesCellsCountX)
-				return -1;
-			if (yIndex < 0 || yIndex > mSpecularProbesCellsCountY)
-				return -1;
-			if (zIndex < 0 || zIndex > mSpecularProbesCellsCountZ)
-				return -1;
-
-			//little hacky way to prevent from out-of-bounds
-			if (xIndex == mSpecularProbesCellsCountX)
-				xIndex = mSpecularProbesCellsCountX - 1;
-			if (yIndex == mSpecularProbesCellsCountY)
-				yIndex = mSpecularProbesCellsCountY - 1;
-			if (zIndex == mSpecularProbesCellsCountZ)
-				zIndex = mSpecularProbesCellsCountZ - 1;
-
-			finalIndex = yIndex * (mSpecularProbesCellsCountX * mSpecularProbesCellsCountZ) + xIndex * mSpecularProbesCellsCountZ + zIndex;
-
-			if (finalIndex >= mSpecularProbesCellsCountTotal)
-				return -1;
 
+		// buffers are not updated every frame, so all their versions have to get the new data
+		ER_RHI* rhi = game.GetRHI();
+		if (!affectedCells.empty())
+			rhi->UpdateBuffer(cellsIndicesGPUBuffer, cellsIndicesCPUBuffer.data(), static_cast<int>(sizeof(int) * cellsIndicesCPUBuffer.size()), true);
+
+		std::vector<XMFLOAT3> positionsCPUBuffer(probes.size());
+		for (size_t probeIndex = 0; probeIndex < probes.size(); probeIndex++)
+			positionsCPUBuffer[probeIndex] = probes[probeIndex].GetPosition();
+		rhi->UpdateBuffer(positionsGPUBuffer, positionsCPUBuffer.data(), static_cast<int>(sizeof(XMFLOAT3) * positionsCPUBuffer.size()), true);
+
+		if (probeRenderingObject)
+		{
+			auto& instancesData = probeRenderingObject->GetInstancesData();
+			instancesData[aIndex].World._41 = aPosition.x;
+			instancesData[aIndex].World._42 = aPosition.y;
+			instancesData[aIndex].World._43 = aPosition.z;
+			probeRenderingObject->UpdateInstanceBuffer(instancesData);
 		}
+		return true;
+	}
+
+	// Spatial hash lookup (cells can be of different sizes); if the pos. is on the edge of several cells, the one with the smallest index is returned
+	int ER_LightProbesManager::GetCellIndex(const XMFLOAT3& pos, ER_ProbeType aType)
+	{
+		const ER_SpatialHash& cellsHash = (aType == DIFFUSE_PROBE) ? mDiffuseProbesCellsHash : mSpecularProbesCellsHash;
 
-		return finalIndex;
+		cellsHash.QueryPoint(pos, mProbesQueryResult);
+		if (mProbesQueryResult.empty())
+			return -1;
+
+		return static_cast<int>(mProbesQueryResult[0]);
 	}
 
 	XMFLOAT4 ER_LightProbesManager::GetProbesCellsCount(ER_ProbeType aType)
@@ -484,26 +519,6 @@ namespace EveryRay_Core
 			return XMFLOAT4(mSpecularProbesCellsCountX, mSpecularProbesCellsCountY, mSpecularProbesCellsCountZ, mSpecularProbesCellsCountTotal);
 	}
 
-	bool ER_LightProbesManager::IsProbeInCell(ER_LightProbe& aProbe, ER_LightProbeCell& aCell, ER_AABB& aCellBounds)
-	{
-		XMFLOAT3 pos = aProbe.GetPosition();
-		float epsilon = 0.00001f;
-
-		XMFLOAT3 maxBounds = XMFLOAT3(
-			aCellBounds.second.x + aCell.position.x,
-			aCellBounds.second.y + aCell.position.y,
-			aCellBounds.second.z + aCell.position.z);
-
-		XMFLOAT3 minBounds = XMFLOAT3(
-			aCellBounds.first.x + aCell.position.x,
-			aCellBounds.first.y + aCell.position.y,
-			aCellBounds.first.z + aCell.position.z);
-
-		return	(pos.x <= (maxBounds.x + epsilon) && pos.x >= (minBounds.x - epsilon)) &&
-				(pos.y <= (maxBounds.y + epsilon) && pos.y >= (minBounds.y - epsilon)) &&
-				(pos.z <= (maxBounds.z + epsilon) && pos.z >= (minBounds.z - epsilon));
-	}
-
 	void ER_LightProbesManager::ComputeOrLoadGlobalProbes(ER_Core& game, ProbesRenderingObjectsInfo& aObjects, ER_Skybox* skybox)
 	{
 		assert(skybox);
@@ -549,47 +564,46 @@ namespace EveryRay_Core
 	{
 		ER_RHI* rhi = game.GetRHI();
 
-		int numThreads = std::thread::hardware_concurrency();
-		if (game.GetRHI()->GetAPI() != ER_GRAPHICS_API::DX11)
-			numThreads = 1; //TODO fix this on DX12 (need to support multiple command lists)
-
-		assert(numThreads > 0);
-
 		if (mDistanceBetweenDiffuseProbes <= 0.0)
 			mDiffuseProbesReady = true;
+		if (mDistanceBetweenSpecularProbes <= 0.0)
+			mSpecularProbesReady = true;
+		if (mDiffuseProbesReady && mSpecularProbesReady)
+			return;
 
-		if (!mDiffuseProbesReady && mDistanceBetweenDiffuseProbes > 0)
-		{
-			std::wstring diffuseProbesPath = mLevelPath + L"diffuse_probes\\";
-			
-			std::vector<std::thread> threads;
-			threads.reserve(numThreads);
+		// all local probes of the level are either loaded from its archive or computed (and saved to a new archive)
+		const std::string archivePath = GetProbesArchivePath();
+		const UINT64 archiveContentHash = GetProbesArchiveContentHash();
+		const ER_LightProbesArchiveGrid diffuseGrid = GetProbesArchiveGrid(DIFFUSE_PROBE);
+		const ER_LightProbesArchiveGrid specularGrid = GetProbesArchiveGrid(SPECULAR_PROBE);
 
-			int probesPerThread = mDiffuseProbes.size() / numThreads;
+		ER_LightProbesArchive archive;
+		const bool isArchiveLoaded = archive.Load(archivePath, archiveContentHash, diffuseGrid, specularGrid, SPHERICAL_HARMONICS_COEF_COUNT);
+		if (isArchiveLoaded)
+		{
+			std::string message = "[ER Logger][ER_LightProbesManager] Loaded light probes archive: " + archivePath + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+		else
+		{
+			std::string message = "[ER Logger][ER_LightProbesManager] Light probes archive is missing or stale: " + archivePath + ". Local probes will be loaded from the old per-probe files (or recomputed) and saved to it. \n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
 
-			for (int i = 0; i < numThreads; i++)
-			{
-				threads.push_back(std::thread([&, diffuseProbesPath, i]
-				{ 
-					int endRange = (i < numThreads - 1) ? (i + 1) * probesPerThread : mDiffuseProbes.size();
-					for (int j = i * probesPerThread; j < endRange; j++)
-						mDiffuseProbes[j].LoadProbeFromDisk(game, diffuseProbesPath);
-				}));
-			}
-			for (auto& t : threads) t.join();
+		std::vector<XMFLOAT3> shCPUBuffer;
+		if (!mDiffuseProbesReady)
+		{
+			std::wstring diffuseProbesPath = mLevelPath + L"diffuse_probes\\";
 
-			for (auto& probe : mDiffuseProbes)
+			for (int probeIndex = 0; probeIndex < mDiffuseProbesCountTotal; probeIndex++)
 			{
-				if (!probe.IsLoadedFromDisk())
+				if (isArchiveLoaded)
+					mDiffuseProbes[probeIndex].SetSphericalHarmonics(archive.GetSphericalHarmonics(probeIndex));
+				else if (!mDiffuseProbes[probeIndex].LoadLegacySphericalHarmonics(diffuseProbesPath))
 				{
-					if (game.GetRHI()->GetAPI() == ER_GRAPHICS_API::DX11)
-						probe.Compute(game, mTempDiffuseCubemapFacesRT, mTempDiffuseCubemapFacesConvolutedRT, mTempDiffuseCubemapDepthBuffers, diffuseProbesPath, aObjects, mQuadRenderer, skybox);
-					else
+					if (rhi->GetAPI() != ER_GRAPHICS_API::DX11)
 						throw ER_CoreException("ER_LightProbesManager: Computing & saving the probes is only possible on DX11 at the moment");
-				}
-				else
-				{
-					//TODO load empty
+					mDiffuseProbes[probeIndex].Compute(game, mTempDiffuseCubemapFacesRT, mTempDiffuseCubemapFacesConvolutedRT, mTempDiffuseCubemapDepthBuffers, diffuseProbesPath, aObjects, mQuadRenderer, skybox);
 				}
 			}
 			
@@ -597,8 +611,8 @@ namespace EveryRay_Core
 
 			UpdateProbesByType(game, DIFFUSE_PROBE);
 
-			// SH GPU buffer
-			XMFLOAT3* shCPUBuffer = new XMFLOAT3[mDiffuseProbesCountTotal * SPHERICAL_HARMONICS_COEF_COUNT];
+			// SH GPU buffer (same layout as in the archive)
+			shCPUBuffer.resize(mDiffuseProbesCountTotal * SPHERICAL_HARMONICS_COEF_COUNT);
 			for (int probeIndex = 0; probeIndex < mDiffuseProbesCountTotal; probeIndex++)
 			{
 				const std::vector<XMFLOAT3>& sh = mDiffuseProbes[probeIndex].GetSphericalHarmonics();
@@ -606,54 +620,143 @@ namespace EveryRay_Core
 					shCPUBuffer[probeIndex * SPHERICAL_HARMONICS_COEF_COUNT + i] = sh[i];
 			}
 			mDiffuseProbesSphericalHarmonicsGPUBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: diffuse probes SH buffer");
-			mDiffuseProbesSphericalHarmonicsGPUBuffer->CreateGPUBufferResource(rhi, shCPUBuffer, mDiffuseProbesCountTotal* SPHERICAL_HARMONICS_COEF_COUNT, sizeof(XMFLOAT3),
+			mDiffuseProbesSphericalHarmonicsGPUBuffer->CreateGPUBufferResource(rhi, shCPUBuffer.data(), mDiffuseProbesCountTotal* SPHERICAL_HARMONICS_COEF_COUNT, sizeof(XMFLOAT3),
 				false, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
-			DeleteObjects(shCPUBuffer);
 		}
 
-		if (mDistanceBetweenSpecularProbes <= 0.0)
-			mSpecularProbesReady = true;
-		if (!mSpecularProbesReady && mDistanceBetweenSpecularProbes > 0)
+		std::wstring specularProbesPath = mLevelPath + L"specular_probes\\";
+		if (!mSpecularProbesReady)
 		{
-			std::wstring specularProbesPath = mLevelPath + L"specular_probes\\";
+			if (isArchiveLoaded)
+			{
+				int numThreads = std::thread::hardware_concurrency();
+				if (rhi->GetAPI() != ER_GRAPHICS_API::DX11)
+					numThreads = 1; //TODO fix this on DX12 (need to support multiple command lists)
+				assert(numThreads > 0);
 
-			std::vector<std::thread> threads;
-			int numThreads = std::thread::hardware_concurrency();
-			if (game.GetRHI()->GetAPI() != ER_GRAPHICS_API::DX11)
-				numThreads = 1; //TODO fix this on DX12 (need to support multiple command lists)
+				std::vector<std::thread> threads;
+				threads.reserve(numThreads);
 
-			threads.reserve(numThreads);
+				int probesPerThread = mSpecularProbes.size() / numThreads;
 
-			int probesPerThread = mSpecularProbes.size() / numThreads;
+				for (int i = 0; i < numThreads; i++)
+				{
+					threads.push_back(std::thread([&, i]
+					{
+						int endRange = (i < numThreads - 1) ? (i + 1) * probesPerThread : mSpecularProbes.size();
+						for (int j = i * probesPerThread; j < endRange; j++)
+						{
+							UINT64 cubemapSize = 0;
+							const char* cubemapData = archive.GetCubemapData(j, cubemapSize);
+							mSpecularProbes[j].LoadProbeFromMemory(game, cubemapData, cubemapSize);
+						}
+					}));
+				}
+				for (auto& t : threads) t.join();
 
-			for (int i = 0; i < numThreads; i++)
-			{
-				threads.push_back(std::thread([&, specularProbesPath, i]
+				for (auto& probe : mSpecularProbes)
 				{
-					int endRange = (i < numThreads - 1) ? (i + 1) * probesPerThread : mSpecularProbes.size();
-					for (int j = i * probesPerThread; j < endRange; j++)
-						mSpecularProbes[j].LoadProbeFromDisk(game, specularProbesPath);
-				}));
+					if (!probe.IsLoadedFromDisk())
+						throw ER_CoreException("ER_LightProbesManager: Could not create a specular probe's cubemap from the light probes archive");
+				}
 			}
-			for (auto& t : threads) t.join();
-
-			for (auto& probe : mSpecularProbes)
+			else
 			{
-				if (!probe.IsLoadedFromDisk())
+				// old per-probe DDS files have the same names as the ones that are computed (and moved into the archive below)
+				for (auto& probe : mSpecularProbes)
 				{
-					if (game.GetRHI()->GetAPI() == ER_GRAPHICS_API::DX11)
-						probe.Compute(game, mTempSpecularCubemapFacesRT, mTempSpecularCubemapFacesConvolutedRT, mTempSpecularCubemapDepthBuffers, specularProbesPath, aObjects, mQuadRenderer, skybox);
-					else
+					if (probe.LoadProbeFromDisk(game, specularProbesPath))
+						continue;
+					if (rhi->GetAPI() != ER_GRAPHICS_API::DX11)
 						throw ER_CoreException("ER_LightProbesManager: Computing & saving the probes is only possible on DX11 at the moment");
-
-				}
-				else
-				{
-					//TODO load empty
+					probe.Compute(game, mTempSpecularCubemapFacesRT, mTempSpecularCubemapFacesConvolutedRT, mTempSpecularCubemapDepthBuffers, specularProbesPath, aObjects, mQuadRenderer, skybox);
 				}
 			}
 			mSpecularProbesReady = true;
 		}
+
+		archive.Close();
+		if (isArchiveLoaded)
+			return;
+
+		// computed (or old) cubemaps are separate DDS files: they are moved into the archive, like the old SH files
+		std::vector<std::wstring> cubemapPaths;
+		cubemapPaths.reserve(specularGrid.ProbesCount);
+		for (UINT i = 0; i < specularGrid.ProbesCount; i++)
+			cubemapPaths.push_back(mSpecularProbes[i].GetConstructedProbeName(specularProbesPath));
+
+		if (ER_LightProbesArchive::Save(archivePath, archiveContentHash, diffuseGrid, specularGrid, shCPUBuffer.data(), SPHERICAL_HARMONICS_COEF_COUNT, cubemapPaths))
+		{
+			for (auto& path : cubemapPaths)
+				DeleteFileW(path.c_str());
+			const std::wstring diffuseProbesPath = mLevelPath + L"diffuse_probes\\";
+			for (UINT i = 0; i < diffuseGrid.ProbesCount; i++)
+				DeleteFileW(mDiffuseProbes[i].GetLegacySphericalHarmonicsName(diffuseProbesPath).c_str());
+
+			std::string message = "[ER Logger][ER_LightProbesManager] Saved light probes archive: " + archivePath + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+		else
+		{
+			std::string message = "[ER Logger][ER_LightProbesManager] Failed to save light probes archive: " + archivePath + ". Local probes will be recomputed on the next load. \n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+	}
+
+	std::string ER_LightProbesManager::GetProbesArchivePath() const
+	{
+		return std::string(mLevelPath.begin(), mLevelPath.end()) + ER_LIGHT_PROBES_ARCHIVE_FILE_NAME;
+	}
+
+	// everything that the local probes depend on besides the grids (validated separately) and ER_LIGHT_PROBES_ARCHIVE_VERSION
+	UINT64 ER_LightProbesManager::GetProbesArchiveContentHash() const
+	{
+		struct ProbesSettings
+		{
+			UINT64 SceneContentHash;
+			XMFLOAT3 SunDirection;
+			XMFLOAT3 SunColor;
+			UINT32 DiffuseProbeSize;
+			UINT32 SpecularProbeSize;
+			UINT32 SpecularProbeMipCount;
+			UINT32 SphericalHarmonicsOrder;
+		} settings;
+		ZeroMemory(&settings, sizeof(settings));
+		settings.SceneContentHash = mSceneContentHash;
+		settings.SunDirection = mSceneSunDirection;
+		settings.SunColor = mSceneSunColor;
+		settings.DiffuseProbeSize = DIFFUSE_PROBE_SIZE;
+		settings.SpecularProbeSize = SPECULAR_PROBE_SIZE;
+		settings.SpecularProbeMipCount = SPECULAR_PROBE_MIP_COUNT;
+		settings.SphericalHarmonicsOrder = SPHERICAL_HARMONICS_ORDER;
+
+		return ER_Utility::HashData(&settings, sizeof(settings));
+	}
+
+	ER_LightProbesArchiveGrid ER_LightProbesManager::GetProbesArchiveGrid(ER_ProbeType aType) const
+	{
+		ER_LightProbesArchiveGrid grid;
+		ZeroMemory(&grid, sizeof(grid));
+
+		if (aType == DIFFUSE_PROBE && mDistanceBetweenDiffuseProbes > 0)
+		{
+			grid.MinBounds = mSceneProbesMinBounds;
+			grid.Distance = mDistanceBetweenDiffuseProbes;
+			grid.CountX = static_cast<UINT32>(mDiffuseProbesCountX);
+			grid.CountY = static_cast<UINT32>(mDiffuseProbesCountY);
+			grid.CountZ = static_cast<UINT32>(mDiffuseProbesCountZ);
+			grid.ProbesCount = static_cast<UINT32>(mDiffuseProbesCountTotal);
+		}
+		else if (aType == SPECULAR_PROBE && mDistanceBetweenSpecularProbes > 0)
+		{
+			grid.MinBounds = mSceneProbesMinBounds;
+			grid.Distance = mDistanceBetweenSpecularProbes;
+			grid.CountX = static_cast<UINT32>(mSpecularProbesCountX);
+			grid.CountY = static_cast<UINT32>(mSpecularProbesCountY);
+			grid.CountZ = static_cast<UINT32>(mSpecularProbesCountZ);
+			grid.ProbesCount = static_cast<UINT32>(mSpecularProbesCountTotal);
+		}
+		return grid;
 	}
 
 	void ER_LightProbesManager::DrawDebugProbes(ER_RHI* rhi, ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_ProbeType aType, ER_RHI_GPURootSignature* rs)
@@ -663,7 +766,7 @@ namespace EveryRay_Core
 
 		ER_RenderingObject* probeObject = aType == DIFFUSE_PROBE ? mDiffuseProbeRenderingObject : mSpecularProbeRenderingObject;
 		bool ready = aType == DIFFUSE_PROBE ? (mDiffuseProbesReady && mDistanceBetweenDiffuseProbes > 0) : (mSpecularProbesReady && mDistanceBetweenSpecularProbes > 0);
-		std::string& psoName = DIFFUSE_PROBE ? mDiffuseDebugLightProbePassPSOName : mSpecularDebugLightProbePassPSOName;
+		const ER_RHI_PSOHandle& psoName = DIFFUSE_PROBE ? mDiffuseDebugLightProbePassPSOName : mSpecularDebugLightProbePassPSOName;
 
 		ER_MaterialSystems materialSystems;
 		materialSystems.mProbesManager = this;
@@ -710,24 +813,49 @@ namespace EveryRay_Core
 		{
 			if (!mSpecularProbesReady || mDistanceBetweenSpecularProbes <= 0)
 				return;
-
-			mNonCulledSpecularProbesCount = 0;
-			mNonCulledSpecularProbesIndices.clear();
 		}
 
 		if (aType == SPECULAR_PROBE)
 		{
-			XMFLOAT3 minBounds = XMFLOAT3(
-				-mSpecularProbesVolumeSize + mMainCamera.Position().x,
-				-mSpecularProbesVolumeSize + mMainCamera.Position().y,
-				-mSpecularProbesVolumeSize + mMainCamera.Position().z);
-			XMFLOAT3 maxBounds = XMFLOAT3(
-				mSpecularProbesVolumeSize + mMainCamera.Position().x,
-				mSpecularProbesVolumeSize + mMainCamera.Position().y,
-				mSpecularProbesVolumeSize + mMainCamera.Position().z);
-
-			for (auto& lightProbe : probes)
-				lightProbe.CPUCullAgainstProbeBoundingVolume(minBounds, maxBounds);
+			const XMFLOAT3 cameraPosition = mMainCamera.Position();
+			const bool isVolumeMoved = !mSpecularProbesVolumeValid ||
+				cameraPosition.x != mSpecularProbesVolumeCenter.x || cameraPosition.y != mSpecularProbesVolumeCenter.y || cameraPosition.z != mSpecularProbesVolumeCenter.z;
+			if (isVolumeMoved)
+			{
+				XMFLOAT3 minBounds = XMFLOAT3(
+					-mSpecularProbesVolumeSize + cameraPosition.x,
+					-mSpecularProbesVolumeSize + cameraPosition.y,
+					-mSpecularProbesVolumeSize + cameraPosition.z);
+				XMFLOAT3 maxBounds = XMFLOAT3(
+					mSpecularProbesVolumeSize + cameraPosition.x,
+					mSpecularProbesVolumeSize + cameraPosition.y,
+					mSpecularProbesVolumeSize + cameraPosition.z);
+
+				mNonCulledSpecularProbesIndices.clear();
+				for (int i = 0; i < static_cast<int>(probes.size()); i++)
+				{
+					probes[i].CPUCullAgainstProbeBoundingVolume(minBounds, maxBounds);
+					if (!probes[i].IsCulled())
+						mNonCulledSpecularProbesIndices.push_back(i);
+				}
+
+				// nearest probes get the free slots first
+				const XMVECTOR cameraPositionVec = XMLoadFloat3(&cameraPosition);
+				std::sort(mNonCulledSpecularProbesIndices.begin(), mNonCulledSpecularProbesIndices.end(), [&](int a, int b)
+				{
+					const float distanceA = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&probes[a].GetPosition()), cameraPositionVec)));
+					const float distanceB = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&probes[b].GetPosition()), cameraPositionVec)));
+					return (distanceA != distanceB) ? (distanceA < distanceB) : (a < b);
+				});
+
+				mSpecularProbesVolumeCenter = cameraPosition;
+				mSpecularProbesVolumeValid = true;
+			}
+
+			// only the probes entering the volume are copied to the array (within the budget), the resident ones keep their slots
+			mSpecularProbesResidency.Update(mNonCulledSpecularProbesIndices, mSpecularProbesCopyBudget, mSpecularProbesCopies);
+			if (!isVolumeMoved && mSpecularProbesCopies.empty())
+				return; // nothing has changed since the last frame
 		}
 
 		if (probeRenderingObject)
@@ -738,8 +866,6 @@ namespace EveryRay_Core
 			for (int i = 0; i < oldInstancedData.size(); i++)
 			{
 				bool isCulled = probes[i].IsCulled();
-				//writing culling flag to [4][4] of world instanced matrix
-				oldInstancedData[i].World._44 = isCulled ? 1.0f : 0.0f;
 				//writing cubemap index to [0][0] of world instanced matrix (since we don't need scale)
 				oldInstancedData[i].World._11 = -1.0f;
 				if (!isCulled)
@@ -748,11 +874,13 @@ namespace EveryRay_Core
 						oldInstancedData[i].World._11 = static_cast<float>(i);
 					else
 					{
-						oldInstancedData[i].World._11 = static_cast<float>(mNonCulledSpecularProbesCount);
-						mNonCulledSpecularProbesCount++;
-						mNonCulledSpecularProbesIndices.push_back(i);
+						const int slot = mSpecularProbesResidency.GetSlot(i);
+						oldInstancedData[i].World._11 = static_cast<float>(slot);
+						isCulled = (slot == -1); // not in the array yet
 					}
 				}
+				//writing culling flag to [4][4] of world instanced matrix
+				oldInstancedData[i].World._44 = isCulled ? 1.0f : 0.0f;
 			}
 
 			probeRenderingObject->UpdateInstanceBuffer(oldInstancedData);
@@ -761,39 +889,41 @@ namespace EveryRay_Core
 		ER_RHI* rhi = game.GetRHI();
 		if (aType == SPECULAR_PROBE)
 		{
-			for (int i = 0; i < mSpecularProbesCountTotal; i++)
-				mSpecularProbesTexArrayIndicesCPUBuffer[i] = -1;
-
-			for (int i = 0; i < mMaxSpecularProbesInVolumeCount; i++)
+			for (const ER_LightProbesResidencyCopy& copy : mSpecularProbesCopies)
 			{
-				if (i < mNonCulledSpecularProbesIndices.size() && i < probes.size())
-				{
-					int probeIndex = mNonCulledSpecularProbesIndices[i];
+				ER_RHI_GPUTexture* probeCubemap = mSpecularProbes[copy.Probe].GetCubemapTexture();
 
-					rhi->TransitionResources({ static_cast<ER_RHI_GPUResource*>(mSpecularCubemapArrayRT), static_cast<ER_RHI_GPUResource*>(mSpecularProbes[probeIndex].GetCubemapTexture()) },
-						{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_SOURCE }, rhi->GetCurrentGraphicsCommandListIndex());
+				rhi->TransitionResources({ static_cast<ER_RHI_GPUResource*>(mSpecularCubemapArrayRT), static_cast<ER_RHI_GPUResource*>(probeCubemap) },
+					{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_SOURCE }, rhi->GetCurrentGraphicsCommandListIndex());
 
-					for (int cubeI = 0; cubeI < CUBEMAP_FACES_COUNT; cubeI++)
+				for (int cubeI = 0; cubeI < CUBEMAP_FACES_COUNT; cubeI++)
+				{
+					for (int mip = 0; mip < SPECULAR_PROBE_MIP_COUNT; mip++)
 					{
-						for (int mip = 0; mip < SPECULAR_PROBE_MIP_COUNT; mip++)
-						{
-							rhi->CopyGPUTextureSubresourceRegion(mSpecularCubemapArrayRT, mip + (cubeI + CUBEMAP_FACES_COUNT * i) * SPECULAR_PROBE_MIP_COUNT, 0, 0, 0,
-								mSpecularProbes[probeIndex].GetCubemapTexture(), mip + cubeI * SPECULAR_PROBE_MIP_COUNT, true);
-						}
+						rhi->CopyGPUTextureSubresourceRegion(mSpecularCubemapArrayRT, mip + (cubeI + CUBEMAP_FACES_COUNT * copy.Slot) * SPECULAR_PROBE_MIP_COUNT, 0, 0, 0,
+							probeCubemap, mip + cubeI * SPECULAR_PROBE_MIP_COUNT, true);
 					}
-					mSpecularProbesTexArrayIndicesCPUBuffer[probeIndex] = CUBEMAP_FACES_COUNT * i;
-
-					rhi->TransitionResources({ static_cast<ER_RHI_GPUResource*>(mSpecularCubemapArrayRT), static_cast<ER_RHI_GPUResource*>(mSpecularProbes[probeIndex].GetCubemapTexture()) },
-						{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE }, rhi->GetCurrentGraphicsCommandListIndex());
 				}
+
+				rhi->TransitionResources({ static_cast<ER_RHI_GPUResource*>(mSpecularCubemapArrayRT), static_cast<ER_RHI_GPUResource*>(probeCubemap) },
+					{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE }, rhi->GetCurrentGraphicsCommandListIndex());
+			}
+
+			for (int i = 0; i < mSpecularProbesCountTotal; i++)
+				mSpecularProbesTexArrayIndicesCPUBuffer[i] = -1;
+			for (int probeIndex : mNonCulledSpecularProbesIndices)
+			{
+				const int slot = mSpecularProbesResidency.GetSlot(probeIndex);
+				if (slot != -1)
+					mSpecularProbesTexArrayIndicesCPUBuffer[probeIndex] = CUBEMAP_FACES_COUNT * slot;
 			}
-			rhi->UpdateBuffer(mSpecularProbesTexArrayIndicesGPUBuffer, mSpecularProbesTexArrayIndicesCPUBuffer, sizeof(mSpecularProbesTexArrayIndicesCPUBuffer[0]) * mSpecularProbesCountTotal);
+			// not uploaded in the frames without changes (see above), so all versions of the buffer have to get the new indices
+			rhi->UpdateBuffer(mSpecularProbesTexArrayIndicesGPUBuffer, mSpecularProbesTexArrayIndicesCPUBuffer, sizeof(mSpecularProbesTexArrayIndicesCPUBuffer[0]) * mSpecularProbesCountTotal, true);
 		}
 	}
 
 	void ER_LightProbesManager::UpdateProbes(ER_Core& game)
 	{
-		//int difProbeCellIndexCamera = GetCellIndex(mMainCamera.Position(), DIFFUSE_PROBE);
 		if (mDistanceBetweenSpecularProbes > 0)
 			assert(mMaxSpecularProbesInVolumeCount > 0);
 
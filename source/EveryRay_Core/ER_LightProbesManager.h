@@ -15,6 +15,9 @@
 #include "Common.h"
 #include "ER_RenderingObject.h"
 #include "ER_LightProbe.h"
+#include "ER_LightProbesArchive.h"
+#include "ER_SpatialHash.h"
+#include "ER_LightProbesResidency.h"
 #include "RHI/ER_RHI.h"
 
 namespace EveryRay_Core
@@ -38,7 +41,8 @@ namespace EveryRay_Core
 	struct ER_LightProbeCell
 	{
 		XMFLOAT3 position;
-		std::vector<int> lightProbeIndices;
+		ER_AABB bounds; // in world space (cells do not have to be of the same size)
+		std::vector<int> lightProbeIndices; // sorted
 		int index;
 	};
 
@@ -56,6 +60,10 @@ namespace EveryRay_Core
 		void DrawDebugProbes(ER_RHI* rhi, ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_ProbeType aType, ER_RHI_GPURootSignature* rs);
 		void UpdateProbes(ER_Core& game);
 		int GetCellIndex(const XMFLOAT3& pos, ER_ProbeType aType);
+		// Moves a local probe and only updates the cells around its old and new positions (probe's lighting is not recomputed);
+		// returns false (and keeps the probe) if a cell would get more than PROBE_COUNT_PER_CELL probes
+		bool UpdateProbePosition(ER_Core& game, ER_ProbeType aType, int aIndex, const XMFLOAT3& aPosition);
+		int GetProbesCount(ER_ProbeType aType) const { return (aType == DIFFUSE_PROBE) ? mDiffuseProbesCountTotal : mSpecularProbesCountTotal; }
 
 		ER_LightProbe* GetGlobalDiffuseProbe() const { return mGlobalDiffuseProbe; }
 		const ER_LightProbe& GetDiffuseLightProbe(int index) const { return mDiffuseProbes[index]; }
@@ -71,6 +79,9 @@ namespace EveryRay_Core
 		ER_RHI_GPUBuffer* GetSpecularProbesTexArrayIndicesBuffer() const { return mSpecularProbesTexArrayIndicesGPUBuffer; }
 		ER_RHI_GPUBuffer* GetSpecularProbesPositionsBuffer() const { return mSpecularProbesPositionsGPUBuffer; }
 		float GetDistanceBetweenSpecularProbes() { return mDistanceBetweenSpecularProbes; }
+		const ER_LightProbesResidencyStats& GetSpecularProbesResidencyStats() const { return mSpecularProbesResidency.GetStats(); }
+		UINT GetSpecularProbesCopyBudget() const { return mSpecularProbesCopyBudget; }
+		void SetSpecularProbesCopyBudget(UINT aBudget) { mSpecularProbesCopyBudget = aBudget; }
 
 		ER_RHI_GPUTexture* GetIntegrationMap() { return mIntegrationMapTextureSRV; }
 		
@@ -87,9 +98,14 @@ namespace EveryRay_Core
 		void SetupGlobalSpecularProbe(ER_Core& game, ER_Camera& camera, ER_Scene* scene, ER_DirectionalLight* light, ER_ShadowMapper* shadowMapper);
 		void SetupDiffuseProbes(ER_Core& game, ER_Camera& camera, ER_Scene* scene, ER_DirectionalLight* light, ER_ShadowMapper* shadowMapper);
 		void SetupSpecularProbes(ER_Core& game, ER_Camera& camera, ER_Scene* scene, ER_DirectionalLight* light, ER_ShadowMapper* shadowMapper);
-		void AddProbeToCells(ER_LightProbe& aProbe, ER_ProbeType aType, const XMFLOAT3& minBounds, const XMFLOAT3& maxBounds);
-		bool IsProbeInCell(ER_LightProbe& aProbe, ER_LightProbeCell& aCell, ER_AABB& aCellBounds);
+		void AssignProbesToCells(ER_ProbeType aType);
+		void AddProbesToCell(ER_LightProbeCell& aCell, ER_ProbeType aType);
+		void QueryProbesInCell(const ER_LightProbeCell& aCell, ER_ProbeType aType); // to mProbesQueryResult
+		void UpdateProbesCellsIndicesCPUBuffer(ER_ProbeType aType, int aCellIndex);
 		void UpdateProbesByType(ER_Core& game, ER_ProbeType aType);
+		std::string GetProbesArchivePath() const;
+		UINT64 GetProbesArchiveContentHash() const;
+		ER_LightProbesArchiveGrid GetProbesArchiveGrid(ER_ProbeType aType) const;
 		
 		ER_QuadRenderer* mQuadRenderer = nullptr;
 		ER_Camera& mMainCamera;
@@ -104,7 +120,7 @@ namespace EveryRay_Core
 		// Diffuse probes members
 		std::vector<ER_LightProbe> mDiffuseProbes;
 		ER_RenderingObject* mDiffuseProbeRenderingObject = nullptr;
-		std::string mDiffuseDebugLightProbePassPSOName = "ER_RHI_GPUPipelineStateObject: Light Probes Manager - Diffuse Debug Probe Pass";
+		ER_RHI_PSOHandle mDiffuseDebugLightProbePassPSOName = "ER_RHI_GPUPipelineStateObject: Light Probes Manager - Diffuse Debug Probe Pass";
 		ER_RHI_GPUBuffer* mDiffuseProbesCellsIndicesGPUBuffer = nullptr;
 		ER_RHI_GPUBuffer* mDiffuseProbesPositionsGPUBuffer = nullptr;
 		ER_RHI_GPUBuffer* mDiffuseProbesSphericalHarmonicsGPUBuffer = nullptr;
@@ -112,7 +128,9 @@ namespace EveryRay_Core
 		ER_RHI_GPUTexture* mTempDiffuseCubemapFacesConvolutedRT = nullptr;
 		ER_RHI_GPUTexture* mTempDiffuseCubemapDepthBuffers[CUBEMAP_FACES_COUNT] = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
 		std::vector<ER_LightProbeCell> mDiffuseProbesCells;
-		ER_AABB mDiffuseProbesCellBounds;
+		std::vector<int> mDiffuseProbesCellsIndicesCPUBuffer;
+		ER_SpatialHash mDiffuseProbesHash; // of the probes positions
+		ER_SpatialHash mDiffuseProbesCellsHash; // of the cells bounds
 		int mDiffuseProbesCountTotal = 0;
 		int mDiffuseProbesCountX = 0;
 		int mDiffuseProbesCountY = 0;
@@ -129,7 +147,7 @@ namespace EveryRay_Core
 		// Specular probes members
 		std::vector<ER_LightProbe> mSpecularProbes;
 		ER_RenderingObject* mSpecularProbeRenderingObject = nullptr;
-		std::string mSpecularDebugLightProbePassPSOName = "ER_RHI_GPUPipelineStateObject: Light Probes Manager - Specular Debug Probe Pass";
+		ER_RHI_PSOHandle mSpecularDebugLightProbePassPSOName = "ER_RHI_GPUPipelineStateObject: Light Probes Manager - Specular Debug Probe Pass";
 		int* mSpecularProbesTexArrayIndicesCPUBuffer = nullptr;
 		ER_RHI_GPUBuffer* mSpecularProbesTexArrayIndicesGPUBuffer = nullptr;
 		ER_RHI_GPUBuffer* mSpecularProbesCellsIndicesGPUBuffer = nullptr;
@@ -139,8 +157,15 @@ namespace EveryRay_Core
 		ER_RHI_GPUTexture* mTempSpecularCubemapDepthBuffers[CUBEMAP_FACES_COUNT] = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
 		ER_RHI_GPUTexture* mSpecularCubemapArrayRT = nullptr;
 		std::vector<ER_LightProbeCell> mSpecularProbesCells;
-		ER_AABB mSpecularProbesCellBounds;
-		std::vector<int> mNonCulledSpecularProbesIndices;
+		std::vector<int> mSpecularProbesCellsIndicesCPUBuffer;
+		ER_SpatialHash mSpecularProbesHash; // of the probes positions
+		ER_SpatialHash mSpecularProbesCellsHash; // of the cells bounds
+		std::vector<int> mNonCulledSpecularProbesIndices; // sorted by the distance to the camera
+		ER_LightProbesResidency mSpecularProbesResidency; // slots of mSpecularCubemapArrayRT
+		std::vector<ER_LightProbesResidencyCopy> mSpecularProbesCopies; // of the current frame
+		UINT mSpecularProbesCopyBudget = ER_LIGHT_PROBES_RESIDENCY_DEFAULT_COPY_BUDGET;
+		XMFLOAT3 mSpecularProbesVolumeCenter; // camera position of the last culling
+		bool mSpecularProbesVolumeValid = false;
 		int mSpecularProbesCountTotal = 0;
 		int mSpecularProbesCountX = 0;
 		int mSpecularProbesCountY = 0;
@@ -149,7 +174,6 @@ namespace EveryRay_Core
 		int mSpecularProbesCellsCountY = 0;
 		int mSpecularProbesCellsCountZ = 0;
 		int mSpecularProbesCellsCountTotal = 0;
-		int mNonCulledSpecularProbesCount = 0;
 		bool mSpecularProbesReady = false;
 		ER_LightProbe* mGlobalSpecularProbe = nullptr;
 		bool mGlobalSpecularProbeReady = false;
@@ -157,7 +181,11 @@ namespace EveryRay_Core
 		float mSpecularProbesVolumeSize = 0.0f;
 		int mMaxSpecularProbesInVolumeCount = 0;
 
+		std::vector<UINT> mProbesQueryResult; // scratch for the spatial hashes queries
 		std::wstring mLevelPath;
+		UINT64 mSceneContentHash = 0;
+		XMFLOAT3 mSceneSunDirection;
+		XMFLOAT3 mSceneSunColor;
 		bool mEnabled = true;
 	};
 }
\ No newline at end of file
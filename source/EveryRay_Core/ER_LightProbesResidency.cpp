@@ -0,0 +1,83 @@
+#include "stdafx.h"
+
+#include "ER_LightProbesResidency.h"
+
+namespace EveryRay_Core
+{
+	void ER_LightProbesResidency::Initialize(UINT aSlotsCount, UINT aProbesCount)
+	{
+		mProbeSlots.assign(aProbesCount, -1);
+		mSlotProbes.assign(aSlotsCount, -1);
+		mSlotLastVisibleFrames.assign(aSlotsCount, 0);
+		mFreeSlots.resize(aSlotsCount);
+		for (UINT slot = 0; slot < aSlotsCount; slot++)
+			mFreeSlots[slot] = static_cast<int>(aSlotsCount - 1 - slot); // popped from the back, so the first slots go first
+		mFrame = 0;
+
+		mStats = ER_LightProbesResidencyStats();
+		mStats.SlotsCount = aSlotsCount;
+	}
+
+	void ER_LightProbesResidency::Update(const std::vector<int>& aVisibleProbes, UINT aCopyBudget, std::vector<ER_LightProbesResidencyCopy>& aOutCopies)
+	{
+		aOutCopies.clear();
+		mFrame++;
+		mStats.CopiesCount = 0;
+		mStats.EvictionsCount = 0;
+		mStats.PendingCount = 0;
+
+		// visible probes can not be evicted this frame
+		for (int probe : aVisibleProbes)
+		{
+			assert(probe >= 0 && probe < static_cast<int>(mProbeSlots.size()));
+			if (mProbeSlots[probe] != -1)
+				mSlotLastVisibleFrames[mProbeSlots[probe]] = mFrame;
+		}
+
+		for (int probe : aVisibleProbes)
+		{
+			if (mProbeSlots[probe] != -1)
+				continue;
+
+			const int slot = (aCopyBudget == 0 || mStats.CopiesCount < aCopyBudget) ? AcquireSlot() : -1;
+			if (slot == -1)
+			{
+				mStats.PendingCount++;
+				continue;
+			}
+
+			if (mSlotProbes[slot] != -1)
+			{
+				mProbeSlots[mSlotProbes[slot]] = -1;
+				mStats.EvictionsCount++;
+				mStats.ResidentCount--;
+			}
+			mSlotProbes[slot] = probe;
+			mSlotLastVisibleFrames[slot] = mFrame;
+			mProbeSlots[probe] = slot;
+			mStats.ResidentCount++;
+
+			aOutCopies.push_back({ static_cast<UINT>(probe), static_cast<UINT>(slot) });
+			mStats.CopiesCount++;
+		}
+	}
+
+	int ER_LightProbesResidency::AcquireSlot()
+	{
+		if (!mFreeSlots.empty())
+		{
+			const int slot = mFreeSlots.back();
+			mFreeSlots.pop_back();
+			return slot;
+		}
+
+		// least recently visible slot (slots of the probes visible this frame are not candidates)
+		int lruSlot = -1;
+		for (int slot = 0; slot < static_cast<int>(mSlotProbes.size()); slot++)
+		{
+			if (mSlotLastVisibleFrames[slot] < mFrame && (lruSlot == -1 || mSlotLastVisibleFrames[slot] < mSlotLastVisibleFrames[lruSlot]))
+				lruSlot = slot;
+		}
+		return lruSlot;
+	}
+}
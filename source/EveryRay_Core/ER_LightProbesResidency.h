@@ -0,0 +1,48 @@
+#pragma once
+#include "Common.h"
+
+#define ER_LIGHT_PROBES_RESIDENCY_DEFAULT_COPY_BUDGET 8 // probes copied to the slots per frame (0 - no limit)
+
+namespace EveryRay_Core
+{
+	struct ER_LightProbesResidencyStats
+	{
+		UINT CopiesCount = 0; // probes copied to the slots in the last Update()
+		UINT EvictionsCount = 0; // resident probes that lost their slots in the last Update()
+		UINT PendingCount = 0; // visible probes still without a slot after the last Update() (over the budget or no slot to evict)
+		UINT ResidentCount = 0;
+		UINT SlotsCount = 0;
+	};
+
+	struct ER_LightProbesResidencyCopy
+	{
+		UINT Probe;
+		UINT Slot;
+	};
+
+	// CPU side of the specular probes' residency in the cubemap array (no RHI): tracks which probe occupies which slot of the array,
+	// so that only the probes entering the volume are copied (in the order of priority, up to the copy budget per frame) and
+	// the slots are taken from the least recently visible probes (LRU). With a static camera there is nothing to copy.
+	class ER_LightProbesResidency
+	{
+	public:
+		ER_LightProbesResidency() {}
+		~ER_LightProbesResidency() {}
+
+		void Initialize(UINT aSlotsCount, UINT aProbesCount);
+		// "aVisibleProbes" are sorted by priority (the first ones get the slots first); copies to do this frame are written to "aOutCopies"
+		void Update(const std::vector<int>& aVisibleProbes, UINT aCopyBudget, std::vector<ER_LightProbesResidencyCopy>& aOutCopies);
+
+		int GetSlot(UINT aProbe) const { return mProbeSlots[aProbe]; } // -1 if the probe is not resident
+		const ER_LightProbesResidencyStats& GetStats() const { return mStats; }
+	private:
+		int AcquireSlot(); // free slot or the least recently visible one, -1 if all slots are visible
+
+		std::vector<int> mProbeSlots; // per probe
+		std::vector<int> mSlotProbes; // per slot (-1 if free)
+		std::vector<UINT64> mSlotLastVisibleFrames;
+		std::vector<int> mFreeSlots;
+		UINT64 mFrame = 0;
+		ER_LightProbesResidencyStats mStats;
+	};
+}
@@ -0,0 +1,65 @@
+#include "stdafx.h"
+
+#include "ER_MappedFile.h"
+
+namespace EveryRay_Core
+{
+	ER_MappedFile::~ER_MappedFile()
+	{
+		Close();
+	}
+
+	bool ER_MappedFile::Open(const std::string& aPath)
+	{
+		Close();
+
+		mFile = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		// empty files can not be mapped
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		mFileMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mFileMapping)
+		{
+			Close();
+			return false;
+		}
+
+		mData = static_cast<const char*>(MapViewOfFile(mFileMapping, FILE_MAP_READ, 0, 0, 0));
+		if (!mData)
+		{
+			Close();
+			return false;
+		}
+
+		mSize = static_cast<UINT64>(fileSize.QuadPart);
+		return true;
+	}
+
+	void ER_MappedFile::Close()
+	{
+		if (mData)
+		{
+			UnmapViewOfFile(mData);
+			mData = nullptr;
+		}
+		if (mFileMapping)
+		{
+			CloseHandle(mFileMapping);
+			mFileMapping = nullptr;
+		}
+		if (mFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(mFile);
+			mFile = INVALID_HANDLE_VALUE;
+		}
+		mSize = 0;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Common.h"
+
+namespace EveryRay_Core
+{
+	// Read-only memory-mapped file. Used for our binary caches (compiled scenes, meshes, etc.) that are stored in a "ready to use" layout.
+	class ER_MappedFile
+	{
+	public:
+		ER_MappedFile() {}
+		~ER_MappedFile();
+
+		bool Open(const std::string& aPath);
+		void Close();
+
+		bool IsOpen() const { return mData != nullptr; }
+		const char* GetData() const { return mData; }
+		UINT64 GetSize() const { return mSize; }
+	private:
+		ER_MappedFile(const ER_MappedFile&) = delete;
+		ER_MappedFile& operator=(const ER_MappedFile&) = delete;
+
+		HANDLE mFile = INVALID_HANDLE_VALUE;
+		HANDLE mFileMapping = nullptr;
+		const char* mData = nullptr;
+		UINT64 mSize = 0;
+	};
+}
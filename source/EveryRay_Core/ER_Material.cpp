@@ -7,6 +7,7 @@
 #include "ER_RenderingObject.h"
 #include "ER_Utility.h"
 #include "ER_MaterialsCallbacks.h"
+#include "ER_ShaderProgramRegistry.h"
 
 namespace EveryRay_Core
 {
@@ -25,10 +26,16 @@ namespace EveryRay_Core
 
 	ER_Material::~ER_Material()
 	{
-		DeleteObject(mInputLayout);
-		DeleteObject(mVertexShader);
-		DeleteObject(mGeometryShader);
-		DeleteObject(mPixelShader);
+		// shaders and input layout are shared between materials, so we only release our references
+		// (pointers are reset, because some materials call this destructor explicitly)
+		ER_ShaderProgramRegistry* registry = GetCore()->ShaderProgramRegistry();
+		registry->ReleaseShader(mVertexShader);
+		registry->ReleaseShader(mGeometryShader);
+		registry->ReleaseShader(mPixelShader);
+		mInputLayout = nullptr;
+		mVertexShader = nullptr;
+		mGeometryShader = nullptr;
+		mPixelShader = nullptr;
 	}
 
 	// Setting up the pipeline before the draw call
@@ -53,27 +60,18 @@ namespace EveryRay_Core
 
 	void ER_Material::CreateVertexShader(const std::string& path, ER_RHI_INPUT_ELEMENT_DESC* inputElementDescriptions, UINT inputElementDescriptionCount)
 	{
-		ER_RHI* rhi = GetCore()->GetRHI();
-
-		mInputLayout = rhi->CreateInputLayout(inputElementDescriptions, inputElementDescriptionCount);
-		mVertexShader = rhi->CreateGPUShader();
-		mVertexShader->CompileShader(GetCore()->GetRHI(), path, mShaderEntries.vertexEntry, ER_VERTEX, mInputLayout);
+		mVertexShader = GetCore()->ShaderProgramRegistry()->AddOrGetShader(GetCore()->GetRHI(), path, mShaderEntries.vertexEntry, ER_VERTEX,
+			inputElementDescriptions, inputElementDescriptionCount, &mInputLayout);
 	}
 
 	void ER_Material::CreatePixelShader(const std::string& path)
 	{
-		ER_RHI* rhi = GetCore()->GetRHI();
-
-		mPixelShader = rhi->CreateGPUShader();
-		mPixelShader->CompileShader(GetCore()->GetRHI(), path, mShaderEntries.pixelEntry, ER_PIXEL);
+		mPixelShader = GetCore()->ShaderProgramRegistry()->AddOrGetShader(GetCore()->GetRHI(), path, mShaderEntries.pixelEntry, ER_PIXEL);
 	}
 
 	void ER_Material::CreateGeometryShader(const std::string& path)
 	{
-		ER_RHI* rhi = GetCore()->GetRHI();
-
-		mGeometryShader = rhi->CreateGPUShader();
-		mGeometryShader->CompileShader(GetCore()->GetRHI(), path, mShaderEntries.geometryEntry, ER_GEOMETRY);
+		mGeometryShader = GetCore()->ShaderProgramRegistry()->AddOrGetShader(GetCore()->GetRHI(), path, mShaderEntries.geometryEntry, ER_GEOMETRY);
 	}
 
 	void ER_Material::CreateTessellationShader(const std::string& path)
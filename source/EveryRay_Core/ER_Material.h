@@ -51,6 +51,7 @@ namespace EveryRay_Core
 
 		bool IsStandard() { return mIsStandard; };
 	protected:
+		// shared with other materials (see ER_ShaderProgramRegistry), do not modify
 		ER_RHI_InputLayout* mInputLayout = nullptr;
 		ER_RHI_GPUShader* mVertexShader = nullptr;
 		ER_RHI_GPUShader* mPixelShader = nullptr;
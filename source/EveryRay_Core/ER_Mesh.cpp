@@ -3,6 +3,7 @@
 #include "ER_Mesh.h"
 #include "ER_Model.h"
 #include "ER_ModelMaterial.h"
+#include "ER_MeshCache.h"
 #include "ER_Core.h"
 #include "ER_CoreException.h"
 #include "ER_VertexDeclarations.h"
@@ -84,6 +85,78 @@ namespace EveryRay_Core
 				}
 			}
 		}
+
+		CalculateAABB();
+	}
+
+	ER_Mesh::ER_Mesh(ER_Model& model, ER_ModelMaterial& material, const ER_MeshCache& cache, UINT index) : mModel(model), mMaterial(material), mName(), mVertices(), mNormals(), mTangents(), mBiNormals(), mTextureCoordinates(), mVertexColors(), mFaceCount(0), mIndices()
+	{
+		const ER_MeshCacheMesh& cachedMesh = cache.GetMesh(index);
+		const UINT verticesCount = cachedMesh.VerticesCount;
+
+		mName = cache.GetString(cachedMesh.Name);
+		mFaceCount = cachedMesh.FaceCount;
+		mAABB = { cachedMesh.AABBMin, cachedMesh.AABBMax };
+
+		// bulk copies from the mapped file (data is stored exactly as the Assimp constructor above produces it)
+		if (verticesCount > 0)
+		{
+			const XMFLOAT3* positions = cache.GetData<XMFLOAT3>(cachedMesh.PositionsOffset);
+			mVertices.assign(positions, positions + verticesCount);
+
+			if (cachedMesh.NormalsOffset != ER_MESH_CACHE_INVALID_OFFSET)
+			{
+				const XMFLOAT3* normals = cache.GetData<XMFLOAT3>(cachedMesh.NormalsOffset);
+				mNormals.assign(normals, normals + verticesCount);
+			}
+
+			if (cachedMesh.TangentsOffset != ER_MESH_CACHE_INVALID_OFFSET && cachedMesh.BiNormalsOffset != ER_MESH_CACHE_INVALID_OFFSET)
+			{
+				const XMFLOAT3* tangents = cache.GetData<XMFLOAT3>(cachedMesh.TangentsOffset);
+				const XMFLOAT3* biNormals = cache.GetData<XMFLOAT3>(cachedMesh.BiNormalsOffset);
+				mTangents.assign(tangents, tangents + verticesCount);
+				mBiNormals.assign(biNormals, biNormals + verticesCount);
+			}
+
+			mTextureCoordinates.resize(cachedMesh.UVChannelsCount);
+			for (UINT i = 0; i < cachedMesh.UVChannelsCount; i++)
+			{
+				const XMFLOAT3* textureCoordinates = cache.GetData<XMFLOAT3>(cachedMesh.UVsOffset) + i * verticesCount;
+				mTextureCoordinates[i].assign(textureCoordinates, textureCoordinates + verticesCount);
+			}
+
+			mVertexColors.resize(cachedMesh.ColorChannelsCount);
+			for (UINT i = 0; i < cachedMesh.ColorChannelsCount; i++)
+			{
+				const XMFLOAT4* vertexColors = cache.GetData<XMFLOAT4>(cachedMesh.ColorsOffset) + i * verticesCount;
+				mVertexColors[i].assign(vertexColors, vertexColors + verticesCount);
+			}
+		}
+
+		if (cachedMesh.IndicesCount > 0)
+		{
+			const UINT* indices = cache.GetData<UINT>(cachedMesh.IndicesOffset);
+			mIndices.assign(indices, indices + cachedMesh.IndicesCount);
+		}
+	}
+
+	void ER_Mesh::CalculateAABB()
+	{
+		XMFLOAT3 minVertex = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 maxVertex = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		for (const XMFLOAT3& vertex : mVertices)
+		{
+			minVertex.x = std::min(minVertex.x, vertex.x);
+			minVertex.y = std::min(minVertex.y, vertex.y);
+			minVertex.z = std::min(minVertex.z, vertex.z);
+
+			maxVertex.x = std::max(maxVertex.x, vertex.x);
+			maxVertex.y = std::max(maxVertex.y, vertex.y);
+			maxVertex.z = std::max(maxVertex.z, vertex.z);
+		}
+
+		mAABB = { minVertex, maxVertex };
 	}
 
 	/*ER_Mesh::ER_Mesh(Model & model, ER_ModelMaterial * material)
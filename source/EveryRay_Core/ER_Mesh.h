@@ -9,11 +9,13 @@ namespace EveryRay_Core
 {
 	class ER_Model;
 	class ER_ModelMaterial;
+	class ER_MeshCache;
 
 	class ER_Mesh
 	{
 	public:
 		ER_Mesh(ER_Model& model, ER_ModelMaterial& material, aiMesh& mesh);
+		ER_Mesh(ER_Model& model, ER_ModelMaterial& material, const ER_MeshCache& cache, UINT index);
 		~ER_Mesh();
 
 		ER_Model& GetModel();
@@ -28,6 +30,7 @@ namespace EveryRay_Core
 		const std::vector<std::vector<XMFLOAT4>>& VertexColors() const;
 		const std::vector<UINT>& Indices() const;
 		UINT FaceCount() const;
+		const ER_AABB& GetAABB() const { return mAABB; }
 
 		void CreateIndexBuffer(ER_RHI_GPUBuffer* indexBuffer) const;
 
@@ -37,6 +40,8 @@ namespace EveryRay_Core
 		void CreateVertexBuffer_PositionUvNormalTangent(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel = 0) const;
 
 	private:
+		void CalculateAABB();
+
 		ER_Model& mModel;
 		ER_ModelMaterial& mMaterial;
 		std::string mName;
@@ -48,5 +53,6 @@ namespace EveryRay_Core
 		std::vector<std::vector<XMFLOAT4>> mVertexColors;
 		UINT mFaceCount;
 		std::vector<UINT> mIndices;
+		ER_AABB mAABB;
 	};
 }
\ No newline at end of file
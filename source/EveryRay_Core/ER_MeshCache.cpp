@@ -0,0 +1,255 @@
+#include "stdafx.h"
+
+#include "ER_MeshCache.h"
+#include "ER_Model.h"
+#include "ER_Mesh.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	// Appends data to the cache blob keeping every block aligned to ER_MESH_CACHE_ALIGNMENT
+	class ER_MeshCacheWriter
+	{
+	public:
+		UINT32 Append(const void* aData, size_t aSize)
+		{
+			if (aSize == 0)
+				return ER_MESH_CACHE_INVALID_OFFSET;
+
+			UINT32 offset = ER_BitmaskAlign(static_cast<unsigned int>(mData.size()), ER_MESH_CACHE_ALIGNMENT);
+			mData.resize(offset + aSize, 0);
+			memcpy(mData.data() + offset, aData, aSize);
+			return offset;
+		}
+
+		UINT32 AddString(const std::string& aString)
+		{
+			UINT32 offset = static_cast<UINT32>(mStrings.size());
+			mStrings.insert(mStrings.end(), aString.begin(), aString.end());
+			mStrings.push_back('\0');
+			return offset;
+		}
+
+		std::vector<char>& GetData() { return mData; }
+		const std::vector<char>& GetStrings() const { return mStrings; }
+	private:
+		std::vector<char> mData;
+		std::vector<char> mStrings;
+	};
+
+	bool ER_MeshCache::Load(const std::string& aModelPath, UINT aImportFlags)
+	{
+		mModelPath = aModelPath;
+		mImportFlags = aImportFlags;
+
+		// reading and hashing the model file is much cheaper than importing it with Assimp
+		std::ifstream file(aModelPath.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.good())
+			return false;
+
+		std::vector<char> source(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		if (!source.empty())
+			file.read(source.data(), source.size());
+		file.close();
+
+		mSourceHash = ER_Utility::HashData(source.data(), source.size());
+		mSourceSize = static_cast<UINT64>(source.size());
+
+		if (!mFile.Open(GetCachePath(aModelPath)))
+			return false;
+
+		if (!Validate())
+		{
+			mFile.Close();
+			return false;
+		}
+		return true;
+	}
+
+	bool ER_MeshCache::Validate() const
+	{
+		if (mFile.GetSize() < sizeof(ER_MeshCacheHeader))
+			return false;
+
+		const ER_MeshCacheHeader& header = GetHeader();
+		if (header.Magic != ER_MESH_CACHE_MAGIC || header.Version != ER_MESH_CACHE_VERSION || header.FileSize != mFile.GetSize() ||
+			header.SourceHash != mSourceHash || header.SourceSize != mSourceSize || header.ImportFlags != mImportFlags)
+			return false;
+
+		const UINT64 size = mFile.GetSize();
+		if (static_cast<UINT64>(header.MeshesOffset) + header.MeshesCount * sizeof(ER_MeshCacheMesh) > size ||
+			static_cast<UINT64>(header.MaterialsOffset) + header.MaterialsCount * sizeof(ER_MeshCacheMaterial) > size ||
+			static_cast<UINT64>(header.TexturePathsOffset) + header.TexturePathsCount * sizeof(UINT32) > size ||
+			static_cast<UINT64>(header.StringsOffset) + header.StringsSize > size)
+			return false;
+
+		// strings are read with plain "const char*", so the table must be terminated
+		if (header.StringsSize > 0 && mFile.GetData()[header.StringsOffset + header.StringsSize - 1] != '\0')
+			return false;
+
+		auto isInFile = [size](UINT32 offset, UINT64 dataSize)
+		{
+			return dataSize == 0 || (offset != ER_MESH_CACHE_INVALID_OFFSET && offset + dataSize <= size);
+		};
+		// optional streams (normals, tangents, binormals) are read whenever their offset is valid
+		auto isOptionalInFile = [size](UINT32 offset, UINT64 dataSize)
+		{
+			return offset == ER_MESH_CACHE_INVALID_OFFSET || offset + dataSize <= size;
+		};
+
+		for (UINT i = 0; i < header.MeshesCount; i++)
+		{
+			const ER_MeshCacheMesh& mesh = GetMesh(i);
+			const UINT64 vertices = mesh.VerticesCount;
+			if (mesh.MaterialIndex >= header.MaterialsCount || mesh.Name >= header.StringsSize ||
+				!isInFile(mesh.PositionsOffset, vertices * sizeof(XMFLOAT3)) ||
+				!isOptionalInFile(mesh.NormalsOffset, vertices * sizeof(XMFLOAT3)) ||
+				!isOptionalInFile(mesh.TangentsOffset, vertices * sizeof(XMFLOAT3)) ||
+				!isOptionalInFile(mesh.BiNormalsOffset, vertices * sizeof(XMFLOAT3)) ||
+				!isInFile(mesh.UVsOffset, vertices * mesh.UVChannelsCount * sizeof(XMFLOAT3)) ||
+				!isInFile(mesh.ColorsOffset, vertices * mesh.ColorChannelsCount * sizeof(XMFLOAT4)) ||
+				!isInFile(mesh.IndicesOffset, mesh.IndicesCount * sizeof(UINT)))
+				return false;
+		}
+
+		for (UINT i = 0; i < header.MaterialsCount; i++)
+		{
+			const ER_MeshCacheMaterial& material = GetMaterial(i);
+			if (material.Name >= header.StringsSize)
+				return false;
+			for (int textureType = 0; textureType < TextureTypeEnd; textureType++)
+			{
+				if ((material.TextureTypesMask & (1u << textureType)) &&
+					static_cast<UINT64>(material.FirstTexturePath[textureType]) + material.TexturePathsCount[textureType] > header.TexturePathsCount)
+					return false;
+			}
+		}
+
+		const UINT32* texturePaths = header.TexturePathsCount > 0 ? GetData<UINT32>(header.TexturePathsOffset) : nullptr;
+		for (UINT i = 0; i < header.TexturePathsCount; i++)
+		{
+			if (texturePaths[i] >= header.StringsSize)
+				return false;
+		}
+		return true;
+	}
+
+	bool ER_MeshCache::Save(const ER_Model& aModel) const
+	{
+		const std::vector<ER_Mesh>& meshes = aModel.Meshes();
+		const std::vector<ER_ModelMaterial>& materials = aModel.Materials();
+
+		ER_MeshCacheWriter writer;
+		writer.GetData().resize(sizeof(ER_MeshCacheHeader), 0);
+
+		// materials (texture paths are stored as offsets in the string table)
+		std::vector<ER_MeshCacheMaterial> cacheMaterials(materials.size());
+		std::vector<UINT32> texturePaths;
+		for (size_t i = 0; i < materials.size(); i++)
+		{
+			ER_MeshCacheMaterial& cacheMaterial = cacheMaterials[i];
+			ZeroMemory(&cacheMaterial, sizeof(cacheMaterial));
+			cacheMaterial.Name = writer.AddString(materials[i].Name());
+
+			for (auto& textures : materials[i].Textures())
+			{
+				cacheMaterial.TextureTypesMask |= (1u << textures.first);
+				cacheMaterial.FirstTexturePath[textures.first] = static_cast<UINT32>(texturePaths.size());
+				cacheMaterial.TexturePathsCount[textures.first] = static_cast<UINT32>(textures.second.size());
+				for (auto& path : textures.second)
+					texturePaths.push_back(writer.AddString(std::string(path.begin(), path.end())));
+			}
+		}
+
+		// meshes
+		std::vector<ER_MeshCacheMesh> cacheMeshes(meshes.size());
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const ER_Mesh& mesh = meshes[i];
+			ER_MeshCacheMesh& cacheMesh = cacheMeshes[i];
+			ZeroMemory(&cacheMesh, sizeof(cacheMesh));
+
+			cacheMesh.AABBMin = mesh.GetAABB().first;
+			cacheMesh.AABBMax = mesh.GetAABB().second;
+			cacheMesh.Name = writer.AddString(mesh.Name());
+			cacheMesh.MaterialIndex = static_cast<UINT32>(&mesh.GetMaterial() - materials.data());
+			cacheMesh.VerticesCount = static_cast<UINT32>(mesh.Vertices().size());
+			cacheMesh.IndicesCount = static_cast<UINT32>(mesh.Indices().size());
+			cacheMesh.FaceCount = mesh.FaceCount();
+			cacheMesh.UVChannelsCount = static_cast<UINT32>(mesh.TextureCoordinates().size());
+			cacheMesh.ColorChannelsCount = static_cast<UINT32>(mesh.VertexColors().size());
+
+			cacheMesh.PositionsOffset = writer.Append(mesh.Vertices().data(), mesh.Vertices().size() * sizeof(XMFLOAT3));
+			cacheMesh.NormalsOffset = writer.Append(mesh.Normals().data(), mesh.Normals().size() * sizeof(XMFLOAT3));
+			cacheMesh.TangentsOffset = writer.Append(mesh.Tangents().data(), mesh.Tangents().size() * sizeof(XMFLOAT3));
+			cacheMesh.BiNormalsOffset = writer.Append(mesh.BiNormals().data(), mesh.BiNormals().size() * sizeof(XMFLOAT3));
+
+			cacheMesh.UVsOffset = ER_MESH_CACHE_INVALID_OFFSET;
+			for (auto& uvs : mesh.TextureCoordinates())
+			{
+				assert(uvs.size() == cacheMesh.VerticesCount);
+				UINT32 offset = writer.Append(uvs.data(), uvs.size() * sizeof(XMFLOAT3));
+				if (cacheMesh.UVsOffset == ER_MESH_CACHE_INVALID_OFFSET)
+					cacheMesh.UVsOffset = offset;
+			}
+
+			cacheMesh.ColorsOffset = ER_MESH_CACHE_INVALID_OFFSET;
+			for (auto& colors : mesh.VertexColors())
+			{
+				assert(colors.size() == cacheMesh.VerticesCount);
+				UINT32 offset = writer.Append(colors.data(), colors.size() * sizeof(XMFLOAT4));
+				if (cacheMesh.ColorsOffset == ER_MESH_CACHE_INVALID_OFFSET)
+					cacheMesh.ColorsOffset = offset;
+			}
+
+			cacheMesh.IndicesOffset = writer.Append(mesh.Indices().data(), mesh.Indices().size() * sizeof(UINT));
+		}
+
+		ER_MeshCacheHeader header;
+		ZeroMemory(&header, sizeof(header));
+		header.Magic = ER_MESH_CACHE_MAGIC;
+		header.Version = ER_MESH_CACHE_VERSION;
+		header.SourceHash = mSourceHash;
+		header.SourceSize = mSourceSize;
+		header.ImportFlags = mImportFlags;
+		header.MeshesCount = static_cast<UINT32>(cacheMeshes.size());
+		header.MaterialsCount = static_cast<UINT32>(cacheMaterials.size());
+		header.TexturePathsCount = static_cast<UINT32>(texturePaths.size());
+		header.MeshesOffset = writer.Append(cacheMeshes.data(), cacheMeshes.size() * sizeof(ER_MeshCacheMesh));
+		header.MaterialsOffset = writer.Append(cacheMaterials.data(), cacheMaterials.size() * sizeof(ER_MeshCacheMaterial));
+		header.TexturePathsOffset = writer.Append(texturePaths.data(), texturePaths.size() * sizeof(UINT32));
+		header.StringsOffset = writer.Append(writer.GetStrings().data(), writer.GetStrings().size());
+		header.StringsSize = static_cast<UINT32>(writer.GetStrings().size());
+
+		std::vector<char>& data = writer.GetData();
+		header.FileSize = static_cast<UINT64>(data.size());
+		memcpy(data.data(), &header, sizeof(header));
+
+		return ER_Utility::SaveBinaryFile(GetCachePath(mModelPath), data.data(), data.size());
+	}
+
+	const ER_MeshCacheMesh& ER_MeshCache::GetMesh(UINT aIndex) const
+	{
+		assert(aIndex < GetHeader().MeshesCount);
+		return GetData<ER_MeshCacheMesh>(GetHeader().MeshesOffset)[aIndex];
+	}
+
+	const ER_MeshCacheMaterial& ER_MeshCache::GetMaterial(UINT aIndex) const
+	{
+		assert(aIndex < GetHeader().MaterialsCount);
+		return GetData<ER_MeshCacheMaterial>(GetHeader().MaterialsOffset)[aIndex];
+	}
+
+	const char* ER_MeshCache::GetTexturePath(UINT aIndex) const
+	{
+		assert(aIndex < GetHeader().TexturePathsCount);
+		return GetString(GetData<UINT32>(GetHeader().TexturePathsOffset)[aIndex]);
+	}
+
+	const char* ER_MeshCache::GetString(UINT32 aOffset) const
+	{
+		assert(aOffset < GetHeader().StringsSize);
+		return mFile.GetData() + GetHeader().StringsOffset + aOffset;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "Common.h"
+#include "ER_MappedFile.h"
+#include "ER_ModelMaterial.h"
+
+#define ER_MESH_CACHE_MAGIC 0x434D5245 // "ERMC"
+#define ER_MESH_CACHE_VERSION 1
+#define ER_MESH_CACHE_EXTENSION ".ermesh"
+#define ER_MESH_CACHE_INVALID_OFFSET 0xFFFFFFFF
+#define ER_MESH_CACHE_ALIGNMENT 16
+
+namespace EveryRay_Core
+{
+	class ER_Model;
+
+	// All the structs below are stored in the file "as is" (POD, no pointers), offsets are in bytes from the beginning of the file.
+	// WARNING: if you change any of these structs or the way ER_Mesh processes Assimp data, increase ER_MESH_CACHE_VERSION.
+
+	struct ER_MeshCacheHeader
+	{
+		UINT32 Magic;
+		UINT32 Version;
+		UINT64 SourceHash; // hash of the model file this cache was built from
+		UINT64 SourceSize;
+		UINT64 FileSize;
+		UINT32 ImportFlags; // Assimp post-processing flags the model was imported with
+		UINT32 MeshesCount;
+		UINT32 MaterialsCount;
+		UINT32 TexturePathsCount;
+		UINT32 MeshesOffset;
+		UINT32 MaterialsOffset;
+		UINT32 TexturePathsOffset;
+		UINT32 StringsOffset;
+		UINT32 StringsSize;
+	};
+
+	struct ER_MeshCacheMaterial
+	{
+		UINT32 Name; // offset in the string table
+		UINT32 TextureTypesMask; // bits of TextureType that the source material had (even if the texture paths could not be read)
+		UINT32 FirstTexturePath[TextureTypeEnd];
+		UINT32 TexturePathsCount[TextureTypeEnd];
+	};
+
+	struct ER_MeshCacheMesh
+	{
+		XMFLOAT3 AABBMin;
+		XMFLOAT3 AABBMax;
+		UINT32 Name; // offset in the string table
+		UINT32 MaterialIndex;
+		UINT32 VerticesCount;
+		UINT32 IndicesCount;
+		UINT32 FaceCount;
+		UINT32 UVChannelsCount;
+		UINT32 ColorChannelsCount;
+		UINT32 PositionsOffset;
+		UINT32 NormalsOffset; // ER_MESH_CACHE_INVALID_OFFSET if the mesh has no normals
+		UINT32 TangentsOffset; // ER_MESH_CACHE_INVALID_OFFSET if the mesh has no tangents (and binormals)
+		UINT32 BiNormalsOffset;
+		UINT32 UVsOffset; // all channels one after another (XMFLOAT3 per vertex)
+		UINT32 ColorsOffset; // all channels one after another (XMFLOAT4 per vertex)
+		UINT32 IndicesOffset;
+	};
+
+	// On-disk cache of the processed ER_Model data (meshes: positions, normals, tangents, binormals, UVs, colors, indices, AABBs and material slots).
+	// It is saved next to the model file with ER_MESH_CACHE_EXTENSION and memory-mapped on later loads, so that we do not go through Assimp again.
+	// Cache is invalidated when the model file content (hash/size), the import flags or ER_MESH_CACHE_VERSION change.
+	// Every LOD is a separate model file, so it has its own cache.
+	class ER_MeshCache
+	{
+	public:
+		ER_MeshCache() {}
+		~ER_MeshCache() {}
+
+		// Hashes the model file and maps its cache. Returns false if there is no valid cache (i.e., model has to be imported with Assimp).
+		bool Load(const std::string& aModelPath, UINT aImportFlags);
+		// Saves the imported model to the cache (call after a failed Load() with the same path/flags).
+		bool Save(const ER_Model& aModel) const;
+
+		const ER_MeshCacheHeader& GetHeader() const { return *reinterpret_cast<const ER_MeshCacheHeader*>(mFile.GetData()); }
+		const ER_MeshCacheMesh& GetMesh(UINT aIndex) const;
+		const ER_MeshCacheMaterial& GetMaterial(UINT aIndex) const;
+		const char* GetTexturePath(UINT aIndex) const;
+		const char* GetString(UINT32 aOffset) const;
+
+		template <typename T>
+		const T* GetData(UINT32 aOffset) const
+		{
+			assert(aOffset != ER_MESH_CACHE_INVALID_OFFSET && aOffset < mFile.GetSize());
+			return reinterpret_cast<const T*>(mFile.GetData() + aOffset);
+		}
+
+		static std::string GetCachePath(const std::string& aModelPath) { return aModelPath + ER_MESH_CACHE_EXTENSION; }
+	private:
+		bool Validate() const;
+
+		ER_MappedFile mFile;
+		std::string mModelPath;
+		UINT64 mSourceHash = 0;
+		UINT64 mSourceSize = 0;
+		UINT mImportFlags = 0;
+	};
+}
@@ -3,8 +3,10 @@
 #include "ER_Model.h"
 #include "ER_Mesh.h"
 #include "ER_ModelMaterial.h"
+#include "ER_MeshCache.h"
 #include "ER_Core.h"
 #include "ER_CoreException.h"
+#include "ER_Utility.h"
 
 #include "assimp\Importer.hpp"
 #include "assimp\scene.h"
@@ -13,16 +15,33 @@
 namespace EveryRay_Core
 {
 	ER_Model::ER_Model(ER_Core& game, const std::string& filename, bool flipUVs)
-		: mCore(game), mMeshes(), mMaterials()
+		: mCore(game), mMeshes(), mMaterials(), mFilename(filename)
 	{
-		Assimp::Importer importer;
-
 		UINT flags = aiProcess_Triangulate /*| aiProcess_JoinIdenticalVertices*/ | aiProcess_SortByPType | aiProcess_FlipWindingOrder;
 		if (flipUVs)
 		{
 			flags |= aiProcess_FlipUVs;
 		}
 
+		// fast path: processed data from the previous import of the same file (with the same flags)
+		ER_MeshCache meshCache;
+		if (meshCache.Load(filename, flags))
+		{
+			const ER_MeshCacheHeader& header = meshCache.GetHeader();
+
+			mMaterials.reserve(header.MaterialsCount);
+			for (UINT i = 0; i < header.MaterialsCount; i++)
+				mMaterials.push_back(ER_ModelMaterial(*this, meshCache, i));
+
+			assert(header.MeshesCount < MAX_MESH_COUNT);
+			mMeshes.reserve(header.MeshesCount);
+			for (UINT i = 0; i < header.MeshesCount; i++)
+				mMeshes.push_back(ER_Mesh(*this, mMaterials[meshCache.GetMesh(i).MaterialIndex], meshCache, i));
+
+			return;
+		}
+
+		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(filename, flags);
 		
 		if (scene == nullptr)
@@ -43,7 +62,11 @@ namespace EveryRay_Core
 				mMeshes.push_back(ER_Mesh(*this, mMaterials[scene->mMeshes[i]->mMaterialIndex], *(scene->mMeshes[i])));
 		}
 
-		mFilename = filename;
+		if (!meshCache.Save(*this))
+		{
+			std::string message = "[ER Logger][ER_Model] Could not save mesh cache for: " + filename + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
 	}
 
 	ER_Model::~ER_Model()
@@ -82,25 +105,21 @@ namespace EveryRay_Core
 
 	const ER_AABB& ER_Model::GenerateAABB()
 	{
-		std::vector<XMFLOAT3> vertices;
-
-		for (ER_Mesh& mesh : mMeshes)
-			vertices.insert(vertices.end(), mesh.Vertices().begin(), mesh.Vertices().end());
-
 		XMFLOAT3 minVertex = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
 		XMFLOAT3 maxVertex = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
-		for (UINT i = 0; i < vertices.size(); i++)
+		// meshes already have their bounds (computed on import or read from the mesh cache)
+		for (const ER_Mesh& mesh : mMeshes)
 		{
-			//Get the smallest vertex 
-			minVertex.x = std::min(minVertex.x, vertices[i].x);    // Find smallest x value in model
-			minVertex.y = std::min(minVertex.y, vertices[i].y);    // Find smallest y value in model
-			minVertex.z = std::min(minVertex.z, vertices[i].z);    // Find smallest z value in model
-
-			//Get the largest vertex 
-			maxVertex.x = std::max(maxVertex.x, vertices[i].x);    // Find largest x value in model
-			maxVertex.y = std::max(maxVertex.y, vertices[i].y);    // Find largest y value in model
-			maxVertex.z = std::max(maxVertex.z, vertices[i].z);    // Find largest z value in model
+			const ER_AABB& meshAABB = mesh.GetAABB();
+
+			minVertex.x = std::min(minVertex.x, meshAABB.first.x);
+			minVertex.y = std::min(minVertex.y, meshAABB.first.y);
+			minVertex.z = std::min(minVertex.z, meshAABB.first.z);
+
+			maxVertex.x = std::max(maxVertex.x, meshAABB.second.x);
+			maxVertex.y = std::max(maxVertex.y, meshAABB.second.y);
+			maxVertex.z = std::max(maxVertex.z, meshAABB.second.z);
 		}
 
 		mAABB = { minVertex, maxVertex };
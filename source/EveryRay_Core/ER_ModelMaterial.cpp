@@ -4,6 +4,7 @@
 #include "ER_Model.h"
 #include "ER_CoreException.h"
 #include "ER_Utility.h"
+#include "ER_MeshCache.h"
 #include "assimp\scene.h"
 
 namespace EveryRay_Core
@@ -47,6 +48,29 @@ namespace EveryRay_Core
 		}
 	}
 
+	ER_ModelMaterial::ER_ModelMaterial(ER_Model& model, const ER_MeshCache& cache, UINT index)
+		: mModel(model), mTextures()
+	{
+		InitializeTextureTypeMappings();
+
+		const ER_MeshCacheMaterial& cachedMaterial = cache.GetMaterial(index);
+		mName = cache.GetString(cachedMaterial.Name);
+
+		for (TextureType textureType = (TextureType)0; textureType < TextureTypeEnd; textureType = (TextureType)(textureType + 1))
+		{
+			if (!(cachedMaterial.TextureTypesMask & (1u << textureType)))
+				continue;
+
+			std::vector<std::wstring>& textures = mTextures[textureType];
+			for (UINT textureIndex = 0; textureIndex < cachedMaterial.TexturePathsCount[textureType]; textureIndex++)
+			{
+				std::wstring wPath;
+				ER_Utility::ToWideString(cache.GetTexturePath(cachedMaterial.FirstTexturePath[textureType] + textureIndex), wPath);
+				textures.push_back(wPath);
+			}
+		}
+	}
+
 	ER_ModelMaterial::~ER_ModelMaterial()
 	{
 	}
@@ -21,12 +21,14 @@ namespace EveryRay_Core
 	};
 
 	class ER_Model;
+	class ER_MeshCache;
 
 	class ER_ModelMaterial
 	{
 	public:
 		ER_ModelMaterial(ER_Model& model, aiMaterial* material);
 		ER_ModelMaterial(ER_Model& model);
+		ER_ModelMaterial(ER_Model& model, const ER_MeshCache& cache, UINT index);
 		~ER_ModelMaterial();
 
 		ER_Model& GetModel();
@@ -85,7 +85,7 @@ namespace EveryRay_Core
 		ER_RHI_GPUTexture* mTonemappingRT = nullptr;
 		ER_RHI_GPUShader* mTonemappingPS = nullptr;
 		bool mUseTonemap = true;
-		std::string mTonemapPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Tonemap";
+		ER_RHI_PSOHandle mTonemapPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Tonemap";
 		ER_RHI_GPURootSignature* mTonemapRS = nullptr;
 
 		// SSR
@@ -96,7 +96,7 @@ namespace EveryRay_Core
 		int mSSRRayCount = 50;
 		float mSSRStepSize = 0.741f;
 		float mSSRMaxThickness = 0.00021f;
-		std::string mSSRPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - SSR";
+		ER_RHI_PSOHandle mSSRPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - SSR";
 		ER_RHI_GPURootSignature* mSSRRS = nullptr;
 
 		// SSS
@@ -104,7 +104,7 @@ namespace EveryRay_Core
 		bool mUseSSS = true;
 		ER_RHI_GPUShader* mSSSPS = nullptr;
 		ER_RHI_GPUConstantBuffer<PostEffectsCBuffers::SSSCB> mSSSConstantBuffer;
-		std::string mSSSPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - SSS";
+		ER_RHI_PSOHandle mSSSPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - SSS";
 		ER_RHI_GPURootSignature* mSSSRS = nullptr;
 
 		// Linear Fog
@@ -116,7 +116,7 @@ namespace EveryRay_Core
 		float mLinearFogDensity = 730.0f;
 		float mLinearFogNearZ = 0.0f;
 		float mLinearFogFarZ = 0.0f;
-		std::string mLinearFogPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Linear Fog";
+		ER_RHI_PSOHandle mLinearFogPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Linear Fog";
 		ER_RHI_GPURootSignature* mLinearFogRS = nullptr;
 
 		ER_RHI_GPUTexture* mVolumetricFogRT = nullptr;
@@ -127,7 +127,7 @@ namespace EveryRay_Core
 		ER_RHI_GPUShader* mColorGradingPS = nullptr;
 		int mColorGradingCurrentLUTIndex = 2;
 		bool mUseColorGrading = true;
-		std::string mColorGradingPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Color Grading";
+		ER_RHI_PSOHandle mColorGradingPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Color Grading";
 		ER_RHI_GPURootSignature* mColorGradingRS = nullptr;
 
 		// FXAA
@@ -135,7 +135,7 @@ namespace EveryRay_Core
 		ER_RHI_GPUConstantBuffer<PostEffectsCBuffers::FXAACB> mFXAAConstantBuffer;
 		ER_RHI_GPUShader* mFXAAPS = nullptr;
 		bool mUseFXAA = true;
-		std::string mFXAAPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - FXAA";
+		ER_RHI_PSOHandle mFXAAPassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - FXAA";
 		ER_RHI_GPURootSignature* mFXAARS = nullptr;
 
 		// Vignette
@@ -145,11 +145,11 @@ namespace EveryRay_Core
 		float mVignetteRadius = 0.75f;
 		float mVignetteSoftness = 0.5f;
 		bool mUseVignette = true;
-		std::string mVignettePassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Vignette";
+		ER_RHI_PSOHandle mVignettePassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Vignette";
 		ER_RHI_GPURootSignature* mVignetteRS = nullptr;
 
 		ER_RHI_GPUShader* mFinalResolvePS = nullptr;
-		std::string mFinalResolvePassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Final Resolve";
+		ER_RHI_PSOHandle mFinalResolvePassPSOName = "ER_RHI_GPUPipelineStateObject: Post Processing - Final Resolve";
 		ER_RHI_GPURootSignature* mFinalResolveRS = nullptr;
 
 		// just pointers to RTs (not allocated in this system)
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+
+#include "ER_RenderQueue.h"
+
+#define ER_RENDER_QUEUE_RADIX_BITS 8
+#define ER_RENDER_QUEUE_RADIX_SIZE (1 << ER_RENDER_QUEUE_RADIX_BITS)
+#define ER_RENDER_QUEUE_RADIX_PASSES (64 / ER_RENDER_QUEUE_RADIX_BITS)
+
+static_assert(ER_RENDER_QUEUE_KEY_PSO_BITS + ER_RENDER_QUEUE_KEY_MATERIAL_BITS + ER_RENDER_QUEUE_KEY_MESH_BITS + ER_RENDER_QUEUE_KEY_DEPTH_BITS == 64, "ER_RenderQueue: key fields must fill 64 bits");
+
+namespace EveryRay_Core
+{
+	static UINT64 GetFieldMask(UINT aBits)
+	{
+		return (1ull << aBits) - 1;
+	}
+
+	UINT64 ER_RenderQueue::MakeKey(UINT aPSO, UINT aMaterial, UINT aMesh, UINT aDepthBucket)
+	{
+		UINT64 key = static_cast<UINT64>(aPSO) & GetFieldMask(ER_RENDER_QUEUE_KEY_PSO_BITS);
+		key = (key << ER_RENDER_QUEUE_KEY_MATERIAL_BITS) | (static_cast<UINT64>(aMaterial) & GetFieldMask(ER_RENDER_QUEUE_KEY_MATERIAL_BITS));
+		key = (key << ER_RENDER_QUEUE_KEY_MESH_BITS) | (static_cast<UINT64>(aMesh) & GetFieldMask(ER_RENDER_QUEUE_KEY_MESH_BITS));
+		key = (key << ER_RENDER_QUEUE_KEY_DEPTH_BITS) | (static_cast<UINT64>(aDepthBucket) & GetFieldMask(ER_RENDER_QUEUE_KEY_DEPTH_BITS));
+		return key;
+	}
+
+	UINT ER_RenderQueue::HashToBits(UINT64 aValue, UINT aBits)
+	{
+		assert(aBits > 0 && aBits <= 32);
+		// Fibonacci hashing: the high bits of the product depend on all bits of the value (pointers have zeroes in the low bits)
+		return static_cast<UINT>((aValue * 0x9E3779B97F4A7C15ull) >> (64 - aBits));
+	}
+
+	UINT ER_RenderQueue::GetDepthBucket(float aDistance, float aMaxDistance)
+	{
+		if (aMaxDistance <= 0.0f)
+			return 0;
+		const float normalizedDistance = std::min(std::max(aDistance / aMaxDistance, 0.0f), 1.0f);
+		return static_cast<UINT>(sqrtf(normalizedDistance) * static_cast<float>(GetFieldMask(ER_RENDER_QUEUE_KEY_DEPTH_BITS)));
+	}
+
+	void ER_RenderQueue::Sort()
+	{
+		const size_t count = mItems.size();
+		if (count < 2)
+			return;
+		mSortScratch.resize(count);
+
+		// histograms of all digits in one pass over the keys
+		UINT histograms[ER_RENDER_QUEUE_RADIX_PASSES][ER_RENDER_QUEUE_RADIX_SIZE] = {};
+		for (size_t i = 0; i < count; i++)
+		{
+			const UINT64 key = mItems[i].Key;
+			for (int pass = 0; pass < ER_RENDER_QUEUE_RADIX_PASSES; pass++)
+				histograms[pass][(key >> (pass * ER_RENDER_QUEUE_RADIX_BITS)) & (ER_RENDER_QUEUE_RADIX_SIZE - 1)]++;
+		}
+
+		ER_RenderQueueItem* source = mItems.data();
+		ER_RenderQueueItem* destination = mSortScratch.data();
+		for (int pass = 0; pass < ER_RENDER_QUEUE_RADIX_PASSES; pass++)
+		{
+			UINT* histogram = histograms[pass];
+			const UINT shift = pass * ER_RENDER_QUEUE_RADIX_BITS;
+
+			// all keys have the same digit: this pass would not change the order
+			if (histogram[(source[0].Key >> shift) & (ER_RENDER_QUEUE_RADIX_SIZE - 1)] == count)
+				continue;
+
+			UINT offset = 0;
+			for (int digit = 0; digit < ER_RENDER_QUEUE_RADIX_SIZE; digit++)
+			{
+				const UINT digitCount = histogram[digit];
+				histogram[digit] = offset;
+				offset += digitCount;
+			}
+
+			for (size_t i = 0; i < count; i++)
+				destination[histogram[(source[i].Key >> shift) & (ER_RENDER_QUEUE_RADIX_SIZE - 1)]++] = source[i];
+			std::swap(source, destination);
+		}
+
+		if (source != mItems.data())
+			mItems.swap(mSortScratch);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "Common.h"
+
+// 64-bit sort keys, from the most significant bits: PSO, material (i.e., texture set), mesh (i.e., vertex buffer), depth bucket.
+// Sorting the keys groups the draws by the most expensive state first, so that redundant state changes can be skipped at submission.
+#define ER_RENDER_QUEUE_KEY_PSO_BITS 8
+#define ER_RENDER_QUEUE_KEY_MATERIAL_BITS 20
+#define ER_RENDER_QUEUE_KEY_MESH_BITS 20
+#define ER_RENDER_QUEUE_KEY_DEPTH_BITS 16
+
+namespace EveryRay_Core
+{
+	struct ER_RenderQueueItem
+	{
+		UINT64 Key;
+		UINT Index; // of the draw in the caller's array
+	};
+
+	// State changes of the last submitted queue (only counts what was actually set, "Draws" is what would have been set without sorting & elision)
+	struct ER_RenderQueueStats
+	{
+		UINT DrawsCount = 0;
+		UINT PSOChangesCount = 0;
+		UINT ConstantBufferChangesCount = 0; // per-object constant buffers (bindings & uploads)
+		UINT TextureChangesCount = 0;
+		UINT VertexBufferChangesCount = 0;
+	};
+
+	// Collects the draws of a pass as (key, index) pairs and sorts them with an LSD radix sort (stable, 8 bits per pass, passes where all keys share the digit are skipped).
+	// Memory is kept between frames, so that there are no allocations in steady-state frames.
+	class ER_RenderQueue
+	{
+	public:
+		ER_RenderQueue() {}
+		~ER_RenderQueue() {}
+
+		// fields are truncated to their bits; depth bucket is from ER_RenderQueue::GetDepthBucket()
+		static UINT64 MakeKey(UINT aPSO, UINT aMaterial, UINT aMesh, UINT aDepthBucket);
+		// small ids for the keys from resources (pointers), collisions only make the sorting less efficient
+		static UINT HashToBits(UINT64 aValue, UINT aBits);
+		// front-to-back: closer is smaller (more precision close to the camera)
+		static UINT GetDepthBucket(float aDistance, float aMaxDistance);
+
+		void Clear() { mItems.clear(); }
+		void Add(UINT64 aKey, UINT aIndex) { mItems.push_back({ aKey, aIndex }); }
+		void Sort();
+
+		const ER_RenderQueueItem* GetItems() const { return mItems.data(); }
+		UINT GetItemsCount() const { return static_cast<UINT>(mItems.size()); }
+	private:
+		ER_RenderQueue(const ER_RenderQueue&) = delete;
+		ER_RenderQueue& operator=(const ER_RenderQueue&) = delete;
+
+		std::vector<ER_RenderQueueItem> mItems;
+		std::vector<ER_RenderQueueItem> mSortScratch;
+	};
+}
@@ -17,11 +17,23 @@
 #include "ER_Terrain.h"
 #include "ER_Settings.h"
 #include "ER_Scene.h"
+#include "ER_GPUCullingTable.h"
 
 namespace EveryRay_Core
 {
 	static int currentSplatChannnel = (int)TerrainSplatChannels::NONE;
 
+	std::atomic<UINT64> ER_RenderingObject::mFrameUploadedInstanceBytes{ 0 };
+	std::atomic<UINT64> ER_RenderingObject::mFrameSkippedInstanceBytes{ 0 };
+	std::atomic<UINT64> ER_RenderingObject::mFrameInstanceUploadsCount{ 0 };
+	std::atomic<UINT64> ER_RenderingObject::mFrameSkippedInstanceUploadsCount{ 0 };
+	ER_InstanceBufferUploadStats ER_RenderingObject::mLastFrameInstanceBufferUploadStats;
+	std::atomic<UINT64> ER_RenderingObject::mFrameLODInstancesCounts[RENDERING_OBJECT_LOD_STATS_MAX_LODS];
+	std::atomic<UINT64> ER_RenderingObject::mFrameLODTooSmallCount{ 0 };
+	std::atomic<UINT64> ER_RenderingObject::mFrameLODSwitchesCount{ 0 };
+	std::atomic<UINT64> ER_RenderingObject::mFrameGPULODObjectsCount{ 0 };
+	ER_LODStats ER_RenderingObject::mLastFrameLODStats;
+
 	ER_RenderingObject::ER_RenderingObject(const std::string& pName, int index, ER_Core& pCore, ER_Camera& pCamera, std::unique_ptr<ER_Model> pModel, bool availableInEditor, bool isInstanced)
 		:
 		mCore(&pCore),
@@ -104,6 +116,9 @@ namespace EveryRay_Core
 		for (auto& meshesInstanceBuffersLOD : mMeshesInstanceBuffers)
 			DeletePointerCollection(meshesInstanceBuffersLOD);
 		mMeshesInstanceBuffers.clear();
+		for (int cascade = 0; cascade < NUM_SHADOW_CASCADES; cascade++)
+			DeleteObject(mShadowCascadesInstanceBuffers[cascade]);
+		DeleteObject(mAllInstancesBuffer);
 
 		mMeshesTextureBuffers.clear();
 
@@ -114,13 +129,6 @@ namespace EveryRay_Core
 
 		mObjectConstantBuffer.Release();
 		mObjectFakeRootConstantBuffer.Release();
-
-		if (mIsIndirectlyRendered)
-		{
-			DeleteObject(mIndirectArgsBuffer);
-			DeleteObject(mIndirectNewInstanceDataBuffer);
-			DeleteObject(mIndirectOriginalInstanceDataBuffer);
-		}
 	}
 
 	void ER_RenderingObject::LoadMaterial(ER_Material* pMaterial, const std::string& materialName)
@@ -363,15 +371,6 @@ namespace EveryRay_Core
 		mMeshRenderBuffers.push_back({});
 		assert(mMeshRenderBuffers.size() - 1 == lod);
 
-		if (!mIndirectArgsBuffer && mIsIndirectlyRendered)
-		{
-			const int numArgs = 5; // number of args for DrawIndexedInstanced
-			int size = numArgs * MAX_MESH_COUNT * MAX_LOD; // we always assume that all lods have same mesh count...
-			mIndirectArgsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Indirect Args Buffer : " + mName);
-			mIndirectArgsBuffer->CreateGPUBufferResource(rhi, nullptr, size, sizeof(UINT), false,
-				ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_DRAWINDIRECT_ARGS, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
-		}
-
 		auto createIndexBuffer = [this, rhi](const ER_Mesh& aMesh, int meshIndex, int lod) {
 			mMeshRenderBuffers[lod][meshIndex]->IndexBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Index Buffer: " + mName + ", lod: " + std::to_string(lod) + ", mesh: " + std::to_string(meshIndex));
 			aMesh.CreateIndexBuffer(mMeshRenderBuffers[lod][meshIndex]->IndexBuffer);
@@ -409,7 +408,7 @@ namespace EveryRay_Core
 			DrawLOD(materialName, toDepth, meshIndex, mCurrentLODIndex);
 	}
 
-	void ER_RenderingObject::DrawLOD(const std::string& materialName, bool toDepth, int meshIndex, int lod, bool skipCulling)
+	void ER_RenderingObject::DrawLOD(const std::string& materialName, bool toDepth, int meshIndex, int lod, bool skipCulling, int shadowCascade)
 	{
 		bool isForwardPass = materialName == ER_MaterialHelper::forwardLightingNonMaterialName && mIsForwardShading;
 
@@ -417,40 +416,43 @@ namespace EveryRay_Core
 
 		if (mMaterials.find(materialName) == mMaterials.end() && !isForwardPass)
 			return;
+
+		// ER_GPUCuller only selects the first MAX_LOD LODs of indirectly rendered objects, higher ones have no draw args (and no instances)
+		const bool isAllInstances = (shadowCascade == RENDERING_OBJECT_ALL_INSTANCES);
+		if (mIsInstanced && mIsIndirectlyRendered && !isAllInstances && lod >= MAX_LOD)
+			return;
 		
-		if (mIsRendered && (skipCulling || !mIsCulled) && mCurrentLODIndex != -1)
+		// camera's LOD is -1 when the object is too small on screen, which is the camera's culling (ignored when drawing all instances)
+		assert(!isAllInstances || skipCulling);
+		if (mIsRendered && (skipCulling || !mIsCulled) && (isAllInstances || mCurrentLODIndex != -1))
 		{
 			if (!isForwardPass && (!mMaterials.size() || mMeshRenderBuffers[lod].size() == 0))
 				return;
 			
-			{
-				mObjectConstantBuffer.Data.World = XMMatrixTranspose(mTransformationMatrix);
-				mObjectConstantBuffer.Data.IndexOfRefraction = mIOR;
-				mObjectConstantBuffer.Data.CustomRoughness = mCustomRoughness;
-				mObjectConstantBuffer.Data.CustomMetalness = mCustomMetalness;
-				mObjectConstantBuffer.Data.CustomAlphaDiscard = mCustomAlphaDiscard;
-				mObjectConstantBuffer.Data.OriginalInstanceCount = mInstanceCount;
-				mObjectConstantBuffer.Data.RenderingObjectFlags = mObjectShaderBitmaskFlags;
-				mObjectConstantBuffer.ApplyChanges(rhi);
-
-				mObjectFakeRootConstantBuffer.Data.CurrentLOD = lod;
-				mObjectFakeRootConstantBuffer.ApplyChanges(rhi);
-			}
+			UpdateObjectConstantBuffers(lod);
 
 			if (isForwardPass && mCore->GetLevel()->mIllumination)
 				mCore->GetLevel()->mIllumination->PreparePipelineForForwardLighting(this);
 
+			// prepare callback of the material is found once (it is called for every mesh)
+			const ER_EventListenerHandle prepareMaterialListener = (!isForwardPass && mMaterials[materialName]->IsStandard()) ?
+				MeshMaterialVariablesUpdateEvent->FindListener(materialName) : ER_EventListenerHandle();
+
 			bool isSpecificMesh = (meshIndex != -1);
 			for (int meshI = (isSpecificMesh) ? meshIndex : 0; meshI < ((isSpecificMesh) ? meshIndex + 1 : mMeshesCount[lod]); meshI++)
 			{
 				if (mIsInstanced)
 				{
-					if (mIsIndirectlyRendered)
+					if (isAllInstances)
+						rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer, mAllInstancesBuffer });
+					else if (mIsIndirectlyRendered)
 					{
 						//instead of instance buffer, we set a read-only structured buffer with instance data in the system (i.e. GBuffer)
 						//WARNING: Make sure the system actually sets that buffer!
 						rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer });
 					}
+					else if (shadowCascade >= 0)
+						rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer, mShadowCascadesInstanceBuffers[shadowCascade] });
 					else
 						rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer, mMeshesInstanceBuffers[lod][meshI]->InstanceBuffer });
 				}
@@ -460,28 +462,25 @@ namespace EveryRay_Core
 
 				// run prepare callbacks for standard materials (specials, i.e., shadow mapping, are processed in their own systems)
 				if (!isForwardPass && mMaterials[materialName]->IsStandard())
-				{
-					auto prepareMaterialBeforeRendering = MeshMaterialVariablesUpdateEvent->GetListener(materialName);
-					if (prepareMaterialBeforeRendering)
-						prepareMaterialBeforeRendering(meshI, lod);
-				}
+					MeshMaterialVariablesUpdateEvent->Invoke(prepareMaterialListener, meshI, lod);
 				else if (isForwardPass && mCore->GetLevel()->mIllumination)
 					mCore->GetLevel()->mIllumination->PrepareResourcesForForwardLighting(this, meshI, lod);
 
 				if (mIsInstanced)
 				{
-					if (mIsIndirectlyRendered && mIndirectArgsBuffer)
+					if (mIsIndirectlyRendered && mIndirectArgsBuffer && !isAllInstances)
 					{
 						if (!isForwardPass)
 							mMaterials[materialName]->SetRootConstantForMaterial(static_cast<UINT>(lod));
 
-						const int offset = (MAX_MESH_COUNT * lod + meshI) * 5 * sizeof(UINT); //5 is args count of DrawIndexedInstanced()
-						rhi->DrawIndexedInstancedIndirect(mIndirectArgsBuffer, offset);
+						rhi->DrawIndexedInstancedIndirect(mIndirectArgsBuffer, GetIndirectArgsByteOffset(lod, meshI));
 					}
 					else
 					{
-						if (mInstanceCountToRender[lod] > 0)
-							rhi->DrawIndexedInstanced(mMeshRenderBuffers[lod][meshI]->IndicesCount, mInstanceCountToRender[lod], 0, 0, 0);
+						const UINT instanceCount = isAllInstances ? mAllInstancesUploadState.Count :
+							(shadowCascade >= 0) ? mShadowCascadesUploadStates[shadowCascade].Count : mInstanceCountToRender[lod];
+						if (instanceCount > 0)
+							rhi->DrawIndexedInstanced(mMeshRenderBuffers[lod][meshI]->IndicesCount, instanceCount, 0, 0, 0);
 						else
 							continue;
 					}
@@ -492,6 +491,73 @@ namespace EveryRay_Core
 		}
 	}
 
+	void ER_RenderingObject::UpdateObjectConstantBuffers(int lod)
+	{
+		ER_RHI* rhi = mCore->GetRHI();
+
+		mObjectConstantBuffer.Data.World = XMMatrixTranspose(mTransformationMatrix);
+		mObjectConstantBuffer.Data.IndexOfRefraction = mIOR;
+		mObjectConstantBuffer.Data.CustomRoughness = mCustomRoughness;
+		mObjectConstantBuffer.Data.CustomMetalness = mCustomMetalness;
+		mObjectConstantBuffer.Data.CustomAlphaDiscard = mCustomAlphaDiscard;
+		mObjectConstantBuffer.Data.OriginalInstanceCount = mInstanceCount;
+		mObjectConstantBuffer.Data.RenderingObjectFlags = mObjectShaderBitmaskFlags;
+		mObjectConstantBuffer.Data.IndirectInstanceOffset = mIndirectNewInstanceDataOffset;
+		mObjectConstantBuffer.ApplyChanges(rhi);
+
+		mObjectFakeRootConstantBuffer.Data.CurrentLOD = lod;
+		mObjectFakeRootConstantBuffer.ApplyChanges(rhi);
+	}
+
+	UINT ER_RenderingObject::GetIndirectArgsByteOffset(int lod, int meshIndex) const
+	{
+		// the object's args region has ER_GPU_CULLING_DRAWS_PER_OBJECT entries, anything outside of it belongs to other objects
+		assert(("LOD/mesh is out of the object's indirect args region", lod >= 0 && lod < MAX_LOD && meshIndex >= 0 && meshIndex < MAX_MESH_COUNT));
+		return mIndirectArgsByteOffset + (MAX_MESH_COUNT * lod + meshIndex) * ER_GPU_CULLING_DRAW_ARGS_COUNT * sizeof(UINT);
+	}
+
+	bool ER_RenderingObject::IsLODDrawable(int lod) const
+	{
+		if (lod < 0 || lod >= static_cast<int>(mMeshRenderBuffers.size()) || mMeshRenderBuffers[lod].size() == 0)
+			return false;
+		if (mIsInstanced && !mIsIndirectlyRendered)
+			return mInstanceCountToRender[lod] > 0;
+		if (mIsInstanced)
+			return lod < MAX_LOD; // ER_GPUCuller only selects the first MAX_LOD LODs (they have draw args)
+		return true;
+	}
+
+	void ER_RenderingObject::DrawMesh(ER_Material* material, int meshIndex, int lod, bool setBuffers)
+	{
+		assert(material);
+		ER_RHI* rhi = mCore->GetRHI();
+		const RenderBufferData* buffers = mMeshRenderBuffers[lod][meshIndex];
+
+		if (setBuffers)
+		{
+			if (mIsInstanced && !mIsIndirectlyRendered)
+				rhi->SetVertexBuffers({ buffers->VertexBuffer, mMeshesInstanceBuffers[lod][meshIndex]->InstanceBuffer });
+			else
+				rhi->SetVertexBuffers({ buffers->VertexBuffer });
+			rhi->SetIndexBuffer(buffers->IndexBuffer);
+		}
+
+		if (mIsInstanced)
+		{
+			if (mIsIndirectlyRendered)
+			{
+				if (!mIndirectArgsBuffer || lod >= MAX_LOD)
+					return;
+				material->SetRootConstantForMaterial(static_cast<UINT>(lod));
+				rhi->DrawIndexedInstancedIndirect(mIndirectArgsBuffer, GetIndirectArgsByteOffset(lod, meshIndex));
+			}
+			else if (mInstanceCountToRender[lod] > 0)
+				rhi->DrawIndexedInstanced(buffers->IndicesCount, mInstanceCountToRender[lod], 0, 0, 0);
+		}
+		else
+			rhi->DrawIndexed(buffers->IndicesCount);
+	}
+
 	void ER_RenderingObject::DrawAABB(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_RHI_GPURootSignature* rs)
 	{
 		if (mIsSelected && mIsAvailableInEditorMode && mIsAABBDebugEnabled && ER_Utility::IsEditorMode)
@@ -569,6 +635,14 @@ namespace EveryRay_Core
 	// new instancing code
 	void ER_RenderingObject::UpdateInstanceBuffer(std::vector<InstancedData>& instanceData, int lod)
 	{
+		UpdateInstanceBuffer(instanceData.data(), static_cast<UINT>(instanceData.size()), lod);
+	}
+
+	void ER_RenderingObject::UpdateInstanceBuffer(const InstancedData* instanceData, UINT instanceCount, int lod)
+	{
+		if (mIsIndirectlyRendered && lod == 0)
+			MarkIndirectInstancesDirty(0, instanceCount); // transforms were changed outside (i.e., on-terrain placement, light probes)
+
 #ifdef NDEBUG
 		if (mIsIndirectlyRendered)
 			return;
@@ -576,14 +650,129 @@ namespace EveryRay_Core
 
 		assert(lod < mMeshesInstanceBuffers.size());
 
-		for (size_t i = 0; i < mMeshesCount[lod]; i++)
+		if (mInstanceBuffersUploadStates.size() != mMeshesInstanceBuffers.size())
+			mInstanceBuffersUploadStates.resize(mMeshesInstanceBuffers.size());
+
+		MarkDirtyInstanceBlocks(mInstanceBuffersUploadStates[lod], instanceData, instanceCount);
+		mInstanceCountToRender[lod] = instanceCount;
+
+		UploadDirtyInstanceRanges(lod);
+	}
+
+	// Compares new instance data with the last one block by block (instances that were not in the last data are always dirty):
+	// if culling and LOD results did not change, nothing is marked and the upload is skipped
+	void ER_RenderingObject::MarkDirtyInstanceBlocks(InstanceBufferUploadState& state, const InstancedData* instanceData, UINT instanceCount)
+	{
+		assert(instanceCount <= MAX_INSTANCE_COUNT);
+		assert(instanceCount == 0 || instanceData);
+
+		const UINT versionsCount = mCore->GetRHI()->GetDynamicBufferVersionsCount();
+		assert(versionsCount <= 8); // one bit per version in "DirtyBlocks"
+		const UINT8 allVersionsMask = static_cast<UINT8>((1u << versionsCount) - 1);
+
+		const UINT blocksCount = (instanceCount + RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK - 1) / RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK;
+		if (state.Data.size() < instanceCount)
+			state.Data.resize(instanceCount);
+		if (state.DirtyBlocks.size() < blocksCount)
+			state.DirtyBlocks.resize(blocksCount, 0);
+
+		for (UINT block = 0; block < blocksCount; block++)
 		{
-			//CreateInstanceBuffer(instanceData);
-			mInstanceCountToRender[lod] = instanceData.size();
+			const UINT start = block * RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK;
+			const UINT end = std::min(start + RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK, instanceCount);
+			const size_t size = (end - start) * sizeof(InstancedData);
+			if (!ER_Utility::IsInstanceBufferDirtyTracking || end > state.Count || memcmp(&state.Data[start], &instanceData[start], size) != 0)
+			{
+				memcpy(&state.Data[start], &instanceData[start], size);
+				state.DirtyBlocks[block] |= allVersionsMask;
+				state.DirtyVersionsMask |= allVersionsMask;
+			}
+		}
+		state.Count = instanceCount;
+	}
+
+	void ER_RenderingObject::UploadDirtyInstanceRanges(int lod)
+	{
+		ER_RHI_GPUBuffer** buffers = mCore->FrameAllocator()->AllocateArray<ER_RHI_GPUBuffer*>(mMeshesCount[lod]);
+		for (int i = 0; i < mMeshesCount[lod]; i++)
+			buffers[i] = mMeshesInstanceBuffers[lod][i]->InstanceBuffer;
+		UploadDirtyInstanceRanges(mInstanceBuffersUploadStates[lod], ER_RHI_ArrayView<ER_RHI_GPUBuffer*>(buffers, mMeshesCount[lod]));
+	}
+
+	// Uploads dirty blocks to the current version of the buffers (other versions get them when they become current)
+	void ER_RenderingObject::UploadDirtyInstanceRanges(InstanceBufferUploadState& state, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> buffers)
+	{
+		auto rhi = mCore->GetRHI();
+
+		const UINT8 versionMask = static_cast<UINT8>(1u << rhi->GetDynamicBufferCurrentVersion());
+		const UINT64 fullUploadBytes = static_cast<UINT64>(state.Count) * InstanceSize() * buffers.size();
+		if (!(state.DirtyVersionsMask & versionMask))
+		{
+			mFrameSkippedInstanceBytes += fullUploadBytes;
+			mFrameSkippedInstanceUploadsCount++;
+			return;
+		}
+		state.DirtyVersionsMask &= ~versionMask;
+
+		// merge consecutive dirty blocks into ranges (blocks after "Count" keep their bits, they are marked again when they are used)
+		const UINT blocksCount = (state.Count + RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK - 1) / RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK;
+		ER_RHI_BufferRange* ranges = mCore->FrameAllocator()->AllocateArray<ER_RHI_BufferRange>(blocksCount);
+		UINT rangesCount = 0;
+		for (UINT block = 0; block < blocksCount; block++)
+		{
+			if (!(state.DirtyBlocks[block] & versionMask))
+				continue;
+			state.DirtyBlocks[block] &= ~versionMask;
+
+			const UINT start = block * RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK;
+			const UINT end = std::min(start + RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK, state.Count);
+			if (rangesCount > 0 && ranges[rangesCount - 1].Offset + ranges[rangesCount - 1].Size == start * InstanceSize())
+				ranges[rangesCount - 1].Size += (end - start) * InstanceSize();
+			else
+			{
+				ranges[rangesCount].Offset = start * InstanceSize();
+				ranges[rangesCount].Size = (end - start) * InstanceSize();
+				rangesCount++;
+			}
+		}
 
-			// dynamically update instance buffer
-			mCore->GetRHI()->UpdateBuffer(mMeshesInstanceBuffers[lod][i]->InstanceBuffer, mInstanceCountToRender[lod] == 0 ? nullptr : &instanceData[0], InstanceSize() * mInstanceCountToRender[lod]);
+		UINT64 uploadedBytes = 0;
+		if (rangesCount > 0)
+		{
+			for (ER_RHI_GPUBuffer* buffer : buffers)
+				uploadedBytes += rhi->UpdateBufferRanges(buffer, state.Data.data(), state.Count * InstanceSize(), ER_RHI_ArrayView<ER_RHI_BufferRange>(ranges, rangesCount));
+			mFrameInstanceUploadsCount++;
 		}
+		else
+			mFrameSkippedInstanceUploadsCount++;
+
+		mFrameUploadedInstanceBytes += uploadedBytes;
+		mFrameSkippedInstanceBytes += fullUploadBytes > uploadedBytes ? fullUploadBytes - uploadedBytes : 0;
+	}
+
+	void ER_RenderingObject::EndFrameInstanceBufferUploadStats()
+	{
+		mLastFrameInstanceBufferUploadStats.UploadedBytes = mFrameUploadedInstanceBytes.exchange(0);
+		mLastFrameInstanceBufferUploadStats.SkippedBytes = mFrameSkippedInstanceBytes.exchange(0);
+		mLastFrameInstanceBufferUploadStats.UploadsCount = mFrameInstanceUploadsCount.exchange(0);
+		mLastFrameInstanceBufferUploadStats.SkippedUploadsCount = mFrameSkippedInstanceUploadsCount.exchange(0);
+	}
+
+	void ER_RenderingObject::EndFrameLODStats()
+	{
+		for (UINT lod = 0; lod < RENDERING_OBJECT_LOD_STATS_MAX_LODS; lod++)
+			mLastFrameLODStats.InstancesPerLOD[lod] = mFrameLODInstancesCounts[lod].exchange(0);
+		mLastFrameLODStats.TooSmallCount = mFrameLODTooSmallCount.exchange(0);
+		mLastFrameLODStats.SwitchesCount = mFrameLODSwitchesCount.exchange(0);
+		mLastFrameLODStats.GPUSelectedObjectsCount = mFrameGPULODObjectsCount.exchange(0);
+	}
+
+	void ER_RenderingObject::SetPendingInstanceBufferUpdate(int lod, const InstancedData* data, UINT count)
+	{
+		assert(lod < static_cast<int>(mPendingInstanceBufferUpdates.size()));
+		mPendingInstanceBufferUpdates[lod].Data = data;
+		mPendingInstanceBufferUpdates[lod].Count = count;
+		mPendingInstanceBufferUpdates[lod].IsPending = true;
 	}
 
 	UINT ER_RenderingObject::InstanceSize() const
@@ -641,30 +830,97 @@ namespace EveryRay_Core
 
 		if (mIsInstanced)
 		{
-			XMMATRIX instanceWorldMatrix = XMMatrixIdentity();
 			const int currentLOD = 0; // no need to iterate through LODs (AABBs are shared between LODs, so culling results will be identical)
 
-			mTempPostCullingInstanceData.clear();
+			if (mIsCulledByScene)
 			{
-				std::vector<InstancedData> newInstanceData;
-				for (int instanceIndex = 0; instanceIndex < static_cast<int>(mInstanceCount); instanceIndex++)
+				// flags are already written by the scene BVH query, we only compact them (in the original order of the instances)
+				mVisibleInstanceCount = 0;
+				for (UINT i = 0; i < mInstanceCount; i++)
 				{
-					instanceWorldMatrix = XMLoadFloat4x4(&(mInstanceData[currentLOD][instanceIndex].World));
-					mInstanceCullingFlags[instanceIndex] = cullFunction(mInstanceAABBs[instanceIndex]);
-					if (!mInstanceCullingFlags[instanceIndex])
-						newInstanceData.push_back(instanceWorldMatrix);
+					if (!mInstanceCullingFlags[i])
+						mVisibleInstanceIndices[mVisibleInstanceCount++] = i;
 				}
-				mTempPostCullingInstanceData = newInstanceData; //we store a copy for future usages
-
-				// if we have lods, we will update instance buffers later in UpdateLODs()
-				if (GetLODCount() <= 1)
-					UpdateInstanceBuffer(mTempPostCullingInstanceData, 0);
 			}
+			else // SIMD test of all instances' bounds (SoA) which gives us a compacted list of visible instances
+				mVisibleInstanceCount = frustum.CullAABBs(mInstanceBoundsSoA, mVisibleInstanceIndices.data(), mInstanceCullingFlags.data());
+
+			// visible instances only live until they are uploaded in Update(), so they go to the frame allocator (no heap allocations)
+			mTempPostCullingInstanceData = mCore->FrameAllocator()->AllocateArray<InstancedData>(mVisibleInstanceCount);
+			mTempPostCullingInstanceCount = mVisibleInstanceCount;
+			for (UINT i = 0; i < mVisibleInstanceCount; i++)
+				mTempPostCullingInstanceData[i] = mInstanceData[currentLOD][mVisibleInstanceIndices[i]];
+
+			// if we have lods, we will update instance buffers later in UpdateLODs()
+			if (GetLODCount() <= 1)
+				SetPendingInstanceBufferUpdate(0, mTempPostCullingInstanceData, mTempPostCullingInstanceCount);
 		}
-		else
+		else if (!mIsCulledByScene)
 			mIsCulled = cullFunction(mGlobalAABB);
 	}
 
+	// Culls the instances against the planes of a shadow cascade's caster volume (see ER_ShadowMapper) on CPU.
+	// Only the AABBs from the last PrepareUpdate() are read, so different objects can be culled in parallel.
+	// Indirectly rendered objects only get the count (their instances are drawn from the GPU culling results).
+	UINT ER_RenderingObject::CullShadowCasterInstances(int cascade, const XMFLOAT4* planes, UINT planesCount)
+	{
+		assert(mIsInstanced);
+		assert(cascade < NUM_SHADOW_CASCADES);
+
+		ER_FrameAllocator* frameAllocator = mCore->FrameAllocator();
+		UINT* visibleIndices = frameAllocator->AllocateArray<UINT>(mInstanceBoundsSoA.Count);
+		const UINT visibleCount = ER_Frustum::CullAABBs(planes, planesCount, mInstanceBoundsSoA, visibleIndices);
+		if (mIsIndirectlyRendered)
+			return visibleCount;
+
+		mTempShadowCascadesInstanceData[cascade] = frameAllocator->AllocateArray<InstancedData>(visibleCount);
+		mTempShadowCascadesInstanceCount[cascade] = visibleCount;
+		for (UINT i = 0; i < visibleCount; i++)
+			mTempShadowCascadesInstanceData[cascade][i] = mInstanceData[0][visibleIndices[i]];
+
+		return visibleCount;
+	}
+
+	void ER_RenderingObject::UploadShadowCasterInstances(int cascade)
+	{
+		assert(mIsInstanced && !mIsIndirectlyRendered);
+		assert(cascade < NUM_SHADOW_CASCADES);
+
+		assert(mTempShadowCascadesInstanceCount[cascade] <= mInstanceCount);
+		if (!mShadowCascadesInstanceBuffers[cascade])
+		{
+			// casters are a subset of the instances, so the buffer does not need MAX_INSTANCE_COUNT elements
+			assert(mInstanceData[0].size() >= mInstanceCount);
+			auto rhi = mCore->GetRHI();
+			mShadowCascadesInstanceBuffers[cascade] = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Shadow Casters Instance Buffer: " + mName + ", cascade: " + std::to_string(cascade));
+			mShadowCascadesInstanceBuffers[cascade]->CreateGPUBufferResource(rhi, &mInstanceData[0][0], mInstanceCount, InstanceSize(), true, ER_BIND_VERTEX_BUFFER);
+		}
+
+		// same dirty tracking as for the main instance buffers: if the cascade's casters did not change, nothing is uploaded
+		MarkDirtyInstanceBlocks(mShadowCascadesUploadStates[cascade], mTempShadowCascadesInstanceData[cascade], mTempShadowCascadesInstanceCount[cascade]);
+		UploadDirtyInstanceRanges(mShadowCascadesUploadStates[cascade], { mShadowCascadesInstanceBuffers[cascade] });
+
+		mTempShadowCascadesInstanceData[cascade] = nullptr; // frame allocator memory is only valid in this frame
+		mTempShadowCascadesInstanceCount[cascade] = 0;
+	}
+
+	void ER_RenderingObject::UploadAllInstances()
+	{
+		assert(mIsInstanced);
+		assert(mInstanceData[0].size() >= mInstanceCount);
+
+		if (!mAllInstancesBuffer)
+		{
+			auto rhi = mCore->GetRHI();
+			mAllInstancesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - All Instances Buffer: " + mName);
+			mAllInstancesBuffer->CreateGPUBufferResource(rhi, &mInstanceData[0][0], mInstanceCount, InstanceSize(), true, ER_BIND_VERTEX_BUFFER);
+		}
+
+		// static instances are uploaded once, moved ones in their dirty blocks
+		MarkDirtyInstanceBlocks(mAllInstancesUploadState, &mInstanceData[0][0], mInstanceCount);
+		UploadDirtyInstanceRanges(mAllInstancesUploadState, { mAllInstancesBuffer });
+	}
+
 	void ER_RenderingObject::StoreInstanceDataAfterTerrainPlacement()
 	{
 		assert(mTempInstancesPositions);
@@ -785,45 +1041,30 @@ namespace EveryRay_Core
 		}
 		mIsTerrainPlacementFinished = true;
 	}
-	void ER_RenderingObject::Update(const ER_CoreTime& time)
+	// Thread-safe part of the update (no RHI and ImGui calls), so it can be executed from ER_JobSystem for many objects in parallel.
+	// Instance buffers that have to be uploaded are only marked here and uploaded later in Update() on the main thread.
+	void ER_RenderingObject::PrepareUpdate(const ER_CoreTime& time)
 	{
 		UpdateBitmaskFlags();
 
 		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
 		assert(camera);
 
-		bool isCurrentlyEditable = ER_Utility::IsEditorMode && mIsAvailableInEditorMode && mIsSelected;
-
-		if (isCurrentlyEditable && mIsInstanced)
-		{
-			// load current selected instance's transform to temp transform (for UI)
-			ER_MatrixHelper::GetFloatArray(mInstanceData[0][mEditorSelectedInstancedObjectIndex].World, mCurrentObjectTransformMatrix);
-		}
+		if (mPendingInstanceBufferUpdates.size() != GetLODCount())
+			mPendingInstanceBufferUpdates.resize(GetLODCount());
+		mTempPostCullingInstanceData = nullptr; // frame allocator memory of the previous frames is not ours anymore
+		mTempPostCullingInstanceCount = 0;
 
 		// place procedurally on terrain (only executed once, on load)
 		//if (mIsTerrainPlacement && !mIsTerrainPlacementFinished)
 		//	PlaceProcedurallyOnTerrain();
 
-		//update AABBs (global and instanced)
-		{
-			mGlobalAABB = mLocalAABB;
-			UpdateAABB(mGlobalAABB, mTransformationMatrix);
+		// AABBs are usually updated earlier in the frame (before the scene BVH)
+		if (!mAreBoundsUpdated)
+			UpdateBounds();
+		mAreBoundsUpdated = false;
 
-			if (mIsInstanced)
-			{
-				XMMATRIX instanceWorldMatrix = XMMatrixIdentity();
-				for (int instanceIndex = 0; instanceIndex < static_cast<int>(mInstanceCount); instanceIndex++)
-				{
-					instanceWorldMatrix = XMLoadFloat4x4(&(mInstanceData[0][instanceIndex].World));
-					mInstanceAABBs[instanceIndex] = mLocalAABB;
-					UpdateAABB(mInstanceAABBs[instanceIndex], instanceWorldMatrix);
-				}
-			}
-		}
-
-		if (mIsIndirectlyRendered)
-			CreateIndirectInstanceData(); // only happens once but we need to do it after the first update (i.e. after we placed the instances and calculated their AABBs)
-		else // fallback for old CPU frustum culling (i.e., makes sense for non-instanced objects)
+		if (!mIsIndirectlyRendered) // fallback for old CPU frustum culling (i.e., makes sense for non-instanced objects)
 		{
 			if (ER_Utility::IsMainCameraCPUFrustumCulling && camera)
 				PerformCPUFrustumCull(camera);
@@ -835,7 +1076,7 @@ namespace EveryRay_Core
 				{
 					//just updating transforms (that could be changed in a previous frame); this is not optimal (GPU buffer map() every frame...)
 					for (int lod = 0; lod < GetLODCount(); lod++)
-						UpdateInstanceBuffer(mInstanceData[lod], lod);
+						SetPendingInstanceBufferUpdate(lod, mInstanceData[lod].data(), static_cast<UINT>(mInstanceData[lod].size()));
 				}
 			}
 		}
@@ -843,6 +1084,74 @@ namespace EveryRay_Core
 		if (GetLODCount() > 1)
 			UpdateLODs();
 
+		mIsCulledByScene = false;
+		mIsUpdatePrepared = true;
+	}
+
+	void ER_RenderingObject::UpdateBounds()
+	{
+		mGlobalAABB = mLocalAABB;
+		UpdateAABB(mGlobalAABB, mTransformationMatrix);
+
+		if (mIsInstanced)
+		{
+			mCore->JobSystem()->ParallelFor(mInstanceCount, RENDERING_OBJECT_INSTANCES_PER_JOB, [this](UINT start, UINT end)
+			{
+				for (UINT instanceIndex = start; instanceIndex < end; instanceIndex++)
+				{
+					XMMATRIX instanceWorldMatrix = XMLoadFloat4x4(&(mInstanceData[0][instanceIndex].World));
+					mInstanceAABBs[instanceIndex] = mLocalAABB;
+					UpdateAABB(mInstanceAABBs[instanceIndex], instanceWorldMatrix);
+					mInstanceBoundsSoA.Set(instanceIndex, mInstanceAABBs[instanceIndex]);
+				}
+			});
+		}
+
+		mAreBoundsUpdated = true;
+	}
+
+	// Everything is culled until the scene BVH query marks the visible object/instances (SetCulled(), SetInstanceCulled())
+	void ER_RenderingObject::BeginSceneCulling()
+	{
+		assert(!mIsIndirectlyRendered);
+
+		mIsCulled = true;
+		if (mIsInstanced)
+			std::fill(mInstanceCullingFlags.begin(), mInstanceCullingFlags.end(), static_cast<UINT8>(1));
+		mIsCulledByScene = true;
+	}
+
+	void ER_RenderingObject::Update(const ER_CoreTime& time)
+	{
+		if (!mIsUpdatePrepared)
+			PrepareUpdate(time);
+		mIsUpdatePrepared = false;
+
+		bool isCurrentlyEditable = ER_Utility::IsEditorMode && mIsAvailableInEditorMode && mIsSelected;
+
+		if (isCurrentlyEditable && mIsInstanced)
+		{
+			// load current selected instance's transform to temp transform (for UI)
+			ER_MatrixHelper::GetFloatArray(mInstanceData[0][mEditorSelectedInstancedObjectIndex].World, mCurrentObjectTransformMatrix);
+		}
+
+		// ER_GPUCuller picks the instances up after the first update (i.e. after we placed the instances and calculated their AABBs)
+		if (mIsIndirectlyRendered && !mIsIndirectInstanceDataReady)
+			mIsIndirectInstanceDataReady = mInstanceCount > 0 && mInstanceAABBs.size() == mInstanceCount && mInstanceData.size() && mInstanceData[0].size() >= mInstanceCount;
+
+		// GPU uploads of instance data that was prepared in PrepareUpdate() (only the ranges that changed)
+		const UINT8 currentBufferVersionMask = static_cast<UINT8>(1u << mCore->GetRHI()->GetDynamicBufferCurrentVersion());
+		for (int lod = 0; lod < static_cast<int>(mPendingInstanceBufferUpdates.size()); lod++)
+		{
+			if (mPendingInstanceBufferUpdates[lod].IsPending)
+			{
+				UpdateInstanceBuffer(mPendingInstanceBufferUpdates[lod].Data, mPendingInstanceBufferUpdates[lod].Count, lod);
+				mPendingInstanceBufferUpdates[lod] = PendingInstanceBufferUpdate();
+			}
+			else if (lod < static_cast<int>(mInstanceBuffersUploadStates.size()) && (mInstanceBuffersUploadStates[lod].DirtyVersionsMask & currentBufferVersionMask))
+				UploadDirtyInstanceRanges(lod); // the current buffer version has not received the last update yet
+		}
+
 		if (isCurrentlyEditable)
 		{
 			UpdateGizmos();
@@ -855,20 +1164,21 @@ namespace EveryRay_Core
 	void ER_RenderingObject::UpdateAABB(ER_AABB& aabb, const XMMATRIX& transformMatrix)
 	{
 		// computing AABB from the non-axis aligned BB
-		mCurrentGlobalAABBVertices[0] = (XMFLOAT3(aabb.first.x, aabb.second.y, aabb.first.z));
-		mCurrentGlobalAABBVertices[1] = (XMFLOAT3(aabb.second.x, aabb.second.y, aabb.first.z));
-		mCurrentGlobalAABBVertices[2] = (XMFLOAT3(aabb.second.x, aabb.first.y, aabb.first.z));
-		mCurrentGlobalAABBVertices[3] = (XMFLOAT3(aabb.first.x, aabb.first.y, aabb.first.z));
-		mCurrentGlobalAABBVertices[4] = (XMFLOAT3(aabb.first.x, aabb.second.y, aabb.second.z));
-		mCurrentGlobalAABBVertices[5] = (XMFLOAT3(aabb.second.x, aabb.second.y, aabb.second.z));
-		mCurrentGlobalAABBVertices[6] = (XMFLOAT3(aabb.second.x, aabb.first.y, aabb.second.z));
-		mCurrentGlobalAABBVertices[7] = (XMFLOAT3(aabb.first.x, aabb.first.y, aabb.second.z));
+		XMFLOAT3 vertices[8]; // local (not a member), because instances' AABBs are updated in parallel
+		vertices[0] = (XMFLOAT3(aabb.first.x, aabb.second.y, aabb.first.z));
+		vertices[1] = (XMFLOAT3(aabb.second.x, aabb.second.y, aabb.first.z));
+		vertices[2] = (XMFLOAT3(aabb.second.x, aabb.first.y, aabb.first.z));
+		vertices[3] = (XMFLOAT3(aabb.first.x, aabb.first.y, aabb.first.z));
+		vertices[4] = (XMFLOAT3(aabb.first.x, aabb.second.y, aabb.second.z));
+		vertices[5] = (XMFLOAT3(aabb.second.x, aabb.second.y, aabb.second.z));
+		vertices[6] = (XMFLOAT3(aabb.second.x, aabb.first.y, aabb.second.z));
+		vertices[7] = (XMFLOAT3(aabb.first.x, aabb.first.y, aabb.second.z));
 
 		// non-axis-aligned BB (applying transform)
 		for (size_t i = 0; i < 8; i++)
 		{
-			XMVECTOR point = XMVector3Transform(XMLoadFloat3(&(mCurrentGlobalAABBVertices[i])), transformMatrix);
-			XMStoreFloat3(&(mCurrentGlobalAABBVertices[i]), point);
+			XMVECTOR point = XMVector3Transform(XMLoadFloat3(&(vertices[i])), transformMatrix);
+			XMStoreFloat3(&(vertices[i]), point);
 		}
 
 		XMFLOAT3 minVertex = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
@@ -877,14 +1187,14 @@ namespace EveryRay_Core
 		for (UINT i = 0; i < 8; i++)
 		{
 			//Get the smallest vertex 
-			minVertex.x = std::min(minVertex.x, mCurrentGlobalAABBVertices[i].x);    // Find smallest x value in model
-			minVertex.y = std::min(minVertex.y, mCurrentGlobalAABBVertices[i].y);    // Find smallest y value in model
-			minVertex.z = std::min(minVertex.z, mCurrentGlobalAABBVertices[i].z);    // Find smallest z value in model
+			minVertex.x = std::min(minVertex.x, vertices[i].x);    // Find smallest x value in model
+			minVertex.y = std::min(minVertex.y, vertices[i].y);    // Find smallest y value in model
+			minVertex.z = std::min(minVertex.z, vertices[i].z);    // Find smallest z value in model
 
 			//Get the largest vertex 
-			maxVertex.x = std::max(maxVertex.x, mCurrentGlobalAABBVertices[i].x);    // Find largest x value in model
-			maxVertex.y = std::max(maxVertex.y, mCurrentGlobalAABBVertices[i].y);    // Find largest y value in model
-			maxVertex.z = std::max(maxVertex.z, mCurrentGlobalAABBVertices[i].z);    // Find largest z value in model
+			maxVertex.x = std::max(maxVertex.x, vertices[i].x);    // Find largest x value in model
+			maxVertex.y = std::max(maxVertex.y, vertices[i].y);    // Find largest y value in model
+			maxVertex.z = std::max(maxVertex.z, vertices[i].z);    // Find largest z value in model
 		}
 
 		aabb = ER_AABB(minVertex, maxVertex);
@@ -908,6 +1218,8 @@ namespace EveryRay_Core
 		{
 			for (int lod = 0; lod < GetLODCount(); lod++)
 				mInstanceData[lod][mEditorSelectedInstancedObjectIndex].World = XMFLOAT4X4(mCurrentObjectTransformMatrix);
+			if (mIsIndirectlyRendered)
+				MarkIndirectInstancesDirty(mEditorSelectedInstancedObjectIndex, 1);
 		}
 	}
 	
@@ -954,6 +1266,12 @@ namespace EveryRay_Core
 				std::string vertexCountText = "--> Vertex count LOD#" + std::to_string(lodI) + ": " + std::to_string(GetVertices(lodI).size());
 				ImGui::Text(vertexCountText.c_str());
 			}
+			if (GetLODCount() > 1)
+			{
+				if (!mIsInstanced)
+					ImGui::Text("--> Screen size: %.4f", ComputeScreenSize(mGlobalAABB, mCamera.Position(), mCamera.ProjectionMatrix4X4()._22) * mLODBias * ER_Utility::LODBias);
+				ImGui::SliderFloat("LOD bias", &mLODBias, 0.1f, 4.0f);
+			}
 
 			std::string meshCountText = "* Mesh count: " + std::to_string(GetMeshCount());
 			ImGui::Text(meshCountText.c_str());
@@ -1187,8 +1505,14 @@ namespace EveryRay_Core
 				std::string instanceName = mName + " #" + std::to_string(i);
 				mInstancesNames.push_back(instanceName);
 				mInstanceAABBs.push_back(mLocalAABB);
-				mInstanceCullingFlags.push_back(false);
+				mInstanceCullingFlags.push_back(0);
 			}
+
+			mInstanceBoundsSoA.Resize(mInstanceCount);
+			for (UINT i = 0; i < mInstanceCount; i++)
+				mInstanceBoundsSoA.Set(i, mInstanceAABBs[i]);
+			mVisibleInstanceIndices.resize(mInstanceBoundsSoA.Count);
+			mVisibleInstanceCount = 0;
 		}
 
 		if (clear)
@@ -1199,126 +1523,221 @@ namespace EveryRay_Core
 		if (lod == -1) {
 			for (int lod = 0; lod < GetLODCount(); lod++)
 				mInstanceData[lod].push_back(InstancedData(worldMatrix));
+			if (mIsIndirectlyRendered)
+				MarkIndirectInstancesDirty(static_cast<UINT>(mInstanceData[0].size()) - 1, 1);
 			return;
 		}
 
 		assert(lod < mInstanceData.size());
 		mInstanceData[lod].push_back(InstancedData(worldMatrix));
+		if (mIsIndirectlyRendered && lod == 0)
+			MarkIndirectInstancesDirty(static_cast<UINT>(mInstanceData[0].size()) - 1, 1);
 	}
 
-	void ER_RenderingObject::CreateIndirectInstanceData()
+	// AABBs are computed from the transforms here (not taken from mInstanceAABBs), because the transforms might have been changed after UpdateBounds() in this frame
+	void ER_RenderingObject::GetIndirectInstanceData(ER_GPUCullingInstance* aOutInstances, UINT aFirstInstance, UINT aInstancesCount) const
 	{
-		ER_RHI* rhi = mCore->GetRHI();
+		assert(mIsIndirectlyRendered && mIsIndirectInstanceDataReady);
+		assert(aOutInstances || aInstancesCount == 0);
+		assert(aFirstInstance + aInstancesCount <= mInstanceCount);
 
-		if (mIndirectOriginalInstanceDataBuffer) // means we already created the buffers
-			return;
+		for (UINT i = 0; i < aInstancesCount; ++i)
+		{
+			const InstancedData& instance = mInstanceData[0][aFirstInstance + i];
+			ER_AABB aabb = mLocalAABB;
+			UpdateAABB(aabb, XMLoadFloat4x4(&instance.World));
+
+			aOutInstances[i].World = instance.World;
+			aOutInstances[i].AABBMin = XMFLOAT4(aabb.first.x, aabb.first.y, aabb.first.z, 1.0f);
+			aOutInstances[i].AABBMax = XMFLOAT4(aabb.second.x, aabb.second.y, aabb.second.z, 1.0f);
+		}
+	}
 
-		if (rhi->GetAPI() == DX12 && rhi->GetCurrentGraphicsCommandListIndex() == -1)
+	void ER_RenderingObject::MarkIndirectInstancesDirty(UINT firstInstance, UINT instanceCount)
+	{
+		if (instanceCount == 0)
 			return;
 
-		assert(mIsIndirectlyRendered);
-		assert(!mIndirectNewInstanceDataBuffer);
-		assert(!mIndirectOriginalInstanceDataBuffer);
-		assert(mInstanceCount);
-		assert(mInstanceAABBs.size());
-		assert(mInstanceData[0].size());
+		const UINT lastBlock = (firstInstance + instanceCount - 1) / ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK;
+		if (mIndirectDirtyInstanceBlocks.size() <= lastBlock)
+			mIndirectDirtyInstanceBlocks.resize(lastBlock + 1, 0);
+		for (UINT block = firstInstance / ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK; block <= lastBlock; block++)
+			mIndirectDirtyInstanceBlocks[block] = 1;
+		mHasIndirectDirtyInstances = true;
+	}
 
-		mIndirectNewInstanceDataBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Indirect New Instance Data Buffer : " + mName);
-		mIndirectOriginalInstanceDataBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Indirect Original Instance Data Buffer : " + mName);
+	// Static instances are never marked, so ER_GPUCuller does not copy (or compare) anything for them
+	bool ER_RenderingObject::TakeIndirectDirtyInstanceRanges(std::vector<std::pair<UINT, UINT>>& aOutRanges)
+	{
+		aOutRanges.clear();
+		if (!mHasIndirectDirtyInstances)
+			return false;
+		mHasIndirectDirtyInstances = false;
 
-		struct IndirectInstanceData 
+		for (UINT block = 0; block < static_cast<UINT>(mIndirectDirtyInstanceBlocks.size()); block++)
 		{
-			XMFLOAT4X4 world;
-			XMFLOAT4 aabbMin;
-			XMFLOAT4 aabbMax;
-		};
+			if (!mIndirectDirtyInstanceBlocks[block])
+				continue;
+			mIndirectDirtyInstanceBlocks[block] = 0;
+
+			const UINT start = block * ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK;
+			if (start >= mInstanceCount)
+				continue;
+			const UINT end = std::min(start + ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK, mInstanceCount);
+			if (!aOutRanges.empty() && aOutRanges.back().first + aOutRanges.back().second == start)
+				aOutRanges.back().second += end - start;
+			else
+				aOutRanges.push_back(std::make_pair(start, end - start));
+		}
+		return !aOutRanges.empty();
+	}
+
+	void ER_RenderingObject::SetIndirectBuffers(ER_RHI_GPUBuffer* aNewInstanceBuffer, UINT aNewInstanceOffset, ER_RHI_GPUBuffer* aArgsBuffer, UINT aArgsByteOffset)
+	{
+		assert(mIsIndirectlyRendered);
+		mIndirectNewInstanceDataBuffer = aNewInstanceBuffer;
+		mIndirectNewInstanceDataOffset = aNewInstanceOffset;
+		mIndirectArgsBuffer = aArgsBuffer;
+		mIndirectArgsByteOffset = aArgsByteOffset;
+	}
+
+	float ER_RenderingObject::GetLODScreenSize(int lod) const
+	{
+		assert(lod >= 0);
+		if (lod < static_cast<int>(mLODScreenSizes.size()))
+			return mLODScreenSizes[lod];
+
+		// no per-object thresholds: global ones, halved for every LOD after them
+		if (lod < MAX_LOD)
+			return ER_Utility::ScreenSizesLOD[lod];
+		return ER_Utility::ScreenSizesLOD[MAX_LOD - 1] * powf(0.5f, static_cast<float>(lod - MAX_LOD + 1));
+	}
 
-		std::vector<IndirectInstanceData> data;
-		data.resize(mInstanceCount);
+	float ER_RenderingObject::ComputeScreenSize(const ER_AABB& aabb, const XMFLOAT3& cameraPos, float projectionScale)
+	{
+		const XMFLOAT3 center = XMFLOAT3((aabb.first.x + aabb.second.x) * 0.5f, (aabb.first.y + aabb.second.y) * 0.5f, (aabb.first.z + aabb.second.z) * 0.5f);
+		const XMFLOAT3 extent = XMFLOAT3(aabb.second.x - center.x, aabb.second.y - center.y, aabb.second.z - center.z);
+		const float radiusSqr = extent.x * extent.x + extent.y * extent.y + extent.z * extent.z;
+		const float distanceSqr =
+			(cameraPos.x - center.x) * (cameraPos.x - center.x) +
+			(cameraPos.y - center.y) * (cameraPos.y - center.y) +
+			(cameraPos.z - center.z) * (cameraPos.z - center.z);
+
+		if (distanceSqr <= radiusSqr) // camera is inside the bounding sphere
+			return FLT_MAX;
+
+		// projected radius of the sphere relative to half of the screen height (= its diameter relative to the screen height)
+		return sqrt(radiusSqr) * projectionScale / sqrt(distanceSqr - radiusSqr);
+	}
 
-		for (int i = 0; i < mInstanceCount; ++i)
+	int ER_RenderingObject::SelectLOD(float screenSize, int previousLOD) const
+	{
+		const int lodCount = GetLODCount();
+		screenSize *= mLODBias * ER_Utility::LODBias;
+
+		// keep the previous LOD while the size is within its range, extended by the hysteresis band on both sides
+		if (previousLOD >= -1 && previousLOD < lodCount)
 		{
-			data[i].world = mInstanceData[0][i].World;
-			data[i].aabbMin = XMFLOAT4(mInstanceAABBs[i].first.x, mInstanceAABBs[i].first.y, mInstanceAABBs[i].first.z, 1.0f);
-			data[i].aabbMax = XMFLOAT4(mInstanceAABBs[i].second.x, mInstanceAABBs[i].second.y, mInstanceAABBs[i].second.z, 1.0f);
+			const int previous = (previousLOD == -1) ? lodCount : previousLOD; // "not rendered" is the range after the last LOD
+			const float lowerSize = (previous < lodCount) ? GetLODScreenSize(previous) * (1.0f - ER_Utility::LODHysteresis) : 0.0f;
+			const float upperSize = (previous > 0) ? GetLODScreenSize(previous - 1) * (1.0f + ER_Utility::LODHysteresis) : FLT_MAX;
+			if (screenSize >= lowerSize && screenSize < upperSize)
+				return previousLOD;
 		}
 
-		mIndirectOriginalInstanceDataBuffer->CreateGPUBufferResource(rhi, &data[0], mInstanceCount, sizeof(IndirectInstanceData), false,
-			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
-		mIndirectNewInstanceDataBuffer->CreateGPUBufferResource(rhi, nullptr, mInstanceCount * MAX_LOD, sizeof(IndirectInstanceData), false,
-			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED, ER_FORMAT_UNKNOWN);
+		for (int lod = 0; lod < lodCount; lod++)
+		{
+			if (screenSize >= GetLODScreenSize(lod))
+				return lod;
+		}
+		return -1;
 	}
 
 	void ER_RenderingObject::UpdateLODs()
 	{
-		const float sqrDistLod0 = ER_Utility::DistancesLOD[0] * ER_Utility::DistancesLOD[0];
-		const float sqrDistLod1 = ER_Utility::DistancesLOD[1] * ER_Utility::DistancesLOD[1];
-		const float sqrDistLod2 = ER_Utility::DistancesLOD[2] * ER_Utility::DistancesLOD[2];
+		const XMFLOAT3 cameraPos = mCamera.Position();
+		const float projectionScale = mCamera.ProjectionMatrix4X4()._22;
+
+		UINT64 lodsStats[RENDERING_OBJECT_LOD_STATS_MAX_LODS] = {};
+		UINT64 tooSmallCount = 0;
+		UINT64 switchesCount = 0;
+		auto addToStats = [&](int lod, int previousLOD)
+		{
+			if (lod >= 0)
+				lodsStats[std::min(lod, static_cast<int>(RENDERING_OBJECT_LOD_STATS_MAX_LODS) - 1)]++;
+			else
+				tooSmallCount++;
+			if (lod != previousLOD)
+				switchesCount++;
+		};
 
 		if (mIsInstanced) {
-			if (!mIsIndirectlyRendered) // LODs are also updated in ER_GPUCuller, so no need to do that here
+			if (mIsIndirectlyRendered) // LODs are selected in ER_GPUCuller, so no need to do that here
+			{
+				mFrameGPULODObjectsCount.fetch_add(1, std::memory_order_relaxed);
 				return;
+			}
 			if (!ER_Utility::IsMainCameraCPUFrustumCulling && mInstanceData.size() == 0)
 				return;
-			if (ER_Utility::IsMainCameraCPUFrustumCulling && mTempPostCullingInstanceData.size() == 0)
-				return;
-
-			mTempPostLoddingInstanceData.clear();
-			for (int lod = 0; lod < GetLODCount(); lod++)
-				mTempPostLoddingInstanceData.push_back({});
 
 			//traverse through original or culled instance data (sort of "read-only") to rebalance LOD's instance buffers
-			int length = (ER_Utility::IsMainCameraCPUFrustumCulling) ? static_cast<int>(mTempPostCullingInstanceData.size()) : static_cast<int>(mInstanceData[0].size());
-			for (int i = 0; i < length; i++)
+			const bool isCulled = ER_Utility::IsMainCameraCPUFrustumCulling; // visible instances are in "mVisibleInstanceIndices" (can be none)
+			const InstancedData* sourceData = isCulled ? mTempPostCullingInstanceData : mInstanceData[0].data();
+			const UINT length = isCulled ? mTempPostCullingInstanceCount : static_cast<UINT>(mInstanceData[0].size());
+			const int lodCount = GetLODCount();
+			if (mInstancesLODs.size() != mInstanceCount)
+				mInstancesLODs.assign(mInstanceCount, 0);
+
+			// first pass: LOD of every instance and LOD sizes, second pass: scatter into per-LOD arrays (all in the frame allocator)
+			ER_FrameAllocator* frameAllocator = mCore->FrameAllocator();
+			INT8* instancesLODs = frameAllocator->AllocateArray<INT8>(length);
+			UINT* lodsCounts = frameAllocator->AllocateArray<UINT>(lodCount);
+			std::fill(lodsCounts, lodsCounts + lodCount, 0);
+			for (UINT i = 0; i < length; i++)
 			{
-				XMFLOAT3 pos;
-				XMMATRIX mat = (ER_Utility::IsMainCameraCPUFrustumCulling) ? XMLoadFloat4x4(&mTempPostCullingInstanceData[i].World) : XMLoadFloat4x4(&mInstanceData[0][i].World);
-				ER_MatrixHelper::GetTranslation(mat, pos);
-
-				float distanceToCameraSqr =
-					(mCamera.Position().x - pos.x) * (mCamera.Position().x - pos.x) +
-					(mCamera.Position().y - pos.y) * (mCamera.Position().y - pos.y) +
-					(mCamera.Position().z - pos.z) * (mCamera.Position().z - pos.z);
-
-				//XMMATRIX newMat;
-				if (distanceToCameraSqr <= sqrDistLod0) {
-					mTempPostLoddingInstanceData[0].push_back((ER_Utility::IsMainCameraCPUFrustumCulling) ? mTempPostCullingInstanceData[i].World : mInstanceData[0][i].World);
-				}
-				else if (sqrDistLod0 < distanceToCameraSqr && distanceToCameraSqr <= sqrDistLod1) {
-					mTempPostLoddingInstanceData[1].push_back((ER_Utility::IsMainCameraCPUFrustumCulling) ? mTempPostCullingInstanceData[i].World : mInstanceData[0][i].World);
-				}
-				else if (sqrDistLod1 < distanceToCameraSqr && distanceToCameraSqr <= sqrDistLod2) {
-					mTempPostLoddingInstanceData[2].push_back((ER_Utility::IsMainCameraCPUFrustumCulling) ? mTempPostCullingInstanceData[i].World : mInstanceData[0][i].World);
-				}
-			}
+				const UINT instance = isCulled ? mVisibleInstanceIndices[i] : i;
+				assert(instance < mInstanceCount);
 
-			for (int i = 0; i < GetLODCount(); i++)
-				UpdateInstanceBuffer(mTempPostLoddingInstanceData[i], i);
-		}
-		else
-		{
-			XMFLOAT3 pos;
-			ER_MatrixHelper::GetTranslation(mTransformationMatrix, pos);
-
-			float distanceToCameraSqr =
-				(mCamera.Position().x - pos.x) * (mCamera.Position().x - pos.x) +
-				(mCamera.Position().y - pos.y) * (mCamera.Position().y - pos.y) +
-				(mCamera.Position().z - pos.z) * (mCamera.Position().z - pos.z);
+				const int previousLOD = mInstancesLODs[instance];
+				const int lod = SelectLOD(ComputeScreenSize(mInstanceAABBs[instance], cameraPos, projectionScale), previousLOD);
+				addToStats(lod, previousLOD);
 
-			if (distanceToCameraSqr <= sqrDistLod0) {
-				mCurrentLODIndex = 0;
+				mInstancesLODs[instance] = static_cast<INT8>(lod);
+				instancesLODs[i] = static_cast<INT8>(lod);
+				if (lod >= 0)
+					lodsCounts[lod]++;
 			}
-			else if (sqrDistLod0 < distanceToCameraSqr && distanceToCameraSqr <= sqrDistLod1) {
-				mCurrentLODIndex = 1;
+
+			InstancedData** lodsData = frameAllocator->AllocateArray<InstancedData*>(lodCount);
+			UINT* lodsWritten = frameAllocator->AllocateArray<UINT>(lodCount);
+			for (int lod = 0; lod < lodCount; lod++)
+			{
+				lodsData[lod] = frameAllocator->AllocateArray<InstancedData>(lodsCounts[lod]);
+				lodsWritten[lod] = 0;
 			}
-			else if (sqrDistLod1 < distanceToCameraSqr && distanceToCameraSqr <= sqrDistLod2) {
-				mCurrentLODIndex = 2;
+			for (UINT i = 0; i < length; i++)
+			{
+				if (instancesLODs[i] >= 0)
+					lodsData[instancesLODs[i]][lodsWritten[instancesLODs[i]]++] = sourceData[i];
 			}
-			else
-				mCurrentLODIndex = -1; //culled
 
-			mCurrentLODIndex = std::min(mCurrentLODIndex, GetLODCount());
+			for (int lod = 0; lod < lodCount; lod++)
+				SetPendingInstanceBufferUpdate(lod, lodsData[lod], lodsCounts[lod]);
+		}
+		else
+		{
+			const int previousLOD = mCurrentLODIndex;
+			mCurrentLODIndex = SelectLOD(ComputeScreenSize(mGlobalAABB, cameraPos, projectionScale), previousLOD); // -1 - culled
+			addToStats(mCurrentLODIndex, previousLOD);
+		}
+
+		for (UINT lod = 0; lod < RENDERING_OBJECT_LOD_STATS_MAX_LODS; lod++)
+		{
+			if (lodsStats[lod])
+				mFrameLODInstancesCounts[lod].fetch_add(lodsStats[lod], std::memory_order_relaxed);
 		}
+		mFrameLODTooSmallCount.fetch_add(tooSmallCount, std::memory_order_relaxed);
+		mFrameLODSwitchesCount.fetch_add(switchesCount, std::memory_order_relaxed);
 	}
 }
 
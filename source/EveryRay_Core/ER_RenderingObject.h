@@ -3,10 +3,17 @@
 #include "Common.h"
 #include "ER_GenericEvent.h"
 #include "ER_ModelMaterial.h"
+#include "ER_Frustum.h"
 
 #include "RHI\ER_RHI.h"
 
+#include <atomic>
+
 const UINT MAX_INSTANCE_COUNT = 20000;
+const UINT RENDERING_OBJECT_INSTANCES_PER_JOB = 1024; // batch size for the parallel update of instances
+const UINT RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK = 64; // granularity of dirty tracking in instance buffers
+const UINT RENDERING_OBJECT_LOD_STATS_MAX_LODS = 8; // finer LOD statistics are not collected (higher LODs are counted in the last one)
+const int RENDERING_OBJECT_ALL_INSTANCES = -2; // "shadowCascade" of DrawLOD() for all instances of UploadAllInstances() (camera's culling is ignored)
 
 // Bitmasks for "RenderingObjectFlags" as decimal values
 // Keep in sync with content/shaders/Common.hlsli!
@@ -31,6 +38,7 @@ namespace EveryRay_Core
 	class ER_RenderableAABB;
 	class ER_Camera;
 	class ER_Model;
+	struct ER_GPUCullingInstance;
 
 	enum RenderingObjectTextureQuality
 	{
@@ -83,6 +91,7 @@ namespace EveryRay_Core
 		float CustomAlphaDiscard;
 		UINT OriginalInstanceCount;
 		UINT RenderingObjectFlags;
+		UINT IndirectInstanceOffset; // of the object's instances in ER_GPUCuller's culled instances buffer
 	};
 
 	struct ER_ALIGN_GPU_BUFFER ObjectFakeRootCB
@@ -139,6 +148,24 @@ namespace EveryRay_Core
 		
 	};
 
+	// Instance buffer uploads of all rendering objects during the last frame
+	struct ER_InstanceBufferUploadStats
+	{
+		UINT64 UploadedBytes = 0;
+		UINT64 SkippedBytes = 0; // unchanged data that would have been uploaded without dirty tracking
+		UINT64 UploadsCount = 0; // per LOD group or shadow cascade (buffers of all its meshes are updated together)
+		UINT64 SkippedUploadsCount = 0; // LOD groups and shadow cascades whose current buffer version was already up to date
+	};
+
+	// LODs selected on CPU for all rendering objects during the last frame (indirectly rendered objects select them on GPU and are only counted)
+	struct ER_LODStats
+	{
+		UINT64 InstancesPerLOD[RENDERING_OBJECT_LOD_STATS_MAX_LODS] = {}; // instances (or non-instanced objects) rendered with every LOD
+		UINT64 TooSmallCount = 0; // smaller on screen than the last LOD's threshold (not rendered)
+		UINT64 SwitchesCount = 0; // changed their LOD since the previous frame
+		UINT64 GPUSelectedObjectsCount = 0;
+	};
+
 	class ER_RenderingObject
 	{
 		using Delegate_MeshMaterialVariablesUpdate = std::function<void(int, int)>; // mesh index & lod index for input
@@ -155,9 +182,20 @@ namespace EveryRay_Core
 		void LoadAssignedMeshTextures(int meshIndex);
 
 		void Draw(const std::string& materialName, bool toDepth = false, int meshIndex = -1);
-		void DrawLOD(const std::string& materialName, bool toDepth, int meshIndex, int lod, bool skipCulling = false);
+		void DrawLOD(const std::string& materialName, bool toDepth, int meshIndex, int lod, bool skipCulling = false, int shadowCascade = -1);
 		void DrawAABB(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_RHI_GPURootSignature* rs);
-		void Update(const ER_CoreTime& time);
+
+		// DrawLOD() split into the per-object and the per-mesh parts for sorted submission (i.e., ER_GBuffer's render queue), so that the caller can skip redundant state.
+		// Culling, the material and the prepare callbacks are handled by the caller.
+		bool IsLODDrawable(int lod) const; // has meshes and (if instanced, not indirect) instances to render
+		void UpdateObjectConstantBuffers(int lod);
+		void DrawMesh(ER_Material* material, int meshIndex, int lod, bool setBuffers);
+		ER_RHI_GPUBuffer* GetVertexBuffer(int lod, int meshIndex) const { return mMeshRenderBuffers[lod][meshIndex]->VertexBuffer; }
+		int GetCurrentLODIndex() const { return mCurrentLODIndex; } // -1 if the object is too small to be rendered
+
+		void UpdateBounds(); // world space AABBs of the object and its instances (thread-safe for different objects)
+		void PrepareUpdate(const ER_CoreTime& time); // thread-safe part of Update() (AABBs, culling, LODs)
+		void Update(const ER_CoreTime& time); // main thread part (GPU uploads, editor)
 
 		std::map<std::string, ER_Material*>& GetMaterials() { return mMaterials; }
 		
@@ -166,6 +204,7 @@ namespace EveryRay_Core
 		const int GetMeshCount(int lod = 0) const { return mMeshesCount[lod]; }
 		const std::vector<XMFLOAT3>& GetVertices(int lod = 0) { return mMeshAllVertices[lod]; }
 		const UINT GetInstanceCount(int lod = 0) const { return (mIsInstanced ? static_cast<UINT>(mInstanceData[lod].size()) : 0); }
+		const UINT GetOriginalInstanceCount() const { return (mIsInstanced ? mInstanceCount : 0); } // instances with AABBs (before culling)
 		std::vector<InstancedData>& GetInstancesData(int lod = 0) { return mInstanceData[lod]; }
 		const int GetIndexCount(int lod, int mesh) const { return mMeshRenderBuffers[lod][mesh]->IndicesCount; }
 
@@ -183,17 +222,33 @@ namespace EveryRay_Core
 
 		void LoadInstanceBuffers(int lod = 0);
 		void UpdateInstanceBuffer(std::vector<InstancedData>& instanceData, int lod = 0);
+		void UpdateInstanceBuffer(const InstancedData* instanceData, UINT instanceCount, int lod = 0);
 		void ResetInstanceData(int count, bool clear = false, int lod = 0);
 		void AddInstanceData(const XMMATRIX& worldMatrix, int lod = -1);
-		void CreateIndirectInstanceData();
 		UINT InstanceSize() const;
+
+		static ER_InstanceBufferUploadStats GetInstanceBufferUploadStats() { return mLastFrameInstanceBufferUploadStats; }
+		static void EndFrameInstanceBufferUploadStats(); // main thread, once per frame
 		
 		void PerformCPUFrustumCull(ER_Camera* camera);
 
+		// Shadow casters of instanced objects: instances are culled for every cascade separately and (if the object is not indirectly rendered)
+		// DrawLOD() with "shadowCascade" draws them from that cascade's instance buffer
+		UINT CullShadowCasterInstances(int cascade, const XMFLOAT4* planes, UINT planesCount); // thread-safe for different objects, returns the casters count
+		void UploadShadowCasterInstances(int cascade); // main thread, after CullShadowCasterInstances()
+
+		// Passes that do not depend on the camera (i.e., voxelization) draw all instances of instanced objects (even indirectly rendered ones):
+		// DrawLOD() with RENDERING_OBJECT_ALL_INSTANCES and "skipCulling" draws them from a buffer of all original instances
+		void UploadAllInstances(); // main thread, before drawing with RENDERING_OBJECT_ALL_INSTANCES in this frame
+
 		void SetGPUIndirectlyRendered(bool value) { mIsIndirectlyRendered = value; }
 		bool IsGPUIndirectlyRendered() { return mIsIndirectlyRendered; }
+		// Instances of indirectly rendered objects are culled (and get their LODs) in ER_GPUCuller's batched pass, which owns the GPU buffers of all objects (see ER_GPUCullingTable)
+		bool IsIndirectInstanceDataReady() const { return mIsIndirectInstanceDataReady; }
+		void GetIndirectInstanceData(ER_GPUCullingInstance* aOutInstances, UINT aFirstInstance, UINT aInstancesCount) const; // original instances from "aFirstInstance"
+		bool TakeIndirectDirtyInstanceRanges(std::vector<std::pair<UINT, UINT>>& aOutRanges); // original instances changed since the last call (first instance, instances count; by ER_GPUCuller)
+		void SetIndirectBuffers(ER_RHI_GPUBuffer* aNewInstanceBuffer, UINT aNewInstanceOffset, ER_RHI_GPUBuffer* aArgsBuffer, UINT aArgsByteOffset); // by ER_GPUCuller
 		ER_RHI_GPUBuffer* GetIndirectNewInstanceBuffer() { return mIndirectNewInstanceDataBuffer; }
-		ER_RHI_GPUBuffer* GetIndirectOriginalInstanceBuffer() { return mIndirectOriginalInstanceDataBuffer; }
 		ER_RHI_GPUBuffer* GetIndirectArgsBuffer() { return mIndirectArgsBuffer; }
 
 		void Rename(const std::string& name) { mName = name; }
@@ -204,6 +259,19 @@ namespace EveryRay_Core
 		}
 		void UpdateLODs();
 		void LoadLOD(std::unique_ptr<ER_Model> pModel);
+
+		// LODs are selected by the projected size of the bounding sphere (fraction of the screen height, multiplied by the LOD biases):
+		// LOD "i" is used down to GetLODScreenSize(i), below the last LOD's threshold the object (or instance) is not rendered.
+		// Going back to the previous LOD requires crossing its threshold by ER_Utility::LODHysteresis, so that LODs do not flicker.
+		float GetLODScreenSize(int lod) const;
+		void SetLODScreenSizes(const std::vector<float>& sizes) { mLODScreenSizes = sizes; } // empty - global thresholds (ER_Utility::ScreenSizesLOD)
+		float GetLODBias() const { return mLODBias; }
+		void SetLODBias(float v) { mLODBias = v; }
+		int SelectLOD(float screenSize, int previousLOD) const; // -1 - not rendered
+		static float ComputeScreenSize(const ER_AABB& aabb, const XMFLOAT3& cameraPos, float projectionScale); // "projectionScale" is [1][1] of the projection matrix
+
+		static ER_LODStats GetLODStats() { return mLastFrameLODStats; }
+		static void EndFrameLODStats(); // main thread, once per frame
 		
 		float GetMinScale() { return mMinScale; }
 		void SetMinScale(float v) { mMinScale = v; }
@@ -213,6 +281,7 @@ namespace EveryRay_Core
 
 		bool IsSelected() { return mIsSelected; }
 		void SetSelected(bool val) { mIsSelected = val; }
+		void SetSelectedInstance(int index) { mEditorSelectedInstancedObjectIndex = index; }
 
 		bool IsInstanced() { return mIsInstanced; }
 		bool IsAvailableInEditor() { return mIsAvailableInEditorMode; }
@@ -223,6 +292,9 @@ namespace EveryRay_Core
 		// main camera view flag
 		bool IsCulled() { return mIsCulled; }
 		void SetCulled(bool val) { mIsCulled = val; }
+		// main camera culling by the scene BVH (see ER_Scene::CullObjects()): PerformCPUFrustumCull() then only consumes these results
+		void BeginSceneCulling();
+		void SetInstanceCulled(UINT index, bool val) { mInstanceCullingFlags[index] = val ? 1 : 0; }
 
 		float GetCustomAlphaDiscard() { return mCustomAlphaDiscard; }
 		void SetCustomAlphaDiscard(float val) { mCustomAlphaDiscard = val; }
@@ -342,7 +414,29 @@ namespace EveryRay_Core
 		void SetFurGravityStrength(float v) { mFurGravityStrength = v; }
 		XMFLOAT4 GetFurGravityStrength(); 
 	private:
-		void UpdateAABB(ER_AABB& aabb, const XMMATRIX& transformMatrix);
+		struct PendingInstanceBufferUpdate
+		{
+			const InstancedData* Data = nullptr; // points to mInstanceData or to the frame allocator (only valid in the frame it was prepared)
+			UINT Count = 0;
+			bool IsPending = false;
+		};
+
+		// Dynamic buffers have several versions (i.e., one per back buffer), so every block remembers which versions still miss its latest data
+		struct InstanceBufferUploadState
+		{
+			std::vector<InstancedData> Data; // last data passed to UpdateInstanceBuffer() (first "Count" instances are valid)
+			UINT Count = 0;
+			std::vector<UINT8> DirtyBlocks; // per RENDERING_OBJECT_INSTANCES_PER_DIRTY_BLOCK instances: bitmask of buffer versions to upload
+			UINT8 DirtyVersionsMask = 0; // union of all blocks' masks
+		};
+
+		void SetPendingInstanceBufferUpdate(int lod, const InstancedData* data, UINT count);
+		void MarkDirtyInstanceBlocks(InstanceBufferUploadState& state, const InstancedData* instanceData, UINT instanceCount);
+		void UploadDirtyInstanceRanges(int lod);
+		void UploadDirtyInstanceRanges(InstanceBufferUploadState& state, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> buffers);
+		void MarkIndirectInstancesDirty(UINT firstInstance, UINT instanceCount);
+		static void UpdateAABB(ER_AABB& aabb, const XMMATRIX& transformMatrix);
+		UINT GetIndirectArgsByteOffset(int lod, int meshIndex) const; // of the draw args in mIndirectArgsBuffer
 		void LoadTexture(ER_RHI_GPUTexture** aTexture, bool* loadStat, const std::wstring& path, int meshIndex, bool isPlaceholder = false);
 		void CreateInstanceBuffer(InstancedData* instanceData, UINT instanceCount, ER_RHI_GPUBuffer* instanceBuffer);
 		
@@ -379,9 +473,20 @@ namespace EveryRay_Core
 		UINT													mInstanceCount = 0;
 		std::vector<std::string>								mInstancesNames; // collection of names of instances (mName + index)
 		std::vector<ER_AABB>									mInstanceAABBs; // collection of AABBs for every instance (shared for LODs)
-		std::vector<bool>										mInstanceCullingFlags; // collection of culling flags for every instance (vector is lame here btw...)
-		std::vector<InstancedData>								mTempPostCullingInstanceData; // temp instance data after CPU culling
-		std::vector<std::vector<InstancedData>>					mTempPostLoddingInstanceData; // temp instance data after lodding (per LOD group)
+		ER_AABBsSoA												mInstanceBoundsSoA; // same AABBs in SoA layout (centers/extents) for SIMD culling
+		std::vector<UINT8>										mInstanceCullingFlags; // collection of culling flags for every instance (1 - culled)
+		std::vector<UINT>										mVisibleInstanceIndices; // compacted indices of visible instances after CPU culling
+		UINT													mVisibleInstanceCount = 0;
+		InstancedData*											mTempPostCullingInstanceData = nullptr; // temp instance data after CPU culling (in the frame allocator)
+		UINT													mTempPostCullingInstanceCount = 0;
+		std::vector<PendingInstanceBufferUpdate>				mPendingInstanceBufferUpdates; // instance data to upload in Update() (per LOD group), prepared in PrepareUpdate()
+		std::vector<InstanceBufferUploadState>					mInstanceBuffersUploadStates; // what was uploaded to the instance buffers (per LOD group)
+		InstancedData*											mTempShadowCascadesInstanceData[NUM_SHADOW_CASCADES] = {}; // instances that can cast shadows into a cascade (in the frame allocator)
+		UINT													mTempShadowCascadesInstanceCount[NUM_SHADOW_CASCADES] = {};
+		ER_RHI_GPUBuffer*										mShadowCascadesInstanceBuffers[NUM_SHADOW_CASCADES] = {}; // shared by all meshes
+		InstanceBufferUploadState								mShadowCascadesUploadStates[NUM_SHADOW_CASCADES];
+		ER_RHI_GPUBuffer*										mAllInstancesBuffer = nullptr; // shared by all meshes
+		InstanceBufferUploadState								mAllInstancesUploadState;
 		std::vector<UINT>										mInstanceCountToRender; //instance render count  (per LOD group)
 		std::vector<std::vector<InstancedData>>					mInstanceData; //original instance data  (per LOD group)
 		XMFLOAT4*												mTempInstancesPositions = nullptr;
@@ -390,9 +495,13 @@ namespace EveryRay_Core
 		// WARNING: Make sure to use this for objects with high instances counts to make this efficient
 		// WARNING: Has nothing to do with indirect lighting!
 		bool													mIsIndirectlyRendered = false; // parsed from the scene file
-		ER_RHI_GPUBuffer*										mIndirectOriginalInstanceDataBuffer = nullptr; //original instance transforms
-		ER_RHI_GPUBuffer*										mIndirectNewInstanceDataBuffer = nullptr; //new instance transforms of all LODs culled and processed in CS
-		ER_RHI_GPUBuffer*										mIndirectArgsBuffer = nullptr; // draw indexed instance indirect args for all meshes (instance count is calculated in CS)
+		bool													mIsIndirectInstanceDataReady = false; // instances were placed and have AABBs, so ER_GPUCuller can add them to its tables
+		std::vector<UINT8>										mIndirectDirtyInstanceBlocks; // per ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK original instances: changed since ER_GPUCuller took them
+		bool													mHasIndirectDirtyInstances = false; // any of mIndirectDirtyInstanceBlocks is set
+		ER_RHI_GPUBuffer*										mIndirectNewInstanceDataBuffer = nullptr; //new instance transforms of all LODs culled and processed in CS (owned by ER_GPUCuller)
+		UINT													mIndirectNewInstanceDataOffset = 0; // of the object's instances in that buffer
+		ER_RHI_GPUBuffer*										mIndirectArgsBuffer = nullptr; // draw indexed instance indirect args for all meshes (instance count is calculated in CS, owned by ER_GPUCuller)
+		UINT													mIndirectArgsByteOffset = 0; // of the object's args in that buffer
 		///****************************************************************************************************************************
 
 		///****************************************************************************************************************************
@@ -438,13 +547,15 @@ namespace EveryRay_Core
 
 		ER_AABB													mLocalAABB; //mesh space AABB
 		ER_AABB													mGlobalAABB; //world space AABB
-		XMFLOAT3												mCurrentGlobalAABBVertices[8];
 		ER_RenderableAABB*										mDebugGizmoAABB = nullptr;
 	
 		std::string												mName;
 		const char*												mInstancedNamesUI[MAX_INSTANCE_COUNT];
 		int														mIndexInScene = -1;
 		int														mCurrentLODIndex = 0; //only used for non-instanced object
+		std::vector<INT8>										mInstancesLODs; // LOD of every instance in the last frame (-1 - not rendered), for hysteresis
+		std::vector<float>										mLODScreenSizes; // per-object LOD thresholds (global ones if empty)
+		float													mLODBias = 1.0f; // "lod_bias" in json
 		int														mEditorSelectedInstancedObjectIndex = 0;
 		bool													mIsAABBDebugEnabled = true;
 		bool													mIsWireframeMode = false;
@@ -455,6 +566,9 @@ namespace EveryRay_Core
 		bool													mIsForwardShading = false;
 		bool													mIsPOM = false;
 		bool													mIsCulled = false; //only for non-instanced objects
+		bool													mIsCulledByScene = false; // main camera culling results were written by ER_Scene::CullObjects() this frame
+		bool													mAreBoundsUpdated = false; // UpdateBounds() was called this frame
+		bool													mIsUpdatePrepared = false; // PrepareUpdate() was called this frame
 		bool													mIsMarkedAsFoliage = false;
 		bool													mIsInLightProbe = false;
 		bool													mIsSeparableSubsurfaceScattering = false;
@@ -486,5 +600,19 @@ namespace EveryRay_Core
 
 		RenderingObjectTextureQuality							mCurrentTextureQuality = RenderingObjectTextureQuality::OBJECT_TEXTURE_LOW;
 		UINT													mObjectShaderBitmaskFlags = 0; // "RenderingObjectFlags" in shaders
+
+		// instance buffers can be updated from loading threads, so the counters of the current frame are atomic
+		static std::atomic<UINT64>								mFrameUploadedInstanceBytes;
+		static std::atomic<UINT64>								mFrameSkippedInstanceBytes;
+		static std::atomic<UINT64>								mFrameInstanceUploadsCount;
+		static std::atomic<UINT64>								mFrameSkippedInstanceUploadsCount;
+		static ER_InstanceBufferUploadStats						mLastFrameInstanceBufferUploadStats;
+
+		// LODs are selected in parallel (PrepareUpdate() of different objects)
+		static std::atomic<UINT64>								mFrameLODInstancesCounts[RENDERING_OBJECT_LOD_STATS_MAX_LODS];
+		static std::atomic<UINT64>								mFrameLODTooSmallCount;
+		static std::atomic<UINT64>								mFrameLODSwitchesCount;
+		static std::atomic<UINT64>								mFrameGPULODObjectsCount;
+		static ER_LODStats										mLastFrameLODStats;
 	};
 }
\ No newline at end of file
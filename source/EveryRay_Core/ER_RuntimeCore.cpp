@@ -13,6 +13,11 @@
 #include "ER_Sandbox.h"
 #include "ER_Editor.h"
 #include "ER_QuadRenderer.h"
+#include "ER_RenderingObject.h"
+#include "ER_Scene.h"
+#include "ER_GBuffer.h"
+#include "ER_GPUCuller.h"
+#include "ER_LightProbesManager.h"
 
 #include "..\JsonCpp\include\json\json.h"
 
@@ -249,6 +254,12 @@ namespace EveryRay_Core
 		if (mIsRHIReset)
 			mIsRHIReset = false;
 
+		mCPUProfiler->BeginFrame();
+		mFrameAllocator->BeginFrame(); // no jobs are running here
+		ER_RenderingObject::EndFrameInstanceBufferUploadStats();
+		ER_RenderingObject::EndFrameLODStats();
+		ER_CPU_PROFILE_SCOPE(mCPUProfiler, "Update");
+
 		auto startUpdateTimer = std::chrono::high_resolution_clock::now();
 
 		if (mKeyboard->WasKeyPressedThisFrame(DIK_ESCAPE))
@@ -257,7 +268,10 @@ namespace EveryRay_Core
 		int updateCommandList = mRHI->GetPrepareGraphicsCommandListIndex() - 1;
 		mRHI->BeginGraphicsCommandList(updateCommandList);
 
-		UpdateImGui();
+		{
+			ER_CPU_PROFILE_SCOPE(mCPUProfiler, "ImGui update");
+			UpdateImGui();
+		}
 
 		ER_Core::Update(gameTime); //engine components (input, camera, etc.);
 		mCurrentSandbox->Update(*this, gameTime); //level components (rendering systems, culling, etc.)
@@ -335,10 +349,100 @@ namespace EveryRay_Core
 				{
 					ImGui::TextColored(ImVec4(0.8f, 0.0f, 0.0f, 1), "Render: %f ms", mElapsedTimeRenderCPU.count() * 1000);
 					ImGui::TextColored(ImVec4(0.8f, 0.0f, 0.0f, 1), "Update: %f ms", mElapsedTimeUpdateCPU.count() * 1000);
+					ImGui::Separator();
+					mCPUProfiler->ShowImGui();
 				}
 				if (ImGui::CollapsingHeader("GPU Time"))
 				{
 				}
+				if (mRHI && ImGui::CollapsingHeader("Shader Cache"))
+				{
+					ER_ShaderCacheStats stats = mRHI->GetShaderCache().GetStats();
+					ImGui::Text("Memory hits: %llu", stats.MemoryHits);
+					ImGui::Text("Disk hits: %llu", stats.DiskHits);
+					ImGui::Text("Misses (compiled): %llu", stats.Misses);
+					ImGui::Text("Failed saves: %llu", stats.FailedSaves);
+					ImGui::Text("Compile time: %.1f ms", stats.CompileTimeMs);
+					if (ImGui::Button("Reset Shader Cache Stats"))
+						mRHI->GetShaderCache().ResetStats();
+				}
+				if (mRHI && mRHI->GetAPI() == ER_GRAPHICS_API::DX12 && ImGui::CollapsingHeader("Descriptor Tables"))
+				{
+					ER_RHI_DescriptorTablesStats stats = mRHI->GetDescriptorTablesStats();
+					const float hitRate = stats.TablesRequested > 0 ? 100.0f * static_cast<float>(stats.TablesReused) / static_cast<float>(stats.TablesRequested) : 0.0f;
+					ImGui::Text("Tables (last frame): %llu, reused: %llu (%.1f%%)", stats.TablesRequested, stats.TablesReused, hitRate);
+					ImGui::Text("Descriptors copied: %llu / %u in the GPU heap", stats.DescriptorsCopied, stats.DescriptorsCapacity);
+				}
+				if (GetLevel() && GetLevel()->mGBuffer && ImGui::CollapsingHeader("GBuffer Render Queue"))
+				{
+					const ER_RenderQueueStats& stats = GetLevel()->mGBuffer->GetRenderQueueStats();
+					ImGui::Text("Draws (last frame): %u", stats.DrawsCount);
+					ImGui::Text("State changes: PSO %u, constant buffers %u, textures %u, vertex buffers %u", stats.PSOChangesCount, stats.ConstantBufferChangesCount,
+						stats.TextureChangesCount, stats.VertexBufferChangesCount);
+					const UINT changesCount = stats.PSOChangesCount + stats.ConstantBufferChangesCount + stats.TextureChangesCount + stats.VertexBufferChangesCount;
+					ImGui::Text("Redundant changes skipped: %u", 4 * stats.DrawsCount - changesCount);
+				}
+				if (GetLevel() && GetLevel()->mGPUCuller && ImGui::CollapsingHeader("GPU Culling"))
+				{
+					const ER_GPUCullingTable& table = GetLevel()->mGPUCuller->GetTable();
+					ImGui::Text("Indirectly rendered objects: %u, instances: %u", table.GetObjectsCount(), table.GetInstancesCount());
+					ImGui::Text("Dispatches (last frame): %u", GetLevel()->mGPUCuller->GetDispatchesCount());
+				}
+				if (GetLevel() && GetLevel()->mLightProbesManager && ImGui::CollapsingHeader("Light Probes Residency"))
+				{
+					ER_LightProbesManager* probesManager = GetLevel()->mLightProbesManager;
+					const ER_LightProbesResidencyStats& stats = probesManager->GetSpecularProbesResidencyStats();
+					ImGui::Text("Specular probes copied (last frame): %u, evicted: %u, pending: %u", stats.CopiesCount, stats.EvictionsCount, stats.PendingCount);
+					ImGui::Text("Resident: %u / %u slots", stats.ResidentCount, stats.SlotsCount);
+					int copyBudget = static_cast<int>(probesManager->GetSpecularProbesCopyBudget());
+					if (ImGui::SliderInt("Copies per frame (0 - no limit)", &copyBudget, 0, 64))
+						probesManager->SetSpecularProbesCopyBudget(static_cast<UINT>(copyBudget));
+				}
+				if (ImGui::CollapsingHeader("Instance Buffers"))
+				{
+					ER_InstanceBufferUploadStats stats = ER_RenderingObject::GetInstanceBufferUploadStats();
+					ImGui::Text("Uploaded (last frame): %.1f KB in %llu LOD groups", stats.UploadedBytes / 1024.0f, stats.UploadsCount);
+					ImGui::Text("Skipped (unchanged): %.1f KB, %llu LOD groups up to date", stats.SkippedBytes / 1024.0f, stats.SkippedUploadsCount);
+					ImGui::Checkbox("Upload only changed ranges", &ER_Utility::IsInstanceBufferDirtyTracking);
+				}
+				if (ImGui::CollapsingHeader("LODs"))
+				{
+					ER_LODStats stats = ER_RenderingObject::GetLODStats();
+					UINT64 renderedCount = 0;
+					for (UINT lod = 0; lod < RENDERING_OBJECT_LOD_STATS_MAX_LODS; lod++)
+						renderedCount += stats.InstancesPerLOD[lod];
+					const float totalCount = static_cast<float>(std::max(renderedCount + stats.TooSmallCount, 1ull));
+					for (UINT lod = 0; lod < RENDERING_OBJECT_LOD_STATS_MAX_LODS; lod++)
+					{
+						if (stats.InstancesPerLOD[lod])
+							ImGui::Text("LOD #%u: %llu (%.1f%%)", lod, stats.InstancesPerLOD[lod], 100.0f * stats.InstancesPerLOD[lod] / totalCount);
+					}
+					ImGui::Text("Too small (not rendered): %llu (%.1f%%)", stats.TooSmallCount, 100.0f * stats.TooSmallCount / totalCount);
+					ImGui::Text("LOD switches (last frame): %llu", stats.SwitchesCount);
+					ImGui::Text("Objects with LODs selected on GPU: %llu", stats.GPUSelectedObjectsCount);
+				}
+				if (GetLevel() && GetLevel()->mScene && ImGui::CollapsingHeader("Scene BVH"))
+				{
+					const ER_BVH& bvh = GetLevel()->mScene->GetBVH();
+					const ER_SceneBVHStats& stats = GetLevel()->mScene->GetBVHStats();
+					ImGui::Text("Items (objects & instances): %u, nodes: %u, depth: %u", bvh.GetItemsCount(), bvh.GetNodesCount(), bvh.GetDepth());
+					ImGui::Text("SAH cost: %.2f (after the last build: %.2f)", bvh.GetCost(), bvh.GetBuildCost());
+					ImGui::Text("Refits: %u, rebuilds: %u", stats.RefitsCount, stats.RebuildsCount);
+				}
+				if (ImGui::CollapsingHeader("Memory"))
+				{
+					ER_AllocatorStats frameStats = mFrameAllocator->GetStats();
+					ImGui::Text("Frame allocator: %llu allocations, %.1f/%.1f KB (peak %.1f KB)", frameStats.AllocationsCount,
+						frameStats.UsedBytes / 1024.0f, frameStats.CapacityBytes / 1024.0f, frameStats.PeakBytes / 1024.0f);
+					ImGui::Text("Frame allocator heap allocations: %llu", frameStats.HeapAllocationsCount);
+					ER_AllocatorStats jobsStats = mJobSystem->GetParallelForPoolStats();
+					ImGui::Text("Jobs pool: %llu alive, %.1f KB (heap allocations: %llu)", jobsStats.AllocationsCount, jobsStats.CapacityBytes / 1024.0f, jobsStats.HeapAllocationsCount);
+				}
+				if (ImGui::CollapsingHeader("Shader Programs"))
+				{
+					ImGui::Text("Programs: %u (requested by materials: %u)", mShaderProgramRegistry->GetProgramsCount(), mShaderProgramRegistry->GetReferencesCount());
+					ImGui::Text("Total compiled: %llu (total requests: %llu)", mShaderProgramRegistry->GetTotalCreatedCount(), mShaderProgramRegistry->GetTotalRequestsCount());
+				}
 				ImGui::End();
 			}
 			ImGui::Separator();
@@ -388,6 +492,8 @@ namespace EveryRay_Core
 		assert(mCurrentSandbox);
 		assert(mRHI);
 
+		ER_CPU_PROFILE_SCOPE(mCPUProfiler, "Draw");
+
 		auto startRenderTimer = std::chrono::high_resolution_clock::now();
 
 		mRHI->BeginGraphicsCommandList();
@@ -242,8 +242,7 @@ namespace EveryRay_Core {
 
 		if (mTerrain)
 		{
-			for (auto listener : mTerrain->ReadbackPlacedPositionsOnInitEvent->GetListeners())
-				listener(mTerrain);
+			mTerrain->ReadbackPlacedPositionsOnInitEvent->Invoke(mTerrain);
 			mTerrain->ReadbackPlacedPositionsOnInitEvent->RemoveAllListeners();
 		}
     }
@@ -252,6 +251,25 @@ namespace EveryRay_Core {
 	{
 		//TODO refactor to updates for elements of ER_CoreComponent type
 
+		ER_CPUProfiler* profiler = game.CPUProfiler();
+		ER_CPU_PROFILE_SCOPE(profiler, "Sandbox update");
+
+		// objects' bounds and the scene BVH are updated first, so that all systems below (voxel GI, probes, main camera culling) query the current frame's data
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Objects bounds update");
+			game.JobSystem()->ParallelFor(static_cast<UINT>(mScene->objects.size()), 1, [this](UINT start, UINT end)
+			{
+				for (UINT i = start; i < end; i++)
+					mScene->objects[i].second->UpdateBounds();
+			});
+		}
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Scene BVH update");
+			mScene->UpdateBVH();
+			if (ER_Utility::IsMainCameraCPUFrustumCulling)
+				mScene->CullObjects(((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->GetFrustum());
+		}
+
 		//TODO refactor skybox updates
 		mSkybox->SetUseCustomSkyColor(mEditor->IsSkyboxUsingCustomColor());
 		mSkybox->SetSkyColors(mEditor->GetBottomSkyColor(), mEditor->GetTopSkyColor());
@@ -262,22 +280,53 @@ namespace EveryRay_Core {
 		mSkybox->Update();
 		mSkybox->UpdateSun(gameTime);
 		mPostProcessingStack->Update();
-		mVolumetricClouds->Update(gameTime);
-		mVolumetricFog->Update(gameTime);
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Volumetric clouds & fog update");
+			mVolumetricClouds->Update(gameTime);
+			mVolumetricFog->Update(gameTime);
+		}
 		if (mTerrain && mScene->HasTerrain())
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Terrain update");
 			mTerrain->Update(gameTime);
-		mIllumination->Update(gameTime, mScene);
+		}
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Illumination update");
+			mIllumination->Update(gameTime, mScene);
+		}
 		if (mScene->HasLightProbesSupport() && mLightProbesManager->IsEnabled())
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Light probes update");
 			mLightProbesManager->UpdateProbes(game);
-		mShadowMapper->Update(gameTime);
+		}
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Shadow mapper update");
+			mShadowMapper->Update(gameTime);
+		}
 		if (mFoliageSystem && mScene->HasFoliage())
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Foliage update");
 			mFoliageSystem->Update(gameTime, mWindGustDistance, mWindStrength, mWindFrequency);
+		}
 		mDirectionalLight->UpdateProxyModel(gameTime, 
 			((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->ViewMatrix4X4(),
 			((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->ProjectionMatrix4X4()); //TODO refactor to DebugRenderer
 
-		for (auto& object : mScene->objects)
-			object.second->Update(gameTime);
+		// thread-safe parts of objects' updates (culling results, LODs) are executed in parallel, the rest (GPU uploads, editor) - on the main thread
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Objects prepare update");
+			game.JobSystem()->ParallelFor(static_cast<UINT>(mScene->objects.size()), 1, [this, &gameTime, profiler](UINT start, UINT end)
+			{
+				ER_CPU_PROFILE_SCOPE(profiler, "Objects prepare update (job)");
+				for (UINT i = start; i < end; i++)
+					mScene->objects[i].second->PrepareUpdate(gameTime);
+			});
+		}
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Objects update");
+			for (auto& object : mScene->objects)
+				object.second->Update(gameTime);
+		}
 
         UpdateImGui();
 	}
@@ -304,6 +353,9 @@ namespace EveryRay_Core {
 		if (ImGui::Button("Terrain"))
 			mTerrain->Config();
 
+		if (ImGui::Button("Shadows"))
+			mShadowMapper->Config();
+
 		if (ImGui::CollapsingHeader("Wind"))
 		{
 			ImGui::SliderFloat("Wind strength", &mWindStrength, 0.0f, 100.0f);
@@ -311,7 +363,6 @@ namespace EveryRay_Core {
 			ImGui::SliderFloat("Wind frequency", &mWindFrequency, 0.0f, 100.0f);
 		}
 
-		//TODO shadow mapper config
 		//TODO skybox config
 
         ImGui::End();
@@ -321,16 +372,21 @@ namespace EveryRay_Core {
 	{
 		ER_RHI* rhi = game.GetRHI();
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		ER_CPUProfiler* profiler = game.CPUProfiler();
 		
 		#pragma region GPU_CULLING
 		rhi->BeginEventTag("EveryRay: GPU Culling");
-		mGPUCuller->PerformCull(mScene);
+		{
+			ER_CPU_PROFILE_SCOPE(profiler, "GPU culling dispatch");
+			mGPUCuller->PerformCull(mScene);
+		}
 		rhi->EndEventTag();
 #pragma endregion
 
 		#pragma region DRAW_GBUFFER
 		rhi->BeginEventTag("EveryRay: GBuffer");
 		{
+			ER_CPU_PROFILE_SCOPE(profiler, "GBuffer draw");
 			mGBuffer->Start();
 
 			rhi->BeginEventTag("EveryRay: GBuffer (objects)");
@@ -361,6 +417,7 @@ namespace EveryRay_Core {
 		#pragma region DRAW_SHADOWS
 		rhi->BeginEventTag("EveryRay: Shadow Maps");
 		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Shadow maps draw");
 			mShadowMapper->Draw(mScene, mTerrain);
 		}
 		rhi->EndEventTag();
@@ -387,6 +444,7 @@ namespace EveryRay_Core {
 		// compute dynamic GI
 		rhi->BeginEventTag("EveryRay: Dynamic Global Illumination");
 		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Dynamic GI draw");
 			mIllumination->DrawDynamicGlobalIllumination(mGBuffer, gameTime);
 		}
 		rhi->EndEventTag();
@@ -395,6 +453,7 @@ namespace EveryRay_Core {
 		#pragma region DRAW_LOCAL_ILLUMINATION
 		rhi->BeginEventTag("EveryRay: Local Illumination");
 		{
+			ER_CPU_PROFILE_SCOPE(profiler, "Local illumination draw");
 			mIllumination->DrawLocalIllumination(mGBuffer, mSkybox);
 			ER_RHI_GPUTexture* localRT = mIllumination->GetLocalIlluminationRT();
 
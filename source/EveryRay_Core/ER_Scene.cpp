@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "ER_Scene.h"
+#include "ER_CompiledScene.h"
 #include "ER_Core.h"
 #include "ER_CoreException.h"
 #include "ER_Utility.h"
@@ -36,167 +37,121 @@ namespace EveryRay_Core
 
 		CreateStandardMaterialsRootSignatures();
 
-		Json::Reader reader;
-		std::ifstream scene(path.c_str(), std::ifstream::binary);
+		// parses (and compiles) the json only if its binary version is missing or stale
+		mCompiledScene = new ER_CompiledScene();
+		mCompiledScene->Load(path);
 
-		if (!reader.parse(scene, mSceneJsonRoot)) {
-			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
-		}
-		else {
+		const ER_CompiledSceneSettings& settings = mCompiledScene->GetSettings();
 
-			if (mSceneJsonRoot.isMember("camera_position")) {
-				float vec3[3];
-				for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["camera_position"].size(); i++)
-					vec3[i] = mSceneJsonRoot["camera_position"][i].asFloat();
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_CAMERA_POSITION))
+			mCameraPosition = settings.CameraPosition;
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_CAMERA_DIRECTION))
+			mCameraDirection = settings.CameraDirection;
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_SUN_DIRECTION))
+			mSunDirection = settings.SunDirection;
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_SUN_COLOR))
+			mSunColor = settings.SunColor;
 
-				mCameraPosition = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-			}
-
-			if (mSceneJsonRoot.isMember("camera_direction")) {
-				float vec3[3];
-				for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["camera_direction"].size(); i++)
-					vec3[i] = mSceneJsonRoot["camera_direction"][i].asFloat();
-
-				mCameraDirection = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-			}
-
-			if (mSceneJsonRoot.isMember("sun_direction")) {
-				float vec3[3] = { 0.0, 0.0, 0.0 };
-				for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["sun_direction"].size(); i++)
-					vec3[i] = mSceneJsonRoot["sun_direction"][i].asFloat();
-
-				mSunDirection = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-			}
-
-			if (mSceneJsonRoot.isMember("sun_color")) {
-				float vec3[3];
-				for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["sun_color"].size(); i++)
-					vec3[i] = mSceneJsonRoot["sun_color"][i].asFloat();
-
-				mSunColor = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
+		// terrain config
+		{
+			if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_TERRAIN)) {
+				mHasTerrain = true;
+				mTerrainTilesCount = settings.TerrainTilesCount;
+				if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_TERRAIN_TILE_SCALE))
+					mTerrainTileScale = settings.TerrainTileScale;
+				if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_TERRAIN_TILE_RESOLUTION))
+					mTerrainTileResolution = settings.TerrainTileResolution;
+
+				for (int i = 0; i < 4; i++)
+					mTerrainSplatLayersTextureNames[i] = ER_Utility::ToWideString(mCompiledScene->GetString(settings.TerrainSplatLayers[i]));
 			}
-
-			// terrain config
-			{
-				if (mSceneJsonRoot.isMember("terrain_num_tiles")) {
-					mHasTerrain = true;
-					mTerrainTilesCount = mSceneJsonRoot["terrain_num_tiles"].asInt();
-					if (mSceneJsonRoot.isMember("terrain_tile_scale"))
-						mTerrainTileScale = mSceneJsonRoot["terrain_tile_scale"].asFloat();
-					if (mSceneJsonRoot.isMember("terrain_tile_resolution"))
-						mTerrainTileResolution = mSceneJsonRoot["terrain_tile_resolution"].asInt();
-					std::string fieldName = "terrain_texture_splat_layer";
-					std::wstring result = L"";
-
-					for (int i = 0; i < 4; i++)
-					{
-						fieldName += std::to_string(i);
-						if (mSceneJsonRoot.isMember(fieldName.c_str()))
-							result = ER_Utility::ToWideString(mSceneJsonRoot[fieldName.c_str()].asString());
-						else
-							result = L"";
-					
-						fieldName = "terrain_texture_splat_layer";
-						mTerrainSplatLayersTextureNames[i] = result;
-					}
-				}
-				else
+			else
 				mHasTerrain = false;
-			}
-
-			// light probes config
-			{
-				if (mSceneJsonRoot.isMember("light_probes_volume_bounds_min")) {
-					float vec3[3];
-					for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["light_probes_volume_bounds_min"].size(); i++)
-						vec3[i] = mSceneJsonRoot["light_probes_volume_bounds_min"][i].asFloat();
-
-					mLightProbesVolumeMinBounds = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-				}
-				else
-					mHasLightProbes = false;
-
-				if (mSceneJsonRoot.isMember("light_probes_volume_bounds_max")) {
-					float vec3[3];
-					for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["light_probes_volume_bounds_max"].size(); i++)
-						vec3[i] = mSceneJsonRoot["light_probes_volume_bounds_max"][i].asFloat();
-
-					mLightProbesVolumeMaxBounds = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-				}
-				else
-					mHasLightProbes = false;
-
-				if (mSceneJsonRoot.isMember("light_probes_diffuse_distance"))
-					mLightProbesDiffuseDistance = mSceneJsonRoot["light_probes_diffuse_distance"].asFloat();
-				if (mSceneJsonRoot.isMember("light_probes_specular_distance"))
-					mLightProbesSpecularDistance = mSceneJsonRoot["light_probes_specular_distance"].asFloat();
+		}
 
-				if (mSceneJsonRoot.isMember("light_probe_global_cam_position")) {
-					float vec3[3];
-					for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["light_probe_global_cam_position"].size(); i++)
-						vec3[i] = mSceneJsonRoot["light_probe_global_cam_position"][i].asFloat();
+		// light probes config
+		{
+			if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_MIN_BOUNDS))
+				mLightProbesVolumeMinBounds = settings.LightProbesVolumeMinBounds;
+			else
+				mHasLightProbes = false;
 
-					mGlobalLightProbeCameraPos = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-				}
-			}
+			if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_MAX_BOUNDS))
+				mLightProbesVolumeMaxBounds = settings.LightProbesVolumeMaxBounds;
+			else
+				mHasLightProbes = false;
+
+			if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_DIFFUSE_DISTANCE))
+				mLightProbesDiffuseDistance = settings.LightProbesDiffuseDistance;
+			if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_LIGHT_PROBES_SPECULAR_DISTANCE))
+				mLightProbesSpecularDistance = settings.LightProbesSpecularDistance;
+			if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_GLOBAL_LIGHT_PROBE_CAMERA_POSITION))
+				mGlobalLightProbeCameraPos = settings.GlobalLightProbeCameraPos;
+		}
 
-			if (mSceneJsonRoot.isMember("foliage_zones"))
-				mHasFoliage = true;
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_FOLIAGE))
+			mHasFoliage = true;
 
-			if (mSceneJsonRoot.isMember("use_volumetric_fog")) {
-				mHasVolumetricFog = mSceneJsonRoot["use_volumetric_fog"].asBool();
-			}
-			else
-				mHasVolumetricFog = false;
-
-			// add rendering objects to scene
-			unsigned int numRenderingObjects = mSceneJsonRoot["rendering_objects"].size();
-			for (Json::Value::ArrayIndex i = 0; i != numRenderingObjects; i++) {
-				objects.emplace_back(
-					mSceneJsonRoot["rendering_objects"][i]["name"].asString(), 
-					new ER_RenderingObject(mSceneJsonRoot["rendering_objects"][i]["name"].asString(), i, *mCore, mCamera, 
-						std::unique_ptr<ER_Model>(new ER_Model(*mCore, ER_Utility::GetFilePath(mSceneJsonRoot["rendering_objects"][i]["model_path"].asString()), true)),
-						true, mSceneJsonRoot["rendering_objects"][i]["instanced"].asBool())
-				);
-			}
-			std::partition(objects.begin(), objects.end(), [](const ER_SceneObject& obj) {	return obj.second->IsInstanced(); });
-			assert(numRenderingObjects == objects.size());
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_VOLUMETRIC_FOG))
+			mHasVolumetricFog = settings.UseVolumetricFog != 0;
+		else
+			mHasVolumetricFog = false;
+
+		// add rendering objects to scene
+		unsigned int numRenderingObjects = mCompiledScene->GetObjectsCount();
+		for (unsigned int i = 0; i < numRenderingObjects; i++) {
+			const ER_CompiledSceneObject& compiledObject = mCompiledScene->GetSceneObject(i);
+			const std::string name = mCompiledScene->GetString(compiledObject.Name);
+			objects.emplace_back(
+				name,
+				new ER_RenderingObject(name, i, *mCore, mCamera,
+					std::unique_ptr<ER_Model>(new ER_Model(*mCore, ER_Utility::GetFilePath(std::string(mCompiledScene->GetString(compiledObject.ModelPath))), true)),
+					true, compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_INSTANCED))
+			);
+		}
+		std::partition(objects.begin(), objects.end(), [](const ER_SceneObject& obj) {	return obj.second->IsInstanced(); });
+		assert(numRenderingObjects == objects.size());
 
 #if MULTITHREADED_SCENE_LOAD && !ER_PLATFORM_WIN64_DX12
-			int numThreads = std::thread::hardware_concurrency();
+		int numThreads = std::thread::hardware_concurrency();
 #else
-			int numThreads = 1;
+		int numThreads = 1;
 #endif
-			int objectsPerThread = numRenderingObjects / numThreads;
-			if (objectsPerThread == 0)
-			{
-				numThreads = 1;
-				objectsPerThread = numRenderingObjects;
-			}
+		int objectsPerThread = numRenderingObjects / numThreads;
+		if (objectsPerThread == 0)
+		{
+			numThreads = 1;
+			objectsPerThread = numRenderingObjects;
+		}
 
-			std::vector<std::thread> threads;
-			threads.reserve(numThreads);
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
 
-			for (int i = 0; i < numThreads; i++)
+		for (int i = 0; i < numThreads; i++)
+		{
+			threads.push_back(std::thread([&, numThreads, numRenderingObjects, objectsPerThread, i]
 			{
-				threads.push_back(std::thread([&, numThreads, numRenderingObjects, objectsPerThread, i]
+				int endRange = (i < numThreads - 1) ? (i + 1) * objectsPerThread : numRenderingObjects;
+
+				for (int j = i * objectsPerThread; j < endRange; j++)
 				{
-					int endRange = (i < numThreads - 1) ? (i + 1) * objectsPerThread : numRenderingObjects;
+					auto objectI = objects.begin();
+					std::advance(objectI, j);
+					LoadRenderingObjectData(objectI->second);
+				}
+			}));
+		}
+		for (auto& t : threads) t.join();
 
-					for (int j = i * objectsPerThread; j < endRange; j++)
-					{
-						auto objectI = objects.begin();
-						std::advance(objectI, j);
-						LoadRenderingObjectData(objectI->second);
-					}
-				}));
-			}
-			for (auto& t : threads) t.join();
+		for (auto& obj : objects)
+			LoadRenderingObjectInstancedData(obj.second);
 
-			for (auto& obj : objects)
-				LoadRenderingObjectInstancedData(obj.second);
+		{
+			ER_ShaderProgramRegistry* registry = mCore->ShaderProgramRegistry();
+			std::wstring msg = L"[ER Logger][ER_Scene] Shader programs: " + std::to_wstring(registry->GetProgramsCount()) +
+				L" for " + std::to_wstring(registry->GetReferencesCount()) + L" material shaders \n";
+			ER_OUTPUT_LOG(msg.c_str());
 		}
-
 		{
 			std::wstring msg = L"[ER Logger][ER_Scene] Finished loading scene: " + ER_Utility::ToWideString(path) + L" Enjoy! \n";
 			ER_OUTPUT_LOG(msg.c_str());
@@ -217,6 +172,8 @@ namespace EveryRay_Core
 			DeleteObject(rs.second);
 		}
 		mStandardMaterialsRootSignatures.clear();
+
+		DeleteObject(mCompiledScene);
 	}
 
 	void ER_Scene::CreateStandardMaterialsRootSignatures()
@@ -279,265 +236,248 @@ namespace EveryRay_Core
 
 		int i = aObject->GetIndexInScene();
 		bool isInstanced = aObject->IsInstanced();
-		bool hasLODs = false;
+		const ER_CompiledSceneObject& compiledObject = mCompiledScene->GetSceneObject(i);
 
 		// load flags
 		{
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("foliageMask"))
-				aObject->SetIsMarkedAsFoliage(mSceneJsonRoot["rendering_objects"][i]["foliageMask"].asBool());
-			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_indirect_global_lightprobe"))
-				aObject->SetUseIndirectGlobalLightProbe(mSceneJsonRoot["rendering_objects"][i]["use_indirect_global_lightprobe"].asBool());
-			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_in_global_lightprobe_rendering"))
-				aObject->SetIsUsedForGlobalLightProbeRendering(mSceneJsonRoot["rendering_objects"][i]["use_in_global_lightprobe_rendering"].asBool());
-			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_parallax_occlusion_mapping"))
-				aObject->SetParallaxOcclusionMapping(mSceneJsonRoot["rendering_objects"][i]["use_parallax_occlusion_mapping"].asBool());
-			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_forward_shading"))
-				aObject->SetForwardShading(mSceneJsonRoot["rendering_objects"][i]["use_forward_shading"].asBool());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_FOLIAGE_MASK))
+				aObject->SetIsMarkedAsFoliage(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_FOLIAGE_MASK));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_reflection"))
-				aObject->SetReflective(mSceneJsonRoot["rendering_objects"][i]["use_reflection"].asBool());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_INDIRECT_GLOBAL_LIGHTPROBE))
+				aObject->SetUseIndirectGlobalLightProbe(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_INDIRECT_GLOBAL_LIGHTPROBE));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_sss"))
-				aObject->SetSeparableSubsurfaceScattering(mSceneJsonRoot["rendering_objects"][i]["use_sss"].asBool());
-			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_custom_alpha_discard"))
-				aObject->SetCustomAlphaDiscard(mSceneJsonRoot["rendering_objects"][i]["use_custom_alpha_discard"].asFloat());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_IN_GLOBAL_LIGHTPROBE_RENDERING))
+				aObject->SetIsUsedForGlobalLightProbeRendering(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_IN_GLOBAL_LIGHTPROBE_RENDERING));
+
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_PARALLAX_OCCLUSION_MAPPING))
+				aObject->SetParallaxOcclusionMapping(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_PARALLAX_OCCLUSION_MAPPING));
+
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_FORWARD_SHADING))
+				aObject->SetForwardShading(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_FORWARD_SHADING));
+
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_REFLECTION))
+				aObject->SetReflective(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_REFLECTION));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_transparency"))
-				aObject->SetTransparency(mSceneJsonRoot["rendering_objects"][i]["use_transparency"].asBool());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_SSS))
+				aObject->SetSeparableSubsurfaceScattering(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_SSS));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_gpu_indirect_rendering"))
-				aObject->SetGPUIndirectlyRendered(mSceneJsonRoot["rendering_objects"][i]["use_gpu_indirect_rendering"].asBool());
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ALPHA_DISCARD))
+				aObject->SetCustomAlphaDiscard(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ALPHA_DISCARD]);
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("skip_indirect_specular"))
-				aObject->SetSkipIndirectSpecular(mSceneJsonRoot["rendering_objects"][i]["skip_indirect_specular"].asBool());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_TRANSPARENCY))
+				aObject->SetTransparency(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_TRANSPARENCY));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("index_of_refraction"))
-				aObject->SetIOR(mSceneJsonRoot["rendering_objects"][i]["index_of_refraction"].asFloat());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_GPU_INDIRECT_RENDERING))
+				aObject->SetGPUIndirectlyRendered(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_USE_GPU_INDIRECT_RENDERING));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("custom_roughness"))
-				aObject->SetCustomRoughness(mSceneJsonRoot["rendering_objects"][i]["custom_roughness"].asFloat());
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_SKIP_INDIRECT_SPECULAR))
+				aObject->SetSkipIndirectSpecular(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_SKIP_INDIRECT_SPECULAR));
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("custom_metalness"))
-				aObject->SetCustomMetalness(mSceneJsonRoot["rendering_objects"][i]["custom_metalness"].asFloat());
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_INDEX_OF_REFRACTION))
+				aObject->SetIOR(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_INDEX_OF_REFRACTION]);
+
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ROUGHNESS))
+				aObject->SetCustomRoughness(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_ROUGHNESS]);
+
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_METALNESS))
+				aObject->SetCustomMetalness(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_CUSTOM_METALNESS]);
 
 			//fur
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_layers_count"))
-				aObject->SetFurLayersCount(mSceneJsonRoot["rendering_objects"][i]["fur_layers_count"].asInt());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_color"))
+			if (compiledObject.HasInt(ER_COMPILED_SCENE_OBJECT_INT_FUR_LAYERS_COUNT))
+				aObject->SetFurLayersCount(compiledObject.Ints[ER_COMPILED_SCENE_OBJECT_INT_FUR_LAYERS_COUNT]);
+			if (compiledObject.HasVec3(ER_COMPILED_SCENE_OBJECT_VEC3_FUR_COLOR))
 			{
-				float vec3[3];
-				for (Json::Value::ArrayIndex vecI = 0; vecI != mSceneJsonRoot["rendering_objects"][i]["fur_color"].size(); vecI++)
-					vec3[vecI] = mSceneJsonRoot["rendering_objects"][i]["fur_color"][vecI].asFloat();
-
-				aObject->SetFurColor(vec3[0], vec3[1], vec3[2]);
+				const XMFLOAT3& furColor = compiledObject.Vec3s[ER_COMPILED_SCENE_OBJECT_VEC3_FUR_COLOR];
+				aObject->SetFurColor(furColor.x, furColor.y, furColor.z);
 			}
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_color_interpolation"))
-				aObject->SetFurColorInterpolation(mSceneJsonRoot["rendering_objects"][i]["fur_color_interpolation"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_length"))
-				aObject->SetFurLength(mSceneJsonRoot["rendering_objects"][i]["fur_length"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_cutoff"))
-				aObject->SetFurCutoff(mSceneJsonRoot["rendering_objects"][i]["fur_cutoff"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_cutoff_end"))
-				aObject->SetFurCutoffEnd(mSceneJsonRoot["rendering_objects"][i]["fur_cutoff_end"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_wind_frequency"))
-				aObject->SetFurWindFrequency(mSceneJsonRoot["rendering_objects"][i]["fur_wind_frequency"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_gravity_strength"))
-				aObject->SetFurGravityStrength(mSceneJsonRoot["rendering_objects"][i]["fur_gravity_strength"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_uv_scale"))
-				aObject->SetFurUVScale(mSceneJsonRoot["rendering_objects"][i]["fur_uv_scale"].asFloat());
-
-			//terrain
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_placement"))
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_COLOR_INTERPOLATION))
+				aObject->SetFurColorInterpolation(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_COLOR_INTERPOLATION]);
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_LENGTH))
+				aObject->SetFurLength(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_LENGTH]);
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF))
+				aObject->SetFurCutoff(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF]);
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF_END))
+				aObject->SetFurCutoffEnd(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_CUTOFF_END]);
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_WIND_FREQUENCY))
+				aObject->SetFurWindFrequency(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_WIND_FREQUENCY]);
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_GRAVITY_STRENGTH))
+				aObject->SetFurGravityStrength(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_GRAVITY_STRENGTH]);
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_UV_SCALE))
+				aObject->SetFurUVScale(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_FUR_UV_SCALE]);
+
+			//terrain (procedural fields are only compiled for objects with "terrain_placement")
+			if (compiledObject.HasBool(ER_COMPILED_SCENE_OBJECT_BOOL_TERRAIN_PLACEMENT))
 			{
-				aObject->SetTerrainPlacement(mSceneJsonRoot["rendering_objects"][i]["terrain_placement"].asBool());
+				aObject->SetTerrainPlacement(compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_TERRAIN_PLACEMENT));
 
-				if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_splat_channel"))
-					aObject->SetTerrainProceduralPlacementSplatChannel(mSceneJsonRoot["rendering_objects"][i]["terrain_splat_channel"].asInt());
+				if (compiledObject.HasInt(ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_SPLAT_CHANNEL))
+					aObject->SetTerrainProceduralPlacementSplatChannel(compiledObject.Ints[ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_SPLAT_CHANNEL]);
 
 				//procedural flags
 				{
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_scale_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_scale_max"))
+					if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MIN))
 						aObject->SetTerrainProceduralObjectsMinMaxScale(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_scale_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_scale_max"].asFloat());
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MIN],
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_SCALE_MAX]);
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_pitch_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_pitch_max"))
+					if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MIN))
 						aObject->SetTerrainProceduralObjectsMinMaxPitch(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_pitch_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_pitch_max"].asFloat());
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MIN],
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_PITCH_MAX]);
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_roll_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_roll_max"))
+					if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MIN))
 						aObject->SetTerrainProceduralObjectsMinMaxRoll(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_roll_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_roll_max"].asFloat());
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MIN],
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ROLL_MAX]);
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_yaw_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_yaw_max"))
+					if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MIN))
 						aObject->SetTerrainProceduralObjectsMinMaxYaw(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_yaw_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_yaw_max"].asFloat());
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MIN],
+							compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_YAW_MAX]);
 
-					if (isInstanced && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_count"))
-						aObject->SetTerrainProceduralInstanceCount(mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_count"].asInt());
+					if (isInstanced && compiledObject.HasInt(ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_INSTANCE_COUNT))
+						aObject->SetTerrainProceduralInstanceCount(compiledObject.Ints[ER_COMPILED_SCENE_OBJECT_INT_TERRAIN_INSTANCE_COUNT]);
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_zone_center_pos"))
-					{
-						float vec3[3];
-						for (Json::Value::ArrayIndex vecI = 0; vecI != mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_zone_center_pos"].size(); vecI++)
-							vec3[vecI] = mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_zone_center_pos"][vecI].asFloat();
-
-						XMFLOAT3 centerPos = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-						aObject->SetTerrainProceduralZoneCenterPos(centerPos);
-					}
+					if (compiledObject.HasVec3(ER_COMPILED_SCENE_OBJECT_VEC3_TERRAIN_ZONE_CENTER_POS))
+						aObject->SetTerrainProceduralZoneCenterPos(compiledObject.Vec3s[ER_COMPILED_SCENE_OBJECT_VEC3_TERRAIN_ZONE_CENTER_POS]);
 
-					if (isInstanced && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_zone_radius"))
-						aObject->SetTerrainProceduralZoneRadius(mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_zone_radius"].asFloat());
+					if (isInstanced && compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ZONE_RADIUS))
+						aObject->SetTerrainProceduralZoneRadius(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_TERRAIN_ZONE_RADIUS]);
 				}
 			}
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("min_scale"))
-				aObject->SetMinScale(mSceneJsonRoot["rendering_objects"][i]["min_scale"].asFloat());
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_MIN_SCALE))
+				aObject->SetMinScale(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_MIN_SCALE]);
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("max_scale"))
-				aObject->SetMaxScale(mSceneJsonRoot["rendering_objects"][i]["max_scale"].asFloat());
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_MAX_SCALE))
+				aObject->SetMaxScale(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_MAX_SCALE]);
+
+			if (compiledObject.HasFloat(ER_COMPILED_SCENE_OBJECT_FLOAT_LOD_BIAS))
+				aObject->SetLODBias(compiledObject.Floats[ER_COMPILED_SCENE_OBJECT_FLOAT_LOD_BIAS]);
 		}
 
 		// load materials
 		{
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("new_materials")) {
-				unsigned int numMaterials = mSceneJsonRoot["rendering_objects"][i]["new_materials"].size();
-				for (Json::Value::ArrayIndex matIndex = 0; matIndex != numMaterials; matIndex++) {
-					std::string name = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["name"].asString();
-
-					MaterialShaderEntries shaderEntries;
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("vertexEntry"))
-						shaderEntries.vertexEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["vertexEntry"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("geometryEntry"))
-						shaderEntries.geometryEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["geometryEntry"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("hullEntry"))
-						shaderEntries.hullEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["hullEntry"].asString();	
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("domainEntry"))
-						shaderEntries.domainEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["domainEntry"].asString();	
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("pixelEntry"))
-						shaderEntries.pixelEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["pixelEntry"].asString();
-
-					if (isInstanced) //be careful with the instancing support in shaders of the materials! (i.e., maybe the material does not have instancing entry point/support)
-						shaderEntries.vertexEntry = shaderEntries.vertexEntry + "_instancing";
-					
-					if (name == ER_MaterialHelper::gbufferMaterialName)
-						aObject->SetInGBuffer(true);
-					if (name == ER_MaterialHelper::renderToLightProbeMaterialName)
-						aObject->SetInLightProbe(true);
-
-					if (name == ER_MaterialHelper::shadowMapMaterialName)
+			for (UINT matIndex = 0; matIndex < compiledObject.MaterialsCount; matIndex++) {
+				const ER_CompiledSceneMaterial& compiledMaterial = mCompiledScene->GetMaterial(compiledObject.FirstMaterial + matIndex);
+				std::string name = mCompiledScene->GetString(compiledMaterial.Name);
+
+				MaterialShaderEntries shaderEntries;
+				if (mCompiledScene->HasString(compiledMaterial.VertexEntry))
+					shaderEntries.vertexEntry = mCompiledScene->GetString(compiledMaterial.VertexEntry);
+				if (mCompiledScene->HasString(compiledMaterial.GeometryEntry))
+					shaderEntries.geometryEntry = mCompiledScene->GetString(compiledMaterial.GeometryEntry);
+				if (mCompiledScene->HasString(compiledMaterial.HullEntry))
+					shaderEntries.hullEntry = mCompiledScene->GetString(compiledMaterial.HullEntry);
+				if (mCompiledScene->HasString(compiledMaterial.DomainEntry))
+					shaderEntries.domainEntry = mCompiledScene->GetString(compiledMaterial.DomainEntry);
+				if (mCompiledScene->HasString(compiledMaterial.PixelEntry))
+					shaderEntries.pixelEntry = mCompiledScene->GetString(compiledMaterial.PixelEntry);
+
+				if (isInstanced) //be careful with the instancing support in shaders of the materials! (i.e., maybe the material does not have instancing entry point/support)
+					shaderEntries.vertexEntry = shaderEntries.vertexEntry + "_instancing";
+				
+				if (name == ER_MaterialHelper::gbufferMaterialName)
+					aObject->SetInGBuffer(true);
+				if (name == ER_MaterialHelper::renderToLightProbeMaterialName)
+					aObject->SetInLightProbe(true);
+
+				if (name == ER_MaterialHelper::shadowMapMaterialName)
+				{
+					for (int cascade = 0; cascade < NUM_SHADOW_CASCADES; cascade++)
 					{
-						for (int cascade = 0; cascade < NUM_SHADOW_CASCADES; cascade++)
-						{
-							std::string cascadedname = ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(cascade);
-							aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), cascadedname);
-						}
+						std::string cascadedname = ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(cascade);
+						aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), cascadedname);
+					}
+				}
+				else if (name == ER_MaterialHelper::voxelizationMaterialName)
+				{
+					aObject->SetInVoxelization(true);
+					for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+					{
+						const std::string fullname = ER_MaterialHelper::voxelizationMaterialName + "_" + std::to_string(cascade);
+						aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), fullname);
 					}
-					else if (name == ER_MaterialHelper::voxelizationMaterialName)
+				}
+				else if (name == ER_MaterialHelper::furShellMaterialName)
+				{
+					ER_RHI_GPURootSignature* rs = mStandardMaterialsRootSignatures.at(name);
+					int layerCount = aObject->GetFurLayersCount();
+					if (layerCount > 0)
 					{
-						aObject->SetInVoxelization(true);
-						for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+						for (int layer = 0; layer < layerCount; layer++)
 						{
-							const std::string fullname = ER_MaterialHelper::voxelizationMaterialName + "_" + std::to_string(cascade);
-							aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), fullname);
+							const std::string fullname = ER_MaterialHelper::furShellMaterialName + "_" + std::to_string(layer);
+							aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced, layer), fullname);
+							if (rs)
+								mStandardMaterialsRootSignatures.emplace(fullname, rs);
 						}
 					}
-					else if (name == ER_MaterialHelper::furShellMaterialName)
+
+				}
+				else if (name == ER_MaterialHelper::renderToLightProbeMaterialName)
+				{
+					std::string originalPSEntry = shaderEntries.pixelEntry;
+					for (int cubemapFaceIndex = 0; cubemapFaceIndex < CUBEMAP_FACES_COUNT; cubemapFaceIndex++)
 					{
-						ER_RHI_GPURootSignature* rs = mStandardMaterialsRootSignatures.at(name);
-						int layerCount = aObject->GetFurLayersCount();
-						if (layerCount > 0)
+						std::string newName;
+						//diffuse
 						{
-							for (int layer = 0; layer < layerCount; layer++)
-							{
-								const std::string fullname = ER_MaterialHelper::furShellMaterialName + "_" + std::to_string(layer);
-								aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced, layer), fullname);
-								if (rs)
-									mStandardMaterialsRootSignatures.emplace(fullname, rs);
-							}
+							shaderEntries.pixelEntry = originalPSEntry + "_DiffuseProbes";
+							newName = "diffuse_" + ER_MaterialHelper::renderToLightProbeMaterialName + "_" + std::to_string(cubemapFaceIndex);
+							aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), newName);
 						}
-
-					}
-					else if (name == ER_MaterialHelper::renderToLightProbeMaterialName)
-					{
-						std::string originalPSEntry = shaderEntries.pixelEntry;
-						for (int cubemapFaceIndex = 0; cubemapFaceIndex < CUBEMAP_FACES_COUNT; cubemapFaceIndex++)
+						//specular
 						{
-							std::string newName;
-							//diffuse
-							{
-								shaderEntries.pixelEntry = originalPSEntry + "_DiffuseProbes";
-								newName = "diffuse_" + ER_MaterialHelper::renderToLightProbeMaterialName + "_" + std::to_string(cubemapFaceIndex);
-								aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), newName);
-							}
-							//specular
-							{
-								shaderEntries.pixelEntry = originalPSEntry + "_SpecularProbes";
-								newName = "specular_" + ER_MaterialHelper::renderToLightProbeMaterialName + "_" + std::to_string(cubemapFaceIndex);
-								aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), newName);
-							}
+							shaderEntries.pixelEntry = originalPSEntry + "_SpecularProbes";
+							newName = "specular_" + ER_MaterialHelper::renderToLightProbeMaterialName + "_" + std::to_string(cubemapFaceIndex);
+							aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), newName);
 						}
 					}
-					else //other standard materials
-						aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), name);
 				}
+				else //other standard materials
+					aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), name);
 			}
 
 			aObject->LoadRenderBuffers();
 		}
 
 		// load extra materials data
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("snow_albedo"))
-			aObject->mSnowAlbedoTexturePath = mSceneJsonRoot["rendering_objects"][i]["snow_albedo"].asString();
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("snow_normal"))
-			aObject->mSnowNormalTexturePath = mSceneJsonRoot["rendering_objects"][i]["snow_normal"].asString();
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("snow_roughness"))
-			aObject->mSnowRoughnessTexturePath = mSceneJsonRoot["rendering_objects"][i]["snow_roughness"].asString();
+		if (mCompiledScene->HasString(compiledObject.SnowAlbedo))
+			aObject->mSnowAlbedoTexturePath = mCompiledScene->GetString(compiledObject.SnowAlbedo);
+		if (mCompiledScene->HasString(compiledObject.SnowNormal))
+			aObject->mSnowNormalTexturePath = mCompiledScene->GetString(compiledObject.SnowNormal);
+		if (mCompiledScene->HasString(compiledObject.SnowRoughness))
+			aObject->mSnowRoughnessTexturePath = mCompiledScene->GetString(compiledObject.SnowRoughness);
 		
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("fresnel_outline_color"))
-		{
-			float vec3[3];
-			for (Json::Value::ArrayIndex vecI = 0; vecI != mSceneJsonRoot["rendering_objects"][i]["fresnel_outline_color"].size(); vecI++)
-				vec3[vecI] = mSceneJsonRoot["rendering_objects"][i]["fresnel_outline_color"][vecI].asFloat();
+		if (compiledObject.HasVec3(ER_COMPILED_SCENE_OBJECT_VEC3_FRESNEL_OUTLINE_COLOR))
+			aObject->SetFresnelOutlineColor(compiledObject.Vec3s[ER_COMPILED_SCENE_OBJECT_VEC3_FRESNEL_OUTLINE_COLOR]);
 
-			XMFLOAT3 color = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
-			aObject->SetFresnelOutlineColor(color);
-		}
-
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_height"))
-			aObject->mFurHeightTexturePath = mSceneJsonRoot["rendering_objects"][i]["fur_height"].asString();
+		if (mCompiledScene->HasString(compiledObject.FurHeight))
+			aObject->mFurHeightTexturePath = mCompiledScene->GetString(compiledObject.FurHeight);
 
 		// load textures
 		{
 			const int meshCount = aObject->GetMeshCount();
-
-			const bool containsCustomTextures = mSceneJsonRoot["rendering_objects"][i].isMember("textures");
-			const int maxCustomTextures = mSceneJsonRoot["rendering_objects"][i]["textures"].size();
+			const int maxCustomTextures = static_cast<int>(compiledObject.MeshTexturesCount);
 
 			for (int meshIndex = 0; meshIndex < meshCount; meshIndex++)
 			{
-				if (containsCustomTextures && meshIndex < maxCustomTextures)
+				if (meshIndex < maxCustomTextures)
 				{
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("albedo"))
-						aObject->mCustomAlbedoTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["albedo"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("normal"))
-						aObject->mCustomNormalTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["normal"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("roughness"))
-						aObject->mCustomRoughnessTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["roughness"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("metalness"))
-						aObject->mCustomMetalnessTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["metalness"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("height"))
-						aObject->mCustomHeightTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["height"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("reflection_mask"))
-						aObject->mCustomReflectionMaskTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["reflection_mask"].asString();
+					const ER_CompiledSceneMeshTextures& textures = mCompiledScene->GetMeshTextures(compiledObject.FirstMeshTextures + meshIndex);
+					if (mCompiledScene->HasString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_ALBEDO]))
+						aObject->mCustomAlbedoTextures[meshIndex] = mCompiledScene->GetString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_ALBEDO]);
+					if (mCompiledScene->HasString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_NORMAL]))
+						aObject->mCustomNormalTextures[meshIndex] = mCompiledScene->GetString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_NORMAL]);
+					if (mCompiledScene->HasString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_ROUGHNESS]))
+						aObject->mCustomRoughnessTextures[meshIndex] = mCompiledScene->GetString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_ROUGHNESS]);
+					if (mCompiledScene->HasString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_METALNESS]))
+						aObject->mCustomMetalnessTextures[meshIndex] = mCompiledScene->GetString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_METALNESS]);
+					if (mCompiledScene->HasString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_HEIGHT]))
+						aObject->mCustomHeightTextures[meshIndex] = mCompiledScene->GetString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_HEIGHT]);
+					if (mCompiledScene->HasString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_REFLECTION_MASK]))
+						aObject->mCustomReflectionMaskTextures[meshIndex] = mCompiledScene->GetString(textures.Textures[ER_COMPILED_SCENE_MESH_TEXTURE_REFLECTION_MASK]);
 
 					aObject->LoadCustomMeshTextures(meshIndex);
 				}
@@ -546,34 +486,14 @@ namespace EveryRay_Core
 			aObject->LoadCustomMaterialTextures();
 		}
 
-		// load world transform
-		{
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("transform")) {
-				if (mSceneJsonRoot["rendering_objects"][i]["transform"].size() != 16)
-				{
-					aObject->SetTransformationMatrix(XMMatrixIdentity());
-				}
-				else {
-					float matrix[16];
-					for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["rendering_objects"][i]["transform"].size(); matC++) {
-						matrix[matC] = mSceneJsonRoot["rendering_objects"][i]["transform"][matC].asFloat();
-					}
-					XMFLOAT4X4 worldTransform(matrix);
-					aObject->SetTransformationMatrix(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)));
-				}
-			}
-			else
-				aObject->SetTransformationMatrix(XMMatrixIdentity());
-		}
+		// load world transform (already transposed and set to identity if missing in json)
+		aObject->SetTransformationMatrix(XMLoadFloat4x4(&compiledObject.Transform));
 
 		// load lods
 		{
-			hasLODs = mSceneJsonRoot["rendering_objects"][i].isMember("model_lods");
-			if (hasLODs) {
-				for (Json::Value::ArrayIndex lod = 1 /* 0 is main model loaded before */; lod != mSceneJsonRoot["rendering_objects"][i]["model_lods"].size(); lod++) {
-					std::string path = mSceneJsonRoot["rendering_objects"][i]["model_lods"][lod]["path"].asString();
-					aObject->LoadLOD(std::unique_ptr<ER_Model>(new ER_Model(*mCore, ER_Utility::GetFilePath(path), true)));
-				}
+			for (UINT lod = 1 /* 0 is main model loaded before */; lod < compiledObject.LODsCount; lod++) {
+				std::string path = mCompiledScene->GetLODPath(compiledObject.FirstLODPath + lod - 1);
+				aObject->LoadLOD(std::unique_ptr<ER_Model>(new ER_Model(*mCore, ER_Utility::GetFilePath(path), true)));
 			}
 		}
 
@@ -589,69 +509,35 @@ namespace EveryRay_Core
 		if (!isInstanced)
 			return;
 
-		bool hasLODs = mSceneJsonRoot["rendering_objects"][i].isMember("model_lods");
-		if (hasLODs)
+		const ER_CompiledSceneObject& compiledObject = mCompiledScene->GetSceneObject(i);
+		const bool hasInstancesTransforms = compiledObject.GetBool(ER_COMPILED_SCENE_OBJECT_BOOL_HAS_INSTANCES_TRANSFORMS);
+		const XMFLOAT4X4* instancesTransforms = hasInstancesTransforms ? mCompiledScene->GetInstances(compiledObject.FirstInstance) : nullptr;
+
+		// same transforms are used for every loaded lod ("model_lods" in json, 1 lod if not specified)
+		const int lodCount = aObject->GetLODCount();
+		for (int lod = 0; lod < lodCount; lod++)
 		{
-			for (int lod = 0; lod < mSceneJsonRoot["rendering_objects"][i]["model_lods"].size(); lod++)
-			{
-				aObject->LoadInstanceBuffers(lod);
-				if (aObject->GetTerrainPlacement() && aObject->GetTerrainProceduralInstanceCount() > 0)
-				{
-					int instanceCount = aObject->GetTerrainProceduralInstanceCount();
-					aObject->ResetInstanceData(instanceCount, true, lod);
-					for (int i = 0; i < instanceCount; i++)
-						aObject->AddInstanceData(XMMatrixIdentity(), lod);
-				}
-				else
-				{
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("instances_transforms")) {
-						aObject->ResetInstanceData(mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(), true, lod);
-						for (Json::Value::ArrayIndex instance = 0; instance != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(); instance++) {
-							float matrix[16];
-							for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"].size(); matC++) {
-								matrix[matC] = mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"][matC].asFloat();
-							}
-							XMFLOAT4X4 worldTransform(matrix);
-							aObject->AddInstanceData(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)), lod);
-						}
-					}
-					else {
-						aObject->ResetInstanceData(1, true, lod);
-						aObject->AddInstanceData(aObject->GetTransformationMatrix(), lod);
-					}
-				}
-				aObject->UpdateInstanceBuffer(aObject->GetInstancesData(), lod);
-			}
-		}
-		else {
-			aObject->LoadInstanceBuffers();
+			aObject->LoadInstanceBuffers(lod);
 
 			if (aObject->GetTerrainPlacement() && aObject->GetTerrainProceduralInstanceCount() > 0)
 			{
 				int instanceCount = aObject->GetTerrainProceduralInstanceCount();
-				aObject->ResetInstanceData(instanceCount, true);
-				for (int i = 0; i < instanceCount; i++)
-					aObject->AddInstanceData(XMMatrixIdentity());
+				aObject->ResetInstanceData(instanceCount, true, lod);
+				for (int instance = 0; instance < instanceCount; instance++)
+					aObject->AddInstanceData(XMMatrixIdentity(), lod);
+			}
+			else if (hasInstancesTransforms)
+			{
+				aObject->ResetInstanceData(compiledObject.InstancesCount, true, lod);
+				for (UINT instance = 0; instance < compiledObject.InstancesCount; instance++)
+					aObject->AddInstanceData(XMLoadFloat4x4(&instancesTransforms[instance]), lod);
 			}
 			else
 			{
-				if (mSceneJsonRoot["rendering_objects"][i].isMember("instances_transforms")) {
-					aObject->ResetInstanceData(mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(), true);
-					for (Json::Value::ArrayIndex instance = 0; instance != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(); instance++) {
-						float matrix[16];
-						for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"].size(); matC++) {
-							matrix[matC] = mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"][matC].asFloat();
-						}
-						XMFLOAT4X4 worldTransform(matrix);
-						aObject->AddInstanceData(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)));
-					}
-				}
-				else {
-					aObject->ResetInstanceData(1, true);
-					aObject->AddInstanceData(aObject->GetTransformationMatrix());
-				}
+				aObject->ResetInstanceData(1, true, lod);
+				aObject->AddInstanceData(aObject->GetTransformationMatrix(), lod);
 			}
-			aObject->UpdateInstanceBuffer(aObject->GetInstancesData());
+			aObject->UpdateInstanceBuffer(aObject->GetInstancesData(lod), lod);
 		}
 	}
 
@@ -660,6 +546,8 @@ namespace EveryRay_Core
 		if (mScenePath.empty())
 			throw ER_CoreException("Can't save to scene json file! Empty scene name...");
 
+		ParseSceneJson();
+
 		if (mSceneJsonRoot.isMember("foliage_zones")) {
 			assert(foliageZones.size() == mSceneJsonRoot["foliage_zones"].size());
 			float vec3[3];
@@ -675,12 +563,7 @@ namespace EveryRay_Core
 			}
 		}
 
-		Json::StreamWriterBuilder builder;
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-
-		std::ofstream file_id;
-		file_id.open(mScenePath.c_str());
-		writer->write(mSceneJsonRoot, &file_id);
+		WriteSceneJson();
 	}
 
 	void ER_Scene::SaveRenderingObjectsTransforms()
@@ -688,6 +571,8 @@ namespace EveryRay_Core
 		if (mScenePath.empty())
 			throw ER_CoreException("Can't save to scene json file! Empty scene name...");
 
+		ParseSceneJson();
+
 		// store world transform
 		for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["rendering_objects"].size(); i++) {
 			Json::Value content(Json::arrayValue);
@@ -746,12 +631,7 @@ namespace EveryRay_Core
 			}
 		}
 
-		Json::StreamWriterBuilder builder;
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-
-		std::ofstream file_id;
-		file_id.open(mScenePath.c_str());
-		writer->write(mSceneJsonRoot, &file_id);
+		WriteSceneJson();
 	}
 
 	// We cant do reflection in C++, that is why we check every materials name and create a material out of it (and root-signature if needed)
@@ -788,46 +668,56 @@ namespace EveryRay_Core
 
 	void ER_Scene::LoadFoliageZones(std::vector<ER_Foliage*>& foliageZones, ER_DirectionalLight& light)
 	{
-		Json::Reader reader;
-		std::ifstream scene(mScenePath.c_str(), std::ifstream::binary);
 		ER_Core* core = GetCore();
 		assert(core);
 
-		if (!reader.parse(scene, mSceneJsonRoot)) {
-			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
-		}
-		else {
-			if (mSceneJsonRoot.isMember("foliage_zones")) {
-				for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["foliage_zones"].size(); i++)
-				{
-					float vec3[3];
-					for (Json::Value::ArrayIndex ia = 0; ia != mSceneJsonRoot["foliage_zones"][i]["position"].size(); ia++)
-						vec3[ia] = mSceneJsonRoot["foliage_zones"][i]["position"][ia].asFloat();
-
-					bool placedOnTerrain = false;
-					if (mSceneJsonRoot["foliage_zones"][i].isMember("placed_on_terrain"))
-						placedOnTerrain = mSceneJsonRoot["foliage_zones"][i]["placed_on_terrain"].asBool();
-					
-					TerrainSplatChannels terrainChannel = TerrainSplatChannels::NONE;
-					if (mSceneJsonRoot["foliage_zones"][i].isMember("placed_splat_channel"))
-						terrainChannel = (TerrainSplatChannels)(mSceneJsonRoot["foliage_zones"][i]["placed_splat_channel"].asInt());
-
-					float placedHeightDelta = 0.0f;
-					if (mSceneJsonRoot["foliage_zones"][i].isMember("placed_height_delta"))
-						placedHeightDelta = mSceneJsonRoot["foliage_zones"][i]["placed_height_delta"].asFloat();
-
-					foliageZones.push_back(new ER_Foliage(*core, mCamera, light,
-						mSceneJsonRoot["foliage_zones"][i]["patch_count"].asInt(),
-						ER_Utility::GetFilePath(mSceneJsonRoot["foliage_zones"][i]["texture_path"].asString()),
-						mSceneJsonRoot["foliage_zones"][i]["average_scale"].asFloat(),
-						mSceneJsonRoot["foliage_zones"][i]["distribution_radius"].asFloat(),
-						XMFLOAT3(vec3[0], vec3[1], vec3[2]),
-						(FoliageBillboardType)mSceneJsonRoot["foliage_zones"][i]["type"].asInt(), placedOnTerrain, terrainChannel, placedHeightDelta));
-				}
+		if (mCompiledScene->HasSetting(ER_COMPILED_SCENE_SETTING_FOLIAGE)) {
+			for (UINT i = 0; i < mCompiledScene->GetFoliageZonesCount(); i++)
+			{
+				const ER_CompiledSceneFoliageZone& zone = mCompiledScene->GetFoliageZone(i);
+
+				TerrainSplatChannels terrainChannel = TerrainSplatChannels::NONE;
+				if (zone.PlacedSplatChannel >= 0)
+					terrainChannel = (TerrainSplatChannels)(zone.PlacedSplatChannel);
+
+				foliageZones.push_back(new ER_Foliage(*core, mCamera, light,
+					zone.PatchCount,
+					ER_Utility::GetFilePath(std::string(mCompiledScene->GetString(zone.TexturePath))),
+					zone.AverageScale,
+					zone.DistributionRadius,
+					zone.Position,
+					(FoliageBillboardType)zone.Type, zone.PlacedOnTerrain != 0, terrainChannel, zone.PlacedHeightDelta));
 			}
-			else
-				mHasFoliage = false;
 		}
+		else
+			mHasFoliage = false;
+	}
+
+	// Scene is loaded from its compiled version, so json is only parsed when we need to save something back to it (editor)
+	void ER_Scene::ParseSceneJson()
+	{
+		if (!mSceneJsonRoot.isNull())
+			return;
+
+		Json::Reader reader;
+		std::ifstream scene(mScenePath.c_str(), std::ifstream::binary);
+		if (!reader.parse(scene, mSceneJsonRoot))
+			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
+	}
+
+	void ER_Scene::WriteSceneJson()
+	{
+		{
+			Json::StreamWriterBuilder builder;
+			std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+
+			std::ofstream file_id;
+			file_id.open(mScenePath.c_str());
+			writer->write(mSceneJsonRoot, &file_id);
+		}
+
+		// keep the binary in sync, so that the next load does not have to parse the json again
+		mCompiledScene->Recompile(mScenePath, mSceneJsonRoot);
 	}
 
 	ER_RHI_GPURootSignature* ER_Scene::GetStandardMaterialRootSignature(const std::string& materialName)
@@ -841,6 +731,12 @@ namespace EveryRay_Core
 			return nullptr;
 	}
 
+	UINT64 ER_Scene::GetContentHash() const
+	{
+		assert(mCompiledScene);
+		return mCompiledScene->GetContentHash();
+	}
+
 	ER_RenderingObject* ER_Scene::FindRenderingObjectByName(const std::string& aName)
 	{
 		for (auto& sceneObj : objects)
@@ -853,4 +749,118 @@ namespace EveryRay_Core
 
 		return nullptr;
 	}
+
+	void ER_Scene::UpdateBVH()
+	{
+		// gather the items (and detect if they are not the same as in the BVH, i.e., objects were added/reordered)
+		bool isStructureChanged = false;
+		UINT itemsCount = 0;
+		for (auto& sceneObj : objects)
+		{
+			ER_RenderingObject* object = sceneObj.second;
+			const UINT instancesCount = object->GetOriginalInstanceCount();
+			const UINT objectItemsCount = object->IsInstanced() ? instancesCount : 1;
+			if (mBVHItems.size() < itemsCount + objectItemsCount)
+			{
+				mBVHItems.resize(itemsCount + objectItemsCount);
+				mBVHItemsBounds.resize(itemsCount + objectItemsCount);
+			}
+
+			for (UINT i = 0; i < objectItemsCount; i++)
+			{
+				ER_SceneBVHItem& item = mBVHItems[itemsCount + i];
+				const int instanceIndex = object->IsInstanced() ? static_cast<int>(i) : -1;
+				if (item.Object != object || item.InstanceIndex != instanceIndex)
+				{
+					item.Object = object;
+					item.InstanceIndex = instanceIndex;
+					isStructureChanged = true;
+				}
+				mBVHItemsBounds[itemsCount + i] = (instanceIndex >= 0) ? object->GetInstanceAABB(instanceIndex) : object->GetGlobalAABB();
+			}
+			itemsCount += objectItemsCount;
+		}
+		if (mBVHItems.size() != itemsCount)
+		{
+			mBVHItems.resize(itemsCount);
+			mBVHItemsBounds.resize(itemsCount);
+			isStructureChanged = true;
+		}
+
+		if (isStructureChanged || mBVH.GetItemsCount() != itemsCount)
+		{
+			mBVH.Build(mBVHItemsBounds.data(), itemsCount);
+			mBVHStats.RebuildsCount++;
+		}
+		else
+		{
+			mBVH.Refit(mBVHItemsBounds.data());
+			mBVHStats.RefitsCount++;
+			if (mBVH.NeedsRebuild())
+			{
+				mBVH.Build(mBVHItemsBounds.data(), itemsCount);
+				mBVHStats.RebuildsCount++;
+			}
+		}
+	}
+
+	void ER_Scene::CullObjects(const ER_Frustum& aFrustum)
+	{
+		for (auto& sceneObj : objects)
+		{
+			if (!sceneObj.second->IsGPUIndirectlyRendered())
+				sceneObj.second->BeginSceneCulling();
+		}
+
+		mBVHQueryItems.clear();
+		mBVH.QueryFrustum(aFrustum.Planes(), 6, mBVHQueryItems);
+		for (UINT itemIndex : mBVHQueryItems)
+		{
+			const ER_SceneBVHItem& item = mBVHItems[itemIndex];
+			if (item.Object->IsGPUIndirectlyRendered())
+				continue;
+
+			// instanced objects stay visible (DrawLOD(), GBuffer, voxelization) as long as any of their instances is
+			if (item.InstanceIndex >= 0)
+				item.Object->SetInstanceCulled(item.InstanceIndex, false);
+			item.Object->SetCulled(false);
+		}
+	}
+
+	void ER_Scene::GetUniqueObjects(const std::vector<UINT>& aItems, std::vector<ER_RenderingObject*>& aOutObjects) const
+	{
+		const size_t firstObject = aOutObjects.size();
+		ER_RenderingObject* lastObject = nullptr; // instances of the same object often end up next to each other
+		for (UINT itemIndex : aItems)
+		{
+			if (mBVHItems[itemIndex].Object != lastObject)
+			{
+				lastObject = mBVHItems[itemIndex].Object;
+				aOutObjects.push_back(lastObject);
+			}
+		}
+		std::sort(aOutObjects.begin() + firstObject, aOutObjects.end());
+		aOutObjects.erase(std::unique(aOutObjects.begin() + firstObject, aOutObjects.end()), aOutObjects.end());
+	}
+
+	void ER_Scene::QueryObjects(const XMFLOAT4* aPlanes, UINT aPlanesCount, std::vector<ER_RenderingObject*>& aOutObjects) const
+	{
+		std::vector<UINT> items;
+		mBVH.QueryFrustum(aPlanes, aPlanesCount, items);
+		GetUniqueObjects(items, aOutObjects);
+	}
+
+	void ER_Scene::QueryObjects(const ER_AABB& aAABB, std::vector<ER_RenderingObject*>& aOutObjects) const
+	{
+		std::vector<UINT> items;
+		mBVH.QueryAABB(aAABB, items);
+		GetUniqueObjects(items, aOutObjects);
+	}
+
+	void ER_Scene::QueryObjects(const XMFLOAT3& aCenter, float aRadius, std::vector<ER_RenderingObject*>& aOutObjects) const
+	{
+		std::vector<UINT> items;
+		mBVH.QuerySphere(aCenter, aRadius, items);
+		GetUniqueObjects(items, aOutObjects);
+	}
 }
\ No newline at end of file
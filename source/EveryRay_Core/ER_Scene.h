@@ -4,6 +4,7 @@
 #include "ER_Camera.h"
 #include "ER_ModelMaterial.h"
 #include "ER_Material.h"
+#include "ER_BVH.h"
 
 #include "..\JsonCpp\include\json\json.h"
 
@@ -12,8 +13,21 @@ namespace EveryRay_Core
 	class ER_RenderingObject;
 	class ER_DirectionalLight;
 	class ER_Foliage;
+	class ER_CompiledScene;
 	using ER_SceneObject = std::pair<std::string, ER_RenderingObject*>;
 
+	struct ER_SceneBVHItem
+	{
+		ER_RenderingObject* Object = nullptr;
+		int InstanceIndex = -1; // -1 for non-instanced objects (instanced objects only have their instances in the BVH)
+	};
+
+	struct ER_SceneBVHStats
+	{
+		UINT RefitsCount = 0;
+		UINT RebuildsCount = 0;
+	};
+
 	class ER_Scene : public ER_CoreComponent
 	{
 	public:
@@ -24,6 +38,21 @@ namespace EveryRay_Core
 		ER_RenderingObject* FindRenderingObjectByName(const std::string& aName);
 		std::vector<ER_SceneObject> objects;
 
+		// Scene BVH over the world space AABBs of all objects and instances (see ER_BVH).
+		// Update it once per frame after the objects' bounds (ER_RenderingObject::UpdateBounds()): it is refitted,
+		// or rebuilt if the objects/instances have changed or the refitted tree became too slow.
+		void UpdateBVH();
+		void CullObjects(const ER_Frustum& aFrustum); // main camera culling flags of all (not GPU-culled) objects and their instances
+
+		// Unique objects that have (at least one instance) inside of the volume; for items/rays use GetBVH() and GetBVHItem()
+		void QueryObjects(const XMFLOAT4* aPlanes, UINT aPlanesCount, std::vector<ER_RenderingObject*>& aOutObjects) const;
+		void QueryObjects(const ER_AABB& aAABB, std::vector<ER_RenderingObject*>& aOutObjects) const;
+		void QueryObjects(const XMFLOAT3& aCenter, float aRadius, std::vector<ER_RenderingObject*>& aOutObjects) const;
+
+		const ER_BVH& GetBVH() const { return mBVH; }
+		const ER_SceneBVHItem& GetBVHItem(UINT aItem) const { return mBVHItems[aItem]; }
+		const ER_SceneBVHStats& GetBVHStats() const { return mBVHStats; }
+
 		ER_Material* GetMaterialByName(const std::string& matName, const MaterialShaderEntries& entries, bool instanced, int layerIndex = -1);
 		ER_RHI_GPURootSignature* GetStandardMaterialRootSignature(const std::string& materialName);
 		
@@ -34,6 +63,9 @@ namespace EveryRay_Core
 		const XMFLOAT3& GetSunDir() { return mSunDirection; }
 		const XMFLOAT3& GetSunColor() { return mSunColor; }
 
+		// see ER_CompiledScene::GetContentHash()
+		UINT64 GetContentHash() const;
+
 		bool HasLightProbesSupport() { return mHasLightProbes; }
 		const XMFLOAT3& GetLightProbesVolumeMinBounds() const { return mLightProbesVolumeMinBounds; }
 		const XMFLOAT3& GetLightProbesVolumeMaxBounds() const { return mLightProbesVolumeMaxBounds; }
@@ -56,9 +88,18 @@ namespace EveryRay_Core
 		void CreateStandardMaterialsRootSignatures();
 		void LoadRenderingObjectData(ER_RenderingObject* aObject);
 		void LoadRenderingObjectInstancedData(ER_RenderingObject* aObject);
+		void ParseSceneJson();
+		void WriteSceneJson();
+		void GetUniqueObjects(const std::vector<UINT>& aItems, std::vector<ER_RenderingObject*>& aOutObjects) const;
 
 		std::map<std::string, ER_RHI_GPURootSignature*> mStandardMaterialsRootSignatures;
 
+		ER_BVH mBVH;
+		std::vector<ER_SceneBVHItem> mBVHItems; // in the order of "objects" and their instances
+		std::vector<ER_AABB> mBVHItemsBounds;
+		std::vector<UINT> mBVHQueryItems; // temp results of CullObjects()
+		ER_SceneBVHStats mBVHStats;
+
 		ER_Camera& mCamera;
 		XMFLOAT3 mCameraPosition;
 		XMFLOAT3 mCameraDirection;
@@ -66,7 +107,8 @@ namespace EveryRay_Core
 		XMFLOAT3 mSunDirection; //in degrees
 		XMFLOAT3 mSunColor;
 
-		Json::Value mSceneJsonRoot;
+		ER_CompiledScene* mCompiledScene = nullptr; // scene is always loaded from the compiled (binary) version of the json, see ER_CompiledScene
+		Json::Value mSceneJsonRoot; // only parsed when we save the scene back to json (editor)
 		std::string mScenePath;
 		
 		bool mHasVolumetricFog = false;
@@ -0,0 +1,232 @@
+#include "stdafx.h"
+
+#include "ER_ShaderCache.h"
+#include "ER_MappedFile.h"
+#include "ER_Utility.h"
+#include <algorithm>
+
+namespace EveryRay_Core
+{
+	// Collects the files from "#include" directives. Directives inside #if blocks are collected too:
+	// it can only make the key change more often than needed, never less.
+	static void ParseIncludes(const std::vector<char>& aSource, std::vector<std::string>& aOutIncludes)
+	{
+		std::string line;
+		std::istringstream stream(std::string(aSource.begin(), aSource.end()));
+		while (std::getline(stream, line))
+		{
+			size_t pos = line.find_first_not_of(" \t");
+			if (pos == std::string::npos || line[pos] != '#')
+				continue;
+
+			pos = line.find_first_not_of(" \t", pos + 1);
+			if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+				continue;
+
+			size_t begin = line.find_first_of("\"<", pos + 7);
+			if (begin == std::string::npos)
+				continue;
+
+			size_t end = line.find_first_of(line[begin] == '"' ? "\"" : ">", begin + 1);
+			if (end == std::string::npos || end == begin + 1)
+				continue;
+
+			aOutIncludes.push_back(line.substr(begin + 1, end - begin - 1));
+		}
+	}
+
+	static void AppendKeyData(std::string& aKeyData, const void* aData, size_t aSize)
+	{
+		aKeyData.append(static_cast<const char*>(aData), aSize);
+	}
+
+	static void AppendKeyData(std::string& aKeyData, const std::string& aString)
+	{
+		// strings are zero-terminated, so that "AB"+"C" and "A"+"BC" give different keys
+		aKeyData.append(aString.c_str(), aString.size() + 1);
+	}
+
+	UINT64 ER_ShaderCache::ComputeKey(const std::string& aPath, const std::string& aEntry, const std::string& aProfile, const std::vector<std::string>& aDefines, UINT aFlags)
+	{
+		std::string keyData;
+		const UINT32 version = ER_SHADER_CACHE_VERSION;
+		AppendKeyData(keyData, &version, sizeof(version));
+		AppendKeyData(keyData, aEntry);
+		AppendKeyData(keyData, aProfile);
+		AppendKeyData(keyData, &aFlags, sizeof(aFlags));
+		for (auto& define : aDefines)
+			AppendKeyData(keyData, define);
+
+		std::vector<std::string> visited;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			AppendIncludeGraph(aPath, visited, keyData);
+		}
+
+		return ER_Utility::HashData(keyData.data(), keyData.size());
+	}
+
+	// Depth-first walk over the include graph: hashes (not paths) of the files go to the key, so the cache survives moving the repository.
+	// Include names are also added, because the same content included from different places can resolve to different files.
+	void ER_ShaderCache::AppendIncludeGraph(const std::string& aPath, std::vector<std::string>& aVisited, std::string& aOutKeyData)
+	{
+		// "#pragma once" files and include cycles
+		if (std::find(aVisited.begin(), aVisited.end(), aPath) != aVisited.end())
+			return;
+		aVisited.push_back(aPath);
+
+		const ER_ShaderCacheSourceFile& file = GetSourceFile(aPath);
+		if (!file.Exists)
+		{
+			// compiler will fail on it anyway, but we do not want to reuse an old result for it
+			AppendKeyData(aOutKeyData, "<missing>");
+			return;
+		}
+
+		AppendKeyData(aOutKeyData, &file.Hash, sizeof(file.Hash));
+
+		std::string directory;
+		ER_Utility::GetDirectory(aPath, directory);
+
+		for (auto& include : file.Includes)
+		{
+			AppendKeyData(aOutKeyData, include);
+			// same lookup as D3D_COMPILE_STANDARD_FILE_INCLUDE: relative to the including file
+			AppendIncludeGraph(directory.empty() ? include : directory + "/" + include, aVisited, aOutKeyData);
+		}
+	}
+
+	const ER_ShaderCache::ER_ShaderCacheSourceFile& ER_ShaderCache::GetSourceFile(const std::string& aPath)
+	{
+		ER_ShaderCacheSourceFile& file = mSourceFiles[aPath];
+
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExA(aPath.c_str(), GetFileExInfoStandard, &attributes))
+		{
+			file = ER_ShaderCacheSourceFile();
+			return file;
+		}
+
+		const UINT64 writeTime = (static_cast<UINT64>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+		const UINT64 size = (static_cast<UINT64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		if (file.Exists && file.WriteTime == writeTime && file.Size == size)
+			return file;
+
+		std::ifstream stream(aPath.c_str(), std::ios::binary | std::ios::ate);
+		if (!stream.good())
+		{
+			file = ER_ShaderCacheSourceFile();
+			return file;
+		}
+
+		std::vector<char> source(static_cast<size_t>(stream.tellg()));
+		stream.seekg(0, std::ios::beg);
+		if (!source.empty())
+			stream.read(source.data(), source.size());
+		stream.close();
+
+		file.Exists = true;
+		file.WriteTime = writeTime;
+		file.Size = size;
+		file.Hash = ER_Utility::HashData(source.data(), source.size());
+		file.Includes.clear();
+		ParseIncludes(source, file.Includes);
+		return file;
+	}
+
+	bool ER_ShaderCache::Find(UINT64 aKey, std::vector<char>& aOutBytecode)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto it = mBytecodes.find(aKey);
+			if (it != mBytecodes.end())
+			{
+				aOutBytecode = it->second;
+				mStats.MemoryHits++;
+				return true;
+			}
+		}
+
+		ER_MappedFile file;
+		bool isValid = file.Open(GetCachePath(aKey)) && file.GetSize() >= sizeof(ER_ShaderCacheHeader);
+		if (isValid)
+		{
+			const ER_ShaderCacheHeader& header = *reinterpret_cast<const ER_ShaderCacheHeader*>(file.GetData());
+			const char* bytecode = file.GetData() + sizeof(ER_ShaderCacheHeader);
+			isValid = header.Magic == ER_SHADER_CACHE_MAGIC && header.Version == ER_SHADER_CACHE_VERSION && header.Key == aKey &&
+				header.BytecodeSize > 0 && header.BytecodeSize == file.GetSize() - sizeof(ER_ShaderCacheHeader) &&
+				header.BytecodeHash == ER_Utility::HashData(bytecode, static_cast<size_t>(header.BytecodeSize));
+			if (isValid)
+				aOutBytecode.assign(bytecode, bytecode + header.BytecodeSize);
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!isValid)
+		{
+			mStats.Misses++;
+			return false;
+		}
+
+		mBytecodes[aKey] = aOutBytecode;
+		mStats.DiskHits++;
+		return true;
+	}
+
+	void ER_ShaderCache::Store(UINT64 aKey, const void* aBytecode, size_t aSize, double aCompileTimeMs)
+	{
+		assert(aBytecode && aSize > 0);
+
+		ER_ShaderCacheHeader header;
+		ZeroMemory(&header, sizeof(header));
+		header.Magic = ER_SHADER_CACHE_MAGIC;
+		header.Version = ER_SHADER_CACHE_VERSION;
+		header.Key = aKey;
+		header.BytecodeHash = ER_Utility::HashData(aBytecode, aSize);
+		header.BytecodeSize = static_cast<UINT64>(aSize);
+
+		std::vector<char> data(sizeof(header) + aSize);
+		memcpy(data.data(), &header, sizeof(header));
+		memcpy(data.data() + sizeof(header), aBytecode, aSize);
+
+		CreateDirectoryA(ER_Utility::GetFilePath(std::string(ER_SHADER_CACHE_DIRECTORY)).c_str(), nullptr);
+		const bool isSaved = ER_Utility::SaveBinaryFile(GetCachePath(aKey), data.data(), data.size());
+		if (!isSaved)
+		{
+			std::string message = "[ER Logger][ER_ShaderCache] Could not save shader cache file: " + GetCachePath(aKey) + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		const char* bytecode = static_cast<const char*>(aBytecode);
+		mBytecodes[aKey].assign(bytecode, bytecode + aSize);
+		mStats.CompileTimeMs += aCompileTimeMs;
+		if (!isSaved)
+			mStats.FailedSaves++;
+	}
+
+	ER_ShaderCacheStats ER_ShaderCache::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mStats;
+	}
+
+	void ER_ShaderCache::ResetStats()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats = ER_ShaderCacheStats();
+	}
+
+	void ER_ShaderCache::ClearMemory()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mBytecodes.clear();
+		mSourceFiles.clear();
+	}
+
+	std::string ER_ShaderCache::GetCachePath(UINT64 aKey)
+	{
+		char name[17];
+		sprintf_s(name, "%016llx", static_cast<unsigned long long>(aKey));
+		return ER_Utility::GetFilePath(std::string(ER_SHADER_CACHE_DIRECTORY) + name + ER_SHADER_CACHE_EXTENSION);
+	}
+}
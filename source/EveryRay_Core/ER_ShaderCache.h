@@ -0,0 +1,75 @@
+#pragma once
+#include "Common.h"
+
+#define ER_SHADER_CACHE_MAGIC 0x48535245 // "ERSH"
+#define ER_SHADER_CACHE_VERSION 1
+#define ER_SHADER_CACHE_EXTENSION ".ershader"
+#define ER_SHADER_CACHE_DIRECTORY "content\\shaders\\cache\\"
+
+namespace EveryRay_Core
+{
+	// Stored in the file "as is", followed by the bytecode.
+	// WARNING: if you change this struct or the way ER_ShaderCache builds the keys, increase ER_SHADER_CACHE_VERSION.
+	struct ER_ShaderCacheHeader
+	{
+		UINT32 Magic;
+		UINT32 Version;
+		UINT64 Key;
+		UINT64 BytecodeHash;
+		UINT64 BytecodeSize;
+	};
+
+	struct ER_ShaderCacheStats
+	{
+		UINT64 MemoryHits = 0; // bytecode was already loaded/compiled in this session
+		UINT64 DiskHits = 0; // bytecode was read from ER_SHADER_CACHE_DIRECTORY
+		UINT64 Misses = 0; // shader had to be compiled
+		UINT64 FailedSaves = 0;
+		double CompileTimeMs = 0.0; // time spent in the compiler on misses
+	};
+
+	// Persistent, content-addressed cache of compiled shader bytecode (API-agnostic, RHIs only pass the bytes around).
+	// Key is a hash of: shader file content, content of all the files it includes (recursively), defines, entry point, target profile and compile flags.
+	// Every source file is hashed once and then only re-hashed when its write time or size changes, together with its list of includes (include graph).
+	// Bytecode is kept in memory for the whole session (i.e., level switches do not touch the disk or the compiler) and saved to ER_SHADER_CACHE_DIRECTORY.
+	// Thread-safe, but does not lock while the caller is compiling.
+	class ER_ShaderCache
+	{
+	public:
+		ER_ShaderCache() {}
+		~ER_ShaderCache() {}
+
+		// "aPath" is the full path of the shader file, "aDefines" are in "NAME=VALUE" format.
+		UINT64 ComputeKey(const std::string& aPath, const std::string& aEntry, const std::string& aProfile, const std::vector<std::string>& aDefines, UINT aFlags);
+
+		// Returns false if the shader has to be compiled (and then passed to Store()).
+		bool Find(UINT64 aKey, std::vector<char>& aOutBytecode);
+		void Store(UINT64 aKey, const void* aBytecode, size_t aSize, double aCompileTimeMs);
+
+		ER_ShaderCacheStats GetStats();
+		void ResetStats();
+		void ClearMemory(); // drops in-memory bytecode and include graph (disk cache stays)
+
+		static std::string GetCachePath(UINT64 aKey);
+	private:
+		ER_ShaderCache(const ER_ShaderCache&) = delete;
+		ER_ShaderCache& operator=(const ER_ShaderCache&) = delete;
+
+		struct ER_ShaderCacheSourceFile
+		{
+			UINT64 WriteTime = 0;
+			UINT64 Size = 0;
+			UINT64 Hash = 0;
+			std::vector<std::string> Includes; // as written in the file
+			bool Exists = false;
+		};
+
+		const ER_ShaderCacheSourceFile& GetSourceFile(const std::string& aPath);
+		void AppendIncludeGraph(const std::string& aPath, std::vector<std::string>& aVisited, std::string& aOutKeyData);
+
+		std::unordered_map<std::string, ER_ShaderCacheSourceFile> mSourceFiles;
+		std::unordered_map<UINT64, std::vector<char>> mBytecodes;
+		ER_ShaderCacheStats mStats;
+		std::mutex mMutex;
+	};
+}
@@ -0,0 +1,152 @@
+#include "stdafx.h"
+
+#include "ER_ShaderProgramRegistry.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	ER_ShaderProgramRegistry::~ER_ShaderProgramRegistry()
+	{
+		// all materials should have released their shaders by now
+		if (mReferencesCount > 0)
+		{
+			std::string message = "[ER Logger][ER_ShaderProgramRegistry] Destroying shader programs that are still referenced by materials: " + std::to_string(mReferencesCount) + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		}
+		for (auto& program : mPrograms)
+		{
+			DeleteObject(program.second->InputLayout);
+			DeleteObject(program.second->Shader);
+		}
+		mPrograms.clear();
+		mProgramsKeys.clear();
+	}
+
+	std::string ER_ShaderProgramRegistry::GetKey(const std::string& aPath, const std::string& aEntry, ER_RHI_SHADER_TYPE aType,
+		ER_RHI_INPUT_ELEMENT_DESC* aInputElementDescriptions, UINT aInputElementDescriptionCount)
+	{
+		std::stringstream key;
+		key << aPath << '|' << aEntry << '|' << static_cast<int>(aType);
+		for (UINT i = 0; i < aInputElementDescriptionCount; i++)
+		{
+			const ER_RHI_INPUT_ELEMENT_DESC& desc = aInputElementDescriptions[i];
+			key << '|' << (desc.SemanticName ? desc.SemanticName : "") << ',' << desc.SemanticIndex << ',' << static_cast<int>(desc.Format) << ',' <<
+				desc.InputSlot << ',' << desc.AlignedByteOffset << ',' << desc.IsPerVertex << ',' << desc.InstanceDataStepRate;
+		}
+		return key.str();
+	}
+
+	ER_RHI_GPUShader* ER_ShaderProgramRegistry::AddOrGetShader(ER_RHI* aRHI, const std::string& aPath, const std::string& aEntry, ER_RHI_SHADER_TYPE aType,
+		ER_RHI_INPUT_ELEMENT_DESC* aInputElementDescriptions, UINT aInputElementDescriptionCount, ER_RHI_InputLayout** aOutInputLayout)
+	{
+		assert(aRHI);
+		assert(aType != ER_VERTEX || (aInputElementDescriptions && aInputElementDescriptionCount > 0));
+
+		const std::string key = GetKey(aPath, aEntry, aType, aInputElementDescriptions, aInputElementDescriptionCount);
+
+		ER_ShaderProgram* program = nullptr;
+		{
+			const std::lock_guard<std::mutex> lock(mMutex);
+			std::unique_ptr<ER_ShaderProgram>& slot = mPrograms[key];
+			if (!slot)
+				slot.reset(new ER_ShaderProgram());
+			program = slot.get();
+			program->RefCount++;
+			mReferencesCount++;
+			mTotalRequestsCount++;
+		}
+
+		// compile outside of the registry lock (only the threads requesting this program wait)
+		try
+		{
+			std::call_once(program->CreatedFlag, [&]()
+			{
+				ER_RHI_InputLayout* inputLayout = nullptr;
+				if (aType == ER_VERTEX)
+					inputLayout = aRHI->CreateInputLayout(aInputElementDescriptions, aInputElementDescriptionCount);
+
+				ER_RHI_GPUShader* shader = aRHI->CreateGPUShader();
+				try
+				{
+					shader->CompileShader(aRHI, aPath, aEntry, aType, inputLayout);
+				}
+				catch (...)
+				{
+					DeleteObject(shader);
+					DeleteObject(inputLayout);
+					throw;
+				}
+
+				const std::lock_guard<std::mutex> lock(mMutex);
+				program->Shader = shader;
+				program->InputLayout = inputLayout;
+				mProgramsKeys.emplace(shader, key);
+				mTotalCreatedCount++;
+			});
+		}
+		catch (...)
+		{
+			// "CreatedFlag" is not set, so the next request will try to compile again
+			const std::lock_guard<std::mutex> lock(mMutex);
+			mReferencesCount--;
+			if (--program->RefCount == 0)
+				mPrograms.erase(key);
+			throw;
+		}
+
+		if (aOutInputLayout)
+			*aOutInputLayout = program->InputLayout;
+		return program->Shader;
+	}
+
+	void ER_ShaderProgramRegistry::ReleaseShader(ER_RHI_GPUShader* aShader)
+	{
+		if (!aShader)
+			return;
+
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		auto keyIt = mProgramsKeys.find(aShader);
+		if (keyIt == mProgramsKeys.end())
+		{
+			assert(("ER_ShaderProgramRegistry: releasing a shader that is not in the registry", 0));
+			return;
+		}
+
+		auto programIt = mPrograms.find(keyIt->second);
+		assert(programIt != mPrograms.end() && programIt->second->RefCount > 0);
+
+		mReferencesCount--;
+		if (--programIt->second->RefCount == 0)
+		{
+			DeleteObject(programIt->second->InputLayout);
+			DeleteObject(programIt->second->Shader);
+			mPrograms.erase(programIt);
+			mProgramsKeys.erase(keyIt);
+		}
+	}
+
+	UINT ER_ShaderProgramRegistry::GetProgramsCount()
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		return static_cast<UINT>(mPrograms.size());
+	}
+
+	UINT ER_ShaderProgramRegistry::GetReferencesCount()
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		return mReferencesCount;
+	}
+
+	UINT64 ER_ShaderProgramRegistry::GetTotalRequestsCount()
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		return mTotalRequestsCount;
+	}
+
+	UINT64 ER_ShaderProgramRegistry::GetTotalCreatedCount()
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		return mTotalCreatedCount;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Common.h"
+#include "RHI/ER_RHI.h"
+
+namespace EveryRay_Core
+{
+	// Compiled shader (+ input layout for vertex shaders) shared by all materials that request the same path, entry point, type and input layout.
+	// It is immutable after creation: materials only keep their per-instance data (constant buffers, etc.) unique.
+	struct ER_ShaderProgram
+	{
+		ER_RHI_GPUShader* Shader = nullptr;
+		ER_RHI_InputLayout* InputLayout = nullptr;
+		UINT RefCount = 0;
+		std::once_flag CreatedFlag;
+	};
+
+	// Reference-counted registry of ER_ShaderPrograms (owned by ER_Core).
+	// Thread-safe: scene objects load their materials from multiple threads. Different programs are compiled in parallel,
+	// while threads requesting a program that is being compiled wait for it instead of compiling it again.
+	class ER_ShaderProgramRegistry
+	{
+	public:
+		ER_ShaderProgramRegistry() {}
+		~ER_ShaderProgramRegistry();
+
+		// Returns a shared shader and adds a reference to it (call ReleaseShader() when you do not need it anymore).
+		// "aOutInputLayout" receives the shared input layout of vertex shaders.
+		ER_RHI_GPUShader* AddOrGetShader(ER_RHI* aRHI, const std::string& aPath, const std::string& aEntry, ER_RHI_SHADER_TYPE aType,
+			ER_RHI_INPUT_ELEMENT_DESC* aInputElementDescriptions = nullptr, UINT aInputElementDescriptionCount = 0, ER_RHI_InputLayout** aOutInputLayout = nullptr);
+		void ReleaseShader(ER_RHI_GPUShader* aShader);
+
+		UINT GetProgramsCount(); // programs that currently exist
+		UINT GetReferencesCount(); // programs that are currently requested by materials
+		UINT64 GetTotalRequestsCount(); // all requests since the start (including the ones that were already released)
+		UINT64 GetTotalCreatedCount(); // all programs compiled since the start
+	private:
+		ER_ShaderProgramRegistry(const ER_ShaderProgramRegistry&) = delete;
+		ER_ShaderProgramRegistry& operator=(const ER_ShaderProgramRegistry&) = delete;
+
+		static std::string GetKey(const std::string& aPath, const std::string& aEntry, ER_RHI_SHADER_TYPE aType,
+			ER_RHI_INPUT_ELEMENT_DESC* aInputElementDescriptions, UINT aInputElementDescriptionCount);
+
+		std::unordered_map<std::string, std::unique_ptr<ER_ShaderProgram>> mPrograms;
+		std::unordered_map<ER_RHI_GPUShader*, std::string> mProgramsKeys;
+		UINT mReferencesCount = 0;
+		UINT64 mTotalRequestsCount = 0;
+		UINT64 mTotalCreatedCount = 0;
+		std::mutex mMutex;
+	};
+}
@@ -20,8 +20,8 @@
 #include <algorithm>
 #include <limits>
 
-static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial";
-static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial w/ Instancing";
+static const ER_RHI_PSOHandle psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial";
+static const ER_RHI_PSOHandle psoNameInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial w/ Instancing";
 
 namespace EveryRay_Core
 {
@@ -61,6 +61,10 @@ namespace EveryRay_Core
 			mLightProjectors[i]->Initialize();
 			mLightProjectors[i]->SetProjectionMatrix(GetProjectionBoundingSphere(i));
 			//mLightProjectors[i]->ApplyRotation(mDirectionalLight.GetTransform());
+
+			mCascadeMaterialNames[i] = ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(i);
+			mCascadeTerrainEventTags[i] = "EveryRay: Shadow Maps (terrain), cascade " + std::to_string(i);
+			mCascadeObjectsEventTags[i] = "EveryRay: Shadow Maps (objects), cascade " + std::to_string(i);
 		}
 
 		mRootSignature = rhi->CreateRootSignature(4, 1);
@@ -94,6 +98,20 @@ namespace EveryRay_Core
 			mLightProjectors[i]->SetViewMatrix(mLightProjectorCenteredPositions[i], mDirectionalLight.Direction(), mDirectionalLight.Up());
 			mLightProjectors[i]->Update();
 		}
+
+		UpdateImGui();
+	}
+
+	void ER_ShadowMapper::UpdateImGui()
+	{
+		if (!mShowDebug)
+			return;
+
+		ImGui::Begin("Shadow Mapper");
+		ImGui::Checkbox("Caster culling (per cascade)", &mIsCasterCulling);
+		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
+			ImGui::Text("Cascade %d: %u casters drawn (%u instances), %u culled", i, mCastersStats.DrawnObjects[i], mCastersStats.DrawnInstances[i], mCastersStats.CulledObjects[i]);
+		ImGui::End();
 	}
 
 	void ER_ShadowMapper::BeginRenderingToShadowMap(int cascadeIndex)
@@ -267,6 +285,98 @@ namespace EveryRay_Core
 		return projectionMatrix;
 	}
 
+	// Convex volume of everything that can cast shadows into a cascade (planes face outwards):
+	// - light's projection without its near plane (casters between the light and the shadow map are still in the map after rasterization)
+	// - planes of the camera's cascade frustum that do not face the light: bounds moved along the light direction never get back inside them
+	UINT ER_ShadowMapper::GetCasterCullingPlanes(int cascadeIndex, XMFLOAT4* outPlanes) const
+	{
+		assert(cascadeIndex < NUM_SHADOW_CASCADES);
+
+		UINT planesCount = 0;
+		ER_Frustum lightFrustum(GetViewMatrix(cascadeIndex) * GetProjectionMatrix(cascadeIndex));
+		for (int planeID = 0; planeID < 6; planeID++)
+		{
+			if (planeID != FrustumPlaneNear)
+				outPlanes[planesCount++] = lightFrustum.Planes()[planeID];
+		}
+
+		if (mIsCascaded) // otherwise "mCameraCascadesFrustums" are not in world space
+		{
+			const XMFLOAT3& lightDirection = mDirectionalLight.Direction();
+			for (int planeID = 0; planeID < 6; planeID++)
+			{
+				const XMFLOAT4& plane = mCameraCascadesFrustums[cascadeIndex].Planes()[planeID];
+				if (plane.x * lightDirection.x + plane.y * lightDirection.y + plane.z * lightDirection.z >= 0.0f)
+					outPlanes[planesCount++] = plane;
+			}
+		}
+
+		assert(planesCount <= ER_FRUSTUM_MAX_CULLING_PLANES);
+		return planesCount;
+	}
+
+	void ER_ShadowMapper::CullCasters(const ER_Scene* scene)
+	{
+		const UINT objectsCount = static_cast<UINT>(scene->objects.size());
+		mObjectsCascadesMasks.assign(objectsCount, 0);
+		mObjectsCascadesInstances.assign(objectsCount * NUM_SHADOW_CASCADES, 0);
+		mCastersStats = ER_ShadowCastersStats();
+
+		if (mIsCasterCulling)
+		{
+			XMFLOAT4 planes[NUM_SHADOW_CASCADES][ER_FRUSTUM_MAX_CULLING_PLANES];
+			UINT planesCounts[NUM_SHADOW_CASCADES];
+			for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
+				planesCounts[i] = GetCasterCullingPlanes(i, planes[i]);
+
+			// instanced objects are tested per instance (their global AABB does not cover the instances)
+			GetCore()->JobSystem()->ParallelFor(objectsCount, ER_SHADOW_MAPPER_CASTERS_PER_JOB, [&](UINT start, UINT end)
+			{
+				for (UINT objectIndex = start; objectIndex < end; objectIndex++)
+				{
+					ER_RenderingObject* renderingObject = scene->objects[objectIndex].second;
+					for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
+					{
+						if (renderingObject->IsInstanced())
+						{
+							const UINT instancesCount = renderingObject->CullShadowCasterInstances(i, planes[i], planesCounts[i]);
+							mObjectsCascadesInstances[objectIndex * NUM_SHADOW_CASCADES + i] = instancesCount;
+							if (instancesCount == 0)
+								continue;
+						}
+						else if (ER_Frustum::IsAABBCulled(planes[i], planesCounts[i], renderingObject->GetGlobalAABB()))
+							continue;
+
+						mObjectsCascadesMasks[objectIndex] |= (1 << i);
+					}
+				}
+			});
+		}
+		else
+			std::fill(mObjectsCascadesMasks.begin(), mObjectsCascadesMasks.end(), static_cast<UINT8>((1 << NUM_SHADOW_CASCADES) - 1));
+
+		// compact the lists and upload casters' instances (RHI calls are only allowed on the main thread)
+		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
+		{
+			mCascadesCasters[i].clear();
+			for (UINT objectIndex = 0; objectIndex < objectsCount; objectIndex++)
+			{
+				ER_RenderingObject* renderingObject = scene->objects[objectIndex].second;
+				if (!(mObjectsCascadesMasks[objectIndex] & (1 << i)))
+				{
+					mCastersStats.CulledObjects[i]++;
+					continue;
+				}
+
+				if (mIsCasterCulling && renderingObject->IsInstanced() && !renderingObject->IsGPUIndirectlyRendered())
+					renderingObject->UploadShadowCasterInstances(i);
+				mCastersStats.DrawnInstances[i] += mObjectsCascadesInstances[objectIndex * NUM_SHADOW_CASCADES + i];
+				mCastersStats.DrawnObjects[i]++;
+				mCascadesCasters[i].push_back(renderingObject);
+			}
+		}
+	}
+
 	void ER_ShadowMapper::Draw(const ER_Scene* scene, ER_Terrain* terrain)
 	{
 		auto rhi = GetCore()->GetRHI();
@@ -274,26 +384,26 @@ namespace EveryRay_Core
 		ER_MaterialSystems materialSystems;
 		materialSystems.mShadowMapper = this;
 
+		CullCasters(scene);
+
 		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
 		{
-			std::string materialName = ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(i);
+			const std::string& materialName = mCascadeMaterialNames[i];
 			BeginRenderingToShadowMap(i);
 
-			rhi->BeginEventTag("EveryRay: Shadow Maps (terrain), cascade " + std::to_string(i));
+			rhi->BeginEventTag(mCascadeTerrainEventTags[i]);
 			if (terrain)
 				terrain->Draw(TerrainRenderPass::TERRAIN_SHADOW, { mShadowMaps[i] }, nullptr, this, nullptr, i);
 			rhi->EndEventTag();
 
-			rhi->BeginEventTag("EveryRay: Shadow Maps (objects), cascade " + std::to_string(i));
+			rhi->BeginEventTag(mCascadeObjectsEventTags[i]);
 
 			rhi->SetRootSignature(mRootSignature);
 			rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-			int objectIndex = 0;
-			for (auto renderingObjectInfo = scene->objects.begin(); renderingObjectInfo != scene->objects.end(); renderingObjectInfo++, objectIndex++)
+			for (ER_RenderingObject* renderingObject : mCascadesCasters[i])
 			{
-				ER_RenderingObject* renderingObject = renderingObjectInfo->second;
-				const std::string& psoName = renderingObject->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
+				const ER_RHI_PSOHandle& psoName = renderingObject->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
 				auto materialInfo = renderingObject->GetMaterials().find(materialName);
 				if (materialInfo != renderingObject->GetMaterials().end())
 				{
@@ -311,11 +421,18 @@ namespace EveryRay_Core
 						rhi->FinalizePSO(psoName);
 					}
 					rhi->SetPSO(psoName);
-					for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
+
+					// casters that passed our culling are drawn even if they are not visible to the camera
+					const bool isCulledPerCascade = mIsCasterCulling && !(renderingObject->IsInstanced() && renderingObject->IsGPUIndirectlyRendered());
+					const int casterLOD = renderingObject->GetLODCount() - 1; //drawing highest LOD
+					const int meshCount = isCulledPerCascade ? renderingObject->GetMeshCount(casterLOD) : renderingObject->GetMeshCount();
+					for (int meshIndex = 0; meshIndex < meshCount; meshIndex++)
 					{
 						static_cast<ER_ShadowMapMaterial*>(material)->PrepareForRendering(materialSystems, renderingObject, meshIndex, i, mRootSignature);
 						if (!renderingObject->IsInstanced())
-							renderingObject->DrawLOD(materialName, true, meshIndex, renderingObject->GetLODCount() - 1); //drawing highest LOD
+							renderingObject->DrawLOD(materialName, true, meshIndex, casterLOD, isCulledPerCascade);
+						else if (isCulledPerCascade)
+							renderingObject->DrawLOD(materialName, true, meshIndex, casterLOD, true, i); // only instances that can cast into this cascade
 						else
 							renderingObject->Draw(materialName, true, meshIndex);
 					}
@@ -3,6 +3,8 @@
 #include "ER_CoreComponent.h"
 #include "RHI/ER_RHI.h"
 
+#define ER_SHADOW_MAPPER_CASTERS_PER_JOB 16 // batch size for the parallel culling of casters
+
 namespace EveryRay_Core
 {
 	class ER_Frustum;
@@ -11,6 +13,7 @@ namespace EveryRay_Core
 	class ER_DirectionalLight;
 	class ER_Scene;
 	class ER_Terrain;
+	class ER_RenderingObject;
 
 	enum ShadowQuality
 	{
@@ -19,6 +22,14 @@ namespace EveryRay_Core
 		SHADOW_HIGH
 	};
 
+	// Shadow casters of the last frame
+	struct ER_ShadowCastersStats
+	{
+		UINT DrawnObjects[NUM_SHADOW_CASCADES] = {};
+		UINT CulledObjects[NUM_SHADOW_CASCADES] = {};
+		UINT DrawnInstances[NUM_SHADOW_CASCADES] = {}; // of instanced objects (after per-instance culling)
+	};
+
 	class ER_ShadowMapper : public ER_CoreComponent 
 	{
 	public:
@@ -36,7 +47,13 @@ namespace EveryRay_Core
 		void ApplyTransform();
 		//void ApplyRotation();
 
+		void Config() { mShowDebug = !mShowDebug; }
+		const ER_ShadowCastersStats& GetCastersStats() const { return mCastersStats; }
+
 	private:
+		void UpdateImGui();
+		void CullCasters(const ER_Scene* scene);
+		UINT GetCasterCullingPlanes(int cascadeIndex, XMFLOAT4* outPlanes) const;
 		XMMATRIX GetLightProjectionMatrixInFrustum(int index, ER_Frustum& cameraFrustum, ER_DirectionalLight& light);
 		XMMATRIX GetProjectionBoundingSphere(int index);
 
@@ -50,6 +67,16 @@ namespace EveryRay_Core
 		std::vector<ER_Frustum> mCameraCascadesFrustums;
 		std::vector<XMFLOAT3> mLightProjectorCenteredPositions;
 
+		// built once, so that Draw() does not concatenate strings per cascade every frame
+		std::string mCascadeMaterialNames[NUM_SHADOW_CASCADES];
+		std::string mCascadeTerrainEventTags[NUM_SHADOW_CASCADES];
+		std::string mCascadeObjectsEventTags[NUM_SHADOW_CASCADES];
+
+		std::vector<ER_RenderingObject*> mCascadesCasters[NUM_SHADOW_CASCADES]; // visible casters per cascade (rebuilt in every Draw())
+		std::vector<UINT8> mObjectsCascadesMasks; // per scene object: bitmask of cascades it can cast shadows into
+		std::vector<UINT> mObjectsCascadesInstances; // per scene object and cascade: instances that can cast shadows
+		ER_ShadowCastersStats mCastersStats;
+
 		ER_RHI_RASTERIZER_STATE mOriginalRS;
 		ER_RHI_Viewport mOriginalViewport;
 		ER_RHI_Rect mOriginalRect;
@@ -57,5 +84,7 @@ namespace EveryRay_Core
 		XMMATRIX mShadowMapProjectionMatrix;
 		UINT mResolution = 0;
 		bool mIsCascaded = true;
+		bool mIsCasterCulling = true;
+		bool mShowDebug = false;
 	};
 }
\ No newline at end of file
@@ -12,8 +12,8 @@
 
 namespace EveryRay_Core
 {
-	static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: SimpleSnowMaterial";
-	static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: SimpleSnowMaterial w/ Instancing";
+	static const ER_RHI_PSOHandle psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: SimpleSnowMaterial";
+	static const ER_RHI_PSOHandle psoNameInstanced = "ER_RHI_GPUPipelineStateObject: SimpleSnowMaterial w/ Instancing";
 
 	ER_SimpleSnowMaterial::ER_SimpleSnowMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced)
 		: ER_Material(game, entries, shaderFlags)
@@ -77,7 +77,7 @@ namespace EveryRay_Core
 		rhi->SetRootSignature(rs);
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		const std::string& psoName = aObj->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
+		const ER_RHI_PSOHandle& psoName = aObj->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
 		if (!rhi->IsPSOReady(psoName))
 		{
 			rhi->InitializePSO(psoName);
@@ -105,13 +105,13 @@ namespace EveryRay_Core
 		rhi->SetConstantBuffers(ER_VERTEX, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, SNOW_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 		rhi->SetConstantBuffers(ER_PIXEL, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, SNOW_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 
-		std::vector<ER_RHI_GPUResource*> resources;
-		resources.push_back(aObj->GetSnowAlbedoTexture());
-		resources.push_back(aObj->GetSnowNormalTexture());
-		resources.push_back(aObj->GetSnowRoughnessTexture());
-		resources.push_back(aObj->GetTextureData(meshIndex).NormalMap);
+		ER_RHI_GPUResource* resources[4 + NUM_SHADOW_CASCADES];
+		resources[0] = aObj->GetSnowAlbedoTexture();
+		resources[1] = aObj->GetSnowNormalTexture();
+		resources[2] = aObj->GetSnowRoughnessTexture();
+		resources[3] = aObj->GetTextureData(meshIndex).NormalMap;
 		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
-			resources.push_back(neededSystems.mShadowMapper->GetShadowTexture(i));
+			resources[4 + i] = neededSystems.mShadowMapper->GetShadowTexture(i);
 		rhi->SetShaderResources(ER_PIXEL, resources, 0, rs, SNOW_MAT_ROOT_DESCRIPTOR_TABLE_SRV_INDEX);
 
 		rhi->SetSamplers(ER_PIXEL, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP, ER_RHI_SAMPLER_STATE::ER_SHADOW_SS });
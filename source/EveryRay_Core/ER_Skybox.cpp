@@ -135,7 +135,7 @@ namespace EveryRay_Core
 	void ER_Skybox::Draw(ER_RHI_GPUTexture* aRenderTarget, ER_Camera* aCustomCamera, ER_RHI_GPUTexture* aSceneDepth, bool isVolumetricCloudsPass)
 	{
 		assert(aRenderTarget);
-		const std::string& psoName = isVolumetricCloudsPass ? mSkyboxPassVolumetricCloudsPSOName : mSkyboxPassPSOName;
+		const ER_RHI_PSOHandle& psoName = isVolumetricCloudsPass ? mSkyboxPassVolumetricCloudsPSOName : mSkyboxPassPSOName;
 
 		auto rhi = mCore.GetRHI();
 
@@ -190,7 +190,7 @@ namespace EveryRay_Core
 		auto quadRenderer = (ER_QuadRenderer*)mCore.GetServices().FindService(ER_QuadRenderer::TypeIdClass());
 		assert(quadRenderer);
 
-		const std::string& psoName = isVolumetricCloudsPass ? mSunPassVolumetricCloudsPSOName : mSunPassPSOName;
+		const ER_RHI_PSOHandle& psoName = isVolumetricCloudsPass ? mSunPassVolumetricCloudsPSOName : mSunPassPSOName;
 		if (mDrawSun)
 		{
 			rhi->SetRootSignature(mSunRS);
@@ -0,0 +1,148 @@
+#include "stdafx.h"
+
+#include "ER_SpatialHash.h"
+
+namespace EveryRay_Core
+{
+	static int GetBucketCoord(float aValue, float aInvBucketSize)
+	{
+		const float coord = floorf(aValue * aInvBucketSize);
+		return static_cast<int>(std::min(std::max(coord, static_cast<float>(-ER_SPATIAL_HASH_COORD_BIAS)), static_cast<float>(ER_SPATIAL_HASH_COORD_BIAS - 1)));
+	}
+
+	static bool AreAABBsOverlapping(const ER_AABB& a, const ER_AABB& b)
+	{
+		return
+			(a.first.x <= b.second.x && a.second.x >= b.first.x) &&
+			(a.first.y <= b.second.y && a.second.y >= b.first.y) &&
+			(a.first.z <= b.second.z && a.second.z >= b.first.z);
+	}
+
+	void ER_SpatialHash::Clear()
+	{
+		mBuckets.clear();
+		mItemsBounds.clear();
+		mItemsBucketsRanges.clear();
+	}
+
+	void ER_SpatialHash::Build(const ER_AABB* aItemsBounds, UINT aItemsCount, float aBucketSize)
+	{
+		assert(aItemsBounds || aItemsCount == 0);
+		assert(aBucketSize > 0.0f && "ER_SpatialHash: bucket size must be positive");
+
+		Clear();
+		mBucketSize = aBucketSize;
+		mInvBucketSize = 1.0f / aBucketSize;
+
+		mItemsBounds.assign(aItemsBounds, aItemsBounds + aItemsCount);
+		mItemsBucketsRanges.resize(aItemsCount);
+		mBuckets.reserve(aItemsCount);
+		for (UINT i = 0; i < aItemsCount; i++)
+			Insert(i);
+	}
+
+	void ER_SpatialHash::Update(UINT aItem, const ER_AABB& aBounds)
+	{
+		assert(aItem < GetItemsCount());
+
+		const BucketsRange newRange = GetBucketsRange(aBounds);
+		const BucketsRange& oldRange = mItemsBucketsRanges[aItem];
+		mItemsBounds[aItem] = aBounds;
+		if (memcmp(&newRange, &oldRange, sizeof(BucketsRange)) == 0) // still in the same buckets
+			return;
+
+		Remove(aItem);
+		Insert(aItem);
+	}
+
+	void ER_SpatialHash::QueryAABB(const ER_AABB& aBounds, std::vector<UINT>& aOutItems) const
+	{
+		aOutItems.clear();
+
+		const BucketsRange range = GetBucketsRange(aBounds);
+		for (int y = range.Min.y; y <= range.Max.y; y++)
+		{
+			for (int x = range.Min.x; x <= range.Max.x; x++)
+			{
+				for (int z = range.Min.z; z <= range.Max.z; z++)
+				{
+					auto bucket = mBuckets.find(GetBucketKey(x, y, z));
+					if (bucket == mBuckets.end())
+						continue;
+
+					// buckets are conservative, so test the actual bounds
+					for (UINT item : bucket->second)
+					{
+						if (AreAABBsOverlapping(mItemsBounds[item], aBounds))
+							aOutItems.push_back(item);
+					}
+				}
+			}
+		}
+
+		// items overlapping several buckets are found several times
+		std::sort(aOutItems.begin(), aOutItems.end());
+		aOutItems.erase(std::unique(aOutItems.begin(), aOutItems.end()), aOutItems.end());
+	}
+
+	ER_SpatialHash::BucketsRange ER_SpatialHash::GetBucketsRange(const ER_AABB& aBounds) const
+	{
+		BucketsRange range;
+		range.Min = XMINT3(GetBucketCoord(aBounds.first.x, mInvBucketSize), GetBucketCoord(aBounds.first.y, mInvBucketSize), GetBucketCoord(aBounds.first.z, mInvBucketSize));
+		range.Max = XMINT3(GetBucketCoord(aBounds.second.x, mInvBucketSize), GetBucketCoord(aBounds.second.y, mInvBucketSize), GetBucketCoord(aBounds.second.z, mInvBucketSize));
+		return range;
+	}
+
+	UINT64 ER_SpatialHash::GetBucketKey(int aX, int aY, int aZ)
+	{
+		const UINT64 mask = (1ull << ER_SPATIAL_HASH_COORD_BITS) - 1;
+		return
+			((static_cast<UINT64>(aX + ER_SPATIAL_HASH_COORD_BIAS) & mask) << (2 * ER_SPATIAL_HASH_COORD_BITS)) |
+			((static_cast<UINT64>(aY + ER_SPATIAL_HASH_COORD_BIAS) & mask) << ER_SPATIAL_HASH_COORD_BITS) |
+			(static_cast<UINT64>(aZ + ER_SPATIAL_HASH_COORD_BIAS) & mask);
+	}
+
+	void ER_SpatialHash::Insert(UINT aItem)
+	{
+		const BucketsRange range = GetBucketsRange(mItemsBounds[aItem]);
+		assert(static_cast<INT64>(range.Max.x - range.Min.x + 1) * (range.Max.y - range.Min.y + 1) * (range.Max.z - range.Min.z + 1) <= ER_SPATIAL_HASH_MAX_BUCKETS_PER_ITEM &&
+			"ER_SpatialHash: item overlaps too many buckets, bucket size is too small");
+
+		mItemsBucketsRanges[aItem] = range;
+		for (int y = range.Min.y; y <= range.Max.y; y++)
+		{
+			for (int x = range.Min.x; x <= range.Max.x; x++)
+			{
+				for (int z = range.Min.z; z <= range.Max.z; z++)
+					mBuckets[GetBucketKey(x, y, z)].push_back(aItem);
+			}
+		}
+	}
+
+	void ER_SpatialHash::Remove(UINT aItem)
+	{
+		const BucketsRange& range = mItemsBucketsRanges[aItem];
+		for (int y = range.Min.y; y <= range.Max.y; y++)
+		{
+			for (int x = range.Min.x; x <= range.Max.x; x++)
+			{
+				for (int z = range.Min.z; z <= range.Max.z; z++)
+				{
+					auto bucket = mBuckets.find(GetBucketKey(x, y, z));
+					if (bucket == mBuckets.end())
+						continue;
+
+					std::vector<UINT>& items = bucket->second;
+					auto item = std::find(items.begin(), items.end(), aItem);
+					if (item != items.end())
+					{
+						*item = items.back(); // order inside of a bucket does not matter (queries are sorted)
+						items.pop_back();
+					}
+					if (items.empty())
+						mBuckets.erase(bucket);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Common.h"
+
+#define ER_SPATIAL_HASH_COORD_BITS 21 // per axis, coordinates of a bucket are packed into one 64-bit key
+#define ER_SPATIAL_HASH_COORD_BIAS (1 << (ER_SPATIAL_HASH_COORD_BITS - 1))
+#define ER_SPATIAL_HASH_MAX_BUCKETS_PER_ITEM 4096 // items bigger than that (in buckets) are a sign of a too small bucket size
+
+namespace EveryRay_Core
+{
+	// Uniform spatial hash of AABBs (points are just degenerate AABBs): the space is split into cubic buckets of "bucket size",
+	// every item is stored in all the buckets it overlaps and only non-empty buckets are allocated (no bounds of the whole set are needed).
+	// - Build() is linear in the items count,
+	// - Update() moves one item between the buckets (i.e., when it moves) without touching the other items,
+	// - Query*() only visits the buckets overlapped by the query, so it does not depend on the items count.
+	// Works best when the bucket size is close to the typical size of the queries (and the distance between the items).
+	class ER_SpatialHash
+	{
+	public:
+		ER_SpatialHash() {}
+		~ER_SpatialHash() {}
+
+		void Clear();
+		void Build(const ER_AABB* aItemsBounds, UINT aItemsCount, float aBucketSize);
+		// Moves the item to its new bounds (the item has to be in the hash already)
+		void Update(UINT aItem, const ER_AABB& aBounds);
+
+		// Items overlapping the box (touching counts as overlapping), sorted by their indices, without duplicates
+		void QueryAABB(const ER_AABB& aBounds, std::vector<UINT>& aOutItems) const;
+		void QueryPoint(const XMFLOAT3& aPoint, std::vector<UINT>& aOutItems) const { QueryAABB(ER_AABB(aPoint, aPoint), aOutItems); }
+
+		UINT GetItemsCount() const { return static_cast<UINT>(mItemsBounds.size()); }
+		UINT GetBucketsCount() const { return static_cast<UINT>(mBuckets.size()); }
+		float GetBucketSize() const { return mBucketSize; }
+		const ER_AABB& GetItemBounds(UINT aItem) const { return mItemsBounds[aItem]; }
+	private:
+		struct BucketsRange
+		{
+			XMINT3 Min;
+			XMINT3 Max;
+		};
+
+		BucketsRange GetBucketsRange(const ER_AABB& aBounds) const;
+		static UINT64 GetBucketKey(int aX, int aY, int aZ);
+		void Insert(UINT aItem);
+		void Remove(UINT aItem);
+
+		std::unordered_map<UINT64, std::vector<UINT>> mBuckets; // items of every non-empty bucket
+		std::vector<ER_AABB> mItemsBounds;
+		std::vector<BucketsRange> mItemsBucketsRanges; // buckets the items are stored in (to remove them on Update())
+		float mBucketSize = 1.0f;
+		float mInvBucketSize = 1.0f;
+	};
+}
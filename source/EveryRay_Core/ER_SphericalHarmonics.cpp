@@ -0,0 +1,217 @@
+#include "stdafx.h"
+
+#include "ER_SphericalHarmonics.h"
+
+// basis constants (same as in SHMath's sh_eval_basis_2())
+#define ER_SH_BASIS_0 0.282094791773878140f
+#define ER_SH_BASIS_1 0.488602511902919920f
+#define ER_SH_BASIS_2_XY 1.092548430592079200f
+#define ER_SH_BASIS_2_ZZ 0.946174695757560080f
+#define ER_SH_BASIS_2_ZZ_BIAS 0.315391565252520050f
+#define ER_SH_BASIS_2_XX_YY 0.546274215296039590f
+
+namespace EveryRay_Core
+{
+	void ER_SphericalHarmonics::Clear()
+	{
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			mCoefficients[i] = XMVectorZero();
+	}
+
+	void ER_SphericalHarmonics::Set(const XMFLOAT3* aCoefficients)
+	{
+		assert(aCoefficients);
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			mCoefficients[i] = XMLoadFloat3(&aCoefficients[i]);
+	}
+
+	void ER_SphericalHarmonics::Get(XMFLOAT3* aOutCoefficients) const
+	{
+		assert(aOutCoefficients);
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			XMStoreFloat3(&aOutCoefficients[i], mCoefficients[i]);
+	}
+
+	void ER_SphericalHarmonics::Get(float* aOutR, float* aOutG, float* aOutB) const
+	{
+		assert(aOutR && aOutG && aOutB);
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+		{
+			aOutR[i] = XMVectorGetX(mCoefficients[i]);
+			aOutG[i] = XMVectorGetY(mCoefficients[i]);
+			aOutB[i] = XMVectorGetZ(mCoefficients[i]);
+		}
+	}
+
+	void XM_CALLCONV ER_SphericalHarmonics::EvaluateBasis(FXMVECTOR aDirection, float* aOutBasis)
+	{
+		XMFLOAT3 dir;
+		XMStoreFloat3(&dir, aDirection);
+
+		aOutBasis[0] = ER_SH_BASIS_0;
+		aOutBasis[1] = -ER_SH_BASIS_1 * dir.y;
+		aOutBasis[2] = ER_SH_BASIS_1 * dir.z;
+		aOutBasis[3] = -ER_SH_BASIS_1 * dir.x;
+		aOutBasis[4] = ER_SH_BASIS_2_XY * dir.x * dir.y;
+		aOutBasis[5] = -ER_SH_BASIS_2_XY * dir.y * dir.z;
+		aOutBasis[6] = ER_SH_BASIS_2_ZZ * dir.z * dir.z - ER_SH_BASIS_2_ZZ_BIAS;
+		aOutBasis[7] = -ER_SH_BASIS_2_XY * dir.x * dir.z;
+		aOutBasis[8] = ER_SH_BASIS_2_XX_YY * (dir.x * dir.x - dir.y * dir.y);
+	}
+
+	XMVECTOR XM_CALLCONV ER_SphericalHarmonics::Evaluate(FXMVECTOR aDirection) const
+	{
+		float basis[ER_SH_COEF_COUNT];
+		EvaluateBasis(aDirection, basis);
+
+		XMVECTOR result = XMVectorZero();
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			result = XMVectorMultiplyAdd(mCoefficients[i], XMVectorReplicate(basis[i]), result);
+		return result;
+	}
+
+	void ER_SphericalHarmonics::Add(const ER_SphericalHarmonics& aOther)
+	{
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			mCoefficients[i] = XMVectorAdd(mCoefficients[i], aOther.mCoefficients[i]);
+	}
+
+	void ER_SphericalHarmonics::Scale(float aScale)
+	{
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			mCoefficients[i] = XMVectorScale(mCoefficients[i], aScale);
+	}
+
+	void XM_CALLCONV ER_SphericalHarmonics::Scale(FXMVECTOR aColor)
+	{
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			mCoefficients[i] = XMVectorMultiply(mCoefficients[i], aColor);
+	}
+
+	void XM_CALLCONV ER_SphericalHarmonics::AddDirectionalLight(FXMVECTOR aDirection, FXMVECTOR aColor)
+	{
+		float basis[ER_SH_COEF_COUNT];
+		EvaluateBasis(aDirection, basis);
+
+		const XMVECTOR color = XMVectorAndInt(aColor, g_XMMask3);
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			mCoefficients[i] = XMVectorMultiplyAdd(color, XMVectorReplicate(basis[i]), mCoefficients[i]);
+	}
+
+	void XM_CALLCONV ER_SphericalHarmonics::Rotate(FXMMATRIX aRotation)
+	{
+		XMFLOAT3X3 r; // r[i][j]: row-vector convention, d' = d * r
+		XMStoreFloat3x3(&r, aRotation);
+
+		// band 1 is a linear function k * dot(w, d): w' = w * r
+		{
+			const XMVECTOR w[3] = { XMVectorNegate(mCoefficients[3]), XMVectorNegate(mCoefficients[1]), mCoefficients[2] };
+			XMVECTOR rotated[3];
+			for (int j = 0; j < 3; j++)
+			{
+				rotated[j] = XMVectorScale(w[0], r.m[0][j]);
+				rotated[j] = XMVectorMultiplyAdd(w[1], XMVectorReplicate(r.m[1][j]), rotated[j]);
+				rotated[j] = XMVectorMultiplyAdd(w[2], XMVectorReplicate(r.m[2][j]), rotated[j]);
+			}
+			mCoefficients[3] = XMVectorNegate(rotated[0]);
+			mCoefficients[1] = XMVectorNegate(rotated[1]);
+			mCoefficients[2] = rotated[2];
+		}
+
+		// band 2 is a traceless quadratic form d^T * M * d: M' = r^T * M * r
+		{
+			const XMVECTOR mXY = XMVectorScale(mCoefficients[4], ER_SH_BASIS_2_XX_YY);
+			const XMVECTOR mYZ = XMVectorScale(mCoefficients[5], -ER_SH_BASIS_2_XX_YY);
+			const XMVECTOR mXZ = XMVectorScale(mCoefficients[7], -ER_SH_BASIS_2_XX_YY);
+			const XMVECTOR mZZ = XMVectorScale(mCoefficients[6], 2.0f * ER_SH_BASIS_2_ZZ_BIAS);
+			const XMVECTOR mXX = XMVectorSubtract(XMVectorScale(mCoefficients[8], ER_SH_BASIS_2_XX_YY), XMVectorScale(mCoefficients[6], ER_SH_BASIS_2_ZZ_BIAS));
+			const XMVECTOR mYY = XMVectorSubtract(XMVectorNegate(XMVectorScale(mCoefficients[8], ER_SH_BASIS_2_XX_YY)), XMVectorScale(mCoefficients[6], ER_SH_BASIS_2_ZZ_BIAS));
+			const XMVECTOR m[3][3] = { { mXX, mXY, mXZ }, { mXY, mYY, mYZ }, { mXZ, mYZ, mZZ } };
+
+			XMVECTOR mr[3][3]; // M * r
+			for (int i = 0; i < 3; i++)
+			{
+				for (int b = 0; b < 3; b++)
+				{
+					mr[i][b] = XMVectorScale(m[i][0], r.m[0][b]);
+					mr[i][b] = XMVectorMultiplyAdd(m[i][1], XMVectorReplicate(r.m[1][b]), mr[i][b]);
+					mr[i][b] = XMVectorMultiplyAdd(m[i][2], XMVectorReplicate(r.m[2][b]), mr[i][b]);
+				}
+			}
+			auto getRotated = [&](int a, int b)
+			{
+				XMVECTOR result = XMVectorScale(mr[0][b], r.m[0][a]);
+				result = XMVectorMultiplyAdd(mr[1][b], XMVectorReplicate(r.m[1][a]), result);
+				return XMVectorMultiplyAdd(mr[2][b], XMVectorReplicate(r.m[2][a]), result);
+			};
+
+			const float invXY = 1.0f / ER_SH_BASIS_2_XX_YY;
+			mCoefficients[4] = XMVectorScale(getRotated(0, 1), invXY);
+			mCoefficients[5] = XMVectorScale(getRotated(1, 2), -invXY);
+			mCoefficients[7] = XMVectorScale(getRotated(0, 2), -invXY);
+			mCoefficients[6] = XMVectorScale(getRotated(2, 2), 1.0f / (2.0f * ER_SH_BASIS_2_ZZ_BIAS));
+			mCoefficients[8] = XMVectorScale(XMVectorSubtract(getRotated(0, 0), getRotated(1, 1)), 0.5f * invXY);
+		}
+	}
+
+	void ER_SphericalHarmonics::ConvolveWithCosineLobe()
+	{
+		// zonal harmonics of max(0, cos): pi, 2pi/3, pi/4 per band
+		const float bandScales[ER_SH_BANDS_COUNT] = { XM_PI, XM_2PI / 3.0f, XM_PI / 4.0f };
+		for (int band = 0; band < ER_SH_BANDS_COUNT; band++)
+		{
+			for (int i = band * band; i < (band + 1) * (band + 1); i++)
+				mCoefficients[i] = XMVectorScale(mCoefficients[i], bandScales[band]);
+		}
+	}
+
+	ER_SphericalHarmonics ER_SphericalHarmonics::ProjectCubemap(const XMFLOAT4* const* aFaces, UINT aSize, size_t aRowPitch)
+	{
+		assert(aFaces && aSize > 0);
+
+		ER_SphericalHarmonics result;
+		float totalWeight = 0.0f;
+		float basis[ER_SH_COEF_COUNT];
+
+		const float invSize = 1.0f / static_cast<float>(aSize);
+		for (int face = 0; face < ER_SH_CUBEMAP_FACES_COUNT; face++)
+		{
+			assert(aFaces[face]);
+			const char* row = reinterpret_cast<const char*>(aFaces[face]);
+			for (UINT y = 0; y < aSize; y++, row += aRowPitch)
+			{
+				const XMFLOAT4* texels = reinterpret_cast<const XMFLOAT4*>(row);
+				const float v = (2.0f * y + 1.0f) * invSize - 1.0f;
+				for (UINT x = 0; x < aSize; x++)
+				{
+					const float u = (2.0f * x + 1.0f) * invSize - 1.0f;
+
+					XMVECTOR direction;
+					switch (face)
+					{
+					case 0: direction = XMVectorSet(1.0f, -v, -u, 0.0f); break;
+					case 1: direction = XMVectorSet(-1.0f, -v, u, 0.0f); break;
+					case 2: direction = XMVectorSet(u, 1.0f, v, 0.0f); break;
+					case 3: direction = XMVectorSet(u, -1.0f, -v, 0.0f); break;
+					case 4: direction = XMVectorSet(u, -v, 1.0f, 0.0f); break;
+					default: direction = XMVectorSet(-u, -v, -1.0f, 0.0f); break;
+					}
+
+					// differential solid angle of the texel
+					const float distanceSq = 1.0f + u * u + v * v;
+					const float weight = 4.0f / (distanceSq * sqrtf(distanceSq));
+					totalWeight += weight;
+
+					EvaluateBasis(XMVector3Normalize(direction), basis);
+					const XMVECTOR color = XMVectorScale(XMVectorAndInt(XMLoadFloat4(&texels[x]), g_XMMask3), weight);
+					for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+						result.mCoefficients[i] = XMVectorMultiplyAdd(color, XMVectorReplicate(basis[i]), result.mCoefficients[i]);
+				}
+			}
+		}
+
+		// texels' solid angles do not add up to exactly 4pi
+		result.Scale(4.0f * XM_PI / totalWeight);
+		return result;
+	}
+}
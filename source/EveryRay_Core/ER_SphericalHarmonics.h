@@ -0,0 +1,46 @@
+#pragma once
+#include "Common.h"
+
+#define ER_SH_BANDS_COUNT 3 // == SPHERICAL_HARMONICS_ORDER + 1 of the light probes
+#define ER_SH_COEF_COUNT (ER_SH_BANDS_COUNT * ER_SH_BANDS_COUNT)
+#define ER_SH_CUBEMAP_FACES_COUNT 6
+
+namespace EveryRay_Core
+{
+	// RGB spherical harmonics of 3 bands (9 coefficients) in the basis of DirectXMath's SHMath (XMSHEvalDirection(), SHProjectCubeMap()),
+	// so that the coefficients go to the light probes' SH buffer "as is" (see GetDiffuseIrradianceFromSphericalHarmonics() in Lighting.hlsli).
+	// Every coefficient is one SIMD vector (RGB in xyz, w is always 0), so all the operations process the 3 channels at once.
+	// Only depends on DirectXMath (no RHI): cubemaps are projected from texels in CPU memory.
+	class ER_SphericalHarmonics
+	{
+	public:
+		ER_SphericalHarmonics() { Clear(); }
+		explicit ER_SphericalHarmonics(const XMFLOAT3* aCoefficients) { Set(aCoefficients); }
+
+		void Clear();
+		void Set(const XMFLOAT3* aCoefficients); // ER_SH_COEF_COUNT coefficients
+		void Get(XMFLOAT3* aOutCoefficients) const;
+		void Get(float* aOutR, float* aOutG, float* aOutB) const; // one array per channel (like in SHMath)
+		XMVECTOR GetCoefficient(int aIndex) const { return mCoefficients[aIndex]; }
+
+		// value of the function in the (normalized) direction
+		XMVECTOR XM_CALLCONV Evaluate(FXMVECTOR aDirection) const;
+
+		void Add(const ER_SphericalHarmonics& aOther);
+		void Scale(float aScale);
+		void XM_CALLCONV Scale(FXMVECTOR aColor);
+		// projection of a delta light (all of its "aColor" comes from the normalized "aDirection")
+		void XM_CALLCONV AddDirectionalLight(FXMVECTOR aDirection, FXMVECTOR aColor);
+		// rotates the function by the matrix (as in XMVector3TransformNormal()), so that rotated(d * aRotation) == original(d)
+		void XM_CALLCONV Rotate(FXMMATRIX aRotation);
+		// convolution with the clamped cosine lobe: radiance -> irradiance (both of the function and of the result are per steradian)
+		void ConvolveWithCosineLobe();
+
+		static void XM_CALLCONV EvaluateBasis(FXMVECTOR aDirection, float* aOutBasis);
+		// Solid angle weighted projection of all texels of a cubemap (faces in D3D order: +X, -X, +Y, -Y, +Z, -Z), "aRowPitch" is in bytes.
+		// Same texel directions and weights as in SHProjectCubeMap(), so the results match the GPU-readback one on DX11.
+		static ER_SphericalHarmonics ProjectCubemap(const XMFLOAT4* const* aFaces, UINT aSize, size_t aRowPitch);
+	private:
+		XMVECTOR mCoefficients[ER_SH_COEF_COUNT];
+	};
+}
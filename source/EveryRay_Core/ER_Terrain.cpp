@@ -428,6 +428,8 @@ namespace EveryRay_Core
 			rawImage = 0;
 		}
 
+		mHeightMaps[tileIndex]->BuildGridIndex(mWidth, mHeight);
+
 		// Generate CPU mesh (and its GPU vertex/index buffers) + calculate AABB of the tile
 		{
 			mHeightMaps[tileIndex]->mVertexCountNonTS = (mWidth - 1) * (mHeight - 1) * 6;
@@ -577,12 +579,20 @@ namespace EveryRay_Core
 	{
 		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
 
-		int visibleTiles = 0;
-		for (int i = 0; i < mHeightMaps.size(); i++)
+		// tiles are independent, so we cull them in parallel
+		std::atomic<int> visibleTilesCounter{ 0 };
+		ER_Camera* cullingCamera = mDoCPUFrustumCulling ? camera : nullptr;
+		mCore->JobSystem()->ParallelFor(static_cast<UINT>(mHeightMaps.size()), TERRAIN_TILES_PER_CULLING_JOB, [this, cullingCamera, &visibleTilesCounter](UINT start, UINT end)
 		{
-			if (!mHeightMaps[i]->PerformCPUFrustumCulling(mDoCPUFrustumCulling ? camera : nullptr))
-				visibleTiles++;
-		}
+			int visibleTilesInBatch = 0;
+			for (UINT i = start; i < end; i++)
+			{
+				if (!mHeightMaps[i]->PerformCPUFrustumCulling(cullingCamera))
+					visibleTilesInBatch++;
+			}
+			visibleTilesCounter.fetch_add(visibleTilesInBatch);
+		});
+		int visibleTiles = visibleTilesCounter.load();
 
 		if (mShowDebug) {
 			ImGui::Begin("Terrain System");
@@ -620,7 +630,7 @@ namespace EveryRay_Core
 		ER_RHI_PRIMITIVE_TYPE originalPrimitiveTopology = rhi->GetCurrentTopologyType();
 
 		ER_RHI_GPURootSignature* rootSig = mTerrainCommonPassRS;
-		std::string& psoName = mTerrainMainPassPSOName;
+		ER_RHI_PSOHandle psoName = mTerrainMainPassPSOName; // a copy (not a reference), so that the main pass handle is not overwritten below
 		if (aPass == TERRAIN_SHADOW)
 			psoName = mTerrainShadowPassPSOName;
 		else if (aPass == TERRAIN_GBUFFER)
@@ -681,7 +691,7 @@ namespace EveryRay_Core
 				rhi->SetConstantBuffers(ER_PIXEL,				{ mTerrainConstantBuffer.Buffer() }, 0, rootSig, TERRAIN_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 			}
 
-			std::vector<ER_RHI_GPUResource*> resources(19);
+			ER_RHI_GPUResource* resources[19] = {};
 			resources[0] = mHeightMaps[tileIndex]->mSplatTexture;
 			resources[1] = mSplatChannelTextures[0];
 			resources[2] = mSplatChannelTextures[1];
@@ -732,44 +742,92 @@ namespace EveryRay_Core
 	}
 
 
+	void HeightMap::BuildGridIndex(int width, int height)
+	{
+		assert(width > 1 && height > 1);
+
+		mGridWidth = width;
+		mGridHeight = height;
+		mGridOrigin = XMFLOAT2(mData[0].x, mData[0].z);
+		mGridCellSize = mData[1].x - mData[0].x;
+		assert(mGridCellSize > 0.0f);
+
+		mGridHeights.resize(width * height);
+		for (int i = 0; i < width * height; i++)
+			mGridHeights[i] = mData[i].y;
+	}
+
+	bool HeightMap::IsInGrid(float x, float z) const
+	{
+		if (mGridHeights.empty())
+			return false;
+
+		const float maxX = mGridOrigin.x + (mGridWidth - 1) * mGridCellSize;
+		const float maxZ = mGridOrigin.y + (mGridHeight - 1) * mGridCellSize;
+		return x >= mGridOrigin.x && x <= maxX && z >= mGridOrigin.y && z <= maxZ;
+	}
+
 	float HeightMap::FindHeightFromPosition(float x, float z)
 	{
-		int index = 0;
-		float vertex1[3] = { 0.0, 0.0, 0.0 };
-		float vertex2[3] = { 0.0, 0.0, 0.0 }; 
-		float vertex3[3] = { 0.0, 0.0, 0.0 }; 
-		float normals[3] = { 0.0, 0.0, 0.0 }; 
-		float height = 0.0f;
-		bool isFound = false;
-
-		int index1 = 0;
-		int index2 = 0;
-		int index3 = 0;
-
-		for (int i = 0; i < mVertexCountNonTS / 3; i++)
+		float height = -1.0f;
+		if (!FindHeightAndNormalFromPosition(x, z, height))
+			return -1.0f;
+		return height;
+	}
+
+	// Same triangulation as the CPU mesh of the tile: every cell is split by the diagonal from the bottom-left (i, j) to the upper-right (i + 1, j + 1) vertex.
+	bool HeightMap::FindHeightAndNormalFromPosition(float x, float z, float& height, XMFLOAT3* normal)
+	{
+		if (!IsInGrid(x, z))
+			return false;
+
+		const float gridX = (x - mGridOrigin.x) / mGridCellSize;
+		const float gridZ = (z - mGridOrigin.y) / mGridCellSize;
+		const int i = std::min(static_cast<int>(gridX), mGridWidth - 2);
+		const int j = std::min(static_cast<int>(gridZ), mGridHeight - 2);
+		const float u = gridX - i;
+		const float v = gridZ - j;
+
+		const float bottomLeft = mGridHeights[mGridWidth * j + i];
+		const float bottomRight = mGridHeights[mGridWidth * j + i + 1];
+		const float upperLeft = mGridHeights[mGridWidth * (j + 1) + i];
+		const float upperRight = mGridHeights[mGridWidth * (j + 1) + i + 1];
+
+		// height deltas along X and Z inside the triangle
+		float deltaX, deltaZ;
+		if (v >= u) // upper-left triangle
+		{
+			deltaX = upperRight - upperLeft;
+			deltaZ = upperLeft - bottomLeft;
+		}
+		else // bottom-right triangle
+		{
+			deltaX = bottomRight - bottomLeft;
+			deltaZ = upperRight - bottomRight;
+		}
+		height = bottomLeft + u * deltaX + v * deltaZ;
+
+		if (normal)
+		{
+			// cross((0, deltaZ, cellSize), (cellSize, deltaX, 0)), normalized
+			XMVECTOR n = XMVector3Normalize(XMVectorSet(-deltaX * mGridCellSize, mGridCellSize * mGridCellSize, -deltaZ * mGridCellSize, 0.0f));
+			XMStoreFloat3(normal, n);
+		}
+		return true;
+	}
+
+	void HeightMap::FindHeightsFromPositions(const XMFLOAT4* positions, int positionsCount, float* outHeights, XMFLOAT3* outNormals)
+	{
+		assert(positions && outHeights);
+		for (int i = 0; i < positionsCount; i++)
 		{
-			index = i * 3;
-
-			vertex1[0] = mVertexList[index].x;
-			vertex1[1] = mVertexList[index].y;
-			vertex1[2] = mVertexList[index].z;
-			index++;
-
-			vertex2[0] = mVertexList[index].x;
-			vertex2[1] = mVertexList[index].y;
-			vertex2[2] = mVertexList[index].z;
-			index++;
-
-			vertex3[0] = mVertexList[index].x;
-			vertex3[1] = mVertexList[index].y;
-			vertex3[2] = mVertexList[index].z;
-
-			// Check to see if this is the polygon we are looking for.
-			isFound = GetHeightFromTriangle(x, z, vertex1, vertex2, vertex3, normals, height);
-			if (isFound)
-				return height;
+			if (!FindHeightAndNormalFromPosition(positions[i].x, positions[i].z, outHeights[i], outNormals ? &outNormals[i] : nullptr))
+			{
+				outHeights[i] = -1.0f;
+				if (outNormals)
+					outNormals[i] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+			}
 		}
-		return -1.0f;
 	}
 
 	bool HeightMap::PerformCPUFrustumCulling(ER_Camera* camera)
@@ -1086,6 +1144,31 @@ namespace EveryRay_Core
 		rhi->EndBufferRead(outputBuffer);
 	}
 
+	void ER_Terrain::FindHeightsFromPositions(const XMFLOAT4* positions, int positionsCount, float* outHeights, XMFLOAT3* outNormals)
+	{
+		assert(positions && outHeights);
+
+		// points usually come in batches from the same area (foliage patches, instances), so we start from the last tile that was hit
+		int lastTileIndex = 0;
+		for (int i = 0; i < positionsCount; i++)
+		{
+			outHeights[i] = -1.0f;
+			if (outNormals)
+				outNormals[i] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+			for (int k = 0; k < static_cast<int>(mHeightMaps.size()); k++)
+			{
+				const int tileIndex = (lastTileIndex + k) % static_cast<int>(mHeightMaps.size());
+				HeightMap* tile = mHeightMaps[tileIndex];
+				if (tile->FindHeightAndNormalFromPosition(positions[i].x, positions[i].z, outHeights[i], outNormals ? &outNormals[i] : nullptr))
+				{
+					lastTileIndex = tileIndex;
+					break;
+				}
+			}
+		}
+	}
+
 	HeightMap::HeightMap(int width, int height)
 	{
 		mData = new MapData[width * height];
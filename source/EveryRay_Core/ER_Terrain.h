@@ -8,6 +8,7 @@
 #define NUM_TERRAIN_PATCHES_PER_TILE 8
 #define NUM_TEXTURE_SPLAT_CHANNELS 4
 #define MAX_TERRAIN_TILE_COUNT 64
+#define TERRAIN_TILES_PER_CULLING_JOB 8
 
 namespace EveryRay_Core 
 {
@@ -100,7 +101,11 @@ namespace EveryRay_Core
 	public:
 		bool GetHeightFromTriangle(float x, float z, float v0[3], float v1[3], float v2[3], float normal[3], float& height);
 		bool RayIntersectsTriangle(float x, float z, float v0[3], float v1[3], float v2[3], float normals[3], float& height);
-		float FindHeightFromPosition(float x, float z);
+		float FindHeightFromPosition(float x, float z); // -1.0f if the point is outside of the tile
+		bool FindHeightAndNormalFromPosition(float x, float z, float& height, XMFLOAT3* normal = nullptr);
+		void FindHeightsFromPositions(const XMFLOAT4* positions, int positionsCount, float* outHeights, XMFLOAT3* outNormals = nullptr); // batched version (-1.0f for points outside of the tile)
+		bool IsInGrid(float x, float z) const;
+		void BuildGridIndex(int width, int height);
 		bool PerformCPUFrustumCulling(ER_Camera* camera);
 		bool IsCulled() { return mIsCulled; }
 		bool IsColliding(const XMFLOAT4& position, bool onlyXZCheck = false);
@@ -128,6 +133,14 @@ namespace EveryRay_Core
 		int mIndexCountNonTS = 0; //not used in GPU tessellated terrain
 
 		bool mIsCulled = false;
+	private:
+		// Regular grid index of the CPU tile (built in ER_Terrain::CreateTerrainTileDataCPU): vertices of the tile lie on a uniform XZ grid,
+		// so queries find the cell of a point directly and only test its 2 triangles instead of walking the whole tile.
+		std::vector<float> mGridHeights;
+		XMFLOAT2 mGridOrigin = XMFLOAT2(0.0f, 0.0f);
+		float mGridCellSize = 0.0f;
+		int mGridWidth = 0;
+		int mGridHeight = 0;
 	};
 
 	class ER_Terrain : public ER_CoreComponent
@@ -158,6 +171,8 @@ namespace EveryRay_Core
 		void PlaceOnTerrain(ER_RHI_GPUBuffer* outputBuffer, ER_RHI_GPUBuffer* inputBuffer, XMFLOAT4* positions, int positionsCount,
 			TerrainSplatChannels splatChannel = TerrainSplatChannels::NONE,	XMFLOAT4* terrainVertices = nullptr, int terrainVertexCount = 0, float customDampDelta = FLT_MAX);
 		void ReadbackPlacedPositions(ER_RHI_GPUBuffer* outputBuffer, ER_RHI_GPUBuffer* inputBuffer, XMFLOAT4* positions, int positionsCount);
+		// CPU height (and normal) queries for many points at once (-1.0f for points outside of the terrain), see HeightMap::FindHeightsFromPositions()
+		void FindHeightsFromPositions(const XMFLOAT4* positions, int positionsCount, float* outHeights, XMFLOAT3* outNormals = nullptr);
 		//float GetHeightScale(bool tessellated) { if (tessellated) return mTerrainTessellatedHeightScale; else return mTerrainNonTessellatedHeightScale; }
 
 		void SetEnabled(bool val) { mEnabled = val; }
@@ -188,17 +203,17 @@ namespace EveryRay_Core
 		ER_RHI_GPUShader* mHS = nullptr;
 		ER_RHI_GPUShader* mDS = nullptr;
 		ER_RHI_GPUShader* mPS = nullptr;
-		std::string mTerrainMainPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - Main Pass";
+		ER_RHI_PSOHandle mTerrainMainPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - Main Pass";
 
 		ER_RHI_GPUShader* mDS_ShadowMap = nullptr;
 		ER_RHI_GPUShader* mPS_ShadowMap = nullptr;
-		std::string mTerrainShadowPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - Shadow Pass";
+		ER_RHI_PSOHandle mTerrainShadowPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - Shadow Pass";
 
 		ER_RHI_GPUShader* mPS_GBuffer = nullptr;
-		std::string mTerrainGBufferPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - GBuffer Pass";
+		ER_RHI_PSOHandle mTerrainGBufferPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - GBuffer Pass";
 
 		ER_RHI_GPUShader* mPlaceOnTerrainCS = nullptr;
-		std::string mTerrainPlacementPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - Placement Pass";
+		ER_RHI_PSOHandle mTerrainPlacementPassPSOName = "ER_RHI_GPUPipelineStateObject: Terrain - Placement Pass";
 		ER_RHI_GPURootSignature* mTerrainPlacementPassRS = nullptr;
 		ER_RHI_GPURootSignature* mTerrainCommonPassRS = nullptr;
 
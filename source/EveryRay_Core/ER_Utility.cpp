@@ -12,7 +12,10 @@ namespace EveryRay_Core
 	bool ER_Utility::IsLightEditor = false;
 	bool ER_Utility::IsFoliageEditor = false;
 	bool ER_Utility::IsMainCameraCPUFrustumCulling = true;
-	float ER_Utility::DistancesLOD[MAX_LOD] = { 100.0f, 300.0f, 2000.0f };
+	bool ER_Utility::IsInstanceBufferDirtyTracking = true;
+	float ER_Utility::ScreenSizesLOD[MAX_LOD] = { 0.25f, 0.06f, 0.005f };
+	float ER_Utility::LODBias = 1.0f;
+	float ER_Utility::LODHysteresis = 0.1f;
 
 	std::string ER_Utility::CurrentDirectory()
 	{
@@ -135,6 +138,47 @@ namespace EveryRay_Core
 		file.close();
 	}
 
+	bool ER_Utility::SaveBinaryFile(const std::string& filename, const void* data, size_t size)
+	{
+		// several threads can try to save the same file (i.e., same model loaded by different scene objects), so every thread writes its own temporary file
+		std::stringstream tempFilename;
+		tempFilename << filename << "." << std::this_thread::get_id() << ".tmp";
+
+		{
+			std::ofstream file(tempFilename.str().c_str(), std::ios::binary | std::ios::trunc);
+			if (!file.good())
+				return false;
+
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			if (!file.good())
+			{
+				file.close();
+				DeleteFileA(tempFilename.str().c_str());
+				return false;
+			}
+		}
+
+		// fails if the destination is currently mapped by a reader: that is fine, the existing file is still valid
+		if (!MoveFileExA(tempFilename.str().c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			DeleteFileA(tempFilename.str().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	UINT64 ER_Utility::HashData(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		UINT64 hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
 	void ER_Utility::ToWideString(const std::string& source, std::wstring& dest)
 	{
 		dest.assign(source.begin(), source.end());
@@ -20,6 +20,8 @@ namespace EveryRay_Core
 		static void GetDirectory(const std::string& inputPath, std::string& directory);
 		static void GetFileNameAndDirectory(const std::string& inputPath, std::string& directory, std::string& filename);
 		static void LoadBinaryFile(const std::wstring& filename, std::vector<char>& data);
+		static bool SaveBinaryFile(const std::string& filename, const void* data, size_t size); // writes to a temporary file first, so readers never see a partial file
+		static UINT64 HashData(const void* data, size_t size); // FNV-1a, used to detect stale binary caches
 		static void ToWideString(const std::string& source, std::wstring& dest);
 		static std::wstring ToWideString(const std::string& source);
 		static void PathJoin(std::wstring& dest, const std::wstring& sourceDirectory, const std::wstring& sourceFile);
@@ -29,7 +31,10 @@ namespace EveryRay_Core
 		static bool IsLightEditor;
 		static bool IsFoliageEditor;
 		static bool IsMainCameraCPUFrustumCulling;
-		static float DistancesLOD[MAX_LOD];
+		static bool IsInstanceBufferDirtyTracking; // upload only changed ranges of instance buffers (otherwise whole buffers every time)
+		static float ScreenSizesLOD[MAX_LOD]; // default LOD thresholds: projected bounding sphere size (fraction of the screen height) down to which a LOD is used
+		static float LODBias; // global multiplier of the projected sizes (> 1 keeps finer LODs longer)
+		static float LODHysteresis; // relative band around the thresholds that has to be crossed before switching back
 	private:
 		ER_Utility();
 		ER_Utility(const ER_Utility& rhs);
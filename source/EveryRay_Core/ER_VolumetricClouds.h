@@ -94,10 +94,10 @@ namespace EveryRay_Core
 		ER_RHI_GPURootSignature* mUpsampleBlurPassRS = nullptr;
 		ER_RHI_GPURootSignature* mCompositePassRS = nullptr;
 
-		const std::string mMainPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Main";
-		const std::string mCompositePassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Composite";
-		const std::string mBlurPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Blur";
-		const std::string mUpsampleBlurPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Upsample & blur";
+		const ER_RHI_PSOHandle mMainPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Main";
+		const ER_RHI_PSOHandle mCompositePassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Composite";
+		const ER_RHI_PSOHandle mBlurPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Blur";
+		const ER_RHI_PSOHandle mUpsampleBlurPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Clouds - Upsample & blur";
 
 		float mCrispiness = 43.0f;
 		float mCurliness = 1.1f;
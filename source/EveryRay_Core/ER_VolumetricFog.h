@@ -72,13 +72,13 @@ namespace EveryRay_Core
 		ER_RHI_GPURootSignature* mCompositePassRootSignature = nullptr;
 
 		ER_RHI_GPUShader* mInjectionCS = nullptr;
-		std::string mInjectionPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Fog - Injection";
+		ER_RHI_PSOHandle mInjectionPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Fog - Injection";
 
 		ER_RHI_GPUShader* mAccumulationCS = nullptr;
-		std::string mAccumulationPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Fog - Accumulation";
+		ER_RHI_PSOHandle mAccumulationPassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Fog - Accumulation";
 
 		ER_RHI_GPUShader* mCompositePS = nullptr;
-		std::string mCompositePassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Fog - Composite";
+		ER_RHI_PSOHandle mCompositePassPSOName = "ER_RHI_GPUPipelineStateObject: Volumetric Fog - Composite";
 
 		XMMATRIX mPrevViewProj;
 
@@ -0,0 +1,289 @@
+#include "stdafx.h"
+
+#include "ER_VoxelClipmap.h"
+
+namespace EveryRay_Core
+{
+	static bool IsRegionEmpty(const ER_VoxelRegion& aRegion)
+	{
+		return aRegion.Min.x >= aRegion.Max.x || aRegion.Min.y >= aRegion.Max.y || aRegion.Min.z >= aRegion.Max.z;
+	}
+
+	static bool IsRegionInside(const ER_VoxelRegion& aInner, const ER_VoxelRegion& aOuter)
+	{
+		return
+			aInner.Min.x >= aOuter.Min.x && aInner.Min.y >= aOuter.Min.y && aInner.Min.z >= aOuter.Min.z &&
+			aInner.Max.x <= aOuter.Max.x && aInner.Max.y <= aOuter.Max.y && aInner.Max.z <= aOuter.Max.z;
+	}
+
+	static UINT64 GetRegionVoxelsCount(const ER_VoxelRegion& aRegion)
+	{
+		return static_cast<UINT64>(aRegion.Max.x - aRegion.Min.x) * (aRegion.Max.y - aRegion.Min.y) * (aRegion.Max.z - aRegion.Min.z);
+	}
+
+	void ER_VoxelClipmap::Initialize(UINT aResolution, float aVoxelsPerUnit)
+	{
+		assert(aResolution > 0 && aResolution % 2 == 0 && "ER_VoxelClipmap: resolution must be a multiple of 2");
+		assert(aVoxelsPerUnit > 0.0f && "ER_VoxelClipmap: voxels per unit must be positive");
+
+		mResolution = aResolution;
+		mVoxelsPerUnit = aVoxelsPerUnit;
+		MarkAllDirty();
+	}
+
+	void ER_VoxelClipmap::Scroll(const XMFLOAT3& aCenter)
+	{
+		assert(IsInitialized());
+
+		const float invStep = mVoxelsPerUnit / static_cast<float>(ER_VOXEL_CLIPMAP_SCROLL_STEP);
+		const int halfResolution = static_cast<int>(mResolution / 2);
+		auto getOrigin = [&](float aValue) { return static_cast<int>(floorf(aValue * invStep + 0.5f)) * ER_VOXEL_CLIPMAP_SCROLL_STEP - halfResolution; };
+
+		const XMINT3 origin(getOrigin(aCenter.x), getOrigin(aCenter.y), getOrigin(aCenter.z));
+		const XMINT3 offset(origin.x - mOrigin.x, origin.y - mOrigin.y, origin.z - mOrigin.z);
+		if (offset.x == 0 && offset.y == 0 && offset.z == 0)
+			return;
+
+		mOrigin = origin;
+		if (mIsAllDirty)
+			return;
+
+		const int resolution = static_cast<int>(mResolution);
+		mScrollOffset = XMINT3(mScrollOffset.x + offset.x, mScrollOffset.y + offset.y, mScrollOffset.z + offset.z);
+		if (abs(mScrollOffset.x) >= resolution || abs(mScrollOffset.y) >= resolution || abs(mScrollOffset.z) >= resolution)
+		{
+			MarkAllDirty();
+			return;
+		}
+
+		// dirty regions that are still to be updated move with the content
+		std::vector<ER_VoxelRegion> oldRegions;
+		oldRegions.swap(mDirtyRegions);
+		for (const ER_VoxelRegion& region : oldRegions)
+		{
+			AddDirtyRegion({
+				XMINT3(region.Min.x - offset.x, region.Min.y - offset.y, region.Min.z - offset.z),
+				XMINT3(region.Max.x - offset.x, region.Max.y - offset.y, region.Max.z - offset.z) });
+		}
+
+		// newly exposed slabs
+		const int offsets[3] = { offset.x, offset.y, offset.z };
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (offsets[axis] == 0)
+				continue;
+
+			int slabMin[3] = { 0, 0, 0 };
+			int slabMax[3] = { resolution, resolution, resolution };
+			if (offsets[axis] > 0)
+				slabMin[axis] = resolution - offsets[axis];
+			else
+				slabMax[axis] = -offsets[axis];
+			AddDirtyRegion({ XMINT3(slabMin[0], slabMin[1], slabMin[2]), XMINT3(slabMax[0], slabMax[1], slabMax[2]) });
+		}
+	}
+
+	void ER_VoxelClipmap::MarkDirty(const ER_AABB& aBounds)
+	{
+		assert(IsInitialized());
+		if (mIsAllDirty)
+			return;
+
+		// one extra voxel on each side: voxelization rounds the positions of the triangles
+		auto getMin = [&](float aValue, int aOrigin) { return static_cast<int>(floorf(aValue * mVoxelsPerUnit)) - aOrigin - 1; };
+		auto getMax = [&](float aValue, int aOrigin) { return static_cast<int>(floorf(aValue * mVoxelsPerUnit)) - aOrigin + 2; };
+
+		// bounds far away from the cascade would overflow the voxel coordinates
+		const ER_AABB bounds = GetBounds();
+		if (aBounds.second.x < bounds.first.x || aBounds.second.y < bounds.first.y || aBounds.second.z < bounds.first.z ||
+			aBounds.first.x > bounds.second.x || aBounds.first.y > bounds.second.y || aBounds.first.z > bounds.second.z)
+			return;
+
+		const XMFLOAT3 minBounds(std::max(aBounds.first.x, bounds.first.x), std::max(aBounds.first.y, bounds.first.y), std::max(aBounds.first.z, bounds.first.z));
+		const XMFLOAT3 maxBounds(std::min(aBounds.second.x, bounds.second.x), std::min(aBounds.second.y, bounds.second.y), std::min(aBounds.second.z, bounds.second.z));
+		AddDirtyRegion({
+			XMINT3(getMin(minBounds.x, mOrigin.x), getMin(minBounds.y, mOrigin.y), getMin(minBounds.z, mOrigin.z)),
+			XMINT3(getMax(maxBounds.x, mOrigin.x), getMax(maxBounds.y, mOrigin.y), getMax(maxBounds.z, mOrigin.z)) });
+	}
+
+	void ER_VoxelClipmap::MarkShadowDirty(const ER_AABB& aBounds, const XMFLOAT3& aLightDirection)
+	{
+		// voxels are lit with the sun's shadow map, so an object also changes the voxels behind it: its bounds are swept far enough
+		// to leave the cascade (the sweep's box is conservative, MarkDirty() clips it)
+		const float length = sqrtf(aLightDirection.x * aLightDirection.x + aLightDirection.y * aLightDirection.y + aLightDirection.z * aLightDirection.z);
+		if (length <= 0.0f)
+		{
+			MarkDirty(aBounds);
+			return;
+		}
+
+		const float distance = 1.7320508f * static_cast<float>(mResolution) / mVoxelsPerUnit / length; // cascade's diagonal
+		const XMFLOAT3 sweep(aLightDirection.x * distance, aLightDirection.y * distance, aLightDirection.z * distance);
+		MarkDirty(ER_AABB(
+			XMFLOAT3(std::min(aBounds.first.x, aBounds.first.x + sweep.x), std::min(aBounds.first.y, aBounds.first.y + sweep.y), std::min(aBounds.first.z, aBounds.first.z + sweep.z)),
+			XMFLOAT3(std::max(aBounds.second.x, aBounds.second.x + sweep.x), std::max(aBounds.second.y, aBounds.second.y + sweep.y), std::max(aBounds.second.z, aBounds.second.z + sweep.z))));
+	}
+
+	void ER_VoxelClipmap::MarkAllDirty()
+	{
+		mIsAllDirty = true;
+		mDirtyRegions.clear();
+		mScrollOffset = XMINT3(0, 0, 0); // nothing to keep, so nothing to scroll
+	}
+
+	void ER_VoxelClipmap::ClearDirty()
+	{
+		mIsAllDirty = false;
+		mDirtyRegions.clear();
+		mScrollOffset = XMINT3(0, 0, 0);
+	}
+
+	ER_VoxelClipmapStats ER_VoxelClipmap::GetStats() const
+	{
+		ER_VoxelClipmapStats stats;
+		stats.IsAllDirty = mIsAllDirty;
+		if (mIsAllDirty)
+		{
+			stats.DirtyRegionsCount = 1;
+			stats.DirtyVoxelsCount = static_cast<UINT64>(mResolution) * mResolution * mResolution;
+			return stats;
+		}
+
+		stats.DirtyRegionsCount = static_cast<UINT>(mDirtyRegions.size());
+		for (const ER_VoxelRegion& region : mDirtyRegions)
+			stats.DirtyVoxelsCount += GetRegionVoxelsCount(region);
+		return stats;
+	}
+
+	void ER_VoxelClipmap::GetTexelRegion(const ER_VoxelRegion& aRegion, XMINT4& aOutMin, XMINT4& aOutMax) const
+	{
+		const int resolution = static_cast<int>(mResolution);
+		aOutMin = XMINT4(aRegion.Min.x, resolution - aRegion.Max.y, aRegion.Min.z, 0);
+		aOutMax = XMINT4(aRegion.Max.x, resolution - aRegion.Min.y, aRegion.Max.z, 0);
+	}
+
+	XMFLOAT3 ER_VoxelClipmap::GetCenter() const
+	{
+		const float halfResolution = static_cast<float>(mResolution / 2);
+		return XMFLOAT3(
+			(static_cast<float>(mOrigin.x) + halfResolution) / mVoxelsPerUnit,
+			(static_cast<float>(mOrigin.y) + halfResolution) / mVoxelsPerUnit,
+			(static_cast<float>(mOrigin.z) + halfResolution) / mVoxelsPerUnit);
+	}
+
+	ER_AABB ER_VoxelClipmap::GetBounds() const
+	{
+		const int resolution = static_cast<int>(mResolution);
+		return GetRegionBounds({ XMINT3(0, 0, 0), XMINT3(resolution, resolution, resolution) });
+	}
+
+	ER_AABB ER_VoxelClipmap::GetRegionBounds(const ER_VoxelRegion& aRegion) const
+	{
+		const float invVoxelsPerUnit = 1.0f / mVoxelsPerUnit;
+		return ER_AABB(
+			XMFLOAT3(
+				static_cast<float>(mOrigin.x + aRegion.Min.x) * invVoxelsPerUnit,
+				static_cast<float>(mOrigin.y + aRegion.Min.y) * invVoxelsPerUnit,
+				static_cast<float>(mOrigin.z + aRegion.Min.z) * invVoxelsPerUnit),
+			XMFLOAT3(
+				static_cast<float>(mOrigin.x + aRegion.Max.x) * invVoxelsPerUnit,
+				static_cast<float>(mOrigin.y + aRegion.Max.y) * invVoxelsPerUnit,
+				static_cast<float>(mOrigin.z + aRegion.Max.z) * invVoxelsPerUnit));
+	}
+
+	void ER_VoxelClipmap::AddDirtyRegion(const ER_VoxelRegion& aRegion)
+	{
+		if (mIsAllDirty)
+			return;
+
+		const int resolution = static_cast<int>(mResolution);
+		const ER_VoxelRegion allRegion = { XMINT3(0, 0, 0), XMINT3(resolution, resolution, resolution) };
+		ER_VoxelRegion region = {
+			XMINT3(std::max(aRegion.Min.x, 0), std::max(aRegion.Min.y, 0), std::max(aRegion.Min.z, 0)),
+			XMINT3(std::min(aRegion.Max.x, resolution), std::min(aRegion.Max.y, resolution), std::min(aRegion.Max.z, resolution)) };
+		if (IsRegionEmpty(region))
+			return;
+
+		for (const ER_VoxelRegion& dirtyRegion : mDirtyRegions)
+		{
+			if (IsRegionInside(region, dirtyRegion))
+				return;
+		}
+		mDirtyRegions.erase(std::remove_if(mDirtyRegions.begin(), mDirtyRegions.end(),
+			[&](const ER_VoxelRegion& dirtyRegion) { return IsRegionInside(dirtyRegion, region); }), mDirtyRegions.end());
+
+		// GPU passes take a fixed amount of regions, so merge all of them into one box when there are too many
+		if (mDirtyRegions.size() == ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS)
+		{
+			for (const ER_VoxelRegion& dirtyRegion : mDirtyRegions)
+			{
+				region.Min = XMINT3(std::min(region.Min.x, dirtyRegion.Min.x), std::min(region.Min.y, dirtyRegion.Min.y), std::min(region.Min.z, dirtyRegion.Min.z));
+				region.Max = XMINT3(std::max(region.Max.x, dirtyRegion.Max.x), std::max(region.Max.y, dirtyRegion.Max.y), std::max(region.Max.z, dirtyRegion.Max.z));
+			}
+			mDirtyRegions.clear();
+		}
+
+		if (IsRegionInside(allRegion, region))
+			MarkAllDirty();
+		else
+			mDirtyRegions.push_back(region);
+	}
+
+	void ER_VoxelObjectsTracker::BeginFrame()
+	{
+		mFrame++;
+		mDirtyBounds.clear();
+	}
+
+	bool ER_VoxelObjectsTracker::UpdateObject(const void* aObject, const ER_AABB* aItemsBounds, UINT aItemsCount)
+	{
+		assert(aObject);
+		assert(aItemsBounds || aItemsCount == 0);
+
+		auto result = mObjects.emplace(aObject, ObjectState());
+		ObjectState& state = result.first->second;
+		state.LastFrame = mFrame;
+
+		if (!result.second && state.ItemsBounds.size() == aItemsCount)
+		{
+			bool isChanged = false;
+			for (UINT i = 0; i < aItemsCount; i++)
+			{
+				if (memcmp(&state.ItemsBounds[i], &aItemsBounds[i], sizeof(ER_AABB)) == 0)
+					continue;
+
+				mDirtyBounds.push_back(state.ItemsBounds[i]);
+				mDirtyBounds.push_back(aItemsBounds[i]);
+				state.ItemsBounds[i] = aItemsBounds[i];
+				isChanged = true;
+			}
+			return isChanged;
+		}
+
+		// new object or its instances have changed
+		mDirtyBounds.insert(mDirtyBounds.end(), state.ItemsBounds.begin(), state.ItemsBounds.end());
+		mDirtyBounds.insert(mDirtyBounds.end(), aItemsBounds, aItemsBounds + aItemsCount);
+		state.ItemsBounds.assign(aItemsBounds, aItemsBounds + aItemsCount);
+		return true;
+	}
+
+	void ER_VoxelObjectsTracker::EndFrame()
+	{
+		for (auto it = mObjects.begin(); it != mObjects.end();)
+		{
+			if (it->second.LastFrame != mFrame)
+			{
+				mDirtyBounds.insert(mDirtyBounds.end(), it->second.ItemsBounds.begin(), it->second.ItemsBounds.end());
+				it = mObjects.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	void ER_VoxelObjectsTracker::Clear()
+	{
+		mObjects.clear();
+		mDirtyBounds.clear();
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Common.h"
+
+#define ER_VOXEL_CLIPMAP_SCROLL_STEP 4 // in voxels: the cascade follows the camera in steps of that many voxels
+#define ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS 8 // same as MAX_DIRTY_REGIONS in Voxelization.hlsl and VoxelConeTracingUpdateCascade.hlsl
+
+namespace EveryRay_Core
+{
+	// box of voxels relative to the cascade's origin (y is up), [Min; Max)
+	struct ER_VoxelRegion
+	{
+		XMINT3 Min;
+		XMINT3 Max;
+	};
+
+	struct ER_VoxelClipmapStats
+	{
+		UINT DirtyRegionsCount = 0;
+		UINT64 DirtyVoxelsCount = 0; // upper bound (regions can overlap)
+		bool IsAllDirty = false;
+	};
+
+	// CPU side of a voxel cascade (no RHI): keeps the cascade on a world space grid of voxels and tracks which of its voxels are no longer valid.
+	// When the camera moves, the cascade is scrolled (its content is moved by GetScrollOffset() voxels) and only the newly exposed slabs
+	// become dirty. Moved objects mark their old and new bounds (and the voxels they shadow) dirty. Everything else keeps its voxels from the previous frames.
+	class ER_VoxelClipmap
+	{
+	public:
+		ER_VoxelClipmap() {}
+		~ER_VoxelClipmap() {}
+
+		void Initialize(UINT aResolution, float aVoxelsPerUnit); // the whole cascade is dirty after that
+		bool IsInitialized() const { return mResolution > 0; }
+
+		void Scroll(const XMFLOAT3& aCenter); // center is snapped to ER_VOXEL_CLIPMAP_SCROLL_STEP voxels
+		void MarkDirty(const ER_AABB& aBounds); // world space, clipped to the cascade
+		void MarkShadowDirty(const ER_AABB& aBounds, const XMFLOAT3& aLightDirection); // MarkDirty() of the bounds swept along the light's direction through the cascade
+		void MarkAllDirty();
+		void ClearDirty(); // call after the cascade has been updated on GPU
+
+		bool IsDirty() const { return mIsAllDirty || !mDirtyRegions.empty() || mScrollOffset.x != 0 || mScrollOffset.y != 0 || mScrollOffset.z != 0; }
+		bool IsAllDirty() const { return mIsAllDirty; }
+		const std::vector<ER_VoxelRegion>& GetDirtyRegions() const { return mDirtyRegions; }
+		const XMINT3& GetScrollOffset() const { return mScrollOffset; } // voxel "v" of the scrolled cascade is voxel "v + offset" of the old one
+		ER_VoxelClipmapStats GetStats() const;
+
+		// Texture space of Voxelization.hlsl (y goes down): [aOutMin; aOutMax) texels of the region, and the scroll offset in texels
+		void GetTexelRegion(const ER_VoxelRegion& aRegion, XMINT4& aOutMin, XMINT4& aOutMax) const;
+		XMINT3 GetTexelScrollOffset() const { return XMINT3(mScrollOffset.x, -mScrollOffset.y, mScrollOffset.z); }
+
+		UINT GetResolution() const { return mResolution; }
+		float GetVoxelsPerUnit() const { return mVoxelsPerUnit; }
+		XMFLOAT3 GetCenter() const;
+		ER_AABB GetBounds() const;
+		ER_AABB GetRegionBounds(const ER_VoxelRegion& aRegion) const;
+	private:
+		void AddDirtyRegion(const ER_VoxelRegion& aRegion);
+
+		std::vector<ER_VoxelRegion> mDirtyRegions;
+		XMINT3 mOrigin = XMINT3(0, 0, 0); // world space voxel of the cascade's min corner
+		XMINT3 mScrollOffset = XMINT3(0, 0, 0);
+		UINT mResolution = 0;
+		float mVoxelsPerUnit = 1.0f;
+		bool mIsAllDirty = true;
+	};
+
+	// Remembers the world space bounds of the voxelized objects (and of their instances) to find the ones that have moved,
+	// appeared or disappeared since the last frame: their old and new bounds need to be re-voxelized.
+	class ER_VoxelObjectsTracker
+	{
+	public:
+		ER_VoxelObjectsTracker() {}
+		~ER_VoxelObjectsTracker() {}
+
+		void BeginFrame(); // clears the dirty bounds
+		// returns true if the object is new or its bounds have changed
+		bool UpdateObject(const void* aObject, const ER_AABB* aItemsBounds, UINT aItemsCount);
+		void EndFrame(); // objects that were not updated since BeginFrame() are removed (their old bounds become dirty)
+		void Clear();
+
+		const std::vector<ER_AABB>& GetDirtyBounds() const { return mDirtyBounds; }
+		UINT GetObjectsCount() const { return static_cast<UINT>(mObjects.size()); }
+	private:
+		struct ObjectState
+		{
+			std::vector<ER_AABB> ItemsBounds;
+			UINT64 LastFrame = 0;
+		};
+		std::unordered_map<const void*, ObjectState> mObjects;
+		std::vector<ER_AABB> mDirtyBounds;
+		UINT64 mFrame = 0;
+	};
+}
@@ -63,7 +63,7 @@ namespace EveryRay_Core
 	}
 
 	void ER_VoxelizationMaterial::PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, 
-		float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, ER_RHI_GPURootSignature* rs)
+		float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, ER_RHI_GPURootSignature* rs, const ER_VoxelClipmap* clipmap)
 	{
 		auto rhi = ER_Material::GetCore()->GetRHI();
 		ER_Camera* camera = (ER_Camera*)(ER_Material::GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
@@ -82,6 +82,16 @@ namespace EveryRay_Core
 		mConstantBuffer.Data.VoxelCameraPos = voxelCameraPos;
 		mConstantBuffer.Data.VoxelTextureDimension = voxelTexSize;
 		mConstantBuffer.Data.WorldVoxelScale = voxelScale;
+		mConstantBuffer.Data.DirtyRegionsCount = 0;
+		mConstantBuffer.Data.pad0 = 0.0f;
+		if (clipmap && !clipmap->IsAllDirty()) // only write the voxels of the dirty regions
+		{
+			const std::vector<ER_VoxelRegion>& regions = clipmap->GetDirtyRegions();
+			assert(regions.size() <= ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS);
+			for (size_t i = 0; i < regions.size(); i++)
+				clipmap->GetTexelRegion(regions[i], mConstantBuffer.Data.DirtyRegionsMin[i], mConstantBuffer.Data.DirtyRegionsMax[i]);
+			mConstantBuffer.Data.DirtyRegionsCount = static_cast<UINT>(regions.size());
+		}
 		mConstantBuffer.ApplyChanges(rhi);
 		rhi->SetConstantBuffers(ER_VERTEX, { mConstantBuffer.Buffer() }, 0, rs, VOXELIZATION_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 		rhi->SetConstantBuffers(ER_GEOMETRY, { mConstantBuffer.Buffer() }, 0, rs, VOXELIZATION_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
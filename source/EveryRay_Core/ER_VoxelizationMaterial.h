@@ -1,5 +1,6 @@
 #pragma once
 #include "ER_Material.h"
+#include "ER_VoxelClipmap.h"
 
 #define VOXELIZATION_MAT_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define VOXELIZATION_MAT_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
@@ -22,6 +23,10 @@ namespace EveryRay_Core
 			XMFLOAT4 VoxelCameraPos;
 			float VoxelTextureDimension;
 			float WorldVoxelScale;
+			UINT DirtyRegionsCount; // 0 - whole cascade
+			float pad0;
+			XMINT4 DirtyRegionsMin[ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS];
+			XMINT4 DirtyRegionsMax[ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS];
 		};
 	}
 	class ER_VoxelizationMaterial : public ER_Material
@@ -31,7 +36,7 @@ namespace EveryRay_Core
 		~ER_VoxelizationMaterial();
 
 		void PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, 
-			float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, ER_RHI_GPURootSignature* rs);
+			float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, ER_RHI_GPURootSignature* rs, const ER_VoxelClipmap* clipmap = nullptr);
 		virtual void PrepareResourcesForStandardMaterial(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs) override;
 		virtual void CreateVertexBuffer(const ER_Mesh& mesh, ER_RHI_GPUBuffer* vertexBuffer) override;
 		virtual int VertexSize() override;
@@ -4,8 +4,7 @@
 #include "ER_RHI_DX11_GPUShader.h"
 #include "..\..\ER_CoreException.h"
 #include "..\..\ER_Utility.h"
-
-#include "DirectXSH.h"
+#include "..\..\ER_SphericalHarmonics.h"
 
 #define DX11_MAX_BOUND_RENDER_TARGETS_VIEWS 8
 #define DX11_MAX_BOUND_SHADER_RESOURCE_VIEWS 64 
@@ -460,7 +459,34 @@ namespace EveryRay_Core
 		ER_RHI_DX11_GPUTexture* tex = static_cast<ER_RHI_DX11_GPUTexture*>(aTexture);
 		assert(tex);
 
-		return !(FAILED(DirectX::SHProjectCubeMap(mDirect3DDeviceContext, order, tex->GetTexture2D(), resultR, resultG, resultB)));
+		if (order != ER_SH_BANDS_COUNT)
+			return false;
+
+		// readback + CPU projection (ER_SphericalHarmonics), texels are converted to float RGBA first
+		DirectX::ScratchImage capturedImage;
+		if (FAILED(DirectX::CaptureTexture(mDirect3DDevice, mDirect3DDeviceContext, tex->GetTexture2D(), capturedImage)))
+			return false;
+
+		const DirectX::TexMetadata& metadata = capturedImage.GetMetadata();
+		if (!metadata.IsCubemap() || metadata.arraySize != ER_SH_CUBEMAP_FACES_COUNT || metadata.width != metadata.height)
+			return false;
+
+		DirectX::ScratchImage floatImage;
+		const DirectX::ScratchImage* image = &capturedImage;
+		if (metadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+		{
+			if (FAILED(DirectX::Convert(capturedImage.GetImages(), capturedImage.GetImageCount(), metadata, DXGI_FORMAT_R32G32B32A32_FLOAT, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, floatImage)))
+				return false;
+			image = &floatImage;
+		}
+
+		const XMFLOAT4* faces[ER_SH_CUBEMAP_FACES_COUNT];
+		for (int face = 0; face < ER_SH_CUBEMAP_FACES_COUNT; face++)
+			faces[face] = reinterpret_cast<const XMFLOAT4*>(image->GetImage(0, face, 0)->pixels);
+
+		ER_SphericalHarmonics sh = ER_SphericalHarmonics::ProjectCubemap(faces, static_cast<UINT>(metadata.width), image->GetImage(0, 0, 0)->rowPitch);
+		sh.Get(resultR, resultG, resultB);
+		return true;
 	}
 
 	void ER_RHI_DX11::SaveGPUTextureToFile(ER_RHI_GPUTexture* aTexture, const std::wstring& aPathName)
@@ -490,7 +516,7 @@ namespace EveryRay_Core
 		mDirect3DDeviceContext->OMSetRenderTargets(1, &mMainRenderTargetView, NULL);
 	}
 
-	void ER_RHI_DX11::SetRenderTargets(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/, ER_RHI_GPUTexture* aUAV /*= nullptr*/, int rtvArrayIndex)
+	void ER_RHI_DX11::SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/, ER_RHI_GPUTexture* aUAV /*= nullptr*/, int rtvArrayIndex)
 	{
 		if (!aUAV)
 		{
@@ -613,7 +639,7 @@ namespace EveryRay_Core
 		mDirect3DDeviceContext->RSSetScissorRects(1, &currentRect);
 	}
 
-	void ER_RHI_DX11::SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aSRVs, UINT startSlot,
+	void ER_RHI_DX11::SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot,
 		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS, bool skipAutomaticTransition)
 	{
 		assert(aSRVs.size() > 0);
@@ -655,7 +681,7 @@ namespace EveryRay_Core
 		}
 	}
 
-	void ER_RHI_DX11::SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aUAVs, UINT startSlot,
+	void ER_RHI_DX11::SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot,
 		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS, bool skipAutomaticTransition)
 	{
 		assert(aUAVs.size() > 0);
@@ -691,7 +717,7 @@ namespace EveryRay_Core
 		}
 	}
 
-	void ER_RHI_DX11::SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUBuffer*>& aCBs, UINT startSlot,
+	void ER_RHI_DX11::SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot,
 		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS)
 	{
 		assert(aCBs.size() > 0);
@@ -780,7 +806,7 @@ namespace EveryRay_Core
 		}
 	}
 
-	void ER_RHI_DX11::SetSamplers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_SAMPLER_STATE>& aSamplers, UINT startSlot, ER_RHI_GPURootSignature* rs)
+	void ER_RHI_DX11::SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot, ER_RHI_GPURootSignature* rs)
 	{
 		assert(aSamplers.size() > 0);
 		assert(aSamplers.size() <= DX11_MAX_BOUND_SAMPLERS);
@@ -840,7 +866,7 @@ namespace EveryRay_Core
 		mDirect3DDeviceContext->IASetIndexBuffer(buf, GetFormat(aBuffer->GetFormatRhi()), offset);
 	}
 
-	void ER_RHI_DX11::SetVertexBuffers(const std::vector<ER_RHI_GPUBuffer*>& aVertexBuffers)
+	void ER_RHI_DX11::SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers)
 	{
 		assert(aVertexBuffers.size() > 0 && aVertexBuffers.size() <= ER_RHI_MAX_BOUND_VERTEX_BUFFERS);
 		if (aVertexBuffers.size() == 1)
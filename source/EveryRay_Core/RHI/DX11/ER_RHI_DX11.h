@@ -86,9 +86,9 @@ namespace EveryRay_Core
 		virtual void SaveGPUTextureToFile(ER_RHI_GPUTexture* aTexture, const std::wstring& aPathName) override;
 
 		virtual void SetMainRenderTargets(int cmdListIndex = 0) override;
-		virtual void SetRenderTargets(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) override;
+		virtual void SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) override;
 		virtual void SetDepthTarget(ER_RHI_GPUTexture* aDepthTarget) override;
-		virtual void SetRenderTargetFormats(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) override {}; //not supported on DX11
+		virtual void SetRenderTargetFormats(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) override {}; //not supported on DX11
 		virtual void SetMainRenderTargetFormats() override {}; //not supported on DX11
 
 		virtual void SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE aDS, UINT stencilRef = 0xffffffff) override;
@@ -98,13 +98,13 @@ namespace EveryRay_Core
 		virtual void SetViewport(const ER_RHI_Viewport& aViewport) override;
 		virtual void SetRect(const ER_RHI_Rect& rect) override;
 
-		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aSRVs, UINT startSlot = 0,
+		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) override;
-		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aUAVs, UINT startSlot = 0,
+		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) override;
-		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUBuffer*>& aCBs, UINT startSlot = 0,
+		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false) override;
-		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_SAMPLER_STATE>& aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) override;
+		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) override;
 		
 		virtual void SetRootSignature(ER_RHI_GPURootSignature* rs, bool isCompute = false) override {}; //not supported on DX11
 		virtual void SetRootConstant(UINT aConstant, UINT aRootIndex, UINT anOffset = 0, bool isCompute = false) override {}; //not supported on DX11
@@ -113,7 +113,7 @@ namespace EveryRay_Core
 		virtual void SetInputLayout(ER_RHI_InputLayout* aIL) override;
 		virtual void SetEmptyInputLayout() override;
 		virtual void SetIndexBuffer(ER_RHI_GPUBuffer* aBuffer, UINT offset = 0) override;
-		virtual void SetVertexBuffers(const std::vector<ER_RHI_GPUBuffer*>& aVertexBuffers) override;
+		virtual void SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers) override;
 
 		virtual void SetTopologyType(ER_RHI_PRIMITIVE_TYPE aType) override;
 		virtual ER_RHI_PRIMITIVE_TYPE GetCurrentTopologyType() override;
@@ -121,16 +121,16 @@ namespace EveryRay_Core
 		virtual void SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE aType, bool aReset) override {}; //not supported on DX11
 		virtual void SetGPUDescriptorHeapImGui(int cmdListIndex) override {}; //not supported on DX11
 
-		virtual void TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, const std::vector<ER_RHI_RESOURCE_STATE>& aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override {}; //not supported on DX11
-		virtual void TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override {}; //not supported on DX11
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE> aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override {}; //not supported on DX11
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override {}; //not supported on DX11
 		virtual void TransitionMainRenderTargetToPresent(int cmdListIndex = 0) override {}; //not supported on DX11
 
-		virtual bool IsPSOReady(const std::string& aName, bool isCompute = false) override { return false; } //not supported on DX11
-		virtual void InitializePSO(const std::string& aName, bool isCompute = false) override {}; //not supported on DX11
-		virtual void SetRootSignatureToPSO(const std::string& aName, ER_RHI_GPURootSignature* rs, bool isCompute = false) override {}; //not supported on DX11
-		virtual void SetTopologyTypeToPSO(const std::string& aName, ER_RHI_PRIMITIVE_TYPE aType) override {}; //not supported on DX11
-		virtual void FinalizePSO(const std::string& aName, bool isCompute = false) override {}; //not supported on DX11
-		virtual void SetPSO(const std::string& aName, bool isCompute = false) override {}; //not supported on DX11
+		virtual bool IsPSOReady(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override { return false; } //not supported on DX11
+		virtual void InitializePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override {}; //not supported on DX11
+		virtual void SetRootSignatureToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_GPURootSignature* rs, bool isCompute = false) override {}; //not supported on DX11
+		virtual void SetTopologyTypeToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_PRIMITIVE_TYPE aType) override {}; //not supported on DX11
+		virtual void FinalizePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override {}; //not supported on DX11
+		virtual void SetPSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override {}; //not supported on DX11
 		virtual void UnsetPSO()override {}; //not supported on DX11
 
 		virtual void UnbindRenderTargets() override;
@@ -411,6 +411,39 @@ namespace EveryRay_Core
 		resourceTex->Release();
 	}
 
+	void ER_RHI_DX11_GPUTexture::CreateGPUTextureResourceFromMemory(ER_RHI* aRHI, const void* aData, size_t aSize, bool* statusFlag)
+	{
+		assert(aRHI);
+		assert(aData && aSize > 0);
+		ER_RHI_DX11* aRHIDX11 = static_cast<ER_RHI_DX11*>(aRHI);
+		ID3D11Device* device = aRHIDX11->GetDevice();
+		assert(device);
+		ID3D11DeviceContext1* context = aRHIDX11->GetContext();
+		assert(context);
+
+		mIsLoadedFromFile = true;
+		if (statusFlag)
+			*statusFlag = false;
+
+		ID3D11Resource* resourceTex = NULL;
+		if (FAILED(DirectX::CreateDDSTextureFromMemory(device, context, static_cast<const uint8_t*>(aData), aSize, &resourceTex, &mSRV)))
+		{
+			ER_OUTPUT_LOG(L"[ER Logger][ER_RHI_DX11_GPUTexture] Failed to load DDS texture from memory. \n");
+			return;
+		}
+
+		if (FAILED(resourceTex->QueryInterface(IID_ID3D11Texture2D, (void**)&mTexture2D)))
+		{
+			resourceTex->Release();
+			throw EveryRay_Core::ER_CoreException("ER_RHI_DX11: Could not cast loaded texture resource to Texture2D. Maybe wrong dimension?");
+		}
+
+		if (statusFlag)
+			*statusFlag = true;
+
+		resourceTex->Release();
+	}
+
 	void ER_RHI_DX11_GPUTexture::LoadFallbackTexture(ER_RHI* aRHI, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView)
 	{
 		assert(aRHI);
@@ -8,6 +8,7 @@
 
 #include "..\..\ER_CoreException.h"
 #include "..\..\ER_Utility.h"
+#include "..\..\ER_SphericalHarmonics.h"
 
 namespace EveryRay_Core
 {
@@ -446,6 +447,7 @@ namespace EveryRay_Core
 			std::string message = "ER_RHI_DX12:: Could not Reset() command list (graphics) " + std::to_string(index);
 			throw ER_CoreException(message.c_str());
 		}
+		mCurrentSetPipelineState = nullptr; // Reset() clears the pipeline state of the command list
 	}
 
 	void ER_RHI_DX12::EndGraphicsCommandList(int index)
@@ -536,7 +538,7 @@ namespace EveryRay_Core
 		#pragma region SHADER_CLEAR
 		auto cmdList = mCommandListGraphics[mCurrentGraphicsCommandListIndex];
 
-		const std::string& psoName = is3D ? mClearUAV3DPSOName : mClearUAV2DPSOName;
+		const ER_RHI_PSOHandle& psoName = is3D ? mClearUAV3DPSOName : mClearUAV2DPSOName;
 		ER_RHI_GPURootSignature* rs = is3D ? mClearUAV3DRS : mClearUAV2DRS;
 
 		SetRootSignature(rs, true);
@@ -824,7 +826,7 @@ namespace EveryRay_Core
 
 		auto cmdList = mCommandListGraphics[mCurrentGraphicsCommandListIndex];
 
-		const std::string& psoName = is3D ? mGenerateMips3DPSOName : mGenerateMips2DPSOName;
+		const ER_RHI_PSOHandle& psoName = is3D ? mGenerateMips3DPSOName : mGenerateMips2DPSOName;
 		ER_RHI_GPURootSignature* rs = is3D ? mGenerateMips3DRS : mGenerateMips2DRS;
 
 		SetRootSignature(rs, true);
@@ -979,10 +981,92 @@ namespace EveryRay_Core
 		//mFenceValuesCompute++;
 	}
 
+	// Mip 0 of every face is copied to a readback buffer in the current graphics command list, which is then executed and waited for (and reopened):
+	// this stalls the GPU, so it is only meant for baking (like the readback on DX11)
 	bool ER_RHI_DX12::ProjectCubemapToSH(ER_RHI_GPUTexture* aTexture, UINT order, float* resultR, float* resultG, float* resultB)
 	{
-		//TODO
-		return false;
+		assert(aTexture);
+		assert(mCurrentGraphicsCommandListIndex > -1);
+
+		if (order != ER_SH_BANDS_COUNT)
+			return false;
+
+		ID3D12Resource* resource = static_cast<ID3D12Resource*>(aTexture->GetResource());
+		assert(resource);
+		const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+		if (desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || desc.DepthOrArraySize != ER_SH_CUBEMAP_FACES_COUNT || desc.Width != desc.Height)
+			return false;
+
+		const UINT subresourcesCount = desc.MipLevels * ER_SH_CUBEMAP_FACES_COUNT;
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(subresourcesCount);
+		UINT64 readbackSize = 0;
+		mDevice->GetCopyableFootprints(&desc, 0, subresourcesCount, 0, footprints.data(), nullptr, nullptr, &readbackSize);
+
+		ComPtr<ID3D12Resource> readbackBuffer;
+		const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_READBACK);
+		const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(readbackSize);
+		if (FAILED(mDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&readbackBuffer))))
+			return false;
+
+		const int cmdListIndex = mCurrentGraphicsCommandListIndex;
+		const ER_RHI_RESOURCE_STATE oldState = aTexture->GetCurrentState();
+		TransitionResources({ static_cast<ER_RHI_GPUResource*>(aTexture) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_SOURCE, cmdListIndex);
+		for (UINT face = 0; face < ER_SH_CUBEMAP_FACES_COUNT; face++)
+		{
+			const UINT subresource = D3D12CalcSubresource(0, face, 0, desc.MipLevels, ER_SH_CUBEMAP_FACES_COUNT);
+			const CD3DX12_TEXTURE_COPY_LOCATION dstLocation(readbackBuffer.Get(), footprints[subresource]);
+			const CD3DX12_TEXTURE_COPY_LOCATION srcLocation(resource, subresource);
+			mCommandListGraphics[cmdListIndex]->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
+		}
+		TransitionResources({ static_cast<ER_RHI_GPUResource*>(aTexture) }, oldState, cmdListIndex);
+
+		EndGraphicsCommandList(cmdListIndex);
+		ExecuteCommandLists(cmdListIndex);
+		WaitForGpuOnGraphicsFence();
+		BeginGraphicsCommandList(cmdListIndex);
+		SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, false); // Reset() of the command list unbinds it
+
+		char* readbackData = nullptr;
+		const D3D12_RANGE readRange = { 0, static_cast<SIZE_T>(readbackSize) };
+		if (FAILED(readbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&readbackData))))
+			return false;
+
+		// texels are converted to float RGBA first (like on DX11)
+		DirectX::ScratchImage floatImages[ER_SH_CUBEMAP_FACES_COUNT];
+		const XMFLOAT4* faces[ER_SH_CUBEMAP_FACES_COUNT];
+		size_t rowPitch = 0;
+		bool isConverted = true;
+		for (UINT face = 0; face < ER_SH_CUBEMAP_FACES_COUNT && isConverted; face++)
+		{
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint = footprints[D3D12CalcSubresource(0, face, 0, desc.MipLevels, ER_SH_CUBEMAP_FACES_COUNT)];
+
+			DirectX::Image image = {};
+			image.width = footprint.Footprint.Width;
+			image.height = footprint.Footprint.Height;
+			image.format = footprint.Footprint.Format;
+			image.rowPitch = footprint.Footprint.RowPitch;
+			image.slicePitch = static_cast<size_t>(footprint.Footprint.RowPitch) * footprint.Footprint.Height;
+			image.pixels = reinterpret_cast<uint8_t*>(readbackData + footprint.Offset);
+
+			if (image.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+				isConverted = SUCCEEDED(floatImages[face].InitializeFromImage(image));
+			else
+				isConverted = SUCCEEDED(DirectX::Convert(image, DXGI_FORMAT_R32G32B32A32_FLOAT, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, floatImages[face]));
+			if (isConverted)
+			{
+				faces[face] = reinterpret_cast<const XMFLOAT4*>(floatImages[face].GetImage(0, 0, 0)->pixels);
+				rowPitch = floatImages[face].GetImage(0, 0, 0)->rowPitch; // same for all faces
+			}
+		}
+
+		const D3D12_RANGE writtenRange = { 0, 0 };
+		readbackBuffer->Unmap(0, &writtenRange);
+		if (!isConverted)
+			return false;
+
+		ER_SphericalHarmonics sh = ER_SphericalHarmonics::ProjectCubemap(faces, static_cast<UINT>(desc.Width), rowPitch);
+		sh.Get(resultR, resultG, resultB);
+		return true;
 	}
 
 	void ER_RHI_DX12::SaveGPUTextureToFile(ER_RHI_GPUTexture* aTexture, const std::wstring& aPathName)
@@ -995,7 +1079,7 @@ namespace EveryRay_Core
 		mCommandListGraphics[cmdListIndex]->OMSetRenderTargets(1, &GetMainRenderTargetView(), false, &GetMainDepthStencilView());
 	}
 
-	void ER_RHI_DX12::SetRenderTargets(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/, ER_RHI_GPUTexture* aUAV /*= nullptr*/, int rtvArrayIndex)
+	void ER_RHI_DX12::SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/, ER_RHI_GPUTexture* aUAV /*= nullptr*/, int rtvArrayIndex)
 	{
 		assert(mCurrentGraphicsCommandListIndex > -1);
 		if (!aUAV)
@@ -1008,7 +1092,8 @@ namespace EveryRay_Core
 
 			D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[DX12_MAX_BOUND_RENDER_TARGETS_VIEWS] = {};
 			UINT rtCount = static_cast<UINT>(aRenderTargets.size());
-			std::vector<ER_RHI_GPUResource*> resources(rtCount);
+			ER_RHI_GPUResource* resources[DX12_MAX_BOUND_RENDER_TARGETS_VIEWS + 1] = {}; // + depth
+			ER_RHI_RESOURCE_STATE transitions[DX12_MAX_BOUND_RENDER_TARGETS_VIEWS + 1] = {};
 			for (UINT i = 0; i < rtCount; i++)
 			{
 				assert(aRenderTargets[i]);
@@ -1018,24 +1103,21 @@ namespace EveryRay_Core
 					rtvHandles[i] = static_cast<ER_RHI_DX12_GPUTexture*>(aRenderTargets[i])->GetRTVHandle().GetCPUHandle();
 
 				resources[i] = static_cast<ER_RHI_GPUResource*>(aRenderTargets[i]);
+				transitions[i] = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET;
 			}
 
 			if (aDepthTarget)
 			{
 				D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = static_cast<ER_RHI_DX12_GPUTexture*>(aDepthTarget)->GetDSVHandle().GetCPUHandle();
 
-				std::vector<ER_RHI_RESOURCE_STATE> transitions(rtCount);
-				for (UINT i = 0; i < rtCount; i++)
-					transitions[i] = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET;
-
-				resources.push_back(static_cast<ER_RHI_GPUResource*>(aDepthTarget));
-				transitions.push_back(ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
-				TransitionResources(resources, transitions);
+				resources[rtCount] = static_cast<ER_RHI_GPUResource*>(aDepthTarget);
+				transitions[rtCount] = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE;
+				TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*>(resources, rtCount + 1), ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE>(transitions, rtCount + 1));
 				mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(rtCount, rtvHandles, FALSE, &dsvHandle);
 			}
 			else
 			{
-				TransitionResources(resources, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
+				TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*>(resources, rtCount), ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
 				mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(rtCount, rtvHandles, FALSE, NULL);
 			}
 
@@ -1058,20 +1140,20 @@ namespace EveryRay_Core
 		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(0, nullptr, FALSE, &dsvHandle);
 	}
 
-	void ER_RHI_DX12::SetRenderTargetFormats(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/)
+	void ER_RHI_DX12::SetRenderTargetFormats(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/)
 	{
 		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::COMPUTE)
 			return;
 
 		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
-		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+		ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 		int rtCount = static_cast<int>(aRenderTargets.size());
-		assert(rtCount <= 8);
+		assert(rtCount <= DX12_MAX_BOUND_RENDER_TARGETS_VIEWS);
 
-		std::vector<DXGI_FORMAT> formats;
+		DXGI_FORMAT formats[DX12_MAX_BOUND_RENDER_TARGETS_VIEWS] = {};
 		for (int i = 0; i < rtCount; i++)
-			formats.push_back(static_cast<ER_RHI_DX12_GPUTexture*>(aRenderTargets[i])->GetFormat());
+			formats[i] = static_cast<ER_RHI_DX12_GPUTexture*>(aRenderTargets[i])->GetFormat();
 		pso.SetRenderTargetFormats(rtCount, rtCount > 0 ? &formats[0] : nullptr, aDepthTarget ? static_cast<ER_RHI_DX12_GPUTexture*>(aDepthTarget)->GetFormat() : DXGI_FORMAT_UNKNOWN);
 	}
 
@@ -1079,7 +1161,7 @@ namespace EveryRay_Core
 	{
 		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
-		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+		ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 		pso.SetRenderTargetFormats(1, &mMainRTBufferFormat, mMainDepthBufferFormat);
 	}
 
@@ -1094,7 +1176,7 @@ namespace EveryRay_Core
 		if (it != mDepthStates.end())
 		{
 			mCurrentDS = aDS;
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 			pso.SetDepthStencilState(it->second);
 		}
 		else
@@ -1112,7 +1194,7 @@ namespace EveryRay_Core
 		if (it != mBlendStates.end())
 		{
 			mCurrentBS = aBS;
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 			pso.SetBlendState(it->second);
 		}
 		else
@@ -1130,7 +1212,7 @@ namespace EveryRay_Core
 		if (it != mRasterizerStates.end())
 		{
 			mCurrentRS = aRS;
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 			pso.SetRasterizerState(it->second);
 		}
 		else
@@ -1176,7 +1258,7 @@ namespace EveryRay_Core
 
 		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS)
 		{
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 
 			switch (aShader->mShaderType)
 			{
@@ -1199,12 +1281,12 @@ namespace EveryRay_Core
 		}
 		else
 		{
-			ER_RHI_DX12_ComputePSO& pso = mComputePSONames.at(mCurrentComputePSOName);
+			ER_RHI_DX12_ComputePSO& pso = *mCurrentComputePSO;
 			pso.SetComputeShader(blob->GetBufferPointer(), blob->GetBufferSize());
 		}
 	}
 
-	void ER_RHI_DX12::SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aSRVs, UINT startSlot /*= 0*/,
+	void ER_RHI_DX12::SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot /*= 0*/,
 		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS, bool skipAutomaticTransition)
 	{
 		int srvCount = static_cast<int>(aSRVs.size());
@@ -1215,34 +1297,33 @@ namespace EveryRay_Core
 		assert(mDescriptorHeapManager);
 		assert(mCurrentGraphicsCommandListIndex > -1);
 
-		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-		ER_RHI_DX12_DescriptorHandle& srvHandle = gpuDescriptorHeap->GetHandleBlock(srvCount);
+		D3D12_CPU_DESCRIPTOR_HANDLE srcHandles[DX12_MAX_BOUND_SHADER_RESOURCE_VIEWS];
 		for (int i = 0; i < srvCount; i++)
 		{
 			if (aSRVs[i])
 			{
 				if (aSRVs[i]->IsBuffer())
-					gpuDescriptorHeap->AddToHandle(mDevice.Get(), srvHandle, static_cast<ER_RHI_DX12_GPUBuffer*>(aSRVs[i])->GetSRVDescriptorHandle());
+					srcHandles[i] = static_cast<ER_RHI_DX12_GPUBuffer*>(aSRVs[i])->GetSRVDescriptorHandle().GetCPUHandle();
 				else
-					gpuDescriptorHeap->AddToHandle(mDevice.Get(), srvHandle, static_cast<ER_RHI_DX12_GPUTexture*>(aSRVs[i])->GetSRVHandle());
+					srcHandles[i] = static_cast<ER_RHI_DX12_GPUTexture*>(aSRVs[i])->GetSRVHandle().GetCPUHandle();
 			}
 			else
-				gpuDescriptorHeap->AddToHandle(mDevice.Get(), srvHandle, sNullSRV2DHandle);
-
+				srcHandles[i] = sNullSRV2DHandle.GetCPUHandle();
 		}
+		const D3D12_GPU_DESCRIPTOR_HANDLE srvTable = GetDescriptorTable(srcHandles, srvCount);
 
 		if (!skipAutomaticTransition)
 			TransitionResources(aSRVs, aShaderType == ER_RHI_SHADER_TYPE::ER_PIXEL ? ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mCurrentGraphicsCommandListIndex);
 
 		if (!isComputeRS)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, srvHandle.GetGPUHandle());
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, srvTable);
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, srvHandle.GetGPUHandle());
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, srvTable);
 
 		//TODO compute queue
 	}
 
-	void ER_RHI_DX12::SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aUAVs, UINT startSlot /*= 0*/,
+	void ER_RHI_DX12::SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot /*= 0*/,
 		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS, bool skipAutomaticTransition)
 	{
 		int uavCount = static_cast<int>(aUAVs.size());
@@ -1253,29 +1334,29 @@ namespace EveryRay_Core
 		assert(mDescriptorHeapManager);
 		assert(mCurrentGraphicsCommandListIndex > -1);
 
-		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-		ER_RHI_DX12_DescriptorHandle& uavHandle = gpuDescriptorHeap->GetHandleBlock(uavCount);
+		D3D12_CPU_DESCRIPTOR_HANDLE srcHandles[DX12_MAX_BOUND_UNORDERED_ACCESS_VIEWS];
 		for (int i = 0; i < uavCount; i++)
 		{
 			assert(aUAVs[i]);
 			if (aUAVs[i]->IsBuffer())
-				gpuDescriptorHeap->AddToHandle(mDevice.Get(), uavHandle, static_cast<ER_RHI_DX12_GPUBuffer*>(aUAVs[i])->GetUAVDescriptorHandle());
+				srcHandles[i] = static_cast<ER_RHI_DX12_GPUBuffer*>(aUAVs[i])->GetUAVDescriptorHandle().GetCPUHandle();
 			else
-				gpuDescriptorHeap->AddToHandle(mDevice.Get(), uavHandle, static_cast<ER_RHI_DX12_GPUTexture*>(aUAVs[i])->GetUAVHandle(startSlot));
+				srcHandles[i] = static_cast<ER_RHI_DX12_GPUTexture*>(aUAVs[i])->GetUAVHandle(startSlot).GetCPUHandle();
 		}
+		const D3D12_GPU_DESCRIPTOR_HANDLE uavTable = GetDescriptorTable(srcHandles, uavCount);
 
 		if (!skipAutomaticTransition)
 			TransitionResources(aUAVs, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS, mCurrentGraphicsCommandListIndex);
 
 		if (!isComputeRS)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, uavHandle.GetGPUHandle());
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, uavTable);
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, uavHandle.GetGPUHandle());
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, uavTable);
 
 		//TODO compute queue
 	}
 
-	void ER_RHI_DX12::SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUBuffer*>& aCBs, UINT startSlot /*= 0*/,
+	void ER_RHI_DX12::SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot /*= 0*/,
 		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS)
 	{
 		int cbvCount = static_cast<int>(aCBs.size());
@@ -1286,23 +1367,23 @@ namespace EveryRay_Core
 		assert(mDescriptorHeapManager);
 		assert(mCurrentGraphicsCommandListIndex > -1);
 
-		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-		ER_RHI_DX12_DescriptorHandle& cbvHandle = gpuDescriptorHeap->GetHandleBlock(cbvCount);
+		D3D12_CPU_DESCRIPTOR_HANDLE srcHandles[DX12_MAX_BOUND_CONSTANT_BUFFERS];
 		for (int i = 0; i < cbvCount; i++)
 		{
 			assert(aCBs[i]);
-			gpuDescriptorHeap->AddToHandle(mDevice.Get(), cbvHandle, static_cast<ER_RHI_DX12_GPUBuffer*>(aCBs[i])->GetCBVDescriptorHandle());
+			srcHandles[i] = static_cast<ER_RHI_DX12_GPUBuffer*>(aCBs[i])->GetCBVDescriptorHandle().GetCPUHandle();
 		}
+		const D3D12_GPU_DESCRIPTOR_HANDLE cbvTable = GetDescriptorTable(srcHandles, cbvCount);
 
 		if (!isComputeRS)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, cbvHandle.GetGPUHandle());
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, cbvTable);
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, cbvHandle.GetGPUHandle());
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, cbvTable);
 
 		//TODO compute queue
 	}
 
-	void ER_RHI_DX12::SetSamplers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_SAMPLER_STATE>& aSamplers, UINT startSlot /*= 0*/, ER_RHI_GPURootSignature* rs)
+	void ER_RHI_DX12::SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot /*= 0*/, ER_RHI_GPURootSignature* rs)
 	{
 		//assert(rs);
 		//assert(rs->GetStaticSamplersCount() == aSamplers.size()); // we can do better checks (compare samplers), but thats ok for now
@@ -1315,7 +1396,7 @@ namespace EveryRay_Core
 		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 		assert(aIL);
 
-		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+		ER_RHI_DX12_GraphicsPSO& pso = *mCurrentGraphicsPSO;
 		pso.SetInputLayout(this, aIL->mInputElementDescriptionCount, aIL->mInputElementDescriptions);
 	}
 
@@ -1336,7 +1417,7 @@ namespace EveryRay_Core
 		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->IASetIndexBuffer(&view);
 	}
 
-	void ER_RHI_DX12::SetVertexBuffers(const std::vector<ER_RHI_GPUBuffer*>& aVertexBuffers)
+	void ER_RHI_DX12::SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers)
 	{
 		assert(mCurrentGraphicsCommandListIndex > -1);
 
@@ -1396,14 +1477,14 @@ namespace EveryRay_Core
 		//TODO compute queue
 	}
 
-	void ER_RHI_DX12::SetTopologyTypeToPSO(const std::string& aName, ER_RHI_PRIMITIVE_TYPE aType)
+	void ER_RHI_DX12::SetTopologyTypeToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_PRIMITIVE_TYPE aType)
 	{
 		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::UNSET)
 			return;
 
 		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
-		assert(mCurrentGraphicsPSOName == aName);
-		mGraphicsPSONames.at(aName).SetPrimitiveTopologyType(GetTopologyType(aType));
+		assert(mCurrentGraphicsPSO && mCurrentGraphicsPSO == mGraphicsPSOs.Find(aPSO.GetHash()));
+		mCurrentGraphicsPSO->SetPrimitiveTopologyType(GetTopologyType(aType));
 	}
 
 	ER_RHI_PRIMITIVE_TYPE ER_RHI_DX12::GetCurrentTopologyType()
@@ -1419,56 +1500,72 @@ namespace EveryRay_Core
 
 		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(GetHeapType(aType));
 		if (aReset)
+		{
 			gpuDescriptorHeap->Reset();
 
+			if (aType == ER_RHI_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+			{
+				mLastFrameDescriptorTablesStats = mDescriptorTablesStats;
+				mLastFrameDescriptorTablesStats.DescriptorsCapacity = gpuDescriptorHeap->GetMaxNoofDescriptors();
+				mDescriptorTablesStats = ER_RHI_DescriptorTablesStats();
+			}
+		}
+
 		ID3D12DescriptorHeap* ppHeaps[] = { gpuDescriptorHeap->GetHeap() };
 		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 	}
 
+	D3D12_GPU_DESCRIPTOR_HANDLE ER_RHI_DX12::GetDescriptorTable(const D3D12_CPU_DESCRIPTOR_HANDLE* aSources, UINT aCount)
+	{
+		assert(mDescriptorHeapManager);
+
+		bool isReused = false;
+		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		ER_RHI_DX12_DescriptorHandle table = gpuDescriptorHeap->GetCachedHandleBlock(mDevice.Get(), aSources, aCount, &isReused);
+
+		mDescriptorTablesStats.TablesRequested++;
+		if (isReused)
+			mDescriptorTablesStats.TablesReused++;
+		else
+			mDescriptorTablesStats.DescriptorsCopied += aCount;
+
+		return table.GetGPUHandle();
+	}
+
 	void ER_RHI_DX12::SetGPUDescriptorHeapImGui(int cmdListIndex)
 	{
 		ID3D12DescriptorHeap* ppHeaps[] = { mImGuiDescriptorHeap.Get() };
 		mCommandListGraphics[cmdListIndex]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 	}
 
-	bool ER_RHI_DX12::IsPSOReady(const std::string& aName, bool isCompute)
+	bool ER_RHI_DX12::IsPSOReady(const ER_RHI_PSOHandle& aPSO, bool isCompute)
 	{
 		if (!isCompute)
-		{
-			auto it = mGraphicsPSONames.find(aName);
-			if (it != mGraphicsPSONames.end())
-				return true;
-			else
-				return false;
-		}
+			return mGraphicsPSOs.Find(aPSO.GetHash()) != nullptr;
 		else
-		{
-			auto it2 = mComputePSONames.find(aName);
-			if (it2 != mComputePSONames.end())
-				return true;
-			else
-				return false;
-		}
+			return mComputePSOs.Find(aPSO.GetHash()) != nullptr;
 	}
 
-	void ER_RHI_DX12::InitializePSO(const std::string& aName, bool isCompute)
+	void ER_RHI_DX12::InitializePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute)
 	{
 		if (isCompute)
 		{
-			mComputePSONames.insert(std::make_pair(aName, ER_RHI_DX12_ComputePSO(aName)));
-			mCurrentComputePSOName = aName;
+			mCurrentComputePSO = mComputePSOs.Find(aPSO.GetHash());
+			if (!mCurrentComputePSO)
+				mCurrentComputePSO = mComputePSOs.Add(aPSO.GetHash(), new ER_RHI_DX12_ComputePSO(aPSO.GetName()));
 			mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
 		}
 		else
 		{
-			mGraphicsPSONames.insert(std::make_pair(aName, ER_RHI_DX12_GraphicsPSO(aName)));
-			mCurrentGraphicsPSOName = aName;
+			mCurrentGraphicsPSO = mGraphicsPSOs.Find(aPSO.GetHash());
+			if (!mCurrentGraphicsPSO)
+				mCurrentGraphicsPSO = mGraphicsPSOs.Add(aPSO.GetHash(), new ER_RHI_DX12_GraphicsPSO(aPSO.GetName()));
 			mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
 			SetRasterizerState(ER_RHI_RASTERIZER_STATE::ER_BACK_CULLING); // set default RS to all gfx PSO on init
 		}
 	}
 
-	void ER_RHI_DX12::SetRootSignatureToPSO(const std::string& aName, ER_RHI_GPURootSignature* rs, bool isCompute /*= false*/)
+	void ER_RHI_DX12::SetRootSignatureToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_GPURootSignature* rs, bool isCompute /*= false*/)
 	{
 		assert(rs);
 		ER_RHI_DX12_GPURootSignature* rsDX12 = static_cast<ER_RHI_DX12_GPURootSignature*>(rs);
@@ -1476,96 +1573,91 @@ namespace EveryRay_Core
 
 		if (!isCompute)
 		{
-			assert(mCurrentGraphicsPSOName == aName);
-			mGraphicsPSONames.at(aName).SetRootSignature(*rsDX12);
+			assert(mCurrentGraphicsPSO && mCurrentGraphicsPSO == mGraphicsPSOs.Find(aPSO.GetHash()));
+			mCurrentGraphicsPSO->SetRootSignature(*rsDX12);
 		}
 		else
 		{
-			assert(mCurrentComputePSOName == aName);
-			mComputePSONames.at(aName).SetRootSignature(*rsDX12);
+			assert(mCurrentComputePSO && mCurrentComputePSO == mComputePSOs.Find(aPSO.GetHash()));
+			mCurrentComputePSO->SetRootSignature(*rsDX12);
 		}
 	}
 
-	void ER_RHI_DX12::FinalizePSO(const std::string& aName, bool isCompute /*= false*/)
+	void ER_RHI_DX12::FinalizePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute /*= false*/)
 	{
+		bool isShared = false;
 		if (!isCompute)
 		{
-			assert(mCurrentGraphicsPSOName == aName);
-			mGraphicsPSONames.at(aName).Finalize(mDevice.Get());
+			assert(mCurrentGraphicsPSO && mCurrentGraphicsPSO == mGraphicsPSOs.Find(aPSO.GetHash()));
+			isShared = !mCurrentGraphicsPSO->Finalize(mDevice.Get(), mPipelineStates);
 		}
 		else
 		{
-			assert(mCurrentComputePSOName == aName);
-			mComputePSONames.at(aName).Finalize(mDevice.Get());
+			assert(mCurrentComputePSO && mCurrentComputePSO == mComputePSOs.Find(aPSO.GetHash()));
+			isShared = !mCurrentComputePSO->Finalize(mDevice.Get(), mPipelineStates);
 		}
+
+		if (isShared)
+			mSharedPipelineStatesCount++;
 	}
 
-	void ER_RHI_DX12::SetPSO(const std::string& aName, bool isCompute)
+	void ER_RHI_DX12::SetPSO(const ER_RHI_PSOHandle& aPSO, bool isCompute)
 	{
 		assert(mCurrentGraphicsCommandListIndex > -1);
-		auto resetPSO = [&](const std::string& name, bool comp)
+		auto resetPSO = [&](const ER_RHI_PSOHandle& pso, bool comp)
 		{
-			std::wstring msg = L"[ER Logger] ER_RHI_DX12: Could not find PSO to set, adding it now and trying to reset: " + ER_Utility::ToWideString(aName) + L'\n';
+			std::wstring msg = L"[ER Logger] ER_RHI_DX12: Could not find PSO to set, adding it now and trying to reset: " + ER_Utility::ToWideString(pso.GetName()) + L'\n';
 			ER_OUTPUT_LOG(msg.c_str());
-			InitializePSO(name, comp);
-			SetPSO(name, comp);
+			InitializePSO(pso, comp);
+			SetPSO(pso, comp);
 		};
 
+		ID3D12PipelineState* pipelineState = nullptr;
 		if (!isCompute)
 		{
-			auto it = mGraphicsPSONames.find(aName);
-			if (it != mGraphicsPSONames.end())
+			ER_RHI_DX12_GraphicsPSO* pso = mGraphicsPSOs.Find(aPSO.GetHash());
+			if (!pso)
 			{
-				if (mCurrentGraphicsPSOName == aName && mCurrentSetGraphicsPSOName == aName)
-				{
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
-					return;
-				}
-				else
-				{
-					mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetPipelineState(it->second.GetPipelineStateObject());
-					mCurrentGraphicsPSOName = it->first;
-					mCurrentSetGraphicsPSOName = mCurrentGraphicsPSOName;
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
-				}
+				resetPSO(aPSO, isCompute);
+				return;
 			}
-			else
-				resetPSO(aName, isCompute);
+			mCurrentGraphicsPSO = pso;
+			mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
+			pipelineState = pso->GetPipelineStateObject();
 		}
 		else
 		{
-			auto it = mComputePSONames.find(aName);
-			if (it != mComputePSONames.end())
+			ER_RHI_DX12_ComputePSO* pso = mComputePSOs.Find(aPSO.GetHash());
+			if (!pso)
 			{
-				if (mCurrentComputePSOName == aName && mCurrentSetComputePSOName == aName)
-				{
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
-					return;
-				}
-				{
-					mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetPipelineState(it->second.GetPipelineStateObject());
-					mCurrentComputePSOName = it->first;
-					mCurrentSetComputePSOName = mCurrentComputePSOName;
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
-				}
+				resetPSO(aPSO, isCompute);
+				return;
 			}
-			else
-				resetPSO(aName, isCompute);
+			mCurrentComputePSO = pso;
+			mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
+			pipelineState = pso->GetPipelineStateObject();
+		}
+
+		// PSOs with identical state share one pipeline, so switching between them does not need a new SetPipelineState()
+		if (pipelineState != mCurrentSetPipelineState)
+		{
+			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetPipelineState(pipelineState);
+			mCurrentSetPipelineState = pipelineState;
 		}
 	}
 
 	void ER_RHI_DX12::UnsetPSO()
 	{
 		mCurrentPSOState = ER_RHI_DX12_PSO_STATE::UNSET;
-		mCurrentSetGraphicsPSOName = "";
-		mCurrentSetComputePSOName = "";
+		mCurrentSetPipelineState = nullptr;
 	}
 
-	void ER_RHI_DX12::TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, const std::vector<ER_RHI_RESOURCE_STATE>& aStates, int cmdListIndex, bool isCopyQueue, int subresourceIndex)
+	void ER_RHI_DX12::TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE> aStates, int cmdListIndex, bool isCopyQueue, int subresourceIndex)
 	{
 		int size = static_cast<int>(aResources.size());
 		assert(size > 0 && size == aStates.size());
-		std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
+		std::vector<CD3DX12_RESOURCE_BARRIER>& barriers = mTransitionBarriers; // keeps its capacity between calls
+		barriers.clear();
 
 		for (int i = 0; i < size; i++)
 		{
@@ -1591,10 +1683,11 @@ namespace EveryRay_Core
 		}
 	}
 
-	void ER_RHI_DX12::TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex /*= 0*/, bool isCopyQueue, int subresourceIndex)
+	void ER_RHI_DX12::TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex /*= 0*/, bool isCopyQueue, int subresourceIndex)
 	{
 		int size = static_cast<int>(aResources.size());
-		std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
+		std::vector<CD3DX12_RESOURCE_BARRIER>& barriers = mTransitionBarriers; // keeps its capacity between calls
+		barriers.clear();
 
 		for (int i = 0; i < size; i++)
 		{
@@ -1645,6 +1738,16 @@ namespace EveryRay_Core
 		buffer->Update(this, aData, dataSize, updateForAllBackBuffers);
 	}
 
+	UINT64 ER_RHI_DX12::UpdateBufferRanges(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, ER_RHI_ArrayView<ER_RHI_BufferRange> aRanges)
+	{
+		assert(aBuffer->GetSize() >= dataSize);
+
+		ER_RHI_DX12_GPUBuffer* buffer = static_cast<ER_RHI_DX12_GPUBuffer*>(aBuffer);
+		assert(buffer);
+
+		return buffer->UpdateRanges(this, aData, dataSize, aRanges);
+	}
+
 	void ER_RHI_DX12::InitImGui()
 	{
 		D3D12_DESCRIPTOR_HEAP_DESC desc = {};
@@ -34,6 +34,81 @@ namespace EveryRay_Core
 
 	class ER_RHI_DX12_GraphicsPSO;
 	class ER_RHI_DX12_ComputePSO;
+
+	// Finalized pipeline and the full state it was created from (see GetStateKey() of the graphics/compute PSOs)
+	struct ER_RHI_DX12_PipelineState
+	{
+		ComPtr<ID3D12PipelineState> Pipeline;
+		std::vector<unsigned char> StateKey;
+	};
+
+	// Flat open-addressing (linear probing) table from ER_RHI_PSOHandle hashes to PSOs, owns the PSOs.
+	// A lookup is a walk over one contiguous array of {hash, pointer} slots; PSOs are never moved, so pointers to them stay valid.
+	template<typename T>
+	class ER_RHI_DX12_PSOTable
+	{
+	public:
+		T* Find(UINT64 aHash) const
+		{
+			if (mSlots.empty())
+				return nullptr;
+
+			const size_t mask = mSlots.size() - 1;
+			for (size_t i = static_cast<size_t>(aHash) & mask; ; i = (i + 1) & mask)
+			{
+				const Slot& slot = mSlots[i];
+				if (!slot.Object)
+					return nullptr;
+				if (slot.Hash == aHash)
+					return slot.Object;
+			}
+		}
+
+		T* Add(UINT64 aHash, T* aObject) // takes the ownership
+		{
+			assert(aObject && !Find(aHash));
+			if ((mObjects.size() + 1) * 2 > mSlots.size()) // keep the load factor <= 0.5
+				Rehash(mSlots.empty() ? 64 : mSlots.size() * 2);
+
+			mObjects.emplace_back(aObject);
+			Insert(aHash, aObject);
+			return aObject;
+		}
+
+		size_t Size() const { return mObjects.size(); }
+	private:
+		struct Slot
+		{
+			UINT64 Hash = 0;
+			T* Object = nullptr;
+		};
+
+		void Insert(UINT64 aHash, T* aObject)
+		{
+			const size_t mask = mSlots.size() - 1;
+			size_t i = static_cast<size_t>(aHash) & mask;
+			while (mSlots[i].Object)
+				i = (i + 1) & mask;
+			mSlots[i].Hash = aHash;
+			mSlots[i].Object = aObject;
+		}
+
+		void Rehash(size_t aCapacity) // power of 2
+		{
+			std::vector<Slot> oldSlots;
+			oldSlots.swap(mSlots);
+			mSlots.resize(aCapacity);
+			for (const Slot& slot : oldSlots)
+			{
+				if (slot.Object)
+					Insert(slot.Hash, slot.Object);
+			}
+		}
+
+		std::vector<Slot> mSlots;
+		std::vector<std::unique_ptr<T>> mObjects;
+	};
+
 	class ER_RHI_DX12_GPURootSignature;
 	class ER_RHI_DX12_GPUDescriptorHeapManager;
 	class ER_RHI_DX12_DescriptorHandle;
@@ -104,9 +179,9 @@ namespace EveryRay_Core
 		virtual void SaveGPUTextureToFile(ER_RHI_GPUTexture* aTexture, const std::wstring& aPathName) override;
 
 		virtual void SetMainRenderTargets(int cmdListIndex = 0) override;
-		virtual void SetRenderTargets(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) override;
+		virtual void SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) override;
 		virtual void SetDepthTarget(ER_RHI_GPUTexture* aDepthTarget) override;
-		virtual void SetRenderTargetFormats(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) override;
+		virtual void SetRenderTargetFormats(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) override;
 		virtual void SetMainRenderTargetFormats() override;
 
 		virtual void SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE aDS, UINT stencilRef = 0xffffffff) override;
@@ -121,13 +196,13 @@ namespace EveryRay_Core
 		
 		virtual void SetShader(ER_RHI_GPUShader* aShader) override;
 		
-		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aSRVs, UINT startSlot = 0, 
+		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot = 0, 
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) override;
-		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aUAVs, UINT startSlot = 0,
+		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) override;
-		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUBuffer*>& aCBs, UINT startSlot = 0,
+		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false) override;
-		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_SAMPLER_STATE>& aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) override;
+		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) override;
 		
 		virtual void SetRootSignature(ER_RHI_GPURootSignature* rs, bool isCompute = false) override;
 		virtual void SetRootConstant(UINT aConstant, UINT aRootIndex, UINT anOffset = 0, bool isCompute = false) override;
@@ -135,30 +210,34 @@ namespace EveryRay_Core
 		virtual void SetInputLayout(ER_RHI_InputLayout* aIL) override;
 		virtual void SetEmptyInputLayout() override;
 		virtual void SetIndexBuffer(ER_RHI_GPUBuffer* aBuffer, UINT offset = 0) override;
-		virtual void SetVertexBuffers(const std::vector<ER_RHI_GPUBuffer*>& aVertexBuffers) override;
+		virtual void SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers) override;
 
 		virtual void SetTopologyType(ER_RHI_PRIMITIVE_TYPE aType) override;
 		virtual ER_RHI_PRIMITIVE_TYPE GetCurrentTopologyType() override;
 
 		virtual void SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE aType, bool aReset) override;
 		virtual void SetGPUDescriptorHeapImGui(int cmdListIndex = 0) override;
+		virtual ER_RHI_DescriptorTablesStats GetDescriptorTablesStats() override { return mLastFrameDescriptorTablesStats; }
 
-		virtual void TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, const std::vector<ER_RHI_RESOURCE_STATE>& aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override;
-		virtual void TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override;
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE> aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override;
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override;
 		virtual void TransitionMainRenderTargetToPresent(int cmdListIndex = 0) override;
 
-		virtual bool IsPSOReady(const std::string& aName, bool isCompute = false) override;
-		virtual void InitializePSO(const std::string& aName, bool isCompute = false) override;
-		virtual void SetRootSignatureToPSO(const std::string& aName, ER_RHI_GPURootSignature* rs, bool isCompute = false) override;
-		virtual void SetTopologyTypeToPSO(const std::string& aName, ER_RHI_PRIMITIVE_TYPE aType) override;
-		virtual void FinalizePSO(const std::string& aName, bool isCompute = false) override;
-		virtual void SetPSO(const std::string& aName, bool isCompute = false) override;
+		virtual bool IsPSOReady(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void InitializePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void SetRootSignatureToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_GPURootSignature* rs, bool isCompute = false) override;
+		virtual void SetTopologyTypeToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_PRIMITIVE_TYPE aType) override;
+		virtual void FinalizePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void SetPSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
 		virtual void UnsetPSO() override;
 
 		virtual void UnbindRenderTargets() override;
 		virtual void UnbindResourcesFromShader(ER_RHI_SHADER_TYPE aShaderType, bool unbindShader = true) override {}; //Not needed on DX12
 
 		virtual void UpdateBuffer(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, bool updateForAllBackBuffers = false) override;
+		virtual UINT64 UpdateBufferRanges(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, ER_RHI_ArrayView<ER_RHI_BufferRange> aRanges) override;
+		virtual UINT GetDynamicBufferVersionsCount() override { return DX12_MAX_BACK_BUFFER_COUNT; }
+		virtual UINT GetDynamicBufferCurrentVersion() override { return static_cast<UINT>(mBackBufferIndex); }
 		
 		virtual bool IsHardwareRaytracingSupported() override { return mIsRaytracingTierAvailable; }
 		virtual bool IsRootConstantSupported()  override { return true; }
@@ -206,6 +285,9 @@ namespace EveryRay_Core
 
 		D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType(ER_RHI_DESCRIPTOR_HEAP_TYPE aType);
 
+		// Returns a table (in the current shader-visible CBV/SRV/UAV heap) with copies of "aSources": identical tables are copied only once per frame
+		D3D12_GPU_DESCRIPTOR_HANDLE GetDescriptorTable(const D3D12_CPU_DESCRIPTOR_HANDLE* aSources, UINT aCount);
+
 		DXGI_FORMAT ChangeFormatToNonSRGB(DXGI_FORMAT aFormat);
 		DXGI_FORMAT ChangeFormatToUncompressed(DXGI_FORMAT aFormat);
 		bool IsFormatSRGB(DXGI_FORMAT aFormat);
@@ -265,14 +347,20 @@ namespace EveryRay_Core
 		std::map<ER_RHI_RASTERIZER_STATE, D3D12_RASTERIZER_DESC> mRasterizerStates;
 		std::map<ER_RHI_DEPTH_STENCIL_STATE, D3D12_DEPTH_STENCIL_DESC> mDepthStates;
 
-		std::map<std::string, ER_RHI_DX12_GraphicsPSO> mGraphicsPSONames;
-		std::map<std::string, ER_RHI_DX12_ComputePSO> mComputePSONames;
-		std::string mCurrentGraphicsPSOName;
-		std::string mCurrentComputePSOName;
-		std::string mCurrentSetGraphicsPSOName; //which was set to command list already
-		std::string mCurrentSetComputePSOName; //which was set to command list already
+		ER_RHI_DX12_PSOTable<ER_RHI_DX12_GraphicsPSO> mGraphicsPSOs;
+		ER_RHI_DX12_PSOTable<ER_RHI_DX12_ComputePSO> mComputePSOs;
+		ER_RHI_DX12_GraphicsPSO* mCurrentGraphicsPSO = nullptr; //which is being initialized or was set last
+		ER_RHI_DX12_ComputePSO* mCurrentComputePSO = nullptr; //which is being initialized or was set last
+		ID3D12PipelineState* mCurrentSetPipelineState = nullptr; //which was set to command list already
+		std::unordered_map<UINT64, ER_RHI_DX12_PipelineState> mPipelineStates; // finalized pipelines by the hash of their full state (PSOs with identical state share one)
+		UINT mSharedPipelineStatesCount = 0; // how many PSOs reused an existing pipeline in FinalizePSO()
 		ER_RHI_DX12_PSO_STATE mCurrentPSOState = ER_RHI_DX12_PSO_STATE::UNSET;
 
+		std::vector<CD3DX12_RESOURCE_BARRIER> mTransitionBarriers; // scratch for TransitionResources()
+
+		ER_RHI_DescriptorTablesStats mDescriptorTablesStats; // since the last reset of the GPU heap
+		ER_RHI_DescriptorTablesStats mLastFrameDescriptorTablesStats;
+
 		ER_RHI_DX12_GPUDescriptorHeapManager* mDescriptorHeapManager = nullptr;
 
 		ComPtr<ID3D12CommandSignature> mCommandSignature_DrawIndexed;
@@ -284,19 +372,19 @@ namespace EveryRay_Core
 
 		ER_RHI_GPURootSignature* mClearUAV2DRS = nullptr;
 		ER_RHI_GPUShader* mClearUAV2DCS = nullptr;
-		std::string mClearUAV2DPSOName = "ER_RHI_GPUPipelineStateObject: Clear UAV 2D";
+		ER_RHI_PSOHandle mClearUAV2DPSOName = "ER_RHI_GPUPipelineStateObject: Clear UAV 2D";
 
 		ER_RHI_GPURootSignature* mClearUAV3DRS = nullptr;
 		ER_RHI_GPUShader* mClearUAV3DCS = nullptr;
-		std::string mClearUAV3DPSOName = "ER_RHI_GPUPipelineStateObject: Clear UAV 3D";
+		ER_RHI_PSOHandle mClearUAV3DPSOName = "ER_RHI_GPUPipelineStateObject: Clear UAV 3D";
 
 		ER_RHI_GPURootSignature* mGenerateMips2DRS = nullptr;
 		ER_RHI_GPUShader* mGenerateMips2DCS = nullptr;
-		std::string mGenerateMips2DPSOName = "ER_RHI_GPUPipelineStateObject: Generate Mips 2D";
+		ER_RHI_PSOHandle mGenerateMips2DPSOName = "ER_RHI_GPUPipelineStateObject: Generate Mips 2D";
 
 		ER_RHI_GPURootSignature* mGenerateMips3DRS = nullptr;
 		ER_RHI_GPUShader* mGenerateMips3DCS = nullptr;
-		std::string mGenerateMips3DPSOName = "ER_RHI_GPUPipelineStateObject: Generate Mips 3D";
+		ER_RHI_PSOHandle mGenerateMips3DPSOName = "ER_RHI_GPUPipelineStateObject: Generate Mips 3D";
 
 		ER_RHI_GPUTexture* mGenerateMipsWithReplacementReadyTexturesPool[DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL] = { nullptr };
 		std::function<void(ER_RHI_GPUTexture**)> mGenerateMipsWithReplacementCallbacks[DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL];
@@ -250,4 +250,23 @@ namespace EveryRay_Core
 		//	UpdateSubresource(aRHI, aData, dataSize, aRHIDX12->GetCurrentGraphicsCommandListIndex());
 	}
 
+	UINT64 ER_RHI_DX12_GPUBuffer::UpdateRanges(ER_RHI* aRHI, void* aData, int dataSize, ER_RHI_ArrayView<ER_RHI_BufferRange> aRanges)
+	{
+		assert(mSize >= dataSize);
+		assert(mIsDynamic);
+		assert(aRHI);
+
+		// upload heaps are persistently mapped, so we can write only the ranges that changed
+		UINT64 uploadedBytes = 0;
+		unsigned char* destination = mMappedData[ER_RHI_DX12::mBackBufferIndex];
+		const unsigned char* source = static_cast<const unsigned char*>(aData);
+		for (const ER_RHI_BufferRange& range : aRanges)
+		{
+			assert(range.Offset + range.Size <= static_cast<UINT>(dataSize));
+			memcpy(destination + range.Offset, source + range.Offset, range.Size);
+			uploadedBytes += range.Size;
+		}
+		return uploadedBytes;
+	}
+
 }
\ No newline at end of file
@@ -34,6 +34,7 @@ namespace EveryRay_Core
 		void Map(ER_RHI* aRHI, void** aOutData);
 		void Unmap(ER_RHI* aRHI);
 		void Update(ER_RHI* aRHI, void* aData, int dataSize, bool updateForAllBackBuffers = false);
+		UINT64 UpdateRanges(ER_RHI* aRHI, void* aData, int dataSize, ER_RHI_ArrayView<ER_RHI_BufferRange> aRanges); // current back buffer's version only
 		DXGI_FORMAT GetFormat() { return mFormat; }
 	private:
 		void UpdateSubresource(ER_RHI* aRHI, void* aData, int aSize, int cmdListIndex);
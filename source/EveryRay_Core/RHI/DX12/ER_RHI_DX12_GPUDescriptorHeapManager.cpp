@@ -114,6 +114,96 @@ namespace EveryRay_Core
 	void ER_RHI_DX12_GPUDescriptorHeap::Reset()
 	{
 		mCurrentDescriptorIndex = 0;
+		InvalidateCachedHandleBlocks();
+	}
+
+	ER_RHI_DX12_DescriptorHandle ER_RHI_DX12_GPUDescriptorHeap::GetCachedHandleBlock(ID3D12Device* device, const D3D12_CPU_DESCRIPTOR_HANDLE* aSources, UINT count, bool* aOutIsReused)
+	{
+		assert(aSources && count > 0);
+
+		// 64-bit FNV-1a of the source descriptors' addresses
+		UINT64 hash = 14695981039346656037ull;
+		for (UINT i = 0; i < count; i++)
+			hash = (hash ^ static_cast<UINT64>(aSources[i].ptr)) * 1099511628211ull;
+
+		int blockIndex = FindCachedBlock(hash, aSources, count);
+		if (aOutIsReused)
+			*aOutIsReused = (blockIndex >= 0);
+
+		if (blockIndex >= 0)
+		{
+			const UINT heapIndex = mCachedBlocks[blockIndex].HeapIndex;
+			ER_RHI_DX12_DescriptorHandle handle;
+			handle.SetCPUHandle({ mDescriptorHeapCPUStart.ptr + heapIndex * mDescriptorSize });
+			handle.SetGPUHandle({ mDescriptorHeapGPUStart.ptr + heapIndex * mDescriptorSize });
+			handle.SetHeapIndex(heapIndex);
+			return handle;
+		}
+
+		ER_RHI_DX12_DescriptorHandle handle = GetHandleBlock(count);
+
+		if (mSourceRangeSizes.size() < count)
+			mSourceRangeSizes.resize(count, 1);
+		device->CopyDescriptors(1, &handle.GetCPUHandle(), &count, count, aSources, mSourceRangeSizes.data(), mHeapType);
+
+		CachedBlock block;
+		block.Hash = hash;
+		block.HeapIndex = handle.GetHeapIndex();
+		block.Count = count;
+		block.SourcesOffset = static_cast<UINT>(mCachedBlocksSources.size());
+		for (UINT i = 0; i < count; i++)
+			mCachedBlocksSources.push_back(aSources[i].ptr);
+		mCachedBlocks.push_back(block);
+
+		if (mCachedBlocks.size() * 2 > mCachedBlocksLookup.size()) // keep the load factor <= 0.5
+		{
+			mCachedBlocksLookup.assign(mCachedBlocksLookup.empty() ? 1024 : mCachedBlocksLookup.size() * 2, 0);
+			for (UINT i = 0; i < static_cast<UINT>(mCachedBlocks.size()); i++)
+				AddCachedBlockToLookup(i);
+		}
+		else
+			AddCachedBlockToLookup(static_cast<UINT>(mCachedBlocks.size()) - 1);
+
+		return handle;
+	}
+
+	int ER_RHI_DX12_GPUDescriptorHeap::FindCachedBlock(UINT64 aHash, const D3D12_CPU_DESCRIPTOR_HANDLE* aSources, UINT count) const
+	{
+		if (mCachedBlocksLookup.empty())
+			return -1;
+
+		const size_t mask = mCachedBlocksLookup.size() - 1;
+		for (size_t i = static_cast<size_t>(aHash) & mask; mCachedBlocksLookup[i] != 0; i = (i + 1) & mask)
+		{
+			const UINT blockIndex = mCachedBlocksLookup[i] - 1;
+			const CachedBlock& block = mCachedBlocks[blockIndex];
+			if (block.Hash != aHash || block.Count != count)
+				continue;
+
+			bool isSame = true;
+			for (UINT j = 0; j < count && isSame; j++)
+				isSame = (mCachedBlocksSources[block.SourcesOffset + j] == aSources[j].ptr);
+			if (isSame)
+				return static_cast<int>(blockIndex);
+		}
+		return -1;
+	}
+
+	void ER_RHI_DX12_GPUDescriptorHeap::AddCachedBlockToLookup(UINT aBlockIndex)
+	{
+		const size_t mask = mCachedBlocksLookup.size() - 1;
+		size_t i = static_cast<size_t>(mCachedBlocks[aBlockIndex].Hash) & mask;
+		while (mCachedBlocksLookup[i] != 0)
+			i = (i + 1) & mask;
+		mCachedBlocksLookup[i] = aBlockIndex + 1;
+	}
+
+	void ER_RHI_DX12_GPUDescriptorHeap::InvalidateCachedHandleBlocks()
+	{
+		// keep the capacity, so that the steady state does not allocate
+		mCachedBlocks.clear();
+		mCachedBlocksSources.clear();
+		std::fill(mCachedBlocksLookup.begin(), mCachedBlocksLookup.end(), 0);
 	}
 
 	ER_RHI_DX12_GPUDescriptorHeapManager::ER_RHI_DX12_GPUDescriptorHeapManager(ID3D12Device* device)
@@ -148,6 +238,13 @@ namespace EveryRay_Core
 
 	ER_RHI_DX12_DescriptorHandle ER_RHI_DX12_GPUDescriptorHeapManager::CreateCPUHandle(D3D12_DESCRIPTOR_HEAP_TYPE heapType, int frameIndex)
 	{
+		// a new descriptor might be written to a freed (and reused) slot, which an already cached GPU block could have copied
+		for (int i = 0; i < DX12_MAX_BACK_BUFFER_COUNT; i++)
+		{
+			if (mGPUDescriptorHeaps[i][heapType])
+				mGPUDescriptorHeaps[i][heapType]->InvalidateCachedHandleBlocks();
+		}
+
 		return mCPUDescriptorHeaps[frameIndex >= 0 ? frameIndex : ER_RHI_DX12::mBackBufferIndex][heapType]->GetNewHandle();
 	}
 
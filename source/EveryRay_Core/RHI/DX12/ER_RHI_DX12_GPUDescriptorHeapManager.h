@@ -90,8 +90,28 @@ namespace EveryRay_Core
 		void Reset();
 		ER_RHI_DX12_DescriptorHandle GetHandleBlock(UINT count);
 
+		// Same as GetHandleBlock() + copying "aSources" into the block (with one CopyDescriptors() call).
+		// Blocks are cached until Reset(): if the same source descriptors (in the same order) were already copied, that block is returned instead.
+		ER_RHI_DX12_DescriptorHandle GetCachedHandleBlock(ID3D12Device* device, const D3D12_CPU_DESCRIPTOR_HANDLE* aSources, UINT count, bool* aOutIsReused = nullptr);
+		void InvalidateCachedHandleBlocks(); // call when source descriptors might have been (re)written
 	private:
+		struct CachedBlock
+		{
+			UINT64 Hash;
+			UINT HeapIndex;
+			UINT Count;
+			UINT SourcesOffset; // in mCachedBlocksSources
+		};
+
+		int FindCachedBlock(UINT64 aHash, const D3D12_CPU_DESCRIPTOR_HANDLE* aSources, UINT count) const;
+		void AddCachedBlockToLookup(UINT aBlockIndex);
+
 		UINT mCurrentDescriptorIndex;
+
+		std::vector<CachedBlock> mCachedBlocks;
+		std::vector<SIZE_T> mCachedBlocksSources;
+		std::vector<UINT> mCachedBlocksLookup; // open addressing (linear probing): index into mCachedBlocks + 1 (0 - empty slot), size is a power of 2
+		std::vector<UINT> mSourceRangeSizes; // all 1s, for CopyDescriptors()
 	};
 
 	class ER_RHI_DX12_GPUDescriptorHeapManager
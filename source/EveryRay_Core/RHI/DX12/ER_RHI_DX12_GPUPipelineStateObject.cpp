@@ -5,11 +5,82 @@
 
 namespace EveryRay_Core
 {
+	// 64-bit FNV-1a (same as ER_RHI_HashName()), but over raw bytes
+	static UINT64 HashBytes(const void* aData, size_t aSize)
+	{
+		UINT64 hash = 14695981039346656037ull;
+		const unsigned char* bytes = static_cast<const unsigned char*>(aData);
+		for (size_t i = 0; i < aSize; i++)
+			hash = (hash ^ static_cast<UINT64>(bytes[i])) * 1099511628211ull;
+		return hash;
+	}
+
+	static void AppendBytes(std::vector<unsigned char>& aKey, const void* aData, size_t aSize)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(aData);
+		aKey.insert(aKey.end(), bytes, bytes + aSize);
+	}
+
+	// only for types without padding (scalars, enums, pointers)
+	template<typename T>
+	static void AppendValue(std::vector<unsigned char>& aKey, const T& aValue)
+	{
+		static_assert(std::is_scalar<T>::value, "AppendValue() is only for scalar types");
+		AppendBytes(aKey, &aValue, sizeof(T));
+	}
+
+	static void AppendString(std::vector<unsigned char>& aKey, const char* aString)
+	{
+		AppendBytes(aKey, aString ? aString : "", aString ? strlen(aString) + 1 : 1);
+	}
+
+	static void AppendShader(std::vector<unsigned char>& aKey, const D3D12_SHADER_BYTECODE& aShader)
+	{
+		AppendValue(aKey, aShader.BytecodeLength);
+		if (aShader.pShaderBytecode)
+			AppendBytes(aKey, aShader.pShaderBytecode, aShader.BytecodeLength);
+	}
+
+	static void AppendDepthStencilOp(std::vector<unsigned char>& aKey, const D3D12_DEPTH_STENCILOP_DESC& aDesc)
+	{
+		AppendValue(aKey, aDesc.StencilFailOp);
+		AppendValue(aKey, aDesc.StencilDepthFailOp);
+		AppendValue(aKey, aDesc.StencilPassOp);
+		AppendValue(aKey, aDesc.StencilFunc);
+	}
 
 	ER_RHI_DX12_PSO::~ER_RHI_DX12_PSO()
 	{
 	}
 
+	bool ER_RHI_DX12_PSO::FindPipeline(const std::vector<unsigned char>& aStateKey, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines)
+	{
+		auto it = aPipelines.find(HashBytes(aStateKey.data(), aStateKey.size()));
+		if (it == aPipelines.end())
+			return true;
+
+		// the hash only finds the candidate, the full state decides (a collision must not bind another PSO's pipeline)
+		if (it->second.StateKey != aStateKey)
+		{
+			std::string message = "[ER_Logger] ER_RHI_DX12: PSO state hash collision, creating a separate pipeline: " + mName + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+			return true;
+		}
+
+		mPSO = it->second.Pipeline;
+		std::string message = "[ER_Logger] ER_RHI_DX12: PSO has the same state as an existing one, sharing its pipeline: " + mName + '\n';
+		ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+		return false;
+	}
+
+	void ER_RHI_DX12_PSO::AddPipeline(std::vector<unsigned char>&& aStateKey, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines)
+	{
+		ER_RHI_DX12_PipelineState pipeline;
+		pipeline.Pipeline = mPSO;
+		pipeline.StateKey = std::move(aStateKey);
+		aPipelines.emplace(HashBytes(pipeline.StateKey.data(), pipeline.StateKey.size()), std::move(pipeline)); // no-op after a collision (first pipeline stays shared)
+	}
+
 	ER_RHI_DX12_GraphicsPSO::ER_RHI_DX12_GraphicsPSO(const std::string& aName) : ER_RHI_DX12_PSO(aName)
 	{
 		mName = aName;
@@ -52,13 +123,95 @@ namespace EveryRay_Core
 		mPSODesc.IBStripCutValue = IBProps;
 	}
 
-	void ER_RHI_DX12_GraphicsPSO::Finalize(ID3D12Device* device)
+	void ER_RHI_DX12_GraphicsPSO::GetStateKey(std::vector<unsigned char>& aOutKey) const
+	{
+		aOutKey.clear();
+		AppendString(aOutKey, "Graphics PSO");
+		AppendShader(aOutKey, mPSODesc.VS);
+		AppendShader(aOutKey, mPSODesc.PS);
+		AppendShader(aOutKey, mPSODesc.DS);
+		AppendShader(aOutKey, mPSODesc.HS);
+		AppendShader(aOutKey, mPSODesc.GS);
+		AppendValue(aOutKey, mPSODesc.pRootSignature);
+
+		// state descs are added field by field, because their padding is not guaranteed to be zeroed
+		AppendValue(aOutKey, mPSODesc.BlendState.AlphaToCoverageEnable);
+		AppendValue(aOutKey, mPSODesc.BlendState.IndependentBlendEnable);
+		for (const D3D12_RENDER_TARGET_BLEND_DESC& rtBlend : mPSODesc.BlendState.RenderTarget)
+		{
+			AppendValue(aOutKey, rtBlend.BlendEnable);
+			AppendValue(aOutKey, rtBlend.LogicOpEnable);
+			AppendValue(aOutKey, rtBlend.SrcBlend);
+			AppendValue(aOutKey, rtBlend.DestBlend);
+			AppendValue(aOutKey, rtBlend.BlendOp);
+			AppendValue(aOutKey, rtBlend.SrcBlendAlpha);
+			AppendValue(aOutKey, rtBlend.DestBlendAlpha);
+			AppendValue(aOutKey, rtBlend.BlendOpAlpha);
+			AppendValue(aOutKey, rtBlend.LogicOp);
+			AppendValue(aOutKey, rtBlend.RenderTargetWriteMask);
+		}
+		AppendValue(aOutKey, mPSODesc.SampleMask);
+
+		const D3D12_RASTERIZER_DESC& rs = mPSODesc.RasterizerState;
+		AppendValue(aOutKey, rs.FillMode);
+		AppendValue(aOutKey, rs.CullMode);
+		AppendValue(aOutKey, rs.FrontCounterClockwise);
+		AppendValue(aOutKey, rs.DepthBias);
+		AppendValue(aOutKey, rs.DepthBiasClamp);
+		AppendValue(aOutKey, rs.SlopeScaledDepthBias);
+		AppendValue(aOutKey, rs.DepthClipEnable);
+		AppendValue(aOutKey, rs.MultisampleEnable);
+		AppendValue(aOutKey, rs.AntialiasedLineEnable);
+		AppendValue(aOutKey, rs.ForcedSampleCount);
+		AppendValue(aOutKey, rs.ConservativeRaster);
+
+		const D3D12_DEPTH_STENCIL_DESC& ds = mPSODesc.DepthStencilState;
+		AppendValue(aOutKey, ds.DepthEnable);
+		AppendValue(aOutKey, ds.DepthWriteMask);
+		AppendValue(aOutKey, ds.DepthFunc);
+		AppendValue(aOutKey, ds.StencilEnable);
+		AppendValue(aOutKey, ds.StencilReadMask);
+		AppendValue(aOutKey, ds.StencilWriteMask);
+		AppendDepthStencilOp(aOutKey, ds.FrontFace);
+		AppendDepthStencilOp(aOutKey, ds.BackFace);
+
+		AppendValue(aOutKey, mPSODesc.InputLayout.NumElements);
+		for (UINT i = 0; i < mPSODesc.InputLayout.NumElements; i++)
+		{
+			const D3D12_INPUT_ELEMENT_DESC& element = mPSODesc.InputLayout.pInputElementDescs[i];
+			AppendString(aOutKey, element.SemanticName);
+			AppendValue(aOutKey, element.SemanticIndex);
+			AppendValue(aOutKey, element.Format);
+			AppendValue(aOutKey, element.InputSlot);
+			AppendValue(aOutKey, element.AlignedByteOffset);
+			AppendValue(aOutKey, element.InputSlotClass);
+			AppendValue(aOutKey, element.InstanceDataStepRate);
+		}
+
+		AppendValue(aOutKey, mPSODesc.IBStripCutValue);
+		AppendValue(aOutKey, mPSODesc.PrimitiveTopologyType);
+		AppendValue(aOutKey, mPSODesc.NumRenderTargets);
+		for (UINT i = 0; i < mPSODesc.NumRenderTargets; i++)
+			AppendValue(aOutKey, mPSODesc.RTVFormats[i]);
+		AppendValue(aOutKey, mPSODesc.DSVFormat);
+		AppendValue(aOutKey, mPSODesc.SampleDesc.Count);
+		AppendValue(aOutKey, mPSODesc.SampleDesc.Quality);
+		AppendValue(aOutKey, mPSODesc.NodeMask);
+		AppendValue(aOutKey, mPSODesc.Flags);
+	}
+
+	bool ER_RHI_DX12_GraphicsPSO::Finalize(ID3D12Device* device, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines)
 	{
 		mPSODesc.pRootSignature = mRootSignature->GetSignature();
 		assert(mPSODesc.pRootSignature != nullptr);
 
 		mPSODesc.InputLayout.pInputElementDescs = mInputLayouts.get();
 
+		std::vector<unsigned char> stateKey;
+		GetStateKey(stateKey);
+		if (!FindPipeline(stateKey, aPipelines))
+			return false;
+
 		HRESULT hr;
 		if (FAILED(hr = device->CreateGraphicsPipelineState(&mPSODesc, IID_PPV_ARGS(&mPSO))))
 		{
@@ -74,7 +227,9 @@ namespace EveryRay_Core
 			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
 
 			mPSO->SetName(ER_Utility::ToWideString(mName).c_str());
+			AddPipeline(std::move(stateKey), aPipelines);
 		}
+		return true;
 	}
 
 	void ER_RHI_DX12_GraphicsPSO::SetRenderTargetFormats(UINT NumRTVs, const DXGI_FORMAT* RTVFormats, DXGI_FORMAT DSVFormat)
@@ -130,11 +285,26 @@ namespace EveryRay_Core
 		mPSODesc.NodeMask = 1;
 	}
 
-	void ER_RHI_DX12_ComputePSO::Finalize(ID3D12Device* device)
+	void ER_RHI_DX12_ComputePSO::GetStateKey(std::vector<unsigned char>& aOutKey) const
+	{
+		aOutKey.clear();
+		AppendString(aOutKey, "Compute PSO");
+		AppendShader(aOutKey, mPSODesc.CS);
+		AppendValue(aOutKey, mPSODesc.pRootSignature);
+		AppendValue(aOutKey, mPSODesc.NodeMask);
+		AppendValue(aOutKey, mPSODesc.Flags);
+	}
+
+	bool ER_RHI_DX12_ComputePSO::Finalize(ID3D12Device* device, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines)
 	{
 		mPSODesc.pRootSignature = mRootSignature->GetSignature();
 		assert(mPSODesc.pRootSignature != nullptr);
-		
+
+		std::vector<unsigned char> stateKey;
+		GetStateKey(stateKey);
+		if (!FindPipeline(stateKey, aPipelines))
+			return false;
+
 		HRESULT hr;
 		if (FAILED(hr = device->CreateComputePipelineState(&mPSODesc, IID_PPV_ARGS(&mPSO))))
 		{
@@ -150,7 +320,9 @@ namespace EveryRay_Core
 			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
 			
 			mPSO->SetName(ER_Utility::ToWideString(mName).c_str());
+			AddPipeline(std::move(stateKey), aPipelines);
 		}
+		return true;
 	}
 
 }
\ No newline at end of file
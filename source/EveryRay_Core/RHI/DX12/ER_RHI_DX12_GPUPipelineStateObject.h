@@ -25,6 +25,11 @@ namespace EveryRay_Core
 		ID3D12PipelineState* GetPipelineStateObject() const { return mPSO.Get(); }
 
 	protected:
+		// Looks for a pipeline with the same state in "aPipelines" (then it is shared instead of creating a new one).
+		// Returns false if an existing pipeline was reused, otherwise the new "mPSO" should be added with AddPipeline().
+		bool FindPipeline(const std::vector<unsigned char>& aStateKey, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines);
+		void AddPipeline(std::vector<unsigned char>&& aStateKey, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines);
+
 		const ER_RHI_DX12_GPURootSignature* mRootSignature;
 		ComPtr<ID3D12PipelineState> mPSO;
 		std::string mName;
@@ -56,8 +61,11 @@ namespace EveryRay_Core
 		void SetHullShader(const D3D12_SHADER_BYTECODE& Binary) { mPSODesc.HS = Binary; }
 		void SetDomainShader(const D3D12_SHADER_BYTECODE& Binary) { mPSODesc.DS = Binary; }
 
-		void Finalize(ID3D12Device* device);
+		// Creates the pipeline or shares an already created one with identical state from "aPipelines". Returns true if a new pipeline was created.
+		bool Finalize(ID3D12Device* device, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines);
 	private:
+		void GetStateKey(std::vector<unsigned char>& aOutKey) const; // all the state that the pipeline is created from
+
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC mPSODesc;
 		std::shared_ptr<const D3D12_INPUT_ELEMENT_DESC> mInputLayouts;
 	};
@@ -70,9 +78,12 @@ namespace EveryRay_Core
 		void SetComputeShader(const void* Binary, size_t Size) { mPSODesc.CS = CD3DX12_SHADER_BYTECODE(const_cast<void*>(Binary), Size); }
 		void SetComputeShader(const D3D12_SHADER_BYTECODE& Binary) { mPSODesc.CS = Binary; }
 
-		void Finalize(ID3D12Device* device);
+		// Creates the pipeline or shares an already created one with identical state from "aPipelines". Returns true if a new pipeline was created.
+		bool Finalize(ID3D12Device* device, std::unordered_map<UINT64, ER_RHI_DX12_PipelineState>& aPipelines);
 
 	private:
+		void GetStateKey(std::vector<unsigned char>& aOutKey) const; // all the state that the pipeline is created from
+
 		D3D12_COMPUTE_PIPELINE_STATE_DESC mPSODesc;
 	};
 }
\ No newline at end of file
@@ -35,27 +35,27 @@ namespace EveryRay_Core
 		switch (mShaderType)
 		{
 		case ER_VERTEX:
-			if (FAILED(CompileBlob(ER_Utility::GetFilePath(ER_Utility::ToWideString(path)).c_str(), shaderEntry.c_str(), vertexShaderModel.c_str(), &mShaderBlob)))
+			if (FAILED(CompileBlob(aRHI->GetShaderCache(), ER_Utility::GetFilePath(path), shaderEntry.c_str(), vertexShaderModel.c_str(), &mShaderBlob)))
 				throw ER_CoreException(compilerErrorMessage.c_str());
 			break;
 		case ER_PIXEL:
-			if (FAILED(CompileBlob(ER_Utility::GetFilePath(ER_Utility::ToWideString(path)).c_str(), shaderEntry.c_str(), pixelShaderModel.c_str(), &mShaderBlob)))
+			if (FAILED(CompileBlob(aRHI->GetShaderCache(), ER_Utility::GetFilePath(path), shaderEntry.c_str(), pixelShaderModel.c_str(), &mShaderBlob)))
 				throw ER_CoreException(compilerErrorMessage.c_str());
 			break;
 		case ER_COMPUTE:
-			if (FAILED(CompileBlob(ER_Utility::GetFilePath(ER_Utility::ToWideString(path)).c_str(), shaderEntry.c_str(), computeShaderModel.c_str(), &mShaderBlob)))
+			if (FAILED(CompileBlob(aRHI->GetShaderCache(), ER_Utility::GetFilePath(path), shaderEntry.c_str(), computeShaderModel.c_str(), &mShaderBlob)))
 				throw ER_CoreException(compilerErrorMessage.c_str());
 			break;
 		case ER_GEOMETRY:
-			if (FAILED(CompileBlob(ER_Utility::GetFilePath(ER_Utility::ToWideString(path)).c_str(), shaderEntry.c_str(), geometryShaderModel.c_str(), &mShaderBlob)))
+			if (FAILED(CompileBlob(aRHI->GetShaderCache(), ER_Utility::GetFilePath(path), shaderEntry.c_str(), geometryShaderModel.c_str(), &mShaderBlob)))
 				throw ER_CoreException(compilerErrorMessage.c_str());
 			break;
 		case ER_TESSELLATION_HULL:
-			if (FAILED(CompileBlob(ER_Utility::GetFilePath(ER_Utility::ToWideString(path)).c_str(), shaderEntry.c_str(), hullShaderModel.c_str(), &mShaderBlob)))
+			if (FAILED(CompileBlob(aRHI->GetShaderCache(), ER_Utility::GetFilePath(path), shaderEntry.c_str(), hullShaderModel.c_str(), &mShaderBlob)))
 				throw ER_CoreException(compilerErrorMessage.c_str());
 			break;
 		case ER_TESSELLATION_DOMAIN:
-			if (FAILED(CompileBlob(ER_Utility::GetFilePath(ER_Utility::ToWideString(path)).c_str(), shaderEntry.c_str(), domainShaderModel.c_str(), &mShaderBlob)))
+			if (FAILED(CompileBlob(aRHI->GetShaderCache(), ER_Utility::GetFilePath(path), shaderEntry.c_str(), domainShaderModel.c_str(), &mShaderBlob)))
 				throw ER_CoreException(compilerErrorMessage.c_str());
 			break;
 		}
@@ -66,9 +66,9 @@ namespace EveryRay_Core
 		return mShaderBlob;
 	}
 
-	HRESULT ER_RHI_DX12_GPUShader::CompileBlob(_In_ LPCWSTR srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob** blob)
+	HRESULT ER_RHI_DX12_GPUShader::CompileBlob(ER_ShaderCache& cache, const std::string& srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob** blob)
 	{
-		if (!srcFile || !entryPoint || !profile || !blob)
+		if (srcFile.empty() || !entryPoint || !profile || !blob)
 			return E_INVALIDARG;
 
 		*blob = nullptr;
@@ -85,9 +85,25 @@ namespace EveryRay_Core
 			NULL, NULL
 		};
 
+		std::vector<std::string> cacheDefines;
+		for (const D3D_SHADER_MACRO* define = defines; define->Name; define++)
+			cacheDefines.push_back(std::string(define->Name) + "=" + (define->Definition ? define->Definition : ""));
+
+		const UINT64 cacheKey = cache.ComputeKey(srcFile, entryPoint, profile, cacheDefines, flags);
+		std::vector<char> bytecode;
+		if (cache.Find(cacheKey, bytecode))
+		{
+			HRESULT hr = D3DCreateBlob(bytecode.size(), blob);
+			if (SUCCEEDED(hr))
+				memcpy((*blob)->GetBufferPointer(), bytecode.data(), bytecode.size());
+			return hr;
+		}
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+
 		ID3DBlob* shaderBlob = nullptr;
 		ID3DBlob* errorBlob = nullptr;
-		HRESULT hr = D3DCompileFromFile(srcFile, defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		HRESULT hr = D3DCompileFromFile(ER_Utility::ToWideString(srcFile).c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
 			entryPoint, profile,
 			flags, 0, &shaderBlob, &errorBlob);
 		if (FAILED(hr))
@@ -103,6 +119,10 @@ namespace EveryRay_Core
 
 			return hr;
 		}
+		ReleaseObject(errorBlob); // warnings
+
+		std::chrono::duration<double, std::milli> compileTime = std::chrono::high_resolution_clock::now() - startTime;
+		cache.Store(cacheKey, shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(), compileTime.count());
 
 		*blob = shaderBlob;
 
@@ -13,7 +13,7 @@ namespace EveryRay_Core
 		virtual void* GetShaderObject() override;
 
 	private:
-		HRESULT CompileBlob(_In_ LPCWSTR srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob** blob);
+		HRESULT CompileBlob(ER_ShaderCache& cache, const std::string& srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob** blob);
 
 		ID3DBlob* mShaderBlob = nullptr;
 	};
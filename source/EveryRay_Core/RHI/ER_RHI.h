@@ -1,5 +1,7 @@
 #pragma once
 #include "..\Common.h"
+#include "..\ER_ShaderCache.h"
+#include <shared_mutex>
 
 #define ER_RHI_MAX_GRAPHICS_COMMAND_LISTS 8
 #define ER_RHI_MAX_COMPUTE_COMMAND_LISTS 2
@@ -13,7 +15,8 @@ namespace EveryRay_Core
 	enum ER_GRAPHICS_API
 	{
 		DX11,
-		DX12
+		DX12,
+		NULL_RHI // headless, see ER_RHI_Null
 	};
 
 	enum ER_RHI_SHADER_TYPE
@@ -221,6 +224,91 @@ namespace EveryRay_Core
 		UINT InstanceDataStepRate = 0;
 	};
 
+	// Non-owning view of a contiguous array, used for the arguments of binding calls.
+	// Can be created from a std::vector or a braced list (i.e., { srv0, srv1 }) which lives on the stack, so there are no heap allocations per call.
+	// Only valid during the call: implementations must not store it.
+	template<typename T>
+	class ER_RHI_ArrayView
+	{
+	public:
+		ER_RHI_ArrayView() {}
+		ER_RHI_ArrayView(const T* aData, size_t aSize) : mData(aData), mSize(aSize) {}
+		ER_RHI_ArrayView(const std::vector<T>& aVector) : mData(aVector.data()), mSize(aVector.size()) {}
+		ER_RHI_ArrayView(std::initializer_list<T> aList) : mData(aList.begin()), mSize(aList.size()) {}
+		template<size_t N>
+		ER_RHI_ArrayView(const T(&aArray)[N]) : mData(aArray), mSize(N) {}
+
+		const T& operator[](size_t index) const { assert(index < mSize); return mData[index]; }
+		const T* data() const { return mData; }
+		size_t size() const { return mSize; }
+		bool empty() const { return mSize == 0; }
+		const T* begin() const { return mData; }
+		const T* end() const { return mData + mSize; }
+	private:
+		const T* mData = nullptr;
+		size_t mSize = 0;
+	};
+
+	// 64-bit FNV-1a, can be evaluated at compile time
+	constexpr UINT64 ER_RHI_HashName(const char* aName, UINT64 aHash = 14695981039346656037ull)
+	{
+		return (*aName == '\0') ? aHash : ER_RHI_HashName(aName + 1, (aHash ^ static_cast<UINT64>(static_cast<unsigned char>(*aName))) * 1099511628211ull);
+	}
+
+	// Handle of a pipeline state object: the name is hashed (and interned for logging/debugging) once, when the handle is created,
+	// so RHI lookups and "is it the same PSO?" checks are integer compares. Hashes are unique per name (collisions are resolved when interning).
+	// Keep handles in members/statics (not temporaries built from strings per draw), the implicit constructors are only there for convenience.
+	class ER_RHI_PSOHandle
+	{
+	public:
+		ER_RHI_PSOHandle() {}
+		ER_RHI_PSOHandle(const char* aName) : mHash(ER_RHI_HashName(aName)) { mName = InternName(mHash, aName); }
+		ER_RHI_PSOHandle(const std::string& aName) : ER_RHI_PSOHandle(aName.c_str()) {}
+
+		UINT64 GetHash() const { return mHash; }
+		const std::string& GetName() const { static const std::string emptyName; return mName ? *mName : emptyName; }
+		bool IsValid() const { return mName != nullptr; }
+
+		bool operator==(const ER_RHI_PSOHandle& aOther) const { return mHash == aOther.mHash; }
+		bool operator!=(const ER_RHI_PSOHandle& aOther) const { return mHash != aOther.mHash; }
+	private:
+		// Names are compared on a hash match: a colliding name gets the next free hash (linear probing), so two names never share a handle.
+		static const std::string* InternName(UINT64& aHash, const char* aName)
+		{
+			static std::unordered_map<UINT64, std::string> names;
+			static std::shared_timed_mutex namesMutex;
+
+			// common case: the name is already interned (shared lock, no allocations)
+			{
+				const std::shared_lock<std::shared_timed_mutex> lock(namesMutex);
+				for (UINT64 hash = aHash; ; hash++)
+				{
+					auto it = names.find(hash);
+					if (it == names.end())
+						break;
+					if (it->second == aName)
+					{
+						aHash = hash;
+						return &it->second;
+					}
+				}
+			}
+
+			const std::lock_guard<std::shared_timed_mutex> lock(namesMutex);
+			for (;; aHash++)
+			{
+				auto it = names.find(aHash);
+				if (it == names.end())
+					return &names.emplace(aHash, aName).first->second;
+				if (it->second == aName)
+					return &it->second; // interned by another thread in the meantime
+			}
+		}
+
+		UINT64 mHash = 0;
+		const std::string* mName = nullptr;
+	};
+
 	struct ER_RHI_Viewport
 	{
 		float TopLeftX;
@@ -255,6 +343,22 @@ namespace EveryRay_Core
 		ER_RHI_INPUT_ELEMENT_DESC* mInputElementDescriptions;
 		UINT mInputElementDescriptionCount;
 	};
+
+	// Descriptor tables of the last frame (only on APIs that use them): how many were requested and how many reused an identical table copied earlier in that frame
+	struct ER_RHI_DescriptorTablesStats
+	{
+		UINT64 TablesRequested = 0;
+		UINT64 TablesReused = 0;
+		UINT64 DescriptorsCopied = 0; // = descriptors allocated in the shader-visible heap (reused tables do not allocate)
+		UINT DescriptorsCapacity = 0; // of the shader-visible heap (per frame)
+	};
+
+	// Byte range for partial updates of dynamic buffers
+	struct ER_RHI_BufferRange
+	{
+		UINT Offset = 0;
+		UINT Size = 0;
+	};
 	
 	class ER_RHI_GPURootSignature;
 	class ER_RHI_GPUResource;
@@ -323,14 +427,14 @@ namespace EveryRay_Core
 		virtual void PresentGraphics() = 0;
 		virtual void PresentCompute() = 0;
 
-		virtual bool ProjectCubemapToSH(ER_RHI_GPUTexture* aTexture, UINT order, float* resultR, float* resultG, float* resultB) = 0; //WARNING: only works on DX11 for now
+		virtual bool ProjectCubemapToSH(ER_RHI_GPUTexture* aTexture, UINT order, float* resultR, float* resultG, float* resultB) = 0; // readback + ER_SphericalHarmonics::ProjectCubemap() (order 3 only); stalls the GPU on DX12 (flushes the current graphics command list)
 
 		virtual void SaveGPUTextureToFile(ER_RHI_GPUTexture* aTexture, const std::wstring& aPathName) = 0; //WARNING: only works on DX11 for now
 
 		virtual void SetMainRenderTargets(int cmdListIndex = 0) = 0;
-		virtual void SetRenderTargets(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) = 0;
+		virtual void SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) = 0;
 		virtual void SetDepthTarget(ER_RHI_GPUTexture* aDepthTarget) = 0;
-		virtual void SetRenderTargetFormats(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) = 0;
+		virtual void SetRenderTargetFormats(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) = 0;
 		virtual void SetMainRenderTargetFormats() = 0;
 
 		virtual void SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE aDS, UINT stencilRef = 0xffffffff) = 0;
@@ -350,19 +454,19 @@ namespace EveryRay_Core
 
 		virtual void SetShader(ER_RHI_GPUShader* aShader) = 0;
 		
-		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aSRVs, UINT startSlot = 0,
+		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) = 0;
-		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aUAVs, UINT startSlot = 0,
+		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) = 0;
-		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUBuffer*>& aCBs, UINT startSlot = 0,
+		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot = 0,
 			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false) = 0;
-		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_SAMPLER_STATE>& aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) = 0;
+		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) = 0;
 		
 		virtual void SetRootSignature(ER_RHI_GPURootSignature* rs, bool isCompute = false) = 0;
 		virtual void SetRootConstant(UINT aConstant, UINT aRootIndex, UINT anOffset = 0, bool isCompute = false) = 0;
 
 		virtual void SetIndexBuffer(ER_RHI_GPUBuffer* aBuffer, UINT offset = 0) = 0;
-		virtual void SetVertexBuffers(const std::vector<ER_RHI_GPUBuffer*>& aVertexBuffers) = 0;
+		virtual void SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers) = 0;
 		virtual void SetInputLayout(ER_RHI_InputLayout* aIL) = 0;
 		virtual void SetEmptyInputLayout() = 0;
 
@@ -371,23 +475,34 @@ namespace EveryRay_Core
 
 		virtual void SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE aType, bool aReset) = 0;
 		virtual void SetGPUDescriptorHeapImGui(int cmdListIndex) = 0;
+		virtual ER_RHI_DescriptorTablesStats GetDescriptorTablesStats() { return ER_RHI_DescriptorTablesStats(); }
 
-		virtual void TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, const std::vector<ER_RHI_RESOURCE_STATE>& aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) = 0;
-		virtual void TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) = 0;
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE> aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) = 0;
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) = 0;
 		virtual void TransitionMainRenderTargetToPresent(int cmdListIndex = 0) = 0;
 
-		virtual bool IsPSOReady(const std::string& aName, bool isCompute = false) = 0;
-		virtual void InitializePSO(const std::string& aName, bool isCompute = false) = 0;
-		virtual void SetRootSignatureToPSO(const std::string& aName, ER_RHI_GPURootSignature* rs, bool isCompute = false) = 0;
-		virtual void SetTopologyTypeToPSO(const std::string& aName, ER_RHI_PRIMITIVE_TYPE aType) = 0;
-		virtual void FinalizePSO(const std::string& aName, bool isCompute = false) = 0;
-		virtual void SetPSO(const std::string& aName, bool isCompute = false) = 0;
+		virtual bool IsPSOReady(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) = 0;
+		virtual void InitializePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) = 0;
+		virtual void SetRootSignatureToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_GPURootSignature* rs, bool isCompute = false) = 0;
+		virtual void SetTopologyTypeToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_PRIMITIVE_TYPE aType) = 0;
+		virtual void FinalizePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) = 0; // PSOs with identical state share one pipeline (where supported)
+		virtual void SetPSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) = 0;
 		virtual void UnsetPSO() = 0;
 
 		virtual void UnbindRenderTargets() = 0;
 		virtual void UnbindResourcesFromShader(ER_RHI_SHADER_TYPE aShaderType, bool unbindShader = true) = 0;
 
 		virtual void UpdateBuffer(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, bool updateForAllBackBuffers = false) = 0;
+		// Writes only the given ranges of "aData" (= full contents of the buffer) to the current version of a dynamic buffer and returns the uploaded bytes.
+		// APIs that cannot update a part of a dynamic buffer (i.e., "discard" maps) upload everything.
+		virtual UINT64 UpdateBufferRanges(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, ER_RHI_ArrayView<ER_RHI_BufferRange> aRanges)
+		{
+			UpdateBuffer(aBuffer, aData, dataSize);
+			return static_cast<UINT64>(dataSize);
+		}
+		// Dynamic buffers can have several versions (one per frame in flight), updates only write the current one
+		virtual UINT GetDynamicBufferVersionsCount() { return 1; }
+		virtual UINT GetDynamicBufferCurrentVersion() { return 0; }
 
 		virtual bool IsHardwareRaytracingSupported() = 0;
 		virtual bool IsRootConstantSupported() = 0;
@@ -415,6 +530,7 @@ namespace EveryRay_Core
 		inline const int GetCurrentComputeCommandListIndex() { return mCurrentComputeCommandListIndex; }
 
 		ER_GRAPHICS_API GetAPI() { return mAPI; }
+		ER_ShaderCache& GetShaderCache() { return mShaderCache; }
 	protected:
 		HWND mWindowHandle;
 
@@ -431,6 +547,8 @@ namespace EveryRay_Core
 		const int mPrepareGraphicsCommandListIndex = ER_RHI_MAX_GRAPHICS_COMMAND_LISTS - 1; // command list for prepare commands (on init)
 		int mCurrentGraphicsCommandListIndex = -1;
 		int mCurrentComputeCommandListIndex = -1;
+
+		ER_ShaderCache mShaderCache; // shared by all GPU shaders of this RHI, survives level switches
 	};
 
 	class ER_RHI_GPURootSignature
@@ -478,6 +596,8 @@ namespace EveryRay_Core
 			int mip = 1, int depth = -1, int arraySize = 1, bool isCubemap = false, int cubemapArraySize = -1) { AbstractRHIMethodAssert();	}
 		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) { AbstractRHIMethodAssert(); }
 		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) { AbstractRHIMethodAssert(); }
+		// DDS file that is already in memory (i.e., in a memory-mapped archive); the data is not referenced after the call. No fallback texture on failure.
+		virtual void CreateGPUTextureResourceFromMemory(ER_RHI* aRHI, const void* aData, size_t aSize, bool* statusFlag = nullptr) { AbstractRHIMethodAssert(); }
 
 		virtual void* GetRTV(void* aEmpty = nullptr) { AbstractRHIMethodAssert(); return nullptr; }
 		virtual void* GetRTV(int index) { AbstractRHIMethodAssert(); return nullptr; }
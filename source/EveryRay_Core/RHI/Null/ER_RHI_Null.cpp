@@ -0,0 +1,748 @@
+#include "ER_RHI_Null.h"
+#include "ER_RHI_Null_GPUResources.h"
+#include "..\..\ER_CoreException.h"
+#include "..\..\ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	static const char* sNullCommandTypeNames[ER_NULL_CMD_COUNT] =
+	{
+		"BeginGraphicsCommandList",
+		"EndGraphicsCommandList",
+		"BeginComputeCommandList",
+		"EndComputeCommandList",
+		"BeginCopyCommandList",
+		"EndCopyCommandList",
+		"ClearMainRenderTarget",
+		"ClearMainDepthStencilTarget",
+		"ClearRenderTarget",
+		"ClearDepthStencilTarget",
+		"ClearUAV",
+		"CreateTexture",
+		"CreateBuffer",
+		"CopyBuffer",
+		"BufferRead",
+		"CopyGPUTextureSubresourceRegion",
+		"Draw",
+		"DrawIndexed",
+		"DrawInstanced",
+		"DrawIndexedInstanced",
+		"DrawIndexedInstancedIndirect",
+		"Dispatch",
+		"GenerateMips",
+		"ExecuteCommandLists",
+		"Present",
+		"SetRenderTargets",
+		"SetDepthTarget",
+		"SetDepthStencilState",
+		"SetBlendState",
+		"SetRasterizerState",
+		"SetViewport",
+		"SetRect",
+		"SetShader",
+		"SetShaderResources",
+		"SetUnorderedAccessResources",
+		"SetConstantBuffers",
+		"SetSamplers",
+		"SetRootSignature",
+		"SetRootConstant",
+		"SetIndexBuffer",
+		"SetVertexBuffers",
+		"SetInputLayout",
+		"SetTopologyType",
+		"SetGPUDescriptorHeap",
+		"TransitionResources",
+		"InitializePSO",
+		"FinalizePSO",
+		"SetPSO",
+		"UnsetPSO",
+		"UnbindRenderTargets",
+		"UnbindResourcesFromShader",
+		"UpdateBuffer",
+		"BeginEventTag",
+		"EndEventTag"
+	};
+
+	ER_RHI_Null::ER_RHI_Null()
+	{
+	}
+
+	ER_RHI_Null::~ER_RHI_Null()
+	{
+		mCurrentFrameCommands.clear();
+		mLastFrameCommands.clear();
+		mCurrentFrameResources.clear();
+		mLastFrameResources.clear();
+		mGraphicsPSOs.clear();
+		mComputePSOs.clear();
+	}
+
+	bool ER_RHI_Null::Initialize(HWND windowHandle, UINT width, UINT height, bool isFullscreen, bool isReset)
+	{
+		assert(width > 0 && height > 0);
+
+		mAPI = ER_GRAPHICS_API::NULL_RHI;
+		mWindowHandle = windowHandle; // can be null, we never create a swapchain
+		mWidth = width;
+		mHeight = height;
+		mIsFullScreen = isFullscreen;
+
+		mMainViewport.TopLeftX = 0.0f;
+		mMainViewport.TopLeftY = 0.0f;
+		mMainViewport.Width = static_cast<float>(width);
+		mMainViewport.Height = static_cast<float>(height);
+		mMainViewport.MinDepth = 0.0f;
+		mMainViewport.MaxDepth = 1.0f;
+		mCurrentViewport = mMainViewport;
+
+		mCurrentRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+
+		if (!isReset)
+		{
+			mCurrentFrameCommands.reserve(NULL_RHI_DEFAULT_COMMANDS_RESERVE);
+			mLastFrameCommands.reserve(NULL_RHI_DEFAULT_COMMANDS_RESERVE);
+			mCurrentFrameResources.reserve(NULL_RHI_DEFAULT_COMMANDS_RESERVE);
+			mLastFrameResources.reserve(NULL_RHI_DEFAULT_COMMANDS_RESERVE);
+		}
+
+		return true;
+	}
+
+	ER_RHI_Null_Command& ER_RHI_Null::RecordCommand(ER_RHI_NULL_COMMAND_TYPE aType, const void* aObject, int cmdListIndex)
+	{
+		static ER_RHI_Null_Command sDiscardedCommand;
+
+		mCurrentFrameCommandCounters[aType]++;
+		mTotalCommandCounters[aType]++;
+
+		if (!mIsRecording)
+		{
+			sDiscardedCommand = ER_RHI_Null_Command();
+			return sDiscardedCommand;
+		}
+
+		mCurrentFrameCommands.emplace_back();
+		ER_RHI_Null_Command& command = mCurrentFrameCommands.back();
+		command.Type = aType;
+		command.Object = aObject;
+		command.CommandListIndex = (cmdListIndex != -1) ? cmdListIndex : mCurrentGraphicsCommandListIndex;
+		return command;
+	}
+
+	template<typename TResources>
+	void ER_RHI_Null::RecordResources(ER_RHI_Null_Command& aCommand, const TResources& aResources)
+	{
+		if (!mIsRecording)
+			return;
+
+		aCommand.ResourcesIndex = static_cast<int>(mCurrentFrameResources.size());
+		for (UINT i = 0; i < static_cast<UINT>(aResources.size()); i++)
+			mCurrentFrameResources.push_back(aResources[i]);
+	}
+
+	const void* ER_RHI_Null::GetLastFrameBoundResource(const ER_RHI_Null_Command& aCommand, UINT aIndex) const
+	{
+		if (aCommand.ResourcesIndex < 0 || aIndex >= aCommand.Args[1])
+			return nullptr;
+		return mLastFrameResources[aCommand.ResourcesIndex + aIndex];
+	}
+
+	int ER_RHI_Null::InternName(const std::string& aName)
+	{
+		auto it = mNamesLookup.find(aName);
+		if (it != mNamesLookup.end())
+			return it->second;
+
+		int index = static_cast<int>(mNames.size());
+		mNames.push_back(aName);
+		mNamesLookup.emplace(aName, index);
+		return index;
+	}
+
+	const std::string& ER_RHI_Null::GetRecordedName(int aNameIndex) const
+	{
+		static const std::string sEmpty;
+		if (aNameIndex < 0 || aNameIndex >= static_cast<int>(mNames.size()))
+			return sEmpty;
+		return mNames[aNameIndex];
+	}
+
+	const char* ER_RHI_Null::GetCommandTypeName(ER_RHI_NULL_COMMAND_TYPE aType)
+	{
+		assert(aType < ER_NULL_CMD_COUNT);
+		return sNullCommandTypeNames[aType];
+	}
+
+	void ER_RHI_Null::ResetRecordedCommands()
+	{
+		mCurrentFrameCommands.clear();
+		mLastFrameCommands.clear();
+		mCurrentFrameResources.clear();
+		mLastFrameResources.clear();
+		memset(mCurrentFrameCommandCounters, 0, sizeof(mCurrentFrameCommandCounters));
+		memset(mLastFrameCommandCounters, 0, sizeof(mLastFrameCommandCounters));
+		memset(mTotalCommandCounters, 0, sizeof(mTotalCommandCounters));
+		mRecordedFramesCount = 0;
+	}
+
+	void ER_RHI_Null::DumpLastFrameCommands(const std::string& aPath)
+	{
+		std::ofstream file(aPath.c_str());
+		if (!file.is_open())
+		{
+			std::string message = "[ER Logger][ER_RHI_Null] Could not open a file for the commands dump: " + aPath + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
+			return;
+		}
+
+		file << "Frame: " << mRecordedFramesCount << ", commands: " << mLastFrameCommands.size() << "\n";
+		for (int i = 0; i < ER_NULL_CMD_COUNT; i++)
+		{
+			if (mLastFrameCommandCounters[i] > 0)
+				file << "  " << sNullCommandTypeNames[i] << ": " << mLastFrameCommandCounters[i] << "\n";
+		}
+
+		for (const auto& command : mLastFrameCommands)
+		{
+			file << "[" << command.CommandListIndex << "] " << sNullCommandTypeNames[command.Type] << " (" << command.Object << ")";
+			for (int i = 0; i < 5; i++)
+				file << " " << command.Args[i];
+			if (command.NameIndex != -1)
+				file << " \"" << mNames[command.NameIndex] << "\"";
+			if (command.ResourcesIndex != -1)
+			{
+				file << " {";
+				for (UINT i = 0; i < command.Args[1]; i++)
+					file << " " << mLastFrameResources[command.ResourcesIndex + i];
+				file << " }";
+			}
+			file << "\n";
+		}
+	}
+
+	void ER_RHI_Null::BeginGraphicsCommandList(int index)
+	{
+		mCurrentGraphicsCommandListIndex = index;
+		RecordCommand(ER_NULL_CMD_BEGIN_GRAPHICS_COMMAND_LIST, nullptr, index);
+	}
+
+	void ER_RHI_Null::EndGraphicsCommandList(int index)
+	{
+		RecordCommand(ER_NULL_CMD_END_GRAPHICS_COMMAND_LIST, nullptr, index);
+		mCurrentGraphicsCommandListIndex = -1;
+	}
+
+	void ER_RHI_Null::BeginComputeCommandList(int index)
+	{
+		mCurrentComputeCommandListIndex = index;
+		RecordCommand(ER_NULL_CMD_BEGIN_COMPUTE_COMMAND_LIST, nullptr, index);
+	}
+
+	void ER_RHI_Null::EndComputeCommandList(int index)
+	{
+		RecordCommand(ER_NULL_CMD_END_COMPUTE_COMMAND_LIST, nullptr, index);
+		mCurrentComputeCommandListIndex = -1;
+	}
+
+	void ER_RHI_Null::BeginCopyCommandList(int index)
+	{
+		RecordCommand(ER_NULL_CMD_BEGIN_COPY_COMMAND_LIST, nullptr, index);
+	}
+
+	void ER_RHI_Null::EndCopyCommandList(int index)
+	{
+		RecordCommand(ER_NULL_CMD_END_COPY_COMMAND_LIST, nullptr, index);
+	}
+
+	void ER_RHI_Null::ClearMainRenderTarget(float colors[4])
+	{
+		RecordCommand(ER_NULL_CMD_CLEAR_MAIN_RENDER_TARGET);
+	}
+
+	void ER_RHI_Null::ClearMainDepthStencilTarget(float depth, UINT stencil)
+	{
+		RecordCommand(ER_NULL_CMD_CLEAR_MAIN_DEPTH_STENCIL_TARGET).Args[0] = stencil;
+	}
+
+	void ER_RHI_Null::ClearRenderTarget(ER_RHI_GPUTexture* aRenderTarget, float colors[4], int rtvArrayIndex)
+	{
+		assert(aRenderTarget);
+		RecordCommand(ER_NULL_CMD_CLEAR_RENDER_TARGET, aRenderTarget).Args[0] = static_cast<UINT>(rtvArrayIndex);
+	}
+
+	void ER_RHI_Null::ClearDepthStencilTarget(ER_RHI_GPUTexture* aDepthTarget, float depth, UINT stencil)
+	{
+		assert(aDepthTarget);
+		RecordCommand(ER_NULL_CMD_CLEAR_DEPTH_STENCIL_TARGET, aDepthTarget).Args[0] = stencil;
+	}
+
+	void ER_RHI_Null::ClearUAV(ER_RHI_GPUResource* aRenderTarget, float colors[4])
+	{
+		assert(aRenderTarget);
+		RecordCommand(ER_NULL_CMD_CLEAR_UAV, aRenderTarget);
+	}
+
+	void ER_RHI_Null::ClearUAV(ER_RHI_GPUBuffer* aBuffer, UINT clear)
+	{
+		assert(aBuffer);
+		RecordCommand(ER_NULL_CMD_CLEAR_UAV, aBuffer).Args[0] = clear;
+	}
+
+	ER_RHI_GPUShader* ER_RHI_Null::CreateGPUShader()
+	{
+		return new ER_RHI_Null_GPUShader();
+	}
+
+	ER_RHI_GPUBuffer* ER_RHI_Null::CreateGPUBuffer(const std::string& aDebugName)
+	{
+		return new ER_RHI_Null_GPUBuffer(aDebugName);
+	}
+
+	ER_RHI_GPUTexture* ER_RHI_Null::CreateGPUTexture(const std::wstring& aDebugName)
+	{
+		return new ER_RHI_Null_GPUTexture(aDebugName);
+	}
+
+	ER_RHI_GPURootSignature* ER_RHI_Null::CreateRootSignature(UINT NumRootParams, UINT NumStaticSamplers)
+	{
+		return new ER_RHI_Null_GPURootSignature(NumRootParams, NumStaticSamplers);
+	}
+
+	ER_RHI_InputLayout* ER_RHI_Null::CreateInputLayout(ER_RHI_INPUT_ELEMENT_DESC* inputElementDescriptions, UINT inputElementDescriptionCount)
+	{
+		return new ER_RHI_Null_InputLayout(inputElementDescriptions, inputElementDescriptionCount);
+	}
+
+	void ER_RHI_Null::CreateTexture(ER_RHI_GPUTexture* aOutTexture, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags, int mip, int depth, int arraySize, bool isCubemap, int cubemapArraySize)
+	{
+		assert(aOutTexture);
+		aOutTexture->CreateGPUTextureResource(this, width, height, samples, format, bindFlags, mip, depth, arraySize, isCubemap, cubemapArraySize);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_CREATE_TEXTURE, aOutTexture);
+		command.Args[0] = width;
+		command.Args[1] = height;
+		command.Args[2] = static_cast<UINT>(format);
+	}
+
+	void ER_RHI_Null::CreateTexture(ER_RHI_GPUTexture* aOutTexture, const std::string& aPath, bool isFullPath)
+	{
+		assert(aOutTexture);
+		aOutTexture->CreateGPUTextureResource(this, aPath, isFullPath);
+		RecordCommand(ER_NULL_CMD_CREATE_TEXTURE, aOutTexture).NameIndex = InternName(aPath);
+	}
+
+	void ER_RHI_Null::CreateTexture(ER_RHI_GPUTexture* aOutTexture, const std::wstring& aPath, bool isFullPath)
+	{
+		assert(aOutTexture);
+		aOutTexture->CreateGPUTextureResource(this, aPath, isFullPath);
+		RecordCommand(ER_NULL_CMD_CREATE_TEXTURE, aOutTexture);
+	}
+
+	void ER_RHI_Null::CreateBuffer(ER_RHI_GPUBuffer* aOutBuffer, void* aData, UINT objectsCount, UINT byteStride, bool isDynamic, ER_RHI_BIND_FLAG bindFlags, UINT cpuAccessFlags, ER_RHI_RESOURCE_MISC_FLAG miscFlags, ER_RHI_FORMAT format)
+	{
+		assert(aOutBuffer);
+		aOutBuffer->CreateGPUBufferResource(this, aData, objectsCount, byteStride, isDynamic, bindFlags, cpuAccessFlags, miscFlags, format);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_CREATE_BUFFER, aOutBuffer);
+		command.Args[0] = objectsCount;
+		command.Args[1] = byteStride;
+		command.Args[2] = static_cast<UINT>(bindFlags);
+	}
+
+	void ER_RHI_Null::CopyBuffer(ER_RHI_GPUBuffer* aDestBuffer, ER_RHI_GPUBuffer* aSrcBuffer, int cmdListIndex, bool isInCopyQueue)
+	{
+		assert(aDestBuffer && aSrcBuffer);
+		static_cast<ER_RHI_Null_GPUBuffer*>(aDestBuffer)->CopyFrom(static_cast<ER_RHI_Null_GPUBuffer*>(aSrcBuffer));
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_COPY_BUFFER, aDestBuffer, cmdListIndex);
+		command.Args[0] = static_cast<UINT>(aSrcBuffer->GetSize());
+		command.Args[1] = isInCopyQueue ? 1 : 0;
+	}
+
+	void ER_RHI_Null::BeginBufferRead(ER_RHI_GPUBuffer* aBuffer, void** output)
+	{
+		assert(aBuffer);
+		assert(!mIsContextReadingBuffer);
+
+		*output = aBuffer->GetBuffer();
+		mIsContextReadingBuffer = true;
+		RecordCommand(ER_NULL_CMD_BUFFER_READ, aBuffer);
+	}
+
+	void ER_RHI_Null::EndBufferRead(ER_RHI_GPUBuffer* aBuffer)
+	{
+		assert(aBuffer);
+		mIsContextReadingBuffer = false;
+	}
+
+	void ER_RHI_Null::CopyGPUTextureSubresourceRegion(ER_RHI_GPUResource* aDestBuffer, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ, ER_RHI_GPUResource* aSrcBuffer, UINT SrcSubresource, bool isInCopyQueueOrSkipTransitions)
+	{
+		assert(aDestBuffer && aSrcBuffer);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_COPY_TEXTURE_REGION, aDestBuffer);
+		command.Args[0] = DstSubresource;
+		command.Args[1] = SrcSubresource;
+	}
+
+	void ER_RHI_Null::Draw(UINT VertexCount)
+	{
+		RecordCommand(ER_NULL_CMD_DRAW).Args[0] = VertexCount;
+	}
+
+	void ER_RHI_Null::DrawIndexed(UINT IndexCount)
+	{
+		RecordCommand(ER_NULL_CMD_DRAW_INDEXED).Args[0] = IndexCount;
+	}
+
+	void ER_RHI_Null::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_DRAW_INSTANCED);
+		command.Args[0] = VertexCountPerInstance;
+		command.Args[1] = InstanceCount;
+		command.Args[2] = StartVertexLocation;
+		command.Args[3] = StartInstanceLocation;
+	}
+
+	void ER_RHI_Null::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_DRAW_INDEXED_INSTANCED);
+		command.Args[0] = IndexCountPerInstance;
+		command.Args[1] = InstanceCount;
+		command.Args[2] = StartIndexLocation;
+		command.Args[3] = static_cast<UINT>(BaseVertexLocation);
+		command.Args[4] = StartInstanceLocation;
+	}
+
+	void ER_RHI_Null::DrawIndexedInstancedIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset)
+	{
+		assert(anArgsBuffer);
+		RecordCommand(ER_NULL_CMD_DRAW_INDEXED_INSTANCED_INDIRECT, anArgsBuffer).Args[0] = alignedByteOffset;
+	}
+
+	void ER_RHI_Null::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_DISPATCH, nullptr, mCurrentComputeCommandListIndex != -1 ? mCurrentComputeCommandListIndex : mCurrentGraphicsCommandListIndex);
+		command.Args[0] = ThreadGroupCountX;
+		command.Args[1] = ThreadGroupCountY;
+		command.Args[2] = ThreadGroupCountZ;
+	}
+
+	void ER_RHI_Null::GenerateMips(ER_RHI_GPUTexture* aTexture, ER_RHI_GPUTexture* aSRGBTexture)
+	{
+		assert(aTexture);
+		RecordCommand(ER_NULL_CMD_GENERATE_MIPS, aTexture);
+	}
+
+	void ER_RHI_Null::ExecuteCommandLists(int commandListIndex, bool isCompute)
+	{
+		RecordCommand(ER_NULL_CMD_EXECUTE_COMMAND_LISTS, nullptr, commandListIndex).Args[0] = isCompute ? 1 : 0;
+	}
+
+	void ER_RHI_Null::ExecuteCopyCommandList()
+	{
+		RecordCommand(ER_NULL_CMD_EXECUTE_COMMAND_LISTS).Args[1] = 1;
+	}
+
+	void ER_RHI_Null::PresentGraphics()
+	{
+		RecordCommand(ER_NULL_CMD_PRESENT);
+
+		// current frame becomes "last frame" (we keep the capacity of both streams to avoid reallocations)
+		std::swap(mCurrentFrameCommands, mLastFrameCommands);
+		mCurrentFrameCommands.clear();
+		std::swap(mCurrentFrameResources, mLastFrameResources);
+		mCurrentFrameResources.clear();
+		memcpy(mLastFrameCommandCounters, mCurrentFrameCommandCounters, sizeof(mCurrentFrameCommandCounters));
+		memset(mCurrentFrameCommandCounters, 0, sizeof(mCurrentFrameCommandCounters));
+		mRecordedFramesCount++;
+	}
+
+	void ER_RHI_Null::SetMainRenderTargets(int cmdListIndex)
+	{
+		RecordCommand(ER_NULL_CMD_SET_RENDER_TARGETS, nullptr, cmdListIndex).Args[0] = 1;
+		SetViewport(mMainViewport);
+	}
+
+	void ER_RHI_Null::SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget, ER_RHI_GPUTexture* aUAV, int rtvArrayIndex)
+	{
+		assert(aRenderTargets.size() > 0 || aDepthTarget);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_RENDER_TARGETS, aRenderTargets.size() > 0 ? aRenderTargets[0] : nullptr);
+		command.Args[0] = static_cast<UINT>(aRenderTargets.size());
+		command.Args[1] = aDepthTarget ? 1 : 0;
+		command.Args[2] = aUAV ? 1 : 0;
+		command.Args[3] = static_cast<UINT>(rtvArrayIndex);
+	}
+
+	void ER_RHI_Null::SetDepthTarget(ER_RHI_GPUTexture* aDepthTarget)
+	{
+		assert(aDepthTarget);
+		RecordCommand(ER_NULL_CMD_SET_DEPTH_TARGET, aDepthTarget);
+	}
+
+	void ER_RHI_Null::SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE aDS, UINT stencilRef)
+	{
+		mCurrentDS = aDS;
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_DEPTH_STENCIL_STATE);
+		command.Args[0] = static_cast<UINT>(aDS);
+		command.Args[1] = stencilRef;
+	}
+
+	void ER_RHI_Null::SetBlendState(ER_RHI_BLEND_STATE aBS, const float BlendFactor[4], UINT SampleMask)
+	{
+		mCurrentBS = aBS;
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_BLEND_STATE);
+		command.Args[0] = static_cast<UINT>(aBS);
+		command.Args[1] = SampleMask;
+	}
+
+	void ER_RHI_Null::SetRasterizerState(ER_RHI_RASTERIZER_STATE aRS)
+	{
+		mCurrentRS = aRS;
+		RecordCommand(ER_NULL_CMD_SET_RASTERIZER_STATE).Args[0] = static_cast<UINT>(aRS);
+	}
+
+	void ER_RHI_Null::SetViewport(const ER_RHI_Viewport& aViewport)
+	{
+		mCurrentViewport = aViewport;
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_VIEWPORT);
+		command.Args[0] = static_cast<UINT>(aViewport.Width);
+		command.Args[1] = static_cast<UINT>(aViewport.Height);
+	}
+
+	void ER_RHI_Null::SetRect(const ER_RHI_Rect& rect)
+	{
+		mCurrentRect = rect;
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_RECT);
+		command.Args[0] = static_cast<UINT>(rect.right - rect.left);
+		command.Args[1] = static_cast<UINT>(rect.bottom - rect.top);
+	}
+
+	void ER_RHI_Null::SetShader(ER_RHI_GPUShader* aShader)
+	{
+		assert(aShader);
+		RecordCommand(ER_NULL_CMD_SET_SHADER, aShader).Args[0] = static_cast<UINT>(aShader->mShaderType);
+	}
+
+	void ER_RHI_Null::SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot,
+		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS, bool skipAutomaticTransition)
+	{
+		assert(aSRVs.size() > 0);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_SHADER_RESOURCES, rs);
+		command.Args[0] = static_cast<UINT>(aShaderType);
+		command.Args[1] = static_cast<UINT>(aSRVs.size());
+		command.Args[2] = startSlot;
+		command.Args[3] = static_cast<UINT>(rootParamIndex);
+		RecordResources(command, aSRVs);
+	}
+
+	void ER_RHI_Null::SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot,
+		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS, bool skipAutomaticTransition)
+	{
+		assert(aUAVs.size() > 0);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_UNORDERED_ACCESS_RESOURCES, rs);
+		command.Args[0] = static_cast<UINT>(aShaderType);
+		command.Args[1] = static_cast<UINT>(aUAVs.size());
+		command.Args[2] = startSlot;
+		command.Args[3] = static_cast<UINT>(rootParamIndex);
+		RecordResources(command, aUAVs);
+	}
+
+	void ER_RHI_Null::SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot,
+		ER_RHI_GPURootSignature* rs, int rootParamIndex, bool isComputeRS)
+	{
+		assert(aCBs.size() > 0);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_CONSTANT_BUFFERS, rs);
+		command.Args[0] = static_cast<UINT>(aShaderType);
+		command.Args[1] = static_cast<UINT>(aCBs.size());
+		command.Args[2] = startSlot;
+		command.Args[3] = static_cast<UINT>(rootParamIndex);
+		RecordResources(command, aCBs);
+	}
+
+	void ER_RHI_Null::SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot, ER_RHI_GPURootSignature* rs)
+	{
+		assert(aSamplers.size() > 0);
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_SAMPLERS, rs);
+		command.Args[0] = static_cast<UINT>(aShaderType);
+		command.Args[1] = static_cast<UINT>(aSamplers.size());
+		command.Args[2] = startSlot;
+	}
+
+	void ER_RHI_Null::SetRootSignature(ER_RHI_GPURootSignature* rs, bool isCompute)
+	{
+		assert(rs);
+		RecordCommand(ER_NULL_CMD_SET_ROOT_SIGNATURE, rs).Args[0] = isCompute ? 1 : 0;
+	}
+
+	void ER_RHI_Null::SetRootConstant(UINT aConstant, UINT aRootIndex, UINT anOffset, bool isCompute)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_ROOT_CONSTANT);
+		command.Args[0] = aConstant;
+		command.Args[1] = aRootIndex;
+		command.Args[2] = anOffset;
+		command.Args[3] = isCompute ? 1 : 0;
+	}
+
+	void ER_RHI_Null::SetIndexBuffer(ER_RHI_GPUBuffer* aBuffer, UINT offset)
+	{
+		assert(aBuffer);
+		RecordCommand(ER_NULL_CMD_SET_INDEX_BUFFER, aBuffer).Args[0] = offset;
+	}
+
+	void ER_RHI_Null::SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers)
+	{
+		assert(aVertexBuffers.size() > 0 && aVertexBuffers.size() <= ER_RHI_MAX_BOUND_VERTEX_BUFFERS);
+		RecordCommand(ER_NULL_CMD_SET_VERTEX_BUFFERS, aVertexBuffers[0]).Args[0] = static_cast<UINT>(aVertexBuffers.size());
+	}
+
+	void ER_RHI_Null::SetInputLayout(ER_RHI_InputLayout* aIL)
+	{
+		assert(aIL);
+		RecordCommand(ER_NULL_CMD_SET_INPUT_LAYOUT, aIL);
+	}
+
+	void ER_RHI_Null::SetEmptyInputLayout()
+	{
+		RecordCommand(ER_NULL_CMD_SET_INPUT_LAYOUT);
+	}
+
+	void ER_RHI_Null::SetTopologyType(ER_RHI_PRIMITIVE_TYPE aType)
+	{
+		mCurrentTopologyType = aType;
+		RecordCommand(ER_NULL_CMD_SET_TOPOLOGY).Args[0] = static_cast<UINT>(aType);
+	}
+
+	void ER_RHI_Null::SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE aType, bool aReset)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_DESCRIPTOR_HEAP);
+		command.Args[0] = static_cast<UINT>(aType);
+		command.Args[1] = aReset ? 1 : 0;
+	}
+
+	void ER_RHI_Null::TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE> aStates, int cmdListIndex, bool isCopyQueue, int subresourceIndex)
+	{
+		assert(aResources.size() == aStates.size());
+		for (int i = 0; i < static_cast<int>(aResources.size()); i++)
+			aResources[i]->SetCurrentState(aStates[i]);
+
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_TRANSITION_RESOURCES, nullptr, cmdListIndex);
+		command.Args[0] = static_cast<UINT>(aResources.size());
+		command.Args[1] = static_cast<UINT>(subresourceIndex);
+	}
+
+	void ER_RHI_Null::TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex, bool isCopyQueue, int subresourceIndex)
+	{
+		for (auto resource : aResources)
+			resource->SetCurrentState(aState);
+
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_TRANSITION_RESOURCES, nullptr, cmdListIndex);
+		command.Args[0] = static_cast<UINT>(aResources.size());
+		command.Args[1] = static_cast<UINT>(subresourceIndex);
+		command.Args[2] = static_cast<UINT>(aState);
+	}
+
+	bool ER_RHI_Null::IsPSOReady(const ER_RHI_PSOHandle& aPSO, bool isCompute)
+	{
+		const auto& psos = isCompute ? mComputePSOs : mGraphicsPSOs;
+		auto it = psos.find(aPSO.GetHash());
+		return it != psos.end() && it->second.IsFinalized;
+	}
+
+	void ER_RHI_Null::InitializePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute)
+	{
+		auto& psos = isCompute ? mComputePSOs : mGraphicsPSOs;
+		ER_RHI_Null_PSO& pso = psos[aPSO.GetHash()];
+		if (pso.NameIndex < 0)
+			pso.NameIndex = InternName(aPSO.GetName());
+		RecordCommand(ER_NULL_CMD_INITIALIZE_PSO).NameIndex = pso.NameIndex;
+	}
+
+	void ER_RHI_Null::FinalizePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute)
+	{
+		auto& psos = isCompute ? mComputePSOs : mGraphicsPSOs;
+		auto it = psos.find(aPSO.GetHash());
+		if (it == psos.end())
+			throw ER_CoreException(("ER_RHI_Null: Could not finalize PSO because it was not initialized: " + aPSO.GetName()).c_str());
+		it->second.IsFinalized = true;
+		RecordCommand(ER_NULL_CMD_FINALIZE_PSO).NameIndex = it->second.NameIndex;
+	}
+
+	void ER_RHI_Null::SetPSO(const ER_RHI_PSOHandle& aPSO, bool isCompute)
+	{
+		const auto& psos = isCompute ? mComputePSOs : mGraphicsPSOs;
+		auto it = psos.find(aPSO.GetHash());
+		if (it == psos.end() || !it->second.IsFinalized)
+			throw ER_CoreException(("ER_RHI_Null: Could not set PSO because it was not finalized: " + aPSO.GetName()).c_str());
+
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_SET_PSO);
+		command.NameIndex = it->second.NameIndex;
+		command.Args[0] = isCompute ? 1 : 0;
+	}
+
+	void ER_RHI_Null::UnsetPSO()
+	{
+		RecordCommand(ER_NULL_CMD_UNSET_PSO);
+	}
+
+	void ER_RHI_Null::UnbindRenderTargets()
+	{
+		RecordCommand(ER_NULL_CMD_UNBIND_RENDER_TARGETS);
+	}
+
+	void ER_RHI_Null::UnbindResourcesFromShader(ER_RHI_SHADER_TYPE aShaderType, bool unbindShader)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_UNBIND_RESOURCES);
+		command.Args[0] = static_cast<UINT>(aShaderType);
+		command.Args[1] = unbindShader ? 1 : 0;
+	}
+
+	void ER_RHI_Null::UpdateBuffer(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, bool updateForAllBackBuffers)
+	{
+		assert(aBuffer);
+		assert(aBuffer->GetSize() >= dataSize);
+		static_cast<ER_RHI_Null_GPUBuffer*>(aBuffer)->Update(aData, dataSize);
+		RecordCommand(ER_NULL_CMD_UPDATE_BUFFER, aBuffer).Args[0] = static_cast<UINT>(dataSize);
+	}
+
+	void ER_RHI_Null::InitImGui()
+	{
+		// no renderer backend: we only need the font atlas to be built, so that ImGui::NewFrame() does not assert
+		ImGuiIO& io = ImGui::GetIO();
+		unsigned char* pixels = nullptr;
+		int width, height;
+		io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+		io.Fonts->SetTexID(nullptr);
+		mIsImGuiInitialized = true;
+	}
+
+	void ER_RHI_Null::StartNewImGuiFrame()
+	{
+		assert(mIsImGuiInitialized);
+	}
+
+	void ER_RHI_Null::ShutdownImGui()
+	{
+		mIsImGuiInitialized = false;
+	}
+
+	void ER_RHI_Null::OnWindowSizeChanged(int width, int height)
+	{
+		mWidth = static_cast<UINT>(width);
+		mHeight = static_cast<UINT>(height);
+		mMainViewport.Width = static_cast<float>(width);
+		mMainViewport.Height = static_cast<float>(height);
+	}
+
+	void ER_RHI_Null::ResetRHI(int width, int height, bool isFullscreen)
+	{
+		Initialize(mWindowHandle, width, height, isFullscreen, true);
+	}
+
+	void ER_RHI_Null::BeginEventTag(const std::string& aName, bool isComputeQueue)
+	{
+		ER_RHI_Null_Command& command = RecordCommand(ER_NULL_CMD_BEGIN_EVENT_TAG);
+		command.NameIndex = InternName(aName);
+		command.Args[0] = isComputeQueue ? 1 : 0;
+	}
+
+	void ER_RHI_Null::EndEventTag(bool isComputeQueue)
+	{
+		RecordCommand(ER_NULL_CMD_END_EVENT_TAG).Args[0] = isComputeQueue ? 1 : 0;
+	}
+}
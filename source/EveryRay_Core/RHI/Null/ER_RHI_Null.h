@@ -0,0 +1,272 @@
+#pragma once
+#include "..\ER_RHI.h"
+
+#define NULL_RHI_DEFAULT_COMMANDS_RESERVE 65536
+
+namespace EveryRay_Core
+{
+	// All commands that are recorded by ER_RHI_Null (one per API call that would normally go to the GPU).
+	// Keep in sync with ER_RHI_Null::GetCommandTypeName()
+	enum ER_RHI_NULL_COMMAND_TYPE
+	{
+		ER_NULL_CMD_BEGIN_GRAPHICS_COMMAND_LIST = 0,
+		ER_NULL_CMD_END_GRAPHICS_COMMAND_LIST,
+		ER_NULL_CMD_BEGIN_COMPUTE_COMMAND_LIST,
+		ER_NULL_CMD_END_COMPUTE_COMMAND_LIST,
+		ER_NULL_CMD_BEGIN_COPY_COMMAND_LIST,
+		ER_NULL_CMD_END_COPY_COMMAND_LIST,
+		ER_NULL_CMD_CLEAR_MAIN_RENDER_TARGET,
+		ER_NULL_CMD_CLEAR_MAIN_DEPTH_STENCIL_TARGET,
+		ER_NULL_CMD_CLEAR_RENDER_TARGET,
+		ER_NULL_CMD_CLEAR_DEPTH_STENCIL_TARGET,
+		ER_NULL_CMD_CLEAR_UAV,
+		ER_NULL_CMD_CREATE_TEXTURE,
+		ER_NULL_CMD_CREATE_BUFFER,
+		ER_NULL_CMD_COPY_BUFFER,
+		ER_NULL_CMD_BUFFER_READ,
+		ER_NULL_CMD_COPY_TEXTURE_REGION,
+		ER_NULL_CMD_DRAW,
+		ER_NULL_CMD_DRAW_INDEXED,
+		ER_NULL_CMD_DRAW_INSTANCED,
+		ER_NULL_CMD_DRAW_INDEXED_INSTANCED,
+		ER_NULL_CMD_DRAW_INDEXED_INSTANCED_INDIRECT,
+		ER_NULL_CMD_DISPATCH,
+		ER_NULL_CMD_GENERATE_MIPS,
+		ER_NULL_CMD_EXECUTE_COMMAND_LISTS,
+		ER_NULL_CMD_PRESENT,
+		ER_NULL_CMD_SET_RENDER_TARGETS,
+		ER_NULL_CMD_SET_DEPTH_TARGET,
+		ER_NULL_CMD_SET_DEPTH_STENCIL_STATE,
+		ER_NULL_CMD_SET_BLEND_STATE,
+		ER_NULL_CMD_SET_RASTERIZER_STATE,
+		ER_NULL_CMD_SET_VIEWPORT,
+		ER_NULL_CMD_SET_RECT,
+		ER_NULL_CMD_SET_SHADER,
+		ER_NULL_CMD_SET_SHADER_RESOURCES,
+		ER_NULL_CMD_SET_UNORDERED_ACCESS_RESOURCES,
+		ER_NULL_CMD_SET_CONSTANT_BUFFERS,
+		ER_NULL_CMD_SET_SAMPLERS,
+		ER_NULL_CMD_SET_ROOT_SIGNATURE,
+		ER_NULL_CMD_SET_ROOT_CONSTANT,
+		ER_NULL_CMD_SET_INDEX_BUFFER,
+		ER_NULL_CMD_SET_VERTEX_BUFFERS,
+		ER_NULL_CMD_SET_INPUT_LAYOUT,
+		ER_NULL_CMD_SET_TOPOLOGY,
+		ER_NULL_CMD_SET_DESCRIPTOR_HEAP,
+		ER_NULL_CMD_TRANSITION_RESOURCES,
+		ER_NULL_CMD_INITIALIZE_PSO,
+		ER_NULL_CMD_FINALIZE_PSO,
+		ER_NULL_CMD_SET_PSO,
+		ER_NULL_CMD_UNSET_PSO,
+		ER_NULL_CMD_UNBIND_RENDER_TARGETS,
+		ER_NULL_CMD_UNBIND_RESOURCES,
+		ER_NULL_CMD_UPDATE_BUFFER,
+		ER_NULL_CMD_BEGIN_EVENT_TAG,
+		ER_NULL_CMD_END_EVENT_TAG,
+
+		ER_NULL_CMD_COUNT
+	};
+
+	// One recorded call. We do not store copies of the data (only pointers and counters), so recording stays cheap
+	// and the CPU cost that we measure is mostly the engine's submission cost, not the one of the backend.
+	struct ER_RHI_Null_Command
+	{
+		ER_RHI_NULL_COMMAND_TYPE Type;
+		int CommandListIndex = -1;
+		const void* Object = nullptr; // main object of the call (resource, shader, root signature, etc.)
+		UINT Args[5] = { 0, 0, 0, 0, 0 }; // call specific arguments (counts, slots, offsets, states...)
+		int NameIndex = -1; // index into the interned names table (PSO names, event tags), -1 if not used
+		int ResourcesIndex = -1; // first of the Args[1] bound resources (SRVs, UAVs, CBs) in the frame's resources table, -1 if not used
+	};
+
+	class ER_RHI_Null_GPURootSignature;
+
+	// "Headless" RHI that creates no device and records every call into an inspectable command stream.
+	// Useful for measuring CPU submission cost (i.e., ER_Sandbox::Draw) and for regression testing on machines without a GPU.
+	class ER_RHI_Null : public ER_RHI
+	{
+	public:
+		ER_RHI_Null();
+		virtual ~ER_RHI_Null();
+
+		virtual bool Initialize(HWND windowHandle, UINT width, UINT height, bool isFullscreen, bool isReset = false) override;
+
+		virtual void BeginGraphicsCommandList(int index = 0) override;
+		virtual void EndGraphicsCommandList(int index = 0) override;
+
+		virtual void BeginComputeCommandList(int index = 0) override;
+		virtual void EndComputeCommandList(int index = 0) override;
+
+		virtual void BeginCopyCommandList(int index = 0) override;
+		virtual void EndCopyCommandList(int index = 0) override;
+
+		virtual void ClearMainRenderTarget(float colors[4]) override;
+		virtual void ClearMainDepthStencilTarget(float depth, UINT stencil = 0) override;
+		virtual void ClearRenderTarget(ER_RHI_GPUTexture* aRenderTarget, float colors[4], int rtvArrayIndex = -1) override;
+		virtual void ClearDepthStencilTarget(ER_RHI_GPUTexture* aDepthTarget, float depth, UINT stencil = 0) override;
+		virtual void ClearUAV(ER_RHI_GPUResource* aRenderTarget, float colors[4]) override;
+		virtual void ClearUAV(ER_RHI_GPUBuffer* aBuffer, UINT clear) override;
+
+		virtual ER_RHI_GPUShader* CreateGPUShader() override;
+		virtual ER_RHI_GPUBuffer* CreateGPUBuffer(const std::string& aDebugName) override;
+		virtual ER_RHI_GPUTexture* CreateGPUTexture(const std::wstring& aDebugName) override;
+		virtual ER_RHI_GPURootSignature* CreateRootSignature(UINT NumRootParams = 0, UINT NumStaticSamplers = 0) override;
+		virtual ER_RHI_InputLayout* CreateInputLayout(ER_RHI_INPUT_ELEMENT_DESC* inputElementDescriptions, UINT inputElementDescriptionCount) override;
+
+		virtual void CreateTexture(ER_RHI_GPUTexture* aOutTexture, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE,
+			int mip = 1, int depth = -1, int arraySize = 1, bool isCubemap = false, int cubemapArraySize = -1) override;
+		virtual void CreateTexture(ER_RHI_GPUTexture* aOutTexture, const std::string& aPath, bool isFullPath = false) override;
+		virtual void CreateTexture(ER_RHI_GPUTexture* aOutTexture, const std::wstring& aPath, bool isFullPath = false) override;
+
+		virtual void CreateBuffer(ER_RHI_GPUBuffer* aOutBuffer, void* aData, UINT objectsCount, UINT byteStride, bool isDynamic = false, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE, UINT cpuAccessFlags = 0, ER_RHI_RESOURCE_MISC_FLAG miscFlags = ER_RESOURCE_MISC_NONE, ER_RHI_FORMAT format = ER_FORMAT_UNKNOWN) override;
+		virtual void CopyBuffer(ER_RHI_GPUBuffer* aDestBuffer, ER_RHI_GPUBuffer* aSrcBuffer, int cmdListIndex, bool isInCopyQueue = false) override;
+		virtual void BeginBufferRead(ER_RHI_GPUBuffer* aBuffer, void** output) override;
+		virtual void EndBufferRead(ER_RHI_GPUBuffer* aBuffer) override;
+
+		virtual void CopyGPUTextureSubresourceRegion(ER_RHI_GPUResource* aDestBuffer, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ, ER_RHI_GPUResource* aSrcBuffer, UINT SrcSubresource, bool isInCopyQueueOrSkipTransitions = false) override;
+
+		virtual void Draw(UINT VertexCount) override;
+		virtual void DrawIndexed(UINT IndexCount) override;
+		virtual void DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation) override;
+		virtual void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation) override;
+		virtual void DrawIndexedInstancedIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) override;
+
+		virtual void Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override;
+
+		virtual void GenerateMips(ER_RHI_GPUTexture* aTexture, ER_RHI_GPUTexture* aSRGBTexture = nullptr) override;
+		virtual void GenerateMipsWithTextureReplacement(ER_RHI_GPUTexture** aTexture, std::function<void(ER_RHI_GPUTexture**)> aReplacementCallback) override {}; // nothing to replace, textures are not real
+		virtual void ReplaceOriginalTexturesWithMipped() override {};
+
+		virtual void ExecuteCommandLists(int commandListIndex = 0, bool isCompute = false) override;
+		virtual void ExecuteCopyCommandList() override;
+
+		virtual void PresentGraphics() override;
+		virtual void PresentCompute() override {};
+
+		virtual bool ProjectCubemapToSH(ER_RHI_GPUTexture* aTexture, UINT order, float* resultR, float* resultG, float* resultB) override { return false; } // no texel data on the null RHI
+
+		virtual void SaveGPUTextureToFile(ER_RHI_GPUTexture* aTexture, const std::wstring& aPathName) override {};
+
+		virtual void SetMainRenderTargets(int cmdListIndex = 0) override;
+		virtual void SetRenderTargets(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr, ER_RHI_GPUTexture* aUAV = nullptr, int rtvArrayIndex = -1) override;
+		virtual void SetDepthTarget(ER_RHI_GPUTexture* aDepthTarget) override;
+		virtual void SetRenderTargetFormats(ER_RHI_ArrayView<ER_RHI_GPUTexture*> aRenderTargets, ER_RHI_GPUTexture* aDepthTarget = nullptr) override {};
+		virtual void SetMainRenderTargetFormats() override {};
+
+		virtual void SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE aDS, UINT stencilRef = 0xffffffff) override;
+		virtual void SetBlendState(ER_RHI_BLEND_STATE aBS, const float BlendFactor[4] = nullptr, UINT SampleMask = 0xffffffff) override;
+		virtual void SetRasterizerState(ER_RHI_RASTERIZER_STATE aRS) override;
+
+		virtual void SetViewport(const ER_RHI_Viewport& aViewport) override;
+		virtual void SetRect(const ER_RHI_Rect& rect) override;
+
+		virtual void SetShader(ER_RHI_GPUShader* aShader) override;
+
+		virtual void SetShaderResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aSRVs, UINT startSlot = 0,
+			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) override;
+		virtual void SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUResource*> aUAVs, UINT startSlot = 0,
+			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false, bool skipAutomaticTransition = false) override;
+		virtual void SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aCBs, UINT startSlot = 0,
+			ER_RHI_GPURootSignature* rs = nullptr, int rootParamIndex = -1, bool isComputeRS = false) override;
+		virtual void SetSamplers(ER_RHI_SHADER_TYPE aShaderType, ER_RHI_ArrayView<ER_RHI_SAMPLER_STATE> aSamplers, UINT startSlot = 0, ER_RHI_GPURootSignature* rs = nullptr) override;
+
+		virtual void SetRootSignature(ER_RHI_GPURootSignature* rs, bool isCompute = false) override;
+		virtual void SetRootConstant(UINT aConstant, UINT aRootIndex, UINT anOffset = 0, bool isCompute = false) override;
+
+		virtual void SetIndexBuffer(ER_RHI_GPUBuffer* aBuffer, UINT offset = 0) override;
+		virtual void SetVertexBuffers(ER_RHI_ArrayView<ER_RHI_GPUBuffer*> aVertexBuffers) override;
+		virtual void SetInputLayout(ER_RHI_InputLayout* aIL) override;
+		virtual void SetEmptyInputLayout() override;
+
+		virtual void SetTopologyType(ER_RHI_PRIMITIVE_TYPE aType) override;
+		virtual ER_RHI_PRIMITIVE_TYPE GetCurrentTopologyType() override { return mCurrentTopologyType; }
+
+		virtual void SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE aType, bool aReset) override;
+		virtual void SetGPUDescriptorHeapImGui(int cmdListIndex) override {};
+
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_ArrayView<ER_RHI_RESOURCE_STATE> aStates, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override;
+		virtual void TransitionResources(ER_RHI_ArrayView<ER_RHI_GPUResource*> aResources, ER_RHI_RESOURCE_STATE aState, int cmdListIndex = 0, bool isCopyQueue = false, int subresourceIndex = -1) override;
+		virtual void TransitionMainRenderTargetToPresent(int cmdListIndex = 0) override {};
+
+		virtual bool IsPSOReady(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void InitializePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void SetRootSignatureToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_GPURootSignature* rs, bool isCompute = false) override {};
+		virtual void SetTopologyTypeToPSO(const ER_RHI_PSOHandle& aPSO, ER_RHI_PRIMITIVE_TYPE aType) override {};
+		virtual void FinalizePSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void SetPSO(const ER_RHI_PSOHandle& aPSO, bool isCompute = false) override;
+		virtual void UnsetPSO() override;
+
+		virtual void UnbindRenderTargets() override;
+		virtual void UnbindResourcesFromShader(ER_RHI_SHADER_TYPE aShaderType, bool unbindShader = true) override;
+
+		virtual void UpdateBuffer(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, bool updateForAllBackBuffers = false) override;
+
+		virtual bool IsHardwareRaytracingSupported() override { return false; }
+		virtual bool IsRootConstantSupported() override { return true; }
+
+		virtual void InitImGui() override;
+		virtual void StartNewImGuiFrame() override;
+		virtual void RenderDrawDataImGui(int cmdListIndex = 0) override {};
+		virtual void ShutdownImGui() override;
+
+		virtual void OnWindowSizeChanged(int width, int height) override;
+
+		virtual void WaitForGpuOnGraphicsFence() override {};
+		virtual void WaitForGpuOnComputeFence() override {};
+		virtual void WaitForGpuOnCopyFence() override {};
+
+		virtual void ResetReplacementMippedTexturesPool() override {};
+		virtual void ResetDescriptorManager() override {};
+		virtual void ResetRHI(int width, int height, bool isFullscreen) override;
+
+		virtual void BeginEventTag(const std::string& aName, bool isComputeQueue = false) override;
+		virtual void EndEventTag(bool isComputeQueue = false) override;
+
+		// recorded command stream
+		const std::vector<ER_RHI_Null_Command>& GetCurrentFrameCommands() const { return mCurrentFrameCommands; }
+		const std::vector<ER_RHI_Null_Command>& GetLastFrameCommands() const { return mLastFrameCommands; } // commands until the last PresentGraphics()
+		const void* GetLastFrameBoundResource(const ER_RHI_Null_Command& aCommand, UINT aIndex) const; // i.e., SRV bound at slot "Args[2] + aIndex"
+		UINT GetLastFrameCommandsCount(ER_RHI_NULL_COMMAND_TYPE aType) const { return mLastFrameCommandCounters[aType]; }
+		UINT64 GetTotalCommandsCount(ER_RHI_NULL_COMMAND_TYPE aType) const { return mTotalCommandCounters[aType]; }
+		UINT64 GetRecordedFramesCount() const { return mRecordedFramesCount; }
+		const std::string& GetRecordedName(int aNameIndex) const;
+		static const char* GetCommandTypeName(ER_RHI_NULL_COMMAND_TYPE aType);
+
+		void SetRecordingEnabled(bool value) { mIsRecording = value; }
+		bool IsRecordingEnabled() const { return mIsRecording; }
+		void ResetRecordedCommands();
+		void DumpLastFrameCommands(const std::string& aPath);
+	private:
+		ER_RHI_Null_Command& RecordCommand(ER_RHI_NULL_COMMAND_TYPE aType, const void* aObject = nullptr, int cmdListIndex = -1);
+		int InternName(const std::string& aName);
+		template<typename TResources> void RecordResources(ER_RHI_Null_Command& aCommand, const TResources& aResources); // std::vector or ER_RHI_ArrayView of resources
+
+		std::vector<ER_RHI_Null_Command> mCurrentFrameCommands;
+		std::vector<ER_RHI_Null_Command> mLastFrameCommands;
+		std::vector<const void*> mCurrentFrameResources; // resources of the binding commands (referenced from ER_RHI_Null_Command::ResourcesIndex)
+		std::vector<const void*> mLastFrameResources;
+		UINT mCurrentFrameCommandCounters[ER_NULL_CMD_COUNT] = { 0 };
+		UINT mLastFrameCommandCounters[ER_NULL_CMD_COUNT] = { 0 };
+		UINT64 mTotalCommandCounters[ER_NULL_CMD_COUNT] = { 0 };
+		UINT64 mRecordedFramesCount = 0;
+
+		std::vector<std::string> mNames; // interned names (referenced from ER_RHI_Null_Command::NameIndex)
+		std::unordered_map<std::string, int> mNamesLookup;
+
+		struct ER_RHI_Null_PSO
+		{
+			int NameIndex = -1;
+			bool IsFinalized = false;
+		};
+		std::unordered_map<UINT64, ER_RHI_Null_PSO> mGraphicsPSOs; // key - ER_RHI_PSOHandle hash
+		std::unordered_map<UINT64, ER_RHI_Null_PSO> mComputePSOs; // key - ER_RHI_PSOHandle hash
+
+		ER_RHI_PRIMITIVE_TYPE mCurrentTopologyType = ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		ER_RHI_Viewport mMainViewport;
+		UINT mWidth = 0;
+		UINT mHeight = 0;
+		bool mIsRecording = true;
+		bool mIsContextReadingBuffer = false;
+		bool mIsImGuiInitialized = false;
+	};
+}
@@ -0,0 +1,158 @@
+#include "ER_RHI_Null_GPUResources.h"
+#include "..\..\ER_CoreException.h"
+#include "..\..\ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	///****************************************************************************************************************************
+	// *** ER_RHI_Null_GPUBuffer ***
+	void ER_RHI_Null_GPUBuffer::CreateGPUBufferResource(ER_RHI* aRHI, void* aData, UINT objectsCount, UINT byteStride, bool isDynamic /*= false*/, ER_RHI_BIND_FLAG bindFlags /*= 0*/,
+		UINT cpuAccessFlags /*= 0*/, ER_RHI_RESOURCE_MISC_FLAG miscFlags /*= 0*/, ER_RHI_FORMAT format /*= ER_FORMAT_UNKNOWN*/)
+	{
+		assert(aRHI);
+
+		mRHIFormat = format;
+		mStride = byteStride;
+		mByteSize = objectsCount * byteStride;
+		mData.resize(mByteSize);
+		if (aData)
+			memcpy(mData.data(), aData, mByteSize);
+		else
+			std::fill(mData.begin(), mData.end(), 0);
+	}
+
+	void ER_RHI_Null_GPUBuffer::Update(void* aData, int dataSize)
+	{
+		assert(aData);
+		assert(dataSize <= mByteSize);
+		memcpy(mData.data(), aData, dataSize);
+	}
+
+	void ER_RHI_Null_GPUBuffer::CopyFrom(ER_RHI_Null_GPUBuffer* aSrcBuffer)
+	{
+		assert(aSrcBuffer);
+		memcpy(mData.data(), aSrcBuffer->mData.data(), std::min(mByteSize, aSrcBuffer->mByteSize));
+	}
+
+	///****************************************************************************************************************************
+	// *** ER_RHI_Null_GPUTexture ***
+	void ER_RHI_Null_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags,
+		int mip, int depth, int arraySize, bool isCubemap, int cubemapArraySize)
+	{
+		assert(aRHI);
+		assert(width > 0 && height > 0);
+
+		mFormat = format;
+		mBindFlags = bindFlags;
+		mWidth = width;
+		mHeight = height;
+		mDepth = (depth > 0) ? depth : 1;
+		mMipLevels = (mip > 0) ? mip : GetCalculatedMipCount();
+		mIsCubemap = isCubemap;
+		if (isCubemap)
+			mArraySize = (cubemapArraySize > 0) ? cubemapArraySize * 6 : 6;
+		else
+			mArraySize = arraySize;
+	}
+
+	void ER_RHI_Null_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent)
+	{
+		CreateGPUTextureResource(aRHI, ER_Utility::ToWideString(aPath), isFullPath, is3D, skipFallback, statusFlag, isSilent);
+	}
+
+	void ER_RHI_Null_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent)
+	{
+		assert(aRHI);
+
+		// we do not decode anything, but we still report missing files the same way, so that systems relying on "statusFlag" (i.e., probes) behave the same
+		std::ifstream file(isFullPath ? aPath.c_str() : ER_Utility::GetFilePath(aPath).c_str(), std::ios::binary);
+		bool isLoaded = file.good();
+		if (!isLoaded && !isSilent)
+		{
+			std::wstring msg = L"[ER Logger][ER_RHI_Null_GPUTexture] Failed to find texture on disk: " + aPath + L". Using placeholder description instead. \n";
+			ER_OUTPUT_LOG(msg.c_str());
+		}
+		if (statusFlag)
+			*statusFlag = isLoaded;
+
+		mIsLoadedFromFile = true;
+		mFormat = ER_FORMAT_R8G8B8A8_UNORM;
+		mWidth = 1;
+		mHeight = 1;
+		mDepth = 1;
+		mMipLevels = 1;
+		mArraySize = 1;
+	}
+
+	void ER_RHI_Null_GPUTexture::CreateGPUTextureResourceFromMemory(ER_RHI* aRHI, const void* aData, size_t aSize, bool* statusFlag)
+	{
+		assert(aRHI);
+		assert(aData && aSize > 0);
+
+		// like for the files, we do not decode anything: only the "DDS " magic is checked
+		const UINT32 ddsMagic = 0x20534444;
+		bool isLoaded = aSize >= sizeof(UINT32) && memcmp(aData, &ddsMagic, sizeof(UINT32)) == 0;
+		if (!isLoaded)
+			ER_OUTPUT_LOG(L"[ER Logger][ER_RHI_Null_GPUTexture] Failed to load DDS texture from memory. Using placeholder description instead. \n");
+		if (statusFlag)
+			*statusFlag = isLoaded;
+
+		mIsLoadedFromFile = true;
+		mFormat = ER_FORMAT_R8G8B8A8_UNORM;
+		mWidth = 1;
+		mHeight = 1;
+		mDepth = 1;
+		mMipLevels = 1;
+		mArraySize = 1;
+	}
+
+	UINT ER_RHI_Null_GPUTexture::GetCalculatedMipCount()
+	{
+		assert(mWidth && mHeight);
+		return 1 + static_cast<UINT>(floor(log2(std::max(mWidth, mHeight))));
+	}
+
+	///****************************************************************************************************************************
+	// *** ER_RHI_Null_GPUShader ***
+	void ER_RHI_Null_GPUShader::CompileShader(ER_RHI* aRHI, const std::string& path, const std::string& shaderEntry, ER_RHI_SHADER_TYPE type, ER_RHI_InputLayout* aIL)
+	{
+		assert(aRHI);
+
+		std::ifstream file(ER_Utility::GetFilePath(path).c_str());
+		if (!file.good())
+			throw ER_CoreException(("ER_RHI_Null: Failed to find shader file: " + path).c_str());
+
+		mPath = path;
+		mEntry = shaderEntry;
+		mShaderType = type;
+	}
+
+	///****************************************************************************************************************************
+	// *** ER_RHI_Null_GPURootSignature ***
+	ER_RHI_Null_GPURootSignature::ER_RHI_Null_GPURootSignature(UINT NumRootParams, UINT NumStaticSamplers)
+		: mNumParameters(NumRootParams), mNumSamplers(NumStaticSamplers)
+	{
+		mCBVCounts.resize(NumRootParams, 0);
+		mSRVCounts.resize(NumRootParams, 0);
+		mUAVCounts.resize(NumRootParams, 0);
+	}
+
+	void ER_RHI_Null_GPURootSignature::InitDescriptorTable(ER_RHI* rhi, int rootParamIndex, const std::vector<ER_RHI_DESCRIPTOR_RANGE_TYPE>& ranges, const std::vector<UINT>& registerIndices,
+		const std::vector<UINT>& descriptorCounters, ER_RHI_SHADER_VISIBILITY visibility)
+	{
+		assert(rootParamIndex < static_cast<int>(mNumParameters));
+
+		int rangesSize = static_cast<int>(ranges.size());
+		assert(rangesSize == descriptorCounters.size() && rangesSize == registerIndices.size());
+
+		for (int i = 0; i < rangesSize; i++)
+		{
+			if (ranges[i] == ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV)
+				mCBVCounts[rootParamIndex] += descriptorCounters[i];
+			else if (ranges[i] == ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV)
+				mSRVCounts[rootParamIndex] += descriptorCounters[i];
+			else if (ranges[i] == ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV)
+				mUAVCounts[rootParamIndex] += descriptorCounters[i];
+		}
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "ER_RHI_Null.h"
+
+namespace EveryRay_Core
+{
+	class ER_RHI_Null_InputLayout : public ER_RHI_InputLayout
+	{
+	public:
+		ER_RHI_Null_InputLayout(ER_RHI_INPUT_ELEMENT_DESC* inputElementDescriptions, UINT inputElementDescriptionCount)
+			: ER_RHI_InputLayout(inputElementDescriptions, inputElementDescriptionCount) { }
+		virtual ~ER_RHI_Null_InputLayout() {}
+	};
+
+	// Buffers keep a CPU copy of their data, so that readbacks (i.e., BeginBufferRead()) return what was uploaded last.
+	class ER_RHI_Null_GPUBuffer : public ER_RHI_GPUBuffer
+	{
+	public:
+		ER_RHI_Null_GPUBuffer(const std::string& aDebugName) : mName(aDebugName) {}
+		virtual ~ER_RHI_Null_GPUBuffer() {}
+
+		virtual void CreateGPUBufferResource(ER_RHI* aRHI, void* aData, UINT objectsCount, UINT byteStride,
+			bool isDynamic = false, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE, UINT cpuAccessFlags = 0,
+			ER_RHI_RESOURCE_MISC_FLAG miscFlags = ER_RESOURCE_MISC_NONE, ER_RHI_FORMAT format = ER_FORMAT_UNKNOWN) override;
+		virtual void* GetBuffer() override { return mData.empty() ? nullptr : mData.data(); }
+		virtual void* GetSRV() override { return this; }
+		virtual void* GetUAV() override { return this; }
+		virtual int GetSize() override { return mByteSize; }
+		virtual UINT GetStride() override { return mStride; }
+		virtual ER_RHI_FORMAT GetFormatRhi() override { return mRHIFormat; }
+		virtual void* GetResource() override { return this; }
+
+		virtual ER_RHI_RESOURCE_STATE GetCurrentState() override { return mCurrentState; }
+		virtual void SetCurrentState(ER_RHI_RESOURCE_STATE aState) override { mCurrentState = aState; }
+
+		inline virtual bool IsBuffer() override { return true; }
+
+		void Update(void* aData, int dataSize);
+		void CopyFrom(ER_RHI_Null_GPUBuffer* aSrcBuffer);
+		const std::string& GetName() { return mName; }
+	private:
+		std::vector<char> mData;
+		std::string mName;
+		ER_RHI_RESOURCE_STATE mCurrentState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMMON;
+		ER_RHI_FORMAT mRHIFormat = ER_FORMAT_UNKNOWN;
+		UINT mStride = 0;
+		int mByteSize = 0;
+	};
+
+	// Textures only store their description (no texel data is allocated).
+	class ER_RHI_Null_GPUTexture : public ER_RHI_GPUTexture
+	{
+	public:
+		ER_RHI_Null_GPUTexture(const std::wstring& aDebugName) { debugName = aDebugName; }
+		virtual ~ER_RHI_Null_GPUTexture() {}
+
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE,
+			int mip = 1, int depth = -1, int arraySize = 1, bool isCubemap = false, int cubemapArraySize = -1) override;
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
+		virtual void CreateGPUTextureResourceFromMemory(ER_RHI* aRHI, const void* aData, size_t aSize, bool* statusFlag = nullptr) override;
+
+		virtual void* GetRTV(void* aEmpty = nullptr) override { return this; }
+		virtual void* GetRTV(int index) override { return this; }
+		virtual void* GetDSV() override { return this; }
+		virtual void* GetSRV() override { return this; }
+		virtual void* GetUAV() override { return this; }
+		virtual void* GetResource() override { return this; }
+
+		virtual UINT GetMips() override { return mMipLevels; }
+		virtual UINT GetCalculatedMipCount() override;
+		virtual UINT GetWidth() override { return mWidth; }
+		virtual UINT GetHeight() override { return mHeight; }
+		virtual UINT GetDepth() override { return mDepth; }
+
+		virtual ER_RHI_RESOURCE_STATE GetCurrentState() override { return mCurrentState; }
+		virtual void SetCurrentState(ER_RHI_RESOURCE_STATE aState) override { mCurrentState = aState; }
+
+		inline virtual bool IsBuffer() override { return false; }
+
+		bool IsLoadedFromFile() { return mIsLoadedFromFile; }
+		ER_RHI_FORMAT GetFormat() { return mFormat; }
+	private:
+		ER_RHI_RESOURCE_STATE mCurrentState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMMON;
+		ER_RHI_FORMAT mFormat = ER_FORMAT_UNKNOWN;
+		UINT mMipLevels = 0;
+		UINT mBindFlags = 0;
+		UINT mWidth = 0;
+		UINT mHeight = 0;
+		UINT mDepth = 0;
+		UINT mArraySize = 0;
+		bool mIsCubemap = false;
+		bool mIsLoadedFromFile = false;
+	};
+
+	// Shaders are not compiled: we only validate that the source file exists and remember what was requested.
+	class ER_RHI_Null_GPUShader : public ER_RHI_GPUShader
+	{
+	public:
+		ER_RHI_Null_GPUShader() {}
+		virtual ~ER_RHI_Null_GPUShader() {}
+
+		virtual void CompileShader(ER_RHI* aRHI, const std::string& path, const std::string& shaderEntry, ER_RHI_SHADER_TYPE type, ER_RHI_InputLayout* aIL = nullptr) override;
+		virtual void* GetShaderObject() override { return this; }
+
+		const std::string& GetPath() { return mPath; }
+		const std::string& GetEntry() { return mEntry; }
+	private:
+		std::string mPath;
+		std::string mEntry;
+	};
+
+	class ER_RHI_Null_GPURootSignature : public ER_RHI_GPURootSignature
+	{
+	public:
+		ER_RHI_Null_GPURootSignature(UINT NumRootParams = 0, UINT NumStaticSamplers = 0);
+		virtual ~ER_RHI_Null_GPURootSignature() {}
+
+		virtual void InitConstant(ER_RHI* rhi, UINT index, UINT regIndex, UINT numDWORDs, ER_RHI_SHADER_VISIBILITY visibility = ER_RHI_SHADER_VISIBILITY_ALL) override {};
+		virtual void InitStaticSampler(ER_RHI* rhi, UINT regIndex, const ER_RHI_SAMPLER_STATE& sampler, ER_RHI_SHADER_VISIBILITY visibility = ER_RHI_SHADER_VISIBILITY_ALL) override {};
+		virtual void InitDescriptorTable(ER_RHI* rhi, int rootParamIndex, const std::vector<ER_RHI_DESCRIPTOR_RANGE_TYPE>& ranges, const std::vector<UINT>& registerIndices,
+			const std::vector<UINT>& descriptorCounters, ER_RHI_SHADER_VISIBILITY visibility = ER_RHI_SHADER_VISIBILITY_ALL) override;
+		virtual void Finalize(ER_RHI* rhi, const std::string& name, bool needsInputAssembler = false) override { mName = name; }
+
+		virtual int GetStaticSamplersCount() override { return mNumSamplers; }
+		virtual int GetRootParameterCount() override { return mNumParameters; }
+		virtual int GetRootParameterCBVCount(int paramIndex) override { return mCBVCounts[paramIndex]; }
+		virtual int GetRootParameterSRVCount(int paramIndex) override { return mSRVCounts[paramIndex]; }
+		virtual int GetRootParameterUAVCount(int paramIndex) override { return mUAVCounts[paramIndex]; }
+	private:
+		std::string mName;
+		std::vector<int> mCBVCounts;
+		std::vector<int> mSRVCounts;
+		std::vector<int> mUAVCounts;
+		UINT mNumParameters = 0;
+		UINT mNumSamplers = 0;
+	};
+}
@@ -5,8 +5,11 @@
 
 #include "..\EveryRay_Core\ER_RuntimeCore.h"
 #include "..\EveryRay_Core\ER_CoreException.h"
+#include "..\EveryRay_Core\ER_CompiledScene.h"
+#include "..\EveryRay_Core\ER_Utility.h"
 #include "..\EveryRay_Core\RHI\ER_RHI.h"
 #include "..\EveryRay_Core\RHI\DX11\ER_RHI_DX11.h"
+#include "..\EveryRay_Core\RHI\Null\ER_RHI_Null.h"
 
 #if defined(DEBUG) || defined(_DEBUG)
 #define _CRTDBG_MAP_ALLOC
@@ -25,10 +28,21 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, LPSTR command
 	//_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF|_CRTDBG_LEAK_CHECK_DF);
 	//#endif
 
+	// "-compile_scenes" compiles all levels from the global scenes config into binary scenes (see ER_CompiledScene) and exits
+	if (commandLine && strstr(commandLine, "-compile_scenes") != nullptr)
+		return ER_CompiledScene::CompileScenesFromConfig(ER_Utility::GetFilePath("content\\levels\\global_scenes_config.json")) ? 0 : 1;
+
+	// "-null_rhi" runs the engine without a GPU device (commands are only recorded, see ER_RHI_Null).
+	// ER_Core still needs a window (input, message loop), so it is created but never shown.
+	bool isNullRHI = commandLine && strstr(commandLine, "-null_rhi") != nullptr;
+	if (isNullRHI)
+		showCommand = SW_HIDE;
+	ER_RHI* rhi = isNullRHI ? static_cast<ER_RHI*>(new ER_RHI_Null()) : static_cast<ER_RHI*>(new ER_RHI_DX11());
+
 #if defined(DEBUG) || defined(_DEBUG)
-	std::unique_ptr<ER_RuntimeCore> game(new ER_RuntimeCore(new ER_RHI_DX11(), instance, L"EveryRay Main Window Class", L"EveryRay - Rendering Engine | Win64 DX11 (Debug)", showCommand, false));
+	std::unique_ptr<ER_RuntimeCore> game(new ER_RuntimeCore(rhi, instance, L"EveryRay Main Window Class", L"EveryRay - Rendering Engine | Win64 DX11 (Debug)", showCommand, false));
 #else
-	std::unique_ptr<ER_RuntimeCore> game(new ER_RuntimeCore(new ER_RHI_DX11(), instance, L"EveryRay Main Window Class", L"EveryRay - Rendering Engine | Win64 DX11 (Release)", showCommand, false));
+	std::unique_ptr<ER_RuntimeCore> game(new ER_RuntimeCore(rhi, instance, L"EveryRay Main Window Class", L"EveryRay - Rendering Engine | Win64 DX11 (Release)", showCommand, false));
 #endif
 	try {
 		game->Run();
@@ -0,0 +1,186 @@
+#include "ER_Tests.h"
+#include "ER_GPUCullingTable.h"
+
+using namespace EveryRay_Core;
+
+namespace
+{
+	std::vector<ER_GPUCullingInstance> MakeInstances(UINT aCount, float aX)
+	{
+		std::vector<ER_GPUCullingInstance> instances(aCount);
+		for (UINT i = 0; i < aCount; i++)
+		{
+			XMStoreFloat4x4(&instances[i].World, XMMatrixTranslation(aX + static_cast<float>(i), 0.0f, 0.0f));
+			instances[i].AABBMin = XMFLOAT4(aX + static_cast<float>(i) - 0.5f, -0.5f, -0.5f, 1.0f);
+			instances[i].AABBMax = XMFLOAT4(aX + static_cast<float>(i) + 0.5f, 0.5f, 0.5f, 1.0f);
+		}
+		return instances;
+	}
+
+	// table of 2 objects: 3 instances with 2 LODs of 2 meshes, 100 instances with 1 LOD of 1 mesh
+	void BuildTable(ER_GPUCullingTable& aTable)
+	{
+		const std::vector<ER_GPUCullingInstance> instances0 = MakeInstances(3, 0.0f);
+		const UINT indexCounts0[] = { 36, 72, 12, 24 };
+		aTable.AddObject(instances0.data(), 3, 2, 2, indexCounts0);
+
+		const std::vector<ER_GPUCullingInstance> instances1 = MakeInstances(100, 1000.0f);
+		const UINT indexCounts1[] = { 6 };
+		aTable.AddObject(instances1.data(), 100, 1, 1, indexCounts1);
+	}
+}
+
+ER_TEST(ER_GPUCullingTable, ObjectsLayout)
+{
+	ER_GPUCullingTable table;
+	BuildTable(table);
+
+	ER_CHECK(table.GetObjectsCount() == 2);
+	ER_CHECK(table.GetInstancesCount() == 103);
+	ER_CHECK(table.GetDrawsCount() == 2 * ER_GPU_CULLING_DRAWS_PER_OBJECT);
+	ER_CHECK(table.GetArgsCount() == 2 * ER_GPU_CULLING_DRAWS_PER_OBJECT * ER_GPU_CULLING_DRAW_ARGS_COUNT);
+	ER_CHECK(table.GetCulledInstancesCount() == 103 * MAX_LOD);
+
+	const ER_GPUCullingObject& object0 = table.GetObjectDesc(0);
+	ER_CHECK(object0.FirstInstance == 0 && object0.InstancesCount == 3);
+	ER_CHECK(object0.CulledInstancesOffset == 0 && object0.ArgsOffset == 0);
+	ER_CHECK(object0.LODCount == 2 && object0.MeshCount == 2);
+
+	const ER_GPUCullingObject& object1 = table.GetObjectDesc(1);
+	ER_CHECK(object1.FirstInstance == 3 && object1.InstancesCount == 100);
+	ER_CHECK(object1.CulledInstancesOffset == 3 * MAX_LOD);
+	ER_CHECK(object1.ArgsOffset == ER_GPU_CULLING_DRAWS_PER_OBJECT * ER_GPU_CULLING_DRAW_ARGS_COUNT);
+	ER_CHECK(table.GetArgsByteOffset(1) == object1.ArgsOffset * sizeof(UINT));
+
+	const std::vector<UINT>& instanceObjects = table.GetInstanceObjects();
+	ER_CHECK(instanceObjects.size() == 103);
+	ER_CHECK(instanceObjects[0] == 0 && instanceObjects[2] == 0);
+	ER_CHECK(instanceObjects[3] == 1 && instanceObjects[102] == 1);
+	ER_CHECK(table.GetInstances()[3].World._41 == 1000.0f);
+
+	table.Clear();
+	ER_CHECK(table.GetObjectsCount() == 0 && table.GetInstancesCount() == 0 && table.GetCulledInstancesCount() == 0);
+}
+
+ER_TEST(ER_GPUCullingTable, LODsAboveMaxAreIgnored)
+{
+	ER_GPUCullingTable table;
+	const std::vector<ER_GPUCullingInstance> instances = MakeInstances(1, 0.0f);
+	const UINT indexCounts[MAX_LOD + 1] = { 300, 200, 100, 50 };
+	table.AddObject(instances.data(), 1, MAX_LOD + 1, 1, indexCounts);
+	ER_CHECK(table.GetObjectDesc(0).LODCount == MAX_LOD);
+
+	std::vector<UINT> args;
+	table.BuildInitialArgs(args);
+	for (UINT lod = 0; lod < MAX_LOD; lod++)
+		ER_CHECK(args[MAX_MESH_COUNT * lod * ER_GPU_CULLING_DRAW_ARGS_COUNT] == indexCounts[lod]);
+}
+
+ER_TEST(ER_GPUCullingTable, InitialArgs)
+{
+	ER_GPUCullingTable table;
+	BuildTable(table);
+
+	std::vector<UINT> args;
+	table.BuildInitialArgs(args);
+	ER_CHECK(args.size() == table.GetArgsCount());
+
+	// draw (MAX_MESH_COUNT * lod + mesh) of the object has its index count and no instances
+	const UINT* args0 = &args[table.GetObjectDesc(0).ArgsOffset];
+	ER_CHECK(args0[(MAX_MESH_COUNT * 0 + 0) * ER_GPU_CULLING_DRAW_ARGS_COUNT] == 36);
+	ER_CHECK(args0[(MAX_MESH_COUNT * 0 + 1) * ER_GPU_CULLING_DRAW_ARGS_COUNT] == 72);
+	ER_CHECK(args0[(MAX_MESH_COUNT * 1 + 0) * ER_GPU_CULLING_DRAW_ARGS_COUNT] == 12);
+	ER_CHECK(args0[(MAX_MESH_COUNT * 1 + 1) * ER_GPU_CULLING_DRAW_ARGS_COUNT] == 24);
+	ER_CHECK(args0[(MAX_MESH_COUNT * 0 + 2) * ER_GPU_CULLING_DRAW_ARGS_COUNT] == 0);
+	ER_CHECK(args0[(MAX_MESH_COUNT * 2 + 0) * ER_GPU_CULLING_DRAW_ARGS_COUNT] == 0);
+	ER_CHECK(args0[1] == 0); // InstanceCount
+
+	const UINT* args1 = &args[table.GetObjectDesc(1).ArgsOffset];
+	ER_CHECK(args1[0] == 6);
+	ER_CHECK(args1[ER_GPU_CULLING_DRAW_ARGS_COUNT] == 0);
+}
+
+ER_TEST(ER_GPUCullingTable, ObjectLODsChangeDetection)
+{
+	ER_GPUCullingTable table;
+	BuildTable(table);
+
+	const float screenSizes[MAX_LOD] = { 0.5f, 0.25f, 0.1f };
+	ER_CHECK(table.SetObjectLODs(1, 1.0f, screenSizes));
+	ER_CHECK(!table.SetObjectLODs(1, 1.0f, screenSizes));
+	ER_CHECK(table.GetObjectDesc(1).LODScreenSizes.y == 0.25f);
+	ER_CHECK(table.SetObjectLODs(1, 2.0f, screenSizes));
+	ER_CHECK(table.GetObjectDesc(1).LODBias == 2.0f);
+}
+
+ER_TEST(ER_GPUCullingTable, MovedInstancesAreUploadedInDirtyBlocks)
+{
+	ER_GPUCullingTable table;
+	BuildTable(table);
+
+	const UINT8 allVersionsMask = 0x3; // 2 versions of the GPU buffer
+	std::vector<std::pair<UINT, UINT>> ranges;
+
+	// a new table is uploaded with the initial data
+	table.TakeDirtyInstanceRanges(0, ranges);
+	ER_CHECK(ranges.empty());
+
+	std::vector<ER_GPUCullingInstance> instances1 = MakeInstances(100, 1000.0f);
+	ER_CHECK(!table.SetObjectInstances(1, 0, instances1.data(), 100, allVersionsMask));
+
+	// instance #70 of object #1 (#73 in the table) moved: its block [64, 103) is dirty in both versions
+	instances1[70].World._42 = 5.0f;
+	ER_CHECK(table.SetObjectInstances(1, 0, instances1.data(), 100, allVersionsMask));
+	ER_CHECK(table.GetInstances()[73].World._42 == 5.0f);
+
+	table.TakeDirtyInstanceRanges(0, ranges);
+	ER_CHECK(ranges.size() == 1);
+	ER_CHECK(ranges[0].first == ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK);
+	ER_CHECK(ranges[0].second == 103 - ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK);
+	table.TakeDirtyInstanceRanges(0, ranges);
+	ER_CHECK(ranges.empty());
+
+	table.TakeDirtyInstanceRanges(1, ranges);
+	ER_CHECK(ranges.size() == 1 && ranges[0].first == ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK);
+	table.TakeDirtyInstanceRanges(1, ranges);
+	ER_CHECK(ranges.empty());
+}
+
+ER_TEST(ER_GPUCullingTable, ConsecutiveDirtyBlocksAreMerged)
+{
+	ER_GPUCullingTable table;
+	BuildTable(table);
+
+	// first instance of object #0 (block #0) and last instance of object #1 (block #1)
+	std::vector<ER_GPUCullingInstance> instances0 = MakeInstances(3, 0.0f);
+	std::vector<ER_GPUCullingInstance> instances1 = MakeInstances(100, 1000.0f);
+	instances0[0].AABBMax.y = 2.0f;
+	instances1[99].AABBMax.y = 2.0f;
+	ER_CHECK(table.SetObjectInstances(0, 0, instances0.data(), 3, 0x1));
+	ER_CHECK(table.SetObjectInstances(1, 0, instances1.data(), 100, 0x1));
+
+	std::vector<std::pair<UINT, UINT>> ranges;
+	table.TakeDirtyInstanceRanges(0, ranges);
+	ER_CHECK(ranges.size() == 1);
+	ER_CHECK(ranges[0].first == 0 && ranges[0].second == 103);
+}
+
+ER_TEST(ER_GPUCullingTable, InstanceRangesOnlyTouchTheirBlocks)
+{
+	ER_GPUCullingTable table;
+	BuildTable(table);
+
+	// only instance #70 of object #1 (#73 in the table) is passed
+	std::vector<ER_GPUCullingInstance> instances1 = MakeInstances(100, 1000.0f);
+	instances1[70].World._42 = 5.0f;
+	ER_CHECK(!table.SetObjectInstances(1, 69, &instances1[69], 1, 0x1));
+	ER_CHECK(table.SetObjectInstances(1, 70, &instances1[70], 1, 0x1));
+	ER_CHECK(table.GetInstances()[73].World._42 == 5.0f);
+	ER_CHECK(table.GetInstances()[72].World._42 == 0.0f);
+
+	std::vector<std::pair<UINT, UINT>> ranges;
+	table.TakeDirtyInstanceRanges(0, ranges);
+	ER_CHECK(ranges.size() == 1);
+	ER_CHECK(ranges[0].first == ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK);
+	ER_CHECK(ranges[0].second == 103 - ER_GPU_CULLING_INSTANCES_PER_DIRTY_BLOCK);
+}
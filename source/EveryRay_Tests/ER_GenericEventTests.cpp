@@ -0,0 +1,275 @@
+#include "ER_Tests.h"
+#include "ER_GenericEvent.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+
+// Counts the allocations of the whole executable (only read by the dispatch benchmark, which is single-threaded)
+static size_t sAllocationsCount = 0;
+
+void* operator new(size_t aSize)
+{
+	sAllocationsCount++;
+	if (void* memory = malloc(aSize ? aSize : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+void operator delete(void* aMemory) noexcept { free(aMemory); }
+void operator delete(void* aMemory, size_t) noexcept { free(aMemory); }
+
+namespace
+{
+	typedef std::function<void(int)> ER_TestListener;
+
+	// Registry of listeners as it was before the handles: named listeners in a map, anonymous ones in a vector,
+	// and a copy of all of them for every dispatch (only used as the reference of the benchmark)
+	class ER_LegacyEvent
+	{
+	public:
+		void AddListener(const std::string& aName, ER_TestListener aListener) { mNamedListeners.emplace(aName, std::move(aListener)); }
+		void AddListener(ER_TestListener aListener) { mAnonymousListeners.push_back(std::move(aListener)); }
+		std::vector<ER_TestListener> GetListeners() const
+		{
+			std::vector<ER_TestListener> listeners;
+			for (const auto& listener : mNamedListeners)
+				listeners.push_back(listener.second);
+			for (const auto& listener : mAnonymousListeners)
+				listeners.push_back(listener);
+			return listeners;
+		}
+	private:
+		std::unordered_map<std::string, ER_TestListener> mNamedListeners;
+		std::vector<ER_TestListener> mAnonymousListeners;
+	};
+
+	const int BENCHMARK_LISTENERS_COUNT = 8; // named and anonymous (i.e., materials of a scene listening to MeshMaterialVariablesUpdateEvent)
+	const int BENCHMARK_DISPATCHES_COUNT = 200000; // i.e., meshes * passes of a few frames
+
+	struct ER_BenchmarkResult
+	{
+		double NanosecondsPerDispatch;
+		double AllocationsPerDispatch;
+	};
+
+	template<typename Dispatch>
+	ER_BenchmarkResult RunBenchmark(Dispatch aDispatch)
+	{
+		aDispatch(0); // warm-up
+
+		const size_t allocationsCount = sAllocationsCount;
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < BENCHMARK_DISPATCHES_COUNT; i++)
+			aDispatch(i);
+		const auto end = std::chrono::steady_clock::now();
+
+		ER_BenchmarkResult result;
+		result.NanosecondsPerDispatch = std::chrono::duration<double, std::nano>(end - start).count() / BENCHMARK_DISPATCHES_COUNT;
+		result.AllocationsPerDispatch = static_cast<double>(sAllocationsCount - allocationsCount) / BENCHMARK_DISPATCHES_COUNT;
+		return result;
+	}
+}
+
+ER_TEST(ER_GenericEvent, NamedListeners)
+{
+	ER_GenericEvent<ER_TestListener> event;
+	int sum = 0;
+	const ER_EventListenerHandle handle = event.AddListener("a", [&](int value) { sum += value; });
+	ER_CHECK(handle.IsValid());
+	ER_CHECK(event.FindListener("a").Index == handle.Index);
+
+	// same name: the first listener is kept
+	const ER_EventListenerHandle duplicate = event.AddListener("a", [&](int value) { sum -= value; });
+	ER_CHECK(duplicate.Index == handle.Index && duplicate.Generation == handle.Generation);
+	ER_CHECK(event.GetListenersCount() == 1);
+
+	event.Invoke(2);
+	ER_CHECK(sum == 2);
+	event.GetListener("a")(3);
+	ER_CHECK(sum == 5);
+
+	bool isThrown = false;
+	try { event.GetListener("b"); }
+	catch (const EveryRay_Core::ER_CoreException&) { isThrown = true; }
+	ER_CHECK(isThrown);
+
+	event.RemoveListener("a");
+	ER_CHECK(!event.FindListener("a").IsValid());
+	ER_CHECK(event.GetListenersCount() == 0);
+}
+
+ER_TEST(ER_GenericEvent, StaleHandlesAreRejected)
+{
+	ER_GenericEvent<ER_TestListener> event;
+	int calls0 = 0, calls1 = 0;
+	const ER_EventListenerHandle handle0 = event.AddListener([&](int) { calls0++; });
+	event.RemoveListener(handle0);
+	ER_CHECK(!event.HasListener(handle0));
+
+	// the slot is reused with a new generation: the old handle does not call (or remove) the new listener
+	const ER_EventListenerHandle handle1 = event.AddListener([&](int) { calls1++; });
+	ER_CHECK(handle1.Index == handle0.Index);
+	ER_CHECK(handle1.Generation != handle0.Generation);
+	ER_CHECK(!event.Invoke(handle0, 0));
+	event.RemoveListener(handle0);
+	ER_CHECK(event.HasListener(handle1));
+	ER_CHECK(event.Invoke(handle1, 0));
+	ER_CHECK(calls0 == 0 && calls1 == 1);
+
+	ER_CHECK(!event.HasListener(ER_EventListenerHandle()));
+	ER_CHECK(!event.Invoke(ER_EventListenerHandle{ 100, handle1.Generation }, 0));
+}
+
+ER_TEST(ER_GenericEvent, ListenersAddedDuringDispatchAreCalledNextTime)
+{
+	ER_GenericEvent<ER_TestListener> event;
+	std::vector<int> calls;
+	ER_EventListenerHandle addedHandle;
+	event.AddListener("adder", [&](int value)
+	{
+		calls.push_back(value);
+		if (!addedHandle.IsValid())
+			addedHandle = event.AddListener("added", [&](int value) { calls.push_back(100 + value); });
+	});
+
+	event.Invoke(1);
+	ER_CHECK(calls.size() == 1 && calls[0] == 1);
+	ER_CHECK(event.HasListener(addedHandle));
+	ER_CHECK(event.GetListenersCount() == 2);
+
+	event.Invoke(2);
+	ER_CHECK(calls.size() == 3 && calls[1] == 2 && calls[2] == 102);
+}
+
+ER_TEST(ER_GenericEvent, PendingListenersKeepTheirIndices)
+{
+	ER_GenericEvent<ER_TestListener> event;
+	int calls = 0;
+	ER_EventListenerHandle pendingHandles[2];
+	ER_EventListenerHandle foundHandle;
+	const ER_EventListenerHandle removedHandle = event.AddListener([](int) {});
+	event.AddListener([&](int)
+	{
+		if (pendingHandles[0].IsValid())
+			return;
+		pendingHandles[0] = event.AddListener("pending0", [&](int) { calls++; });
+		pendingHandles[1] = event.AddListener([&](int) { calls += 10; });
+		foundHandle = event.FindListener("pending0");
+		ER_CHECK(!event.Invoke(pendingHandles[0], 0)); // not added yet
+	});
+	event.RemoveListener(removedHandle); // free slot #0 is not reused by the pending listeners
+
+	event.Invoke(0);
+	ER_CHECK(pendingHandles[0].Index == 2 && pendingHandles[1].Index == 3);
+	ER_CHECK(foundHandle.Index == pendingHandles[0].Index && foundHandle.Generation == pendingHandles[0].Generation);
+	ER_CHECK(calls == 0);
+
+	// after the dispatch, they are in the slots of their handles
+	ER_CHECK(event.Invoke(pendingHandles[0], 0));
+	ER_CHECK(event.Invoke(pendingHandles[1], 0));
+	ER_CHECK(calls == 11);
+	ER_CHECK(event.FindListener("pending0").Index == 2);
+}
+
+ER_TEST(ER_GenericEvent, ListenersRemovedDuringDispatchAreNotCalled)
+{
+	ER_GenericEvent<ER_TestListener> event;
+	int callsA = 0, callsB = 0;
+	ER_EventListenerHandle handleB;
+	event.AddListener("a", [&](int) { callsA++; event.RemoveListener(handleB); });
+	handleB = event.AddListener("b", [&](int) { callsB++; });
+
+	event.Invoke(0);
+	ER_CHECK(callsA == 1 && callsB == 0);
+	ER_CHECK(!event.HasListener(handleB));
+	ER_CHECK(event.GetListenersCount() == 1);
+
+	// a pending listener removed in the same dispatch is never added
+	ER_EventListenerHandle pendingHandle;
+	event.AddListener([&](int)
+	{
+		pendingHandle = event.AddListener([&](int) { callsB++; });
+		event.RemoveListener(pendingHandle);
+	});
+	event.Invoke(0);
+	event.Invoke(0);
+	ER_CHECK(callsB == 0);
+	ER_CHECK(!event.HasListener(pendingHandle));
+}
+
+ER_TEST(ER_GenericEvent, ListenersCanRemoveThemselves)
+{
+	ER_GenericEvent<ER_TestListener> event;
+	int onceCalls = 0, otherCalls = 0;
+	ER_EventListenerHandle onceHandle;
+	onceHandle = event.AddListener("once", [&](int)
+	{
+		onceCalls++;
+		event.RemoveListener(onceHandle); // the callback is destroyed after the dispatch, so its captures are still valid here
+		ER_CHECK(onceHandle.IsValid());
+	});
+	event.AddListener([&](int) { otherCalls++; });
+
+	event.Invoke(0);
+	event.Invoke(0);
+	ER_CHECK(onceCalls == 1 && otherCalls == 2);
+	ER_CHECK(event.GetListenersCount() == 1);
+
+	// also from a dispatch of the handle only, and from a nested dispatch
+	ER_EventListenerHandle nestedHandle;
+	nestedHandle = event.AddListener([&](int value)
+	{
+		if (value == 0)
+			event.Invoke(1);
+		else
+			event.RemoveListener(nestedHandle);
+	});
+	ER_CHECK(event.Invoke(nestedHandle, 0));
+	ER_CHECK(!event.HasListener(nestedHandle));
+	ER_CHECK(event.GetListenersCount() == 1);
+
+	event.RemoveAllListeners();
+	ER_CHECK(event.GetListenersCount() == 0);
+}
+
+// Reproducible benchmark (fixed listeners and dispatches): reports the time and the allocations of a dispatch,
+// checks that dispatches do not allocate (the time is only reported, as it depends on the machine)
+ER_TEST(ER_GenericEvent, DispatchBenchmark)
+{
+	int sum = 0;
+	ER_GenericEvent<ER_TestListener> event;
+	ER_LegacyEvent legacyEvent;
+	ER_EventListenerHandle handle;
+	for (int i = 0; i < BENCHMARK_LISTENERS_COUNT; i++)
+	{
+		if (i % 2)
+		{
+			handle = event.AddListener("listener #" + std::to_string(i), [&sum](int value) { sum += value; });
+			legacyEvent.AddListener("listener #" + std::to_string(i), [&sum](int value) { sum += value; });
+		}
+		else
+		{
+			event.AddListener([&sum](int value) { sum -= value; });
+			legacyEvent.AddListener([&sum](int value) { sum -= value; });
+		}
+	}
+
+	const ER_BenchmarkResult result = RunBenchmark([&](int value) { event.Invoke(value); });
+	const ER_BenchmarkResult handleResult = RunBenchmark([&](int value) { event.Invoke(handle, value); });
+	const ER_BenchmarkResult legacyResult = RunBenchmark([&](int value)
+	{
+		for (const ER_TestListener& listener : legacyEvent.GetListeners())
+			listener(value);
+	});
+
+	printf("%d listeners, %d dispatches:\n", BENCHMARK_LISTENERS_COUNT, BENCHMARK_DISPATCHES_COUNT);
+	printf("  Invoke():          %8.1f ns, %.1f allocations per dispatch\n", result.NanosecondsPerDispatch, result.AllocationsPerDispatch);
+	printf("  Invoke(handle):    %8.1f ns, %.1f allocations per dispatch\n", handleResult.NanosecondsPerDispatch, handleResult.AllocationsPerDispatch);
+	printf("  map + copy (old):  %8.1f ns, %.1f allocations per dispatch\n", legacyResult.NanosecondsPerDispatch, legacyResult.AllocationsPerDispatch);
+
+	ER_CHECK(result.AllocationsPerDispatch == 0.0);
+	ER_CHECK(handleResult.AllocationsPerDispatch == 0.0);
+	ER_CHECK(legacyResult.AllocationsPerDispatch >= 1.0); // the counter works
+}
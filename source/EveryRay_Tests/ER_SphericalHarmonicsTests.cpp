@@ -0,0 +1,225 @@
+#include "ER_Tests.h"
+#include "ER_SphericalHarmonics.h"
+
+#include <DirectXSH.h>
+#include <functional>
+#include <random>
+
+using namespace EveryRay_Core;
+
+namespace
+{
+	const UINT CubemapSize = 64;
+
+	// cubemap with the radiance of "aFunction" in the texel directions (same face orientations as in SHProjectCubeMap())
+	struct TestCubemap
+	{
+		explicit TestCubemap(const std::function<XMFLOAT4(const XMFLOAT3&)>& aFunction)
+		{
+			for (int face = 0; face < ER_SH_CUBEMAP_FACES_COUNT; face++)
+			{
+				Faces[face].resize(CubemapSize * CubemapSize);
+				for (UINT y = 0; y < CubemapSize; y++)
+				{
+					for (UINT x = 0; x < CubemapSize; x++)
+					{
+						XMFLOAT3 direction;
+						XMStoreFloat3(&direction, XMVector3Normalize(GetTexelDirection(face, x, y)));
+						Faces[face][y * CubemapSize + x] = aFunction(direction);
+					}
+				}
+				FacesData[face] = Faces[face].data();
+			}
+		}
+
+		static XMVECTOR GetTexelDirection(int aFace, UINT aX, UINT aY)
+		{
+			const float u = (2.0f * aX + 1.0f) / CubemapSize - 1.0f;
+			const float v = (2.0f * aY + 1.0f) / CubemapSize - 1.0f;
+			switch (aFace)
+			{
+			case 0: return XMVectorSet(1.0f, -v, -u, 0.0f);
+			case 1: return XMVectorSet(-1.0f, -v, u, 0.0f);
+			case 2: return XMVectorSet(u, 1.0f, v, 0.0f);
+			case 3: return XMVectorSet(u, -1.0f, -v, 0.0f);
+			case 4: return XMVectorSet(u, -v, 1.0f, 0.0f);
+			default: return XMVectorSet(-u, -v, -1.0f, 0.0f);
+			}
+		}
+
+		ER_SphericalHarmonics Project() const { return ER_SphericalHarmonics::ProjectCubemap(FacesData, CubemapSize, CubemapSize * sizeof(XMFLOAT4)); }
+
+		std::vector<XMFLOAT4> Faces[ER_SH_CUBEMAP_FACES_COUNT];
+		const XMFLOAT4* FacesData[ER_SH_CUBEMAP_FACES_COUNT];
+	};
+
+	XMVECTOR RandomDirection(std::mt19937& aGenerator)
+	{
+		std::normal_distribution<float> distribution;
+		return XMVector3Normalize(XMVectorSet(distribution(aGenerator), distribution(aGenerator), distribution(aGenerator), 0.0f));
+	}
+
+	ER_SphericalHarmonics RandomFunction(std::mt19937& aGenerator)
+	{
+		std::normal_distribution<float> distribution;
+		XMFLOAT3 coefficients[ER_SH_COEF_COUNT];
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			coefficients[i] = XMFLOAT3(distribution(aGenerator), distribution(aGenerator), distribution(aGenerator));
+		return ER_SphericalHarmonics(coefficients);
+	}
+}
+
+ER_TEST(ER_SphericalHarmonics, ConstantRadiance)
+{
+	const TestCubemap cubemap([](const XMFLOAT3&) { return XMFLOAT4(0.5f, 1.0f, 2.0f, 7.0f); });
+	const ER_SphericalHarmonics radiance = cubemap.Project();
+	ER_CHECK(XMVectorGetW(radiance.GetCoefficient(0)) == 0.0f); // alpha is not projected
+
+	ER_SphericalHarmonics irradiance = radiance;
+	irradiance.ConvolveWithCosineLobe();
+
+	std::mt19937 generator(1);
+	for (int i = 0; i < 100; i++)
+	{
+		const XMVECTOR direction = RandomDirection(generator);
+		XMFLOAT3 value;
+		XMStoreFloat3(&value, radiance.Evaluate(direction));
+		ER_CHECK_NEAR(value.x, 0.5f, 1e-3f);
+		ER_CHECK_NEAR(value.y, 1.0f, 1e-3f);
+		ER_CHECK_NEAR(value.z, 2.0f, 1e-3f);
+
+		// irradiance of a constant radiance L is pi * L
+		ER_CHECK_NEAR(XMVectorGetY(irradiance.Evaluate(direction)), XM_PI, 1e-2f);
+	}
+}
+
+ER_TEST(ER_SphericalHarmonics, DirectionalLightCosinePeak)
+{
+	const XMVECTOR lightDirection = XMVector3Normalize(XMVectorSet(0.3f, 0.8f, -0.5f, 0.0f));
+	ER_SphericalHarmonics irradiance;
+	irradiance.AddDirectionalLight(lightDirection, XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f));
+	irradiance.ConvolveWithCosineLobe();
+
+	// 3 bands of the clamped cosine lobe of a white delta light: 1/4 + 1/2 cos(t) + 5/16 (3 cos(t)^2 - 1) / 2, so 1/4 + 1/2 + 5/16 at the peak
+	ER_CHECK_NEAR(XMVectorGetX(irradiance.Evaluate(lightDirection)), 1.0625f, 1e-4f);
+	ER_CHECK_NEAR(XMVectorGetX(irradiance.Evaluate(XMVectorNegate(lightDirection))), 0.0625f, 1e-4f);
+}
+
+ER_TEST(ER_SphericalHarmonics, ProjectionMatchesSHMath)
+{
+	// band-limited radiance: projected exactly up to the cubemap's quadrature error
+	auto radianceFunction = [](const XMFLOAT3& d)
+	{
+		const float value = 1.0f + d.x + 0.5f * (3.0f * d.z * d.z - 1.0f) + d.x * d.y;
+		return XMFLOAT4(value, 2.0f * value, -value, 0.0f);
+	};
+	const TestCubemap cubemap(radianceFunction);
+	const ER_SphericalHarmonics radiance = cubemap.Project();
+
+	std::mt19937 generator(2);
+	for (int i = 0; i < 100; i++)
+	{
+		const XMVECTOR direction = RandomDirection(generator);
+		XMFLOAT3 d;
+		XMStoreFloat3(&d, direction);
+		XMFLOAT3 value;
+		XMStoreFloat3(&value, radiance.Evaluate(direction));
+		const XMFLOAT4 expected = radianceFunction(d);
+		ER_CHECK_NEAR(value.x, expected.x, 2e-3f);
+		ER_CHECK_NEAR(value.y, expected.y, 4e-3f);
+		ER_CHECK_NEAR(value.z, expected.z, 2e-3f);
+	}
+
+	// same texel weights and basis as SHProjectCubeMap() (XMSHEvalDirection() per texel)
+	float expected[ER_SH_COEF_COUNT] = {};
+	float totalWeight = 0.0f;
+	for (int face = 0; face < ER_SH_CUBEMAP_FACES_COUNT; face++)
+	{
+		for (UINT y = 0; y < CubemapSize; y++)
+		{
+			for (UINT x = 0; x < CubemapSize; x++)
+			{
+				const float u = (2.0f * x + 1.0f) / CubemapSize - 1.0f;
+				const float v = (2.0f * y + 1.0f) / CubemapSize - 1.0f;
+				const float weight = 4.0f / ((1.0f + u * u + v * v) * sqrtf(1.0f + u * u + v * v));
+				float basis[ER_SH_COEF_COUNT];
+				XMSHEvalDirection(basis, ER_SH_BANDS_COUNT, XMVector3Normalize(TestCubemap::GetTexelDirection(face, x, y)));
+				for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+					expected[i] += basis[i] * weight * cubemap.Faces[face][y * CubemapSize + x].x;
+				totalWeight += weight;
+			}
+		}
+	}
+
+	float r[ER_SH_COEF_COUNT], g[ER_SH_COEF_COUNT], b[ER_SH_COEF_COUNT];
+	radiance.Get(r, g, b);
+	for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+		ER_CHECK_NEAR(r[i], expected[i] * 4.0f * XM_PI / totalWeight, 1e-4f);
+}
+
+ER_TEST(ER_SphericalHarmonics, RotateRoundTrip)
+{
+	std::mt19937 generator(3);
+	std::normal_distribution<float> distribution;
+	const ER_SphericalHarmonics original = RandomFunction(generator);
+
+	for (int test = 0; test < 20; test++)
+	{
+		const XMMATRIX rotation = XMMatrixRotationRollPitchYaw(distribution(generator), distribution(generator), distribution(generator));
+		ER_SphericalHarmonics rotated = original;
+		rotated.Rotate(rotation);
+
+		// rotated(d * R) == original(d)
+		for (int i = 0; i < 20; i++)
+		{
+			const XMVECTOR direction = RandomDirection(generator);
+			ER_CHECK_NEAR(XMVectorGetY(rotated.Evaluate(XMVector3TransformNormal(direction, rotation))), XMVectorGetY(original.Evaluate(direction)), 1e-4f);
+		}
+
+		// and back with the inverse rotation
+		rotated.Rotate(XMMatrixTranspose(rotation));
+		for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+			ER_CHECK(XMVector3NearEqual(rotated.GetCoefficient(i), original.GetCoefficient(i), XMVectorReplicate(1e-4f)));
+	}
+}
+
+ER_TEST(ER_SphericalHarmonics, RotateMatchesXMSHRotate)
+{
+	std::mt19937 generator(4);
+	std::normal_distribution<float> distribution;
+	const ER_SphericalHarmonics original = RandomFunction(generator);
+
+	for (int test = 0; test < 20; test++)
+	{
+		const XMMATRIX rotation = XMMatrixRotationRollPitchYaw(distribution(generator), distribution(generator), distribution(generator));
+		ER_SphericalHarmonics rotated = original;
+		rotated.Rotate(rotation);
+
+		float input[3][ER_SH_COEF_COUNT], expected[3][ER_SH_COEF_COUNT], result[3][ER_SH_COEF_COUNT];
+		original.Get(input[0], input[1], input[2]);
+		rotated.Get(result[0], result[1], result[2]);
+		for (int channel = 0; channel < 3; channel++)
+		{
+			XMSHRotate(expected[channel], ER_SH_BANDS_COUNT, rotation, input[channel]);
+			for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+				ER_CHECK_NEAR(result[channel][i], expected[channel][i], 1e-4f);
+		}
+	}
+}
+
+ER_TEST(ER_SphericalHarmonics, RotatedDirectionalLight)
+{
+	const XMVECTOR lightDirection = XMVector3Normalize(XMVectorSet(0.3f, 0.8f, -0.5f, 0.0f));
+	const XMVECTOR lightColor = XMVectorSet(1.0f, 2.0f, 3.0f, 0.0f);
+	const XMMATRIX rotation = XMMatrixRotationAxis(XMVectorSet(1.0f, 1.0f, 0.0f, 0.0f), 0.7f);
+
+	ER_SphericalHarmonics rotated;
+	rotated.AddDirectionalLight(lightDirection, lightColor);
+	rotated.Rotate(rotation);
+
+	ER_SphericalHarmonics expected;
+	expected.AddDirectionalLight(XMVector3TransformNormal(lightDirection, rotation), lightColor);
+
+	for (int i = 0; i < ER_SH_COEF_COUNT; i++)
+		ER_CHECK(XMVector3NearEqual(rotated.GetCoefficient(i), expected.GetCoefficient(i), XMVectorReplicate(1e-4f)));
+}
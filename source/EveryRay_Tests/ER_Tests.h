@@ -0,0 +1,36 @@
+#pragma once
+#include <cmath>
+#include <vector>
+
+// Minimal test registry: ER_TEST(Suite, Name) registers a test, ER_CHECK*() report failures and let the test continue,
+// the runner (ER_TestsMain.cpp) runs the tests of the suite that is passed in the command line (or all of them).
+namespace EveryRay_Tests
+{
+	typedef void (*ER_TestFunction)();
+
+	struct ER_Test
+	{
+		const char* Suite;
+		const char* Name;
+		ER_TestFunction Function;
+	};
+
+	std::vector<ER_Test>& GetTests();
+	void ReportFailure(const char* aFile, int aLine, const char* aExpression);
+
+	struct ER_TestRegistrar
+	{
+		ER_TestRegistrar(const char* aSuite, const char* aName, ER_TestFunction aFunction) { GetTests().push_back({ aSuite, aName, aFunction }); }
+	};
+}
+
+#define ER_TEST(suite, name) \
+	static void suite##_##name(); \
+	static EveryRay_Tests::ER_TestRegistrar suite##_##name##_Registrar(#suite, #name, suite##_##name); \
+	static void suite##_##name()
+
+#define ER_CHECK(condition) \
+	do { if (!(condition)) EveryRay_Tests::ReportFailure(__FILE__, __LINE__, #condition); } while (0)
+
+#define ER_CHECK_NEAR(a, b, epsilon) \
+	do { if (!(std::fabs((a) - (b)) <= (epsilon))) EveryRay_Tests::ReportFailure(__FILE__, __LINE__, #a " == " #b " (+-" #epsilon ")"); } while (0)
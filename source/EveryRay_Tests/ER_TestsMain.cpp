@@ -0,0 +1,47 @@
+#include "ER_Tests.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace EveryRay_Tests
+{
+	static int sFailuresCount = 0;
+
+	std::vector<ER_Test>& GetTests()
+	{
+		static std::vector<ER_Test> tests;
+		return tests;
+	}
+
+	void ReportFailure(const char* aFile, int aLine, const char* aExpression)
+	{
+		printf("%s(%d): check failed: %s\n", aFile, aLine, aExpression);
+		sFailuresCount++;
+	}
+}
+
+// EveryRay_Tests [suite]
+int main(int argc, char** argv)
+{
+	using namespace EveryRay_Tests;
+
+	const char* suite = argc > 1 ? argv[1] : nullptr;
+	int testsCount = 0;
+	int failedTestsCount = 0;
+	for (const ER_Test& test : GetTests())
+	{
+		if (suite && strcmp(suite, test.Suite) != 0)
+			continue;
+
+		const int failuresCount = sFailuresCount;
+		test.Function();
+		const bool isPassed = failuresCount == sFailuresCount;
+		printf("[%s] %s.%s\n", isPassed ? "PASSED" : "FAILED", test.Suite, test.Name);
+
+		testsCount++;
+		failedTestsCount += isPassed ? 0 : 1;
+	}
+
+	printf("%d tests, %d failed\n", testsCount, failedTestsCount);
+	return (testsCount == 0 || failedTestsCount > 0) ? 1 : 0;
+}
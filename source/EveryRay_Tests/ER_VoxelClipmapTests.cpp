@@ -0,0 +1,354 @@
+#include "ER_Tests.h"
+#include "ER_VoxelClipmap.h"
+
+using namespace EveryRay_Core;
+
+namespace
+{
+	// 32 voxels per side, 1 voxel per unit, centered at the origin: voxels [0; 32) are world [-16; 16), all clean
+	void InitializeClipmap(ER_VoxelClipmap& aClipmap)
+	{
+		aClipmap.Initialize(32, 1.0f);
+		aClipmap.Scroll(XMFLOAT3(0.0f, 0.0f, 0.0f));
+		aClipmap.ClearDirty();
+	}
+
+	bool IsRegion(const ER_VoxelRegion& aRegion, const XMINT3& aMin, const XMINT3& aMax)
+	{
+		return
+			aRegion.Min.x == aMin.x && aRegion.Min.y == aMin.y && aRegion.Min.z == aMin.z &&
+			aRegion.Max.x == aMax.x && aRegion.Max.y == aMax.y && aRegion.Max.z == aMax.z;
+	}
+
+	ER_AABB MakeBounds(float aMinX, float aMinY, float aMinZ, float aMaxX, float aMaxY, float aMaxZ)
+	{
+		return ER_AABB(XMFLOAT3(aMinX, aMinY, aMinZ), XMFLOAT3(aMaxX, aMaxY, aMaxZ));
+	}
+
+	bool IsSameBounds(const ER_AABB& a, const ER_AABB& b)
+	{
+		return memcmp(&a, &b, sizeof(ER_AABB)) == 0;
+	}
+}
+
+ER_TEST(ER_VoxelClipmap, InitiallyAllDirty)
+{
+	ER_VoxelClipmap clipmap;
+	clipmap.Initialize(32, 1.0f);
+	clipmap.Scroll(XMFLOAT3(0.0f, 0.0f, 0.0f));
+	ER_CHECK(clipmap.IsAllDirty() && clipmap.IsDirty());
+	ER_CHECK(clipmap.GetScrollOffset().x == 0 && clipmap.GetScrollOffset().y == 0 && clipmap.GetScrollOffset().z == 0);
+
+	const ER_VoxelClipmapStats stats = clipmap.GetStats();
+	ER_CHECK(stats.IsAllDirty && stats.DirtyRegionsCount == 1 && stats.DirtyVoxelsCount == 32 * 32 * 32);
+
+	clipmap.ClearDirty();
+	ER_CHECK(!clipmap.IsDirty() && !clipmap.IsAllDirty());
+
+	const ER_AABB bounds = clipmap.GetBounds();
+	ER_CHECK(IsSameBounds(bounds, MakeBounds(-16.0f, -16.0f, -16.0f, 16.0f, 16.0f, 16.0f)));
+}
+
+ER_TEST(ER_VoxelClipmap, ScrollWithinStepIsIgnored)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.Scroll(XMFLOAT3(1.5f, -1.5f, 0.5f)); // less than half of ER_VOXEL_CLIPMAP_SCROLL_STEP
+	ER_CHECK(!clipmap.IsDirty());
+}
+
+ER_TEST(ER_VoxelClipmap, ScrollExposesPositiveSlab)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.Scroll(XMFLOAT3(4.0f, 0.0f, 0.0f));
+	ER_CHECK(clipmap.IsDirty() && !clipmap.IsAllDirty());
+	ER_CHECK(clipmap.GetScrollOffset().x == 4 && clipmap.GetScrollOffset().y == 0 && clipmap.GetScrollOffset().z == 0);
+
+	const std::vector<ER_VoxelRegion>& regions = clipmap.GetDirtyRegions();
+	ER_CHECK(regions.size() == 1);
+	ER_CHECK(regions.size() == 1 && IsRegion(regions[0], XMINT3(28, 0, 0), XMINT3(32, 32, 32)));
+	ER_CHECK(clipmap.GetStats().DirtyVoxelsCount == 4 * 32 * 32);
+	ER_CHECK(clipmap.GetCenter().x == 4.0f);
+}
+
+ER_TEST(ER_VoxelClipmap, ScrollExposesNegativeSlab)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.Scroll(XMFLOAT3(0.0f, -4.0f, 0.0f));
+	ER_CHECK(clipmap.GetScrollOffset().y == -4);
+
+	const std::vector<ER_VoxelRegion>& regions = clipmap.GetDirtyRegions();
+	ER_CHECK(regions.size() == 1 && IsRegion(regions[0], XMINT3(0, 0, 0), XMINT3(32, 4, 32)));
+
+	// texture space y goes down
+	const XMINT3 texelOffset = clipmap.GetTexelScrollOffset();
+	ER_CHECK(texelOffset.x == 0 && texelOffset.y == 4 && texelOffset.z == 0);
+	XMINT4 texelMin, texelMax;
+	clipmap.GetTexelRegion(regions[0], texelMin, texelMax);
+	ER_CHECK(texelMin.x == 0 && texelMin.y == 28 && texelMin.z == 0);
+	ER_CHECK(texelMax.x == 32 && texelMax.y == 32 && texelMax.z == 32);
+}
+
+ER_TEST(ER_VoxelClipmap, DiagonalScrollExposesSlabPerAxis)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.Scroll(XMFLOAT3(4.0f, 0.0f, -4.0f));
+	const std::vector<ER_VoxelRegion>& regions = clipmap.GetDirtyRegions();
+	ER_CHECK(regions.size() == 2);
+	ER_CHECK(regions.size() == 2 && IsRegion(regions[0], XMINT3(28, 0, 0), XMINT3(32, 32, 32)));
+	ER_CHECK(regions.size() == 2 && IsRegion(regions[1], XMINT3(0, 0, 0), XMINT3(32, 32, 4)));
+}
+
+ER_TEST(ER_VoxelClipmap, ScrollsAccumulateUntilCleared)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.Scroll(XMFLOAT3(4.0f, 0.0f, 0.0f));
+	clipmap.Scroll(XMFLOAT3(8.0f, 0.0f, 0.0f));
+	ER_CHECK(clipmap.GetScrollOffset().x == 8);
+
+	// the slab of the first scroll moves with the content
+	const std::vector<ER_VoxelRegion>& regions = clipmap.GetDirtyRegions();
+	ER_CHECK(regions.size() == 2);
+	ER_CHECK(regions.size() == 2 && IsRegion(regions[0], XMINT3(24, 0, 0), XMINT3(28, 32, 32)));
+	ER_CHECK(regions.size() == 2 && IsRegion(regions[1], XMINT3(28, 0, 0), XMINT3(32, 32, 32)));
+
+	clipmap.ClearDirty();
+	ER_CHECK(!clipmap.IsDirty() && clipmap.GetScrollOffset().x == 0);
+}
+
+ER_TEST(ER_VoxelClipmap, LargeScrollMakesAllDirty)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.Scroll(XMFLOAT3(100.0f, 0.0f, 0.0f));
+	ER_CHECK(clipmap.IsAllDirty());
+	ER_CHECK(clipmap.GetDirtyRegions().empty());
+	ER_CHECK(clipmap.GetScrollOffset().x == 0); // nothing is kept
+}
+
+ER_TEST(ER_VoxelClipmap, DirtyRegionsMoveWithScroll)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.MarkDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+	clipmap.Scroll(XMFLOAT3(4.0f, 0.0f, 0.0f));
+
+	const std::vector<ER_VoxelRegion>& regions = clipmap.GetDirtyRegions();
+	ER_CHECK(regions.size() == 2);
+	ER_CHECK(regions.size() == 2 && IsRegion(regions[0], XMINT3(11, 15, 15), XMINT3(15, 19, 19)));
+	ER_CHECK(regions.size() == 2 && IsRegion(regions[1], XMINT3(28, 0, 0), XMINT3(32, 32, 32)));
+}
+
+ER_TEST(ER_VoxelClipmap, MarkDirtyPadsAndClips)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	// one voxel before and two voxels after the bounds
+	clipmap.MarkDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(15, 15, 15), XMINT3(19, 19, 19)));
+	ER_CHECK(IsSameBounds(clipmap.GetRegionBounds(clipmap.GetDirtyRegions()[0]), MakeBounds(-1.0f, -1.0f, -1.0f, 3.0f, 3.0f, 3.0f)));
+
+	// partially outside
+	clipmap.ClearDirty();
+	clipmap.MarkDirty(MakeBounds(10.0f, 0.0f, 0.0f, 50.0f, 1.0f, 1.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(25, 15, 15), XMINT3(32, 19, 19)));
+
+	// outside
+	clipmap.ClearDirty();
+	clipmap.MarkDirty(MakeBounds(100.0f, 100.0f, 100.0f, 101.0f, 101.0f, 101.0f));
+	clipmap.MarkDirty(MakeBounds(-1.0e9f, -1.0e9f, -1.0e9f, -1.0e8f, -1.0e8f, -1.0e8f));
+	ER_CHECK(!clipmap.IsDirty());
+}
+
+ER_TEST(ER_VoxelClipmap, ContainedRegionsAreSkipped)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.MarkDirty(MakeBounds(-4.0f, -4.0f, -4.0f, 4.0f, 4.0f, 4.0f));
+	clipmap.MarkDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(11, 11, 11), XMINT3(22, 22, 22)));
+
+	// a bigger region replaces the ones it contains
+	clipmap.ClearDirty();
+	clipmap.MarkDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+	clipmap.MarkDirty(MakeBounds(2.0f, 2.0f, 2.0f, 3.0f, 3.0f, 3.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 2);
+	clipmap.MarkDirty(MakeBounds(-4.0f, -4.0f, -4.0f, 4.0f, 4.0f, 4.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(11, 11, 11), XMINT3(22, 22, 22)));
+}
+
+ER_TEST(ER_VoxelClipmap, TooManyRegionsAreMerged)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	// points along x: regions [3 * i; 3 * i + 3) that touch but do not contain each other
+	for (int i = 0; i < ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS; i++)
+	{
+		const float x = -15.0f + 3.0f * static_cast<float>(i);
+		clipmap.MarkDirty(MakeBounds(x, 0.0f, 0.0f, x, 0.0f, 0.0f));
+	}
+	ER_CHECK(clipmap.GetDirtyRegions().size() == ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS);
+
+	const float x = -15.0f + 3.0f * static_cast<float>(ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS);
+	clipmap.MarkDirty(MakeBounds(x, 0.0f, 0.0f, x, 0.0f, 0.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1);
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 &&
+		IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(0, 15, 15), XMINT3(3 * (ER_VOXEL_CLIPMAP_MAX_DIRTY_REGIONS + 1), 18, 18)));
+	ER_CHECK(!clipmap.IsAllDirty());
+}
+
+ER_TEST(ER_VoxelClipmap, RegionOfWholeCascadeMakesAllDirty)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	clipmap.MarkDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+	clipmap.MarkDirty(clipmap.GetBounds());
+	ER_CHECK(clipmap.IsAllDirty());
+	ER_CHECK(clipmap.GetDirtyRegions().empty());
+	ER_CHECK(clipmap.GetStats().DirtyVoxelsCount == 32 * 32 * 32);
+}
+
+ER_TEST(ER_VoxelClipmap, ShadowIsSweptAlongLightDirection)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	// sun from above: everything below the bounds
+	clipmap.MarkShadowDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, -1.0f, 0.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(15, 0, 15), XMINT3(19, 19, 19)));
+
+	// not normalized direction
+	clipmap.ClearDirty();
+	clipmap.MarkShadowDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f), XMFLOAT3(2.0f, -2.0f, 0.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(15, 0, 15), XMINT3(32, 19, 19)));
+
+	// no direction: only the bounds
+	clipmap.ClearDirty();
+	clipmap.MarkShadowDirty(MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(15, 15, 15), XMINT3(19, 19, 19)));
+}
+
+ER_TEST(ER_VoxelClipmap, ShadowOfBoundsOutsideCascade)
+{
+	ER_VoxelClipmap clipmap;
+	InitializeClipmap(clipmap);
+
+	// above the cascade, its shadow falls through all of it
+	clipmap.MarkShadowDirty(MakeBounds(0.0f, 30.0f, 0.0f, 1.0f, 31.0f, 1.0f), XMFLOAT3(0.0f, -1.0f, 0.0f));
+	ER_CHECK(clipmap.GetDirtyRegions().size() == 1 && IsRegion(clipmap.GetDirtyRegions()[0], XMINT3(15, 0, 15), XMINT3(19, 32, 19)));
+
+	// below the cascade, its shadow goes away from it
+	clipmap.ClearDirty();
+	clipmap.MarkShadowDirty(MakeBounds(0.0f, -31.0f, 0.0f, 1.0f, -30.0f, 1.0f), XMFLOAT3(0.0f, -1.0f, 0.0f));
+	ER_CHECK(!clipmap.IsDirty());
+}
+
+ER_TEST(ER_VoxelClipmap, TrackerNewObjectIsDirty)
+{
+	ER_VoxelObjectsTracker tracker;
+	const int object = 0;
+	const ER_AABB bounds = MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+
+	tracker.BeginFrame();
+	ER_CHECK(tracker.UpdateObject(&object, &bounds, 1));
+	tracker.EndFrame();
+	ER_CHECK(tracker.GetObjectsCount() == 1);
+	ER_CHECK(tracker.GetDirtyBounds().size() == 1 && IsSameBounds(tracker.GetDirtyBounds()[0], bounds));
+
+	// static objects are not dirty anymore
+	tracker.BeginFrame();
+	ER_CHECK(!tracker.UpdateObject(&object, &bounds, 1));
+	tracker.EndFrame();
+	ER_CHECK(tracker.GetDirtyBounds().empty());
+}
+
+ER_TEST(ER_VoxelClipmap, TrackerMovedInstanceGivesOldAndNewBounds)
+{
+	ER_VoxelObjectsTracker tracker;
+	const int object = 0;
+	ER_AABB bounds[3] = {
+		MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f),
+		MakeBounds(2.0f, 0.0f, 0.0f, 3.0f, 1.0f, 1.0f),
+		MakeBounds(4.0f, 0.0f, 0.0f, 5.0f, 1.0f, 1.0f) };
+
+	tracker.BeginFrame();
+	tracker.UpdateObject(&object, bounds, 3);
+	tracker.EndFrame();
+
+	const ER_AABB oldBounds = bounds[1];
+	bounds[1] = MakeBounds(2.0f, 5.0f, 0.0f, 3.0f, 6.0f, 1.0f);
+	tracker.BeginFrame();
+	ER_CHECK(tracker.UpdateObject(&object, bounds, 3));
+	tracker.EndFrame();
+
+	// only the moved instance
+	const std::vector<ER_AABB>& dirtyBounds = tracker.GetDirtyBounds();
+	ER_CHECK(dirtyBounds.size() == 2);
+	ER_CHECK(dirtyBounds.size() == 2 && IsSameBounds(dirtyBounds[0], oldBounds) && IsSameBounds(dirtyBounds[1], bounds[1]));
+
+	tracker.BeginFrame();
+	ER_CHECK(!tracker.UpdateObject(&object, bounds, 3));
+	ER_CHECK(tracker.GetDirtyBounds().empty());
+}
+
+ER_TEST(ER_VoxelClipmap, TrackerInstancesCountChange)
+{
+	ER_VoxelObjectsTracker tracker;
+	const int object = 0;
+	const ER_AABB bounds[3] = {
+		MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f),
+		MakeBounds(2.0f, 0.0f, 0.0f, 3.0f, 1.0f, 1.0f),
+		MakeBounds(4.0f, 0.0f, 0.0f, 5.0f, 1.0f, 1.0f) };
+
+	tracker.BeginFrame();
+	tracker.UpdateObject(&object, bounds, 2);
+	tracker.EndFrame();
+
+	// all old and all new bounds
+	tracker.BeginFrame();
+	ER_CHECK(tracker.UpdateObject(&object, bounds, 3));
+	tracker.EndFrame();
+	ER_CHECK(tracker.GetDirtyBounds().size() == 2 + 3);
+}
+
+ER_TEST(ER_VoxelClipmap, TrackerRemovedObjectGivesOldBounds)
+{
+	ER_VoxelObjectsTracker tracker;
+	const int objects[2] = { 0, 1 };
+	const ER_AABB bounds[2] = {
+		MakeBounds(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f),
+		MakeBounds(2.0f, 0.0f, 0.0f, 3.0f, 1.0f, 1.0f) };
+
+	tracker.BeginFrame();
+	tracker.UpdateObject(&objects[0], &bounds[0], 1);
+	tracker.UpdateObject(&objects[1], &bounds[1], 1);
+	tracker.EndFrame();
+	ER_CHECK(tracker.GetObjectsCount() == 2);
+
+	tracker.BeginFrame();
+	tracker.UpdateObject(&objects[0], &bounds[0], 1);
+	ER_CHECK(tracker.GetDirtyBounds().empty());
+	tracker.EndFrame();
+	ER_CHECK(tracker.GetObjectsCount() == 1);
+	ER_CHECK(tracker.GetDirtyBounds().size() == 1 && IsSameBounds(tracker.GetDirtyBounds()[0], bounds[1]));
+
+	tracker.Clear();
+	ER_CHECK(tracker.GetObjectsCount() == 0 && tracker.GetDirtyBounds().empty());
+	tracker.BeginFrame();
+	ER_CHECK(tracker.UpdateObject(&objects[0], &bounds[0], 1)); // new again
+}
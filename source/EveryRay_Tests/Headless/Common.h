@@ -0,0 +1,48 @@
+#pragma once
+
+// Headless replacement of EveryRay_Core/Common.h for the tests (see CMakeLists.txt):
+// only the standard library, DirectXMath and the engine's own definitions, which should match the ones in EveryRay_Core/Common.h
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+typedef unsigned char UINT8;
+typedef unsigned int UINT;
+typedef uint64_t UINT64;
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+using namespace DirectX;
+
+#define DeleteObject(object) if((object) != NULL) { delete object; object = NULL; }
+#define DeleteObjects(objects) if((objects) != NULL) { delete[] objects; objects = NULL; }
+
+#define ER_CEIL(n,d) (int)ceil((float)n/d)
+#define ER_OUTPUT_LOG( s ) { fputws(s, stderr); }
+
+#define ER_ALIGN16 alignas(16)
+#define ER_ALIGN_GPU_BUFFER ER_ALIGN16
+#define ER_GPU_BUFFER_ALIGNMENT 16
+
+#define NUM_SHADOW_CASCADES 3
+#define MAX_LOD 3
+#define MAX_MESH_COUNT 32 // should match with IndirectCulling.hlsli
+
+template <typename T>
+inline T ER_DivideByMultiple(T value, unsigned int alignment) {	return (T)((value + alignment - 1) / alignment); }
+
+inline unsigned int ER_BitmaskAlign(unsigned int value, unsigned int alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+inline bool ER_IsPowerOfTwo(int v) { return v != 0 && (v & (v - 1)) == 0; }
+inline float ER_Lerp(const float& a, const float& b, const float& t) { return a + t * (b - a); }
+
+using ER_AABB = std::pair<XMFLOAT3, XMFLOAT3>;
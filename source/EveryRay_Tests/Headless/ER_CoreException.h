@@ -0,0 +1,20 @@
+#pragma once
+
+// Headless replacement of EveryRay_Core/ER_CoreException.h for the tests (see CMakeLists.txt): same interface without HRESULT
+#include <exception>
+#include <string>
+
+namespace EveryRay_Core
+{
+	class ER_CoreException : public std::exception
+	{
+	public:
+		ER_CoreException(const char* const& message) : mMessage(message) {}
+
+		const char* what() const noexcept override { return mMessage.c_str(); }
+		std::wstring whatw() const { return std::wstring(mMessage.begin(), mMessage.end()); }
+
+	private:
+		std::string mMessage;
+	};
+}
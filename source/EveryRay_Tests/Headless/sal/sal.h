@@ -0,0 +1,27 @@
+#pragma once
+
+// Empty SAL annotations (used by DirectXMath) for compilers other than MSVC
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _In_reads_(x)
+#define _In_reads_opt_(x)
+#define _In_reads_bytes_(x)
+#define _Out_writes_(x)
+#define _Out_writes_opt_(x)
+#define _Out_writes_bytes_(x)
+#define _Out_writes_all_(x)
+#define _Inout_updates_(x)
+#define _Use_decl_annotations_
+#define _Analysis_assume_(x)
+#define _Success_(x)
+#define _Check_return_
+#define _Ret_maybenull_
+#define _When_(a,b)
+#define _Outptr_
+#define _Outptr_opt_
+#define _In_range_(a,b)
+#define _Out_writes_to_(a,b)
+#define _Pre_satisfies_(x)
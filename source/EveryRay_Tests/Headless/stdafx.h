@@ -0,0 +1,4 @@
+#pragma once
+
+// Headless replacement of EveryRay_Core/stdafx.h for the tests (see CMakeLists.txt)
+#include "Common.h"